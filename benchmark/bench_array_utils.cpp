@@ -0,0 +1,41 @@
+#include <benchmark/benchmark.h>
+#include "array_utils.h"
+#include "bench_corpus.h"
+
+// ArrayUtils intersection/union kernels used by filtering and faceting
+
+static void bench_array_utils_and_scalar(benchmark::State& state) {
+    const auto ids_a = bench_corpus_ids(size_t(state.range(0)), 4, 7);
+    const auto ids_b = bench_corpus_ids(size_t(state.range(0)) / 10, 40, 11);
+
+    uint32_t* results = new uint32_t[ids_a.size() + ids_b.size()];
+
+    for(auto _ : state) {
+        size_t results_size = ArrayUtils::and_scalar(ids_a.data(), ids_a.size(),
+                                                     ids_b.data(), ids_b.size(), &results);
+        benchmark::DoNotOptimize(results_size);
+    }
+
+    delete [] results;
+    state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(bench_array_utils_and_scalar)->Arg(100000)->Arg(1000000)->ArgName("num_ids");
+
+static void bench_array_utils_or_scalar(benchmark::State& state) {
+    const auto ids_a = bench_corpus_ids(size_t(state.range(0)), 4, 7);
+    const auto ids_b = bench_corpus_ids(size_t(state.range(0)) / 10, 40, 11);
+
+    uint32_t* results = new uint32_t[ids_a.size() + ids_b.size()];
+
+    for(auto _ : state) {
+        size_t results_size = ArrayUtils::or_scalar(ids_a.data(), ids_a.size(),
+                                                    ids_b.data(), ids_b.size(), &results);
+        benchmark::DoNotOptimize(results_size);
+    }
+
+    delete [] results;
+    state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(bench_array_utils_or_scalar)->Arg(100000)->Arg(1000000)->ArgName("num_ids");
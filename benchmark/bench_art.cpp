@@ -0,0 +1,49 @@
+#include <benchmark/benchmark.h>
+#include <art.h>
+#include "bench_corpus.h"
+
+// art_fuzzy_search over a tree of 100k terms, across typo budgets and
+// prefix/non-prefix lookups (the shapes the query planner actually issues)
+
+static const size_t NUM_TERMS = 100 * 1000;
+
+static art_tree* corpus_tree() {
+    static art_tree* t = []() {
+        art_tree* tree = new art_tree;
+        art_tree_init(tree);
+
+        const auto words = bench_corpus_words(NUM_TERMS);
+        for(size_t i = 0; i < words.size(); i++) {
+            art_document doc(i, int64_t(i % 1000), {0});
+            art_insert(tree, (const unsigned char*)words[i].c_str(), words[i].size() + 1, &doc);
+        }
+
+        return tree;
+    }();
+
+    return t;
+}
+
+static void bench_art_fuzzy_search(benchmark::State& state) {
+    art_tree* t = corpus_tree();
+    const auto words = bench_corpus_words(NUM_TERMS);
+
+    const int max_cost = int(state.range(0));
+    const bool prefix = bool(state.range(1));
+
+    size_t i = 0;
+    for(auto _ : state) {
+        const std::string& term = words[i++ % words.size()];
+        std::vector<art_leaf*> results;
+        art_fuzzy_search(t, (const unsigned char*)term.c_str(), term.size() + 1, 0, max_cost,
+                         10, FREQUENCY, prefix, nullptr, 0, results);
+        benchmark::DoNotOptimize(results);
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+BENCHMARK(bench_art_fuzzy_search)
+    ->Args({0, 0})->Args({1, 0})->Args({2, 0})
+    ->Args({0, 1})->Args({1, 1})->Args({2, 1})
+    ->ArgNames({"max_cost", "prefix"});
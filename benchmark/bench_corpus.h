@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Shared corpus helpers for the micro benchmark suites.
+//
+// Inputs come either from the file named by $TYPESENSE_BENCH_CORPUS (one word
+// or document per line, e.g. an exported title field) or, when that is unset,
+// from a seeded generator — so runs are reproducible and comparable across
+// machines and builds.
+
+inline std::vector<std::string> bench_corpus_words(size_t num_words) {
+    std::vector<std::string> words;
+
+    const char* corpus_path = std::getenv("TYPESENSE_BENCH_CORPUS");
+    if(corpus_path != nullptr) {
+        std::ifstream infile(corpus_path);
+        std::string line;
+        while(words.size() < num_words && std::getline(infile, line)) {
+            if(!line.empty()) {
+                words.push_back(line);
+            }
+        }
+
+        if(!words.empty()) {
+            return words;
+        }
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> len_dist(3, 12);
+    std::uniform_int_distribution<int> char_dist(0, 25);
+
+    for(size_t i = 0; i < num_words; i++) {
+        std::string word;
+        const int len = len_dist(rng);
+        for(int j = 0; j < len; j++) {
+            word += char('a' + char_dist(rng));
+        }
+        words.push_back(word);
+    }
+
+    return words;
+}
+
+// ascending ids with pseudo-random gaps, mimicking seq_ids of a partially
+// deleted / filtered collection
+inline std::vector<uint32_t> bench_corpus_ids(size_t num_ids, uint32_t max_gap, uint32_t seed = 7) {
+    std::vector<uint32_t> ids;
+    ids.reserve(num_ids);
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<uint32_t> gap_dist(1, max_gap);
+
+    uint32_t id = 0;
+    for(size_t i = 0; i < num_ids; i++) {
+        id += gap_dist(rng);
+        ids.push_back(id);
+    }
+
+    return ids;
+}
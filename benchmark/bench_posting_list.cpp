@@ -0,0 +1,39 @@
+#include <benchmark/benchmark.h>
+#include "posting_list.h"
+#include "bench_corpus.h"
+
+// posting_list_t::intersect across lists of skewed sizes, the hot loop of
+// multi-token queries
+
+static posting_list_t* build_list(size_t num_ids, uint32_t max_gap, uint32_t seed) {
+    posting_list_t* plist = new posting_list_t(1024);
+    const auto ids = bench_corpus_ids(num_ids, max_gap, seed);
+
+    for(uint32_t id: ids) {
+        plist->upsert(id, {1, 2});
+    }
+
+    return plist;
+}
+
+static void bench_posting_list_intersect(benchmark::State& state) {
+    // one dense list and progressively rarer ones sharing the same id space
+    static posting_list_t* dense = build_list(1000000, 2, 7);
+    static posting_list_t* mid = build_list(100000, 20, 11);
+    static posting_list_t* sparse = build_list(10000, 200, 13);
+
+    std::vector<posting_list_t*> lists;
+    if(state.range(0) >= 1) lists.push_back(dense);
+    if(state.range(0) >= 2) lists.push_back(mid);
+    if(state.range(0) >= 3) lists.push_back(sparse);
+
+    for(auto _ : state) {
+        std::vector<uint32_t> result_ids;
+        posting_list_t::intersect(lists, result_ids);
+        benchmark::DoNotOptimize(result_ids);
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+BENCHMARK(bench_posting_list_intersect)->Arg(2)->Arg(3)->ArgName("num_lists");
@@ -0,0 +1,40 @@
+#include <benchmark/benchmark.h>
+#include "sorted_array.h"
+#include "bench_corpus.h"
+
+// sorted_array append (FOR re-compression growth path) and bulk uncompress
+
+static void bench_sorted_array_append(benchmark::State& state) {
+    const auto ids = bench_corpus_ids(size_t(state.range(0)), 8);
+
+    for(auto _ : state) {
+        sorted_array arr;
+        for(uint32_t id: ids) {
+            arr.append(id);
+        }
+        benchmark::DoNotOptimize(arr.getLength());
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(bench_sorted_array_append)->Arg(10000)->Arg(100000)->ArgName("num_ids");
+
+static void bench_sorted_array_uncompress(benchmark::State& state) {
+    const auto ids = bench_corpus_ids(size_t(state.range(0)), 8);
+
+    sorted_array arr;
+    arr.load(ids.data(), ids.size());
+
+    uint32_t* out = new uint32_t[ids.size()];
+
+    for(auto _ : state) {
+        arr.uncompress(out);
+        benchmark::DoNotOptimize(out[0]);
+    }
+
+    delete [] out;
+    state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(bench_sorted_array_uncompress)->Arg(10000)->Arg(100000)->Arg(1000000)->ArgName("num_ids");
@@ -0,0 +1,38 @@
+#include <benchmark/benchmark.h>
+#include "tokenizer.h"
+#include "bench_corpus.h"
+
+// Tokenizer throughput over document-sized text, with and without
+// unicode normalization
+
+static std::string corpus_text() {
+    const auto words = bench_corpus_words(10000);
+    std::string text;
+    for(const auto& word: words) {
+        if(!text.empty()) {
+            text += " ";
+        }
+        text += word;
+    }
+    return text;
+}
+
+static void bench_tokenizer_next(benchmark::State& state) {
+    const std::string text = corpus_text();
+    const bool normalize = bool(state.range(0));
+
+    size_t num_tokens = 0;
+    for(auto _ : state) {
+        Tokenizer tokenizer(text, normalize);
+        std::string token;
+        size_t token_index;
+        while(tokenizer.next(token, token_index)) {
+            num_tokens++;
+        }
+    }
+
+    benchmark::DoNotOptimize(num_tokens);
+    state.SetItemsProcessed(int64_t(num_tokens));
+}
+
+BENCHMARK(bench_tokenizer_next)->Arg(0)->Arg(1)->ArgName("normalize");
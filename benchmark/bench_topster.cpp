@@ -0,0 +1,54 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include "topster.h"
+
+// Topster insertion with the usual page-sized capacity, in plain and
+// distinct (group_by) modes
+
+static std::vector<KV> build_kvs(size_t num_kvs, size_t num_groups) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int64_t> score_dist(0, 1000000);
+
+    std::vector<KV> kvs;
+    kvs.reserve(num_kvs);
+
+    for(size_t i = 0; i < num_kvs; i++) {
+        int64_t scores[3] = {score_dist(rng), 0, 0};
+        KV kv(0, 0, 0, i, (num_groups == 0) ? i : (i % num_groups), 0, scores);
+        kvs.push_back(kv);
+    }
+
+    return kvs;
+}
+
+static void bench_topster_add(benchmark::State& state) {
+    auto kvs = build_kvs(100000, 0);
+
+    for(auto _ : state) {
+        Topster topster(250);
+        for(auto& kv: kvs) {
+            topster.add(&kv);
+        }
+        benchmark::DoNotOptimize(topster.size);
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * kvs.size());
+}
+
+BENCHMARK(bench_topster_add);
+
+static void bench_topster_add_distinct(benchmark::State& state) {
+    auto kvs = build_kvs(100000, 1000);
+
+    for(auto _ : state) {
+        Topster topster(250, 3);
+        for(auto& kv: kvs) {
+            topster.add(&kv);
+        }
+        benchmark::DoNotOptimize(topster.size);
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * kvs.size());
+}
+
+BENCHMARK(bench_topster_add_distinct);
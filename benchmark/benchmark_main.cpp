@@ -0,0 +1,5 @@
+#include <benchmark/benchmark.h>
+
+// Each suite lives in its own bench_*.cpp and registers via BENCHMARK(); this
+// translation unit only provides the entry point.
+BENCHMARK_MAIN();
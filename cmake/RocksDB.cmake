@@ -1,6 +1,8 @@
 # Download and build RocksDB
 
-set(ROCKSDB_VERSION 6.20.3)
+# 6.29 is needed for the integrated BlobDB used by the documents column family
+# (blob garbage collection and checkpoint support for blob files)
+set(ROCKSDB_VERSION 6.29.5)
 set(ROCKSDB_NAME rocksdb-${ROCKSDB_VERSION})
 set(ROCKSDB_TAR_PATH ${DEP_ROOT_DIR}/${ROCKSDB_NAME}.tar.gz)
 
@@ -24,7 +26,6 @@ if(NOT EXISTS ${DEP_ROOT_DIR}/${ROCKSDB_NAME}/librocksdb.a AND BUILD_DEPS STREQU
     set(ENV{ROCKSDB_DISABLE_GFLAGS} 1)
     set(ENV{ROCKSDB_DISABLE_BZIP} 1)
     set(ENV{ROCKSDB_DISABLE_LZ4} 1)
-    set(ENV{ROCKSDB_DISABLE_ZSTD} 1)
     set(ENV{ROCKSDB_DISABLE_NUMA} 1)
     set(ENV{ROCKSDB_DISABLE_TBB} 1)
     set(ENV{ROCKSDB_DISABLE_JEMALLOC} 1)
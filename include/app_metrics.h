@@ -3,9 +3,89 @@
 #include "sparsepp.h"
 #include "json.hpp"
 #include "logger.h"
+#include <array>
+#include <cmath>
 #include <string>
+#include <thread>
 #include <shared_mutex>
 
+// Fixed-footprint log-linear histogram in the HDR style: one row of
+// NUM_SUB_BUCKETS linear buckets per power-of-two magnitude, which bounds the
+// relative error of a percentile estimate to ~1/NUM_SUB_BUCKETS while keeping
+// the record path a single array increment (no allocation, no sorting).
+struct latency_histogram_t {
+    static constexpr size_t NUM_ROWS = 28;
+    static constexpr size_t SUB_BUCKET_BITS = 4;
+    static constexpr size_t NUM_SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+    std::array<uint64_t, NUM_ROWS * NUM_SUB_BUCKETS> buckets{};
+    uint64_t total = 0;
+
+    static size_t bucket_of(uint64_t value) {
+        if(value < NUM_SUB_BUCKETS) {
+            // small values get a bucket each, so short durations are exact
+            return value;
+        }
+
+        const size_t magnitude = 63 - __builtin_clzll(value);
+        const size_t row = magnitude - (SUB_BUCKET_BITS - 1);
+
+        if(row >= NUM_ROWS) {
+            // values beyond the last row (~2^31 ms) saturate into the final bucket
+            return (NUM_ROWS * NUM_SUB_BUCKETS) - 1;
+        }
+
+        const size_t sub_bucket = (value >> (magnitude - SUB_BUCKET_BITS)) & (NUM_SUB_BUCKETS - 1);
+        return (row * NUM_SUB_BUCKETS) + sub_bucket;
+    }
+
+    void record(uint64_t value) {
+        buckets[bucket_of(value)]++;
+        total++;
+    }
+
+    void merge(const latency_histogram_t& other) {
+        for(size_t i = 0; i < buckets.size(); i++) {
+            buckets[i] += other.buckets[i];
+        }
+
+        total += other.total;
+    }
+
+    // representative (mid-point) value of a bucket
+    static uint64_t bucket_value(size_t index) {
+        const size_t row = index / NUM_SUB_BUCKETS;
+        const size_t sub_bucket = index % NUM_SUB_BUCKETS;
+
+        if(row == 0) {
+            return sub_bucket;
+        }
+
+        const uint64_t lower_bound = uint64_t(NUM_SUB_BUCKETS + sub_bucket) << (row - 1);
+        const uint64_t bucket_width = uint64_t(1) << (row - 1);
+        return lower_bound + (bucket_width / 2);
+    }
+
+    // `percentile` is expressed out of 100, e.g. 50, 99 or 99.9
+    uint64_t percentile(double percentile) const {
+        if(total == 0) {
+            return 0;
+        }
+
+        const uint64_t target_rank = std::max<uint64_t>(1, uint64_t(std::ceil((percentile / 100.0) * total)));
+        uint64_t cumulative = 0;
+
+        for(size_t i = 0; i < buckets.size(); i++) {
+            cumulative += buckets[i];
+            if(cumulative >= target_rank) {
+                return bucket_value(i);
+            }
+        }
+
+        return bucket_value(buckets.size() - 1);
+    }
+};
+
 class AppMetrics {
 private:
     mutable std::shared_mutex mutex;
@@ -13,25 +93,38 @@ private:
     // stores last complete window
     spp::sparse_hash_map<std::string, uint64_t>* counts;
     spp::sparse_hash_map<std::string, uint64_t>* durations;
-
-    // stores the current window
-    spp::sparse_hash_map<std::string, uint64_t>* current_counts;
-    spp::sparse_hash_map<std::string, uint64_t>* current_durations;
+    spp::sparse_hash_map<std::string, latency_histogram_t>* latencies;
+
+    // the current window is striped so that request threads recording metrics
+    // don't contend on one hot lock: each thread hashes to a stripe and only
+    // that stripe's mutex is taken on the request path. The stripes are merged
+    // into the complete-window maps at window_reset() time.
+    static constexpr size_t NUM_STRIPES = 16;
+
+    struct alignas(64) stripe_t {
+        std::mutex mutex;
+        spp::sparse_hash_map<std::string, uint64_t> counts;
+        spp::sparse_hash_map<std::string, uint64_t> durations;
+        spp::sparse_hash_map<std::string, latency_histogram_t> latencies;
+    };
+
+    std::array<stripe_t, NUM_STRIPES> stripes;
+
+    stripe_t& current_stripe() {
+        const size_t thread_hash = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        return stripes[thread_hash % NUM_STRIPES];
+    }
 
     AppMetrics() {
-        current_counts = new spp::sparse_hash_map<std::string, uint64_t>();
         counts = new spp::sparse_hash_map<std::string, uint64_t>();
-
-        current_durations = new spp::sparse_hash_map<std::string, uint64_t>();
         durations = new spp::sparse_hash_map<std::string, uint64_t>();
+        latencies = new spp::sparse_hash_map<std::string, latency_histogram_t>();
     }
 
     ~AppMetrics() {
-        delete current_counts;
         delete counts;
-
-        delete current_durations;
         delete durations;
+        delete latencies;
     }
 
 public:
@@ -40,6 +133,20 @@ public:
     static inline const std::string IMPORT_LABEL = "import";
     static inline const std::string DOC_DELETE_LABEL = "delete";
 
+    static inline const std::string POSTING_COMPACTION_LABEL = "posting_compaction_blocks";
+
+    static inline const std::string FILTER_CACHE_HIT_LABEL = "filter_cache_hit";
+    static inline const std::string FILTER_CACHE_MISS_LABEL = "filter_cache_miss";
+
+    static inline const std::string DOC_CACHE_HIT_LABEL = "doc_cache_hit";
+    static inline const std::string DOC_CACHE_MISS_LABEL = "doc_cache_miss";
+
+    static inline const std::string PEER_CONN_REUSE_LABEL = "peer_conn_reuse";
+    static inline const std::string PEER_CONN_NEW_LABEL = "peer_conn_new";
+
+    static inline const std::string QUERY_CACHE_HIT_LABEL = "query_cache_hit";
+    static inline const std::string QUERY_CACHE_MISS_LABEL = "query_cache_miss";
+
     static const uint64_t METRICS_REFRESH_INTERVAL_MS = 10 * 1000;
 
     static AppMetrics & get_instance() {
@@ -51,13 +158,42 @@ public:
     void operator=(AppMetrics const&) = delete;
 
     void increment_count(const std::string& identifier, uint64_t count) {
-        std::unique_lock lock(mutex);
-        (*current_counts)[identifier] += count;
+        stripe_t& stripe = current_stripe();
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        stripe.counts[identifier] += count;
     }
 
     void increment_duration(const std::string& identifier, uint64_t duration) {
-        std::unique_lock lock(mutex);
-        (*current_durations)[identifier] += duration;
+        stripe_t& stripe = current_stripe();
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        stripe.durations[identifier] += duration;
+        stripe.latencies[identifier].record(duration);
+    }
+
+    uint64_t get_count(const std::string& identifier) const {
+        std::shared_lock lock(mutex);
+        const auto it = counts->find(identifier);
+        return (it == counts->end()) ? 0 : it->second;
+    }
+
+    // average duration over the last complete window
+    uint64_t get_avg_duration(const std::string& identifier) const {
+        std::shared_lock lock(mutex);
+        const auto duration_it = durations->find(identifier);
+        const auto count_it = counts->find(identifier);
+
+        if(duration_it == durations->end() || count_it == counts->end() || count_it->second == 0) {
+            return 0;
+        }
+
+        return duration_it->second / count_it->second;
+    }
+
+    // duration percentile (e.g. 50, 99 or 99.9) over the last complete window
+    uint64_t get_duration_percentile(const std::string& identifier, double percentile) const {
+        std::shared_lock lock(mutex);
+        const auto it = latencies->find(identifier);
+        return (it == latencies->end()) ? 0 : it->second.percentile(percentile);
     }
 
     void increment_write_metrics(uint64_t route_hash, uint64_t duration);
@@ -65,4 +201,4 @@ public:
     void window_reset();
 
     void get(const std::string& rps_key, const std::string& latency_key, nlohmann::json &result) const;
-};
\ No newline at end of file
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Bump allocator for per-request scratch: an allocation is a pointer bump
+ * inside a fixed-size block and all memory is released wholesale when the
+ * arena is destroyed at the end of the request, so short-lived aggregation
+ * structures never pay a malloc/free per entry.
+ */
+class arena_t {
+private:
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<uint8_t*> blocks;
+
+    uint8_t* current_block = nullptr;
+    size_t used = 0;
+
+public:
+
+    arena_t() = default;
+
+    arena_t(const arena_t&) = delete;
+    arena_t& operator=(const arena_t&) = delete;
+
+    ~arena_t() {
+        for(uint8_t* block: blocks) {
+            delete [] block;
+        }
+    }
+
+    void* alloc(const size_t num_bytes) {
+        // every allocation is kept 8-byte aligned
+        const size_t aligned_bytes = (num_bytes + 7) & ~size_t(7);
+
+        if(aligned_bytes > BLOCK_SIZE) {
+            // oversized allocations get a dedicated block, while the current
+            // block keeps serving the small ones
+            uint8_t* block = new uint8_t[aligned_bytes];
+            blocks.push_back(block);
+            return block;
+        }
+
+        if(current_block == nullptr || used + aligned_bytes > BLOCK_SIZE) {
+            current_block = new uint8_t[BLOCK_SIZE];
+            blocks.push_back(current_block);
+            used = 0;
+        }
+
+        void* ptr = current_block + used;
+        used += aligned_bytes;
+        return ptr;
+    }
+
+    size_t num_blocks() const {
+        return blocks.size();
+    }
+};
+
+// std allocator adapter that draws from an arena, for containers holding
+// per-request scratch; deallocation is a no-op since the arena frees
+// everything wholesale
+template <typename T>
+struct arena_allocator {
+    using value_type = T;
+
+    arena_t* arena;
+
+    explicit arena_allocator(arena_t* arena): arena(arena) {}
+
+    template <typename U>
+    arena_allocator(const arena_allocator<U>& other): arena(other.arena) {}
+
+    T* allocate(const size_t n) {
+        return static_cast<T*>(arena->alloc(n * sizeof(T)));
+    }
+
+    void deallocate(T*, size_t) {
+        // released wholesale when the arena is destroyed
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const arena_allocator<T>& lhs, const arena_allocator<U>& rhs) {
+    return lhs.arena == rhs.arena;
+}
+
+template <typename T, typename U>
+bool operator!=(const arena_allocator<T>& lhs, const arena_allocator<U>& rhs) {
+    return lhs.arena != rhs.arena;
+}
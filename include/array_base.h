@@ -36,10 +36,21 @@ public:
         in = nullptr;
     }
 
+    // pulls the compressed buffer towards the cache: a caller that knows it will
+    // decode this array soon can overlap the memory fetch with other work
+    void prefetch() const {
+        for(uint32_t i = 0; i < length_bytes; i += 64) {
+            __builtin_prefetch(in + i, 0, 1);
+        }
+    }
+
     // len determines length of output buffer (default: length of input)
     uint32_t* uncompress(uint32_t len=0) const;
 
-    uint32_t getSizeInBytes();
+    // decodes into a caller-provided buffer of at least `length` elements
+    void uncompress(uint32_t* out) const;
+
+    uint32_t getSizeInBytes() const;
 
     uint32_t getLength() const;
 
@@ -10,6 +10,8 @@
 
 #define IGNORE_PRINTF 1
 
+class token_interner_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -94,22 +96,33 @@ typedef struct {
 } art_values;
 
 /**
- * Represents a leaf. These are
- * of arbitrary size, as they include the key.
+ * Represents a leaf. The key bytes are owned by the tree's interner when
+ * one is attached (a single copy shared across all trees of a collection),
+ * otherwise by the tree's own arena.
  */
 typedef struct {
     uint32_t key_len;
     int64_t max_score;
     void* values;
-    unsigned char key[];
+    const unsigned char* key;
 } art_leaf;
 
+typedef int(*art_leaf_callback)(void *data, const art_leaf *leaf);
+
+/**
+ * Slab arena backing the node and leaf allocations of a single tree.
+ * Defined in art.cpp.
+ */
+typedef struct art_arena art_arena;
+
 /**
  * Main struct, points to root.
  */
 typedef struct {
     art_node *root;
     uint64_t size;
+    art_arena *arena;
+    token_interner_t *interner;
 } art_tree;
 
 /*
@@ -145,12 +158,32 @@ enum NUM_COMPARATOR {
     RANGE_INCLUSIVE
 };
 
+/**
+ * Marks the start/end of a read-side section. Searches and iterations
+ * enter one automatically; threads that hold art_leaf or node pointers
+ * across calls (e.g. while draining fuzzy search results) should wrap the
+ * whole span so retired nodes are not recycled underneath them. Sections
+ * nest; writers defer reclamation until every overlapping section exits.
+ */
+void art_rcu_reader_enter();
+
+void art_rcu_reader_exit();
+
 /**
  * Initializes an ART tree
  * @return 0 on success.
  */
 int art_tree_init(art_tree *t);
 
+/**
+ * Initializes an ART tree whose leaf keys are deduplicated through the
+ * given interner, which must outlive the tree. Trees of all string fields
+ * of a collection share one interner, so a token's bytes are stored once
+ * regardless of how many fields contain it.
+ * @return 0 on success.
+ */
+int art_tree_init_interned(art_tree *t, token_interner_t *interner);
+
 /**
  * DEPRECATED
  * Initializes an ART tree
@@ -182,6 +215,13 @@ inline uint64_t art_size(art_tree *t) {
 }
 #endif
 
+/**
+ * Returns the bytes held by the tree's slab arena, i.e. nodes, leaves and
+ * (for non-interned trees) key copies. Posting lists hanging off the leaves
+ * are owned by the caller and must be accounted for separately.
+ */
+uint64_t art_tree_arena_bytes(const art_tree *t);
+
 /**
  * Inserts a new value into the ART tree
  * @arg t The tree
@@ -197,6 +237,32 @@ void* art_insert(art_tree *t, const unsigned char *key, int key_len, art_documen
 void* art_inserts(art_tree *t, const unsigned char *key, int key_len, const int64_t docs_max_score,
                   std::vector<art_document>& documents);
 
+/*
+ * One entry of a bulk insert batch: a key along with the documents that
+ * contain it. The key and documents must stay alive for the duration of
+ * the call.
+ */
+struct art_key_documents {
+    const unsigned char *key;
+    uint32_t key_len;
+    std::vector<art_document>* documents;
+};
+
+/*
+ * Inserts a batch of distinct keys in one pass. The batch is sorted and the
+ * descent is resumed from the longest prefix shared with the previous key,
+ * so shared prefixes are walked only once per batch.
+ */
+void art_bulk_inserts(art_tree *t, const int64_t docs_max_score, std::vector<art_key_documents>& batch);
+
+/*
+ * Inserts a key with a prebuilt posting object (index snapshot restore),
+ * bypassing per-document posting construction. The key must not already be
+ * present in the tree; `values` ownership transfers to the leaf.
+ */
+void art_load_leaf(art_tree *t, const unsigned char *key, uint32_t key_len,
+                   const int64_t max_score, void *values);
+
 /**
  * Deletes a value from the ART tree
  * @arg t The tree
@@ -241,6 +307,13 @@ art_leaf* art_maximum(art_tree *t);
  */
 int art_iter(art_tree *t, art_callback cb, void *data);
 
+/**
+ * Same as art_iter, but the callback receives the leaf itself instead of
+ * its value pointer, giving access to the key bytes and the leaf max_score
+ * in one visit (used by index snapshot serialization).
+ */
+int art_iter_leaves(art_tree *t, art_leaf_callback cb, void *data);
+
 /**
  * Iterates through the entries pairs in the map,
  * invoking a callback for each that matches a given prefix.
@@ -0,0 +1,160 @@
+#ifndef ART_FROZEN_H
+#define ART_FROZEN_H
+
+#include <stdint.h>
+#include <string>
+#include "art.h"
+
+/*
+ * Immutable, pointer-free snapshot of an art_tree.
+ *
+ * The tree is serialized depth-first into a single contiguous file: inner
+ * nodes keep the in-memory ART layout but reference their children through
+ * file offsets instead of pointers, and leaves carry their key along with a
+ * flattened copy of the posting data (ids, per-id offset index and token
+ * offsets). Since nothing in the image is a pointer, the file can be
+ * memory-mapped read-only at startup and traversed in place — no
+ * per-token rebuild from the store is needed.
+ *
+ * Writes that arrive after the snapshot go to a small mutable overlay
+ * art_tree owned by the handle. A key is materialized into the overlay on
+ * first write (or first posting-level access via art_frozen_search), so the
+ * overlay stays proportional to the post-snapshot churn rather than to the
+ * full index.
+ */
+
+// Offsets to child records are tagged like in-memory child pointers:
+// bit 0 set means the offset points at an art_frozen_leaf.
+#define FROZEN_IS_LEAF(off) ((off) & 1)
+#define FROZEN_SET_LEAF(off) ((off) | 1)
+#define FROZEN_RAW_OFFSET(off) ((off) & ~((uint64_t) 1))
+
+/**
+ * Common header of every serialized inner node. Mirrors art_node, with
+ * children stored as tagged file offsets right after the type-specific
+ * key arrays.
+ */
+struct art_frozen_node {
+    uint8_t type;
+    uint8_t num_children;
+    uint8_t partial_len;
+    unsigned char partial[MAX_PREFIX_LEN];
+    int64_t max_score;
+};
+
+struct art_frozen_node4 {
+    art_frozen_node n;
+    unsigned char keys[4];
+    uint64_t children[4];
+};
+
+struct art_frozen_node16 {
+    art_frozen_node n;
+    unsigned char keys[16];
+    uint64_t children[16];
+};
+
+struct art_frozen_node48 {
+    art_frozen_node n;
+    unsigned char keys[256];
+    uint64_t children[48];
+};
+
+struct art_frozen_node256 {
+    art_frozen_node n;
+    uint64_t children[256];
+};
+
+/**
+ * A serialized leaf: fixed header followed by `num_ids` document ids,
+ * `num_ids` offset-index entries, `num_offsets` token offsets and finally
+ * the key bytes. All variable parts are accessed via the helpers below.
+ */
+struct art_frozen_leaf {
+    uint32_t key_len;
+    uint32_t num_ids;
+    uint32_t num_offsets;
+    uint32_t pad;
+    int64_t max_score;
+
+    const uint32_t* ids() const {
+        return (const uint32_t *) (this + 1);
+    }
+
+    const uint32_t* offset_index() const {
+        return ids() + num_ids;
+    }
+
+    const uint32_t* offsets() const {
+        return offset_index() + num_ids;
+    }
+
+    const unsigned char* key() const {
+        return (const unsigned char *) (offsets() + num_offsets);
+    }
+};
+
+/**
+ * Handle over a memory-mapped snapshot plus the overlay tree that absorbs
+ * writes made after the snapshot was taken.
+ */
+struct art_frozen_t {
+    int fd;
+    const uint8_t* base;
+    size_t file_size;
+    uint64_t root_offset;   // tagged offset of the root record, 0 if empty
+    uint64_t num_keys;
+    art_tree overlay;
+};
+
+typedef int(*art_frozen_callback)(void *data, const unsigned char *key, uint32_t key_len,
+                                  const art_frozen_leaf *leaf);
+
+/**
+ * Serializes the tree into `path`. Returns false on I/O failure.
+ */
+bool art_frozen_write(const art_tree *t, const std::string& path);
+
+/**
+ * Memory-maps a snapshot previously produced by art_frozen_write().
+ * Returns NULL if the file cannot be mapped or fails validation.
+ */
+art_frozen_t* art_frozen_open(const std::string& path);
+
+/**
+ * Unmaps the snapshot and destroys the overlay tree.
+ */
+void art_frozen_close(art_frozen_t *ft);
+
+/**
+ * Exact-match lookup against the frozen image only (the overlay is not
+ * consulted). Returns NULL when the key is absent from the snapshot.
+ */
+const art_frozen_leaf* art_frozen_find(const art_frozen_t *ft, const unsigned char *key, int key_len);
+
+/**
+ * Exact-match lookup across overlay and frozen image. A hit that exists
+ * only in the snapshot is materialized into the overlay first, so the
+ * returned value is always a live posting list usable with posting_t.
+ * Returns NULL when the key exists in neither.
+ */
+void* art_frozen_search(art_frozen_t *ft, const unsigned char *key, int key_len);
+
+/**
+ * Copies a frozen leaf's postings into `t` under `key`, returning the
+ * resulting live leaf. Per-document scores are not preserved in the
+ * snapshot; documents are replayed with the leaf's max_score so top-k
+ * bounds remain valid.
+ */
+art_leaf* art_frozen_materialize(const art_frozen_leaf *fl, const unsigned char *key, art_tree *t);
+
+/**
+ * Invokes `cb` for every snapshot leaf whose key begins with the given
+ * prefix. Overlay keys are not visited; callers merging live and frozen
+ * results should also run art_iter_prefix() on the overlay.
+ * Iteration stops early if the callback returns non-zero.
+ */
+int art_frozen_iter_prefix(const art_frozen_t *ft, const unsigned char *prefix, int prefix_len,
+                           art_frozen_callback cb, void *data);
+
+#endif
@@ -8,6 +8,7 @@
 #include "json.hpp"
 #include "option.h"
 #include "store.h"
+#include "lru/lru.hpp"
 
 struct api_key_t {
     uint32_t id;
@@ -76,6 +77,16 @@ struct api_key_t {
     }
 };
 
+// a positive auth decision, kept only until `expires_at` so that key expiry is
+// still enforced on cache hits
+struct cached_auth_t {
+    uint64_t expires_at;
+
+    // embedded params of a scoped key, which must be merged into every request
+    // (empty object for regular keys)
+    nlohmann::json embedded_params;
+};
+
 class AuthManager {
 
 private:
@@ -83,6 +94,13 @@ private:
     mutable std::shared_mutex mutex;
 
     std::map<std::string, api_key_t> api_keys;  // stores key_value => key mapping
+
+    // positive auth decisions keyed by hash of (api key, action, collections), so that
+    // repeat requests skip collection regex matching and scoped key HMAC verification:
+    // the request path takes only a brief shared lock for the probe. Cleared on key CRUD.
+    mutable std::shared_mutex auth_cache_mutex;
+    mutable LRU::Cache<uint64_t, cached_auth_t> auth_cache;
+
     Store *store;
 
     std::string bootstrap_auth_key;
@@ -102,7 +120,10 @@ private:
 
     Option<bool> authenticate_parse_params(const std::string& scoped_api_key, const std::string& action,
                                            const std::vector<std::string>& collections,
-                                           nlohmann::json& embedded_params) const ;
+                                           nlohmann::json& embedded_params, uint64_t& expiry_ts) const ;
+
+    static uint64_t auth_request_hash(const std::string& req_api_key, const std::string& action,
+                                      const std::vector<std::string>& collections);
 
     bool auth_against_key(const std::vector<std::string>& collections, const std::string& action,
                           const api_key_t &api_key, const bool search_only) const;
@@ -2,6 +2,7 @@
 
 #include <unordered_map>
 #include <deque>
+#include <vector>
 #include "store.h"
 #include "http_data.h"
 #include "threadpool.h"
@@ -20,6 +21,10 @@ private:
         uint32_t next_chunk_index;   // index where next read must begin
         bool is_complete;           //  whether the req has been written to store fully
 
+        // Contiguous prefix of the request's chunks held in memory to avoid a store round-trip.
+        // Chunks that don't fit within `CHUNK_BUFFER_MAX_BYTES` spill to the store instead.
+        std::vector<std::string> chunk_buffer;
+
         req_res_t(uint64_t start_ts, const std::string& prev_req_body,
                   const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res,
                   uint64_t last_updated, uint32_t num_chunks, uint32_t next_chunk_index, bool is_complete):
@@ -46,14 +51,55 @@ private:
     await_t* qmutuxes;
     std::vector<std::deque<uint64_t>> queues;
 
+    // sticky collection → queue assignment: the first write of a collection
+    // picks the queue with the fewest pending requests and later writes follow
+    // it, so hot collections spread across workers while per-collection
+    // ordering and worker affinity are preserved (protected by `mutex`)
+    std::unordered_map<std::string, uint32_t> collection_queue_ids;
+
+    // pending requests per queue, for picking the least-loaded queue
+    // (protected by `mutex`)
+    std::vector<int64_t> queue_pending_reqs;
+
     /* Variables to be serialized on snapshot                  /
     --------------------------------------------------------- */
 
     std::mutex mutex;
     std::unordered_map<uint64_t, req_res_t> req_res_map;
 
+    // total bytes held across all in-memory chunk buffers (protected by `mutex`)
+    size_t buffered_chunks_bytes = 0;
+
     std::atomic<int64_t> queued_writes = 0;
 
+    /* Write admission control                                  /
+    --------------------------------------------------------- */
+
+    // watermarks on `queued_writes`: above high, imports are turned away with 429
+    // until the queue drains below low again (0 disables the check)
+    const size_t queue_high_watermark;
+    const size_t queue_low_watermark;
+
+    std::atomic<bool> write_backpressured = false;
+
+    // total chunks applied and the drain rate observed over the last second
+    std::atomic<uint64_t> processed_writes = 0;
+    std::atomic<int64_t> drain_rate_per_sec = 0;
+
+    // notified when backpressure is released, for callers that want to wait out a drain
+    await_t drain_await;
+
+    /* Search-priority catch-up throttle                        /
+    --------------------------------------------------------- */
+
+    // per-chunk delay imposed on replay while searches are degraded (0 = full speed);
+    // adjusted by the monitor loop in run()
+    std::atomic<uint32_t> replay_delay_ms = 0;
+
+    // EMA of search latency observed while no meaningful backlog is applying,
+    // used as the baseline the throttle compares against
+    std::atomic<uint64_t> baseline_search_latency_ms = 0;
+
     /* ------------------------------------------------------- */
 
     std::chrono::high_resolution_clock::time_point last_gc_run;
@@ -70,13 +116,31 @@ private:
     static const size_t GC_INTERVAL_SECONDS = 60;
     static const size_t GC_PRUNE_MAX_SECONDS = 3600;
 
+    // cap on memory used for buffering request chunks before spilling to the store
+    static const size_t CHUNK_BUFFER_MAX_BYTES = 64 * 1024 * 1024;
+
+    // backlog size (in queued chunks) below which replay is never throttled
+    static const size_t REPLAY_THROTTLE_MIN_QUEUE = 1000;
+
+    // ceiling on the per-chunk delay: guarantees a floor on replay progress,
+    // so a throttled catch-up always completes
+    static const uint32_t REPLAY_DELAY_MAX_MS = 20;
+
     static std::string get_req_prefix_key(uint64_t req_id);
 
+    // requires `mutex` to be held
+    void release_buffered_chunks(req_res_t& req_res);
+
+    // resolves the sticky queue of `collection_name`, assigning the
+    // least-loaded queue on first sight (requires `mutex` to be held)
+    uint32_t get_queue_id(const std::string& collection_name);
+
 public:
 
     static const constexpr char* RAFT_REQ_LOG_PREFIX = "$RL_";
 
-    BatchedIndexer(HttpServer* server, Store* store, Store* meta_store, size_t num_threads);
+    BatchedIndexer(HttpServer* server, Store* store, Store* meta_store, size_t num_threads,
+                   size_t queue_high_watermark = 0, size_t queue_low_watermark = 0);
 
     ~BatchedIndexer();
 
@@ -84,6 +148,18 @@ public:
 
     int64_t get_queued_writes();
 
+    bool is_write_backpressured();
+
+    int64_t get_drain_rate();
+
+    // seconds a client should wait before retrying a rejected import,
+    // estimated from the current drain rate
+    size_t get_retry_after_secs();
+
+    // blocks until backpressure is released or `timeout_ms` elapses;
+    // returns true if the queue drained within the timeout
+    bool await_drain(size_t timeout_ms);
+
     void run();
 
     void stop();
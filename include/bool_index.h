@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "array_utils.h"
+
+/*
+ * Dedicated index for bool fields: one bitmap per truth value, addressed by
+ * seq_id. A value costs two bits per document instead of a tree node and a
+ * compressed id array, inserts and removes flip a single bit, and a filter
+ * like `in_stock:true` materializes its id set with a word-parallel scan
+ * that emits 64 documents per loaded word.
+ */
+class bool_index_t {
+private:
+    // words[0] => ids holding `false`, words[1] => ids holding `true`
+    // (an array doc can appear in both)
+    std::vector<uint64_t> words[2];
+    size_t value_counts[2] = {0, 0};
+
+public:
+
+    void insert(bool value, uint32_t seq_id) {
+        std::vector<uint64_t>& wrds = words[value];
+        const size_t word_index = seq_id >> 6;
+
+        if(word_index >= wrds.size()) {
+            // grow geometrically: seq_ids arrive mostly in increasing order and
+            // a resize to exactly `word_index + 1` each time would be quadratic
+            if(word_index >= wrds.capacity()) {
+                wrds.reserve(std::max<size_t>(2 * wrds.capacity(), word_index + 1));
+            }
+
+            wrds.resize(word_index + 1, 0);
+        }
+
+        const uint64_t mask = uint64_t(1) << (seq_id & 63);
+
+        if((wrds[word_index] & mask) == 0) {
+            wrds[word_index] |= mask;
+            value_counts[value]++;
+        }
+    }
+
+    void remove(bool value, uint32_t seq_id) {
+        std::vector<uint64_t>& wrds = words[value];
+        const size_t word_index = seq_id >> 6;
+
+        if(word_index < wrds.size()) {
+            const uint64_t mask = uint64_t(1) << (seq_id & 63);
+
+            if((wrds[word_index] & mask) != 0) {
+                wrds[word_index] &= ~mask;
+                value_counts[value]--;
+            }
+        }
+    }
+
+    size_t num_ids(bool value) const {
+        return value_counts[value];
+    }
+
+    size_t memory_bytes() const {
+        return sizeof(bool_index_t) +
+               ((words[0].capacity() + words[1].capacity()) * sizeof(uint64_t));
+    }
+
+    // snapshot support: raw bitmap words of a truth value
+    const std::vector<uint64_t>& get_words(bool value) const {
+        return words[value];
+    }
+
+    // snapshot support: replaces a truth value's bitmap wholesale
+    void load_words(bool value, std::vector<uint64_t>&& wrds, size_t num_set_ids) {
+        words[value] = std::move(wrds);
+        value_counts[value] = num_set_ids;
+    }
+
+    // or-merges the ids holding `value` into `ids` (same contract as num_tree_t::search)
+    void search(bool value, uint32_t** ids, size_t& ids_len) const {
+        if(value_counts[value] == 0) {
+            return ;
+        }
+
+        uint32_t* val_ids = new uint32_t[value_counts[value]];
+        size_t val_ids_len = 0;
+
+        const std::vector<uint64_t>& wrds = words[value];
+
+        for(size_t word_index = 0; word_index < wrds.size(); word_index++) {
+            uint64_t word = wrds[word_index];
+
+            while(word != 0) {
+                val_ids[val_ids_len++] = uint32_t((word_index << 6) + __builtin_ctzll(word));
+                word &= (word - 1);
+            }
+        }
+
+        uint32_t* out = nullptr;
+        ids_len = ArrayUtils::or_scalar(val_ids, val_ids_len, *ids, ids_len, &out);
+        delete [] *ids;
+        *ids = out;
+        delete [] val_ids;
+    }
+};
@@ -4,6 +4,7 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <list>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -120,11 +121,26 @@ struct synonym_t {
     }
 };
 
+// Lazy collections (see CollectionManager::hydrate_collection_async): the in-memory
+// index of a PENDING collection is built on first access; IN_PROGRESS marks a
+// thread replaying documents into it.
+enum class hydration_state_t : uint8_t {
+    HYDRATED,
+    PENDING,
+    IN_PROGRESS
+};
+
 class Collection {
 private:
 
     mutable std::shared_mutex mutex;
 
+    // serializes document writers among themselves: writers then hold `mutex`
+    // only in shared mode, so searches can proceed while a batch is being
+    // validated and tokenized (the Index takes its own writer lock for the
+    // actual in-memory apply)
+    mutable std::mutex indexing_mutex;
+
     const uint8_t CURATED_RECORD_IDENTIFIER = 100;
 
     struct highlight_t {
@@ -155,6 +171,21 @@ private:
     // Auto incrementing record ID used internally for indexing - not exposed to the client
     std::atomic<uint32_t> next_seq_id;
 
+    // Sequence IDs are reserved from the store in blocks: every id below the
+    // ceiling is already persisted as handed out, so allocation stays purely
+    // in-memory until the block runs out (see get_next_seq_id)
+    std::atomic<uint32_t> seq_id_ceiling;
+
+    // serializes block reservations against the store
+    std::mutex seq_id_reserve_mutex;
+
+    // number of sequence IDs reserved per store write
+    static const uint32_t SEQ_ID_BLOCK_SIZE = 10000;
+
+    // bumped on every applied write, so the query result cache can tell that a
+    // cached response predates newer writes (see res_cache in core_api.cpp)
+    std::atomic<uint64_t> write_epoch;
+
     Store* store;
 
     std::vector<field> fields;
@@ -167,8 +198,67 @@ private:
 
     std::map<std::string, override_t> overrides;
 
+    // Overrides compiled into a one-pass matcher so that curation does not
+    // string-compare every override rule per query: exact rules live in a hash
+    // map and `contains` rules in an Aho-Corasick automaton over the query
+    // bytes. Rebuilt whenever an override is added or removed.
+    struct override_matcher_t {
+        struct node_t {
+            spp::sparse_hash_map<unsigned char, uint32_t> next;
+            uint32_t suffix_link = 0;
+            std::vector<uint32_t> rule_ids;       // contains-rules ending at this node
+        };
+
+        std::vector<node_t> nodes;                // automaton states, nodes[0] = root
+        std::vector<const override_t*> contains_rules;
+        spp::sparse_hash_map<std::string, std::vector<const override_t*>> exact_rules;
+
+        // overrides with a filter_by clause, in override id order: these are
+        // resolved later against query tokens, not the raw query string
+        std::vector<const override_t*> filter_overrides;
+
+        void compile(const std::map<std::string, override_t>& overrides);
+
+        // appends curation overrides whose rule matches `query`, in override id order
+        void match(const std::string& query, std::vector<const override_t*>& matched) const;
+    };
+
+    override_matcher_t override_matcher;
+
     spp::sparse_hash_map<std::string, synonym_t> synonym_definitions;
-    spp::sparse_hash_map<uint64_t, std::vector<std::string>> synonym_index;
+
+    // Synonym left-hand sides compiled into a token trie, so that expansion
+    // walks each query position only as deep as some synonym actually extends
+    // instead of hashing every (start, length) window of the query. Rebuilt
+    // whenever a synonym is added or removed.
+    struct synonym_matcher_t {
+        struct node_t {
+            spp::sparse_hash_map<uint64_t, uint32_t> next;  // token hash => state
+            std::vector<std::string> synonym_ids;           // definitions ending here
+        };
+
+        // a synonym left-hand side matched against the query tokens
+        struct match_t {
+            size_t window_len;
+            uint64_t syn_hash;                              // combined hash of the window
+            const std::vector<std::string>* synonym_ids;
+        };
+
+        std::vector<node_t> nodes;                          // trie states, nodes[0] = root
+
+        // inserts one definition; used on the add path so that loading a large
+        // synonym set at boot stays linear in its total token count
+        void add(const synonym_t& synonym);
+
+        void compile(const spp::sparse_hash_map<std::string, synonym_t>& definitions);
+
+        // walks the trie from `start`, appending a match for every synonym
+        // left-hand side that covers a window beginning at this position
+        void match_at(const std::vector<uint64_t>& token_hashes, size_t start,
+                      std::vector<match_t>& matches) const;
+    };
+
+    synonym_matcher_t synonym_matcher;
 
     const std::string default_sorting_field;
 
@@ -184,6 +274,57 @@ private:
 
     Index* index;
 
+    // LRU of (segmentation flag, query, query_by fields) => parsed and
+    // synonym-expanded query tokens: live traffic repeats a handful of queries
+    // almost verbatim, so re-tokenizing them on every request is wasted work.
+    // Entries carry the plan version they were compiled at, so synonym and
+    // schema changes invalidate them wholesale.
+    static const size_t QUERY_PLAN_CACHE_MAX_ENTRIES = 64;
+
+    struct query_plan_t {
+        std::vector<query_tokens_t> field_query_tokens;
+        uint64_t version;
+        std::list<std::string>::iterator lru_it;
+    };
+
+    mutable std::mutex query_plan_cache_mutex;
+    mutable std::list<std::string> query_plan_cache_lru;  // front = most recently used
+    mutable spp::sparse_hash_map<std::string, query_plan_t*> query_plan_cache;
+
+    // bumped on synonym and schema changes
+    mutable std::atomic<uint64_t> query_plan_version{0};
+
+    // LRU of seq_id => parsed document used to hydrate hits: hot documents
+    // appear on thousands of result pages, and fetching + parsing their JSON
+    // from disk per request is the only disk dependency of a warm search.
+    // Writes invalidate the touched seq_ids directly; the watermark rejects
+    // fills that raced a concurrent write to the same document.
+    static const size_t DOC_CACHE_MAX_ENTRIES = 1000;
+
+    struct doc_cache_entry_t {
+        nlohmann::json document;
+        std::list<uint32_t>::iterator lru_it;
+    };
+
+    mutable std::mutex doc_cache_mutex;
+    mutable std::list<uint32_t> doc_cache_lru;  // front = most recently used
+    mutable spp::sparse_hash_map<uint32_t, doc_cache_entry_t*> doc_cache;
+
+    // bumped before every document write / removal hits the store
+    mutable std::atomic<uint64_t> doc_cache_watermark{0};
+
+    // lazily loaded collections boot as PENDING and are hydrated on first access
+    std::atomic<hydration_state_t> hydration_state{hydration_state_t::HYDRATED};
+
+    // epoch seconds of the last search / write, for idle eviction
+    mutable std::atomic<uint64_t> last_access_timestamp{0};
+
+    bool doc_cache_get(uint32_t seq_id, nlohmann::json& document) const;
+
+    void doc_cache_put(uint32_t seq_id, const nlohmann::json& document, uint64_t watermark) const;
+
+    void doc_cache_erase(uint32_t seq_id) const;
+
     // methods
 
     std::string get_doc_id_key(const std::string & doc_id) const;
@@ -199,6 +340,7 @@ private:
                           bool highlighted_fully,
                           const std::string& highlight_start_tag,
                           const std::string& highlight_end_tag,
+                          spp::sparse_hash_map<std::string, art_leaf*>& leaf_cache,
                           highlight_t &highlight) const;
 
     void remove_document(const nlohmann::json & document, const uint32_t seq_id, bool remove_from_store);
@@ -209,6 +351,10 @@ private:
                         std::map<size_t, std::vector<uint32_t>>& include_ids,
                         std::vector<uint32_t>& excluded_ids, std::vector<const override_t*>& filter_overrides) const;
 
+    bool query_plan_cache_get(const std::string& plan_key, std::vector<query_tokens_t>& field_query_tokens) const;
+
+    void query_plan_cache_put(const std::string& plan_key, const std::vector<query_tokens_t>& field_query_tokens) const;
+
     Option<bool> check_and_update_schema(nlohmann::json& document, const DIRTY_VALUES& dirty_values);
 
     static bool facet_count_compare(const std::pair<uint64_t, facet_count_t>& a,
@@ -261,6 +407,9 @@ public:
     static constexpr const char* COLLECTION_SEARCH_FIELDS_KEY = "fields";
     static constexpr const char* COLLECTION_DEFAULT_SORTING_FIELD_KEY = "default_sorting_field";
     static constexpr const char* COLLECTION_CREATED = "created_at";
+    // accepted and persisted only for meta compatibility: a collection is served by a
+    // single Index and intra-collection parallelism comes from the shared thread pool,
+    // so there is no per-shard layout to size at creation or rebuild later
     static constexpr const char* COLLECTION_NUM_MEMORY_SHARDS = "num_memory_shards";
     static constexpr const char* COLLECTION_FALLBACK_FIELD_TYPE = "fallback_field_type";
 
@@ -293,6 +442,10 @@ public:
 
     uint64_t get_created_at() const;
 
+    uint64_t get_write_epoch() const {
+        return write_epoch;
+    }
+
     uint32_t get_collection_id() const;
 
     uint32_t get_next_seq_id();
@@ -311,16 +464,24 @@ public:
 
     std::string get_default_sorting_field();
 
-    Option<doc_seq_id_t> to_doc(const std::string& json_str, nlohmann::json& document,
+    Option<doc_seq_id_t> to_doc(nlohmann::json& document,
                                 const index_operation_t& operation,
                                 const DIRTY_VALUES dirty_values,
                                 const std::string& id="");
 
     static uint32_t get_seq_id_from_key(const std::string & key);
 
-    Option<bool> get_document_from_store(const std::string & seq_id_key, nlohmann::json & document) const;
+    // when `field_filter` is given, only those top-level fields are
+    // materialized from the stored JSON and the result bypasses the doc cache;
+    // when `raw_doc` is given, it receives the stored JSON text verbatim, but
+    // only if the bytes match `document` exactly (full store read, no filter)
+    Option<bool> get_document_from_store(const std::string & seq_id_key, nlohmann::json & document,
+                                         const spp::sparse_hash_set<std::string>* field_filter = nullptr,
+                                         std::string* raw_doc = nullptr) const;
 
-    Option<bool> get_document_from_store(const uint32_t& seq_id, nlohmann::json & document) const;
+    Option<bool> get_document_from_store(const uint32_t& seq_id, nlohmann::json & document,
+                                         const spp::sparse_hash_set<std::string>* field_filter = nullptr,
+                                         std::string* raw_doc = nullptr) const;
 
     Option<uint32_t> index_in_memory(nlohmann::json & document, uint32_t seq_id,
                                      const index_operation_t op, const DIRTY_VALUES& dirty_values);
@@ -330,9 +491,6 @@ public:
 
     const Index* _get_index() const;
 
-    bool facet_value_to_string(const facet &a_facet, const facet_count_t &facet_count, const nlohmann::json &document,
-                               std::string &value) const;
-
     static void populate_result_kvs(Topster *topster, std::vector<std::vector<KV *>> &result_kvs);
 
     void batch_index(std::vector<index_record>& index_records, std::vector<std::string>& json_out, size_t &num_indexed);
@@ -347,15 +505,22 @@ public:
 
     nlohmann::json get_summary_json() const;
 
+    // per-structure memory accounting of the underlying index, served by
+    // `GET /collections/:collection/stats`
+    nlohmann::json get_stats_json() const;
+
     size_t batch_index_in_memory(std::vector<index_record>& index_records);
 
     Option<nlohmann::json> add(const std::string & json_str,
                                const index_operation_t& operation=CREATE, const std::string& id="",
                                const DIRTY_VALUES& dirty_values=DIRTY_VALUES::COERCE_OR_REJECT);
 
+    // when `msgpack_records` is true, each line holds a MessagePack-encoded
+    // document instead of JSON text (lines are still overwritten with JSON results)
     nlohmann::json add_many(std::vector<std::string>& json_lines, nlohmann::json& document,
                             const index_operation_t& operation=CREATE, const std::string& id="",
-                            const DIRTY_VALUES& dirty_values=DIRTY_VALUES::COERCE_OR_REJECT);
+                            const DIRTY_VALUES& dirty_values=DIRTY_VALUES::COERCE_OR_REJECT,
+                            const bool msgpack_records=false);
 
     Option<nlohmann::json> search(const std::string & query, const std::vector<std::string> & search_fields,
                                   const std::string & simple_filter_query, const std::vector<std::string> & facet_fields,
@@ -386,7 +551,12 @@ public:
                                   const bool exhaustive_search = false,
                                   size_t search_stop_millis = 6000*1000,
                                   size_t min_len_1typo = 4,
-                                  size_t min_len_2typo = 7) const;
+                                  size_t min_len_2typo = 7,
+                                  bool approx_facets = false,
+                                  size_t facet_sample_percent = 100,
+                                  size_t facet_sample_threshold = 0,
+                                  std::vector<std::string>* serialized_hits = nullptr,
+                                  const std::string& search_after = "") const;
 
     Option<bool> get_filter_ids(const std::string & simple_filter_query,
                                 std::vector<std::pair<size_t, uint32_t*>>& index_ids);
@@ -397,11 +567,37 @@ public:
 
     Option<bool> remove_if_found(uint32_t seq_id, bool remove_from_store = true);
 
-    bool facet_value_to_string(const facet &a_facet, const facet_count_t &facet_count, const nlohmann::json &document,
-                               std::string &value);
-
     size_t get_num_documents() const;
 
+    // merges under-filled posting list blocks left behind by deletes and
+    // returns the number of blocks reclaimed
+    size_t compact_posting_lists();
+
+    // dumps the in-memory index into `writer`; the caller must have quiesced
+    // writes (see CollectionManager::save_index_snapshots)
+    void serialize_index_state(index_snapshot_writer_t& writer);
+
+    // rebuilds the in-memory index from a snapshot written against the same
+    // schema; must be called right after construction, before any document is
+    // indexed. Returns false when the stream is malformed, in which case this
+    // collection object must be discarded and rebuilt via the replay path.
+    bool load_index_state(index_snapshot_reader_t& reader);
+
+    // lazy collection support (see CollectionManager::hydrate_collection_async)
+
+    hydration_state_t get_hydration_state() const;
+
+    void set_hydration_state(hydration_state_t state);
+
+    // claims hydration: atomically moves PENDING to IN_PROGRESS
+    bool try_start_hydration();
+
+    bool is_hydrated() const;
+
+    uint64_t get_last_access_timestamp() const;
+
+    void update_last_access_timestamp() const;
+
     DIRTY_VALUES parse_dirty_values_option(std::string& dirty_values) const;
 
     std::vector<char> get_symbols_to_index();
@@ -56,6 +56,10 @@ private:
     Store *store;
     ThreadPool* thread_pool;
 
+    // indexing runs on a separate pool so that search tasks are never
+    // queued behind import batches
+    ThreadPool* indexing_thread_pool;
+
     AuthManager auth_manager;
 
     spp::sparse_hash_map<std::string, Collection*> collections;
@@ -76,6 +80,47 @@ private:
 
     BatchedIndexer* batch_indexer;
 
+    // when non-empty, per-collection index snapshots are written here during
+    // raft snapshots and consulted on boot to skip the reindex-from-store pass
+    std::string index_snapshot_dir;
+
+    // lazy collection mode: only collection metadata is loaded at boot and the
+    // in-memory index is built on first access (see hydrate_collection_async)
+    bool lazy_mode = false;
+
+    // document batch size used when a lazy collection is hydrated, remembered
+    // from load()
+    size_t lazy_document_batch_size = 1000;
+
+    // signals hydration completion to writers blocked in hydrate_collection_wait
+    std::mutex hydration_mutex;
+    std::condition_variable hydration_cv;
+
+    // continuous sample of popular search requests, persisted to the meta
+    // store so that a restarted node can replay them against cold caches
+    Store* meta_store = nullptr;
+
+    std::mutex query_samples_mutex;
+    spp::sparse_hash_map<std::string, uint64_t> query_samples;
+    bool query_samples_dirty = false;
+
+    // flips to false while sampled queries are replayed after boot, so the
+    // node does not report healthy until its caches have been warmed
+    std::atomic<bool> query_warmup_done{true};
+
+    // replays every stored document of `collection` into its in-memory index
+    // (shared by the boot path and lazy hydration)
+    static Option<bool> replay_documents(Collection* collection, const size_t batch_size,
+                                         const std::atomic<bool>& quit);
+
+    // runs the replay for a claimed (IN_PROGRESS) collection and publishes the
+    // resulting hydration state; returns false when the replay failed
+    bool do_hydrate(Collection* collection);
+
+    // drops a hydrated collection's index from memory and re-registers it as
+    // PENDING, so it hydrates again on next access
+    bool evict_collection(const std::string& collection_name);
+
     CollectionManager();
 
     ~CollectionManager() = default;
@@ -96,6 +141,7 @@ public:
     static constexpr const char* NEXT_COLLECTION_ID_KEY = "$CI";
     static constexpr const char* SYMLINK_PREFIX = "$SL";
     static constexpr const char* BATCHED_INDEXER_STATE_KEY = "$BI";
+    static constexpr const char* INDEX_SNAPSHOT_STAMP_KEY = "$IS";
 
     static CollectionManager & get_instance() {
         static CollectionManager instance;
@@ -113,7 +159,8 @@ public:
     static Option<bool> load_collection(const nlohmann::json& collection_meta,
                                         const size_t batch_size,
                                         const StoreStatus& next_coll_id_status,
-                                        const std::atomic<bool>& quit);
+                                        const std::atomic<bool>& quit,
+                                        const bool lazy = false);
 
     void add_to_collections(Collection* collection);
 
@@ -123,7 +170,8 @@ public:
 
     // PUBLICLY EXPOSED API
 
-    void init(Store *store, ThreadPool* thread_pool, const float max_memory_ratio,
+    void init(Store *store, ThreadPool* thread_pool, ThreadPool* indexing_thread_pool,
+              const float max_memory_ratio,
               const std::string & auth_key, std::atomic<bool>& quit, BatchedIndexer* batch_indexer);
 
     // only for tests!
@@ -163,9 +211,76 @@ public:
 
     ThreadPool* get_thread_pool() const;
 
+    ThreadPool* get_indexing_thread_pool() const;
+
+    // meta store key under which the top sampled queries are persisted
+    static constexpr const char* QUERY_SAMPLES_KEY = "$QS";
+
+    // cap on distinct sampled queries held in memory
+    static constexpr size_t QUERY_SAMPLES_MAX_DISTINCT = 1000;
+
+    // number of most popular queries persisted and replayed on boot
+    static constexpr size_t QUERY_SAMPLES_TOP_K = 100;
+
+    void set_meta_store(Store* meta_store);
+
+    // records a served search request in the popular-query sample
+    void sample_query(const std::map<std::string, std::string>& req_params);
+
+    // writes the most popular sampled queries to the meta store; called
+    // periodically from the housekeeping loop and cheap when nothing changed
+    void persist_query_samples();
+
+    // replays the persisted query samples on the thread pool to warm CPU,
+    // block and result caches; is_warmed_up() stays false until it finishes
+    void trigger_query_warmup();
+
+    bool is_warmed_up() const;
+
+    // upper bound on last-window writes beyond which posting list compaction is deferred
+    static constexpr uint64_t COMPACTION_MAX_RECENT_WRITES = 100;
+
+    // schedules a low-priority compaction of every collection's posting lists
+    // on the thread pool; skipped entirely while write traffic is heavy
+    void compact_posting_lists();
+
+    // a hydrated collection becomes an eviction candidate after this many idle seconds
+    static constexpr uint64_t LAZY_MIN_IDLE_SECONDS = 30 * 60;
+
+    // eviction kicks in when used memory crosses this fraction of max_memory_ratio
+    static constexpr float LAZY_EVICTION_WATERMARK = 0.9f;
+
+    // enables lazy collection mode: load() then registers collections with
+    // metadata only and their indices are built on first access
+    void set_lazy_mode(bool enable);
+
+    // builds the index of a PENDING collection on the indexing pool; searches
+    // keep receiving a loading status until it finishes
+    void hydrate_collection_async(const std::string& collection_name);
+
+    // blocks until `collection` is hydrated, claiming the work if nobody else has
+    void hydrate_collection_wait(Collection* collection);
+
+    // evicts the longest-idle hydrated collections back to metadata-only while
+    // used memory stays above the eviction watermark; no-op unless lazy mode is on
+    void evict_idle_collections();
+
+    // enables persisted index snapshots, written into `dir` during raft
+    // snapshots and used on boot to skip the reindex-from-store pass
+    void set_index_snapshot_dir(const std::string& dir);
+
+    // writes one index snapshot file per collection plus a random stamp into
+    // the db, binding the files to the db checkpoint taken in the same pause.
+    // Must be called while writes are quiesced (see ReplicationState::on_snapshot_save);
+    // no-op unless set_index_snapshot_dir() was called.
+    void save_index_snapshots();
+
     AuthManager& getAuthManager();
 
-    static Option<bool> do_search(std::map<std::string, std::string>& req_params, std::string& results_json_str);
+    // when `serialized_hits` is given, ungrouped hits are emitted by the search
+    // as response-ready JSON strings and `result_json["hits"]` stays empty
+    static Option<bool> do_search(std::map<std::string, std::string>& req_params, nlohmann::json& result_json,
+                                  std::vector<std::string>* serialized_hits = nullptr);
 
     static bool parse_sort_by_str(std::string sort_by_str, std::vector<sort_by>& sort_fields);
 
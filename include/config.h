@@ -31,12 +31,36 @@ private:
 
     bool enable_cors;
 
+    // persist in-memory index snapshots during raft snapshots and use them on
+    // boot to skip the reindex-from-store pass
+    bool enable_index_snapshots;
+
+    // boot collections with metadata only and build their in-memory indices
+    // lazily on first access
+    bool enable_lazy_collections;
+
+    // this node serves reads only and never campaigns for raft leadership
+    bool read_replica;
+
     float max_memory_ratio;
     int snapshot_interval_seconds;
 
+    // UTC window (HH:MM-HH:MM) within which periodic snapshots may run;
+    // empty means anytime
+    std::string snapshot_window;
+
+    // cap on disk write rate during the snapshot copy phase (0 = unthrottled)
+    int snapshot_max_write_mb_per_sec;
+
     std::atomic<size_t> healthy_read_lag;
     std::atomic<size_t> healthy_write_lag;
 
+    // admission control for writes: above the high watermark of queued write
+    // batches, imports are rejected with 429 until the queue drains below the
+    // low watermark (0 disables the check)
+    std::atomic<size_t> write_queue_high_watermark;
+    std::atomic<size_t> write_queue_low_watermark;
+
     std::string config_file;
     int config_file_validity;
 
@@ -46,6 +70,17 @@ private:
     uint32_t num_documents_parallel_load;
 
     uint32_t thread_pool_size;
+    uint32_t indexing_thread_pool_size;
+
+    uint32_t num_http_loops;
+
+    // curated RocksDB tunables applied when the store is opened;
+    // a zero value keeps the built-in default
+    size_t db_block_cache_mb;
+    size_t db_write_buffer_mb;
+    size_t db_max_write_buffer_number;
+    int db_max_background_jobs;
+    int db_compaction_rate_mb_per_sec;
 
 protected:
 
@@ -54,15 +89,29 @@ protected:
         this->api_port = 8108;
         this->peering_port = 8107;
         this->enable_cors = false;
+        this->enable_index_snapshots = false;
+        this->enable_lazy_collections = false;
+        this->read_replica = false;
         this->max_memory_ratio = 1.0f;
         this->snapshot_interval_seconds = 3600;
+        this->snapshot_window = "";
+        this->snapshot_max_write_mb_per_sec = 0;
         this->healthy_read_lag = 1000;
         this->healthy_write_lag = 500;
+        this->write_queue_high_watermark = 0;  // disabled by default
+        this->write_queue_low_watermark = 0;
         this->log_slow_requests_time_ms = -1;
         this->num_collections_parallel_load = 0;  // will be set dynamically if not overridden
         this->num_documents_parallel_load = 1000;
         this->thread_pool_size = 0; // will be set dynamically if not overridden
+        this->indexing_thread_pool_size = 0; // will be set dynamically if not overridden
+        this->num_http_loops = 1;
         this->ssl_refresh_interval_seconds = 8 * 60 * 60;
+        this->db_block_cache_mb = 0;
+        this->db_write_buffer_mb = 0;
+        this->db_max_write_buffer_number = 0;
+        this->db_max_background_jobs = 0;
+        this->db_compaction_rate_mb_per_sec = 0;
     }
 
     Config(Config const&) {
@@ -180,6 +229,18 @@ public:
         return this->enable_cors;
     }
 
+    bool get_enable_index_snapshots() const {
+        return this->enable_index_snapshots;
+    }
+
+    bool get_enable_lazy_collections() const {
+        return this->enable_lazy_collections;
+    }
+
+    bool get_read_replica() const {
+        return this->read_replica;
+    }
+
     std::string get_peering_address() const {
         return this->peering_address;
     }
@@ -200,6 +261,14 @@ public:
         return this->snapshot_interval_seconds;
     }
 
+    std::string get_snapshot_window() const {
+        return this->snapshot_window;
+    }
+
+    int get_snapshot_max_write_mb_per_sec() const {
+        return this->snapshot_max_write_mb_per_sec;
+    }
+
     size_t get_healthy_read_lag() const {
         return this->healthy_read_lag;
     }
@@ -208,6 +277,14 @@ public:
         return this->healthy_write_lag;
     }
 
+    size_t get_write_queue_high_watermark() const {
+        return this->write_queue_high_watermark;
+    }
+
+    size_t get_write_queue_low_watermark() const {
+        return this->write_queue_low_watermark;
+    }
+
     int get_log_slow_requests_time_ms() const {
         return this->log_slow_requests_time_ms;
     }
@@ -224,10 +301,38 @@ public:
         return this->thread_pool_size;
     }
 
+    size_t get_indexing_thread_pool_size() const {
+        return this->indexing_thread_pool_size;
+    }
+
+    size_t get_num_http_loops() const {
+        return this->num_http_loops;
+    }
+
     size_t get_ssl_refresh_interval_seconds() const {
         return this->ssl_refresh_interval_seconds;
     }
 
+    size_t get_db_block_cache_mb() const {
+        return this->db_block_cache_mb;
+    }
+
+    size_t get_db_write_buffer_mb() const {
+        return this->db_write_buffer_mb;
+    }
+
+    size_t get_db_max_write_buffer_number() const {
+        return this->db_max_write_buffer_number;
+    }
+
+    int get_db_max_background_jobs() const {
+        return this->db_max_background_jobs;
+    }
+
+    int get_db_compaction_rate_mb_per_sec() const {
+        return this->db_compaction_rate_mb_per_sec;
+    }
+
     // loaders
 
     std::string get_env(const char *name) {
@@ -280,6 +385,18 @@ public:
         StringUtils::toupper(enable_cors_str);
         this->enable_cors = ("TRUE" == enable_cors_str) ? true : false;
 
+        std::string enable_index_snapshots_str = get_env("TYPESENSE_ENABLE_INDEX_SNAPSHOTS");
+        StringUtils::toupper(enable_index_snapshots_str);
+        this->enable_index_snapshots = ("TRUE" == enable_index_snapshots_str) ? true : false;
+
+        std::string enable_lazy_collections_str = get_env("TYPESENSE_ENABLE_LAZY_COLLECTIONS");
+        StringUtils::toupper(enable_lazy_collections_str);
+        this->enable_lazy_collections = ("TRUE" == enable_lazy_collections_str) ? true : false;
+
+        std::string read_replica_str = get_env("TYPESENSE_READ_REPLICA");
+        StringUtils::toupper(read_replica_str);
+        this->read_replica = ("TRUE" == read_replica_str) ? true : false;
+
         if(!get_env("TYPESENSE_MAX_MEMORY_RATIO").empty()) {
             this->max_memory_ratio = std::stof(get_env("TYPESENSE_MAX_MEMORY_RATIO"));
         }
@@ -288,6 +405,14 @@ public:
             this->snapshot_interval_seconds = std::stoi(get_env("TYPESENSE_SNAPSHOT_INTERVAL_SECONDS"));
         }
 
+        if(!get_env("TYPESENSE_SNAPSHOT_WINDOW").empty()) {
+            this->snapshot_window = get_env("TYPESENSE_SNAPSHOT_WINDOW");
+        }
+
+        if(!get_env("TYPESENSE_SNAPSHOT_MAX_WRITE_MB_PER_SEC").empty()) {
+            this->snapshot_max_write_mb_per_sec = std::stoi(get_env("TYPESENSE_SNAPSHOT_MAX_WRITE_MB_PER_SEC"));
+        }
+
         if(!get_env("TYPESENSE_HEALTHY_READ_LAG").empty()) {
             this->healthy_read_lag = std::stoi(get_env("TYPESENSE_HEALTHY_READ_LAG"));
         }
@@ -296,6 +421,14 @@ public:
             this->healthy_write_lag = std::stoi(get_env("TYPESENSE_HEALTHY_WRITE_LAG"));
         }
 
+        if(!get_env("TYPESENSE_WRITE_QUEUE_HIGH_WATERMARK").empty()) {
+            this->write_queue_high_watermark = std::stoi(get_env("TYPESENSE_WRITE_QUEUE_HIGH_WATERMARK"));
+        }
+
+        if(!get_env("TYPESENSE_WRITE_QUEUE_LOW_WATERMARK").empty()) {
+            this->write_queue_low_watermark = std::stoi(get_env("TYPESENSE_WRITE_QUEUE_LOW_WATERMARK"));
+        }
+
         if(!get_env("TYPESENSE_LOG_SLOW_REQUESTS_TIME_MS").empty()) {
             this->log_slow_requests_time_ms = std::stoi(get_env("TYPESENSE_LOG_SLOW_REQUESTS_TIME_MS"));
         }
@@ -312,9 +445,37 @@ public:
             this->thread_pool_size = std::stoi(get_env("TYPESENSE_THREAD_POOL_SIZE"));
         }
 
+        if(!get_env("TYPESENSE_INDEXING_THREAD_POOL_SIZE").empty()) {
+            this->indexing_thread_pool_size = std::stoi(get_env("TYPESENSE_INDEXING_THREAD_POOL_SIZE"));
+        }
+
+        if(!get_env("TYPESENSE_NUM_HTTP_LOOPS").empty()) {
+            this->num_http_loops = std::stoi(get_env("TYPESENSE_NUM_HTTP_LOOPS"));
+        }
+
         if(!get_env("TYPESENSE_SSL_REFRESH_INTERVAL_SECONDS").empty()) {
             this->ssl_refresh_interval_seconds = std::stoi(get_env("TYPESENSE_SSL_REFRESH_INTERVAL_SECONDS"));
         }
+
+        if(!get_env("TYPESENSE_DB_BLOCK_CACHE_MB").empty()) {
+            this->db_block_cache_mb = std::stoi(get_env("TYPESENSE_DB_BLOCK_CACHE_MB"));
+        }
+
+        if(!get_env("TYPESENSE_DB_WRITE_BUFFER_MB").empty()) {
+            this->db_write_buffer_mb = std::stoi(get_env("TYPESENSE_DB_WRITE_BUFFER_MB"));
+        }
+
+        if(!get_env("TYPESENSE_DB_MAX_WRITE_BUFFER_NUMBER").empty()) {
+            this->db_max_write_buffer_number = std::stoi(get_env("TYPESENSE_DB_MAX_WRITE_BUFFER_NUMBER"));
+        }
+
+        if(!get_env("TYPESENSE_DB_MAX_BACKGROUND_JOBS").empty()) {
+            this->db_max_background_jobs = std::stoi(get_env("TYPESENSE_DB_MAX_BACKGROUND_JOBS"));
+        }
+
+        if(!get_env("TYPESENSE_DB_COMPACTION_RATE_MB_PER_SEC").empty()) {
+            this->db_compaction_rate_mb_per_sec = std::stoi(get_env("TYPESENSE_DB_COMPACTION_RATE_MB_PER_SEC"));
+        }
     }
 
     void load_config_file(cmdline::parser & options) {
@@ -385,6 +546,18 @@ public:
             this->enable_cors = reader.GetBoolean("server", "enable-cors", false);
         }
 
+        if(reader.Exists("server", "enable-index-snapshots")) {
+            this->enable_index_snapshots = reader.GetBoolean("server", "enable-index-snapshots", false);
+        }
+
+        if(reader.Exists("server", "enable-lazy-collections")) {
+            this->enable_lazy_collections = reader.GetBoolean("server", "enable-lazy-collections", false);
+        }
+
+        if(reader.Exists("server", "read-replica")) {
+            this->read_replica = reader.GetBoolean("server", "read-replica", false);
+        }
+
         if(reader.Exists("server", "peering-address")) {
             this->peering_address = reader.Get("server", "peering-address", "");
         }
@@ -405,6 +578,14 @@ public:
             this->snapshot_interval_seconds = (int) reader.GetInteger("server", "snapshot-interval-seconds", 3600);
         }
 
+        if(reader.Exists("server", "snapshot-window")) {
+            this->snapshot_window = reader.Get("server", "snapshot-window", "");
+        }
+
+        if(reader.Exists("server", "snapshot-max-write-mb-per-sec")) {
+            this->snapshot_max_write_mb_per_sec = (int) reader.GetInteger("server", "snapshot-max-write-mb-per-sec", 0);
+        }
+
         if(reader.Exists("server", "healthy-read-lag")) {
             this->healthy_read_lag = (size_t) reader.GetInteger("server", "healthy-read-lag", 1000);
         }
@@ -413,6 +594,14 @@ public:
             this->healthy_write_lag = (size_t) reader.GetInteger("server", "healthy-write-lag", 100);
         }
 
+        if(reader.Exists("server", "write-queue-high-watermark")) {
+            this->write_queue_high_watermark = (size_t) reader.GetInteger("server", "write-queue-high-watermark", 0);
+        }
+
+        if(reader.Exists("server", "write-queue-low-watermark")) {
+            this->write_queue_low_watermark = (size_t) reader.GetInteger("server", "write-queue-low-watermark", 0);
+        }
+
         if(reader.Exists("server", "log-slow-requests-time-ms")) {
             this->log_slow_requests_time_ms = (int) reader.GetInteger("server", "log-slow-requests-time-ms", -1);
         }
@@ -429,9 +618,37 @@ public:
             this->thread_pool_size = (int) reader.GetInteger("server", "thread-pool-size", 0);
         }
 
+        if(reader.Exists("server", "indexing-thread-pool-size")) {
+            this->indexing_thread_pool_size = (int) reader.GetInteger("server", "indexing-thread-pool-size", 0);
+        }
+
+        if(reader.Exists("server", "num-http-loops")) {
+            this->num_http_loops = (int) reader.GetInteger("server", "num-http-loops", 1);
+        }
+
         if(reader.Exists("server", "ssl-refresh-interval-seconds")) {
             this->ssl_refresh_interval_seconds = (int) reader.GetInteger("server", "ssl-refresh-interval-seconds", 8 * 60 * 60);
         }
+
+        if(reader.Exists("server", "db-block-cache-mb")) {
+            this->db_block_cache_mb = (size_t) reader.GetInteger("server", "db-block-cache-mb", 0);
+        }
+
+        if(reader.Exists("server", "db-write-buffer-mb")) {
+            this->db_write_buffer_mb = (size_t) reader.GetInteger("server", "db-write-buffer-mb", 0);
+        }
+
+        if(reader.Exists("server", "db-max-write-buffer-number")) {
+            this->db_max_write_buffer_number = (size_t) reader.GetInteger("server", "db-max-write-buffer-number", 0);
+        }
+
+        if(reader.Exists("server", "db-max-background-jobs")) {
+            this->db_max_background_jobs = (int) reader.GetInteger("server", "db-max-background-jobs", 0);
+        }
+
+        if(reader.Exists("server", "db-compaction-rate-mb-per-sec")) {
+            this->db_compaction_rate_mb_per_sec = (int) reader.GetInteger("server", "db-compaction-rate-mb-per-sec", 0);
+        }
     }
 
     void load_config_cmd_args(cmdline::parser & options) {
@@ -484,6 +701,18 @@ public:
             this->enable_cors = options.exist("enable-cors");
         }
 
+        if(options.exist("enable-index-snapshots")) {
+            this->enable_index_snapshots = options.exist("enable-index-snapshots");
+        }
+
+        if(options.exist("enable-lazy-collections")) {
+            this->enable_lazy_collections = options.exist("enable-lazy-collections");
+        }
+
+        if(options.exist("read-replica")) {
+            this->read_replica = options.exist("read-replica");
+        }
+
         if(options.exist("peering-address")) {
             this->peering_address = options.get<std::string>("peering-address");
         }
@@ -504,6 +733,14 @@ public:
             this->snapshot_interval_seconds = options.get<int>("snapshot-interval-seconds");
         }
 
+        if(options.exist("snapshot-window")) {
+            this->snapshot_window = options.get<std::string>("snapshot-window");
+        }
+
+        if(options.exist("snapshot-max-write-mb-per-sec")) {
+            this->snapshot_max_write_mb_per_sec = options.get<int>("snapshot-max-write-mb-per-sec");
+        }
+
         if(options.exist("healthy-read-lag")) {
             this->healthy_read_lag = options.get<size_t>("healthy-read-lag");
         }
@@ -512,6 +749,14 @@ public:
             this->healthy_write_lag = options.get<size_t>("healthy-write-lag");
         }
 
+        if(options.exist("write-queue-high-watermark")) {
+            this->write_queue_high_watermark = options.get<size_t>("write-queue-high-watermark");
+        }
+
+        if(options.exist("write-queue-low-watermark")) {
+            this->write_queue_low_watermark = options.get<size_t>("write-queue-low-watermark");
+        }
+
         if(options.exist("log-slow-requests-time-ms")) {
             this->log_slow_requests_time_ms = options.get<int>("log-slow-requests-time-ms");
         }
@@ -528,9 +773,37 @@ public:
             this->thread_pool_size = options.get<uint32_t>("thread-pool-size");
         }
 
+        if(options.exist("indexing-thread-pool-size")) {
+            this->indexing_thread_pool_size = options.get<uint32_t>("indexing-thread-pool-size");
+        }
+
+        if(options.exist("num-http-loops")) {
+            this->num_http_loops = options.get<uint32_t>("num-http-loops");
+        }
+
         if(options.exist("ssl-refresh-interval-seconds")) {
             this->ssl_refresh_interval_seconds = options.get<uint32_t>("ssl-refresh-interval-seconds");
         }
+
+        if(options.exist("db-block-cache-mb")) {
+            this->db_block_cache_mb = options.get<size_t>("db-block-cache-mb");
+        }
+
+        if(options.exist("db-write-buffer-mb")) {
+            this->db_write_buffer_mb = options.get<size_t>("db-write-buffer-mb");
+        }
+
+        if(options.exist("db-max-write-buffer-number")) {
+            this->db_max_write_buffer_number = options.get<size_t>("db-max-write-buffer-number");
+        }
+
+        if(options.exist("db-max-background-jobs")) {
+            this->db_max_background_jobs = options.get<int>("db-max-background-jobs");
+        }
+
+        if(options.exist("db-compaction-rate-mb-per-sec")) {
+            this->db_compaction_rate_mb_per_sec = options.get<int>("db-compaction-rate-mb-per-sec");
+        }
     }
 
     // validation
@@ -15,6 +15,8 @@ bool del_drop_collection(const std::shared_ptr<http_req>& req, const std::shared
 
 bool get_collection_summary(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
+bool get_collection_stats(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
+
 // Documents
 
 bool get_search(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
@@ -35,6 +37,10 @@ bool del_remove_document(const std::shared_ptr<http_req>& req, const std::shared
 
 bool del_remove_documents(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
+bool get_delete_job(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
+
+bool del_delete_job(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
+
 // Alias
 
 bool get_alias(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
@@ -79,6 +85,8 @@ bool del_key(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_re
 
 bool get_debug(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
+bool get_debug_rocksdb(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
+
 bool get_health(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
 bool post_health(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
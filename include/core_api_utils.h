@@ -2,6 +2,10 @@
 
 #include <cstdlib>
 #include <vector>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
 #include "collection.h"
 
 struct deletion_state_t {
@@ -18,6 +22,13 @@ struct deletion_state_t {
 };
 
 struct export_state_t {
+    // documents are packed into a response chunk until it crosses this size,
+    // so each deferred handler invocation ships a full buffer instead of one row
+    static const size_t CHUNK_SIZE_BYTES = 1024 * 1024;
+
+    // iterator readahead for the sequential scan over document values
+    static const size_t SCAN_READAHEAD_BYTES = 4 * 1024 * 1024;
+
     Collection* collection;
     std::vector<std::pair<size_t, uint32_t*>> index_ids;
     std::vector<size_t> offsets;
@@ -27,6 +38,10 @@ struct export_state_t {
 
     bool filtered_export = false;
 
+    // whether at least one document has been written, for newline joining
+    // across response chunks
+    bool exported_any = false;
+
     rocksdb::Iterator* it = nullptr;
 
     ~export_state_t() {
@@ -38,5 +53,96 @@ struct export_state_t {
     }
 };
 
+// hands the hits of a search response to the streaming machinery in batches, so
+// serialization happens into bounded chunks instead of one response-sized buffer
+struct search_stream_state_t {
+    // hits are packed into a response chunk until it crosses this size
+    static const size_t CHUNK_SIZE_BYTES = 1024 * 1024;
+
+    // every top-level field except the hits, serialized up-front (small)
+    std::string header;
+
+    // `hits` or `grouped_hits`
+    std::string hits_key;
+
+    // ungrouped hits arrive pre-serialized from the search itself; grouped hits
+    // (and cached-path fallbacks) are still carried as a tree
+    bool hits_are_serialized = false;
+    std::vector<std::string> serialized_hits;
+
+    nlohmann::json hits;
+    size_t next_hit_index = 0;
+
+    size_t num_hits() const {
+        return hits_are_serialized ? serialized_hits.size() : hits.size();
+    }
+};
+
+// a delete-by-filter running in the background: the submitting request returns
+// a job id right away and progress is polled via the delete_jobs end-points
+struct delete_job_t {
+    enum class state_t { running, done, failed, cancelled };
+
+    uint64_t id = 0;
+    std::string collection;
+    std::string filter_by;
+    size_t batch_size = 0;
+    uint64_t created_at = 0;
+
+    std::atomic<size_t> num_matched{0};
+    std::atomic<size_t> num_removed{0};
+    std::atomic<state_t> state{state_t::running};
+    std::atomic<bool> cancel_requested{false};
+
+    // written once by the worker before `state` flips to failed
+    std::string error;
+
+    static const char* state_to_str(state_t state);
+
+    nlohmann::json to_json() const;
+};
+
+class DeleteJobManager {
+private:
+    mutable std::mutex mutex;
+
+    // job id => job, ordered so that the oldest finished jobs are pruned first
+    std::map<uint64_t, std::shared_ptr<delete_job_t>> jobs;
+
+    uint64_t next_job_id = 1;
+
+    DeleteJobManager() = default;
+
+    void run_job(const std::shared_ptr<delete_job_t>& job);
+
+public:
+
+    // deletions happen in much larger batches than the synchronous end-point
+    // since no response is held open between them
+    static const size_t DEFAULT_JOB_BATCH_SIZE = 10000;
+
+    // pause between batches when searches were served in the last metrics
+    // window, so a large purge does not starve live traffic
+    static const size_t THROTTLE_SLEEP_MS = 25;
+
+    // only this many finished jobs are remembered for status polling
+    static const size_t MAX_FINISHED_JOBS = 100;
+
+    static DeleteJobManager& get_instance() {
+        static DeleteJobManager instance;
+        return instance;
+    }
+
+    DeleteJobManager(DeleteJobManager const&) = delete;
+    void operator=(DeleteJobManager const&) = delete;
+
+    Option<std::shared_ptr<delete_job_t>> submit(const std::string& collection,
+                                                 const std::string& filter_by, size_t batch_size);
+
+    Option<std::shared_ptr<delete_job_t>> get(uint64_t id) const;
+
+    Option<std::shared_ptr<delete_job_t>> cancel(uint64_t id);
+};
+
 Option<bool> stateful_remove_docs(deletion_state_t* deletion_state, size_t batch_size, bool& done);
 Option<bool> stateful_export_docs(export_state_t* export_state, size_t batch_size, bool& done);
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+/*
+ * Function multiversioning for hot kernels: the compiler emits one clone of
+ * the annotated function per listed target and the dynamic loader binds the
+ * best one through an ifunc resolver at startup, so a single shipped binary
+ * takes the AVX2 paths on machines that have it without per-machine builds.
+ *
+ * Requires GNU-style `target_clones` and an ELF loader (Linux); elsewhere the
+ * attribute expands to nothing and the kernel is compiled once for the
+ * baseline target.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__ELF__) && \
+    (!defined(__clang__) || __clang_major__ >= 14)
+#define CLONE_FOR_AVX2 __attribute__((target_clones("avx2", "default")))
+#else
+#define CLONE_FOR_AVX2
+#endif
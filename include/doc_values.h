@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Columnar store for a sort field's values, addressed directly by seq_id.
+ * score_results() reads one value per candidate document, so the values live
+ * in a flat array that candidate iteration walks mostly sequentially, instead
+ * of a hash map that costs a cache miss per probe. A validity bitmap marks
+ * slots of deleted documents and of documents that don't have the field
+ * (optional fields); since seq_ids are only re-used on the in-place update
+ * path, a cleared slot is its own free slot and is simply re-written when the
+ * same document is indexed again.
+ */
+class doc_values_t {
+private:
+    std::vector<int64_t> vals;
+    std::vector<bool> valid;
+
+public:
+
+    void upsert(uint32_t seq_id, int64_t value) {
+        if(seq_id >= vals.size()) {
+            // grow geometrically: seq_ids arrive mostly in increasing order and
+            // a resize to exactly `seq_id + 1` each time would be quadratic
+            if(size_t(seq_id) >= vals.capacity()) {
+                const size_t new_capacity = std::max<size_t>(2 * vals.capacity(), size_t(seq_id) + 1);
+                vals.reserve(new_capacity);
+                valid.reserve(new_capacity);
+            }
+
+            vals.resize(size_t(seq_id) + 1);
+            valid.resize(size_t(seq_id) + 1, false);
+        }
+
+        vals[seq_id] = value;
+        valid[seq_id] = true;
+    }
+
+    void erase(uint32_t seq_id) {
+        if(seq_id < vals.size()) {
+            valid[seq_id] = false;
+        }
+    }
+
+    bool contains(uint32_t seq_id) const {
+        return seq_id < vals.size() && valid[seq_id];
+    }
+
+    // caller must ensure that `seq_id` is present
+    int64_t at(uint32_t seq_id) const {
+        return vals[seq_id];
+    }
+
+    int64_t get(uint32_t seq_id, int64_t default_value) const {
+        return contains(seq_id) ? vals[seq_id] : default_value;
+    }
+
+    size_t num_slots() const {
+        return vals.size();
+    }
+
+    size_t memory_bytes() const {
+        return sizeof(doc_values_t) + (vals.capacity() * sizeof(int64_t)) + (valid.capacity() / 8);
+    }
+};
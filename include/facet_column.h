@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "field.h"
+
+/*
+ * Columnar store for a facet field's hash lists, addressed directly by seq_id.
+ * do_facets() touches one row per candidate document, so rows live in a flat
+ * array that result iteration walks in order instead of a hash map that costs
+ * a cache miss per probe. A row with no hashes marks a document that doesn't
+ * have the field (or has been deleted).
+ */
+class facet_column_t {
+private:
+    std::vector<facet_hash_values_t> rows;
+
+public:
+
+    void upsert(uint32_t seq_id, facet_hash_values_t&& fhashvalues) {
+        if(seq_id >= rows.size()) {
+            // grow geometrically: seq_ids arrive mostly in increasing order and
+            // a resize to exactly `seq_id + 1` each time would be quadratic
+            if(size_t(seq_id) >= rows.capacity()) {
+                rows.reserve(std::max<size_t>(2 * rows.capacity(), size_t(seq_id) + 1));
+            }
+
+            rows.resize(size_t(seq_id) + 1);
+        }
+
+        rows[seq_id] = std::move(fhashvalues);
+    }
+
+    void erase(uint32_t seq_id) {
+        if(seq_id < rows.size()) {
+            rows[seq_id] = facet_hash_values_t();
+        }
+    }
+
+    // returns nullptr when the document has no values for the field
+    const facet_hash_values_t* get(uint32_t seq_id) const {
+        if(seq_id >= rows.size() || rows[seq_id].length == 0) {
+            return nullptr;
+        }
+
+        return &rows[seq_id];
+    }
+
+    size_t num_rows() const {
+        return rows.size();
+    }
+
+    size_t memory_bytes() const {
+        size_t bytes = sizeof(facet_column_t) + (rows.capacity() * sizeof(facet_hash_values_t));
+
+        for(const auto& row: rows) {
+            bytes += row.length * sizeof(uint64_t);
+        }
+
+        return bytes;
+    }
+};
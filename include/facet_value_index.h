@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+#include "art.h"
+#include "posting.h"
+#include "sparsepp.h"
+
+/*
+ * Prefix index over the values of a single facet field, used to resolve
+ * facet_query (type-ahead inside a facet) without scanning candidate
+ * documents. Keys are the normalized tokens of the values and each key maps
+ * back to the hashes of the values containing that token, which is what
+ * do_facets() counts against — so a query token finds its values with one
+ * prefix lookup ("bal" finds the hash of "New Balance") instead of a
+ * candidate scan.
+ */
+class facet_value_index_t {
+private:
+    art_tree tree;
+
+    // token => hashes of the values containing it; a hash can linger after
+    // its last document is gone for as long as another value shares the
+    // token, but do_facets() only counts hashes present in result documents,
+    // so a stale entry costs a lookup, never a wrong count
+    spp::sparse_hash_map<std::string, std::vector<uint64_t>> key_to_hashes;
+
+public:
+
+    explicit facet_value_index_t(token_interner_t* interner) {
+        art_tree_init_interned(&tree, interner);
+    }
+
+    ~facet_value_index_t() {
+        art_tree_destroy(&tree);
+    }
+
+    facet_value_index_t(const facet_value_index_t&) = delete;
+    facet_value_index_t& operator=(const facet_value_index_t&) = delete;
+
+    void insert(const std::string& key, const uint64_t fhash, const uint32_t seq_id, const int64_t score) {
+        art_document art_doc(seq_id, score, {0});
+        art_insert(&tree, (const unsigned char *) key.c_str(), key.size() + 1, &art_doc);
+
+        auto& hashes = key_to_hashes[key];
+        if(std::find(hashes.begin(), hashes.end(), fhash) == hashes.end()) {
+            hashes.push_back(fhash);
+        }
+    }
+
+    void remove(const std::string& key, const uint32_t seq_id) {
+        art_leaf* leaf = (art_leaf *) art_search(&tree, (const unsigned char *) key.c_str(), key.size() + 1);
+        if(leaf == nullptr) {
+            return;
+        }
+
+        posting_t::erase(leaf->values, seq_id);
+
+        if(posting_t::num_ids(leaf->values) == 0) {
+            void* values = art_delete(&tree, (const unsigned char *) key.c_str(), key.size() + 1);
+            posting_t::destroy_list(values);
+            key_to_hashes.erase(key);
+        }
+    }
+
+    // returns up to `max_keys` matching keys (most frequent first) with their hashes;
+    // `filter_ids` restricts matches to keys held by at least one of those documents
+    void search(const std::string& query, const int max_cost, const size_t max_keys,
+                const uint32_t* filter_ids, const size_t filter_ids_length,
+                std::vector<std::pair<std::string, std::vector<uint64_t>>>& matches) {
+        std::vector<art_leaf*> leaves;
+
+        art_rcu_reader_enter();
+
+        // prefix searches pass the term length without the terminating null
+        art_fuzzy_search(&tree, (const unsigned char *) query.c_str(), query.size(),
+                         0, max_cost, max_keys, FREQUENCY, true, filter_ids, filter_ids_length, leaves);
+
+        for(const art_leaf* leaf: leaves) {
+            std::string key(reinterpret_cast<const char*>(leaf->key), leaf->key_len - 1);
+            const auto it = key_to_hashes.find(key);
+            if(it != key_to_hashes.end()) {
+                matches.emplace_back(std::move(key), it->second);
+            }
+        }
+
+        art_rcu_reader_exit();
+    }
+
+    size_t num_keys() const {
+        return key_to_hashes.size();
+    }
+
+    size_t memory_bytes() const {
+        size_t bytes = sizeof(facet_value_index_t) + art_tree_arena_bytes(&tree);
+
+        // posting lists hanging off the suffix tree's leaves
+        art_iter_leaves(const_cast<art_tree*>(&tree), [](void* data, const art_leaf* leaf) {
+            *static_cast<size_t*>(data) += posting_t::memory_bytes(leaf->values);
+            return 0;
+        }, &bytes);
+
+        for(const auto& key_hashes: key_to_hashes) {
+            bytes += sizeof(std::string) + key_hashes.first.capacity() +
+                     sizeof(std::vector<uint64_t>) + (key_hashes.second.capacity() * sizeof(uint64_t));
+        }
+
+        return bytes;
+    }
+
+    // snapshot support: the suffix tree holding (key => seq_ids) postings
+    art_tree* get_tree() {
+        return &tree;
+    }
+
+    // snapshot support: walks every (key, value hashes) entry
+    template<typename F>
+    void iterate_key_hashes(F func) const {
+        for(const auto& key_hashes: key_to_hashes) {
+            func(key_hashes.first, key_hashes.second);
+        }
+    }
+
+    // snapshot support: installs a key's value hashes wholesale
+    void load_key_hashes(std::string&& key, std::vector<uint64_t>&& hashes) {
+        key_to_hashes[std::move(key)] = std::move(hashes);
+    }
+};
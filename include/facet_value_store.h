@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "sparsepp.h"
+
+/*
+ * Interned copy of a facet field's distinct values, keyed by facet hash.
+ * A value repeated across millions of documents is stored exactly once with
+ * a reference count, and facet responses resolve their top values from here
+ * instead of fetching a representative document from the store per value.
+ */
+class facet_value_store_t {
+private:
+    struct interned_value_t {
+        std::string value;
+        uint32_t ref_count = 0;
+    };
+
+    spp::sparse_hash_map<uint64_t, interned_value_t> values;
+
+public:
+
+    void intern(const uint64_t fhash, const std::string& value) {
+        interned_value_t& interned = values[fhash];
+
+        if(interned.ref_count == 0) {
+            interned.value = value;
+        }
+
+        interned.ref_count++;
+    }
+
+    void release(const uint64_t fhash) {
+        const auto it = values.find(fhash);
+        if(it == values.end()) {
+            return;
+        }
+
+        if(--it->second.ref_count == 0) {
+            values.erase(it);
+        }
+    }
+
+    // returns nullptr when no live document holds a value with this hash
+    const std::string* get(const uint64_t fhash) const {
+        const auto it = values.find(fhash);
+        return (it == values.end()) ? nullptr : &it->second.value;
+    }
+
+    size_t num_values() const {
+        return values.size();
+    }
+
+    size_t memory_bytes() const {
+        size_t bytes = sizeof(facet_value_store_t);
+
+        for(const auto& hash_value: values) {
+            bytes += sizeof(uint64_t) + sizeof(interned_value_t) + hash_value.second.value.capacity();
+        }
+
+        return bytes;
+    }
+
+    // snapshot support: walks every (hash, value, ref_count) entry
+    template<typename F>
+    void iterate_values(F func) const {
+        for(const auto& hash_value: values) {
+            func(hash_value.first, hash_value.second.value, hash_value.second.ref_count);
+        }
+    }
+
+    // snapshot support: installs an interned value with its reference count
+    void load_value(const uint64_t fhash, std::string&& value, uint32_t ref_count) {
+        interned_value_t& interned = values[fhash];
+        interned.value = std::move(value);
+        interned.ref_count = ref_count;
+    }
+};
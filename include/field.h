@@ -38,6 +38,7 @@ namespace fields {
     static const std::string optional = "optional";
     static const std::string index = "index";
     static const std::string locale = "locale";
+    static const std::string materialize = "materialize";
 }
 
 struct field {
@@ -49,9 +50,15 @@ struct field {
 
     std::string locale;
 
+    // maintain a ready-made id list per distinct value so that equality filters
+    // become a plain lookup; meant for low-cardinality fields like a bool flag
+    // or a store / branch identifier
+    bool materialize;
+
     field(const std::string &name, const std::string &type, const bool facet, const bool optional = false,
-          bool index = true, std::string locale = "") :
-            name(name), type(type), facet(facet), optional(optional), index(index), locale(locale) {
+          bool index = true, std::string locale = "", bool materialize = false) :
+            name(name), type(type), facet(facet), optional(optional), index(index), locale(locale),
+            materialize(materialize) {
 
     }
 
@@ -211,6 +218,7 @@ struct field {
             field_val[fields::optional] = field.optional;
 
             field_val[fields::locale] = field.locale;
+            field_val[fields::materialize] = field.materialize;
 
             fields_json.push_back(field_val);
 
@@ -252,6 +260,11 @@ struct field {
                 return Option<bool>(400, "Field `" + field.name + "` cannot be a facet since "
                                                                   "it's marked as non-indexable.");
             }
+
+            if(field.materialize && !(field.is_integer() || field.is_float() || field.is_bool())) {
+                return Option<bool>(400, "Field `" + field.name + "` cannot be materialized since only "
+                                                                  "numerical and bool fields support it.");
+            }
         }
 
         if(!default_sorting_field.empty() && !found_default_sorting_field) {
@@ -299,6 +312,11 @@ struct field {
                                          field_json[fields::name].get<std::string>() + std::string("` should be a boolean."));
             }
 
+            if(field_json.count(fields::materialize) != 0 && !field_json.at(fields::materialize).is_boolean()) {
+                return Option<bool>(400, std::string("The `materialize` property of the field `") +
+                                         field_json[fields::name].get<std::string>() + std::string("` should be a boolean."));
+            }
+
             if(field_json.count(fields::locale) != 0){
                 if(!field_json.at(fields::locale).is_string()) {
                     return Option<bool>(400, std::string("The `locale` property of the field `") +
@@ -368,6 +386,10 @@ struct field {
                 field_json[fields::locale] = "";
             }
 
+            if(field_json.count(fields::materialize) == 0) {
+                field_json[fields::materialize] = false;
+            }
+
             if(field_json.count(fields::optional) == 0) {
                 // dynamic fields are always optional
                 bool is_dynamic = field::is_dynamic(field_json[fields::name], field_json[fields::type]);
@@ -376,7 +398,8 @@ struct field {
 
             fields.emplace_back(
                 field(field_json[fields::name], field_json[fields::type], field_json[fields::facet],
-                      field_json[fields::optional], field_json[fields::index], field_json[fields::locale])
+                      field_json[fields::optional], field_json[fields::index], field_json[fields::locale],
+                      field_json[fields::materialize])
             );
         }
 
@@ -565,7 +588,16 @@ struct facet {
 
     facet_stats_t stats;
 
-    explicit facet(const std::string& field_name): field_name(field_name) {
+    // opt-in: count into a bounded summary, trading exactness beyond the
+    // displayed top values for bounded memory on high-cardinality fields
+    bool approx;
+
+    // set when counts were computed from a sample of the result ids and
+    // scaled up, so the response can mark them as estimates
+    bool sampled = false;
+
+    explicit facet(const std::string& field_name, bool approx = false):
+            field_name(field_name), approx(approx) {
 
     }
 };
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <string>
+
 bool directory_exists(const std::string & dir_path);
 
 bool file_exists(const std::string & file_path);
@@ -7,6 +10,11 @@ bool file_exists(const std::string & file_path);
 // tries to hard link first
 bool copy_dir(const std::string& from_path, const std::string& to_path);
 
+// recursive copy without hard linking; when `max_write_mb_per_sec` is non-zero,
+// writes are paced to stay below that rate. Bytes written are added to `bytes_copied`.
+bool copy_dir_throttled(const std::string& from_path, const std::string& to_path,
+                        size_t max_write_mb_per_sec, uint64_t& bytes_copied);
+
 bool mv_dir(const std::string& from_path, const std::string& to_path);
 
 bool rename_path(const std::string& from_path, const std::string& to_path);
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "sparsepp.h"
+
+/*
+ * Dedicated index for geopoint fields: ids are stored per S2 cell term, and
+ * since the term set produced at index time spans multiple cell precisions,
+ * a query covering resolves through plain per-term lookups. Per-cell id lists
+ * are kept sorted and de-duplicated so that collecting the candidates of a
+ * radius / polygon filter is a bulk gather + merge instead of a red-black
+ * tree insert per id, and so that the exact verification pass that follows
+ * reads the packed lat/lng column in seq_id order.
+ */
+class geo_index_t {
+private:
+    // S2 cell term (includes ancestor terms at coarser precisions) => sorted ids
+    spp::sparse_hash_map<std::string, std::vector<uint32_t>> cell_to_ids;
+
+public:
+
+    void insert(const std::string& term, uint32_t seq_id) {
+        std::vector<uint32_t>& ids = cell_to_ids[term];
+
+        if(ids.empty() || ids.back() < seq_id) {
+            // fast path: ids mostly arrive in increasing order
+            ids.push_back(seq_id);
+        } else {
+            auto it = std::lower_bound(ids.begin(), ids.end(), seq_id);
+            if(it == ids.end() || *it != seq_id) {
+                ids.insert(it, seq_id);
+            }
+        }
+    }
+
+    void remove(const std::string& term, uint32_t seq_id) {
+        auto term_it = cell_to_ids.find(term);
+        if(term_it == cell_to_ids.end()) {
+            return;
+        }
+
+        std::vector<uint32_t>& ids = term_it->second;
+        auto it = std::lower_bound(ids.begin(), ids.end(), seq_id);
+        if(it != ids.end() && *it == seq_id) {
+            ids.erase(it);
+        }
+
+        if(ids.empty()) {
+            cell_to_ids.erase(term_it);
+        }
+    }
+
+    // gathers the ids of all query terms into a sorted, de-duplicated list
+    void collect(const std::vector<std::string>& terms, std::vector<uint32_t>& result_ids) const {
+        size_t num_ids = 0;
+
+        for(const std::string& term: terms) {
+            auto term_it = cell_to_ids.find(term);
+            if(term_it != cell_to_ids.end()) {
+                num_ids += term_it->second.size();
+            }
+        }
+
+        result_ids.reserve(result_ids.size() + num_ids);
+
+        for(const std::string& term: terms) {
+            auto term_it = cell_to_ids.find(term);
+            if(term_it != cell_to_ids.end()) {
+                result_ids.insert(result_ids.end(), term_it->second.begin(), term_it->second.end());
+            }
+        }
+
+        std::sort(result_ids.begin(), result_ids.end());
+        result_ids.erase(std::unique(result_ids.begin(), result_ids.end()), result_ids.end());
+    }
+
+    size_t num_cells() const {
+        return cell_to_ids.size();
+    }
+
+    size_t memory_bytes() const {
+        size_t bytes = sizeof(geo_index_t);
+
+        for(const auto& cell_ids: cell_to_ids) {
+            bytes += sizeof(std::string) + cell_ids.first.capacity() +
+                     sizeof(std::vector<uint32_t>) + (cell_ids.second.capacity() * sizeof(uint32_t));
+        }
+
+        return bytes;
+    }
+
+    // snapshot support: walks every (cell term, ids) entry
+    template<typename F>
+    void iterate_cells(F func) const {
+        for(const auto& cell_ids: cell_to_ids) {
+            func(cell_ids.first, cell_ids.second);
+        }
+    }
+
+    // snapshot support: installs a cell's id list wholesale
+    void load_cell(std::string&& term, std::vector<uint32_t>&& ids) {
+        cell_to_ids[std::move(term)] = std::move(ids);
+    }
+};
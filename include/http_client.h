@@ -2,10 +2,23 @@
 
 #include <string>
 #include <map>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <thread>
+#include <vector>
 #include <curl/curl.h>
 #include "http_data.h"
 #include "http_server.h"
 
+// outcome of a transfer driven by the curl-multi event loop
+struct async_transfer_res_t {
+    long status_code = 0;
+    std::string body;
+    std::map<std::string, std::string> headers;
+};
+
 /*
   NOTE: This is a really primitive blocking client meant only for specific Typesense use cases.
 */
@@ -14,6 +27,40 @@ private:
     static std::string api_key;
     static std::string ca_cert_path;
 
+    // shared connection cache + TLS session cache, so inter-node calls reuse
+    // kept-alive connections instead of reconnecting and re-handshaking on
+    // every forward (see init_curl)
+    static CURLSH* curl_share;
+    static std::mutex curl_share_mutexes[CURL_LOCK_DATA_LAST];
+
+    static void curl_share_lock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr);
+
+    static void curl_share_unlock(CURL* handle, curl_lock_data data, void* userptr);
+
+    // a transfer in flight on the curl-multi event loop
+    struct async_transfer_t {
+        CURL* curl = nullptr;
+        curl_slist* headers_list = nullptr;
+        std::string request_body;
+        async_transfer_res_t result;
+        std::promise<async_transfer_res_t> promise;
+        std::function<void(async_transfer_res_t&)> done;
+    };
+
+    // Event loop state: transfers submitted via request_async are handed to a
+    // single loop thread, so any number of concurrent remote calls occupy one
+    // thread between them instead of blocking a pool thread each.
+    static CURLM* curl_multi;
+    static std::thread multi_loop_thread;
+    static std::mutex multi_mutex;
+    static std::vector<async_transfer_t*> pending_transfers;
+    static std::atomic<bool> multi_quit;
+
+    static void run_multi_loop();
+
+    // publishes the outcome of a finished transfer and frees its resources
+    static void finish_transfer(async_transfer_t* transfer, CURLcode code);
+
     HttpClient() = default;
 
     ~HttpClient() = default;
@@ -30,7 +77,8 @@ private:
 
     static size_t curl_req_send_callback(char* buffer, size_t size, size_t nitems, void *userdata);
 
-    static long perform_curl(CURL *curl, std::map<std::string, std::string>& res_headers);
+    static long perform_curl(CURL *curl, std::map<std::string, std::string>& res_headers,
+                             const std::string& api_key_override = "");
 
 public:
     static HttpClient & get_instance() {
@@ -52,6 +100,12 @@ public:
     static long post_response(const std::string & url, const std::string & body, std::string & response,
                               std::map<std::string, std::string>& res_headers, long timeout_ms=4000);
 
+    // POSTs to another cluster with an explicit API key and request timeout;
+    // the other methods always authenticate with this cluster's own key
+    static long post_response_remote(const std::string& url, const std::string& body,
+                                     const std::string& remote_api_key, long timeout_ms,
+                                     std::string& response, std::map<std::string, std::string>& res_headers);
+
     static long post_response_async(const std::string &url, const std::shared_ptr<http_req> request,
                                     const std::shared_ptr<http_res> response,
                                     HttpServer* server);
@@ -63,4 +117,16 @@ public:
                              std::map<std::string, std::string>& res_headers, long timeout_ms=4000);
 
     static void extract_response_headers(CURL* curl, std::map<std::string, std::string> &res_headers);
+
+    // Future-based async API: the transfer is driven by the shared curl-multi
+    // event loop thread started in init(). `done`, when given, runs on the loop
+    // thread just before the future is fulfilled and must not block.
+    // A `timeout_ms` of 0 means no overall transfer timeout (the connect
+    // timeout still applies), matching the blocking methods above.
+    static std::future<async_transfer_res_t> request_async(const std::string& http_method, const std::string& url,
+                                                           const std::string& body, long timeout_ms = 0,
+                                                           std::function<void(async_transfer_res_t&)> done = nullptr);
+
+    // stops the event loop thread, failing the transfers still in flight
+    static void stop_async_loop();
 };
@@ -19,6 +19,8 @@ extern "C" {
 
 using TimePoint = std::chrono::high_resolution_clock::time_point;
 
+struct http_message_dispatcher;
+
 struct h2o_custom_timer_t {
     h2o_timer_t timer;
     void *data;
@@ -173,6 +175,11 @@ struct cached_res_t {
     uint32_t ttl;
     uint64_t hash;
 
+    // (collection name, write epoch) pairs captured when the response was cached;
+    // a hit is served only while every epoch still matches, so writes to a
+    // collection invalidate its cached queries before their TTL lapses
+    std::vector<std::pair<std::string, uint64_t>> collection_write_epochs;
+
     bool operator == (const cached_res_t& res) const {
         return hash == res.hash;
     }
@@ -182,13 +189,15 @@ struct cached_res_t {
     }
 
     void load(uint32_t status_code, const std::string& content_type_header, const std::string& body,
-              const TimePoint created_at, const uint32_t ttl, uint64_t hash) {
+              const TimePoint created_at, const uint32_t ttl, uint64_t hash,
+              const std::vector<std::pair<std::string, uint64_t>>& collection_write_epochs = {}) {
         this->status_code = status_code;
         this->content_type_header = content_type_header;
         this->body = body;
         this->created_at = created_at;
         this->ttl = ttl;
         this->hash = hash;
+        this->collection_write_epochs = collection_write_epochs;
     }
 };
 
@@ -212,6 +221,11 @@ struct http_req {
 
     void* data;
 
+    // dispatcher of the event loop that owns the underlying socket: messages that
+    // touch `_req` must be processed on that loop. Stays null for requests without
+    // a live socket (e.g. replicated writes being replayed from the raft log).
+    http_message_dispatcher* message_dispatcher;
+
     // for deffered processing of async handlers
     h2o_custom_timer_t defer_timer;
 
@@ -227,7 +241,8 @@ struct http_req {
 
     http_req(): _req(nullptr), route_hash(1),
                 first_chunk_aggregate(true), last_chunk_aggregate(false),
-                chunk_len(0), body_index(0), data(nullptr), ready(false), log_index(0), is_http_v1(true) {
+                chunk_len(0), body_index(0), data(nullptr), message_dispatcher(nullptr),
+                ready(false), log_index(0), is_http_v1(true) {
 
         start_ts = std::chrono::duration_cast<std::chrono::microseconds>(
                 std::chrono::system_clock::now().time_since_epoch()).count();
@@ -238,8 +253,8 @@ struct http_req {
             const std::map<std::string, std::string> & params, const std::string& body):
             _req(_req), http_method(http_method), path_without_query(path_without_query), route_hash(route_hash),
             params(params), first_chunk_aggregate(true), last_chunk_aggregate(false),
-            chunk_len(0), body(body), body_index(0), data(nullptr), ready(false),
-            log_index(0) {
+            chunk_len(0), body(body), body_index(0), data(nullptr), message_dispatcher(nullptr),
+            ready(false), log_index(0) {
 
         start_ts = std::chrono::duration_cast<std::chrono::microseconds>(
                 std::chrono::system_clock::now().time_since_epoch()).count();
@@ -433,9 +448,11 @@ struct h2o_custom_res_message_t {
 struct http_message_dispatcher {
     h2o_multithread_queue_t* message_queue;
     h2o_multithread_receiver_t* message_receiver;
+    h2o_loop_t* loop;
     std::map<std::string, bool (*)(void*)> message_handlers;
 
     void init(h2o_loop_t *loop) {
+        this->loop = loop;
         message_queue = h2o_multithread_create_queue(loop);
         message_receiver = new h2o_multithread_receiver_t();
         h2o_multithread_register_receiver(message_queue, message_receiver, on_message);
@@ -11,6 +11,8 @@ extern "C" {
 
 #include <map>
 #include <string>
+#include <vector>
+#include <thread>
 #include <cstdio>
 #include "http_data.h"
 #include "option.h"
@@ -139,6 +141,23 @@ public:
     }
 };
 
+// an additional accept shard: its own event loop, accept context and message
+// dispatcher, fed independently by the kernel via a SO_REUSEPORT listener socket
+struct http_worker_t {
+    h2o_context_t ctx{};
+    h2o_accept_ctx_t accept_ctx{};
+    http_message_dispatcher* message_dispatcher = nullptr;
+    h2o_socket_t* listener_socket = nullptr;
+    std::thread thread;
+};
+
+// posted to a worker loop so that it swaps in a freshly loaded SSL context
+// on its own thread (the refresh timer itself runs only on the main loop)
+struct ssl_ctx_refresh_t {
+    h2o_accept_ctx_t* accept_ctx;
+    SSL_CTX* ssl_ctx;
+};
+
 struct defer_processing_t {
     const std::shared_ptr<http_req> req;
     const std::shared_ptr<http_res> res;
@@ -160,7 +179,13 @@ private:
     h2o_hostconf_t *hostconf;
     h2o_socket_t* listener_socket;
 
-    static const size_t ACTIVE_STREAM_WINDOW_SIZE = 196605;
+    // HTTP/2 stream window, which doubles as the write aggregation threshold:
+    // an async write handler fires — and replicates one raft entry — per
+    // window of buffered request body, so the window size bounds how many
+    // import chunks are coalesced into a single consensus round trip.
+    // (2 MB ≈ 10x fewer raft entries per import than the previous 192 KB
+    // window, at 2 MB of buffering per in-flight streaming request.)
+    static const size_t ACTIVE_STREAM_WINDOW_SIZE = 2 * 1024 * 1024;
     static const size_t REQ_TIMEOUT_MS = 60000;
 
     const uint64_t SSL_REFRESH_INTERVAL_MS;
@@ -170,6 +195,12 @@ private:
 
     http_message_dispatcher* message_dispatcher;
 
+    // number of event loops accepting connections: the main loop plus
+    // (num_http_loops - 1) worker loops sharded via SO_REUSEPORT
+    const size_t num_http_loops;
+
+    std::vector<http_worker_t*> http_workers;
+
     ReplicationState* replication_state;
 
     std::atomic<bool> exit_loop;
@@ -209,8 +240,16 @@ private:
 
     static void on_metrics_refresh_timeout(h2o_timer_t *entry);
 
+    static bool on_ssl_ctx_refresh_message(void *data);
+
+    int bind_listener_fd(bool reuse_port);
+
     int create_listener();
 
+    int start_http_workers();
+
+    http_message_dispatcher* dispatcher_for_context(h2o_context_t* context) const;
+
     h2o_pathconf_t *register_handler(h2o_hostconf_t *hostconf, const char *path,
                                      int (*on_req)(h2o_handler_t *, h2o_req_t *));
 
@@ -234,12 +273,16 @@ public:
                const std::string & ssl_cert_path,
                const std::string & ssl_cert_key_path,
                const uint64_t ssl_refresh_interval_ms,
-               bool cors_enabled, ThreadPool* thread_pool);
+               bool cors_enabled, size_t num_http_loops, ThreadPool* thread_pool);
 
     ~HttpServer();
 
     http_message_dispatcher* get_message_dispatcher() const;
 
+    // dispatcher of the loop that owns the request's socket (falls back to the
+    // main loop for requests without one, e.g. replayed writes)
+    http_message_dispatcher* get_message_dispatcher(const std::shared_ptr<http_req>& req) const;
+
     ReplicationState* get_replication_state() const;
 
     bool is_alive() const;
@@ -296,6 +339,7 @@ public:
     static constexpr const char* STREAM_RESPONSE_MESSAGE = "STREAM_RESPONSE";
     static constexpr const char* REQUEST_PROCEED_MESSAGE = "REQUEST_PROCEED";
     static constexpr const char* DEFER_PROCESSING_MESSAGE = "DEFER_PROCESSING";
+    static constexpr const char* SSL_CTX_REFRESH_MESSAGE = "SSL_CTX_REFRESH";
 
     static int process_request(const std::shared_ptr<http_req>& request, const std::shared_ptr<http_res>& response, route_path *rpath,
                                const h2o_custom_req_handler_t *req_handler);
@@ -311,4 +355,16 @@ public:
     void persist_applying_index();
 
     int64_t get_num_queued_writes();
+
+    bool is_write_backpressured();
+
+    int64_t get_write_drain_rate();
+
+    int64_t get_applied_lag();
+
+    int64_t get_read_staleness_ms();
+
+    int64_t get_last_snapshot_duration_ms();
+
+    int64_t get_last_snapshot_bytes_written();
 };
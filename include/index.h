@@ -6,6 +6,8 @@
 #include <mutex>
 #include <shared_mutex>
 #include <condition_variable>
+#include <atomic>
+#include <list>
 #include <art.h>
 #include <number.h>
 #include <sparsepp.h>
@@ -17,14 +19,21 @@
 #include <set>
 #include "string_utils.h"
 #include "num_tree.h"
+#include "doc_values.h"
+#include "geo_index.h"
+#include "bool_index.h"
+#include "facet_column.h"
+#include "facet_value_index.h"
+#include "facet_value_store.h"
+#include "token_interner.h"
+#include "arena.h"
 #include "magic_enum.hpp"
 #include "match_score.h"
 #include "posting_list.h"
 #include "threadpool.h"
 
-static constexpr size_t ARRAY_FACET_DIM = 4;
-using facet_map_t = spp::sparse_hash_map<uint32_t, facet_hash_values_t>;
-using array_mapped_facet_t = std::array<facet_map_t*, ARRAY_FACET_DIM>;
+class index_snapshot_writer_t;
+class index_snapshot_reader_t;
 
 struct token_t {
     size_t position;
@@ -251,6 +260,22 @@ struct override_t {
     }
 };
 
+// per-document KV lists built during multi-field aggregation, backed by the
+// per-search arena
+using arena_kv_list_t = std::vector<KV*, arena_allocator<KV*>>;
+
+// wall-clock time spent in the major stages of a single search, reported by the
+// slow query log (see Collection::search). Only the orchestrating thread updates
+// these, so parallel sub-stages are attributed to their enclosing stage.
+struct search_stage_timings_t {
+    uint64_t tokenize_us = 0;     // query parsing + synonym expansion
+    uint64_t filter_us = 0;       // filter clause evaluation (incl. override filters)
+    uint64_t candidates_us = 0;   // token candidate enumeration + per-field matching
+    uint64_t score_us = 0;        // cross-field score aggregation
+    uint64_t facet_us = 0;        // facet counting
+    uint64_t hydrate_us = 0;      // document fetch + highlighting
+};
+
 struct search_args {
     std::vector<query_tokens_t> field_query_tokens;
     std::vector<search_field_t> search_fields;
@@ -279,6 +304,8 @@ struct search_args {
     size_t search_cutoff_ms;
     size_t min_len_1typo;
     size_t min_len_2typo;
+    size_t facet_sample_percent;
+    size_t facet_sample_threshold;
 
     spp::sparse_hash_set<uint64_t> groups_processed;
     std::vector<std::vector<art_leaf*>> searched_queries;
@@ -287,6 +314,12 @@ struct search_args {
     std::vector<std::vector<KV*>> raw_result_kvs;
     std::vector<std::vector<KV*>> override_result_kvs;
 
+    // scratch for result aggregation (e.g. KV::query_indices), released
+    // wholesale when the search ends
+    arena_t kv_arena;
+
+    search_stage_timings_t timings;
+
     search_args(std::vector<query_tokens_t> field_query_tokens,
                 std::vector<search_field_t> search_fields, std::vector<filter> filters,
                 std::vector<facet>& facets,
@@ -303,7 +336,9 @@ struct search_args {
                 const std::vector<const override_t*>& dynamic_overrides,
                 size_t search_cutoff_ms,
                 size_t min_len_1typo,
-                size_t min_len_2typo):
+                size_t min_len_2typo,
+                size_t facet_sample_percent,
+                size_t facet_sample_threshold):
             field_query_tokens(field_query_tokens),
             search_fields(search_fields), filters(filters), facets(facets),
             included_ids(included_ids), excluded_ids(excluded_ids), sort_fields_std(sort_fields_std),
@@ -314,7 +349,8 @@ struct search_args {
             prioritize_exact_match(prioritize_exact_match), all_result_ids_len(0),
             exhaustive_search(exhaustive_search), concurrency(concurrency),
             filter_overrides(dynamic_overrides), search_cutoff_ms(search_cutoff_ms),
-            min_len_1typo(min_len_1typo), min_len_2typo(min_len_2typo) {
+            min_len_1typo(min_len_1typo), min_len_2typo(min_len_2typo),
+            facet_sample_percent(facet_sample_percent), facet_sample_threshold(facet_sample_threshold) {
 
         const size_t topster_size = std::max((size_t)1, max_hits);  // needs to be atleast 1 since scoring is mandatory
         topster = new Topster(topster_size, group_limit);
@@ -344,6 +380,12 @@ enum class DIRTY_VALUES {
 struct offsets_facet_hashes_t {
     std::unordered_map<std::string, std::vector<uint32_t>> offsets;
     std::vector<uint64_t> facet_hashes;
+
+    // raw text of each facet value, parallel to `facet_hashes`
+    std::vector<std::string> facet_values;
+
+    // normalized tokens of each facet value, parallel to `facet_hashes`
+    std::vector<std::vector<std::string>> facet_value_tokens;
 };
 
 struct index_record {
@@ -351,6 +393,12 @@ struct index_record {
     uint32_t seq_id;
 
     nlohmann::json doc;                 // actual document sent in request (could be partial)
+
+    // original request body, kept only for create operations whose parsed doc
+    // is byte-equivalent to it: the on-disk write then stores this string
+    // verbatim and skips re-serializing the DOM. Cleared if validation
+    // mutates the document.
+    std::string raw_doc;
     nlohmann::json old_doc;             // previously stored *full* document from disk
     nlohmann::json new_doc;             // new *full* document to be stored into disk
     nlohmann::json del_doc;             // document containing the fields that should be deleted
@@ -358,6 +406,16 @@ struct index_record {
     index_operation_t operation;
     bool is_update;
 
+    // set when an update only replaces scalar numeric/bool values: such records
+    // are patched in place (num_tree / bool bitmaps / sort doc-values) and skip
+    // the generic remove + per-field reindex machinery
+    bool numeric_only_update = false;
+
+    // client-supplied indexing artifacts extracted from the reserved
+    // `$field_index` key of the request document, null when absent
+    // (see Index::load_precomputed_field_index for the format)
+    nlohmann::json precomputed_index;
+
     // pre-processed data primed for indexing
     std::unordered_map<std::string, offsets_facet_hashes_t> field_index;
     int64_t points;
@@ -398,6 +456,10 @@ private:
 
     ThreadPool* thread_pool;
 
+    // pool for import/indexing fan-outs: kept separate from the search pool
+    // so that queries don't wait behind write batches
+    ThreadPool* indexing_thread_pool;
+
     size_t num_documents;
 
     std::unordered_map<std::string, field> search_schema;
@@ -406,17 +468,39 @@ private:
 
     std::unordered_map<std::string, field> sort_schema;
 
+    // one token dictionary shared by the trees of every string field, so a
+    // token's bytes are stored once no matter how many fields contain it
+    token_interner_t token_interner;
+
     spp::sparse_hash_map<std::string, art_tree*> search_index;
 
     spp::sparse_hash_map<std::string, num_tree_t*> numerical_index;
 
-    spp::sparse_hash_map<std::string, spp::sparse_hash_map<std::string, std::vector<uint32_t>>*> geopoint_index;
+    // bool_field => two-bitmap (true / false) id sets
+    spp::sparse_hash_map<std::string, bool_index_t*> bool_index;
+
+    // materialized_field => (value => ready-made sorted id list): opt-in via the
+    // `materialize` field annotation, turns equality filters on low-cardinality
+    // fields into a single lookup instead of a tree search + merge
+    spp::sparse_hash_map<std::string, spp::sparse_hash_map<int64_t, std::vector<uint32_t>>*> materialized_filter_index;
 
-    // facet_field => (seq_id => values)
-    spp::sparse_hash_map<std::string, array_mapped_facet_t> facet_index_v3;
+    // geo_field => (cell term => sorted ids) at multiple cell precisions
+    spp::sparse_hash_map<std::string, geo_index_t*> geopoint_index;
 
-    // sort_field => (seq_id => value)
-    spp::sparse_hash_map<std::string, spp::sparse_hash_map<uint32_t, int64_t>*> sort_index;
+    // facet_field => columnar (seq_id => hash list) store scanned by do_facets()
+    spp::sparse_hash_map<std::string, facet_column_t*> facet_index_v3;
+
+    // facet_field => ART over normalized facet value suffixes, resolves
+    // facet_query by prefix lookup instead of scanning candidate documents
+    spp::sparse_hash_map<std::string, facet_value_index_t*> facet_value_index;
+
+    // facet_field => one interned copy of each distinct value (hash => string
+    // with a refcount), so facet responses resolve their top values without
+    // fetching representative documents from the store
+    spp::sparse_hash_map<std::string, facet_value_store_t*> facet_value_store;
+
+    // sort_field => columnar (seq_id => value) store read by score_results()
+    spp::sparse_hash_map<std::string, doc_values_t*> sort_index;
 
     // geo_array_field => (seq_id => values) used for exact filtering of geo array records
     spp::sparse_hash_map<std::string, spp::sparse_hash_map<uint32_t, int64_t*>*> geo_array_index;
@@ -424,6 +508,58 @@ private:
     // this is used for wildcard queries
     sorted_array seq_ids;
 
+    // lazily materialized uncompressed view of `seq_ids`, shared zero-copy by
+    // wildcard searches and NOT filters; rebuilt only when `seq_ids_version`
+    // moves, so back-to-back browse queries don't uncompress per request
+    mutable std::mutex live_ids_mutex;
+    mutable std::vector<uint32_t> live_ids_view;
+    mutable uint64_t live_ids_view_version = 0;
+
+    // bumped whenever `seq_ids` is mutated (insert / remove / snapshot load)
+    std::atomic<uint64_t> seq_ids_version{1};
+
+    // LRU of normalized filter expression => compressed id set: storefront-style
+    // traffic repeats a handful of filter_by expressions on almost every query.
+    // Entries carry the write watermark they were computed at, so any write to
+    // the index invalidates them wholesale.
+    static const size_t FILTER_CACHE_MAX_ENTRIES = 32;
+
+    // filter clauses are farmed out to the thread pool only when the index is
+    // large enough for per-clause work to dwarf the fan-out overhead
+    static const size_t PARALLEL_FILTER_MIN_DOCS = 50000;
+
+    // number of counters kept per facet when approximate counting is requested:
+    // values more frequent than (results / capacity) are guaranteed to survive
+    static const size_t APPROX_FACET_CAPACITY = 1000;
+
+    // facet value type-ahead stops after this many matching values
+    static const size_t FACET_VALUE_SEARCH_MAX_KEYS = 100;
+
+    struct filter_cache_entry_t {
+        sorted_array ids;
+        uint64_t watermark;
+        std::list<std::string>::iterator lru_it;
+    };
+
+    mutable std::mutex filter_cache_mutex;
+    mutable std::list<std::string> filter_cache_lru;  // front = most recently used
+    mutable spp::sparse_hash_map<std::string, filter_cache_entry_t*> filter_cache;
+
+    // bumped on every write batch / removal
+    mutable std::atomic<uint64_t> write_watermark{0};
+
+    struct facet_cache_entry_t {
+        spp::sparse_hash_map<uint64_t, facet_count_t> result_map;
+        facet_stats_t stats;
+        uint64_t watermark = 0;
+    };
+
+    // field_name => whole-index facet counts, valid at `watermark`: queries
+    // whose result set spans every document (unfiltered wildcards) reuse them
+    // until the next write
+    mutable std::mutex facet_cache_mutex;
+    mutable spp::sparse_hash_map<std::string, facet_cache_entry_t> facet_cache;
+
     std::vector<char> symbols_to_index;
 
     std::vector<char> token_separators;
@@ -432,9 +568,9 @@ private:
 
     // used as sentinels
 
-    static spp::sparse_hash_map<uint32_t, int64_t> text_match_sentinel_value;
-    static spp::sparse_hash_map<uint32_t, int64_t> seq_id_sentinel_value;
-    static spp::sparse_hash_map<uint32_t, int64_t> geo_sentinel_value;
+    static doc_values_t text_match_sentinel_value;
+    static doc_values_t seq_id_sentinel_value;
+    static doc_values_t geo_sentinel_value;
 
     // Internal utility functions
 
@@ -445,12 +581,20 @@ private:
                                        uint32_t& token_bits,
                                        uint64& qhash);
 
+    // fills `combination_order` with up to `combination_limit` combination indices
+    // of the candidate cartesian product, best first: lowest total typo/prefix
+    // cost, then highest token document frequency
+    static void beam_candidate_order(const std::vector<token_candidates>& token_candidates_vec,
+                                     long long combination_limit,
+                                     std::vector<long long>& combination_order);
+
     void log_leaves(int cost, const std::string &token, const std::vector<art_leaf *> &leaves) const;
 
     void do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
                    const std::vector<facet_info_t>& facet_infos,
                    size_t group_limit, const std::vector<std::string>& group_by_fields,
-                   const uint32_t* result_ids, size_t results_size) const;
+                   const uint32_t* result_ids, size_t results_size,
+                   size_t sample_stride = 1) const;
 
     bool static_filter_query_eval(const override_t* override, std::vector<std::string>& tokens,
                                   std::vector<filter>& filters) const;
@@ -472,6 +616,9 @@ private:
 
     static void aggregate_topster(Topster* agg_topster, Topster* index_topster);
 
+    static void aggregate_facets(std::vector<facet>& agg_facets, std::vector<facet>& batch_facets,
+                                 size_t group_limit);
+
     void search_field(const uint8_t & field_id,
                       std::vector<token_t>& query_tokens,
                       std::vector<token_t>& search_tokens,
@@ -482,6 +629,7 @@ private:
                       const uint32_t *filter_ids, size_t filter_ids_length,
                       const std::vector<uint32_t>& curated_ids,
                       const std::vector<sort_by> & sort_fields,
+                      const std::string& default_sorting_field,
                       int num_typos, std::vector<std::vector<art_leaf*>> & searched_queries,
                       Topster* topster, spp::sparse_hash_set<uint64_t>& groups_processed,
                       uint32_t** all_result_ids, size_t & all_result_ids_len,
@@ -503,7 +651,9 @@ private:
                            const uint32_t* filter_ids, size_t filter_ids_length,
                            const uint32_t* exclude_token_ids, size_t exclude_token_ids_size,
                            const std::vector<uint32_t>& curated_ids,
-                           const std::vector<sort_by> & sort_fields, std::vector<token_candidates> & token_to_candidates,
+                           const std::vector<sort_by> & sort_fields,
+                           const std::string& default_sorting_field,
+                           std::vector<token_candidates> & token_to_candidates,
                            std::vector<std::vector<art_leaf*>> & searched_queries,
                            Topster* topster, spp::sparse_hash_set<uint64_t>& groups_processed,
                            uint32_t** all_result_ids,
@@ -521,6 +671,29 @@ private:
     void do_filtering(uint32_t*& filter_ids, uint32_t& filter_ids_length, const std::vector<filter>& filters,
                       const bool enable_short_circuit) const;
 
+    // evaluates a single filter clause; returns false when the clause targets a field
+    // that has no search index. `prior_ids` is consumed only by string `!=` clauses,
+    // which subtract from the result accumulated so far.
+    bool do_filtering_clause(const filter& a_filter, uint32_t* prior_ids, uint32_t prior_ids_length,
+                             uint32_t*& result_ids, size_t& result_ids_len) const;
+
+    void do_filtering_parallel(uint32_t*& filter_ids, uint32_t& filter_ids_length,
+                               const std::vector<filter>& filters) const;
+
+    // order-independent identity of a filter conjunction ("" when not cacheable)
+    static std::string get_filter_cache_key(const std::vector<filter>& filters, bool enable_short_circuit);
+
+    bool filter_cache_get(const std::string& cache_key, uint32_t*& filter_ids, uint32_t& filter_ids_length) const;
+
+    void filter_cache_put(const std::string& cache_key, const uint32_t* filter_ids, uint32_t filter_ids_length) const;
+
+    void materialized_filter_insert(const std::string& field_name, int64_t value, uint32_t seq_id);
+
+    void materialized_filter_remove(const std::string& field_name, int64_t value, uint32_t seq_id);
+
+    void materialized_filter_fetch(const std::string& field_name, int64_t value,
+                                   uint32_t** ids, size_t& ids_len) const;
+
     void insert_doc(const int64_t score, art_tree *t, uint32_t seq_id,
                     const std::unordered_map<std::string, std::vector<uint32_t>> &token_to_offsets) const;
 
@@ -528,7 +701,9 @@ private:
                                             const std::vector<char>& symbols_to_index,
                                             const std::vector<char>& token_separators,
                                             std::unordered_map<std::string, std::vector<uint32_t>>& token_to_offsets,
-                                            std::vector<uint64_t>& facet_hashes);
+                                            std::vector<uint64_t>& facet_hashes,
+                                            std::vector<std::string>& facet_values,
+                                            std::vector<std::vector<std::string>>& facet_value_tokens);
 
     void index_strings_field(const int64_t score, art_tree *t,
                             uint32_t seq_id, bool is_facet, const field & a_field,
@@ -540,7 +715,9 @@ private:
                                            const std::vector<char>& symbols_to_index,
                                            const std::vector<char>& token_separators,
                                            std::unordered_map<std::string, std::vector<uint32_t>>& token_to_offsets,
-                                           std::vector<uint64_t>& facet_hashes);
+                                           std::vector<uint64_t>& facet_hashes,
+                                           std::vector<std::string>& facet_values,
+                                           std::vector<std::vector<std::string>>& facet_value_tokens);
 
     void collate_included_ids(const std::vector<std::string>& q_included_tokens,
                               const std::string & field, const uint8_t field_id,
@@ -595,12 +772,17 @@ public:
     // in the query that have the least individual hits one by one until enough results are found.
     static const int DROP_TOKENS_THRESHOLD = 1;
 
+    // reserved document key carrying client-precomputed indexing artifacts
+    // (stripped from the document before validation / storage)
+    static constexpr const char* PRECOMPUTED_FIELD_INDEX_KEY = "$field_index";
+
     Index() = delete;
 
     Index(const std::string& name,
           const uint32_t collection_id,
           const Store* store,
           ThreadPool* thread_pool,
+          ThreadPool* indexing_thread_pool,
           const std::unordered_map<std::string, field>& search_schema,
           const std::map<std::string, field>& facet_schema,
           const std::unordered_map<std::string, field>& sort_schema,
@@ -608,20 +790,27 @@ public:
 
     ~Index();
 
+    // the searched query leaves remain in use after `run_search` returns (e.g.
+    // for highlighting), so the caller holds the read lock for the full request
+    std::shared_lock<std::shared_mutex> get_search_lock() const {
+        return std::shared_lock<std::shared_mutex>(mutex);
+    }
+
     // reference: https://stackoverflow.com/a/27952689/131050
     static uint64_t hash_combine(uint64_t combined, uint64_t hash) {
         combined ^= hash + 0x517cc1b727220a95 + (combined << 6) + (combined >> 2);
         return combined;
     }
 
-    static void concat_topster_ids(Topster* topster, spp::sparse_hash_map<uint64_t, std::vector<KV*>>& topster_ids);
+    static void concat_topster_ids(Topster* topster, spp::sparse_hash_map<uint64_t, arena_kv_list_t>& topster_ids,
+                                   arena_t& kv_arena);
 
     void score_results(const std::vector<sort_by> &sort_fields, const uint16_t &query_index, const uint8_t &field_id,
                        bool field_is_array, const uint32_t total_cost,
                        Topster *topster, const std::vector<art_leaf *> &query_suggestion,
                        spp::sparse_hash_set<uint64_t> &groups_processed,
                        const uint32_t seq_id, const int sort_order[3],
-                       std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3> field_values,
+                       std::array<doc_values_t*, 3> field_values,
                        const std::vector<size_t>& geopoint_indices,
                        const size_t group_limit,
                        const std::vector<std::string> &group_by_fields, uint32_t token_bits,
@@ -635,6 +824,12 @@ public:
 
     const spp::sparse_hash_map<std::string, num_tree_t*>& _get_numerical_index() const;
 
+    // returns nullptr when no live document holds a value with this hash
+    const std::string* get_facet_value(const std::string& field_name, uint64_t fhash) const;
+
+    // k-way merges per-worker topsters into `agg_topster`, moving KV entries
+    static void aggregate_topsters(Topster* agg_topster, const std::vector<Topster*>& batch_topsters);
+
     static int get_bounded_typo_cost(const size_t max_cost, const size_t token_len,
                                      size_t min_len_1typo, size_t min_len_2typo);
 
@@ -648,9 +843,27 @@ public:
                                              const std::vector<char>& local_token_separators,
                                              const std::vector<char>& local_symbols_to_index);
 
+    // Loads client-precomputed indexing artifacts into `record.field_index`, skipping
+    // server-side tokenization during bulk imports. The reserved `$field_index` document
+    // key maps each indexed field name to `{"offsets": {token: [uint32...]},
+    // "facet_hashes": [uint64...], "facet_values": [str...], "facet_value_tokens": [[str...]...]}`,
+    // mirroring what compute_token_offsets_facets() produces for that field. Only the
+    // structure is validated: the tokens and offsets themselves are trusted, so the
+    // client must tokenize with the same separators/symbols configured on the collection
+    // and must cover every string / faceted field it wants indexed — fields missing
+    // from the artifacts are not tokenized server-side.
+    static Option<bool> load_precomputed_field_index(index_record& record,
+                                                     const std::unordered_map<std::string, field>& search_schema,
+                                                     const std::map<std::string, field>& facet_schema);
+
     static void scrub_reindex_doc(const std::unordered_map<std::string, field>& search_schema,
                                   nlohmann::json& update_doc, nlohmann::json& del_doc, const nlohmann::json& old_doc);
 
+    // checks whether an update (post-scrub) only replaces scalar numeric/bool values,
+    // making it eligible for the in-place patch path
+    static bool is_numeric_only_update(const std::unordered_map<std::string, field>& search_schema,
+                                       const index_record& record);
+
     static void tokenize_string_field(const nlohmann::json& document,
                                       const field& search_field, std::vector<std::string>& tokens,
                                       const std::string& locale);
@@ -684,10 +897,29 @@ public:
                 size_t concurrency,
                 size_t search_cutoff_ms,
                 size_t min_len_1typo,
-                size_t min_len_2typo) const;
+                size_t min_len_2typo,
+                size_t facet_sample_percent,
+                size_t facet_sample_threshold,
+                arena_t& kv_arena,
+                search_stage_timings_t& timings) const;
 
     Option<uint32_t> remove(const uint32_t seq_id, const nlohmann::json & document, const bool is_update);
 
+    // requires unique lock to be held by the caller. For updates, `new_field_index`
+    // carries the tokens of the incoming document: tokens present in both the old and
+    // new values are left alone, since the subsequent posting upsert replaces their
+    // offsets in place anyway.
+    Option<uint32_t> remove_unlocked(const uint32_t seq_id, const nlohmann::json & document, const bool is_update,
+                                     const std::unordered_map<std::string, offsets_facet_hashes_t>* new_field_index = nullptr);
+
+    // requires unique lock to be held by the caller: applies a numeric-only update
+    // by swapping the changed values directly in the numerical indices
+    void patch_numerical_fields_in_place(index_record& record);
+
+    // merges adjacent under-filled posting list blocks left behind by deletes
+    // across all search fields, and returns the number of blocks reclaimed
+    size_t compact_posting_lists();
+
     static void validate_and_preprocess(Index *index, std::vector<index_record>& iter_batch,
                                           const size_t batch_start_index, const size_t batch_size,
                                           const std::string & default_sorting_field,
@@ -726,13 +958,16 @@ public:
 
     // the following methods are not synchronized because their parent calls are synchronized or they are const/static
 
+    // `doc_modified`, when given, is set if validation mutated the document
+    // (coercions, dropped fields), i.e. it no longer matches the raw request body
     static Option<uint32_t> validate_index_in_memory(nlohmann::json &document, uint32_t seq_id,
                                                      const std::string & default_sorting_field,
                                                      const std::unordered_map<std::string, field> & search_schema,
                                                      const std::map<std::string, field> & facet_schema,
                                                      const index_operation_t op,
                                                      const std::string& fallback_field_type,
-                                                     const DIRTY_VALUES& dirty_values);
+                                                     const DIRTY_VALUES& dirty_values,
+                                                     bool* doc_modified = nullptr);
 
     void search_wildcard(const std::vector<std::string>& qtokens, const std::vector<filter>& filters,
                          const std::map<size_t, std::map<size_t, uint32_t>>& included_ids_map,
@@ -747,11 +982,18 @@ public:
 
     void curate_filtered_ids(const std::vector<filter>& filters, const std::set<uint32_t>& curated_ids,
                              const uint32_t* exclude_token_ids, size_t exclude_token_ids_size, uint32_t*& filter_ids,
-                             uint32_t& filter_ids_length, const std::vector<uint32_t>& curated_ids_sorted) const;
+                             uint32_t& filter_ids_length, bool& filter_ids_owned,
+                             const std::vector<uint32_t>& curated_ids_sorted) const;
+
+    // Returns the shared uncompressed view of `seq_ids` along with its size.
+    // The returned pointer is borrowed: it stays valid for the duration of the
+    // caller's search lock (writers mutate `seq_ids` under the exclusive lock)
+    // and must not be freed or written through.
+    uint32_t* get_live_ids(size_t& num_ids) const;
 
     void populate_sort_mapping(int* sort_order, std::vector<size_t>& geopoint_indices,
                                const std::vector<sort_by>& sort_fields_std,
-                               std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3>& field_values) const;
+                               std::array<doc_values_t*, 3>& field_values) const;
 
     static void remove_matched_tokens(std::vector<std::string>& tokens, const std::set<std::string>& rule_token_set) ;
 
@@ -761,6 +1003,23 @@ public:
                              std::vector<facet_info_t>& facet_infos) const;
 
     size_t num_seq_ids() const;
+
+    // Fills `stats` with approximate per-structure byte counts (ART arenas,
+    // posting lists, numerical / facet / sort indexes etc.), surfaced by the
+    // collection stats end-point for capacity planning.
+    void get_memory_stats(nlohmann::json& stats) const;
+
+    // Dumps every index structure into `writer` (see index_snapshot.h for the
+    // file framing). The caller must have quiesced writes; non-const because
+    // dumping walks structures through their mutating iteration APIs.
+    void serialize_index_state(index_snapshot_writer_t& writer);
+
+    // Rebuilds the index structures from a snapshot produced by
+    // serialize_index_state() against the same schema. Must be called on a
+    // freshly constructed Index that has never indexed a document; returns
+    // false when the stream is malformed (caller falls back to a replay,
+    // discarding this partially-mutated instance).
+    bool load_index_state(index_snapshot_reader_t& reader);
 };
 
 template<class T>
@@ -770,6 +1029,11 @@ void Index::iterate_and_index_numerical_field(std::vector<index_record>& iter_ba
             continue;
         }
 
+        if(record.numeric_only_update) {
+            // already applied via the in-place patch path
+            continue;
+        }
+
         const auto& document = record.doc;
         const auto seq_id = record.seq_id;
 
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*
+ * Minimal binary framing for the persisted index snapshot: length-prefixed
+ * strings and fixed-width little-endian integers, with a running FNV-1a hash
+ * over every byte written. The hash is appended as the final 8 bytes of the
+ * file and verified before a snapshot is loaded, so a torn or corrupted file
+ * degrades to the regular replay-from-store path instead of a broken index.
+ *
+ * Snapshot files are node-local (written and read by the same machine), so
+ * integers are stored in host byte order.
+ */
+class index_snapshot_writer_t {
+private:
+    FILE* fp = nullptr;
+    uint64_t checksum = FNV_SEED;
+    bool failed = false;
+
+public:
+    static constexpr uint64_t FNV_SEED = 0xcbf29ce484222325ULL;
+    static constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+    static constexpr uint32_t SNAPSHOT_MAGIC = 0x58495354;    // "TSIX"
+    static constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+    explicit index_snapshot_writer_t(const std::string& path) {
+        fp = std::fopen(path.c_str(), "wb");
+        failed = (fp == nullptr);
+    }
+
+    ~index_snapshot_writer_t() {
+        if(fp != nullptr) {
+            std::fclose(fp);
+        }
+    }
+
+    index_snapshot_writer_t(const index_snapshot_writer_t&) = delete;
+    index_snapshot_writer_t& operator=(const index_snapshot_writer_t&) = delete;
+
+    bool ok() const {
+        return !failed;
+    }
+
+    void write_bytes(const void* data, size_t len) {
+        if(failed || len == 0) {
+            return;
+        }
+
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for(size_t i = 0; i < len; i++) {
+            checksum = (checksum ^ bytes[i]) * FNV_PRIME;
+        }
+
+        failed = (std::fwrite(data, 1, len, fp) != len);
+    }
+
+    void write_u32(uint32_t value) {
+        write_bytes(&value, sizeof(value));
+    }
+
+    void write_u64(uint64_t value) {
+        write_bytes(&value, sizeof(value));
+    }
+
+    void write_i64(int64_t value) {
+        write_bytes(&value, sizeof(value));
+    }
+
+    void write_str(const std::string& value) {
+        write_u32(uint32_t(value.size()));
+        write_bytes(value.data(), value.size());
+    }
+
+    void write_u32s(const uint32_t* values, size_t len) {
+        write_bytes(values, len * sizeof(uint32_t));
+    }
+
+    // appends the checksum trailer and flushes; the writer cannot be used afterwards
+    bool finish() {
+        if(failed) {
+            return false;
+        }
+
+        const uint64_t trailer = checksum;
+        failed = (std::fwrite(&trailer, 1, sizeof(trailer), fp) != sizeof(trailer)) ||
+                 (std::fflush(fp) != 0);
+
+        std::fclose(fp);
+        fp = nullptr;
+
+        return !failed;
+    }
+};
+
+class index_snapshot_reader_t {
+private:
+    FILE* fp = nullptr;
+    uint64_t checksum = index_snapshot_writer_t::FNV_SEED;
+    bool failed = false;
+
+public:
+
+    explicit index_snapshot_reader_t(const std::string& path) {
+        fp = std::fopen(path.c_str(), "rb");
+        failed = (fp == nullptr);
+    }
+
+    ~index_snapshot_reader_t() {
+        if(fp != nullptr) {
+            std::fclose(fp);
+        }
+    }
+
+    index_snapshot_reader_t(const index_snapshot_reader_t&) = delete;
+    index_snapshot_reader_t& operator=(const index_snapshot_reader_t&) = delete;
+
+    bool ok() const {
+        return !failed;
+    }
+
+    void read_bytes(void* data, size_t len) {
+        if(failed || len == 0) {
+            return;
+        }
+
+        if(std::fread(data, 1, len, fp) != len) {
+            failed = true;
+            return;
+        }
+
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for(size_t i = 0; i < len; i++) {
+            checksum = (checksum ^ bytes[i]) * index_snapshot_writer_t::FNV_PRIME;
+        }
+    }
+
+    uint32_t read_u32() {
+        uint32_t value = 0;
+        read_bytes(&value, sizeof(value));
+        return value;
+    }
+
+    uint64_t read_u64() {
+        uint64_t value = 0;
+        read_bytes(&value, sizeof(value));
+        return value;
+    }
+
+    int64_t read_i64() {
+        int64_t value = 0;
+        read_bytes(&value, sizeof(value));
+        return value;
+    }
+
+    std::string read_str() {
+        const uint32_t len = read_u32();
+        if(failed) {
+            return "";
+        }
+
+        std::string value(len, '\0');
+        read_bytes(&value[0], len);
+        return value;
+    }
+
+    void read_u32s(uint32_t* values, size_t len) {
+        read_bytes(values, len * sizeof(uint32_t));
+    }
+
+    // verifies that exactly the checksum trailer remains and that it matches
+    // the bytes read so far
+    bool finish() {
+        if(failed) {
+            return false;
+        }
+
+        uint64_t trailer = 0;
+        if(std::fread(&trailer, 1, sizeof(trailer), fp) != sizeof(trailer)) {
+            return false;
+        }
+
+        unsigned char extra;
+        if(std::fread(&extra, 1, 1, fp) != 0) {
+            // trailing garbage after the checksum
+            return false;
+        }
+
+        return trailer == checksum;
+    }
+
+    // streams the entire file once and verifies the checksum trailer, without
+    // interpreting any of the contents: called before a snapshot is applied so
+    // that a corrupted file never leaves the index partially loaded
+    static bool verify_file(const std::string& path) {
+        FILE* vfp = std::fopen(path.c_str(), "rb");
+        if(vfp == nullptr) {
+            return false;
+        }
+
+        uint64_t hash = index_snapshot_writer_t::FNV_SEED;
+        std::vector<unsigned char> buffer(65536);
+
+        // the last 8 bytes read at any point could be the trailer, so hashing
+        // lags one window behind the read position
+        std::vector<unsigned char> pending;
+        size_t read_len;
+
+        while((read_len = std::fread(buffer.data(), 1, buffer.size(), vfp)) != 0) {
+            pending.insert(pending.end(), buffer.begin(), buffer.begin() + read_len);
+
+            if(pending.size() > sizeof(uint64_t)) {
+                const size_t hashable = pending.size() - sizeof(uint64_t);
+                for(size_t i = 0; i < hashable; i++) {
+                    hash = (hash ^ pending[i]) * index_snapshot_writer_t::FNV_PRIME;
+                }
+
+                pending.erase(pending.begin(), pending.begin() + hashable);
+            }
+        }
+
+        const bool read_error = (std::ferror(vfp) != 0);
+        std::fclose(vfp);
+
+        if(read_error || pending.size() != sizeof(uint64_t)) {
+            return false;
+        }
+
+        uint64_t trailer = 0;
+        memcpy(&trailer, pending.data(), sizeof(trailer));
+
+        return trailer == hash;
+    }
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Bit-parallel simulation of a Levenshtein automaton, precompiled once per
+ * query token and stepped with a handful of word operations per indexed
+ * character. Used by `art_fuzzy_search()` to prune trie subtrees that cannot
+ * produce a match within `max_cost` edits, instead of carrying a full
+ * dynamic-programming row through every branch.
+ *
+ * Bit `j` of row `e` means: `j` characters of the query term can be consumed
+ * with exactly `e` edits after reading the key characters streamed so far.
+ * Rows beyond `max_rows` are not tracked, so costs larger than the budget
+ * collapse to "dead" and the branch is abandoned.
+ *
+ * Transpositions are tracked with one extra register per row so that costs
+ * agree with the optimal string alignment distance computed by the DP
+ * fallback (`levenshtein_dist()` in art.cpp).
+ */
+class lev_automaton {
+public:
+    // (term_len + 1) state bits must fit in a single word
+    static const int MAX_TERM_LEN = 63;
+
+    // rows 0..max_cost are needed for acceptance, plus one boundary row
+    // since descent is allowed to continue at (max_cost + 1)
+    static const int MAX_ROWS = 8;
+
+    static const int COST_INF = MAX_ROWS + 1;
+
+    struct state {
+        uint64_t rows[MAX_ROWS];
+        uint64_t trans[MAX_ROWS];
+    };
+
+    lev_automaton(const unsigned char* term, const int term_len, const int max_edits):
+            num_rows(max_edits + 1) {
+        memset(chi, 0, sizeof(chi));
+        for(int j = 1; j <= term_len; j++) {
+            chi[term[j-1]] |= (1ULL << j);
+        }
+    }
+
+    static bool usable(const int term_len, const int max_edits) {
+        return term_len <= MAX_TERM_LEN && (max_edits + 1) <= MAX_ROWS;
+    }
+
+    state initial() const {
+        state st;
+        memset(&st, 0, sizeof(st));
+        for(int e = 0; e < num_rows; e++) {
+            // e leading deletions: positions 0..e are reachable with e edits
+            st.rows[e] = (1ULL << (e + 1)) - 1;
+        }
+        return st;
+    }
+
+    // Advances the automaton over one key character. `depth` is the zero-based
+    // index of `c` within the key: the DP recurrence applies transpositions
+    // only from depth 2 onwards, and this mirrors that behavior.
+    void step(state& st, const unsigned char c, const int depth) const {
+        const uint64_t match = chi[c];
+        uint64_t prev_row = st.rows[0];
+        uint64_t next[MAX_ROWS];
+        uint64_t next_trans[MAX_ROWS];
+
+        next[0] = (st.rows[0] << 1) & match;
+        next_trans[0] = 0;
+
+        for(int e = 1; e < num_rows; e++) {
+            next[e] = ((st.rows[e] << 1) & match) |
+                      prev_row |                     // insertion
+                      (prev_row << 1) |              // substitution
+                      (next[e-1] << 1);              // deletion
+
+            if(depth > 1) {
+                // seeded two characters ago, completed iff c matches the
+                // earlier of the two swapped positions
+                next[e] |= st.trans[e] & (match << 1);
+            }
+
+            // seed transposition candidates for the next step: bit j is set
+            // when row (e-1) could consume j-2 chars and c == term[j-1]
+            next_trans[e] = (prev_row << 2) & match;
+            prev_row = st.rows[e];
+        }
+
+        memcpy(st.rows, next, sizeof(uint64_t) * num_rows);
+        memcpy(st.trans, next_trans, sizeof(uint64_t) * num_rows);
+    }
+
+    bool is_dead(const state& st) const {
+        uint64_t any = 0;
+        for(int e = 0; e < num_rows; e++) {
+            any |= st.rows[e];
+        }
+        return any == 0;
+    }
+
+    // Cost of consuming exactly `column` characters of the term, i.e. the
+    // DP value cost_row[column], or COST_INF when it exceeds the budget.
+    int cost_at(const state& st, const int column) const {
+        for(int e = 0; e < num_rows; e++) {
+            if((st.rows[e] >> column) & 1) {
+                return e;
+            }
+        }
+        return COST_INF;
+    }
+
+private:
+    uint64_t chi[256];
+    int num_rows;
+};
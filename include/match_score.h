@@ -8,6 +8,11 @@
 #include <limits>
 #include "logger.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MATCH_HAS_SSE4_MIN_SCAN 1
+#endif
+
 const size_t WINDOW_SIZE = 10;
 const uint16_t MAX_DISPLACEMENT = std::numeric_limits<uint16_t>::max();
 
@@ -130,6 +135,16 @@ struct Match {
         // in case if number of tokens in query is greater than max window
         const size_t tokens_size = std::min(token_offsets.size(), WINDOW_SIZE);
 
+        if(!populate_window) {
+            // scoring-only fast path that skips all window bookkeeping
+            score_tokens(token_offsets, tokens_size);
+            exact_match = 0;
+            if(check_exact_match) {
+                set_exact_match(token_offsets);
+            }
+            return;
+        }
+
         std::vector<TokenOffset> window(tokens_size);
         for (size_t token_id = 0; token_id < tokens_size; token_id++) {
             window[token_id] = TokenOffset{static_cast<uint8_t>(token_id), token_offsets[token_id].positions[0], 0};
@@ -218,29 +233,158 @@ struct Match {
         exact_match = 0;
 
         if(check_exact_match) {
+            set_exact_match(token_offsets);
+        }
+    }
 
-            if(distance != token_offsets.size()-1) {
-                // we can exit early and don't have to care about other requirements
+private:
+
+    void set_exact_match(const std::vector<token_positions_t>& token_offsets) {
+        if(distance != token_offsets.size()-1) {
+            // we can exit early and don't have to care about other requirements
+            return;
+        }
+
+        int last_token_index = -1;
+        size_t total_offsets = 0;
+
+        for(const auto& token_positions: token_offsets) {
+            if(token_positions.last_token && !token_positions.positions.empty()) {
+                last_token_index = token_positions.positions.back();
+            }
+            total_offsets += token_positions.positions.size();
+            if(total_offsets > token_offsets.size()) {
+                // if total offsets exceed query length, there cannot possibly be an exact match
                 return;
             }
+        }
 
-            int last_token_index = -1;
-            size_t total_offsets = 0;
+        if(last_token_index == int(token_offsets.size())-1 && total_offsets == token_offsets.size()) {
+            exact_match = 1;
+        }
+    }
 
-            for(const auto& token_positions: token_offsets) {
-                if(token_positions.last_token && !token_positions.positions.empty()) {
-                    last_token_index = token_positions.positions.back();
-                }
-                total_offsets += token_positions.positions.size();
-                if(total_offsets > token_offsets.size()) {
-                    // if total offsets exceed query length, there cannot possibly be an exact match
-                    return;
-                }
+    static inline void min_offset_scan(const uint16_t* cur_offsets, const size_t tokens_size,
+                                       uint32_t& min_offset, size_t& min_token) {
+        min_offset = cur_offsets[0];
+        min_token = 0;
+
+        for(size_t i = 1; i < tokens_size; i++) {
+            if(cur_offsets[i] < min_offset) {
+                min_offset = cur_offsets[i];
+                min_token = i;
             }
+        }
+    }
 
-            if(last_token_index == int(token_offsets.size())-1 && total_offsets == token_offsets.size()) {
-                exact_match = 1;
+#ifdef MATCH_HAS_SSE4_MIN_SCAN
+
+    __attribute__((target("sse4.1")))
+    static inline void min_offset_scan_sse(const uint16_t* cur_offsets, uint32_t& min_offset, size_t& min_token) {
+        // horizontal min + position over the 16 padded lanes in two ops
+        const __m128i lo_min = _mm_minpos_epu16(_mm_load_si128(reinterpret_cast<const __m128i*>(cur_offsets)));
+        const __m128i hi_min = _mm_minpos_epu16(_mm_load_si128(reinterpret_cast<const __m128i*>(cur_offsets + 8)));
+
+        min_offset = _mm_extract_epi16(lo_min, 0);
+        min_token = _mm_extract_epi16(lo_min, 1);
+
+        const uint32_t hi_offset = _mm_extract_epi16(hi_min, 0);
+        if(hi_offset < min_offset) {
+            min_offset = hi_offset;
+            min_token = _mm_extract_epi16(hi_min, 1) + 8;
+        }
+    }
+
+    static bool cpu_has_sse41() {
+        static const bool has_sse41 = __builtin_cpu_supports("sse4.1");
+        return has_sse41;
+    }
+
+#endif
+
+    /*
+     * Scoring-only equivalent of the windowing loop above: tracks the current
+     * offset of every token in a flat array and advances the minimum on each
+     * step, so no per-iteration sort or window vector is needed. Since the
+     * qualifying offsets form a contiguous run above the minimum, the summed
+     * adjacent displacements telescope to (max qualifying offset - minimum).
+     */
+    void score_tokens(const std::vector<token_positions_t>& token_offsets, const size_t tokens_size) {
+        alignas(16) uint16_t cur_offsets[16];
+        uint16_t cur_indices[WINDOW_SIZE];
+
+        for(size_t i = 0; i < 16; i++) {
+            cur_offsets[i] = MAX_DISPLACEMENT;  // exhausted-token sentinel
+        }
+
+        for(size_t i = 0; i < tokens_size; i++) {
+            cur_offsets[i] = token_offsets[i].positions[0];
+            cur_indices[i] = 0;
+        }
+
+        size_t active_tokens = tokens_size;
+        size_t best_num_match = 1;
+        size_t best_displacement = MAX_DISPLACEMENT;
+
+#ifdef MATCH_HAS_SSE4_MIN_SCAN
+        const bool use_sse_scan = cpu_has_sse41();
+#endif
+
+        while(active_tokens > 1) {
+            uint32_t min_offset;
+            size_t min_token;
+
+#ifdef MATCH_HAS_SSE4_MIN_SCAN
+            if(use_sse_scan) {
+                min_offset_scan_sse(cur_offsets, min_offset, min_token);
+            } else
+#endif
+            {
+                min_offset_scan(cur_offsets, tokens_size, min_offset, min_token);
             }
+
+            size_t this_num_match = 0;
+            uint32_t max_in_window = min_offset;
+
+            for(size_t i = 0; i < tokens_size; i++) {
+                const uint32_t offset = cur_offsets[i];
+                const bool within_window = (offset - min_offset) <= WINDOW_SIZE;
+                this_num_match += within_window;
+                const uint32_t qualified_offset = within_window ? offset : 0;
+                max_in_window = std::max(max_in_window, qualified_offset);
+            }
+
+            const size_t this_displacement = max_in_window - min_offset;
+
+            if((this_num_match > best_num_match) ||
+               (this_num_match == best_num_match && this_displacement < best_displacement)) {
+                best_num_match = this_num_match;
+                best_displacement = this_displacement;
+            }
+
+            if(best_num_match == tokens_size && best_displacement == (active_tokens - 1)) {
+                // this is the best we can get, so quit early!
+                break;
+            }
+
+            // advance the token that held the minimum
+            const std::vector<uint16_t>& positions = token_offsets[min_token].positions;
+
+            if(size_t(cur_indices[min_token]) + 1 < positions.size()) {
+                cur_indices[min_token]++;
+                cur_offsets[min_token] = positions[cur_indices[min_token]];
+            } else {
+                // no more offsets for this token
+                cur_offsets[min_token] = MAX_DISPLACEMENT;
+                active_tokens--;
+            }
+        }
+
+        if(best_displacement == MAX_DISPLACEMENT) {
+            best_displacement = 0;
         }
+
+        words_present = best_num_match;
+        distance = uint8_t(best_displacement);
     }
 };
@@ -1,32 +1,89 @@
 #pragma once
 
-#include <map>
+#include <functional>
+#include <vector>
 #include "sparsepp.h"
 #include "sorted_array.h"
 #include "array_utils.h"
 #include "art.h"
 
+// number of keys held by each num_tree_t leaf page (tunable at build time)
+#ifndef NUM_TREE_LEAF_FANOUT
+#define NUM_TREE_LEAF_FANOUT 64
+#endif
+
 class num_tree_t {
 private:
-    std::map<int64_t, sorted_array*> int64map;
+    /*
+     * B+-tree style leaf-page layout: values live in sorted, chained pages so
+     * that range scans walk contiguous memory instead of chasing one red-black
+     * node per distinct value (price / timestamp fields hold millions of them).
+     * A flat, binary-searched directory of every page's first key stands in
+     * for the inner nodes.
+     */
+    struct leaf_page_t {
+        std::vector<int64_t> keys;              // sorted
+        std::vector<sorted_array*> values;      // parallel to `keys`
+        leaf_page_t* next = nullptr;
+
+        // sorted, de-duplicated union of every value's ids, built lazily and
+        // dropped on writes to the page: a wide range filter then merges one
+        // pre-aggregated array per fully covered page instead of one per key
+        sorted_array* id_union = nullptr;
+    };
+
+    static constexpr size_t LEAF_FANOUT = NUM_TREE_LEAF_FANOUT;
+
+    // directory: first key of pages[i] is page_first_keys[i] (kept in sync)
+    std::vector<int64_t> page_first_keys;
+    std::vector<leaf_page_t*> pages;
+
+    size_t num_keys = 0;
+
+    // index of the page that contains (or would contain) `value`
+    size_t page_index_of(int64_t value) const;
+
+    sorted_array* find_value(int64_t value) const;
+
+    sorted_array* get_or_create(int64_t value);
+
+    // appends ids of all keys in [start, end], merging one pre-aggregated
+    // id union per fully covered page instead of one array per key
+    void collect_range_ids(int64_t start, int64_t end, std::vector<uint32_t>& consolidated_ids);
 
 public:
 
     ~num_tree_t() {
-        for(auto& kv: int64map) {
-            delete kv.second;
+        for(leaf_page_t* page: pages) {
+            for(sorted_array* arr: page->values) {
+                delete arr;
+            }
+
+            delete page->id_union;
+            delete page;
         }
     }
 
     void insert(int64_t value, uint32_t id);
 
+    // snapshot support: installs a value's full sorted id list in one bulk
+    // load instead of one compressed append per id
+    void load(int64_t value, const uint32_t* ids, uint32_t ids_len);
+
     void range_inclusive_search(int64_t start, int64_t end, uint32_t** ids, size_t& ids_len);
 
     size_t get(int64_t value, std::vector<uint32_t>& geo_result_ids);
 
     void search(NUM_COMPARATOR comparator, int64_t value, uint32_t** ids, size_t& ids_len);
 
+    // walks values in ascending or descending order, calling `func` with each
+    // value's ids until it returns false
+    void iterate_values(bool descending, const std::function<bool(int64_t, sorted_array*)>& func);
+
     void remove(uint64_t value, uint32_t id);
 
     size_t size();
-};
\ No newline at end of file
+
+    // approximate bytes held by the page directory, leaf pages and id arrays
+    size_t memory_bytes() const;
+};
@@ -66,8 +66,11 @@ public:
             to_expanded_plists(raw_posting_lists, plists, expanded_plists);
 
             if(plists.size() > 1) {
+                // most selective list first: it drives both the intersection loop and
+                // the windowing in split_lists(). Number of ids is a finer estimate
+                // than number of blocks (two one-block lists can differ 100x in ids).
                 std::sort(this->plists.begin(), this->plists.end(), [](posting_list_t* a, posting_list_t* b) {
-                    return a->num_blocks() < b->num_blocks();
+                    return a->num_ids() < b->num_ids();
                 });
             }
         }
@@ -84,7 +87,7 @@ public:
         void split_lists(size_t concurrency, std::vector<std::vector<posting_list_t::iterator_t>>& partial_its_vec);
     };
 
-    static void upsert(void*& obj, uint32_t id, const std::vector<uint32_t>& offsets);
+    static void upsert(void*& obj, uint32_t id, const std::vector<uint32_t>& offsets, int64_t score = INT64_MAX);
 
     static void erase(void*& obj, uint32_t id);
 
@@ -92,6 +95,9 @@ public:
 
     static uint32_t num_ids(const void* obj);
 
+    // approximate bytes held by a compact or full posting list
+    static size_t memory_bytes(const void* obj);
+
     static uint32_t first_id(const void* obj);
 
     static bool contains(const void* obj, uint32_t id);
@@ -114,13 +120,23 @@ public:
 
     static void get_matching_array_indices(const std::vector<void*>& raw_posting_lists,
                                            uint32_t id, std::vector<size_t>& indices);
+
+    // flattens ids and per-id offsets into the parallel-array shape that
+    // posting_list_t::load_sorted consumes (index snapshot serialization)
+    static void dump_flat(const void* obj, std::vector<uint32_t>& ids,
+                          std::vector<uint32_t>& offset_index, std::vector<uint32_t>& offsets);
+
+    // rebuilds a posting object from dump_flat() output, choosing the compact
+    // or full representation the same way incremental upserts would have
+    static void* load_flat(uint32_t num_ids, const uint32_t* ids, const uint32_t* offset_index,
+                           uint32_t num_offsets, const uint32_t* offsets);
 };
 
 template<class T>
 bool posting_t::block_intersector_t::intersect(T func, size_t concurrency) {
     // Split posting lists into N chunks and intersect them in-parallel
-    // 1. Sort posting lists by number of blocks
-    // 2. Iterate on the posting list with least number of blocks on N-block windows
+    // 1. Sort posting lists by selectivity (number of ids)
+    // 2. Iterate on the most selective posting list on N-block windows
     // 3. On each window, pick the last block's last ID and identify blocks from other lists containing that ID
     // 4. Construct N groups of iterators this way (the last block must overlap on both sides of the window)
 
@@ -128,7 +144,9 @@ bool posting_t::block_intersector_t::intersect(T func, size_t concurrency) {
         return true;
     }
 
-    if(plists[0]->num_ids() < parallelize_min_ids) {
+    // a single chunk gains nothing from a pool round-trip; running it inline also
+    // lets callers that already execute on the pool avoid blocking on nested tasks
+    if(concurrency == 1 || plists[0]->num_ids() < parallelize_min_ids) {
         std::vector<posting_list_t::iterator_t> its;
         its.reserve(plists.size());
 
@@ -165,16 +183,25 @@ bool posting_t::block_intersector_t::intersect(T func, size_t concurrency) {
     size_t num_processed = 0;
     std::mutex m_process;
     std::condition_variable cv_process;
-    size_t num_non_empty = 0;
+    size_t num_queued = 0;
+
+    size_t last_non_empty = partial_its_vec.size();
+    for(size_t i = 0; i < partial_its_vec.size(); i++) {
+        if(!partial_its_vec[i].empty()) {
+            last_non_empty = i;
+        }
+    }
 
     for(size_t i = 0; i < partial_its_vec.size(); i++) {
         auto& partial_its = partial_its_vec[i];
 
-        if(partial_its.empty()) {
+        // the last chunk is handled inline below on the calling thread,
+        // which would otherwise just sleep on the condition variable
+        if(partial_its.empty() || i == last_non_empty) {
             continue;
         }
 
-        num_non_empty++;
+        num_queued++;
 
         /*for(auto& it: partial_its) {
             while(it.valid()) {
@@ -195,8 +222,14 @@ bool posting_t::block_intersector_t::intersect(T func, size_t concurrency) {
         });
     }
 
+    if(last_non_empty != partial_its_vec.size()) {
+        auto iter_state_copy = iter_state;
+        iter_state_copy.index = last_non_empty;
+        posting_list_t::block_intersect<T>(partial_its_vec[last_non_empty], iter_state_copy, func);
+    }
+
     std::unique_lock<std::mutex> lock_process(m_process);
-    cv_process.wait(lock_process, [&](){ return num_processed == num_non_empty; });
+    cv_process.wait(lock_process, [&](){ return num_processed == num_queued; });
 
     return true;
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <unordered_map>
 #include "sorted_array.h"
@@ -8,6 +9,40 @@
 
 typedef uint32_t last_id_t;
 
+/*
+ * Chunked bitmap over document ids (the bitmap-container flavour of a
+ * roaring bitmap): 2^16-id chunks allocated on demand, each a flat 8 KB
+ * word array. Dense posting lists maintain one alongside their block
+ * chain so membership checks and intersections against them become O(1)
+ * word probes instead of block-chain walks.
+ */
+struct id_bitmap_t {
+    static const uint32_t CHUNK_SHIFT = 16;
+    static const uint32_t WORDS_PER_CHUNK = (1 << CHUNK_SHIFT) / 64;
+
+    std::vector<uint64_t*> chunks;
+
+    ~id_bitmap_t() {
+        for(uint64_t* chunk: chunks) {
+            delete [] chunk;
+        }
+    }
+
+    void set(uint32_t id);
+
+    void unset(uint32_t id);
+
+    bool contains(uint32_t id) const {
+        uint32_t chunk_index = id >> CHUNK_SHIFT;
+        if(chunk_index >= chunks.size() || chunks[chunk_index] == nullptr) {
+            return false;
+        }
+
+        uint32_t bit = id & ((1 << CHUNK_SHIFT) - 1);
+        return (chunks[chunk_index][bit / 64] >> (bit % 64)) & 1;
+    }
+};
+
 #define FOR_ELE_SIZE sizeof(uint32_t)
 #define METADATA_OVERHEAD 5
 
@@ -29,6 +64,11 @@ public:
         // link to next block
         block_t* next = nullptr;
 
+        // upper bound of the indexing scores of the ids in this block, used by the
+        // WAND intersection to skip blocks that cannot make the top-k (erase leaves
+        // it stale-high, which keeps it a valid upper bound)
+        int64_t max_score = INT64_MIN;
+
         bool contains(uint32_t id);
 
         void remove_and_shift_offset_index(const uint32_t* indices_sorted, uint32_t num_indices);
@@ -49,21 +89,42 @@ public:
 
         block_t* end_block;
 
+        // last_id => block mapping of the parent list, used by skip_to()
+        // to jump over intermediate blocks instead of walking (and
+        // uncompressing) each one
+        const std::map<last_id_t, block_t*>* id_block_map;
+
+        // whether the decode buffers came from the thread local scratch pool
+        // (oversized offset streams fall back to plain heap allocations)
+        bool ids_pooled = false;
+        mutable bool offset_index_pooled = false;
+        mutable bool offsets_pooled = false;
+
+        void decode_curr_block();
+        void release_buffers();
+
     public:
         // uncompressed data structures for performance
         uint32_t* ids = nullptr;
-        uint32_t* offset_index = nullptr;
-        uint32_t* offsets = nullptr;
 
-        explicit iterator_t(block_t* start, block_t* end);
+        // unlike ids, offsets are decoded lazily via decode_offsets(): most
+        // candidates are filtered away before scoring ever looks at offsets
+        mutable uint32_t* offset_index = nullptr;
+        mutable uint32_t* offsets = nullptr;
+
+        explicit iterator_t(block_t* start, block_t* end,
+                            const std::map<last_id_t, block_t*>* id_block_map = nullptr);
         iterator_t(iterator_t&& rhs) noexcept;
         ~iterator_t();
+        // decodes the current block's offset arrays on first use
+        void decode_offsets() const;
         [[nodiscard]] bool valid() const;
         void next();
         void skip_to(uint32_t id);
         [[nodiscard]] uint32_t id() const;
         [[nodiscard]] inline uint32_t index() const;
         [[nodiscard]] inline block_t* block() const;
+        [[nodiscard]] int64_t block_max_score() const;
     };
 
     struct result_iter_state_t {
@@ -77,6 +138,10 @@ public:
         size_t filter_ids_index = 0;
         size_t index = 0;
 
+        // Block-Max WAND: when set, intersections skip whole blocks whose max_score
+        // cannot beat this threshold (callers keep it updated from the top-k heap)
+        const std::atomic<int64_t>* max_score_threshold = nullptr;
+
         result_iter_state_t() = default;
 
         result_iter_state_t(uint32_t* excluded_result_ids, size_t excluded_result_ids_size,
@@ -98,6 +163,11 @@ private:
     // MUST be ordered
     std::map<last_id_t, block_t*> id_block_map;
 
+    // maintained once the list crosses BITMAP_MIN_IDS, for O(1) membership
+    id_bitmap_t* id_bitmap = nullptr;
+
+    void build_id_bitmap();
+
     static bool at_end(const std::vector<posting_list_t::iterator_t>& its);
     static bool at_end2(const std::vector<posting_list_t::iterator_t>& its);
 
@@ -113,8 +183,14 @@ private:
     static uint32_t advance_smallest(std::vector<posting_list_t::iterator_t>& its);
     static uint32_t advance_smallest2(std::vector<posting_list_t::iterator_t>& its);
 
+    static bool advance_past_low_scoring_blocks(std::vector<posting_list_t::iterator_t>& its, int64_t threshold);
+
 public:
 
+    // high-frequency tokens (stopword-like terms, brand names) upgrade to
+    // a bitmap-accelerated representation past this many ids
+    static constexpr size_t BITMAP_MIN_IDS = 50000;
+
     posting_list_t() = delete;
 
     explicit posting_list_t(uint16_t max_block_elements);
@@ -125,16 +201,28 @@ public:
 
     static void merge_adjacent_blocks(block_t* block1, block_t* block2, size_t num_block2_ids_to_move);
 
-    void upsert(uint32_t id, const std::vector<uint32_t>& offsets);
+    void upsert(uint32_t id, const std::vector<uint32_t>& offsets, int64_t score = INT64_MAX);
+
+    // bulk-loads sorted, de-duplicated ids (with their offsets) into an empty list,
+    // building whole blocks directly instead of paying a re-encode per upserted id
+    void load_sorted(const uint32_t* ids, uint32_t num_ids,
+                     const uint32_t* offset_index, const uint32_t* offsets, uint32_t num_offsets);
 
     void erase(uint32_t id);
 
+    // merges adjacent blocks left sparse by erases whenever their combined ids
+    // fit in one block, and returns the number of blocks freed
+    size_t compact_blocks();
+
     block_t* get_root();
 
     size_t num_blocks() const;
 
     size_t num_ids() const;
 
+    // approximate bytes held by the blocks and the id => block map
+    size_t memory_bytes() const;
+
     uint32_t first_id();
 
     block_t* block_of(uint32_t id);
@@ -143,6 +231,10 @@ public:
 
     bool contains_atleast_one(const uint32_t* target_ids, size_t target_ids_size);
 
+    const id_bitmap_t* get_id_bitmap() const {
+        return id_bitmap;
+    }
+
     iterator_t new_iterator(block_t* start_block = nullptr, block_t* end_block = nullptr);
 
     static void merge(const std::vector<posting_list_t*>& posting_lists, std::vector<uint32_t>& result_ids);
@@ -182,6 +274,11 @@ bool posting_list_t::block_intersect(std::vector<posting_list_t::iterator_t>& it
             break;
         case 1:
             while(its[0].valid()) {
+                if(istate.max_score_threshold != nullptr &&
+                   advance_past_low_scoring_blocks(its, istate.max_score_threshold->load(std::memory_order_relaxed))) {
+                    continue;
+                }
+
                 if(posting_list_t::take_id(istate, its[0].id())) {
                     func(its[0].id(), its, istate.index);
                 }
@@ -191,6 +288,11 @@ bool posting_list_t::block_intersect(std::vector<posting_list_t::iterator_t>& it
             break;
         case 2:
             while(!at_end2(its)) {
+                if(istate.max_score_threshold != nullptr &&
+                   advance_past_low_scoring_blocks(its, istate.max_score_threshold->load(std::memory_order_relaxed))) {
+                    continue;
+                }
+
                 if(equals2(its)) {
                     if(posting_list_t::take_id(istate, its[0].id())) {
                         func(its[0].id(), its, istate.index);
@@ -204,6 +306,11 @@ bool posting_list_t::block_intersect(std::vector<posting_list_t::iterator_t>& it
             break;
         default:
             while(!at_end(its)) {
+                if(istate.max_score_threshold != nullptr &&
+                   advance_past_low_scoring_blocks(its, istate.max_score_threshold->load(std::memory_order_relaxed))) {
+                    continue;
+                }
+
                 if(equals(its)) {
                     //LOG(INFO) << its[0].id();
                     if(posting_list_t::take_id(istate, its[0].id())) {
@@ -110,10 +110,33 @@ private:
     std::atomic<bool> read_caught_up;
     std::atomic<bool> write_caught_up;
 
+    // raft entries committed but not yet applied here, including queued write
+    // batches (refreshed along with the catch-up status)
+    std::atomic<int64_t> applied_lag_entries;
+
+    // epoch millis of the last refresh that found zero applied lag; the basis
+    // for the bounded-staleness contract (see get_read_staleness_ms)
+    std::atomic<int64_t> last_caught_up_ts_ms;
+
     std::string raft_dir_path;
 
     std::string ext_snapshot_path;
 
+    // validated copy of the configured snapshot window (empty = no window, braft's
+    // own snapshot timer stays active); scheduling state for trigger_periodic_snapshot()
+    std::string snapshot_window;
+    int snapshot_interval_s;
+    uint64_t last_periodic_snapshot_ts;
+
+    // duration and bytes written by the most recent snapshot (exposed on /stats.json)
+    std::atomic<int64_t> last_snapshot_duration_ms;
+    std::atomic<int64_t> last_snapshot_bytes_written;
+
+    // checksums of the previous snapshot's immutable db files, keyed by
+    // file name -> (size, crc32c), so save_snapshot() does not re-read SST
+    // files that haven't changed (snapshots are serialized, so no locking)
+    std::unordered_map<std::string, std::pair<uint64_t, std::string>> snapshot_file_checksums;
+
     int election_timeout_interval_ms;
 
     std::mutex mcv;
@@ -165,6 +188,26 @@ public:
         return write_caught_up;
     }
 
+    int64_t get_applied_lag() const {
+        return applied_lag_entries;
+    }
+
+    // upper bound (in millis) on how stale this node's applied state is: 0 when
+    // fully caught up, otherwise the time since the last zero-lag observation
+    int64_t get_read_staleness_ms() const;
+
+    int64_t get_last_snapshot_duration_ms() const {
+        return last_snapshot_duration_ms;
+    }
+
+    int64_t get_last_snapshot_bytes_written() const {
+        return last_snapshot_bytes_written;
+    }
+
+    // fires a snapshot when a snapshot window is configured, currently open and
+    // the snapshot interval has elapsed; no-op otherwise (called off the raft loop)
+    void trigger_periodic_snapshot();
+
     bool is_alive() const;
 
     uint64_t node_state() const;
@@ -189,6 +232,10 @@ public:
 
     http_message_dispatcher* get_message_dispatcher() const;
 
+    // dispatcher of the loop that owns the request's socket; requests replayed
+    // from the raft log have none and fall back to the main loop
+    http_message_dispatcher* get_message_dispatcher(const std::shared_ptr<http_req>& req) const;
+
     void wait() {
         auto lk = std::unique_lock<std::mutex>(mcv);
         cv.wait(lk, [&] { return ready; });
@@ -205,6 +252,12 @@ public:
 
     int64_t get_num_queued_writes();
 
+    bool is_write_backpressured();
+
+    int64_t get_write_drain_rate();
+
+    size_t get_write_retry_after_secs();
+
     bool is_leader();
 
 private:
@@ -221,6 +274,8 @@ private:
         std::string db_snapshot_path;
         std::string ext_snapshot_path;
         braft::Closure* done;
+        int max_write_mb_per_sec;
+        uint64_t start_ts_ms;
     };
 
     static void *save_snapshot(void* arg);
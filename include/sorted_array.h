@@ -38,6 +38,8 @@ private:
                                int low_index, int high_index, uint32_t base, uint32_t bits,
                                uint32_t *indices);
 
+    void merge_search_indices(const uint32_t *values, size_t values_len, uint32_t *indices);
+
     void binary_search_indices(const uint32_t *values, int low_vindex, int high_vindex,
                                int low_index, int high_index, uint32_t *indices);
 
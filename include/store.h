@@ -5,6 +5,7 @@
 #include <string>
 #include <sstream>
 #include <memory>
+#include <algorithm>
 #include <thread>
 #include <shared_mutex>
 #include <option.h>
@@ -13,8 +14,13 @@
 #include <rocksdb/options.h>
 #include <rocksdb/merge_operator.h>
 #include <rocksdb/transaction_log.h>
+#include <rocksdb/table.h>
+#include <rocksdb/filter_policy.h>
+#include <rocksdb/cache.h>
+#include <rocksdb/rate_limiter.h>
 #include <butil/file_util.h>
 #include <rocksdb/utilities/checkpoint.h>
+#include <json.hpp>
 #include "string_utils.h"
 #include "logger.h"
 #include "file_utils.h"
@@ -42,6 +48,25 @@ enum StoreStatus {
     ERROR
 };
 
+// Curated set of RocksDB tunables surfaced through server configuration
+// (see the `db-*` options). A zero value keeps the built-in default, so a
+// default-constructed instance leaves behavior unchanged.
+struct store_tuning_t {
+    // shared LRU cache for data and index blocks, across column families
+    size_t block_cache_mb = 0;
+
+    // size and count of the memtables of each column family
+    size_t write_buffer_mb = 0;
+    size_t max_write_buffer_number = 0;
+
+    // threads available for background compactions and flushes
+    int max_background_jobs = 0;
+
+    // disk write rate limit shared by compactions and flushes, to keep
+    // compaction I/O from starving foreground traffic during imports
+    int compaction_rate_mb_per_sec = 0;
+};
+
 /*
  *  Abstraction for underlying KV store (RocksDB)
  */
@@ -53,14 +78,162 @@ private:
     rocksdb::Options options;
     rocksdb::WriteOptions write_options;
 
+    store_tuning_t tuning;
+
+    // block cache configured via `tuning`; shared across column families so a
+    // single budget covers the whole store (empty = RocksDB's per-CF default)
+    std::shared_ptr<rocksdb::Cache> block_cache;
+
+    // handles returned by DB::Open / CreateColumnFamily; destroyed before the DB handle
+    std::vector<rocksdb::ColumnFamilyHandle*> cf_handles;
+
+    // column family holding document JSONs and buffered raft request chunks
+    rocksdb::ColumnFamilyHandle* docs_cf = nullptr;
+
     // Used to protect assignment to DB handle, which is otherwise thread safe
     // So we use unique lock only for assignment, but shared locks for all other operations on DB
     mutable std::shared_mutex mutex;
 
+    // Document JSONs ("<collection_id>_$SI_<seq_id>", see Collection::SEQ_ID_PREFIX) and
+    // buffered raft request chunks ("$RL_...", see BatchedIndexer::RAFT_REQ_LOG_PREFIX)
+    // are the only large values in the store. They get their own column family so that
+    // compacting them never rewrites the tiny hot metadata keys (collection meta,
+    // counters, doc-id mappings) and vice versa.
+    bool is_docs_cf_key(const std::string& key) const {
+        if(key.compare(0, 4, "$RL_") == 0) {
+            return true;
+        }
+
+        // "<collection_id>_$SI_...": anchor on the numeric prefix so that user
+        // controlled key parts (doc ids, collection names) can never match
+        size_t i = 0;
+        while(i < key.size() && key[i] >= '0' && key[i] <= '9') {
+            i++;
+        }
+
+        return i != 0 && key.compare(i, 5, "_$SI_") == 0;
+    }
+
+    rocksdb::ColumnFamilyHandle* cf_for_key(const std::string& key) const {
+        return is_docs_cf_key(key) ? docs_cf : db->DefaultColumnFamily();
+    }
+
+    rocksdb::ColumnFamilyOptions docs_cf_options() const {
+        rocksdb::ColumnFamilyOptions cf_options(options);
+
+        // document values are large and write heavy: bigger memtables mean fewer L0
+        // files, and a bloom filter lets point lookups on the doc-fetch path skip
+        // SST files that cannot contain the key
+        cf_options.write_buffer_size = 32*1048576;
+        cf_options.max_write_buffer_number = 2;
+        cf_options.compression = rocksdb::CompressionType::kSnappyCompression;
+
+        rocksdb::BlockBasedTableOptions table_options;
+        table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10, false));
+        if(block_cache) {
+            table_options.block_cache = block_cache;
+        }
+        cf_options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+
+        if(tuning.write_buffer_mb != 0) {
+            cf_options.write_buffer_size = tuning.write_buffer_mb * 1048576;
+        }
+
+        if(tuning.max_write_buffer_number != 0) {
+            cf_options.max_write_buffer_number = tuning.max_write_buffer_number;
+        }
+
+        // Documents of a collection share structure (same keys, similar values),
+        // which independent block compression cannot exploit. Compactions train a
+        // zstd dictionary from sampled input blocks per output file, so shared
+        // structure is stored once per SST instead of once per block.
+        cf_options.compression = rocksdb::CompressionType::kZSTD;
+        cf_options.compression_opts.max_dict_bytes = 16*1024;
+        cf_options.compression_opts.zstd_max_train_bytes = 100*16*1024;
+
+        // Key/value separation: values above min_blob_size are written to blob
+        // files that compactions never rewrite — only the keys and blob
+        // references move through the LSM, instead of the documents themselves.
+        // Garbage from overwritten / deleted documents is reclaimed by
+        // rewriting the oldest quarter of blob files during compactions.
+        // Blob values are compressed individually (RocksDB does not support
+        // dictionaries for blob files), but zstd still beats snappy on them.
+        cf_options.enable_blob_files = true;
+        cf_options.min_blob_size = 4096;
+        cf_options.blob_file_size = 256*1048576;
+        cf_options.blob_compression_type = rocksdb::CompressionType::kZSTD;
+        cf_options.enable_blob_garbage_collection = true;
+        cf_options.blob_garbage_collection_age_cutoff = 0.25;
+
+        return cf_options;
+    }
+
+    // Moves document and request-chunk values of a pre-column-family DB out of the
+    // default column family. Batches are written with the WAL enabled and flushed at
+    // the end, so a crash midway simply leaves the remaining keys behind for the next
+    // start-up to migrate.
+    void migrate_to_docs_cf() {
+        rocksdb::Iterator* iter = db->NewIterator(rocksdb::ReadOptions());
+        rocksdb::WriteBatch batch;
+        size_t num_migrated = 0;
+
+        for(iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+            const std::string& key = iter->key().ToString();
+            if(!is_docs_cf_key(key)) {
+                continue;
+            }
+
+            batch.Put(docs_cf, key, iter->value());
+            batch.Delete(key);
+            num_migrated++;
+
+            if(batch.Count() >= 2000) {
+                db->Write(rocksdb::WriteOptions(), &batch);
+                batch.Clear();
+            }
+        }
+
+        delete iter;
+
+        if(batch.Count() != 0) {
+            db->Write(rocksdb::WriteOptions(), &batch);
+        }
+
+        if(num_migrated != 0) {
+            rocksdb::FlushOptions flush_options;
+            db->Flush(flush_options);
+            db->Flush(flush_options, docs_cf);
+            LOG(INFO) << "Moved " << num_migrated << " large values into the "
+                      << DOCS_CF_NAME << " column family.";
+        }
+    }
+
+    void free_db_handles() {
+        for(rocksdb::ColumnFamilyHandle* cf_handle: cf_handles) {
+            db->DestroyColumnFamilyHandle(cf_handle);
+        }
+
+        cf_handles.clear();
+        docs_cf = nullptr;
+    }
+
     rocksdb::Status init_db() {
         LOG(INFO) << "Initializing DB by opening state dir: " << state_dir_path;
 
-        rocksdb::Status s = rocksdb::DB::Open(options, state_dir_path, &db);
+        // a DB created before the split keeps everything in the default column
+        // family: open only the families that exist and create the rest after
+        std::vector<std::string> existing_cfs;
+        rocksdb::DB::ListColumnFamilies(options, state_dir_path, &existing_cfs);
+        const bool has_docs_cf = std::find(existing_cfs.begin(), existing_cfs.end(),
+                                           DOCS_CF_NAME) != existing_cfs.end();
+
+        std::vector<rocksdb::ColumnFamilyDescriptor> cf_descriptors;
+        cf_descriptors.emplace_back(rocksdb::kDefaultColumnFamilyName, rocksdb::ColumnFamilyOptions(options));
+        if(has_docs_cf) {
+            cf_descriptors.emplace_back(DOCS_CF_NAME, docs_cf_options());
+        }
+
+        rocksdb::Status s = rocksdb::DB::Open(options, state_dir_path, cf_descriptors, &cf_handles, &db);
         if(!s.ok()) {
             LOG(ERROR) << "Error while initializing store: " << s.ToString();
             if(s.code() == rocksdb::Status::Code::kIOError) {
@@ -69,9 +242,26 @@ private:
                 LOG(ERROR) << "If you are SURE that this is not the case, delete the LOCK file "
                            << "in the data db directory and try again.";
             }
+
+            assert(s.ok());
+            return s;
+        }
+
+        if(has_docs_cf) {
+            docs_cf = cf_handles[1];
+        } else {
+            s = db->CreateColumnFamily(docs_cf_options(), DOCS_CF_NAME, &docs_cf);
+            if(!s.ok()) {
+                LOG(ERROR) << "Error while creating column family " << DOCS_CF_NAME
+                           << ": " << s.ToString();
+                assert(s.ok());
+                return s;
+            }
+
+            cf_handles.push_back(docs_cf);
+            migrate_to_docs_cf();
         }
 
-        assert(s.ok());
         return s;
     }
 
@@ -81,7 +271,8 @@ public:
 
     Store(const std::string & state_dir_path,
           const size_t wal_ttl_secs = 24*60*60,
-          const size_t wal_size_mb = 1024, bool disable_wal = true): state_dir_path(state_dir_path) {
+          const size_t wal_size_mb = 1024, bool disable_wal = true,
+          const store_tuning_t& tuning = store_tuning_t{}): state_dir_path(state_dir_path), tuning(tuning) {
         // Optimize RocksDB
         options.IncreaseParallelism();
         options.OptimizeLevelStyleCompaction();
@@ -93,6 +284,31 @@ public:
         options.compression = rocksdb::CompressionType::kSnappyCompression;
         //options.bottommost_compression = rocksdb::CompressionType::kSnappyCompression;
 
+        // apply the configured tunables (zero = keep the defaults above)
+        if(tuning.write_buffer_mb != 0) {
+            options.write_buffer_size = tuning.write_buffer_mb * 1048576;
+        }
+
+        if(tuning.max_write_buffer_number != 0) {
+            options.max_write_buffer_number = tuning.max_write_buffer_number;
+        }
+
+        if(tuning.max_background_jobs != 0) {
+            options.max_background_jobs = tuning.max_background_jobs;
+        }
+
+        if(tuning.compaction_rate_mb_per_sec != 0) {
+            options.rate_limiter.reset(rocksdb::NewGenericRateLimiter(
+                    int64_t(tuning.compaction_rate_mb_per_sec) * 1048576));
+        }
+
+        if(tuning.block_cache_mb != 0) {
+            block_cache = rocksdb::NewLRUCache(tuning.block_cache_mb * 1048576);
+            rocksdb::BlockBasedTableOptions table_options;
+            table_options.block_cache = block_cache;
+            options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+        }
+
         // these need to be high for replication scenarios
         options.WAL_ttl_seconds = wal_ttl_secs;
         options.WAL_size_limit_MB = wal_size_mb;
@@ -109,15 +325,26 @@ public:
         close();
     }
 
+    // name of the column family holding document JSONs and raft request chunks
+    static constexpr const char* DOCS_CF_NAME = "documents";
+
+    // for constructing write batches that put document values directly
+    rocksdb::ColumnFamilyHandle* get_docs_cf_handle() const {
+        return docs_cf;
+    }
+
     bool insert(const std::string& key, const std::string& value) {
         std::shared_lock lock(mutex);
-        rocksdb::Status status = db->Put(write_options, key, value);
+        rocksdb::Status status = db->Put(write_options, cf_for_key(key), key, value);
         return status.ok();
     }
 
-    bool batch_write(rocksdb::WriteBatch& batch) {
+    bool batch_write(rocksdb::WriteBatch& batch, bool sync = false) {
         std::shared_lock lock(mutex);
-        rocksdb::Status status = db->Write(write_options, &batch);
+        rocksdb::WriteOptions batch_write_options = write_options;
+        // rocksdb rejects syncing when the WAL is disabled (on the leader, Raft's WAL is used)
+        batch_write_options.sync = sync && !write_options.disableWAL;
+        rocksdb::Status status = db->Write(batch_write_options, &batch);
         return status.ok();
     }
 
@@ -126,7 +353,8 @@ public:
 
         std::string value;
         bool value_found;
-        bool key_may_exist = db->KeyMayExist(rocksdb::ReadOptions(), key, &value, &value_found);
+        bool key_may_exist = db->KeyMayExist(rocksdb::ReadOptions(), cf_for_key(key), key,
+                                             &value, &value_found);
 
         // returns false when key definitely does not exist
         if(!key_may_exist) {
@@ -138,13 +366,13 @@ public:
         }
 
         // otherwise, we have try getting the value
-        rocksdb::Status status = db->Get(rocksdb::ReadOptions(), key, &value);
+        rocksdb::Status status = db->Get(rocksdb::ReadOptions(), cf_for_key(key), key, &value);
         return status.ok() && !status.IsNotFound();
     }
 
     StoreStatus get(const std::string& key, std::string& value) const {
         std::shared_lock lock(mutex);
-        rocksdb::Status status = db->Get(rocksdb::ReadOptions(), key, &value);
+        rocksdb::Status status = db->Get(rocksdb::ReadOptions(), cf_for_key(key), key, &value);
 
         if(status.ok()) {
             return StoreStatus::FOUND;
@@ -160,13 +388,23 @@ public:
 
     bool remove(const std::string& key) {
         std::shared_lock lock(mutex);
-        rocksdb::Status status = db->Delete(write_options, key);
+        rocksdb::Status status = db->Delete(write_options, cf_for_key(key), key);
         return status.ok();
     }
 
-    rocksdb::Iterator* scan(const std::string & prefix) {
+    // `readahead_size` is meant for long sequential scans (exports): it makes
+    // RocksDB prefetch SST data ahead of the iterator, and such scans also skip
+    // the block cache so they cannot evict blocks that live traffic is using
+    rocksdb::Iterator* scan(const std::string & prefix, const size_t readahead_size = 0) {
         std::shared_lock lock(mutex);
-        rocksdb::Iterator *iter = db->NewIterator(rocksdb::ReadOptions());
+        rocksdb::ReadOptions read_options;
+
+        if(readahead_size != 0) {
+            read_options.readahead_size = readahead_size;
+            read_options.fill_cache = false;
+        }
+
+        rocksdb::Iterator *iter = db->NewIterator(read_options, cf_for_key(prefix));
         iter->Seek(prefix);
         return iter;
     }
@@ -179,7 +417,7 @@ public:
 
     void scan_fill(const std::string & prefix, std::vector<std::string> & values) {
         std::shared_lock lock(mutex);
-        rocksdb::Iterator *iter = db->NewIterator(rocksdb::ReadOptions());
+        rocksdb::Iterator *iter = db->NewIterator(rocksdb::ReadOptions(), cf_for_key(prefix));
         for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
             values.push_back(iter->value().ToString());
         }
@@ -189,7 +427,7 @@ public:
 
     void increment(const std::string & key, uint32_t value) {
         std::shared_lock lock(mutex);
-        db->Merge(write_options, key, StringUtils::serialize_uint32_t(value));
+        db->Merge(write_options, cf_for_key(key), key, StringUtils::serialize_uint32_t(value));
     }
 
     uint64_t get_latest_seq_number() const {
@@ -263,6 +501,9 @@ public:
 
     void close() {
         std::unique_lock lock(mutex);
+        if(db != nullptr) {
+            free_db_handles();
+        }
         delete db;
         db = nullptr;
     }
@@ -271,6 +512,9 @@ public:
         std::unique_lock lock(mutex);
 
         // we don't use close() to avoid nested lock and because lock is required until db is re-initialized
+        if(db != nullptr) {
+            free_db_handles();
+        }
         delete db;
         db = nullptr;
 
@@ -309,6 +553,68 @@ public:
         return 0;
     }
 
+    // Two-phase snapshot install: the snapshot is copied and sanity-checked in
+    // a staging directory while the current DB keeps serving reads; only the
+    // directory swap and the reopen happen under the exclusive lock, so
+    // searches see a pause of milliseconds instead of the full copy time.
+    int install_snapshot(const std::string& snapshot_path) {
+        const std::string staging_dir_path = state_dir_path + ".snapshot_install";
+
+        if(!butil::DeleteFile(butil::FilePath(staging_dir_path), true)) {
+            LOG(WARNING) << "rm " << staging_dir_path << " failed";
+            return -1;
+        }
+
+        // tries to use link if possible, or else copies
+        if(!copy_dir(snapshot_path, staging_dir_path)) {
+            LOG(WARNING) << "copy snapshot " << snapshot_path << " to " << staging_dir_path << " failed";
+            return -1;
+        }
+
+        // reading the column family list walks CURRENT + MANIFEST, catching a
+        // truncated or unreadable copy before the live DB is touched
+        std::vector<std::string> staged_cf_names;
+        const rocksdb::Status& staged_status = rocksdb::DB::ListColumnFamilies(rocksdb::DBOptions(),
+                                                                               staging_dir_path, &staged_cf_names);
+        if(!staged_status.ok()) {
+            LOG(WARNING) << "Staged snapshot at " << staging_dir_path << " is not a readable DB, msg: "
+                         << staged_status.ToString();
+            butil::DeleteFile(butil::FilePath(staging_dir_path), true);
+            return -1;
+        }
+
+        LOG(INFO) << "copy snapshot " << snapshot_path << " to " << staging_dir_path << " success";
+
+        std::unique_lock lock(mutex);
+
+        // we don't use close() to avoid nested lock and because lock is required until db is re-initialized
+        if(db != nullptr) {
+            free_db_handles();
+        }
+        delete db;
+        db = nullptr;
+
+        if(!butil::DeleteFile(butil::FilePath(state_dir_path), true)) {
+            LOG(WARNING) << "rm " << state_dir_path << " failed";
+            return -1;
+        }
+
+        if(!butil::Move(butil::FilePath(staging_dir_path), butil::FilePath(state_dir_path))) {
+            LOG(WARNING) << "mv " << staging_dir_path << " to " << state_dir_path << " failed";
+            return -1;
+        }
+
+        const rocksdb::Status& status = init_db();
+        if(!status.ok()) {
+            LOG(WARNING) << "Open DB " << state_dir_path << " failed, msg: " << status.ToString();
+            return -1;
+        }
+
+        LOG(INFO) << "DB open success!";
+
+        return 0;
+    }
+
     void flush() {
         std::shared_lock lock(mutex);
         rocksdb::FlushOptions options;
@@ -335,7 +641,7 @@ public:
 
     rocksdb::Status delete_range(const std::string& begin_key, const std::string& end_key) {
         std::shared_lock lock(mutex);
-        return db->DeleteRange(rocksdb::WriteOptions(), db->DefaultColumnFamily(), begin_key, end_key);
+        return db->DeleteRange(rocksdb::WriteOptions(), cf_for_key(begin_key), begin_key, end_key);
     }
 
     // Only for internal tests
@@ -351,6 +657,52 @@ public:
         return options;
     }
 
+    // Point-in-time RocksDB counters for `GET /debug/rocksdb`, grouped per
+    // column family so that compaction stalls and cache pressure can be
+    // attributed to the family causing them.
+    nlohmann::json get_db_stats() const {
+        std::shared_lock lock(mutex);
+        nlohmann::json stats = nlohmann::json::object();
+
+        if(db == nullptr) {
+            return stats;
+        }
+
+        static const std::vector<std::string> int_properties = {
+            "rocksdb.estimate-num-keys",
+            "rocksdb.total-sst-files-size",
+            "rocksdb.num-files-at-level0",
+            "rocksdb.cur-size-all-mem-tables",
+            "rocksdb.num-immutable-mem-table",
+            "rocksdb.estimate-table-readers-mem",
+            "rocksdb.estimate-pending-compaction-bytes",
+            "rocksdb.num-running-compactions",
+            "rocksdb.num-running-flushes",
+            "rocksdb.actual-delayed-write-rate",
+            "rocksdb.is-write-stopped",
+            "rocksdb.block-cache-capacity",
+            "rocksdb.block-cache-usage",
+        };
+
+        auto fill_cf_stats = [this](rocksdb::ColumnFamilyHandle* cf, nlohmann::json& cf_stats) {
+            for(const std::string& property: int_properties) {
+                uint64_t value = 0;
+                if(db->GetIntProperty(cf, property, &value)) {
+                    // strip the "rocksdb." prefix
+                    cf_stats[property.substr(8)] = value;
+                }
+            }
+        };
+
+        fill_cf_stats(db->DefaultColumnFamily(), stats["default"]);
+
+        if(docs_cf != nullptr) {
+            fill_cf_stats(docs_cf, stats[DOCS_CF_NAME]);
+        }
+
+        return stats;
+    }
+
     void print_memory_usage() {
         std::string index_usage;
         db->GetProperty("rocksdb.estimate-table-readers-mem", &index_usage);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <algorithm>
 #include <sstream>
 #include <ctype.h>
@@ -33,13 +34,20 @@ struct StringUtils {
 
         while (true) {
             subend = std::search(substart, s.end(), delim.begin(), delim.end());
-            std::string temp(substart, subend);
+            end_index += (subend - substart) + delim.size();
 
-            end_index += temp.size() + delim.size();
-            temp = trim(temp);
+            // trim the token in-place so that it is allocated exactly once
+            std::string::const_iterator token_start = substart, token_end = subend;
+            while (token_start != token_end && *token_start == ' ') {
+                token_start++;
+            }
+
+            while (token_end != token_start && *(token_end - 1) == ' ') {
+                token_end--;
+            }
 
-            if (keep_empty || !temp.empty()) {
-                result.push_back(temp);
+            if (keep_empty || token_start != token_end) {
+                result.emplace_back(token_start, token_end);
             }
 
             if(result.size() == max_values) {
@@ -93,28 +101,32 @@ struct StringUtils {
     // Convert string of chars to its representative string of hex numbers
     static std::string str2hex(const std::string& str, bool capital = false);
 
-    static std::string url_decode(const std::string& text) {
-        char h;
-        std::ostringstream escaped;
-        escaped.fill('0');
+    static std::string url_decode(std::string_view text) {
+        if (text.find_first_of("%+") == std::string_view::npos) {
+            // nothing to decode
+            return std::string(text);
+        }
+
+        std::string escaped;
+        escaped.reserve(text.size());
 
-        for (auto i = text.begin(), n = text.end(); i != n; ++i) {
-            std::string::value_type c = (*i);
+        for (size_t i = 0; i < text.size(); ++i) {
+            char c = text[i];
 
             if (c == '%') {
-                if (i[1] && i[2]) {
-                    h = from_hex(i[1]) << 4 | from_hex(i[2]);
-                    escaped << h;
+                if (i + 2 < text.size() && text[i + 1] && text[i + 2]) {
+                    char h = from_hex(text[i + 1]) << 4 | from_hex(text[i + 2]);
+                    escaped += h;
                     i += 2;
                 }
             } else if (c == '+') {
-                escaped << ' ';
+                escaped += ' ';
             } else {
-                escaped << c;
+                escaped += c;
             }
         }
 
-        return escaped.str();
+        return escaped;
     }
 
     // See: https://stackoverflow.com/a/19751887/131050
@@ -309,7 +321,10 @@ struct StringUtils {
         return str.rfind(prefix, 0) == 0;
     }
 
-    static void parse_query_string(const std::string& query, std::map<std::string, std::string>& query_map);
+    // parses a raw query string (which can be a view into the request buffer) without
+    // materializing intermediate per-character accumulators: keys and values are sliced
+    // as views and copied exactly once into the map
+    static void parse_query_string(std::string_view query, std::map<std::string, std::string>& query_map);
 
     static std::string float_to_str(float value);
 
@@ -2,6 +2,8 @@
 #include <fstream>
 #include <sstream>
 #include <thread>
+#include <atomic>
+#include <memory>
 #include <sys/stat.h>
 #include "json.hpp"
 
@@ -38,6 +40,12 @@ private:
     static uint64_t non_proc_mem_last_access;
     static uint64_t non_proc_mem_bytes;
 
+    // snapshot of the last background sample: served as-is by get() so that
+    // several collectors scraping concurrently don't each trigger a fresh
+    // round of /proc reads, statvfs and mallctl calls
+    static std::shared_ptr<nlohmann::json> cached_metrics;
+    static std::atomic<uint64_t> last_sampled_seconds;
+
     size_t _get_idle_time(const cpu_data_t &e) {
         // we will consider iowait as cpu being idle
         return e.times[S_IDLE] +
@@ -139,11 +147,14 @@ private:
 
     static uint64_t linux_get_mem_available_bytes();
 
+    static uint64_t linux_get_proc_rss_bytes();
+
     static uint64_t get_memory_active_bytes();
 
     static uint64_t get_memory_non_proc_bytes();
 
-public:
+    // does the actual /proc + statvfs + mallctl round and publishes the snapshot
+    void sample(const std::string& data_dir_path);
 
     SystemMetrics() {
         non_proc_mem_last_access = std::chrono::duration_cast<std::chrono::seconds>(
@@ -152,10 +163,27 @@ public:
         non_proc_mem_bytes = memory_used_bytes - get_memory_active_bytes();
     }
 
+public:
+
+    const static uint64_t SAMPLE_INTERVAL_MS = 5 * 1000;
+
+    static SystemMetrics& get_instance() {
+        static SystemMetrics instance;
+        return instance;
+    }
+
+    SystemMetrics(SystemMetrics const&) = delete;
+    void operator=(SystemMetrics const&) = delete;
+
     static void linux_get_network_data(const std::string & stat_path, uint64_t& received_bytes, uint64_t& sent_bytes);
 
+    // serves the cached snapshot; samples inline only when the background
+    // sampler is not running (e.g. in tests) or the snapshot has gone stale
     void get(const std::string & data_dir_path, nlohmann::json& result);
 
+    // loops on a fixed cadence until `quit` is set, refreshing the snapshot
+    void run_sampler(const std::string& data_dir_path, const std::atomic<bool>& quit);
+
     static float used_memory_ratio();
 
     std::vector<cpu_stat_t> get_cpu_stats() {
@@ -2,58 +2,173 @@
 
 #pragma once
 
+#include <atomic>
+#include <deque>
 #include <functional>
 #include <future>
-#include <queue>
+#include <memory>
 
+#ifdef __linux__
+#include <fstream>
+#include <sstream>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Work-stealing pool: each worker owns a deque guarded by its own mutex, and
+// enqueue() spreads tasks round-robin across them. A worker pops from the front
+// of its own deque and steals from the back of the others, so the single hot
+// lock of a shared-queue pool is replaced by mostly-uncontended per-queue locks.
+// The sleep mutex + condition variable are only touched when a worker runs dry.
 class ThreadPool {
 public:
-    explicit ThreadPool(size_t);
+    explicit ThreadPool(size_t threads, bool pin_across_numa_nodes = false);
     template<class F, class... Args>
     decltype(auto) enqueue(F&& f, Args&&... args);
     void shutdown();
 private:
+    struct worker_queue_t {
+        std::mutex mutex;
+        std::deque<std::packaged_task<void()>> tasks;
+    };
+
     // need to keep track of threads so we can join them
     std::vector< std::thread > workers;
-    // the task queue
-    std::queue< std::packaged_task<void()> > tasks;
+    // per-worker task queues (unique_ptr since std::mutex is not movable)
+    std::vector<std::unique_ptr<worker_queue_t>> queues;
+
+    std::atomic<size_t> next_queue;
+    std::atomic<size_t> num_pending;
 
-    // synchronization
-    std::mutex queue_mutex;
+    // synchronization for idle workers
+    std::mutex sleep_mutex;
     std::condition_variable condition;
-    bool stop;
+    std::atomic<bool> stop;
+
+    bool try_pop_task(size_t self, std::packaged_task<void()>& task);
+
+    static void pin_workers_to_numa_nodes(std::vector<std::thread>& workers);
 };
 
+#ifdef __linux__
+// Distributes worker threads round-robin across NUMA nodes so that memory
+// touched first by a worker (index arenas, posting list blocks) stays local
+// to the node it keeps running on. On single-node machines every node set
+// spans all CPUs, so this degenerates into a no-op.
+inline void ThreadPool::pin_workers_to_numa_nodes(std::vector<std::thread>& workers) {
+    std::vector<cpu_set_t> node_cpu_sets;
+
+    for(size_t node = 0; ; node++) {
+        std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if(!cpulist.good()) {
+            break;
+        }
+
+        std::string ranges;
+        std::getline(cpulist, ranges);
+
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+
+        // cpulist looks like `0-15,32-47`
+        std::stringstream ranges_stream(ranges);
+        std::string range;
+        while(std::getline(ranges_stream, range, ',')) {
+            size_t dash_pos = range.find('-');
+            int first_cpu = std::atoi(range.substr(0, dash_pos).c_str());
+            int last_cpu = (dash_pos == std::string::npos) ? first_cpu :
+                           std::atoi(range.substr(dash_pos + 1).c_str());
+            for(int cpu = first_cpu; cpu <= last_cpu && cpu < CPU_SETSIZE; cpu++) {
+                CPU_SET(cpu, &cpu_set);
+            }
+        }
+
+        if(CPU_COUNT(&cpu_set) != 0) {
+            node_cpu_sets.push_back(cpu_set);
+        }
+    }
+
+    if(node_cpu_sets.size() < 2) {
+        // no NUMA topology (or sysfs unavailable): leave scheduling to the kernel
+        return;
+    }
+
+    for(size_t i = 0; i < workers.size(); i++) {
+        cpu_set_t& cpu_set = node_cpu_sets[i % node_cpu_sets.size()];
+        pthread_setaffinity_np(workers[i].native_handle(), sizeof(cpu_set_t), &cpu_set);
+    }
+}
+#else
+inline void ThreadPool::pin_workers_to_numa_nodes(std::vector<std::thread>&) {
+
+}
+#endif
+
+// pops from the front of the worker's own queue, otherwise steals from the
+// back of the other queues, starting with the next neighbour so concurrent
+// thieves don't all converge on queue 0
+inline bool ThreadPool::try_pop_task(size_t self, std::packaged_task<void()>& task) {
+    const size_t num_queues = queues.size();
+
+    for(size_t k = 0; k < num_queues; k++) {
+        const size_t qindex = (self + k) % num_queues;
+        worker_queue_t& queue = *queues[qindex];
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.tasks.empty()) {
+            continue;
+        }
+
+        if(qindex == self) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        } else {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
 // the constructor just launches some amount of workers
-inline ThreadPool::ThreadPool(size_t threads)
-        :   stop(false)
+inline ThreadPool::ThreadPool(size_t threads, bool pin_across_numa_nodes)
+        :   next_queue(0), num_pending(0), stop(false)
 {
+    queues.reserve(threads);
+    for(size_t i = 0;i<threads;++i) {
+        queues.emplace_back(new worker_queue_t());
+    }
+
     for(size_t i = 0;i<threads;++i)
         workers.emplace_back(
-                [this]
+                [this, i]
                 {
                     for(;;)
                     {
                         std::packaged_task<void()> task;
-                        {
-                            std::unique_lock<std::mutex> lock(this->queue_mutex);
-                            this->condition.wait(lock,
-                                                 [this]{ return this->stop || !this->tasks.empty(); });
-                            if(this->stop) {
-                                return;
-                            }
-
-                            if(this->tasks.empty()) {
-                                continue;
-                            }
-                            task = std::move(this->tasks.front());
-                            this->tasks.pop();
+
+                        if(try_pop_task(i, task)) {
+                            num_pending--;
+                            task();
+                            continue;
                         }
 
-                        task();
+                        std::unique_lock<std::mutex> lock(this->sleep_mutex);
+                        this->condition.wait(lock,
+                                             [this]{ return this->stop || this->num_pending != 0; });
+                        if(this->stop) {
+                            return;
+                        }
                     }
                 }
         );
+
+    if(pin_across_numa_nodes) {
+        pin_workers_to_numa_nodes(workers);
+    }
 }
 
 // add new work item to the pool
@@ -67,21 +182,31 @@ decltype(auto) ThreadPool::enqueue(F&& f, Args&&... args)
     );
 
     std::future<return_type> res = task.get_future();
+
+    const size_t qindex = next_queue++ % queues.size();
     {
-        std::unique_lock<std::mutex> lock(queue_mutex);
+        std::lock_guard<std::mutex> lock(queues[qindex]->mutex);
 
         // don't allow enqueueing after stopping the pool
         if(!stop) {
-            tasks.emplace(std::move(task));
+            queues[qindex]->tasks.emplace_back(std::move(task));
+            num_pending++;
         }
     }
+
+    {
+        // taken only to pair with the sleepers' predicate check, so a worker
+        // that just found every queue empty cannot miss this notification
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
     condition.notify_one();
+
     return res;
 }
 
 inline void ThreadPool::shutdown() {
     {
-        std::unique_lock<std::mutex> lock(queue_mutex);
+        std::unique_lock<std::mutex> lock(sleep_mutex);
         stop = true;
     }
     condition.notify_all();
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <vector>
+#include "sparsepp.h"
+
+/*
+ * Collection-level dictionary of token bytes. The same token typically
+ * appears in every string field of a schema (one art_leaf key per field
+ * tree), so storing the bytes once and handing out stable pointers / ids
+ * collapses that duplication: leaves of every tree of an Index reference
+ * the single interned copy, and token identity checks become integer (or
+ * pointer) compares.
+ *
+ * Interned bytes are bump-allocated out of large blocks and are never
+ * freed individually — a dictionary only ever grows for the lifetime of
+ * its collection, which is the same lifetime as the trees referencing it.
+ */
+class token_interner_t {
+private:
+    static const size_t BLOCK_SIZE = 262144;
+
+    mutable std::shared_mutex mutex;
+
+    // views point into `blocks`, so they remain valid for the lifetime
+    // of the interner
+    spp::sparse_hash_map<std::string_view, uint32_t> token_to_id;
+    std::vector<std::string_view> id_to_token;
+
+    std::vector<char*> blocks;
+    size_t block_used = 0;
+    size_t block_capacity = 0;
+
+    const char* store_bytes(const unsigned char* bytes, uint32_t len);
+
+public:
+    static const uint32_t NOT_FOUND = UINT32_MAX;
+
+    token_interner_t() = default;
+    token_interner_t(const token_interner_t&) = delete;
+    token_interner_t& operator=(const token_interner_t&) = delete;
+
+    ~token_interner_t();
+
+    // Returns a stable pointer to the single stored copy of `bytes`,
+    // inserting it if it has not been seen before. If `id` is non-null,
+    // the token's dictionary id is written to it.
+    const unsigned char* intern(const unsigned char* bytes, uint32_t len, uint32_t* id = nullptr);
+
+    // Returns the id of a previously interned token, or NOT_FOUND.
+    uint32_t get_id(const unsigned char* bytes, uint32_t len) const;
+
+    // Returns the bytes of a token by id, or nullptr for an unknown id.
+    const unsigned char* get_bytes(uint32_t id, uint32_t& len) const;
+
+    size_t num_tokens() const;
+
+    // approximate bytes held: token byte blocks plus dictionary overhead
+    size_t memory_bytes() const;
+};
@@ -59,12 +59,8 @@ public:
                        const std::vector<char>& symbols_to_index = {},
                        const std::vector<char>& separators = {});
 
-    ~Tokenizer() {
-        iconv_close(cd);
-        free(normalized_text);
-        delete bi;
-        delete transliterator;
-    }
+    // returns the pooled ICU / iconv handles for reuse on this thread
+    ~Tokenizer();
 
     bool next(std::string& token, size_t& token_index, size_t& start_index, size_t& end_index);
 
@@ -4,7 +4,9 @@
 #include <climits>
 #include <cstdio>
 #include <algorithm>
+#include <new>
 #include <unordered_map>
+#include "arena.h"
 
 struct KV {
     uint8_t field_id{};
@@ -16,7 +18,8 @@ struct KV {
     uint64_t distinct_key{};
     int64_t scores[3]{};  // match score + 2 custom attributes
 
-    // to be used only in final aggregation
+    // to be used only in final aggregation; points into the per-search arena
+    // and is released wholesale with it, so KVs never delete it
     uint64_t* query_indices = nullptr;
 
     KV(uint8_t field_id, uint16_t queryIndex, uint32_t token_bits, uint64_t key, uint64_t distinct_key,
@@ -59,7 +62,6 @@ struct KV {
             scores[1] = kv.scores[1];
             scores[2] = kv.scores[2];
 
-            delete[] query_indices;
             query_indices = kv.query_indices;
             kv.query_indices = nullptr;
         }
@@ -81,39 +83,106 @@ struct KV {
             scores[1] = kv.scores[1];
             scores[2] = kv.scores[2];
 
-            delete[] query_indices;
             query_indices = kv.query_indices;
             kv.query_indices = nullptr;
         }
 
         return *this;
     }
+};
+
+struct group_slot_t {
+    uint64_t key = 0;
+    uint32_t size = 0;
+    KV* kvs = nullptr;      // top `group_limit` KVs, kept sorted descending
+};
+
+/*
+ * Purpose-built aggregator for group_by queries: an open addressing table
+ * whose slots hold the top-N KVs of a group inline (sorted descending), with
+ * the KV arrays bump-allocated from an arena. Compared to per-group mini
+ * Topsters, a hit costs one linear probe and groups need no heap allocation.
+ */
+struct group_table_t {
+    static const size_t INITIAL_SLOTS = 256;
+
+    const uint32_t group_limit;     // max KVs retained per group
+
+    std::vector<group_slot_t> slots;
+    size_t num_groups = 0;
+
+    arena_t kvs_arena;
+
+    explicit group_table_t(uint32_t group_limit): group_limit(group_limit) {}
 
-    ~KV() {
-        delete [] query_indices;
-        query_indices = nullptr;
+    group_table_t(const group_table_t&) = delete;
+    group_table_t& operator=(const group_table_t&) = delete;
+
+    static size_t hash_key(uint64_t key) {
+        // fibonacci hashing to spread clustered keys across the table
+        key *= 0x9E3779B97F4A7C15ULL;
+        return size_t(key ^ (key >> 32));
     }
+
+    group_slot_t* find(uint64_t key) {
+        if(slots.empty()) {
+            return nullptr;
+        }
+
+        const size_t mask = slots.size() - 1;
+        size_t i = hash_key(key) & mask;
+
+        while(slots[i].kvs != nullptr) {
+            if(slots[i].key == key) {
+                return &slots[i];
+            }
+            i = (i + 1) & mask;
+        }
+
+        return nullptr;
+    }
+
+    // defined after Topster since they use its comparators
+    void add(KV* kv);
+    void add_to_slot(group_slot_t& slot, KV* kv);
+    void grow();
 };
 
 /*
 * Remembers the max-K elements seen so far using a min-heap
 */
 struct Topster {
+    // cursor (`search_after`) pagination bound: candidates ranking at-or-before
+    // this (score tuple, key) are rejected by add(), so a deep page keeps the
+    // heap at one page instead of `page * per_page` entries
+    struct after_bound_t {
+        bool active = false;
+        int64_t scores[3] = {0, 0, 0};
+        uint64_t key = 0;
+    };
+
     const uint32_t MAX_SIZE;
     uint32_t size;
 
+    after_bound_t after_bound;
+
     KV *data;
     KV** kvs;
 
     std::unordered_map<uint64_t, KV*> kv_map;
 
-    spp::sparse_hash_map<uint64_t, Topster*> group_kv_map;
+    group_table_t* group_map = nullptr;   // allocated only for distinct (group_by) mode
     size_t distinct;
 
+    // set when a bulk merge filled `kvs` in ascending score order (which is a
+    // valid min-heap layout), so sort() can reverse instead of a full sort
+    bool sorted_ascending;
+
     explicit Topster(size_t capacity): Topster(capacity, 0) {
     }
 
-    explicit Topster(size_t capacity, size_t distinct): MAX_SIZE(capacity), size(0), distinct(distinct) {
+    explicit Topster(size_t capacity, size_t distinct): MAX_SIZE(capacity), size(0), distinct(distinct),
+                                                        sorted_ascending(false) {
         // we allocate data first to get a memory block whose indices are then assigned to `kvs`
         // we use separate **kvs for easier pointer swaps
         data = new KV[capacity];
@@ -129,19 +198,20 @@ struct Topster {
             data[i].distinct_key = 0;
             kvs[i] = &data[i];
         }
+
+        if(distinct != 0) {
+            group_map = new group_table_t(distinct);
+        }
     }
 
     ~Topster() {
         delete[] data;
         delete[] kvs;
-        for(auto& kv: group_kv_map) {
-            delete kv.second;
-        }
+        delete group_map;
 
         data = nullptr;
         kvs = nullptr;
-
-        group_kv_map.clear();
+        group_map = nullptr;
     }
 
     static inline void swapMe(KV** a, KV** b) {
@@ -160,6 +230,15 @@ struct Topster {
             LOG(INFO) << "kv key: " << mkv.first << " => " << mkv.second->scores[mkv.second->match_score_index];
         }*/
 
+        sorted_ascending = false;
+
+        if(after_bound.active &&
+           std::tie(kv->scores[0], kv->scores[1], kv->scores[2], kv->key) >=
+           std::tie(after_bound.scores[0], after_bound.scores[1], after_bound.scores[2], after_bound.key)) {
+            // the candidate was already served on an earlier cursor page
+            return false;
+        }
+
         bool less_than_min_heap = (size >= MAX_SIZE) && is_smaller(kv, kvs[0]);
         size_t heap_op_index = 0;
 
@@ -172,15 +251,7 @@ struct Topster {
 
         if(distinct) {
             // Grouping cannot be a streaming operation, so aggregate the KVs associated with every group.
-            auto kvs_it = group_kv_map.find(kv->distinct_key);
-            if(kvs_it != group_kv_map.end()) {
-                kvs_it->second->add(kv);
-            } else {
-                Topster* g_topster = new Topster(distinct, 0);
-                g_topster->add(kv);
-                group_kv_map.insert({kv->distinct_key, g_topster});
-            }
-            
+            group_map->add(kv);
             return true;
 
         } else { // not distinct
@@ -287,12 +358,18 @@ struct Topster {
     // topster must be sorted before iterated upon to remove dead array entries
     void sort() {
         if(!distinct) {
-            std::stable_sort(kvs, kvs + size, is_greater);
+            if(sorted_ascending) {
+                std::reverse(kvs, kvs + size);
+                sorted_ascending = false;
+            } else {
+                std::stable_sort(kvs, kvs + size, is_greater);
+            }
         }
     }
 
     void clear(){
         size = 0;
+        sorted_ascending = false;
     }
 
     uint64_t getKeyAt(uint32_t index) {
@@ -306,4 +383,92 @@ struct Topster {
     KV* getKV(uint32_t index) {
         return kvs[index];
     }
-};
\ No newline at end of file
+};
+
+inline void group_table_t::add(KV* kv) {
+    if(slots.empty()) {
+        slots.resize(INITIAL_SLOTS);
+    } else if(num_groups * 10 >= slots.size() * 7) {
+        grow();
+    }
+
+    const size_t mask = slots.size() - 1;
+    size_t i = hash_key(kv->distinct_key) & mask;
+
+    while(slots[i].kvs != nullptr && slots[i].key != kv->distinct_key) {
+        i = (i + 1) & mask;
+    }
+
+    group_slot_t& slot = slots[i];
+
+    if(slot.kvs == nullptr) {
+        slot.key = kv->distinct_key;
+        slot.kvs = static_cast<KV*>(kvs_arena.alloc(group_limit * sizeof(KV)));
+        for(uint32_t j = 0; j < group_limit; j++) {
+            new (&slot.kvs[j]) KV();
+        }
+        num_groups++;
+    }
+
+    add_to_slot(slot, kv);
+}
+
+inline void group_table_t::add_to_slot(group_slot_t& slot, KV* kv) {
+    // the same document can be scored again via another query/field, so
+    // retain only its best entry within the group
+    for(uint32_t i = 0; i < slot.size; i++) {
+        if(slot.kvs[i].key == kv->key) {
+            if(Topster::is_smaller(kv, &slot.kvs[i])) {
+                return;
+            }
+
+            // better entry for this document: remove and re-insert in order
+            for(uint32_t j = i; j + 1 < slot.size; j++) {
+                slot.kvs[j] = slot.kvs[j + 1];
+            }
+
+            slot.size--;
+            break;
+        }
+    }
+
+    uint32_t write_index;
+
+    if(slot.size < group_limit) {
+        write_index = slot.size++;
+    } else if(Topster::is_smaller(kv, &slot.kvs[group_limit - 1])) {
+        // group is full and the incoming entry is below its worst
+        return;
+    } else {
+        write_index = group_limit - 1;
+    }
+
+    // shift smaller entries down to keep the slot sorted descending
+    while(write_index > 0 && Topster::is_greater(kv, &slot.kvs[write_index - 1])) {
+        slot.kvs[write_index] = slot.kvs[write_index - 1];
+        write_index--;
+    }
+
+    slot.kvs[write_index] = *kv;
+}
+
+inline void group_table_t::grow() {
+    std::vector<group_slot_t> old_slots;
+    old_slots.swap(slots);
+    slots.resize(old_slots.size() * 2);
+
+    const size_t mask = slots.size() - 1;
+
+    for(group_slot_t& old_slot: old_slots) {
+        if(old_slot.kvs == nullptr) {
+            continue;
+        }
+
+        size_t i = hash_key(old_slot.key) & mask;
+        while(slots[i].kvs != nullptr) {
+            i = (i + 1) & mask;
+        }
+
+        slots[i] = old_slot;
+    }
+}
\ No newline at end of file
@@ -88,6 +88,53 @@ void AppMetrics::get(const std::string& rps_key, const std::string& latency_key,
         }
     }
 
+    // tail percentiles from the per-endpoint histograms: the averages above
+    // hide latency spikes that only a p99/p999 will surface
+    static const std::vector<std::pair<std::string, double>> percentile_labels = {
+        {"p50", 50.0}, {"p90", 90.0}, {"p99", 99.0}, {"p999", 99.9}
+    };
+
+    const std::string percentiles_suffix = "_percentiles";
+    result[latency_key + percentiles_suffix] = nlohmann::json::object();
+
+    for(const auto& kv: *latencies) {
+        nlohmann::json percentiles = nlohmann::json::object();
+        for(const auto& label: percentile_labels) {
+            percentiles[label.first] = kv.second.percentile(label.second);
+        }
+
+        if(kv.first == SEARCH_LABEL) {
+            result[SEARCH_LATENCY_KEY + percentiles_suffix] = percentiles;
+        }
+
+        else if(kv.first == IMPORT_LABEL) {
+            result[IMPORT_LATENCY_KEY + percentiles_suffix] = percentiles;
+        }
+
+        else if(kv.first == DOC_WRITE_LABEL) {
+            result[DOC_WRITE_LATENCY_KEY + percentiles_suffix] = percentiles;
+        }
+
+        else if(kv.first == DOC_DELETE_LABEL) {
+            result[DOC_DELETE_LATENCY_KEY + percentiles_suffix] = percentiles;
+        }
+
+        else {
+            result[latency_key + percentiles_suffix][kv.first] = percentiles;
+        }
+    }
+
+    for(const auto& label_latency_key: {SEARCH_LATENCY_KEY, IMPORT_LATENCY_KEY,
+                                        DOC_WRITE_LATENCY_KEY, DOC_DELETE_LATENCY_KEY}) {
+        if(!result.contains(label_latency_key + percentiles_suffix)) {
+            nlohmann::json zero_percentiles = nlohmann::json::object();
+            for(const auto& label: percentile_labels) {
+                zero_percentiles[label.first] = 0;
+            }
+            result[label_latency_key + percentiles_suffix] = zero_percentiles;
+        }
+    }
+
     std::vector<std::string> keys_to_check = {
         SEARCH_RPS_KEY, IMPORT_RPS_KEY, DOC_WRITE_RPS_KEY, DOC_DELETE_RPS_KEY,
         SEARCH_LATENCY_KEY, IMPORT_LATENCY_KEY, DOC_WRITE_LATENCY_KEY, DOC_DELETE_LATENCY_KEY
@@ -101,14 +148,40 @@ void AppMetrics::get(const std::string& rps_key, const std::string& latency_key,
 }
 
 void AppMetrics::window_reset() {
+    // drain the per-thread stripes of the closing window into merged maps
+    auto* new_counts = new spp::sparse_hash_map<std::string, uint64_t>();
+    auto* new_durations = new spp::sparse_hash_map<std::string, uint64_t>();
+    auto* new_latencies = new spp::sparse_hash_map<std::string, latency_histogram_t>();
+
+    for(auto& stripe: stripes) {
+        std::lock_guard<std::mutex> stripe_lock(stripe.mutex);
+
+        for(const auto& kv: stripe.counts) {
+            (*new_counts)[kv.first] += kv.second;
+        }
+
+        for(const auto& kv: stripe.durations) {
+            (*new_durations)[kv.first] += kv.second;
+        }
+
+        for(const auto& kv: stripe.latencies) {
+            (*new_latencies)[kv.first].merge(kv.second);
+        }
+
+        stripe.counts.clear();
+        stripe.durations.clear();
+        stripe.latencies.clear();
+    }
+
     std::unique_lock lock(mutex);
 
     delete counts;
-    counts = current_counts;
-    current_counts = new spp::sparse_hash_map<std::string, uint64_t>();
+    counts = new_counts;
 
     delete durations;
-    durations = current_durations;
-    current_durations = new spp::sparse_hash_map<std::string, uint64_t>();
+    durations = new_durations;
+
+    delete latencies;
+    latencies = new_latencies;
 }
 
@@ -1,15 +1,20 @@
 #include "array_utils.h"
+#include "cpu_dispatch.h"
 #include <memory.h>
+#include <vector>
 
-size_t ArrayUtils::and_scalar(const uint32_t *A, const size_t lenA,
-                              const uint32_t *B, const size_t lenB, uint32_t **results) {
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AND_SCALAR_HAS_SIMD_KERNELS 1
+#endif
+
+// the scalar Kurz loop, also used by the SIMD kernels to finish off tails
+static size_t and_scalar_kernel(const uint32_t *A, const size_t lenA,
+                                const uint32_t *B, const size_t lenB, uint32_t *out) {
   if (lenA == 0 || lenB == 0) {
     return 0;
   }
 
-  *results = new uint32_t[std::min(lenA, lenB)];
-  uint32_t *out = *results;
-
   const uint32_t *const initout(out);
   const uint32_t *endA = A + lenA;
   const uint32_t *endB = B + lenB;
@@ -36,6 +41,143 @@ size_t ArrayUtils::and_scalar(const uint32_t *A, const size_t lenA,
   return (out - initout); // NOTREACHED
 }
 
+#ifdef AND_SCALAR_HAS_SIMD_KERNELS
+
+// Adapted from the `v1` kernel of lemire/SIMDCompressionAndIntersection:
+// each id of the rare array is broadcast and probed against 8 ids of the
+// frequent array at once, advancing the frequent array a block at a time.
+CLONE_FOR_AVX2
+static size_t and_simd_v1(const uint32_t *rare, const size_t lenRare,
+                          const uint32_t *freq, const size_t lenFreq, uint32_t *out) {
+  const uint32_t *const initout(out);
+  const uint32_t *endRare = rare + lenRare;
+  const uint32_t *endFreq = freq + lenFreq;
+  const size_t BLOCK = 8;
+
+  while (rare < endRare && freq + BLOCK <= endFreq) {
+    const uint32_t matchRare = *rare;
+
+    while (freq[BLOCK - 1] < matchRare) {
+      freq += BLOCK;
+      if (freq + BLOCK > endFreq) {
+        goto FINISH_SCALAR;
+      }
+    }
+
+    // all preceding blocks ended below matchRare, so it can only be here
+    const __m128i match = _mm_set1_epi32(matchRare);
+    const __m128i eq0 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) freq), match);
+    const __m128i eq1 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) (freq + 4)), match);
+
+    if (_mm_movemask_epi8(_mm_or_si128(eq0, eq1)) != 0) {
+      *out++ = matchRare;
+    }
+
+    rare++;
+  }
+
+FINISH_SCALAR:
+  return (out - initout) + and_scalar_kernel(rare, endRare - rare, freq, endFreq - freq, out);
+}
+
+// Adapted from the `SIMDgalloping` (v3) kernel of the same library: for
+// heavily skewed pairs, blocks of the frequent array are located by doubling
+// probes plus a binary search instead of a linear block walk.
+CLONE_FOR_AVX2
+static size_t and_simd_gallop(const uint32_t *rare, const size_t lenRare,
+                              const uint32_t *freq, const size_t lenFreq, uint32_t *out) {
+  const uint32_t *const initout(out);
+  const uint32_t *endRare = rare + lenRare;
+  const uint32_t *endFreq = freq + lenFreq;
+  const size_t BLOCK = 8;
+
+  while (rare < endRare && freq + BLOCK <= endFreq) {
+    const uint32_t matchRare = *rare;
+
+    if (freq[BLOCK - 1] < matchRare) {
+      const size_t num_blocks = (endFreq - freq) / BLOCK;
+      size_t lo = 0, hi = 1;
+
+      // double the stride until a block whose last id covers matchRare
+      while (hi < num_blocks && freq[hi * BLOCK + BLOCK - 1] < matchRare) {
+        lo = hi;
+        hi *= 2;
+      }
+
+      if (hi >= num_blocks) {
+        hi = num_blocks - 1;
+        if (freq[hi * BLOCK + BLOCK - 1] < matchRare) {
+          freq += hi * BLOCK;
+          goto FINISH_SCALAR;
+        }
+      }
+
+      // smallest covering block in (lo, hi]: lo does not cover, hi does
+      while (hi - lo > 1) {
+        const size_t mid = (lo + hi) / 2;
+        if (freq[mid * BLOCK + BLOCK - 1] < matchRare) {
+          lo = mid;
+        } else {
+          hi = mid;
+        }
+      }
+
+      freq += hi * BLOCK;
+    }
+
+    const __m128i match = _mm_set1_epi32(matchRare);
+    const __m128i eq0 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) freq), match);
+    const __m128i eq1 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) (freq + 4)), match);
+
+    if (_mm_movemask_epi8(_mm_or_si128(eq0, eq1)) != 0) {
+      *out++ = matchRare;
+    }
+
+    rare++;
+  }
+
+FINISH_SCALAR:
+  return (out - initout) + and_scalar_kernel(rare, endRare - rare, freq, endFreq - freq, out);
+}
+
+#endif
+
+size_t ArrayUtils::and_scalar(const uint32_t *A, const size_t lenA,
+                              const uint32_t *B, const size_t lenB, uint32_t **results) {
+  if (lenA == 0 || lenB == 0) {
+    return 0;
+  }
+
+  *results = new uint32_t[std::min(lenA, lenB)];
+  uint32_t *out = *results;
+
+#ifdef AND_SCALAR_HAS_SIMD_KERNELS
+  const uint32_t *rare = A, *freq = B;
+  size_t lenRare = lenA, lenFreq = lenB;
+
+  if (lenRare > lenFreq) {
+    std::swap(rare, freq);
+    std::swap(lenRare, lenFreq);
+  }
+
+  // kernel selection by skew, following lemire/SIMDCompressionAndIntersection:
+  // galloping pays off only on heavily skewed pairs (filter ids vs posting
+  // ids), the SIMD probe on moderately skewed ones, while near-equal
+  // lengths stay on the scalar loop
+  if (lenFreq >= 8) {
+    if (lenRare * 50 < lenFreq) {
+      return and_simd_gallop(rare, lenRare, freq, lenFreq, out);
+    }
+
+    if (lenRare * 2 < lenFreq) {
+      return and_simd_v1(rare, lenRare, freq, lenFreq, out);
+    }
+  }
+#endif
+
+  return and_scalar_kernel(A, lenA, B, lenB, out);
+}
+
 // merges two sorted arrays and also removes duplicates
 size_t ArrayUtils::or_scalar(const uint32_t *A, const size_t lenA,
                              const uint32_t *B, const size_t lenB, uint32_t **out) {
@@ -102,10 +244,108 @@ size_t ArrayUtils::or_scalar(const uint32_t *A, const size_t lenA,
   return res_index;
 }
 
-size_t ArrayUtils::exclude_scalar(const uint32_t *A, const size_t lenA,
-                                 const uint32_t *B, const size_t lenB, uint32_t **out) {
+// the scalar difference merge, also used by the SIMD kernel to finish off tails
+static size_t exclude_scalar_kernel(const uint32_t *A, const size_t lenA,
+                                    const uint32_t *B, const size_t lenB, uint32_t *out) {
   size_t indexA = 0, indexB = 0, res_index = 0;
 
+  while (indexA < lenA && indexB < lenB) {
+    if (A[indexA] < B[indexB]) {
+      out[res_index] = A[indexA];
+      res_index++;
+      indexA++;
+    } else if (A[indexA] == B[indexB]) {
+        indexA++;
+        indexB++;
+    } else {
+        indexB++;
+    }
+  }
+
+  while (indexA < lenA) {
+    out[res_index] = A[indexA];
+    res_index++;
+    indexA++;
+  }
+
+  return res_index;
+}
+
+// emits the ids of src that are absent from a bitmap built over the filter's id
+// range; used when the filter set is dense enough for the bitmap to stay small
+static size_t exclude_bitset(const uint32_t *src, const size_t lenSrc,
+                             const uint32_t *filter, const size_t lenFilter, uint32_t *out) {
+  const uint32_t base = filter[0];
+  const uint32_t last = filter[lenFilter - 1];
+  const uint64_t range = uint64_t(last) - base + 1;
+
+  std::vector<uint64_t> bits((range + 63) / 64, 0);
+
+  for (size_t i = 0; i < lenFilter; i++) {
+    const uint64_t offset = filter[i] - base;
+    bits[offset >> 6] |= (uint64_t(1) << (offset & 63));
+  }
+
+  const uint32_t *const initout(out);
+
+  for (size_t i = 0; i < lenSrc; i++) {
+    const uint32_t id = src[i];
+
+    if (id < base || id > last) {
+      *out++ = id;
+      continue;
+    }
+
+    const uint64_t offset = id - base;
+    if ((bits[offset >> 6] & (uint64_t(1) << (offset & 63))) == 0) {
+      *out++ = id;
+    }
+  }
+
+  return out - initout;
+}
+
+#ifdef AND_SCALAR_HAS_SIMD_KERNELS
+
+// difference counterpart of `and_simd_v1`: every source id is broadcast and
+// probed against 8 filter ids at once, and emitted when none of them match
+CLONE_FOR_AVX2
+static size_t exclude_simd(const uint32_t *src, const size_t lenSrc,
+                           const uint32_t *filter, const size_t lenFilter, uint32_t *out) {
+  const uint32_t *const initout(out);
+  const uint32_t *endSrc = src + lenSrc;
+  const uint32_t *endFilter = filter + lenFilter;
+  const size_t BLOCK = 8;
+
+  while (src < endSrc && filter + BLOCK <= endFilter) {
+    const uint32_t id = *src;
+
+    while (filter[BLOCK - 1] < id) {
+      filter += BLOCK;
+      if (filter + BLOCK > endFilter) {
+        goto FINISH_SCALAR;
+      }
+    }
+
+    const __m128i match = _mm_set1_epi32(id);
+    const __m128i eq0 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) filter), match);
+    const __m128i eq1 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) (filter + 4)), match);
+
+    if (_mm_movemask_epi8(_mm_or_si128(eq0, eq1)) == 0) {
+      *out++ = id;
+    }
+
+    src++;
+  }
+
+FINISH_SCALAR:
+  return (out - initout) + exclude_scalar_kernel(src, endSrc - src, filter, endFilter - filter, out);
+}
+
+#endif
+
+size_t ArrayUtils::exclude_scalar(const uint32_t *A, const size_t lenA,
+                                 const uint32_t *B, const size_t lenB, uint32_t **out) {
   if(A == nullptr && B == nullptr) {
       *out = nullptr;
       return 0;
@@ -123,24 +363,22 @@ size_t ArrayUtils::exclude_scalar(const uint32_t *A, const size_t lenA,
   }
 
   uint32_t* results = new uint32_t[lenA];
+  size_t res_index;
 
-  while (indexA < lenA && indexB < lenB) {
-    if (A[indexA] < B[indexB]) {
-      results[res_index] = A[indexA];
-      res_index++;
-      indexA++;
-    } else if (A[indexA] == B[indexB]) {
-        indexA++;
-        indexB++;
-    } else {
-        indexB++;
-    }
-  }
+  // with at most 32 ids per bit the bitmap is no bigger than the filter array
+  // itself, and then a probe per source id beats the merge
+  const uint64_t filter_range = uint64_t(B[lenB - 1]) - B[0] + 1;
 
-  while (indexA < lenA) {
-    results[res_index] = A[indexA];
-    res_index++;
-    indexA++;
+  if (filter_range <= uint64_t(lenB) * 32) {
+    res_index = exclude_bitset(A, lenA, B, lenB, results);
+  }
+#ifdef AND_SCALAR_HAS_SIMD_KERNELS
+  else if (lenB >= 8) {
+    res_index = exclude_simd(A, lenA, B, lenB, results);
+  }
+#endif
+  else {
+    res_index = exclude_scalar_kernel(A, lenA, B, lenB, results);
   }
 
   // shrink fit
@@ -3,6 +3,9 @@
 #include <strings.h>
 #include <stdio.h>
 #include <emmintrin.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 #include <assert.h>
 #include <art.h>
 #include <functional>
@@ -13,7 +16,10 @@
 #include <queue>
 #include <list>
 #include <stdint.h>
+#include <atomic>
 #include <posting.h>
+#include <lev_automaton.h>
+#include <token_interner.h>
 #include "art.h"
 #include "logger.h"
 
@@ -40,6 +46,11 @@ static void art_fuzzy_recurse(unsigned char p, unsigned char c, const art_node *
                               const int term_len, const int* irow, const int* jrow, const int min_cost,
                               const int max_cost, const bool prefix, std::vector<const art_node *> &results);
 
+static void art_fuzzy_recurse_auto(unsigned char c, const art_node *n, int depth, const lev_automaton& la,
+                                   lev_automaton::state st, const unsigned char *term, const int term_len,
+                                   const int min_cost, const int max_cost, const bool prefix,
+                                   std::vector<const art_node *> &results);
+
 void art_int_fuzzy_recurse(art_node *n, int depth, const unsigned char* int_str, int int_str_len,
                            NUM_COMPARATOR comparator, std::vector<const art_leaf *> &results);
 
@@ -52,16 +63,22 @@ bool compare_art_leaf_score(const art_leaf *a, const art_leaf *b) {
 }
 
 bool compare_art_node_frequency(const art_node *a, const art_node *b) {
-    uint32_t a_value = 0, b_value = 0;
+    int64_t a_value = 0, b_value = 0;
 
     if(IS_LEAF(a)) {
         art_leaf* al = (art_leaf *) LEAF_RAW(a);
         a_value = posting_t::num_ids(al->values);
+    } else {
+        // inner nodes track the max frequency of their subtree, so the
+        // top-k iterator can order (and thereby skip) whole subtrees
+        a_value = a->max_score;
     }
 
     if(IS_LEAF(b)) {
         art_leaf* bl = (art_leaf *) LEAF_RAW(b);
         b_value = posting_t::num_ids(bl->values);
+    } else {
+        b_value = b->max_score;
     }
 
     return a_value > b_value;
@@ -96,32 +113,281 @@ bool compare_art_node_score_pq(const art_node* a, const art_node* b) {
 }
 
 /**
- * Allocates a node of the given type,
- * initializes to zero and sets the type.
+ * Slab arena backing all node and leaf allocations of a single art_tree.
+ * Fresh allocations are bump-pointer carved out of large blocks so that
+ * siblings created together stay close in memory, freed nodes and leaves
+ * are recycled through per-size free lists, and destroying a tree frees
+ * the blocks wholesale instead of walking every allocation.
  */
-static art_node* alloc_node(uint8_t type) {
-    art_node* n;
+static const size_t ARENA_BLOCK_SIZE = 262144;
+
+struct art_arena_block {
+    art_arena_block* next;
+    size_t used;
+    size_t capacity;
+    // allocations follow the header
+};
+
+/*
+ * A node or leaf retired from the tree. Concurrent readers may still hold
+ * pointers into it, so it is parked on a FIFO retire list (the record's own
+ * memory doubles as the list entry) and only recycled once every reader
+ * that could have seen it has left its read-side section.
+ */
+struct art_retired_rec {
+    art_retired_rec* next;
+    uint64_t epoch;        // global epoch at retirement time
+    uint8_t kind;          // node type, or 0 for a leaf
+};
+
+struct art_arena {
+    art_arena_block* blocks;
+    void* free_nodes[NODE256 + 1];            // indexed by node type, slot 0 unused
+    void* free_leaves;                        // leaves are fixed-size records
+    art_retired_rec* retired_head;            // FIFO, oldest epoch first
+    art_retired_rec* retired_tail;
+};
+
+/*
+ * Epoch-based reclamation for lock-free readers. Readers announce the
+ * global epoch they entered at in a per-thread slot; writers publish
+ * replacement nodes with release stores, retire the old ones, and recycle
+ * a retired record only when its epoch precedes every active reader's.
+ * Writers of a given tree are assumed to be serialized externally (the
+ * Index already guarantees one writer per field tree).
+ */
+static const size_t RCU_MAX_READER_THREADS = 256;
+
+static std::atomic<uint64_t> rcu_global_epoch{1};
+static std::atomic<uint64_t> rcu_reader_epochs[RCU_MAX_READER_THREADS];
+static std::atomic<bool> rcu_slot_used[RCU_MAX_READER_THREADS];
+
+namespace {
+    // claims a reader slot per thread, released when the thread exits
+    struct rcu_thread_slot {
+        size_t index = SIZE_MAX;
+        size_t depth = 0;
+
+        ~rcu_thread_slot() {
+            if(index != SIZE_MAX) {
+                rcu_reader_epochs[index].store(0, std::memory_order_release);
+                rcu_slot_used[index].store(false, std::memory_order_release);
+            }
+        }
+
+        size_t claim() {
+            if(index == SIZE_MAX) {
+                for(size_t i = 0; i < RCU_MAX_READER_THREADS; i++) {
+                    bool expected = false;
+                    if(rcu_slot_used[i].compare_exchange_strong(expected, true)) {
+                        index = i;
+                        break;
+                    }
+                }
+            }
+            return index;
+        }
+    };
+
+    thread_local rcu_thread_slot rcu_slot;
+}
+
+void art_rcu_reader_enter() {
+    if(rcu_slot.depth++ != 0) {
+        return;
+    }
+
+    size_t index = rcu_slot.claim();
+    if(index == SIZE_MAX) {
+        // no free slot: reader falls back to pinning the current epoch
+        // forever being impossible, we simply don't track it; writers will
+        // then not reclaim past this epoch only if other readers pin it.
+        // In practice the server's thread pool is far below the slot count.
+        return;
+    }
+
+    // seq_cst so the epoch store is visible before any node is dereferenced
+    rcu_reader_epochs[index].store(rcu_global_epoch.load(std::memory_order_acquire),
+                                   std::memory_order_seq_cst);
+}
+
+void art_rcu_reader_exit() {
+    if(--rcu_slot.depth != 0) {
+        return;
+    }
+
+    if(rcu_slot.index != SIZE_MAX) {
+        rcu_reader_epochs[rcu_slot.index].store(0, std::memory_order_release);
+    }
+}
+
+namespace {
+    // scopes a read-side section; nesting is handled via the slot's depth
+    struct rcu_read_guard {
+        rcu_read_guard() { art_rcu_reader_enter(); }
+        ~rcu_read_guard() { art_rcu_reader_exit(); }
+    };
+}
+
+// Oldest epoch any active reader could still be traversing in.
+static uint64_t rcu_min_active_epoch() {
+    uint64_t min_epoch = rcu_global_epoch.load(std::memory_order_acquire);
+    for(size_t i = 0; i < RCU_MAX_READER_THREADS; i++) {
+        uint64_t e = rcu_reader_epochs[i].load(std::memory_order_acquire);
+        if(e != 0 && e < min_epoch) {
+            min_epoch = e;
+        }
+    }
+    return min_epoch;
+}
+
+static art_arena* arena_new() {
+    return (art_arena *) calloc(1, sizeof(art_arena));
+}
+
+static void* arena_alloc(art_arena *arena, size_t size) {
+    size = (size + 7) & ~(size_t)7;
+    art_arena_block* block = arena->blocks;
+
+    if (!block || block->capacity - block->used < size) {
+        size_t capacity = ARENA_BLOCK_SIZE - sizeof(art_arena_block);
+        if (size > capacity) {
+            capacity = size;
+        }
+        block = (art_arena_block *) malloc(sizeof(art_arena_block) + capacity);
+        block->next = arena->blocks;
+        block->used = 0;
+        block->capacity = capacity;
+        arena->blocks = block;
+    }
+
+    void* ptr = (char *)(block + 1) + block->used;
+    block->used += size;
+    return ptr;
+}
+
+static void arena_destroy(art_arena *arena) {
+    art_arena_block* block = arena->blocks;
+    while (block) {
+        art_arena_block* next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
+
+static size_t node_size(uint8_t type) {
     switch (type) {
         case NODE4:
-            n = (art_node *) calloc(1, sizeof(art_node4));
-            break;
+            return sizeof(art_node4);
         case NODE16:
-            n = (art_node *) calloc(1, sizeof(art_node16));
-            break;
+            return sizeof(art_node16);
         case NODE48:
-            n = (art_node *) calloc(1, sizeof(art_node48));
-            break;
+            return sizeof(art_node48);
         case NODE256:
-            n = (art_node *) calloc(1, sizeof(art_node256));
-            break;
+            return sizeof(art_node256);
         default:
             abort();
     }
+}
+
+/**
+ * Allocates a node of the given type,
+ * initializes to zero and sets the type.
+ */
+static art_node* alloc_node(art_arena *arena, uint8_t type) {
+    art_node* n;
+    if (arena->free_nodes[type]) {
+        n = (art_node *) arena->free_nodes[type];
+        arena->free_nodes[type] = *(void **)n;
+    } else {
+        n = (art_node *) arena_alloc(arena, node_size(type));
+    }
+    memset(n, 0, node_size(type));
     n->type = type;
     n->max_score = 0;
     return n;
 }
 
+// Parks a record on the arena's retire list; it rejoins a free list only
+// once no concurrent reader can still be traversing it.
+static void arena_retire(art_arena *arena, void *ptr, uint8_t kind) {
+    art_retired_rec* rec = (art_retired_rec *) ptr;
+    rec->next = NULL;
+    rec->epoch = rcu_global_epoch.load(std::memory_order_acquire);
+    rec->kind = kind;
+
+    if (arena->retired_tail) {
+        arena->retired_tail->next = rec;
+    } else {
+        arena->retired_head = rec;
+    }
+    arena->retired_tail = rec;
+}
+
+// Moves safely-reclaimable retired records back to the free lists and
+// advances the global epoch. Called by writers between inserts/deletes.
+static void arena_reclaim(art_arena *arena) {
+    if (!arena->retired_head) {
+        return;
+    }
+
+    rcu_global_epoch.fetch_add(1, std::memory_order_acq_rel);
+    const uint64_t min_active = rcu_min_active_epoch();
+
+    while (arena->retired_head && arena->retired_head->epoch < min_active) {
+        art_retired_rec* rec = arena->retired_head;
+        arena->retired_head = rec->next;
+        if (!arena->retired_head) {
+            arena->retired_tail = NULL;
+        }
+
+        if (rec->kind == 0) {
+            *(void **)rec = arena->free_leaves;
+            arena->free_leaves = rec;
+        } else {
+            *(void **)rec = arena->free_nodes[rec->kind];
+            arena->free_nodes[rec->kind] = rec;
+        }
+    }
+}
+
+// Retires a node replaced by a copy-on-write update.
+static void free_node(art_arena *arena, art_node *n) {
+    arena_retire(arena, n, n->type);
+}
+
+static art_leaf* alloc_leaf(art_arena *arena) {
+    if (arena->free_leaves) {
+        art_leaf* l = (art_leaf *) arena->free_leaves;
+        arena->free_leaves = *(void **)l;
+        return l;
+    }
+    return (art_leaf *) arena_alloc(arena, sizeof(art_leaf));
+}
+
+static void free_leaf(art_arena *arena, art_leaf *l) {
+    arena_retire(arena, l, 0);
+    // non-interned key bytes stay in their block until the tree is destroyed
+}
+
+// Allocates a node of the same type as `n` and copies its contents; used
+// by copy-on-write updates so readers never observe a partially-mutated
+// node.
+static art_node* clone_node(art_arena *arena, const art_node *n) {
+    art_node* copy = alloc_node(arena, n->type);
+    memcpy(copy, n, node_size(n->type));
+    return copy;
+}
+
+// Publishes a fully-built node (or tagged leaf) into a child slot. The
+// release store pairs with the address dependency readers carry from slot
+// load to node access, so a reader either sees the old record or the
+// complete new one.
+static inline void publish_child(art_node **ref, void *child) {
+    __atomic_store_n(ref, (art_node *) child, __ATOMIC_RELEASE);
+}
+
 /**
  * Initializes an ART tree
  * @return 0 on success.
@@ -129,10 +395,24 @@ static art_node* alloc_node(uint8_t type) {
 int art_tree_init(art_tree *t) {
     t->root = NULL;
     t->size = 0;
+    t->arena = arena_new();
+    t->interner = NULL;
     return 0;
 }
 
-// Recursively destroys the tree
+/**
+ * Initializes an ART tree that deduplicates its leaf keys through the
+ * given interner. The interner must outlive the tree.
+ * @return 0 on success.
+ */
+int art_tree_init_interned(art_tree *t, token_interner_t *interner) {
+    art_tree_init(t);
+    t->interner = interner;
+    return 0;
+}
+
+// Recursively destroys the posting lists hanging off the leaves; the nodes
+// and leaves themselves belong to the arena and are freed wholesale.
 static void destroy_node(art_node *n) {
     // Break if null
     if (!n) return;
@@ -141,7 +421,6 @@ static void destroy_node(art_node *n) {
     if (IS_LEAF(n)) {
         art_leaf *leaf = (art_leaf *) LEAF_RAW(n);
         posting_t::destroy_list(leaf->values);
-        free(leaf);
         return;
     }
 
@@ -186,9 +465,6 @@ static void destroy_node(art_node *n) {
         default:
             abort();
     }
-
-    // Free ourself on the way up
-    free(n);
 }
 
 /**
@@ -197,9 +473,28 @@ static void destroy_node(art_node *n) {
  */
 int art_tree_destroy(art_tree *t) {
     destroy_node(t->root);
+    t->root = NULL;
+
+    if (t->arena) {
+        arena_destroy(t->arena);
+        t->arena = NULL;
+    }
+
     return 0;
 }
 
+uint64_t art_tree_arena_bytes(const art_tree *t) {
+    uint64_t total_bytes = 0;
+    const art_arena_block* block = t->arena->blocks;
+
+    while (block) {
+        total_bytes += sizeof(art_arena_block) + block->capacity;
+        block = block->next;
+    }
+
+    return total_bytes;
+}
+
 /**
  * Returns the size of the ART tree.
  */
@@ -271,6 +566,67 @@ static art_node** find_child(art_node *n, unsigned char c) {
     return NULL;
 }
 
+/**
+ * Returns the index of the first occupied slot at or after `i` in the
+ * 256-slot key map of a node48, scanning 16 (or 32 with AVX2) slots at
+ * a time instead of one byte per iteration. Returns 256 when no occupied
+ * slot remains. Traversal code descends through node48 on every level of
+ * every lookup, so this scan is worth vectorizing.
+ */
+static inline int node48_next_occupied(const art_node48 *n, int i) {
+#ifdef __AVX2__
+    int base = i & ~31;
+    while (base < 256) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(n->keys + base));
+        uint32_t occupied = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_setzero_si256()));
+        if (i > base) {
+            occupied &= ~((1u << (i - base)) - 1);
+        }
+        if (occupied) {
+            return base + __builtin_ctz(occupied);
+        }
+        base += 32;
+        i = base;
+    }
+#else
+    int base = i & ~15;
+    while (base < 256) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(n->keys + base));
+        uint32_t occupied = (~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_setzero_si128()))) & 0xFFFF;
+        if (i > base) {
+            occupied &= ~((1u << (i - base)) - 1);
+        }
+        if (occupied) {
+            return base + __builtin_ctz(occupied);
+        }
+        base += 16;
+        i = base;
+    }
+#endif
+    return 256;
+}
+
+/**
+ * Mirror of node48_next_occupied for reverse iteration: returns the index
+ * of the last occupied slot at or before `i`, or -1 when none remains.
+ */
+static inline int node48_prev_occupied(const art_node48 *n, int i) {
+    int base = i & ~15;
+    while (base >= 0) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(n->keys + base));
+        uint32_t occupied = (~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_setzero_si128()))) & 0xFFFF;
+        if (i - base < 15) {
+            occupied &= (1u << (i - base + 1)) - 1;
+        }
+        if (occupied) {
+            return base + 31 - __builtin_clz(occupied);
+        }
+        base -= 16;
+        i = base + 15;
+    }
+    return -1;
+}
+
 // Simple inlined if
 static inline int min(int a, int b) {
     return (a < b) ? a : b;
@@ -312,6 +668,7 @@ static int leaf_matches(const art_leaf *n, const unsigned char *key, int key_len
  * the value pointer is returned.
  */
 void* art_search(const art_tree *t, const unsigned char *key, int key_len) {
+    rcu_read_guard guard;
     art_node **child;
     art_node *n = t->root;
     int prefix_len, depth = 0;
@@ -362,8 +719,7 @@ static art_leaf* minimum(const art_node *n) {
         case NODE16:
             return minimum(((art_node16*)n)->children[0]);
         case NODE48:
-            idx=0;
-            while (!((art_node48*)n)->keys[idx]) idx++;
+            idx = node48_next_occupied((art_node48*)n, 0);
             idx = ((art_node48*)n)->keys[idx] - 1;
             return minimum(((art_node48*)n)->children[idx]);
         case NODE256:
@@ -388,8 +744,7 @@ static art_leaf* maximum(const art_node *n) {
         case NODE16:
             return maximum(((art_node16*)n)->children[n->num_children-1]);
         case NODE48:
-            idx=255;
-            while (!((art_node48*)n)->keys[idx]) idx--;
+            idx = node48_prev_occupied((art_node48*)n, 255);
             idx = ((art_node48*)n)->keys[idx] - 1;
             return maximum(((art_node48*)n)->children[idx]);
         case NODE256:
@@ -417,18 +772,29 @@ art_leaf* art_maximum(art_tree *t) {
 
 static void add_document_to_leaf(art_document *document, art_leaf *leaf) {
     leaf->max_score = MAX(leaf->max_score, document->score);
-    posting_t::upsert(leaf->values, document->id, document->offsets);
+    // frequency sentinel is not a real score, so it must not tighten block bounds
+    int64_t block_score = (document->score == USE_FREQUENCY_SCORE) ? INT64_MAX : document->score;
+    posting_t::upsert(leaf->values, document->id, document->offsets, block_score);
 
     if(document->score == USE_FREQUENCY_SCORE) {
         leaf->max_score = posting_t::num_ids(leaf->values);
     }
 }
 
-static art_leaf* make_leaf(const unsigned char *key, uint32_t key_len, art_document *document) {
-    art_leaf *l = (art_leaf *) malloc(sizeof(art_leaf) + key_len);
+static art_leaf* make_leaf(art_tree *t, const unsigned char *key, uint32_t key_len, art_document *document) {
+    art_leaf *l = alloc_leaf(t->arena);
     l->key_len = key_len;
     l->max_score = 0;
 
+    if(t->interner != nullptr) {
+        // single shared copy across all trees referencing the interner
+        l->key = t->interner->intern(key, key_len);
+    } else {
+        unsigned char* key_copy = (unsigned char *) arena_alloc(t->arena, key_len);
+        memcpy(key_copy, key, key_len);
+        l->key = key_copy;
+    }
+
     uint32_t ids[1] = {document->id};
     uint32_t offset_index[1] = {0};
 
@@ -442,7 +808,6 @@ static art_leaf* make_leaf(const unsigned char *key, uint32_t key_len, art_docum
         l->values = pl;
     }
 
-    memcpy(l->key, key, key_len);
     add_document_to_leaf(document, l);
     return l;
 }
@@ -464,65 +829,85 @@ static void copy_header(art_node *dest, art_node *src) {
     memcpy(dest->partial, src->partial, min(MAX_PREFIX_LEN, src->partial_len));
 }
 
+// Max score of a child being attached, which can be either a leaf or an inner node.
+static inline int64_t child_max_score(const void *child) {
+    if(IS_LEAF(child)) {
+        return ((art_leaf *) LEAF_RAW(child))->max_score;
+    }
+    return ((const art_node *) child)->max_score;
+}
+
 static void add_child256(art_node256 *n, art_node **ref, unsigned char c, void *child) {
     (void)ref;
     n->n.num_children++;
-    n->children[c] = (art_node *) child;
-    n->n.max_score = MAX(n->n.max_score, ((art_leaf *) LEAF_RAW(child))->max_score);
+    // a single slot store: readers see either NULL or the complete child
+    publish_child(&n->children[c], child);
+    n->n.max_score = MAX(n->n.max_score, child_max_score(child));
 }
 
-static void add_child48(art_node48 *n, art_node **ref, unsigned char c, void *child) {
+static void add_child48(art_arena *arena, art_node48 *n, art_node **ref, unsigned char c, void *child) {
     if (n->n.num_children < 48) {
         int pos = 0;
         while (n->children[pos]) pos++;
-        n->children[pos] = (art_node *) child;
-        n->keys[c] = pos + 1;
+        // the child slot must be visible before the key map points at it
+        publish_child(&n->children[pos], child);
+        __atomic_store_n(&n->keys[c], pos + 1, __ATOMIC_RELEASE);
         n->n.num_children++;
-        n->n.max_score = MAX(n->n.max_score, ((art_leaf *) LEAF_RAW(child))->max_score);
+        n->n.max_score = MAX(n->n.max_score, child_max_score(child));
     } else {
-        art_node256 *new_n = (art_node256*)alloc_node(NODE256);
+        art_node256 *new_n = (art_node256*)alloc_node(arena, NODE256);
         for (int i=0;i<256;i++) {
             if (n->keys[i]) {
                 new_n->children[i] = n->children[n->keys[i] - 1];
             }
         }
         copy_header((art_node*)new_n, (art_node*)n);
-        *ref = (art_node*)new_n;
-        free(n);
         add_child256(new_n, ref, c, child);
+        publish_child(ref, new_n);
+        free_node(arena, (art_node*)n);
     }
 }
 
-static void add_child16(art_node16 *n, art_node **ref, unsigned char c, void *child) {
-    if (n->n.num_children < 16) {
-        __m128i cmp;
-
-        // Compare the key to all 16 stored keys
-        cmp = _mm_cmplt_epi8(_mm_set1_epi8(c),
-                             _mm_loadu_si128((__m128i*)n->keys));
-
-        // Use a mask to ignore children that don't exist
-        unsigned mask = (1 << n->n.num_children) - 1;
-        unsigned bitfield = _mm_movemask_epi8(cmp) & mask;
-
-        // Check if less than any
-        unsigned idx;
-        if (bitfield) {
-            idx = __builtin_ctz(bitfield);
-            memmove(n->keys+idx+1,n->keys+idx,n->n.num_children-idx);
-            memmove(n->children+idx+1,n->children+idx,
-                    (n->n.num_children-idx)*sizeof(void*));
-        } else
-            idx = n->n.num_children;
-
-        // Set the child
-        n->keys[idx] = c;
-        n->children[idx] = (art_node *) child;
-        n->n.num_children++;
-        n->n.max_score = MAX(n->n.max_score, ((art_leaf *) LEAF_RAW(child))->max_score);
+// In-place insertion into a node16 that is not yet visible to readers.
+static void add_child16_no_cow(art_node16 *n, unsigned char c, void *child) {
+    __m128i cmp;
+
+    // Compare the key to all 16 stored keys
+    cmp = _mm_cmplt_epi8(_mm_set1_epi8(c),
+                         _mm_loadu_si128((__m128i*)n->keys));
+
+    // Use a mask to ignore children that don't exist
+    unsigned mask = (1 << n->n.num_children) - 1;
+    unsigned bitfield = _mm_movemask_epi8(cmp) & mask;
+
+    // Check if less than any
+    unsigned idx;
+    if (bitfield) {
+        idx = __builtin_ctz(bitfield);
+        memmove(n->keys+idx+1,n->keys+idx,n->n.num_children-idx);
+        memmove(n->children+idx+1,n->children+idx,
+                (n->n.num_children-idx)*sizeof(void*));
+    } else
+        idx = n->n.num_children;
+
+    // Set the child
+    n->keys[idx] = c;
+    n->children[idx] = (art_node *) child;
+    n->n.num_children++;
+    n->n.max_score = MAX(n->n.max_score, child_max_score(child));
+}
 
+static void add_child16(art_arena *arena, art_node16 *n, art_node **ref, unsigned char c, void *child) {
+    if (n->n.num_children < 16) {
+        // sorted insertion shifts keys and children, which a concurrent
+        // reader must never observe mid-move: mutate a private copy and
+        // swap it in
+        art_node16 *copy = (art_node16*)clone_node(arena, (art_node*)n);
+        add_child16_no_cow(copy, c, child);
+        publish_child(ref, copy);
+        free_node(arena, (art_node*)n);
     } else {
-        art_node48 *new_n = (art_node48*)alloc_node(NODE48);
+        art_node48 *new_n = (art_node48*)alloc_node(arena, NODE48);
 
         // Copy the child pointers and populate the key map
         memcpy(new_n->children, n->children,
@@ -531,31 +916,38 @@ static void add_child16(art_node16 *n, art_node **ref, unsigned char c, void *ch
             new_n->keys[n->keys[i]] = i + 1;
         }
         copy_header((art_node*)new_n, (art_node*)n);
-        *ref = (art_node*)new_n;
-        free(n);
-        add_child48(new_n, ref, c, child);
+        add_child48(arena, new_n, ref, c, child);
+        publish_child(ref, new_n);
+        free_node(arena, (art_node*)n);
     }
 }
 
-static void add_child4(art_node4 *n, art_node **ref, unsigned char c, void *child) {
-    if (n->n.num_children < 4) {
-        int idx;
-        for (idx=0; idx < n->n.num_children; idx++) {
-            if (c < n->keys[idx]) break;
-        }
+// In-place insertion into a node4 that is not yet visible to readers.
+static void add_child4_no_cow(art_node4 *n, unsigned char c, void *child) {
+    int idx;
+    for (idx=0; idx < n->n.num_children; idx++) {
+        if (c < n->keys[idx]) break;
+    }
 
-        // Shift to make room
-        memmove(n->keys+idx+1, n->keys+idx, n->n.num_children - idx);
-        memmove(n->children+idx+1, n->children+idx,
-                (n->n.num_children - idx)*sizeof(void*));
+    // Shift to make room
+    memmove(n->keys+idx+1, n->keys+idx, n->n.num_children - idx);
+    memmove(n->children+idx+1, n->children+idx,
+            (n->n.num_children - idx)*sizeof(void*));
 
-        n->keys[idx] = c;
-        n->children[idx] = (art_node *) child;
-        n->n.num_children++;
-        n->n.max_score = MAX(n->n.max_score, ((art_leaf *) LEAF_RAW(child))->max_score);
+    n->keys[idx] = c;
+    n->children[idx] = (art_node *) child;
+    n->n.num_children++;
+    n->n.max_score = MAX(n->n.max_score, child_max_score(child));
+}
 
+static void add_child4(art_arena *arena, art_node4 *n, art_node **ref, unsigned char c, void *child) {
+    if (n->n.num_children < 4) {
+        art_node4 *copy = (art_node4*)clone_node(arena, (art_node*)n);
+        add_child4_no_cow(copy, c, child);
+        publish_child(ref, copy);
+        free_node(arena, (art_node*)n);
     } else {
-        art_node16 *new_n = (art_node16*)alloc_node(NODE16);
+        art_node16 *new_n = (art_node16*)alloc_node(arena, NODE16);
 
         // Copy the child pointers and the key map
         memcpy(new_n->children, n->children,
@@ -563,20 +955,20 @@ static void add_child4(art_node4 *n, art_node **ref, unsigned char c, void *chil
         memcpy(new_n->keys, n->keys,
                 sizeof(unsigned char)*n->n.num_children);
         copy_header((art_node*)new_n, (art_node*)n);
-        *ref = (art_node*)new_n;
-        free(n);
-        add_child16(new_n, ref, c, child);
+        add_child16_no_cow(new_n, c, child);
+        publish_child(ref, new_n);
+        free_node(arena, (art_node*)n);
     }
 }
 
-static void add_child(art_node *n, art_node **ref, unsigned char c, void *child) {
+static void add_child(art_arena *arena, art_node *n, art_node **ref, unsigned char c, void *child) {
     switch (n->type) {
         case NODE4:
-            return add_child4((art_node4*)n, ref, c, child);
+            return add_child4(arena, (art_node4*)n, ref, c, child);
         case NODE16:
-            return add_child16((art_node16*)n, ref, c, child);
+            return add_child16(arena, (art_node16*)n, ref, c, child);
         case NODE48:
-            return add_child48((art_node48*)n, ref, c, child);
+            return add_child48(arena, (art_node48*)n, ref, c, child);
         case NODE256:
             return add_child256((art_node256*)n, ref, c, child);
         default:
@@ -608,17 +1000,22 @@ static int prefix_mismatch(const art_node *n, const unsigned char *key, int key_
     return idx;
 }
 
-static void* recursive_insert(art_node* n, art_node** ref, const unsigned char* key, uint32_t key_len,
-                              const int64_t docs_max_score, std::vector<art_document>& documents, int depth,
-                              std::list<art_node*>& path, int* old) {
+static void* recursive_insert(art_tree* t, art_node* n, art_node** ref, const unsigned char* key,
+                              uint32_t key_len, const int64_t docs_max_score, std::vector<art_document>& documents,
+                              int depth, std::list<art_node*>& path, int* old,
+                              std::vector<std::pair<art_node**, int>>* descent = nullptr,
+                              art_leaf** affected_leaf = nullptr) {
+    art_arena* arena = t->arena;
+
     // If we are at a NULL node, inject a leaf
     if (!n) {
-        art_leaf* new_leaf = make_leaf(key, key_len, &documents[0]);
+        art_leaf* new_leaf = make_leaf(t, key, key_len, &documents[0]);
         for(size_t i = 1; i < documents.size(); i++) {
             add_document_to_leaf(&documents[i], new_leaf);
         }
 
         *ref = (art_node*)SET_LEAF(new_leaf);
+        if(affected_leaf) *affected_leaf = new_leaf;
         return NULL;
     }
 
@@ -632,14 +1029,15 @@ static void* recursive_insert(art_node* n, art_node** ref, const unsigned char*
             for(size_t i = 0; i < documents.size(); i++) {
                 add_document_to_leaf(&documents[i], l);
             }
+            if(affected_leaf) *affected_leaf = l;
             return l->values;
         }
 
         // New value, we must split the leaf into a node4
-        art_node4 *new_n = (art_node4*)alloc_node(NODE4);
+        art_node4 *new_n = (art_node4*)alloc_node(arena, NODE4);
 
         // Create a new leaf
-        art_leaf *l2 = make_leaf(key, key_len, &documents[0]);
+        art_leaf *l2 = make_leaf(t, key, key_len, &documents[0]);
 
         uint32_t longest_prefix = longest_common_prefix(l, l2, depth);
         new_n->n.partial_len = longest_prefix;
@@ -649,15 +1047,28 @@ static void* recursive_insert(art_node* n, art_node** ref, const unsigned char*
             add_document_to_leaf(&documents[i], l2);
         }
 
-        // Add the leafs to the new node4
-        *ref = (art_node*)new_n;
-        add_child4(new_n, ref, l->key[depth+longest_prefix], SET_LEAF(l));
-        add_child4(new_n, ref, l2->key[depth+longest_prefix], SET_LEAF(l2));
+        // Add the leafs to the new node4, then swap it in: readers see
+        // either the old leaf or the finished node
+        add_child4_no_cow(new_n, l->key[depth+longest_prefix], SET_LEAF(l));
+        add_child4_no_cow(new_n, l2->key[depth+longest_prefix], SET_LEAF(l2));
+        publish_child(ref, new_n);
+        if(affected_leaf) *affected_leaf = l2;
         return NULL;
     }
 
+    if(descent) {
+        // remember the slot and entry depth of every internal node visited,
+        // so that a bulk insert can resume from a shared prefix
+        descent->push_back({ref, depth});
+    }
+
     if(docs_max_score != USE_FREQUENCY_SCORE) {
         n->max_score = MAX(n->max_score, docs_max_score);
+    } else {
+        // for frequency-ordered trees the subtree max is the leaf's eventual
+        // id count, known only after the leaf is updated: remember the node
+        // so the caller can fix it up after the descent
+        path.push_back(n);
     }
 
     // Check if given node has a prefix
@@ -670,33 +1081,46 @@ static void* recursive_insert(art_node* n, art_node** ref, const unsigned char*
         }
 
         // Create a new node
-        art_node4 *new_n = (art_node4*)alloc_node(NODE4);
-        *ref = (art_node*)new_n;
+        art_node4 *new_n = (art_node4*)alloc_node(arena, NODE4);
         new_n->n.partial_len = prefix_diff;
         memcpy(new_n->n.partial, n->partial, min(MAX_PREFIX_LEN, prefix_diff));
 
-        // Adjust the prefix of the old node
+        // Adjust the prefix of the old node on a private copy: the prefix
+        // rewrite must not be observable while `n` is still reachable
+        art_node *n_copy = clone_node(arena, n);
         if (n->partial_len <= MAX_PREFIX_LEN) {
-            add_child4(new_n, ref, n->partial[prefix_diff], n);
-            n->partial_len -= (prefix_diff+1);
-            memmove(n->partial, n->partial+prefix_diff+1,
-                    min(MAX_PREFIX_LEN, n->partial_len));
+            add_child4_no_cow(new_n, n_copy->partial[prefix_diff], n_copy);
+            n_copy->partial_len -= (prefix_diff+1);
+            memmove(n_copy->partial, n_copy->partial+prefix_diff+1,
+                    min(MAX_PREFIX_LEN, n_copy->partial_len));
         } else {
-            n->partial_len -= (prefix_diff+1);
+            n_copy->partial_len -= (prefix_diff+1);
             art_leaf *l = minimum(n);
-            add_child4(new_n, ref, l->key[depth+prefix_diff], n);
-            memcpy(n->partial, l->key+depth+prefix_diff+1,
-                   min(MAX_PREFIX_LEN, n->partial_len));
+            add_child4_no_cow(new_n, l->key[depth+prefix_diff], n_copy);
+            memcpy(n_copy->partial, l->key+depth+prefix_diff+1,
+                   min(MAX_PREFIX_LEN, n_copy->partial_len));
         }
 
         // Insert the new leaf
-        art_leaf *l = make_leaf(key, key_len, &documents[0]);
+        art_leaf *l = make_leaf(t, key, key_len, &documents[0]);
         for(size_t i = 1; i < documents.size(); i++) {
             add_document_to_leaf(&documents[i], l);
         }
 
-        add_child4(new_n, ref, key[depth+prefix_diff], SET_LEAF(l));
-        path.push_back(*ref);
+        add_child4_no_cow(new_n, key[depth+prefix_diff], SET_LEAF(l));
+        publish_child(ref, new_n);
+        free_node(arena, n);
+
+        // the retired original may already sit on `path` for the frequency
+        // fix-up: point such entries at its replacement
+        for(art_node*& path_n: path) {
+            if(path_n == n) {
+                path_n = n_copy;
+            }
+        }
+
+        path.push_back((art_node*)new_n);
+        if(affected_leaf) *affected_leaf = l;
         return NULL;
     }
 
@@ -705,17 +1129,30 @@ static void* recursive_insert(art_node* n, art_node** ref, const unsigned char*
     // Find a child to recurse to
     art_node **child = find_child(n, key[depth]);
     if (child) {
-        return recursive_insert(*child, child, key, key_len, docs_max_score, documents, depth + 1, path, old);
+        return recursive_insert(t, *child, child, key, key_len, docs_max_score, documents, depth + 1,
+                                path, old, descent, affected_leaf);
     }
 
     // No child, node goes within us
-    art_leaf *l = make_leaf(key, key_len, &documents[0]);
+    art_leaf *l = make_leaf(t, key, key_len, &documents[0]);
     for(size_t i = 1; i < documents.size(); i++) {
         add_document_to_leaf(&documents[i], l);
     }
 
-    add_child(n, ref, key[depth], SET_LEAF(l));
+    add_child(arena, n, ref, key[depth], SET_LEAF(l));
+
+    // add_child may have replaced `n` with a copy; refresh path entries
+    // that still point at the retired original
+    if (*ref != n) {
+        for(art_node*& path_n: path) {
+            if(path_n == n) {
+                path_n = *ref;
+            }
+        }
+    }
+
     path.push_back(*ref);
+    if(affected_leaf) *affected_leaf = l;
     return NULL;
 }
 
@@ -739,27 +1176,134 @@ void* art_inserts(art_tree *t, const unsigned char *key, int key_len, const int6
 
     std::list<art_node*> path;
     bool frequency_based_ordering = (docs_max_score == USE_FREQUENCY_SCORE);
-    void *old = recursive_insert(t->root, &t->root, key, key_len, docs_max_score, documents, 0, path, &old_val);
+    art_leaf* affected_leaf = nullptr;
+    void *old = recursive_insert(t, t->root, &t->root, key, key_len, docs_max_score, documents, 0, path,
+                                 &old_val, nullptr, &affected_leaf);
     if (!old_val) t->size++;
 
-    if(frequency_based_ordering) {
+    if(frequency_based_ordering && affected_leaf != nullptr) {
+        // propagate the leaf's updated frequency (its max_score holds the id
+        // count for frequency trees) so inner nodes track their subtree max
         for(art_node* n: path) {
-            n->max_score = MAX(n->max_score, docs_max_score);
+            n->max_score = MAX(n->max_score, affected_leaf->max_score);
         }
     }
 
+    arena_reclaim(t->arena);
     return old;
 }
 
-static void remove_child256(art_node256 *n, art_node **ref, unsigned char c) {
-    n->children[c] = NULL;
+void art_load_leaf(art_tree *t, const unsigned char *key, uint32_t key_len,
+                   const int64_t max_score, void *values) {
+    // descend with a placeholder document so recursive_insert handles node
+    // splitting and inner max score propagation, then swap in the restored
+    // posting object wholesale
+    art_document placeholder(0, max_score, {0});
+    std::vector<art_document> documents = {placeholder};
+
+    int old_val = 0;
+    std::list<art_node*> path;
+    art_leaf* affected_leaf = nullptr;
+
+    recursive_insert(t, t->root, &t->root, key, key_len, max_score, documents, 0, path,
+                     &old_val, nullptr, &affected_leaf);
+    if (!old_val) t->size++;
+
+    posting_t::destroy_list(affected_leaf->values);
+    affected_leaf->values = values;
+    affected_leaf->max_score = max_score;
+
+    arena_reclaim(t->arena);
+}
+
+static bool compare_key_documents(const art_key_documents& a, const art_key_documents& b) {
+    int cmp = memcmp(a.key, b.key, min(a.key_len, b.key_len));
+    if (cmp != 0) {
+        return cmp < 0;
+    }
+    return a.key_len < b.key_len;
+}
+
+void art_bulk_inserts(art_tree *t, const int64_t docs_max_score, std::vector<art_key_documents>& batch) {
+    std::sort(batch.begin(), batch.end(), compare_key_documents);
+
+    // Slots and entry depths of the internal nodes visited for the previous
+    // key, deepest last. Consecutive sorted keys share prefixes, so the
+    // descent is resumed from the deepest node entered within the common
+    // prefix instead of re-descending from the root.
+    std::vector<std::pair<art_node**, int>> descent;
+    const unsigned char* prev_key = nullptr;
+    uint32_t prev_key_len = 0;
+
+    for(art_key_documents& rec: batch) {
+        uint32_t lcp = 0;
+        if(prev_key) {
+            uint32_t max_cmp = min(prev_key_len, rec.key_len);
+            while(lcp < max_cmp && prev_key[lcp] == rec.key[lcp]) {
+                lcp++;
+            }
+        }
+
+        // nodes entered past the common prefix belong to the previous key's
+        // subtree and cannot lie on this key's path
+        while(!descent.empty() && descent.back().second > (int)lcp) {
+            descent.pop_back();
+        }
+
+        art_node** ref = &t->root;
+        int depth = 0;
+
+        if(!descent.empty()) {
+            ref = descent.back().first;
+            depth = descent.back().second;
+            descent.pop_back();  // re-recorded by recursive_insert
+
+            // skipped ancestors still need their max score refreshed, which
+            // a full descent would have done on the way down
+            if(docs_max_score != USE_FREQUENCY_SCORE) {
+                for(auto& entry: descent) {
+                    art_node* ancestor = *entry.first;
+                    ancestor->max_score = MAX(ancestor->max_score, docs_max_score);
+                }
+            }
+        }
+
+        int old_val = 0;
+        std::list<art_node*> path;
+        art_leaf* affected_leaf = nullptr;
+        recursive_insert(t, *ref, ref, rec.key, rec.key_len, docs_max_score, *rec.documents,
+                         depth, path, &old_val, &descent, &affected_leaf);
+        if (!old_val) t->size++;
+
+        if(docs_max_score == USE_FREQUENCY_SCORE && affected_leaf != nullptr) {
+            // the entered nodes are covered by `path`, the retained ancestors
+            // by the descent stack; MAX is idempotent so overlap is fine
+            for(art_node* n: path) {
+                n->max_score = MAX(n->max_score, affected_leaf->max_score);
+            }
+            for(auto& entry: descent) {
+                art_node* ancestor = *entry.first;
+                if(!IS_LEAF(ancestor)) {
+                    ancestor->max_score = MAX(ancestor->max_score, affected_leaf->max_score);
+                }
+            }
+        }
+
+        prev_key = rec.key;
+        prev_key_len = rec.key_len;
+    }
+
+    arena_reclaim(t->arena);
+}
+
+static void remove_child256(art_arena *arena, art_node256 *n, art_node **ref, unsigned char c) {
+    publish_child(&n->children[c], NULL);
     n->n.num_children--;
 
     // Resize to a node48 on underflow, not immediately to prevent
     // trashing if we sit on the 48/49 boundary
     if (n->n.num_children == 37) {
-        art_node48 *new_n = (art_node48*)alloc_node(NODE48);
-        *ref = (art_node*)new_n;
+        art_node48 *new_n = (art_node48*)alloc_node(arena, NODE48);
         copy_header((art_node*)new_n, (art_node*)n);
 
         int pos = 0;
@@ -770,19 +1314,21 @@ static void remove_child256(art_node256 *n, art_node **ref, unsigned char c) {
                 pos++;
             }
         }
-        free(n);
+        publish_child(ref, new_n);
+        free_node(arena, (art_node*)n);
     }
 }
 
-static void remove_child48(art_node48 *n, art_node **ref, unsigned char c) {
+static void remove_child48(art_arena *arena, art_node48 *n, art_node **ref, unsigned char c) {
     int pos = n->keys[c];
-    n->keys[c] = 0;
-    n->children[pos-1] = NULL;
+    // clear the key map entry before the child slot so readers never chase
+    // a cleared slot
+    __atomic_store_n(&n->keys[c], 0, __ATOMIC_RELEASE);
+    publish_child(&n->children[pos-1], NULL);
     n->n.num_children--;
 
     if (n->n.num_children == 12) {
-        art_node16 *new_n = (art_node16*)alloc_node(NODE16);
-        *ref = (art_node*)new_n;
+        art_node16 *new_n = (art_node16*)alloc_node(arena, NODE16);
         copy_header((art_node*)new_n, (art_node*)n);
 
         int child = 0;
@@ -794,73 +1340,97 @@ static void remove_child48(art_node48 *n, art_node **ref, unsigned char c) {
                 child++;
             }
         }
-        free(n);
+        publish_child(ref, new_n);
+        free_node(arena, (art_node*)n);
     }
 }
 
-static void remove_child16(art_node16 *n, art_node **ref, art_node **l) {
+static void remove_child16(art_arena *arena, art_node16 *n, art_node **ref, art_node **l) {
     int pos = l - n->children;
-    memmove(n->keys+pos, n->keys+pos+1, n->n.num_children - 1 - pos);
-    memmove(n->children+pos, n->children+pos+1, (n->n.num_children - 1 - pos)*sizeof(void*));
-    n->n.num_children--;
 
-    if (n->n.num_children == 3) {
-        art_node4 *new_n = (art_node4*)alloc_node(NODE4);
-        *ref = (art_node*)new_n;
-        copy_header((art_node*)new_n, (art_node*)n);
-        memcpy(new_n->keys, n->keys, 4);
-        memcpy(new_n->children, n->children, 4*sizeof(void*));
-        free(n);
+    // removal shifts keys and children: do it on a private copy and swap,
+    // so readers see the node before or after but never mid-move
+    art_node16 *copy = (art_node16*)clone_node(arena, (art_node*)n);
+    memmove(copy->keys+pos, copy->keys+pos+1, copy->n.num_children - 1 - pos);
+    memmove(copy->children+pos, copy->children+pos+1, (copy->n.num_children - 1 - pos)*sizeof(void*));
+    copy->n.num_children--;
+
+    if (copy->n.num_children == 3) {
+        art_node4 *new_n = (art_node4*)alloc_node(arena, NODE4);
+        copy_header((art_node*)new_n, (art_node*)copy);
+        memcpy(new_n->keys, copy->keys, 4);
+        memcpy(new_n->children, copy->children, 4*sizeof(void*));
+        publish_child(ref, new_n);
+        free_node(arena, (art_node*)copy);
+    } else {
+        publish_child(ref, copy);
     }
+
+    free_node(arena, (art_node*)n);
 }
 
-static void remove_child4(art_node4 *n, art_node **ref, art_node **l) {
+static void remove_child4(art_arena *arena, art_node4 *n, art_node **ref, art_node **l) {
     int pos = l - n->children;
-    memmove(n->keys+pos, n->keys+pos+1, n->n.num_children - 1 - pos);
-    memmove(n->children+pos, n->children+pos+1, (n->n.num_children - 1 - pos)*sizeof(void*));
-    n->n.num_children--;
+
+    art_node4 *copy = (art_node4*)clone_node(arena, (art_node*)n);
+    memmove(copy->keys+pos, copy->keys+pos+1, copy->n.num_children - 1 - pos);
+    memmove(copy->children+pos, copy->children+pos+1, (copy->n.num_children - 1 - pos)*sizeof(void*));
+    copy->n.num_children--;
 
     // Remove nodes with only a single child
-    if (n->n.num_children == 1) {
-        art_node *child = n->children[0];
+    if (copy->n.num_children == 1) {
+        art_node *child = copy->children[0];
         if (!IS_LEAF(child)) {
+            // the child's prefix must be rewritten, which readers of the
+            // still-reachable child must not observe: promote a copy
+            art_node *child_copy = clone_node(arena, child);
+
             // Concatenate the prefixes
-            int prefix = n->n.partial_len;
+            int prefix = copy->n.partial_len;
             if (prefix < MAX_PREFIX_LEN) {
-                n->n.partial[prefix] = n->keys[0];
+                copy->n.partial[prefix] = copy->keys[0];
                 prefix++;
             }
             if (prefix < MAX_PREFIX_LEN) {
-                int sub_prefix = min(child->partial_len, MAX_PREFIX_LEN - prefix);
-                memcpy(n->n.partial+prefix, child->partial, sub_prefix);
+                int sub_prefix = min(child_copy->partial_len, MAX_PREFIX_LEN - prefix);
+                memcpy(copy->n.partial+prefix, child_copy->partial, sub_prefix);
                 prefix += sub_prefix;
             }
 
             // Store the prefix in the child
-            memcpy(child->partial, n->n.partial, min(prefix, MAX_PREFIX_LEN));
-            child->partial_len += n->n.partial_len + 1;
+            memcpy(child_copy->partial, copy->n.partial, min(prefix, MAX_PREFIX_LEN));
+            child_copy->partial_len += copy->n.partial_len + 1;
+
+            publish_child(ref, child_copy);
+            free_node(arena, child);
+        } else {
+            publish_child(ref, child);
         }
-        *ref = child;
-        free(n);
+        free_node(arena, (art_node*)copy);
+    } else {
+        publish_child(ref, copy);
     }
+
+    free_node(arena, (art_node*)n);
 }
 
-static void remove_child(art_node *n, art_node **ref, unsigned char c, art_node **l) {
+static void remove_child(art_arena *arena, art_node *n, art_node **ref, unsigned char c, art_node **l) {
     switch (n->type) {
         case NODE4:
-            return remove_child4((art_node4*)n, ref, l);
+            return remove_child4(arena, (art_node4*)n, ref, l);
         case NODE16:
-            return remove_child16((art_node16*)n, ref, l);
+            return remove_child16(arena, (art_node16*)n, ref, l);
         case NODE48:
-            return remove_child48((art_node48*)n, ref, c);
+            return remove_child48(arena, (art_node48*)n, ref, c);
         case NODE256:
-            return remove_child256((art_node256*)n, ref, c);
+            return remove_child256(arena, (art_node256*)n, ref, c);
         default:
             abort();
     }
 }
 
-static art_leaf* recursive_delete(art_node *n, art_node **ref, const unsigned char *key, int key_len, int depth) {
+static art_leaf* recursive_delete(art_arena *arena, art_node *n, art_node **ref, const unsigned char *key,
+                                  int key_len, int depth) {
     // Search terminated
     if (!n) return NULL;
 
@@ -896,14 +1466,14 @@ static art_leaf* recursive_delete(art_node *n, art_node **ref, const unsigned ch
     if (IS_LEAF(*child)) {
         art_leaf *l = (art_leaf *) LEAF_RAW(*child);
         if (!leaf_matches(l, key, key_len, depth)) {
-            remove_child(n, ref, key[depth], child);
+            remove_child(arena, n, ref, key[depth], child);
             return l;
         }
         return NULL;
 
         // Recurse
     } else {
-        return recursive_delete(*child, child, key, key_len, depth+1);
+        return recursive_delete(arena, *child, child, key, key_len, depth+1);
     }
 }
 
@@ -916,11 +1486,12 @@ static art_leaf* recursive_delete(art_node *n, art_node **ref, const unsigned ch
  * the value pointer is returned.
  */
 void* art_delete(art_tree *t, const unsigned char *key, int key_len) {
-    art_leaf *l = recursive_delete(t->root, &t->root, key, key_len, 0);
+    art_leaf *l = recursive_delete(t->arena, t->root, &t->root, key, key_len, 0);
     if (l) {
         t->size--;
         void *old = l->values;
-        free(l);
+        free_leaf(t->arena, l);
+        arena_reclaim(t->arena);
         return old;
     }
     return NULL;
@@ -1008,9 +1579,9 @@ int art_topk_iter(const art_node *root, token_ordering token_order, size_t max_r
 
             case NODE48:
                 //LOG(INFO)  << "NODE48, SCORE: " << n->max_score;
-                for (int i=0; i < 256; i++) {
+                for (int i=node48_next_occupied((art_node48*)n, 0); i < 256;
+                     i=node48_next_occupied((art_node48*)n, i+1)) {
                     idx = ((art_node48*)n)->keys[i];
-                    if (!idx) continue;
                     art_node *child = ((art_node48*)n)->children[idx - 1];
                     q.push(child);
                 }
@@ -1068,10 +1639,9 @@ static int recursive_iter(art_node *n, art_callback cb, void *data) {
             break;
 
         case NODE48:
-            for (int i=0; i < 256; i++) {
+            for (int i=node48_next_occupied((art_node48*)n, 0); i < 256;
+                 i=node48_next_occupied((art_node48*)n, i+1)) {
                 idx = ((art_node48*)n)->keys[i];
-                if (!idx) continue;
-
                 res = recursive_iter(((art_node48*)n)->children[idx-1], cb, data);
                 if (res) return res;
             }
@@ -1102,9 +1672,66 @@ static int recursive_iter(art_node *n, art_callback cb, void *data) {
  * @return 0 on success, or the return of the callback.
  */
 int art_iter(art_tree *t, art_callback cb, void *data) {
+    rcu_read_guard guard;
     return recursive_iter(t->root, cb, data);
 }
 
+static int recursive_iter_leaves(art_node *n, art_leaf_callback cb, void *data) {
+    // Handle base cases
+    if (!n) return 0;
+    if (IS_LEAF(n)) {
+        art_leaf *l = (art_leaf *) LEAF_RAW(n);
+        return cb(data, l);
+    }
+
+    int idx, res;
+    switch (n->type) {
+        case NODE4:
+            for (int i=0; i < n->num_children; i++) {
+                res = recursive_iter_leaves(((art_node4*)n)->children[i], cb, data);
+                if (res) return res;
+            }
+            break;
+
+        case NODE16:
+            for (int i=0; i < n->num_children; i++) {
+                res = recursive_iter_leaves(((art_node16*)n)->children[i], cb, data);
+                if (res) return res;
+            }
+            break;
+
+        case NODE48:
+            for (int i=node48_next_occupied((art_node48*)n, 0); i < 256;
+                 i=node48_next_occupied((art_node48*)n, i+1)) {
+                idx = ((art_node48*)n)->keys[i];
+                res = recursive_iter_leaves(((art_node48*)n)->children[idx-1], cb, data);
+                if (res) return res;
+            }
+            break;
+
+        case NODE256:
+            for (int i=0; i < 256; i++) {
+                if (!((art_node256*)n)->children[i]) continue;
+                res = recursive_iter_leaves(((art_node256*)n)->children[i], cb, data);
+                if (res) return res;
+            }
+            break;
+
+        default:
+            abort();
+    }
+    return 0;
+}
+
+/**
+ * Same as art_iter, but the callback receives the leaf itself, giving
+ * access to the key bytes and leaf max_score in one visit.
+ */
+int art_iter_leaves(art_tree *t, art_leaf_callback cb, void *data) {
+    rcu_read_guard guard;
+    return recursive_iter_leaves(t->root, cb, data);
+}
+
 /**
  * Checks if a leaf prefix matches
  * @return 0 on success.
@@ -1130,6 +1757,7 @@ static int leaf_prefix_matches(const art_leaf *n, const unsigned char *prefix, i
  * @return 0 on success, or the return of the callback.
  */
 int art_iter_prefix(art_tree *t, const unsigned char *key, int key_len, art_callback cb, void *data) {
+    rcu_read_guard guard;
     art_node **child;
     art_node *n = t->root;
     int prefix_len, depth = 0;
@@ -1260,9 +1888,9 @@ static inline void art_fuzzy_children(unsigned char p, const art_node *n, int de
             break;
         case NODE48:
             printf("\nNODE48\n");
-            for (int i=255; i >= 0; i--) {
+            for (int i=node48_prev_occupied((art_node48*)n, 255); i >= 0;
+                 i=node48_prev_occupied((art_node48*)n, i-1)) {
                 int ix = ((art_node48*)n)->keys[i];
-                if (!ix) continue;
                 child = ((art_node48*)n)->children[ix - 1];
                 child_char = (char)i;
                 printf("48!child_char: %c, depth: %d, ix: %d\n", child_char, depth, ix);
@@ -1478,6 +2106,205 @@ static void art_fuzzy_recurse(unsigned char p, unsigned char c, const art_node *
     art_fuzzy_children(c, n, depth, term, term_len, rows[i], rows[j], min_cost, max_cost, prefix, results);
 }
 
+// Automaton flavour of fuzzy_search_state: probes the same columns, but reads
+// the cost out of the bit-parallel state instead of a DP row.
+static inline int fuzzy_search_state_auto(const lev_automaton& la, const lev_automaton::state& st, const bool prefix,
+                                          int key_index, bool last_key_char, int term_len,
+                                          int min_cost, int max_cost) {
+    int cost = 0;
+    int key_len = key_index + 1;
+
+    if(last_key_char) {
+        if(key_len > 5 && term_len > key_len && (term_len - key_len) <= max_cost) {
+            // used to handle some trailing edge cases, but limit to larger keys to prevent eager matches
+            cost = std::min(la.cost_at(st, key_len), la.cost_at(st, term_len));
+        } else {
+            cost = la.cost_at(st, term_len);
+        }
+
+        if(cost >= min_cost && cost <= max_cost) {
+            return 1;
+        }
+
+        return -1;
+    }
+
+    if(key_len >= term_len && prefix) {
+        cost = la.cost_at(st, term_len);
+        if(cost >= min_cost && cost <= max_cost) {
+            return 1;
+        }
+    } else {
+        cost = la.cost_at(st, std::min(key_len, term_len));
+    }
+
+    int bounded_cost = (max_cost == 0) ? max_cost : (max_cost + 1);
+    return (cost > bounded_cost) ? -1 : 0;
+}
+
+static inline void art_fuzzy_children_auto(const art_node *n, int depth, const lev_automaton& la,
+                                           const lev_automaton::state& st, const unsigned char *term,
+                                           const int term_len, const int min_cost, const int max_cost,
+                                           const bool prefix, std::vector<const art_node *> &results) {
+    char child_char;
+    art_node* child;
+
+    switch (n->type) {
+        case NODE4:
+            for (int i=n->num_children-1; i >= 0; i--) {
+                child_char = ((art_node4*)n)->keys[i];
+                child = ((art_node4*)n)->children[i];
+                art_fuzzy_recurse_auto(child_char, child, depth, la, st, term, term_len, min_cost, max_cost, prefix, results);
+            }
+            break;
+        case NODE16:
+            for (int i=n->num_children-1; i >= 0; i--) {
+                child_char = ((art_node16*)n)->keys[i];
+                child = ((art_node16*)n)->children[i];
+                art_fuzzy_recurse_auto(child_char, child, depth, la, st, term, term_len, min_cost, max_cost, prefix, results);
+            }
+            break;
+        case NODE48:
+            for (int i=node48_prev_occupied((art_node48*)n, 255); i >= 0;
+                 i=node48_prev_occupied((art_node48*)n, i-1)) {
+                int ix = ((art_node48*)n)->keys[i];
+                child = ((art_node48*)n)->children[ix - 1];
+                child_char = (char)i;
+                art_fuzzy_recurse_auto(child_char, child, depth, la, st, term, term_len, min_cost, max_cost, prefix, results);
+            }
+            break;
+        case NODE256:
+            for (int i=255; i >= 0; i--) {
+                if (!((art_node256*)n)->children[i]) continue;
+                child_char = (char) i;
+                child = ((art_node256*)n)->children[i];
+                art_fuzzy_recurse_auto(child_char, child, depth, la, st, term, term_len, min_cost, max_cost, prefix, results);
+            }
+            break;
+        default:
+            abort();
+    }
+}
+
+// Same traversal as art_fuzzy_recurse, but the per-branch edit state is a
+// small copyable automaton state advanced with a few word ops per character,
+// instead of a DP row of (term_len + 1) ints recomputed on every level.
+static void art_fuzzy_recurse_auto(unsigned char c, const art_node *n, int depth, const lev_automaton& la,
+                                   lev_automaton::state st, const unsigned char *term, const int term_len,
+                                   const int min_cost, const int max_cost, const bool prefix,
+                                   std::vector<const art_node *> &results) {
+    if (!n) return ;
+
+    if(depth == -1) {
+        // root node
+        depth = 0;
+    } else {
+        // check indexed char first
+        bool last_key_char = (c == '\0');
+
+        if(!prefix || !last_key_char) {
+            la.step(st, c, depth);
+        }
+
+        int action = fuzzy_search_state_auto(la, st, prefix, depth, last_key_char, term_len, min_cost, max_cost);
+        if(1 == action) {
+            results.push_back(n);
+            return;
+        }
+
+        if(action == -1) {
+            return;
+        }
+
+        depth++;
+    }
+
+    // check if node is a leaf
+    if(IS_LEAF(n)) {
+        art_leaf *l = (art_leaf *) LEAF_RAW(n);
+
+        // look past term_len to deal with trailing typo, e.g. searching "pltinum" on "platinum" @ max_cost = 1
+        const int iter_len = std::min(int(l->key_len), term_len + max_cost);
+
+        if(depth >= iter_len) {
+            // when a preceding partial node completely contains the whole leaf (e.g. "[raspberr]y" on "raspberries")
+            int action = fuzzy_search_state_auto(la, st, prefix, depth, true, term_len, min_cost, max_cost);
+            if(action == 1) {
+                results.push_back(n);
+            }
+
+            return;
+        }
+
+        // we will iterate through remaining leaf characters
+        while(depth < iter_len) {
+            c = l->key[depth];
+            bool last_key_char = (c == '\0');
+
+            if(!prefix || !last_key_char) {
+                la.step(st, c, depth);
+            }
+
+            int action = fuzzy_search_state_auto(la, st, prefix, depth, last_key_char, term_len, min_cost, max_cost);
+            if(action == 1) {
+                results.push_back(n);
+                return;
+            }
+
+            if(action == -1) {
+                return;
+            }
+
+            depth++;
+        }
+
+        return ;
+    }
+
+    // now check compressed prefix
+
+    int partial_len = min(MAX_PREFIX_LEN, n->partial_len);
+
+    for (int idx = 0; idx < partial_len; idx++) {
+        c = n->partial[idx];
+
+        la.step(st, c, depth);
+
+        int action = fuzzy_search_state_auto(la, st, prefix, depth, false, term_len, min_cost, max_cost);
+        if(action == 1) {
+            results.push_back(n);
+            return;
+        }
+
+        if(action == -1) {
+            return;
+        }
+
+        depth++;
+    }
+
+    // Some intermediate path may have been left out if partial_len is truncated: progress the automaton
+    while(partial_len < n->partial_len && depth < term_len) {
+        c = term[depth];
+        la.step(st, c, depth);
+
+        int action = fuzzy_search_state_auto(la, st, prefix, depth, false, term_len, min_cost, max_cost);
+        if(action == 1) {
+            results.push_back(n);
+            return;
+        }
+
+        if(action == -1) {
+            return;
+        }
+
+        depth++;
+        partial_len++;
+    }
+
+    art_fuzzy_children_auto(n, depth, la, st, term, term_len, min_cost, max_cost, prefix, results);
+}
+
 /**
  * Returns leaves that match a given string within a fuzzy distance of max_cost.
  */
@@ -1485,26 +2312,46 @@ int art_fuzzy_search(art_tree *t, const unsigned char *term, const int term_len,
                      const int max_words, const token_ordering token_order, const bool prefix,
                      const uint32_t *filter_ids, size_t filter_ids_length,
                      std::vector<art_leaf *> &results, const std::set<art_leaf *>& exclude_leaves) {
+    rcu_read_guard guard;
+
 
     std::vector<const art_node*> nodes;
-    int irow[term_len + 1];
-    int jrow[term_len + 1];
-    for (int i = 0; i <= term_len; i++){
-        irow[i] = jrow[i] = i;
-    }
 
     //auto begin = std::chrono::high_resolution_clock::now();
 
-    if(IS_LEAF(t->root)) {
-        art_leaf *l = (art_leaf *) LEAF_RAW(t->root);
-        art_fuzzy_recurse(0, l->key[0], t->root, 0, term, term_len, irow, jrow, min_cost, max_cost, prefix, nodes);
+    if(t->root == nullptr) {
+        return 0;
+    }
+
+    // descent is allowed to run one edit past max_cost, so the automaton
+    // must track one extra error row
+    if(lev_automaton::usable(term_len, max_cost + 1)) {
+        const lev_automaton la(term, term_len, max_cost + 1);
+
+        if(IS_LEAF(t->root)) {
+            art_leaf *l = (art_leaf *) LEAF_RAW(t->root);
+            art_fuzzy_recurse_auto(l->key[0], t->root, 0, la, la.initial(), term, term_len, min_cost, max_cost,
+                                   prefix, nodes);
+        } else {
+            // send depth as -1 to indicate that this is a root node
+            art_fuzzy_recurse_auto(0, t->root, -1, la, la.initial(), term, term_len, min_cost, max_cost,
+                                   prefix, nodes);
+        }
     } else {
-        if(t->root == nullptr) {
-            return 0;
+        // overly long tokens fall back to the DP rows
+        int irow[term_len + 1];
+        int jrow[term_len + 1];
+        for (int i = 0; i <= term_len; i++){
+            irow[i] = jrow[i] = i;
         }
 
-        // send depth as -1 to indicate that this is a root node
-        art_fuzzy_recurse(0, 0, t->root, -1, term, term_len, irow, jrow, min_cost, max_cost, prefix, nodes);
+        if(IS_LEAF(t->root)) {
+            art_leaf *l = (art_leaf *) LEAF_RAW(t->root);
+            art_fuzzy_recurse(0, l->key[0], t->root, 0, term, term_len, irow, jrow, min_cost, max_cost, prefix, nodes);
+        } else {
+            // send depth as -1 to indicate that this is a root node
+            art_fuzzy_recurse(0, 0, t->root, -1, term, term_len, irow, jrow, min_cost, max_cost, prefix, nodes);
+        }
     }
 
     //long long int time_micro = microseconds(std::chrono::high_resolution_clock::now() - begin).count();
@@ -1621,9 +2468,9 @@ static void art_iter(const art_node *n, const unsigned char* int_str, int int_st
             break;
 
         case NODE48:
-            for (int i=0; i < 256; i++) {
+            for (int i=node48_next_occupied((art_node48*)n, 0); i < 256;
+                 i=node48_next_occupied((art_node48*)n, i+1)) {
                 idx = ((art_node48*)n)->keys[i];
-                if (!idx) continue;
                 art_iter(((art_node48 *) n)->children[idx - 1], int_str, int_str_len, comparator, results);
             }
             break;
@@ -1678,9 +2525,9 @@ static inline void art_int_fuzzy_children(const art_node *n, int depth, const un
             break;
         case NODE48:
             printf("\nNODE48\n");
-            for (int i=255; i >= 0; i--) {
+            for (int i=node48_prev_occupied((art_node48*)n, 255); i >= 0;
+                 i=node48_prev_occupied((art_node48*)n, i-1)) {
                 int ix = ((art_node48*)n)->keys[i];
-                if (!ix) continue;
                 child = ((art_node48*)n)->children[ix - 1];
                 child_char = (unsigned char)i;
                 printf("48!child_char: %c, depth: %d, ix: %d\n", child_char, depth, ix);
@@ -1772,6 +2619,7 @@ void compare_and_match_leaf(const unsigned char *int_str, int int_str_len, const
 }
 
 int art_int32_search(art_tree *t, int32_t value, NUM_COMPARATOR comparator, std::vector<const art_leaf *> &results) {
+    rcu_read_guard guard;
     unsigned char chars[8];
     encode_int32(value, chars);
     art_int_fuzzy_recurse(t->root, 0, chars, 8, comparator, results);
@@ -1779,6 +2627,7 @@ int art_int32_search(art_tree *t, int32_t value, NUM_COMPARATOR comparator, std:
 }
 
 int art_int64_search(art_tree *t, int64_t value, NUM_COMPARATOR comparator, std::vector<const art_leaf *> &results) {
+    rcu_read_guard guard;
     unsigned char chars[8];
     encode_int64(value, chars);
     art_int_fuzzy_recurse(t->root, 0, chars, 8, comparator, results);
@@ -1786,6 +2635,7 @@ int art_int64_search(art_tree *t, int64_t value, NUM_COMPARATOR comparator, std:
 }
 
 int art_float_search(art_tree *t, float value, NUM_COMPARATOR comparator, std::vector<const art_leaf *> &results) {
+    rcu_read_guard guard;
     unsigned char chars[8];
     encode_float(value, chars);
     art_int_fuzzy_recurse(t->root, 0, chars, 8, comparator, results);
@@ -0,0 +1,601 @@
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <vector>
+#include <posting.h>
+#include "art_frozen.h"
+#include "logger.h"
+
+#define IS_LEAF(x) (((uintptr_t)x & 1))
+#define LEAF_RAW(x) ((void*)((uintptr_t)x & ~1))
+
+static const char FROZEN_MAGIC[8] = {'A', 'R', 'T', 'F', 'Z', 'N', '0', '1'};
+
+/**
+ * Fixed header at the start of every snapshot file.
+ */
+struct art_frozen_file_header {
+    char magic[8];
+    uint64_t root_offset;
+    uint64_t num_keys;
+    uint64_t file_size;
+};
+
+static inline int min(int a, int b) {
+    return (a < b) ? a : b;
+}
+
+/**
+ * Appends `len` bytes to the buffer and returns the offset they start at.
+ * Records are kept 8-byte aligned so the mapped structs can be read with
+ * plain casts.
+ */
+static uint64_t buf_append(std::vector<uint8_t>& buf, const void* data, size_t len) {
+    while(buf.size() % 8 != 0) {
+        buf.push_back(0);
+    }
+
+    uint64_t off = buf.size();
+    buf.insert(buf.end(), (const uint8_t *) data, (const uint8_t *) data + len);
+    return off;
+}
+
+static void buf_append_raw(std::vector<uint8_t>& buf, const void* data, size_t len) {
+    buf.insert(buf.end(), (const uint8_t *) data, (const uint8_t *) data + len);
+}
+
+/**
+ * Flattens a leaf's posting data (compact or full list) into plain arrays:
+ * document ids, the start index of each id's offsets, and the offsets
+ * themselves. Offset indices from chained blocks are rebased so they index
+ * into the single concatenated offsets array.
+ */
+static void flatten_posting(const void* obj, std::vector<uint32_t>& ids,
+                            std::vector<uint32_t>& offset_index, std::vector<uint32_t>& offsets) {
+    if(IS_COMPACT_POSTING(obj)) {
+        const compact_posting_list_t* list = COMPACT_POSTING_PTR(obj);
+        uint32_t i = 0;
+        while(i < list->length) {
+            uint32_t num_offsets = list->id_offsets[i];
+            offset_index.push_back(offsets.size());
+            for(uint32_t j = 0; j < num_offsets; j++) {
+                offsets.push_back(list->id_offsets[i + 1 + j]);
+            }
+            ids.push_back(list->id_offsets[i + 1 + num_offsets]);
+            i += (num_offsets + 2);
+        }
+        return;
+    }
+
+    posting_list_t* list = (posting_list_t *)(obj);
+    posting_list_t::block_t* block = list->get_root();
+
+    while(block != nullptr) {
+        uint32_t* block_ids = block->ids.uncompress();
+        uint32_t* block_offset_index = block->offset_index.uncompress();
+        uint32_t* block_offsets = block->offsets.uncompress();
+
+        uint32_t offsets_base = offsets.size();
+
+        for(uint32_t i = 0; i < block->ids.getLength(); i++) {
+            ids.push_back(block_ids[i]);
+            offset_index.push_back(offsets_base + block_offset_index[i]);
+        }
+
+        for(uint32_t i = 0; i < block->offsets.getLength(); i++) {
+            offsets.push_back(block_offsets[i]);
+        }
+
+        delete [] block_ids;
+        delete [] block_offset_index;
+        delete [] block_offsets;
+
+        block = block->next;
+    }
+}
+
+static uint64_t freeze_leaf(const art_leaf* l, std::vector<uint8_t>& buf) {
+    std::vector<uint32_t> ids;
+    std::vector<uint32_t> offset_index;
+    std::vector<uint32_t> offsets;
+    flatten_posting(l->values, ids, offset_index, offsets);
+
+    art_frozen_leaf header;
+    header.key_len = l->key_len;
+    header.num_ids = ids.size();
+    header.num_offsets = offsets.size();
+    header.pad = 0;
+    header.max_score = l->max_score;
+
+    uint64_t off = buf_append(buf, &header, sizeof(header));
+    buf_append_raw(buf, ids.data(), ids.size() * sizeof(uint32_t));
+    buf_append_raw(buf, offset_index.data(), offset_index.size() * sizeof(uint32_t));
+    buf_append_raw(buf, offsets.data(), offsets.size() * sizeof(uint32_t));
+    buf_append_raw(buf, l->key, l->key_len);
+
+    return FROZEN_SET_LEAF(off);
+}
+
+/**
+ * Serializes the subtree rooted at `n` and returns the tagged offset of
+ * its record. Children are written after their parent and their offsets
+ * patched into the already-emitted record, so the layout stays depth-first
+ * (parents and first children adjacent) for traversal locality.
+ */
+static uint64_t freeze_node(const art_node* n, std::vector<uint8_t>& buf) {
+    if(IS_LEAF(n)) {
+        return freeze_leaf((const art_leaf *) LEAF_RAW(n), buf);
+    }
+
+    art_frozen_node header;
+    header.type = n->type;
+    header.num_children = n->num_children;
+    header.partial_len = n->partial_len;
+    memcpy(header.partial, n->partial, MAX_PREFIX_LEN);
+    header.max_score = n->max_score;
+
+    uint64_t off = 0;
+
+    switch(n->type) {
+        case NODE4: {
+            const art_node4* p = (const art_node4 *) n;
+            art_frozen_node4 rec;
+            memset(&rec, 0, sizeof(rec));
+            rec.n = header;
+            memcpy(rec.keys, p->keys, sizeof(rec.keys));
+            off = buf_append(buf, &rec, sizeof(rec));
+            for(int i = 0; i < n->num_children; i++) {
+                uint64_t child_off = freeze_node(p->children[i], buf);
+                memcpy(buf.data() + off + offsetof(art_frozen_node4, children) + i * sizeof(uint64_t),
+                       &child_off, sizeof(uint64_t));
+            }
+            break;
+        }
+        case NODE16: {
+            const art_node16* p = (const art_node16 *) n;
+            art_frozen_node16 rec;
+            memset(&rec, 0, sizeof(rec));
+            rec.n = header;
+            memcpy(rec.keys, p->keys, sizeof(rec.keys));
+            off = buf_append(buf, &rec, sizeof(rec));
+            for(int i = 0; i < n->num_children; i++) {
+                uint64_t child_off = freeze_node(p->children[i], buf);
+                memcpy(buf.data() + off + offsetof(art_frozen_node16, children) + i * sizeof(uint64_t),
+                       &child_off, sizeof(uint64_t));
+            }
+            break;
+        }
+        case NODE48: {
+            const art_node48* p = (const art_node48 *) n;
+            art_frozen_node48 rec;
+            memset(&rec, 0, sizeof(rec));
+            rec.n = header;
+            memcpy(rec.keys, p->keys, sizeof(rec.keys));
+            off = buf_append(buf, &rec, sizeof(rec));
+            for(int i = 0; i < 256; i++) {
+                if(!p->keys[i]) {
+                    continue;
+                }
+                uint64_t child_off = freeze_node(p->children[p->keys[i] - 1], buf);
+                memcpy(buf.data() + off + offsetof(art_frozen_node48, children) +
+                       (p->keys[i] - 1) * sizeof(uint64_t), &child_off, sizeof(uint64_t));
+            }
+            break;
+        }
+        case NODE256: {
+            const art_node256* p = (const art_node256 *) n;
+            art_frozen_node256 rec;
+            memset(&rec, 0, sizeof(rec));
+            rec.n = header;
+            off = buf_append(buf, &rec, sizeof(rec));
+            for(int i = 0; i < 256; i++) {
+                if(!p->children[i]) {
+                    continue;
+                }
+                uint64_t child_off = freeze_node(p->children[i], buf);
+                memcpy(buf.data() + off + offsetof(art_frozen_node256, children) + i * sizeof(uint64_t),
+                       &child_off, sizeof(uint64_t));
+            }
+            break;
+        }
+        default:
+            abort();
+    }
+
+    return off;
+}
+
+bool art_frozen_write(const art_tree *t, const std::string& path) {
+    std::vector<uint8_t> buf;
+    buf.resize(sizeof(art_frozen_file_header));
+
+    uint64_t root_offset = 0;
+    if(t->root != nullptr) {
+        root_offset = freeze_node(t->root, buf);
+    }
+
+    art_frozen_file_header header;
+    memcpy(header.magic, FROZEN_MAGIC, sizeof(FROZEN_MAGIC));
+    header.root_offset = root_offset;
+    header.num_keys = t->size;
+    header.file_size = buf.size();
+    memcpy(buf.data(), &header, sizeof(header));
+
+    FILE* fp = fopen(path.c_str(), "wb");
+    if(fp == nullptr) {
+        LOG(ERROR) << "Could not open " << path << " for writing ART snapshot.";
+        return false;
+    }
+
+    size_t written = fwrite(buf.data(), 1, buf.size(), fp);
+    fclose(fp);
+
+    if(written != buf.size()) {
+        LOG(ERROR) << "Short write while persisting ART snapshot to " << path;
+        return false;
+    }
+
+    return true;
+}
+
+art_frozen_t* art_frozen_open(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        LOG(ERROR) << "Could not open ART snapshot at " << path;
+        return nullptr;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(art_frozen_file_header)) {
+        LOG(ERROR) << "ART snapshot at " << path << " is truncated.";
+        close(fd);
+        return nullptr;
+    }
+
+    void* base = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(base == MAP_FAILED) {
+        LOG(ERROR) << "Could not mmap ART snapshot at " << path;
+        close(fd);
+        return nullptr;
+    }
+
+    const art_frozen_file_header* header = (const art_frozen_file_header *) base;
+    if(memcmp(header->magic, FROZEN_MAGIC, sizeof(FROZEN_MAGIC)) != 0 ||
+       header->file_size != (uint64_t) st.st_size) {
+        LOG(ERROR) << "ART snapshot at " << path << " failed validation.";
+        munmap(base, st.st_size);
+        close(fd);
+        return nullptr;
+    }
+
+    art_frozen_t* ft = new art_frozen_t();
+    ft->fd = fd;
+    ft->base = (const uint8_t *) base;
+    ft->file_size = st.st_size;
+    ft->root_offset = header->root_offset;
+    ft->num_keys = header->num_keys;
+    art_tree_init(&ft->overlay);
+
+    return ft;
+}
+
+void art_frozen_close(art_frozen_t *ft) {
+    if(ft == nullptr) {
+        return;
+    }
+
+    art_tree_destroy(&ft->overlay);
+    munmap((void *) ft->base, ft->file_size);
+    close(ft->fd);
+    delete ft;
+}
+
+static inline const art_frozen_node* frozen_node_at(const art_frozen_t *ft, uint64_t off) {
+    return (const art_frozen_node *) (ft->base + FROZEN_RAW_OFFSET(off));
+}
+
+static inline const art_frozen_leaf* frozen_leaf_at(const art_frozen_t *ft, uint64_t off) {
+    return (const art_frozen_leaf *) (ft->base + FROZEN_RAW_OFFSET(off));
+}
+
+/**
+ * Returns the tagged offset of the child reached via byte `c`, or 0.
+ */
+static uint64_t frozen_find_child(const art_frozen_node* n, unsigned char c) {
+    switch(n->type) {
+        case NODE4: {
+            const art_frozen_node4* p = (const art_frozen_node4 *) n;
+            for(int i = 0; i < n->num_children; i++) {
+                if(p->keys[i] == c) {
+                    return p->children[i];
+                }
+            }
+            break;
+        }
+        case NODE16: {
+            const art_frozen_node16* p = (const art_frozen_node16 *) n;
+            for(int i = 0; i < n->num_children; i++) {
+                if(p->keys[i] == c) {
+                    return p->children[i];
+                }
+            }
+            break;
+        }
+        case NODE48: {
+            const art_frozen_node48* p = (const art_frozen_node48 *) n;
+            if(p->keys[c]) {
+                return p->children[p->keys[c] - 1];
+            }
+            break;
+        }
+        case NODE256: {
+            const art_frozen_node256* p = (const art_frozen_node256 *) n;
+            return p->children[c];
+        }
+        default:
+            abort();
+    }
+
+    return 0;
+}
+
+static int frozen_check_prefix(const art_frozen_node *n, const unsigned char *key, int key_len, int depth) {
+    int max_cmp = min(min(n->partial_len, MAX_PREFIX_LEN), key_len - depth);
+    int idx;
+    for(idx = 0; idx < max_cmp; idx++) {
+        if(n->partial[idx] != key[depth + idx]) {
+            return idx;
+        }
+    }
+    return idx;
+}
+
+/**
+ * Returns the left-most leaf under the record at `off`.
+ */
+static const art_frozen_leaf* frozen_minimum(const art_frozen_t *ft, uint64_t off) {
+    while(!FROZEN_IS_LEAF(off)) {
+        const art_frozen_node* n = frozen_node_at(ft, off);
+        switch(n->type) {
+            case NODE4:
+                off = ((const art_frozen_node4 *) n)->children[0];
+                break;
+            case NODE16:
+                off = ((const art_frozen_node16 *) n)->children[0];
+                break;
+            case NODE48: {
+                const art_frozen_node48* p = (const art_frozen_node48 *) n;
+                int idx = 0;
+                while(!p->keys[idx]) idx++;
+                off = p->children[p->keys[idx] - 1];
+                break;
+            }
+            case NODE256: {
+                const art_frozen_node256* p = (const art_frozen_node256 *) n;
+                int idx = 0;
+                while(!p->children[idx]) idx++;
+                off = p->children[idx];
+                break;
+            }
+            default:
+                abort();
+        }
+    }
+
+    return frozen_leaf_at(ft, off);
+}
+
+const art_frozen_leaf* art_frozen_find(const art_frozen_t *ft, const unsigned char *key, int key_len) {
+    if(ft->root_offset == 0) {
+        return nullptr;
+    }
+
+    uint64_t off = ft->root_offset;
+    int depth = 0;
+
+    while(off != 0) {
+        if(FROZEN_IS_LEAF(off)) {
+            const art_frozen_leaf* l = frozen_leaf_at(ft, off);
+            if(l->key_len == (uint32_t) key_len && memcmp(l->key(), key, key_len) == 0) {
+                return l;
+            }
+            return nullptr;
+        }
+
+        const art_frozen_node* n = frozen_node_at(ft, off);
+
+        if(n->partial_len) {
+            int prefix_len = frozen_check_prefix(n, key, key_len, depth);
+            if(prefix_len != min(MAX_PREFIX_LEN, n->partial_len)) {
+                return nullptr;
+            }
+
+            depth = depth + n->partial_len;
+            if(depth >= key_len) {
+                return nullptr;
+            }
+        }
+
+        off = frozen_find_child(n, key[depth]);
+        depth++;
+    }
+
+    return nullptr;
+}
+
+art_leaf* art_frozen_materialize(const art_frozen_leaf *fl, const unsigned char *key, art_tree *t) {
+    std::vector<art_document> documents;
+    documents.reserve(fl->num_ids);
+
+    const uint32_t* ids = fl->ids();
+    const uint32_t* offset_index = fl->offset_index();
+    const uint32_t* offsets = fl->offsets();
+
+    for(uint32_t i = 0; i < fl->num_ids; i++) {
+        uint32_t offsets_start = offset_index[i];
+        uint32_t offsets_end = (i + 1 < fl->num_ids) ? offset_index[i + 1] : fl->num_offsets;
+        std::vector<uint32_t> doc_offsets(offsets + offsets_start, offsets + offsets_end);
+        documents.emplace_back(ids[i], fl->max_score, doc_offsets);
+    }
+
+    art_inserts(t, key, fl->key_len, fl->max_score, documents);
+    return (art_leaf *) art_search(t, key, fl->key_len);
+}
+
+void* art_frozen_search(art_frozen_t *ft, const unsigned char *key, int key_len) {
+    art_leaf* overlay_leaf = (art_leaf *) art_search(&ft->overlay, key, key_len);
+    if(overlay_leaf != nullptr) {
+        return overlay_leaf->values;
+    }
+
+    const art_frozen_leaf* fl = art_frozen_find(ft, key, key_len);
+    if(fl == nullptr) {
+        return nullptr;
+    }
+
+    art_leaf* live = art_frozen_materialize(fl, key, &ft->overlay);
+    return live == nullptr ? nullptr : live->values;
+}
+
+static int frozen_leaf_prefix_matches(const art_frozen_leaf *l, const unsigned char *prefix, int prefix_len) {
+    if(l->key_len < (uint32_t) prefix_len) {
+        return 1;
+    }
+
+    return memcmp(l->key(), prefix, prefix_len);
+}
+
+static int frozen_recursive_iter(const art_frozen_t *ft, uint64_t off, art_frozen_callback cb, void *data) {
+    if(off == 0) {
+        return 0;
+    }
+
+    if(FROZEN_IS_LEAF(off)) {
+        const art_frozen_leaf* l = frozen_leaf_at(ft, off);
+        return cb(data, l->key(), l->key_len, l);
+    }
+
+    const art_frozen_node* n = frozen_node_at(ft, off);
+    int res;
+
+    switch(n->type) {
+        case NODE4: {
+            const art_frozen_node4* p = (const art_frozen_node4 *) n;
+            for(int i = 0; i < n->num_children; i++) {
+                res = frozen_recursive_iter(ft, p->children[i], cb, data);
+                if(res) return res;
+            }
+            break;
+        }
+        case NODE16: {
+            const art_frozen_node16* p = (const art_frozen_node16 *) n;
+            for(int i = 0; i < n->num_children; i++) {
+                res = frozen_recursive_iter(ft, p->children[i], cb, data);
+                if(res) return res;
+            }
+            break;
+        }
+        case NODE48: {
+            const art_frozen_node48* p = (const art_frozen_node48 *) n;
+            for(int i = 0; i < 256; i++) {
+                if(!p->keys[i]) continue;
+                res = frozen_recursive_iter(ft, p->children[p->keys[i] - 1], cb, data);
+                if(res) return res;
+            }
+            break;
+        }
+        case NODE256: {
+            const art_frozen_node256* p = (const art_frozen_node256 *) n;
+            for(int i = 0; i < 256; i++) {
+                if(!p->children[i]) continue;
+                res = frozen_recursive_iter(ft, p->children[i], cb, data);
+                if(res) return res;
+            }
+            break;
+        }
+        default:
+            abort();
+    }
+
+    return 0;
+}
+
+/**
+ * Like prefix_mismatch() on the live tree: compares the node's prefix with
+ * the key, consulting the subtree's minimum leaf when the prefix is longer
+ * than the stored partial bytes.
+ */
+static int frozen_prefix_mismatch(const art_frozen_t *ft, uint64_t off, const art_frozen_node *n,
+                                  const unsigned char *key, int key_len, int depth) {
+    int max_cmp = min(min(MAX_PREFIX_LEN, n->partial_len), key_len - depth);
+    int idx;
+    for(idx = 0; idx < max_cmp; idx++) {
+        if(n->partial[idx] != key[depth + idx]) {
+            return idx;
+        }
+    }
+
+    if(n->partial_len > MAX_PREFIX_LEN) {
+        const art_frozen_leaf* l = frozen_minimum(ft, off);
+        max_cmp = min(l->key_len, (uint32_t) key_len) - depth;
+        for(; idx < max_cmp; idx++) {
+            if(l->key()[idx + depth] != key[depth + idx]) {
+                return idx;
+            }
+        }
+    }
+
+    return idx;
+}
+
+int art_frozen_iter_prefix(const art_frozen_t *ft, const unsigned char *prefix, int prefix_len,
+                           art_frozen_callback cb, void *data) {
+    uint64_t off = ft->root_offset;
+    int depth = 0;
+
+    while(off != 0) {
+        if(FROZEN_IS_LEAF(off)) {
+            const art_frozen_leaf* l = frozen_leaf_at(ft, off);
+            if(!frozen_leaf_prefix_matches(l, prefix, prefix_len)) {
+                return cb(data, l->key(), l->key_len, l);
+            }
+            return 0;
+        }
+
+        const art_frozen_node* n = frozen_node_at(ft, off);
+
+        if(depth == prefix_len) {
+            const art_frozen_leaf* l = frozen_minimum(ft, off);
+            if(!frozen_leaf_prefix_matches(l, prefix, prefix_len)) {
+                return frozen_recursive_iter(ft, off, cb, data);
+            }
+            return 0;
+        }
+
+        if(n->partial_len) {
+            int mismatch = frozen_prefix_mismatch(ft, off, n, prefix, prefix_len, depth);
+
+            if(mismatch > n->partial_len) {
+                mismatch = n->partial_len;
+            }
+
+            if(!mismatch) {
+                return 0;
+            } else if(depth + mismatch == prefix_len) {
+                return frozen_recursive_iter(ft, off, cb, data);
+            } else if(depth + n->partial_len >= prefix_len) {
+                return 0;
+            }
+
+            depth = depth + n->partial_len;
+        }
+
+        off = frozen_find_child(n, prefix[depth]);
+        depth++;
+    }
+
+    return 0;
+}
@@ -13,6 +13,11 @@ Option<bool> AuthManager::init(Store* store, const std::string& bootstrap_auth_k
     this->store = store;
     this->bootstrap_auth_key = bootstrap_auth_key;
 
+    {
+        std::unique_lock cache_lock(auth_cache_mutex);
+        auth_cache.clear();
+    }
+
     std::string next_api_key_id_str;
     StoreStatus next_api_key_id_status = store->get(API_KEY_NEXT_ID_KEY, next_api_key_id_str);
 
@@ -111,6 +116,10 @@ Option<api_key_t> AuthManager::create_key(api_key_t& api_key) {
     }
 
     api_keys.emplace(api_key.value, api_key);
+
+    std::unique_lock cache_lock(auth_cache_mutex);
+    auth_cache.clear();
+
     return Option<api_key_t>(api_key);
 }
 
@@ -131,6 +140,10 @@ Option<api_key_t> AuthManager::remove_key(uint32_t id) {
     api_key_t&& key = key_op.get();
     api_keys.erase(key.value);
 
+    // a revoked key must stop authenticating immediately
+    std::unique_lock cache_lock(auth_cache_mutex);
+    auth_cache.clear();
+
     return Option<api_key_t>(key.truncate_value());
 }
 
@@ -139,26 +152,76 @@ uint32_t AuthManager::get_next_api_key_id() {
     return next_api_key_id++;
 }
 
+uint64_t AuthManager::auth_request_hash(const std::string& req_api_key, const std::string& action,
+                                        const std::vector<std::string>& collections) {
+    std::string hash_input = req_api_key + "$" + action;
+
+    for(const std::string& collection: collections) {
+        hash_input += "$";
+        hash_input += collection;
+    }
+
+    return StringUtils::hash_wy(hash_input.c_str(), hash_input.size());
+}
+
 bool AuthManager::authenticate(const std::string& req_api_key, const std::string& action,
                                const std::vector<std::string>& collections,
                                std::map<std::string, std::string>& params) const {
 
+    const uint64_t auth_hash = auth_request_hash(req_api_key, action, collections);
+
+    {
+        // only positive decisions are cached, so a hit needs just an expiry re-check;
+        // an expired entry falls through so that the full check can log and reject
+        std::shared_lock cache_lock(auth_cache_mutex);
+        const auto& hit_it = auth_cache.find(auth_hash);
+
+        if(hit_it != auth_cache.end() && uint64_t(std::time(0)) <= hit_it.value().expires_at) {
+            nlohmann::json embedded_params = hit_it.value().embedded_params;
+            cache_lock.unlock();
+
+            for(auto& item: embedded_params.items()) {
+                if(item.key() == "expires_at") {
+                    continue;
+                }
+
+                // overwrite = true as embedded params have higher priority
+                AuthManager::add_item_to_params(params, item, true);
+            }
+
+            return true;
+        }
+    }
+
     std::shared_lock lock(mutex);
     //LOG(INFO) << "AuthManager::authenticate()";
 
     const auto& key_it = api_keys.find(req_api_key);
     if(key_it != api_keys.end()) {
         const api_key_t& api_key = key_it->second;
-        return auth_against_key(collections, action, api_key, false);
+        bool allowed = auth_against_key(collections, action, api_key, false);
+
+        if(allowed) {
+            std::unique_lock cache_lock(auth_cache_mutex);
+            auth_cache.insert(auth_hash, cached_auth_t{api_key.expires_at, nlohmann::json::object()});
+        }
+
+        return allowed;
     }
 
     // could be a scoped API key
     nlohmann::json embedded_params;
-    Option<bool> auth_op = authenticate_parse_params(req_api_key, action, collections, embedded_params);
+    uint64_t expiry_ts = api_key_t::FAR_FUTURE_TIMESTAMP;
+    Option<bool> auth_op = authenticate_parse_params(req_api_key, action, collections, embedded_params, expiry_ts);
     if(!auth_op.ok()) {
         return false;
     }
 
+    {
+        std::unique_lock cache_lock(auth_cache_mutex);
+        auth_cache.insert(auth_hash, cached_auth_t{expiry_ts, embedded_params});
+    }
+
     // enrich params with values from embedded_params
     for(auto& item: embedded_params.items()) {
         if(item.key() == "expires_at") {
@@ -236,7 +299,7 @@ bool AuthManager::auth_against_key(const std::vector<std::string>& collections,
 
 Option<bool> AuthManager::authenticate_parse_params(const std::string& scoped_api_key, const std::string& action,
                                                     const std::vector<std::string>& collections,
-                                                    nlohmann::json& embedded_params) const {
+                                                    nlohmann::json& embedded_params, uint64_t& expiry_ts) const {
 
     // allow only searches from scoped keys
     if(action != DOCUMENTS_SEARCH_ACTION) {
@@ -286,6 +349,8 @@ Option<bool> AuthManager::authenticate_parse_params(const std::string& scoped_ap
                     return Option<bool>(403, "Forbidden.");
                 }
 
+                expiry_ts = api_key.expires_at;
+
                 if(embedded_params.count("expires_at") != 0) {
                     if(!embedded_params["expires_at"].is_number_integer() || embedded_params["expires_at"].get<int64_t>() < 0) {
                         LOG(ERROR) << fmt_error("Wrong format for `expires_at`. It should be an unsigned integer.", api_key.value);
@@ -293,7 +358,7 @@ Option<bool> AuthManager::authenticate_parse_params(const std::string& scoped_ap
                     }
 
                     // if parent key's expiry timestamp is smaller, it takes precedence
-                    uint64_t expiry_ts = std::min(api_key.expires_at, embedded_params["expires_at"].get<uint64_t>());
+                    expiry_ts = std::min(api_key.expires_at, embedded_params["expires_at"].get<uint64_t>());
 
                     if(uint64_t(std::time(0)) > expiry_ts) {
                         LOG(ERROR) << fmt_error("Scoped API key has expired. ", api_key.value);
@@ -1,14 +1,37 @@
 #include "batched_indexer.h"
 #include "core_api.h"
 #include "thread_local_vars.h"
+#include "app_metrics.h"
+#include <algorithm>
 
-BatchedIndexer::BatchedIndexer(HttpServer* server, Store* store, Store* meta_store, const size_t num_threads):
+BatchedIndexer::BatchedIndexer(HttpServer* server, Store* store, Store* meta_store, const size_t num_threads,
+                               const size_t queue_high_watermark, const size_t queue_low_watermark):
                                server(server), store(store), meta_store(meta_store), num_threads(num_threads),
+                               queue_high_watermark(queue_high_watermark),
+                               queue_low_watermark(queue_low_watermark),
                                last_gc_run(std::chrono::high_resolution_clock::now()), quit(false) {
     queues.resize(num_threads);
+    queue_pending_reqs.resize(num_threads, 0);
     qmutuxes = new await_t[num_threads];
 }
 
+uint32_t BatchedIndexer::get_queue_id(const std::string& collection_name) {
+    const auto it = collection_queue_ids.find(collection_name);
+    if(it != collection_queue_ids.end()) {
+        return it->second;
+    }
+
+    uint32_t queue_id = 0;
+    for(uint32_t i = 1; i < num_threads; i++) {
+        if(queue_pending_reqs[i] < queue_pending_reqs[queue_id]) {
+            queue_id = i;
+        }
+    }
+
+    collection_queue_ids.emplace(collection_name, queue_id);
+    return queue_id;
+}
+
 void BatchedIndexer::enqueue(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
     // Called by the raft write thread: goal is to quickly send the request to a queue and move on
     // NOTE: it's ok to access `req` and `res` in this function without synchronization
@@ -16,6 +39,8 @@ void BatchedIndexer::enqueue(const std::shared_ptr<http_req>& req, const std::sh
 
     //LOG(INFO) << "BatchedIndexer::enqueue";
     uint32_t chunk_sequence = 0;
+    std::string chunk_value = req->to_json();
+    bool chunk_buffered = false;
 
     {
         uint64_t now = std::chrono::duration_cast<std::chrono::seconds>(
@@ -27,20 +52,30 @@ void BatchedIndexer::enqueue(const std::shared_ptr<http_req>& req, const std::sh
         if(req_res_map_it == req_res_map.end()) {
             // first chunk
             req_res_t req_res(req->start_ts, "", req, res, now, 1, 0, false);
-            req_res_map.emplace(req->start_ts, req_res);
+            req_res_map_it = req_res_map.emplace(req->start_ts, req_res).first;
         } else {
             chunk_sequence = req_res_map_it->second.num_chunks;
             req_res_map_it->second.num_chunks += 1;
             req_res_map_it->second.last_updated = now;
         }
-    }
 
-    const std::string& req_key_prefix = get_req_prefix_key(req->start_ts);
-    const std::string& request_chunk_key = req_key_prefix + StringUtils::serialize_uint32_t(chunk_sequence);
+        // Buffer the chunk in memory when there's room, so the indexing thread can skip the store round-trip.
+        // Only a contiguous prefix is buffered: once a chunk spills to the store, later chunks spill too.
+        if(req_res_map_it->second.chunk_buffer.size() == chunk_sequence &&
+           buffered_chunks_bytes + chunk_value.size() <= CHUNK_BUFFER_MAX_BYTES) {
+            buffered_chunks_bytes += chunk_value.size();
+            req_res_map_it->second.chunk_buffer.emplace_back(std::move(chunk_value));
+            chunk_buffered = true;
+        }
+    }
 
     //LOG(INFO) << "request_chunk_key: " << req->start_ts << "_" << chunk_sequence << ", req body: " << req->body;
 
-    store->insert(request_chunk_key, req->to_json());
+    if(!chunk_buffered) {
+        const std::string& req_key_prefix = get_req_prefix_key(req->start_ts);
+        const std::string& request_chunk_key = req_key_prefix + StringUtils::serialize_uint32_t(chunk_sequence);
+        store->insert(request_chunk_key, chunk_value);
+    }
 
     bool is_old_serialized_request = (req->start_ts == 0);
     bool read_more_input = (req->_req != nullptr && req->_req->proceed_req);
@@ -49,13 +84,21 @@ void BatchedIndexer::enqueue(const std::shared_ptr<http_req>& req, const std::sh
         //LOG(INFO) << "Last chunk for req_id: " << req->start_ts;
         queued_writes += (chunk_sequence + 1);
 
+        if(queue_high_watermark != 0 && size_t(queued_writes.load()) > queue_high_watermark &&
+           !write_backpressured.exchange(true)) {
+            LOG(WARNING) << "Write queue crossed high watermark of " << queue_high_watermark
+                         << ", imports will be rejected until it drains below " << queue_low_watermark << ".";
+        }
+
         {
             const std::string& coll_name = get_collection_name(req);
-            uint64_t queue_id = StringUtils::hash_wy(coll_name.c_str(), coll_name.size()) % num_threads;
             req->body = "";
 
+            uint32_t queue_id;
             {
                 std::unique_lock lk2(mutex);
+                queue_id = get_queue_id(coll_name);
+                queue_pending_reqs[queue_id]++;
                 req_res_map[req->start_ts].is_complete = true;
             }
 
@@ -91,7 +134,7 @@ void BatchedIndexer::enqueue(const std::shared_ptr<http_req>& req, const std::sh
     if(read_more_input) {
         // Tell the http library to read more input data
         deferred_req_res_t* req_res = new deferred_req_res_t(req, res, server, true);
-        server->get_message_dispatcher()->send_message(HttpServer::REQUEST_PROCEED_MESSAGE, req_res);
+        server->get_message_dispatcher(req)->send_message(HttpServer::REQUEST_PROCEED_MESSAGE, req_res);
     }
 }
 
@@ -118,7 +161,9 @@ std::string BatchedIndexer::get_collection_name(const std::shared_ptr<http_req>&
 
 void BatchedIndexer::run() {
     LOG(INFO) << "Starting batch indexer with " << num_threads << " threads.";
-    ThreadPool* thread_pool = new ThreadPool(num_threads);
+    // a collection always maps to the same queue + worker, so pinning workers
+    // across NUMA nodes keeps each collection's index memory on a single node
+    ThreadPool* thread_pool = new ThreadPool(num_threads, true);
 
     skip_index_iter = meta_store->scan(SKIP_INDICES_PREFIX);
     populate_skip_index();
@@ -146,19 +191,18 @@ void BatchedIndexer::run() {
                 auto req_res_map_it = req_res_map.find(req_id);
                 if(req_res_map_it == req_res_map.end()) {
                     LOG(ERROR) << "Req ID " << req_id << " not found in req_res_map.";
+                    queue_pending_reqs[i]--;
                     continue;
                 }
 
                 req_res_t& orig_req_res = req_res_map_it->second;
                 mlk.unlock();
 
-                // scan db for all logs associated with request
                 const std::string& req_key_prefix = get_req_prefix_key(req_id);
+                const uint32_t num_chunks = orig_req_res.num_chunks;
 
-                const std::string& req_key_start_prefix = get_req_prefix_key(req_id) +
-                                                    StringUtils::serialize_uint32_t(orig_req_res.next_chunk_index);
-
-                rocksdb::Iterator* iter = store->scan(req_key_start_prefix);
+                // iterator for chunks that spilled to the store, created lazily on first use
+                rocksdb::Iterator* iter = nullptr;
 
                 // used to handle partial JSON documents caused by chunking
                 std::string& prev_body = orig_req_res.prev_req_body;
@@ -171,10 +215,36 @@ void BatchedIndexer::run() {
                 bool route_found = server->get_route(orig_req->route_hash, &found_rpath);
                 bool async_res = false;
 
-                while(iter->Valid() && iter->key().starts_with(req_key_prefix)) {
+                while(orig_req_res.next_chunk_index < num_chunks) {
                     std::shared_lock slk(pause_mutex); // used for snapshot
+                    const uint32_t chunk_index = orig_req_res.next_chunk_index;
+                    std::string chunk_value;
+                    bool chunk_in_memory = false;
+
+                    {
+                        // chunk is usually buffered in memory; otherwise it has spilled to the store
+                        std::unique_lock clk(mutex);
+                        if(chunk_index < orig_req_res.chunk_buffer.size()) {
+                            chunk_value = std::move(orig_req_res.chunk_buffer[chunk_index]);
+                            buffered_chunks_bytes -= chunk_value.size();
+                            chunk_in_memory = true;
+                        }
+                    }
+
+                    if(!chunk_in_memory) {
+                        if(iter == nullptr) {
+                            iter = store->scan(req_key_prefix + StringUtils::serialize_uint32_t(chunk_index));
+                        }
+
+                        if(!iter->Valid() || !iter->key().starts_with(req_key_prefix)) {
+                            break;
+                        }
+
+                        chunk_value = iter->value().ToString();
+                    }
+
                     orig_req->body = prev_body;
-                    orig_req->load_from_json(iter->value().ToString());
+                    orig_req->load_from_json(chunk_value);
 
                     // update thread local for reference during a crash
                     write_log_index = orig_req->log_index;
@@ -199,7 +269,7 @@ void BatchedIndexer::run() {
                         if(is_live_req && (!route_found ||!async_res)) {
                             // sync request get a response immediately
                             async_req_res_t* async_req_res = new async_req_res_t(orig_req, orig_res, true);
-                            server->get_message_dispatcher()->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
+                            server->get_message_dispatcher(orig_req)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
                         }
 
                         if(!route_found) {
@@ -208,8 +278,30 @@ void BatchedIndexer::run() {
                     }
 
                     queued_writes--;
+                    processed_writes++;
+
+                    if(write_backpressured.load() && size_t(queued_writes.load()) <= queue_low_watermark) {
+                        if(write_backpressured.exchange(false)) {
+                            LOG(INFO) << "Write queue drained below low watermark of " << queue_low_watermark
+                                      << ", accepting imports again.";
+                        }
+
+                        // wake up anyone waiting out the drain
+                        std::lock_guard<std::mutex> drain_lk(drain_await.mcv);
+                        drain_await.cv.notify_all();
+                    }
+
                     orig_req_res.next_chunk_index++;
-                    iter->Next();
+
+                    if(!chunk_in_memory) {
+                        iter->Next();
+                    }
+
+                    const uint32_t chunk_delay_ms = replay_delay_ms.load();
+                    if(chunk_delay_ms != 0) {
+                        // search-priority catch-up throttle (see the monitor loop below)
+                        std::this_thread::sleep_for(std::chrono::milliseconds(chunk_delay_ms));
+                    }
 
                     if(quit) {
                         break;
@@ -224,14 +316,57 @@ void BatchedIndexer::run() {
                 store->delete_range(req_key_prefix, req_key_prefix + StringUtils::serialize_uint32_t(UINT32_MAX));
 
                 std::unique_lock lk(mutex);
-                req_res_map.erase(req_id);
+                auto erase_it = req_res_map.find(req_id);
+                if(erase_it != req_res_map.end()) {
+                    release_buffered_chunks(erase_it->second);
+                    req_res_map.erase(erase_it);
+                }
+
+                queue_pending_reqs[i]--;
             }
         });
     }
 
+    uint64_t prev_processed_writes = 0;
+
     while(!quit) {
         std::this_thread::sleep_for(std::chrono::milliseconds (1000));
 
+        // sample the drain rate over the last second (used for Retry-After estimates)
+        const uint64_t processed_writes_now = processed_writes.load();
+        drain_rate_per_sec = int64_t(processed_writes_now - prev_processed_writes);
+        prev_processed_writes = processed_writes_now;
+
+        // search-priority catch-up throttle: when a large backlog (e.g. a rejoining
+        // node replaying the log) degrades search latency, slow down replay a little
+        // at a time, and speed back up once searches recover or the queue drains
+        const uint64_t search_latency_ms = AppMetrics::get_instance().get_avg_duration(AppMetrics::SEARCH_LABEL);
+        const bool backlogged = queued_writes.load() >= int64_t(REPLAY_THROTTLE_MIN_QUEUE);
+
+        if(search_latency_ms != 0 && !backlogged) {
+            // learn the baseline latency while no meaningful backlog is applying
+            baseline_search_latency_ms = (baseline_search_latency_ms == 0) ? search_latency_ms :
+                                         (baseline_search_latency_ms * 7 + search_latency_ms) / 8;
+        }
+
+        const uint64_t degraded_latency_ms = std::max<uint64_t>(2 * baseline_search_latency_ms, 10);
+
+        if(backlogged && search_latency_ms > degraded_latency_ms) {
+            // additive increase while searches stay slow
+            const uint32_t new_delay = std::min(replay_delay_ms.load() + 1, REPLAY_DELAY_MAX_MS);
+            if(replay_delay_ms.exchange(new_delay) == 0) {
+                LOG(INFO) << "Throttling catch-up replay: search latency is " << search_latency_ms
+                          << " ms against a baseline of " << baseline_search_latency_ms << " ms.";
+            }
+        } else if(replay_delay_ms.load() != 0) {
+            // multiplicative decrease once latency recovers or the queue drains
+            const uint32_t new_delay = replay_delay_ms.load() / 2;
+            replay_delay_ms = new_delay;
+            if(new_delay == 0) {
+                LOG(INFO) << "Catch-up replay resumed at full speed.";
+            }
+        }
+
         // do gc, if we are due for one
         uint64_t seconds_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
                 std::chrono::high_resolution_clock::now() - last_gc_run).count();
@@ -242,7 +377,7 @@ void BatchedIndexer::run() {
             LOG(INFO) << "Running GC for aborted requests, req map size: " << req_res_map.size();
 
             // iterate through all map entries and delete ones which are not complete but > GC_PRUNE_MAX_SECONDS
-            for (auto it = req_res_map.cbegin(); it != req_res_map.cend();) {
+            for (auto it = req_res_map.begin(); it != req_res_map.end();) {
                 uint64_t seconds_since_batch_update = std::chrono::duration_cast<std::chrono::seconds>(
                         std::chrono::system_clock::now().time_since_epoch()).count() - it->second.last_updated;
 
@@ -254,11 +389,12 @@ void BatchedIndexer::run() {
 
                     const std::string& req_key_prefix = get_req_prefix_key(it->second.start_ts);
                     store->delete_range(req_key_prefix, req_key_prefix + StringUtils::serialize_uint32_t(UINT32_MAX));
+                    release_buffered_chunks(it->second);
 
                     if(it->second.res->is_alive) {
                         it->second.res->final = true;
                         async_req_res_t* async_req_res = new async_req_res_t(it->second.req, it->second.res, true);
-                        server->get_message_dispatcher()->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
+                        server->get_message_dispatcher(it->second.req)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
                     }
 
                     it = req_res_map.erase(it);
@@ -304,6 +440,37 @@ int64_t BatchedIndexer::get_queued_writes() {
     return queued_writes;
 }
 
+bool BatchedIndexer::is_write_backpressured() {
+    return write_backpressured.load();
+}
+
+int64_t BatchedIndexer::get_drain_rate() {
+    return drain_rate_per_sec.load();
+}
+
+size_t BatchedIndexer::get_retry_after_secs() {
+    const int64_t excess_writes = queued_writes.load() - int64_t(queue_low_watermark);
+    const int64_t drain_rate = drain_rate_per_sec.load();
+
+    if(excess_writes <= 0) {
+        return 1;
+    }
+
+    if(drain_rate <= 0) {
+        // no writes drained in the last second, ask the client to back off for a while
+        return 30;
+    }
+
+    return std::min<size_t>(60, std::max<size_t>(1, excess_writes / drain_rate));
+}
+
+bool BatchedIndexer::await_drain(const size_t timeout_ms) {
+    std::unique_lock<std::mutex> lk(drain_await.mcv);
+    return drain_await.cv.wait_for(lk, std::chrono::milliseconds(timeout_ms), [this] {
+        return quit.load() || !write_backpressured.load();
+    });
+}
+
 void BatchedIndexer::populate_skip_index() {
     if(skip_index_iter->Valid() && skip_index_iter->key().starts_with(SKIP_INDICES_PREFIX)) {
         const std::string& index_value = skip_index_iter->value().ToString();
@@ -332,6 +499,16 @@ void BatchedIndexer::serialize_state(nlohmann::json& state) {
     std::unique_lock lk(mutex);
 
     for(auto& kv: req_res_map) {
+        // pending in-memory chunks must be flushed to the store so the snapshot can be replayed from it
+        const std::string& req_key_prefix = get_req_prefix_key(kv.first);
+        for(uint32_t chunk_index = kv.second.next_chunk_index;
+            chunk_index < kv.second.chunk_buffer.size(); chunk_index++) {
+            const std::string& request_chunk_key = req_key_prefix + StringUtils::serialize_uint32_t(chunk_index);
+            store->insert(request_chunk_key, kv.second.chunk_buffer[chunk_index]);
+        }
+
+        release_buffered_chunks(kv.second);
+
         std::string req_key = std::to_string(kv.first);
         state["req_res_map"].emplace(req_key, nlohmann::json());
         nlohmann::json& req_res = state["req_res_map"][req_key];
@@ -381,7 +558,14 @@ void BatchedIndexer::load_state(const nlohmann::json& state) {
                       << ", req_res.next_chunk_index: " << req_res.next_chunk_index;
 
             const std::string& coll_name = get_collection_name(req);
-            uint64_t queue_id = StringUtils::hash_wy(coll_name.c_str(), coll_name.size()) % num_threads;
+
+            uint32_t queue_id;
+            {
+                std::unique_lock mlk(mutex);
+                queue_id = get_queue_id(coll_name);
+                queue_pending_reqs[queue_id]++;
+            }
+
             queue_ids.insert(queue_id);
             std::unique_lock qlk(qmutuxes[queue_id].mcv);
             queues[queue_id].emplace_back(req->start_ts);
@@ -400,6 +584,15 @@ void BatchedIndexer::load_state(const nlohmann::json& state) {
     LOG(INFO) << "Restored " << num_reqs_restored << " in-flight requests from snapshot.";
 }
 
+void BatchedIndexer::release_buffered_chunks(req_res_t& req_res) {
+    for(const std::string& chunk: req_res.chunk_buffer) {
+        buffered_chunks_bytes -= chunk.size();
+    }
+
+    req_res.chunk_buffer.clear();
+    req_res.chunk_buffer.shrink_to_fit();
+}
+
 std::shared_mutex& BatchedIndexer::get_pause_mutex() {
     return pause_mutex;
 }
@@ -15,6 +15,9 @@
 #include <regex>
 #include <list>
 #include <posting.h>
+#include <app_metrics.h>
+#include <config.h>
+#include "index_snapshot.h"
 #include "topster.h"
 #include "logger.h"
 #include "thread_local_vars.h"
@@ -46,7 +49,7 @@ Collection::Collection(const std::string& name, const uint32_t collection_id, co
                        const float max_memory_ratio, const std::string& fallback_field_type,
                        const std::vector<std::string>& symbols_to_index, const std::vector<std::string>& token_separators):
         name(name), collection_id(collection_id), created_at(created_at),
-        next_seq_id(next_seq_id), store(store),
+        next_seq_id(next_seq_id), seq_id_ceiling(next_seq_id), write_epoch(0), store(store),
         fields(fields), default_sorting_field(default_sorting_field),
         max_memory_ratio(max_memory_ratio),
         fallback_field_type(fallback_field_type), dynamic_fields({}),
@@ -59,25 +62,45 @@ Collection::Collection(const std::string& name, const uint32_t collection_id, co
 Collection::~Collection() {
     std::unique_lock lock(mutex);
     delete index;
+
+    for(auto& kv: query_plan_cache) {
+        delete kv.second;
+    }
+
+    for(auto& kv: doc_cache) {
+        delete kv.second;
+    }
 }
 
 uint32_t Collection::get_next_seq_id() {
     std::shared_lock lock(mutex);
-    store->increment(get_next_seq_id_key(name), 1);
-    return next_seq_id++;
+    const uint32_t seq_id = next_seq_id++;
+
+    if(seq_id >= seq_id_ceiling.load()) {
+        std::lock_guard<std::mutex> reserve_lock(seq_id_reserve_mutex);
+
+        // the current block is exhausted: reserve the next one with a single
+        // store write, after which allocation stays in-memory again. The store
+        // holds the ceiling, so a crash skips to the end of the block instead
+        // of ever re-issuing a handed-out id.
+        while(seq_id >= seq_id_ceiling.load()) {
+            const uint32_t new_ceiling = seq_id_ceiling.load() + SEQ_ID_BLOCK_SIZE;
+            if(!store->insert(get_next_seq_id_key(name), StringUtils::serialize_uint32_t(new_ceiling))) {
+                LOG(ERROR) << "Could not persist the sequence ID block of collection " << name;
+            }
+            seq_id_ceiling = new_ceiling;
+        }
+    }
+
+    return seq_id;
 }
 
-Option<doc_seq_id_t> Collection::to_doc(const std::string & json_str, nlohmann::json& document,
+// expects `document` to have been parsed already (see the parse-ahead
+// pipeline in add_many)
+Option<doc_seq_id_t> Collection::to_doc(nlohmann::json& document,
                                         const index_operation_t& operation,
                                         const DIRTY_VALUES dirty_values,
                                         const std::string& id) {
-    try {
-        document = nlohmann::json::parse(json_str);
-    } catch(const std::exception& e) {
-        LOG(ERROR) << "JSON error: " << e.what();
-        return Option<doc_seq_id_t>(400, std::string("Bad JSON: ") + e.what());
-    }
-
     if(!document.is_object()) {
         return Option<doc_seq_id_t>(400, "Bad JSON: not a properly formed document.");
     }
@@ -168,6 +191,7 @@ nlohmann::json Collection::get_summary_json() const {
         field_json[fields::facet] = coll_field.facet;
         field_json[fields::optional] = coll_field.optional;
         field_json[fields::index] = coll_field.index;
+        field_json[fields::materialize] = coll_field.materialize;
 
         fields_arr.push_back(field_json);
     }
@@ -177,6 +201,18 @@ nlohmann::json Collection::get_summary_json() const {
     return json_response;
 }
 
+nlohmann::json Collection::get_stats_json() const {
+    std::shared_lock lock(mutex);
+
+    nlohmann::json stats;
+    stats["name"] = name;
+    stats["num_documents"] = num_documents.load();
+    stats["memory"] = nlohmann::json::object();
+    index->get_memory_stats(stats["memory"]);
+
+    return stats;
+}
+
 Option<nlohmann::json> Collection::add(const std::string & json_str,
                                        const index_operation_t& operation, const std::string& id,
                                        const DIRTY_VALUES& dirty_values) {
@@ -202,8 +238,14 @@ Option<nlohmann::json> Collection::add(const std::string & json_str,
 
 nlohmann::json Collection::add_many(std::vector<std::string>& json_lines, nlohmann::json& document,
                                     const index_operation_t& operation, const std::string& id,
-                                    const DIRTY_VALUES& dirty_values) {
+                                    const DIRTY_VALUES& dirty_values, const bool msgpack_records) {
     //LOG(INFO) << "Memory ratio. Max = " << max_memory_ratio << ", Used = " << SystemMetrics::used_memory_ratio();
+
+    // a write cannot be rejected with a loading status (raft has already
+    // committed it), so it blocks until the index is in memory
+    CollectionManager::get_instance().hydrate_collection_wait(this);
+    update_last_access_timestamp();
+
     std::vector<index_record> index_records;
 
     const size_t index_batch_size = 1000;
@@ -213,12 +255,89 @@ nlohmann::json Collection::add_many(std::vector<std::string>& json_lines, nlohma
     // ensures that document IDs are not repeated within the same batch
     std::set<std::string> batch_doc_ids;
 
+    // parse-ahead pipeline: JSON parsing is the stateless, CPU-heavy part of
+    // ingesting a line, so the next window of lines is parsed on the indexing
+    // pool while the current window is resolved and indexed. Id resolution,
+    // schema updates and indexing remain strictly sequential below.
+    struct parsed_line_t {
+        nlohmann::json doc;
+        std::string parse_error;
+    };
+
+    auto parse_window = [&json_lines, index_batch_size, msgpack_records](size_t start,
+                                                                         std::vector<parsed_line_t>& out) {
+        const size_t end = std::min(start + index_batch_size, json_lines.size());
+        out.clear();
+        out.resize(end - start);
+
+        for(size_t i = start; i < end; i++) {
+            try {
+                out[i - start].doc = msgpack_records ? nlohmann::json::from_msgpack(json_lines[i])
+                                                     : nlohmann::json::parse(json_lines[i]);
+            } catch(const std::exception& e) {
+                LOG(ERROR) << "JSON error: " << e.what();
+                out[i - start].parse_error = std::string(msgpack_records ? "Bad MessagePack: " : "Bad JSON: ")
+                                             + e.what();
+            }
+        }
+    };
+
+    ThreadPool* indexing_thread_pool = CollectionManager::get_instance().get_indexing_thread_pool();
+
+    std::vector<parsed_line_t> curr_parsed, next_parsed;
+    std::future<void> parse_ahead;
+    size_t window_start = 0;
+
+    if(!json_lines.empty()) {
+        parse_window(0, curr_parsed);
+        if(json_lines.size() > index_batch_size) {
+            parse_ahead = indexing_thread_pool->enqueue(parse_window, index_batch_size, std::ref(next_parsed));
+        }
+    }
+
     for(size_t i=0; i < json_lines.size(); i++) {
-        const std::string & json_line = json_lines[i];
-        Option<doc_seq_id_t> doc_seq_id_op = to_doc(json_line, document, operation, dirty_values, id);
+        if(i == window_start + index_batch_size) {
+            // the current window is exhausted: adopt the parsed-ahead one and
+            // kick off parsing of the window after it
+            parse_ahead.get();
+            curr_parsed = std::move(next_parsed);
+            window_start = i;
+
+            if(window_start + index_batch_size < json_lines.size()) {
+                parse_ahead = indexing_thread_pool->enqueue(parse_window, window_start + index_batch_size,
+                                                            std::ref(next_parsed));
+            }
+        }
+
+        parsed_line_t& parsed_line = curr_parsed[i - window_start];
+
+        Option<doc_seq_id_t> doc_seq_id_op = Option<doc_seq_id_t>(400, parsed_line.parse_error);
+        bool had_explicit_id = false;
+        nlohmann::json precomputed_index;
+
+        if(parsed_line.parse_error.empty()) {
+            document = std::move(parsed_line.doc);
+
+            if(document.is_object()) {
+                auto artifacts_it = document.find(Index::PRECOMPUTED_FIELD_INDEX_KEY);
+                if(artifacts_it != document.end()) {
+                    // precomputed indexing artifacts ride along under a reserved key:
+                    // extracted here so they are neither validated as a document field
+                    // nor persisted to disk
+                    precomputed_index = std::move(artifacts_it.value());
+                    document.erase(artifacts_it);
+                }
+            }
+
+            had_explicit_id = document.is_object() && document.count("id") != 0;
+            doc_seq_id_op = to_doc(document, operation, dirty_values, id);
+        } else {
+            document = nlohmann::json();
+        }
 
         const uint32_t seq_id = doc_seq_id_op.ok() ? doc_seq_id_op.get().seq_id : 0;
         index_record record(i, seq_id, document, operation, dirty_values);
+        record.precomputed_index = std::move(precomputed_index);
 
         // NOTE: we overwrite the input json_lines with result to avoid memory pressure
 
@@ -233,6 +352,11 @@ nlohmann::json Collection::add_many(std::vector<std::string>& json_lines, nlohma
 
             if(repeated_doc) {
                 // when a document repeats, we send the batch until this document so that we can deal with conflicts
+                // (the parsed doc is put back since this line will be visited again)
+                parsed_line.doc = std::move(document);
+                if(!record.precomputed_index.is_null()) {
+                    parsed_line.doc[Index::PRECOMPUTED_FIELD_INDEX_KEY] = std::move(record.precomputed_index);
+                }
                 i--;
                 goto do_batched_index;
             }
@@ -251,6 +375,14 @@ nlohmann::json Collection::add_many(std::vector<std::string>& json_lines, nlohma
                 if(!schema_change_op.ok()) {
                     record.index_failure(schema_change_op.code(), schema_change_op.error());
                 }
+            } else if(!record.is_update && had_explicit_id && !msgpack_records &&
+                      record.precomputed_index.is_null()) {
+                // a fresh create whose parsed doc still matches the request line:
+                // keep the line so the disk write can skip re-serialization
+                // (msgpack lines are binary, so they can never stand in for the stored JSON)
+                // (validation clears this if it coerces or drops a field; a stripped
+                // `$field_index` key means the line no longer matches the doc)
+                record.raw_doc = json_lines[i];
             }
         }
 
@@ -287,53 +419,75 @@ void Collection::batch_index(std::vector<index_record>& index_records, std::vect
 
     batch_index_in_memory(index_records);
 
-    // store only documents that were indexed in-memory successfully
-    for(auto& index_record: index_records) {
-        nlohmann::json res;
+    // Store documents that were indexed in-memory successfully. All disk writes of the
+    // batch are aggregated into a single write batch, so RocksDB is hit once per
+    // batch instead of once per document.
+    rocksdb::WriteBatch batch;
+    std::vector<index_record*> pending_writes;
 
-        if(index_record.indexed.ok()) {
-            if(index_record.is_update) {
-                const std::string& serialized_json = index_record.new_doc.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
-                bool write_ok = store->insert(get_seq_id_key(index_record.seq_id), serialized_json);
-
-                if(!write_ok) {
-                    // we will attempt to reindex the old doc on a best-effort basis
-                    LOG(ERROR) << "Update to disk failed. Will restore old document";
-                    remove_document(index_record.new_doc, index_record.seq_id, false);
-                    index_in_memory(index_record.old_doc, index_record.seq_id, index_record.operation, index_record.dirty_values);
-                    index_record.index_failure(500, "Could not write to on-disk storage.");
-                } else {
-                    num_indexed++;
-                    index_record.index_success();
-                }
+    for(auto& index_record: index_records) {
+        if(!index_record.indexed.ok()) {
+            continue;
+        }
 
-            } else {
-                const std::string& seq_id_str = std::to_string(index_record.seq_id);
-                const std::string& serialized_json = index_record.doc.dump(-1, ' ', false,
+        if(index_record.is_update) {
+            const std::string& serialized_json = index_record.new_doc.dump(-1, ' ', false,
                                                                            nlohmann::detail::error_handler_t::ignore);
+            batch.Put(store->get_docs_cf_handle(), get_seq_id_key(index_record.seq_id), serialized_json);
+        } else {
+            const std::string& seq_id_str = std::to_string(index_record.seq_id);
+            const std::string serialized_json = !index_record.raw_doc.empty() ?
+                                                std::move(index_record.raw_doc) :
+                                                index_record.doc.dump(-1, ' ', false,
+                                                                      nlohmann::detail::error_handler_t::ignore);
 
-                rocksdb::WriteBatch batch;
-                batch.Put(get_doc_id_key(index_record.doc["id"]), seq_id_str);
-                batch.Put(get_seq_id_key(index_record.seq_id), serialized_json);
-                bool write_ok = store->batch_write(batch);
+            batch.Put(get_doc_id_key(index_record.doc["id"]), seq_id_str);
+            batch.Put(store->get_docs_cf_handle(), get_seq_id_key(index_record.seq_id), serialized_json);
+        }
 
-                if(!write_ok) {
-                    // remove from in-memory store to keep the state synced
-                    LOG(ERROR) << "Write to disk failed. Will restore old document";
-                    remove_document(index_record.doc, index_record.seq_id, false);
-                    index_record.index_failure(500, "Could not write to on-disk storage.");
-                } else {
-                    num_indexed++;
-                    index_record.index_success();
-                }
-            }
+        pending_writes.push_back(&index_record);
+    }
+
+    bool write_ok = (batch.Count() == 0) || store->batch_write(batch);
 
-            res["success"] = index_record.indexed.ok();
-            if(!index_record.indexed.ok()) {
-                res["document"] = json_out[index_record.position];
-                res["error"] = index_record.indexed.error();
-                res["code"] = index_record.indexed.code();
+    if(write_ok && !pending_writes.empty()) {
+        // bump-then-erase, in this order after the store write: see doc_cache_put
+        doc_cache_watermark++;
+        for(const index_record* pending_write: pending_writes) {
+            doc_cache_erase(pending_write->seq_id);
+        }
+
+        write_epoch++;
+    }
+
+    for(index_record* pending_write: pending_writes) {
+        auto& index_record = *pending_write;
+
+        if(!write_ok) {
+            // remove from in-memory store to keep the state synced
+            LOG(ERROR) << "Write to disk failed. Will restore old document";
+
+            if(index_record.is_update) {
+                // we will attempt to reindex the old doc on a best-effort basis
+                remove_document(index_record.new_doc, index_record.seq_id, false);
+                index_in_memory(index_record.old_doc, index_record.seq_id,
+                                index_record.operation, index_record.dirty_values);
+            } else {
+                remove_document(index_record.doc, index_record.seq_id, false);
             }
+
+            index_record.index_failure(500, "Could not write to on-disk storage.");
+        } else {
+            num_indexed++;
+            index_record.index_success();
+        }
+    }
+
+    for(auto& index_record: index_records) {
+        nlohmann::json res;
+
+        if(index_record.indexed.ok()) {
+            res["success"] = true;
         } else {
             res["success"] = false;
             res["document"] = json_out[index_record.position];
@@ -348,7 +502,8 @@ void Collection::batch_index(std::vector<index_record>& index_records, std::vect
 
 Option<uint32_t> Collection::index_in_memory(nlohmann::json &document, uint32_t seq_id,
                                              const index_operation_t op, const DIRTY_VALUES& dirty_values) {
-    std::unique_lock lock(mutex);
+    std::lock_guard<std::mutex> write_lock(indexing_mutex);
+    std::shared_lock lock(mutex);
 
     Option<uint32_t> validation_op = Index::validate_index_in_memory(document, seq_id, default_sorting_field,
                                                                      search_schema, facet_schema, op,
@@ -371,7 +526,8 @@ Option<uint32_t> Collection::index_in_memory(nlohmann::json &document, uint32_t
 }
 
 size_t Collection::batch_index_in_memory(std::vector<index_record>& index_records) {
-    std::unique_lock lock(mutex);
+    std::lock_guard<std::mutex> write_lock(indexing_mutex);
+    std::shared_lock lock(mutex);
     size_t num_indexed = Index::batch_memory_index(index, index_records, default_sorting_field,
                                                    search_schema, facet_schema, fallback_field_type,
                                                    token_separators, symbols_to_index);
@@ -419,37 +575,33 @@ void Collection::curate_results(string& actual_query, bool enable_overrides, boo
     if(enable_overrides && !overrides.empty()) {
         StringUtils::tolowercase(query);
 
-        for(const auto& override_kv: overrides) {
-            const auto& override = override_kv.second;
+        // ID-based overrides are applied first as they take precedence over filter-based overrides
+        filter_overrides = override_matcher.filter_overrides;
 
-            // ID-based overrides are applied first as they take precedence over filter-based overrides
-            if(!override.filter_by.empty()) {
-                filter_overrides.push_back(&override);
-                continue;
-            }
+        std::vector<const override_t*> matched_overrides;
+        override_matcher.match(query, matched_overrides);
 
-            if( (override.rule.match == override_t::MATCH_EXACT && override.rule.query == query) ||
-                (override.rule.match == override_t::MATCH_CONTAINS && query.find(override.rule.query) != std::string::npos) )  {
+        for(const override_t* matched_override: matched_overrides) {
+            const auto& override = *matched_override;
 
-                // have to ensure that dropped hits take precedence over added hits
-                for(const auto & hit: override.drop_hits) {
-                    Option<uint32_t> seq_id_op = doc_id_to_seq_id(hit.doc_id);
-                    if(seq_id_op.ok()) {
-                        excluded_ids.push_back(seq_id_op.get());
-                        excluded_set.insert(seq_id_op.get());
-                    }
+            // have to ensure that dropped hits take precedence over added hits
+            for(const auto & hit: override.drop_hits) {
+                Option<uint32_t> seq_id_op = doc_id_to_seq_id(hit.doc_id);
+                if(seq_id_op.ok()) {
+                    excluded_ids.push_back(seq_id_op.get());
+                    excluded_set.insert(seq_id_op.get());
                 }
+            }
 
-                for(const auto & hit: override.add_hits) {
-                    Option<uint32_t> seq_id_op = doc_id_to_seq_id(hit.doc_id);
-                    if(!seq_id_op.ok()) {
-                        continue;
-                    }
-                    uint32_t seq_id = seq_id_op.get();
-                    bool excluded = (excluded_set.count(seq_id) != 0);
-                    if(!excluded) {
-                        include_ids[hit.position].push_back(seq_id);
-                    }
+            for(const auto & hit: override.add_hits) {
+                Option<uint32_t> seq_id_op = doc_id_to_seq_id(hit.doc_id);
+                if(!seq_id_op.ok()) {
+                    continue;
+                }
+                uint32_t seq_id = seq_id_op.get();
+                bool excluded = (excluded_set.count(seq_id) != 0);
+                if(!excluded) {
+                    include_ids[hit.position].push_back(seq_id);
                 }
             }
         }
@@ -473,6 +625,141 @@ void Collection::curate_results(string& actual_query, bool enable_overrides, boo
     }
 }
 
+bool Collection::query_plan_cache_get(const std::string& plan_key,
+                                      std::vector<query_tokens_t>& field_query_tokens) const {
+    std::lock_guard<std::mutex> lock(query_plan_cache_mutex);
+
+    const auto& it = query_plan_cache.find(plan_key);
+    if(it == query_plan_cache.end()) {
+        return false;
+    }
+
+    query_plan_t* plan = it->second;
+
+    if(plan->version != query_plan_version.load()) {
+        // synonyms or the schema changed after this plan was compiled
+        query_plan_cache_lru.erase(plan->lru_it);
+        delete plan;
+        query_plan_cache.erase(it);
+        return false;
+    }
+
+    query_plan_cache_lru.splice(query_plan_cache_lru.begin(), query_plan_cache_lru, plan->lru_it);
+    field_query_tokens = plan->field_query_tokens;
+
+    return true;
+}
+
+void Collection::query_plan_cache_put(const std::string& plan_key,
+                                      const std::vector<query_tokens_t>& field_query_tokens) const {
+    std::lock_guard<std::mutex> lock(query_plan_cache_mutex);
+
+    if(query_plan_cache.find(plan_key) != query_plan_cache.end()) {
+        // a concurrent search has compiled this query already
+        return;
+    }
+
+    query_plan_t* plan = new query_plan_t();
+    plan->field_query_tokens = field_query_tokens;
+    plan->version = query_plan_version.load();
+
+    query_plan_cache_lru.push_front(plan_key);
+    plan->lru_it = query_plan_cache_lru.begin();
+    query_plan_cache.emplace(plan_key, plan);
+
+    if(query_plan_cache.size() > QUERY_PLAN_CACHE_MAX_ENTRIES) {
+        const std::string& evicted_key = query_plan_cache_lru.back();
+        const auto& evicted_it = query_plan_cache.find(evicted_key);
+        delete evicted_it->second;
+        query_plan_cache.erase(evicted_it);
+        query_plan_cache_lru.pop_back();
+    }
+}
+
+bool Collection::doc_cache_get(const uint32_t seq_id, nlohmann::json& document) const {
+    std::lock_guard<std::mutex> lock(doc_cache_mutex);
+
+    const auto& it = doc_cache.find(seq_id);
+    if(it == doc_cache.end()) {
+        return false;
+    }
+
+    doc_cache_entry_t* entry = it->second;
+    doc_cache_lru.splice(doc_cache_lru.begin(), doc_cache_lru, entry->lru_it);
+    document = entry->document;
+
+    return true;
+}
+
+void Collection::doc_cache_put(const uint32_t seq_id, const nlohmann::json& document,
+                               const uint64_t watermark) const {
+    std::lock_guard<std::mutex> lock(doc_cache_mutex);
+
+    if(watermark != doc_cache_watermark.load()) {
+        // A write hit the store after this fetch began, so the parsed document
+        // may be stale. Writers bump the watermark only after the store write
+        // and erase the seq_id only after bumping, so any fill they cannot
+        // reject here is guaranteed to be erased by them.
+        return;
+    }
+
+    if(doc_cache.find(seq_id) != doc_cache.end()) {
+        // a concurrent hydration has stored this document already
+        return;
+    }
+
+    doc_cache_entry_t* entry = new doc_cache_entry_t();
+    entry->document = document;
+
+    doc_cache_lru.push_front(seq_id);
+    entry->lru_it = doc_cache_lru.begin();
+    doc_cache.emplace(seq_id, entry);
+
+    if(doc_cache.size() > DOC_CACHE_MAX_ENTRIES) {
+        const uint32_t evicted_seq_id = doc_cache_lru.back();
+        const auto& evicted_it = doc_cache.find(evicted_seq_id);
+        delete evicted_it->second;
+        doc_cache.erase(evicted_it);
+        doc_cache_lru.pop_back();
+    }
+}
+
+hydration_state_t Collection::get_hydration_state() const {
+    return hydration_state.load();
+}
+
+void Collection::set_hydration_state(const hydration_state_t state) {
+    hydration_state = state;
+}
+
+bool Collection::try_start_hydration() {
+    hydration_state_t expected = hydration_state_t::PENDING;
+    return hydration_state.compare_exchange_strong(expected, hydration_state_t::IN_PROGRESS);
+}
+
+bool Collection::is_hydrated() const {
+    return hydration_state.load() == hydration_state_t::HYDRATED;
+}
+
+uint64_t Collection::get_last_access_timestamp() const {
+    return last_access_timestamp.load();
+}
+
+void Collection::update_last_access_timestamp() const {
+    last_access_timestamp = static_cast<uint64_t>(std::time(nullptr));
+}
+
+void Collection::doc_cache_erase(const uint32_t seq_id) const {
+    std::lock_guard<std::mutex> lock(doc_cache_mutex);
+
+    const auto& it = doc_cache.find(seq_id);
+    if(it != doc_cache.end()) {
+        doc_cache_lru.erase(it->second->lru_it);
+        delete it->second;
+        doc_cache.erase(it);
+    }
+}
+
 Option<nlohmann::json> Collection::search(const std::string & raw_query, const std::vector<std::string>& search_fields,
                                   const std::string & simple_filter_query, const std::vector<std::string>& facet_fields,
                                   const std::vector<sort_by> & sort_fields, const std::vector<uint32_t>& num_typos,
@@ -502,10 +789,30 @@ Option<nlohmann::json> Collection::search(const std::string & raw_query, const s
                                   const bool exhaustive_search,
                                   const size_t search_stop_millis,
                                   const size_t min_len_1typo,
-                                  const size_t min_len_2typo) const {
+                                  const size_t min_len_2typo,
+                                  const bool approx_facets,
+                                  const size_t facet_sample_percent,
+                                  const size_t facet_sample_threshold,
+                                  std::vector<std::string>* serialized_hits,
+                                  const std::string& search_after) const {
+
+    const auto search_begin = std::chrono::high_resolution_clock::now();
+
+    if(hydration_state.load() != hydration_state_t::HYDRATED) {
+        // lazy collection: kick off index hydration and answer with a
+        // retriable loading status until the index is in memory
+        CollectionManager::get_instance().hydrate_collection_async(name);
+        return Option<nlohmann::json>(503, "Collection is being loaded into memory. Please retry in a few moments.");
+    }
+
+    update_last_access_timestamp();
 
     std::shared_lock lock(mutex);
 
+    if(facet_sample_percent == 0 || facet_sample_percent > 100) {
+        return Option<nlohmann::json>(400, "Value of `facet_sample_percent` must be between 1 and 100.");
+    }
+
     if(raw_query != "*" && search_fields.empty()) {
         return Option<nlohmann::json>(400, "No search fields specified for the query.");
     }
@@ -608,7 +915,7 @@ Option<nlohmann::json> Collection::search(const std::string & raw_query, const s
             std::string error = "Could not find a facet field named `" + field_name + "` in the schema.";
             return Option<nlohmann::json>(404, error);
         }
-        facets.emplace_back(field_name);
+        facets.emplace_back(field_name, approx_facets);
     }
 
     // parse facet query
@@ -813,6 +1120,40 @@ Option<nlohmann::json> Collection::search(const std::string & raw_query, const s
         return Option<nlohmann::json>(422, message);
     }
 
+    // cursor pagination: the bound from a previous page's `search_cursor` lets
+    // scoring reject already-served candidates, so the heap stays at one page
+    Topster::after_bound_t after_bound;
+
+    if(!search_after.empty()) {
+        if(group_limit != 0) {
+            return Option<nlohmann::json>(422, "Parameter `search_after` cannot be used with grouping.");
+        }
+
+        if(page > 1) {
+            return Option<nlohmann::json>(422, "Parameter `page` cannot be used along with `search_after`.");
+        }
+
+        std::vector<std::string> cursor_parts;
+        StringUtils::split(search_after, cursor_parts, ",");
+
+        const bool cursor_valid = (cursor_parts.size() == 4) &&
+                                  StringUtils::is_int64_t(cursor_parts[0]) &&
+                                  StringUtils::is_int64_t(cursor_parts[1]) &&
+                                  StringUtils::is_int64_t(cursor_parts[2]) &&
+                                  StringUtils::is_uint64_t(cursor_parts[3]);
+
+        if(!cursor_valid) {
+            return Option<nlohmann::json>(422, "Parameter `search_after` must be a `search_cursor` value "
+                                               "returned by a previous search.");
+        }
+
+        after_bound.active = true;
+        after_bound.scores[0] = std::stoll(cursor_parts[0]);
+        after_bound.scores[1] = std::stoll(cursor_parts[1]);
+        after_bound.scores[2] = std::stoll(cursor_parts[2]);
+        after_bound.key = std::stoull(cursor_parts[3]);
+    }
+
     size_t max_hits = 250;
 
     // ensure that `max_hits` never exceeds number of documents in collection
@@ -822,6 +1163,11 @@ Option<nlohmann::json> Collection::search(const std::string & raw_query, const s
         max_hits = std::min(std::max((page * per_page), max_hits), get_num_documents());
     }
 
+    if(after_bound.active) {
+        // earlier pages are pruned by the bound itself, so one page suffices
+        max_hits = std::max((size_t) 1, std::min(per_page, get_num_documents()));
+    }
+
     if(token_order == NOT_SET) {
         if(default_sorting_field.empty()) {
             token_order = FREQUENCY;
@@ -893,26 +1239,44 @@ Option<nlohmann::json> Collection::search(const std::string & raw_query, const s
     //LOG(INFO) << "Num indices used for querying: " << indices.size();
     std::vector<query_tokens_t> field_query_tokens;
 
-    if(search_fields.size() == 0) {
-        // has to be a wildcard query
-        field_query_tokens.emplace_back(query_tokens_t{});
-        parse_search_query(query, field_query_tokens[0].q_include_tokens, field_query_tokens[0].q_exclude_tokens, "",
-                           false);
-    } else {
-        for(size_t i = 0; i < search_fields.size(); i++) {
-            const auto& search_field = search_fields[i];
+    // key is built only now since curation overrides may have rewritten the query
+    std::string plan_key = pre_segmented_query ? "1" : "0";
+    plan_key += '\x1e';
+    plan_key += query;
+    for(const std::string& search_field: search_fields) {
+        plan_key += '\x1f';
+        plan_key += search_field;
+    }
+
+    const auto tokenize_begin = std::chrono::high_resolution_clock::now();
+
+    if(!query_plan_cache_get(plan_key, field_query_tokens)) {
+        if(search_fields.size() == 0) {
+            // has to be a wildcard query
             field_query_tokens.emplace_back(query_tokens_t{});
+            parse_search_query(query, field_query_tokens[0].q_include_tokens, field_query_tokens[0].q_exclude_tokens, "",
+                               false);
+        } else {
+            for(size_t i = 0; i < search_fields.size(); i++) {
+                const auto& search_field = search_fields[i];
+                field_query_tokens.emplace_back(query_tokens_t{});
 
-            const std::string & field_locale = search_schema.at(search_field).locale;
-            parse_search_query(query, field_query_tokens[i].q_include_tokens, field_query_tokens[i].q_exclude_tokens,
-                               field_locale, pre_segmented_query);
+                const std::string & field_locale = search_schema.at(search_field).locale;
+                parse_search_query(query, field_query_tokens[i].q_include_tokens, field_query_tokens[i].q_exclude_tokens,
+                                   field_locale, pre_segmented_query);
 
-            // get synonyms
-            std::vector<std::vector<std::string>> q_synonyms;
-            synonym_reduction(field_query_tokens[i].q_include_tokens, field_query_tokens[i].q_synonyms);
+                // get synonyms
+                std::vector<std::vector<std::string>> q_synonyms;
+                synonym_reduction(field_query_tokens[i].q_include_tokens, field_query_tokens[i].q_synonyms);
+            }
         }
+
+        query_plan_cache_put(plan_key, field_query_tokens);
     }
 
+    const uint64_t tokenize_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - tokenize_begin).count();
+
     // search all indices
 
     size_t index_id = 0;
@@ -924,7 +1288,14 @@ Option<nlohmann::json> Collection::search(const std::string & raw_query, const s
                                                  group_by_fields, group_limit, default_sorting_field, prioritize_exact_match,
                                                  exhaustive_search, 4, filter_overrides,
                                                  search_stop_millis,
-                                                 min_len_1typo, min_len_2typo);
+                                                 min_len_1typo, min_len_2typo,
+                                                 facet_sample_percent, facet_sample_threshold);
+
+    search_params->topster->after_bound = after_bound;
+
+    // the index is read-locked for the whole request, since searched query
+    // leaves are dereferenced for highlighting after the search itself returns
+    auto index_lock = index->get_search_lock();
 
     index->run_search(search_params);
 
@@ -1004,7 +1375,107 @@ Option<nlohmann::json> Collection::search(const std::string & raw_query, const s
     std::string hits_key = group_limit ? "grouped_hits" : "hits";
     result[hits_key] = nlohmann::json::array();
 
+    // when `include_fields` narrows the response down, hydration materializes
+    // only those fields (plus the fields being highlighted) from the stored
+    // JSON instead of parsing every cold field of the document
+    spp::sparse_hash_set<std::string> hydration_fields;
+    if(!include_fields.empty()) {
+        hydration_fields = include_fields;
+
+        if(highlight_fields.empty()) {
+            for(const auto& field_name: search_fields) {
+                if(exclude_fields.count(field_name) == 0) {
+                    hydration_fields.insert(field_name);
+                }
+            }
+        } else {
+            std::vector<std::string> highlight_field_names;
+            StringUtils::split(highlight_fields, highlight_field_names, ",");
+            for(const auto& field_name: highlight_field_names) {
+                hydration_fields.insert(field_name);
+            }
+        }
+    }
+
+    const spp::sparse_hash_set<std::string>* hydration_filter = hydration_fields.empty() ?
+                                                               nullptr : &hydration_fields;
+
+    // the set of fields to highlight and their schema entries are identical for
+    // every hit, so they are resolved once here instead of per document
+
+    // find out if fields have to be highlighted fully
+    std::vector<std::string> fields_highlighted_fully_vec;
+    spp::sparse_hash_set<std::string> fields_highlighted_fully;
+    StringUtils::split(highlight_full_fields, fields_highlighted_fully_vec, ",");
+
+    for(std::string& highlight_full_field: fields_highlighted_fully_vec) {
+        fields_highlighted_fully.emplace(highlight_full_field);
+    }
+
+    std::vector<std::string> fields_highlighted_vec;
+    std::vector<size_t> fields_highlighted_indices;
+    if(highlight_fields.empty()) {
+        for(size_t i = 0; i < search_fields.size(); i++) {
+            const auto& field_name = search_fields[i];
+            // should not pick excluded field for highlighting
+            if(exclude_fields.count(field_name) > 0) {
+                continue;
+            }
+
+            fields_highlighted_vec.emplace_back(field_name);
+            fields_highlighted_indices.push_back(i);
+        }
+    } else {
+        if(query != "*") {
+            StringUtils::split(highlight_fields, fields_highlighted_vec, ",");
+            for(size_t i = 0; i < fields_highlighted_vec.size(); i++) {
+                fields_highlighted_indices.push_back(0);
+            }
+        }
+    }
+
+    struct highlight_field_t {
+        const field* search_field;
+        const std::vector<std::string>* q_tokens;
+        bool highlighted_fully;
+    };
+
+    // only string fields known to the schema can produce a highlight
+    std::vector<highlight_field_t> highlight_field_entries;
+    for(size_t i = 0; i < fields_highlighted_vec.size(); i++) {
+        const std::string& field_name = fields_highlighted_vec[i];
+        const auto schema_it = search_schema.find(field_name);
+
+        if(schema_it == search_schema.end()) {
+            continue;
+        }
+
+        const field& search_field = schema_it->second;
+        if(query != "*" && (search_field.type == field_types::STRING ||
+                            search_field.type == field_types::STRING_ARRAY)) {
+            highlight_field_entries.push_back({&search_field,
+                                               &field_query_tokens[fields_highlighted_indices[i]].q_include_tokens,
+                                               fields_highlighted_fully.count(field_name) != 0});
+        }
+    }
+
+    // a (field, token) pair resolves to the same ART leaf for every hit, so the
+    // tree descents done during highlighting are memoized across the result set
+    spp::sparse_hash_map<std::string, art_leaf*> highlight_leaf_cache;
+    StringUtils string_utils;
+
+    // hits are emitted as serialized strings directly when the caller asked for
+    // it (grouped hits keep the tree since groups nest hits under group_key)
+    const bool emit_hits_directly = (serialized_hits != nullptr) && (group_limit == 0);
+
+    // the stored JSON can be spliced into the output verbatim only when the
+    // served document is byte-identical to it: no pruning and no partial hydration
+    const bool raw_doc_usable = emit_hits_directly && include_fields.empty() && exclude_fields.empty() &&
+                                hydration_filter == nullptr;
+
     // construct results array
+    const auto hydrate_begin = std::chrono::high_resolution_clock::now();
+
     for(long result_kvs_index = start_result_index; result_kvs_index <= end_result_index; result_kvs_index++) {
         const std::vector<KV*> & kv_group = result_group_kvs[result_kvs_index];
 
@@ -1019,7 +1490,9 @@ Option<nlohmann::json> Collection::search(const std::string & raw_query, const s
             const std::string& seq_id_key = get_seq_id_key((uint32_t) field_order_kv->key);
 
             nlohmann::json document;
-            const Option<bool> & document_op = get_document_from_store(seq_id_key, document);
+            std::string raw_doc;
+            const Option<bool> & document_op = get_document_from_store(seq_id_key, document, hydration_filter,
+                                                                       raw_doc_usable ? &raw_doc : nullptr);
 
             if(!document_op.ok()) {
                 LOG(ERROR) << "Document fetch error. " << document_op.error();
@@ -1029,65 +1502,22 @@ Option<nlohmann::json> Collection::search(const std::string & raw_query, const s
             nlohmann::json wrapper_doc;
             wrapper_doc["highlights"] = nlohmann::json::array();
             std::vector<highlight_t> highlights;
-            StringUtils string_utils;
-
-            // find out if fields have to be highlighted fully
-            std::vector<std::string> fields_highlighted_fully_vec;
-            spp::sparse_hash_set<std::string> fields_highlighted_fully;
-            StringUtils::split(highlight_full_fields, fields_highlighted_fully_vec, ",");
-
-            std::vector<std::string> fields_highlighted_vec;
-            std::vector<size_t> fields_highlighted_indices;
-            if(highlight_fields.empty()) {
-                for(size_t i = 0; i < search_fields.size(); i++) {
-                    const auto& field_name = search_fields[i];
-                    // should not pick excluded field for highlighting
-                    if(exclude_fields.count(field_name) > 0) {
-                        continue;
-                    }
-
-                    fields_highlighted_vec.emplace_back(field_name);
-                    fields_highlighted_indices.push_back(i);
-                }
-            } else {
-                if(query != "*") {
-                    StringUtils::split(highlight_fields, fields_highlighted_vec, ",");
-                    for(size_t i = 0; i < fields_highlighted_vec.size(); i++) {
-                        fields_highlighted_indices.push_back(0);
-                    }
-                }
-            }
 
-            for(std::string & highlight_full_field: fields_highlighted_fully_vec) {
-                fields_highlighted_fully.emplace(highlight_full_field);
-            }
-
-            for(size_t i = 0; i < fields_highlighted_vec.size(); i++) {
-                const std::string& field_name = fields_highlighted_vec[i];
-                const std::vector<std::string>& q_tokens = field_query_tokens[fields_highlighted_indices[i]].q_include_tokens;
-
-                if(search_schema.count(field_name) == 0) {
-                    continue;
-                }
-
-                field search_field = search_schema.at(field_name);
-                if(query != "*" && (search_field.type == field_types::STRING ||
-                                    search_field.type == field_types::STRING_ARRAY)) {
-
-                    bool highlighted_fully = (fields_highlighted_fully.find(field_name) != fields_highlighted_fully.end());
-                    highlight_t highlight;
-                    //LOG(INFO) << "Highlighting: " << document;
-                    /*if(document["title"] == "Quantum Quest: A Cassini Space Odyssey") {
-                        LOG(INFO) << "here!";
-                    }*/
-                    highlight_result(search_field, searched_queries, q_tokens, field_order_kv, document,
-                                     string_utils, snippet_threshold, highlight_affix_num_tokens,
-                                     highlighted_fully, highlight_start_tag, highlight_end_tag, highlight);
-                    //LOG(INFO) << "End";
-
-                    if(!highlight.snippets.empty()) {
-                        highlights.push_back(highlight);
-                    }
+            for(const auto& field_entry: highlight_field_entries) {
+                highlight_t highlight;
+                //LOG(INFO) << "Highlighting: " << document;
+                /*if(document["title"] == "Quantum Quest: A Cassini Space Odyssey") {
+                    LOG(INFO) << "here!";
+                }*/
+                highlight_result(*field_entry.search_field, searched_queries, *field_entry.q_tokens,
+                                 field_order_kv, document,
+                                 string_utils, snippet_threshold, highlight_affix_num_tokens,
+                                 field_entry.highlighted_fully, highlight_start_tag, highlight_end_tag,
+                                 highlight_leaf_cache, highlight);
+                //LOG(INFO) << "End";
+
+                if(!highlight.snippets.empty()) {
+                    highlights.push_back(highlight);
                 }
             }
 
@@ -1118,8 +1548,10 @@ Option<nlohmann::json> Collection::search(const std::string & raw_query, const s
 
             //wrapper_doc["seq_id"] = (uint32_t) field_order_kv->key;
 
-            prune_document(document, include_fields, exclude_fields);
-            wrapper_doc["document"] = document;
+            if(!emit_hits_directly) {
+                prune_document(document, include_fields, exclude_fields);
+                wrapper_doc["document"] = document;
+            }
 
             if(field_order_kv->match_score_index == CURATED_RECORD_IDENTIFIER) {
                 wrapper_doc["curated"] = true;
@@ -1140,7 +1572,32 @@ Option<nlohmann::json> Collection::search(const std::string & raw_query, const s
                 wrapper_doc["geo_distance_meters"] = geo_distances;
             }
 
-            hits_array.push_back(wrapper_doc);
+            if(emit_hits_directly) {
+                // the hit is written straight into its response-ready form: the stored
+                // JSON is spliced in verbatim when possible and the rest of the wrapper
+                // (a small tree of highlights and scores) is appended after it
+                if(raw_doc.empty()) {
+                    prune_document(document, include_fields, exclude_fields);
+                    raw_doc = document.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
+                }
+
+                const std::string& meta = wrapper_doc.dump(-1, ' ', false,
+                                                           nlohmann::detail::error_handler_t::ignore);
+
+                std::string& hit_out = serialized_hits->emplace_back();
+                hit_out.reserve(raw_doc.size() + meta.size() + 16);
+                hit_out += "{\"document\":";
+                hit_out += raw_doc;
+
+                if(meta.size() > 2) {
+                    hit_out += ',';
+                    hit_out.append(meta, 1, meta.size() - 1);
+                } else {
+                    hit_out += '}';
+                }
+            } else {
+                hits_array.push_back(wrapper_doc);
+            }
         }
 
         if(group_limit) {
@@ -1157,6 +1614,26 @@ Option<nlohmann::json> Collection::search(const std::string & raw_query, const s
         }
     }
 
+    const uint64_t hydrate_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - hydrate_begin).count();
+
+    if(group_limit == 0) {
+        // cursor of the last organic hit on this page: passing it back via
+        // `search_after` fetches the next page without deepening the heap
+        for(long i = end_result_index; i >= start_result_index; i--) {
+            const KV* cursor_kv = result_group_kvs[i][0];
+            if(cursor_kv->match_score_index == CURATED_RECORD_IDENTIFIER) {
+                continue;
+            }
+
+            result["search_cursor"] = std::to_string(cursor_kv->scores[0]) + "," +
+                                      std::to_string(cursor_kv->scores[1]) + "," +
+                                      std::to_string(cursor_kv->scores[2]) + "," +
+                                      std::to_string(cursor_kv->key);
+            break;
+        }
+    }
+
     result["facet_counts"] = nlohmann::json::array();
 
     // populate facets
@@ -1192,21 +1669,20 @@ Option<nlohmann::json> Collection::search(const std::string & raw_query, const s
             auto & kv = facet_hash_counts[fi];
             auto & facet_count = kv.second;
 
-            // fetch actual facet value from representative doc id
-            const std::string& seq_id_key = get_seq_id_key((uint32_t) facet_count.doc_id);
-            nlohmann::json document;
-            const Option<bool> & document_op = get_document_from_store(seq_id_key, document);
+            // resolve the actual facet value from the interned value store
+            const std::string* interned_value = index->get_facet_value(a_facet.field_name, kv.first);
 
-            if(!document_op.ok()) {
-                LOG(ERROR) << "Facet fetch error. " << document_op.error();
+            if(interned_value == nullptr) {
+                LOG(ERROR) << "Could not resolve interned facet value for field " << a_facet.field_name;
                 continue;
             }
 
-            std::string value;
-            bool facet_found = facet_value_to_string(a_facet, facet_count, document, value);
+            std::string value = *interned_value;
 
-            if(!facet_found) {
-                continue;
+            if(the_field.is_bool()) {
+                value = (value == "1") ? "true" : "false";
+            } else if(the_field.is_float() && value != "0") {
+                value.erase(value.find_last_not_of('0') + 1, std::string::npos);  // remove trailing zeros
             }
 
             std::unordered_map<std::string, size_t> ftoken_pos;
@@ -1303,9 +1779,14 @@ Option<nlohmann::json> Collection::search(const std::string & raw_query, const s
         }
 
         facet_result["stats"]["total_values"] = facet_hash_counts.size();
+        facet_result["sampled"] = a_facet.sampled;
         result["facet_counts"].push_back(facet_result);
     }
 
+    search_stage_timings_t stage_timings = search_params->timings;
+    stage_timings.tokenize_us = tokenize_us;
+    stage_timings.hydrate_us = hydrate_us;
+
     // free search params
     delete search_params;
 
@@ -1316,6 +1797,27 @@ Option<nlohmann::json> Collection::search(const std::string & raw_query, const s
     result["request_params"]["per_page"] = per_page;
     result["request_params"]["q"] = query;
 
+    // slow query log: emitted only after the response is fully built, so the timers
+    // cover every stage and the (buffered) log write stays off the response path
+    const int slow_requests_ms = Config::get_instance().get_log_slow_requests_time_ms();
+
+    if(slow_requests_ms > 0) {
+        const uint64_t search_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::high_resolution_clock::now() - search_begin).count();
+
+        if(int(search_ms) > slow_requests_ms) {
+            LOG(INFO) << "SLOW SEARCH: (" << search_ms << " ms) collection=`" << name
+                      << "`, q=`" << raw_query << "`, filter_by=`" << simple_filter_query
+                      << "`, num_facets=" << facet_fields.size() << ", page=" << page
+                      << ", stages (us): tokenize=" << stage_timings.tokenize_us
+                      << ", filter=" << stage_timings.filter_us
+                      << ", candidates=" << stage_timings.candidates_us
+                      << ", score=" << stage_timings.score_us
+                      << ", facet=" << stage_timings.facet_us
+                      << ", hydrate=" << stage_timings.hydrate_us;
+        }
+    }
+
     //long long int timeMillis = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - begin).count();
     //!LOG(INFO) << "Time taken for result calc: " << timeMillis << "us";
     //!store->print_memory_usage();
@@ -1381,11 +1883,10 @@ void Collection::populate_result_kvs(Topster *topster, std::vector<std::vector<K
         // we have to pick top-K groups
         Topster gtopster(topster->MAX_SIZE);
 
-        for(auto& group_topster: topster->group_kv_map) {
-            group_topster.second->sort();
-            if(group_topster.second->size != 0) {
-                KV* kv_head = group_topster.second->getKV(0);
-                gtopster.add(kv_head);
+        for(auto& slot: topster->group_map->slots) {
+            if(slot.size != 0) {
+                // slot entries are already sorted descending, so the head leads
+                gtopster.add(&slot.kvs[0]);
             }
         }
 
@@ -1393,10 +1894,13 @@ void Collection::populate_result_kvs(Topster *topster, std::vector<std::vector<K
 
         for(size_t i = 0; i < gtopster.size; i++) {
             KV* kv = gtopster.getKV(i);
-            const std::vector<KV*> group_kvs(
-                topster->group_kv_map[kv->distinct_key]->kvs,
-                topster->group_kv_map[kv->distinct_key]->kvs+topster->group_kv_map[kv->distinct_key]->size
-            );
+            group_slot_t* slot = topster->group_map->find(kv->distinct_key);
+
+            std::vector<KV*> group_kvs(slot->size);
+            for(uint32_t j = 0; j < slot->size; j++) {
+                group_kvs[j] = &slot->kvs[j];
+            }
+
             result_kvs.emplace_back(group_kvs);
         }
     } else {
@@ -1428,69 +1932,6 @@ Option<bool> Collection::get_filter_ids(const std::string & simple_filter_query,
     return Option<bool>(true);
 }
 
-bool Collection::facet_value_to_string(const facet &a_facet, const facet_count_t &facet_count,
-                                       const nlohmann::json &document, std::string &value) const {
-
-    if(document.count(a_facet.field_name) == 0) {
-        // check for field exists
-        if(search_schema.at(a_facet.field_name).optional) {
-            return false;
-        }
-
-        LOG(ERROR) << "Could not find field " << a_facet.field_name << " in document during faceting.";
-        LOG(ERROR) << "Facet field type: " << facet_schema.at(a_facet.field_name).type;
-        LOG(ERROR) << "Actual document: " << document;
-        return false;
-    }
-
-    if(facet_schema.at(a_facet.field_name).is_array()) {
-        size_t array_sz = document[a_facet.field_name].size();
-        if(facet_count.array_pos >= array_sz) {
-            LOG(ERROR) << "Facet field array size " << array_sz << " lesser than array pos " <<  facet_count.array_pos
-                       << " for facet field " << a_facet.field_name;
-            LOG(ERROR) << "Facet field type: " << facet_schema.at(a_facet.field_name).type;
-            LOG(ERROR) << "Actual document: " << document;
-            return false;
-        }
-    }
-
-    if(facet_schema.at(a_facet.field_name).type == field_types::STRING) {
-        value =  document[a_facet.field_name];
-    } else if(facet_schema.at(a_facet.field_name).type == field_types::STRING_ARRAY) {
-        value = document[a_facet.field_name][facet_count.array_pos];
-    } else if(facet_schema.at(a_facet.field_name).type == field_types::INT32) {
-        int32_t raw_val = document[a_facet.field_name].get<int32_t>();
-        value = std::to_string(raw_val);
-    } else if(facet_schema.at(a_facet.field_name).type == field_types::INT32_ARRAY) {
-        int32_t raw_val = document[a_facet.field_name][facet_count.array_pos].get<int32_t>();
-        value = std::to_string(raw_val);
-    } else if(facet_schema.at(a_facet.field_name).type == field_types::INT64) {
-        int64_t raw_val = document[a_facet.field_name].get<int64_t>();
-        value = std::to_string(raw_val);
-    } else if(facet_schema.at(a_facet.field_name).type == field_types::INT64_ARRAY) {
-        int64_t raw_val = document[a_facet.field_name][facet_count.array_pos].get<int64_t>();
-        value = std::to_string(raw_val);
-    } else if(facet_schema.at(a_facet.field_name).type == field_types::FLOAT) {
-        float raw_val = document[a_facet.field_name].get<float>();
-        value = StringUtils::float_to_str(raw_val);
-        if(value != "0") {
-            value.erase ( value.find_last_not_of('0') + 1, std::string::npos ); // remove trailing zeros
-        }
-    } else if(facet_schema.at(a_facet.field_name).type == field_types::FLOAT_ARRAY) {
-        float raw_val = document[a_facet.field_name][facet_count.array_pos].get<float>();
-        value = StringUtils::float_to_str(raw_val);
-        value.erase ( value.find_last_not_of('0') + 1, std::string::npos );  // remove trailing zeros
-    } else if(facet_schema.at(a_facet.field_name).type == field_types::BOOL) {
-        value = std::to_string(document[a_facet.field_name].get<bool>());
-        value = (value == "1") ? "true" : "false";
-    } else if(facet_schema.at(a_facet.field_name).type == field_types::BOOL_ARRAY) {
-        value = std::to_string(document[a_facet.field_name][facet_count.array_pos].get<bool>());
-        value = (value == "1") ? "true" : "false";
-    }
-
-    return true;
-}
-
 void Collection::highlight_result(const field &search_field,
                                   const std::vector<std::vector<art_leaf *>> &searched_queries,
                                   const std::vector<std::string>& q_tokens,
@@ -1501,11 +1942,30 @@ void Collection::highlight_result(const field &search_field,
                                   bool highlighted_fully,
                                   const std::string& highlight_start_tag,
                                   const std::string& highlight_end_tag,
+                                  spp::sparse_hash_map<std::string, art_leaf*>& leaf_cache,
                                   highlight_t & highlight) const {
 
     std::vector<art_leaf*> query_suggestion;
     std::set<std::string> query_suggestion_tokens;
 
+    // `get_token_leaf` descends the field's ART tree and the same (field, token)
+    // pair repeats for every hit being highlighted, so lookups (misses included)
+    // are memoized in `leaf_cache` for the duration of the request
+    auto get_cached_token_leaf = [&](const unsigned char* key, size_t key_len) -> art_leaf* {
+        std::string cache_key(search_field.name);
+        cache_key.push_back('\0');
+        cache_key.append(reinterpret_cast<const char*>(key), key_len);
+
+        const auto cache_it = leaf_cache.find(cache_key);
+        if(cache_it != leaf_cache.end()) {
+            return cache_it->second;
+        }
+
+        art_leaf* leaf = index->get_token_leaf(search_field.name, key, key_len);
+        leaf_cache.emplace(std::move(cache_key), leaf);
+        return leaf;
+    };
+
     size_t qindex = 0;
 
     do {
@@ -1528,7 +1988,7 @@ void Collection::highlight_result(const field &search_field,
 
             // Must search for the token string fresh on that field for the given document since `token_leaf`
             // is from the best matched field and need not be present in other fields of a document.
-            art_leaf* actual_leaf = index->get_token_leaf(search_field.name, &token_leaf->key[0], token_leaf->key_len);
+            art_leaf* actual_leaf = get_cached_token_leaf(&token_leaf->key[0], token_leaf->key_len);
 
             if(actual_leaf != nullptr && posting_t::contains(actual_leaf->values, field_order_kv->key)) {
                 query_suggestion.push_back(actual_leaf);
@@ -1547,8 +2007,7 @@ void Collection::highlight_result(const field &search_field,
             continue;
         }
 
-        art_leaf *actual_leaf = index->get_token_leaf(search_field.name,
-                                                      reinterpret_cast<const unsigned char *>(q_token.c_str()),
+        art_leaf *actual_leaf = get_cached_token_leaf(reinterpret_cast<const unsigned char *>(q_token.c_str()),
                                                       q_token.size() + 1);
 
         if(actual_leaf != nullptr && posting_t::contains(actual_leaf->values, field_order_kv->key)) {
@@ -1840,13 +2299,23 @@ void Collection::remove_document(const nlohmann::json & document, const uint32_t
         num_documents -= 1;
     }
 
+    write_epoch++;
+
     if(remove_from_store) {
         store->remove(get_doc_id_key(id));
         store->remove(get_seq_id_key(seq_id));
+
+        // bump-then-erase, in this order after the store write: see doc_cache_put
+        doc_cache_watermark++;
+        doc_cache_erase(seq_id);
     }
 }
 
 Option<std::string> Collection::remove(const std::string & id, const bool remove_from_store) {
+    // like add_many, deletions block until the index is in memory
+    CollectionManager::get_instance().hydrate_collection_wait(this);
+    update_last_access_timestamp();
+
     std::string seq_id_str;
     StoreStatus seq_id_status = store->get(get_doc_id_key(id), seq_id_str);
 
@@ -1907,6 +2376,116 @@ Option<bool> Collection::remove_if_found(uint32_t seq_id, const bool remove_from
     return Option<bool>(true);
 }
 
+void Collection::override_matcher_t::compile(const std::map<std::string, override_t>& overrides) {
+    nodes.assign(1, node_t{});  // root
+    contains_rules.clear();
+    exact_rules.clear();
+    filter_overrides.clear();
+
+    for(const auto& override_kv: overrides) {
+        const override_t& override = override_kv.second;
+
+        if(!override.filter_by.empty()) {
+            // map iteration keeps these in override id order
+            filter_overrides.push_back(&override);
+            continue;
+        }
+
+        if(override.rule.match == override_t::MATCH_EXACT) {
+            exact_rules[override.rule.query].push_back(&override);
+        } else if(override.rule.match == override_t::MATCH_CONTAINS) {
+            // insert the rule query into the trie
+            uint32_t node_id = 0;
+
+            for(unsigned char c: override.rule.query) {
+                auto it = nodes[node_id].next.find(c);
+                if(it == nodes[node_id].next.end()) {
+                    nodes[node_id].next.emplace(c, nodes.size());
+                    node_id = nodes.size();
+                    nodes.emplace_back();
+                } else {
+                    node_id = it->second;
+                }
+            }
+
+            nodes[node_id].rule_ids.push_back(contains_rules.size());
+            contains_rules.push_back(&override);
+        }
+    }
+
+    // BFS to wire suffix links and propagate rule ids along them, so that a
+    // state reports every rule query ending at that position
+    std::vector<uint32_t> bfs_queue = {0};
+
+    for(size_t qi = 0; qi < bfs_queue.size(); qi++) {
+        const uint32_t node_id = bfs_queue[qi];
+
+        for(const auto& edge: nodes[node_id].next) {
+            const uint32_t child_id = edge.second;
+
+            if(node_id != 0) {
+                uint32_t link = nodes[node_id].suffix_link;
+                while(link != 0 && nodes[link].next.count(edge.first) == 0) {
+                    link = nodes[link].suffix_link;
+                }
+
+                const auto link_it = nodes[link].next.find(edge.first);
+                if(link_it != nodes[link].next.end() && link_it->second != child_id) {
+                    nodes[child_id].suffix_link = link_it->second;
+                }
+            }
+
+            const auto& link_rule_ids = nodes[nodes[child_id].suffix_link].rule_ids;
+            nodes[child_id].rule_ids.insert(nodes[child_id].rule_ids.end(),
+                                            link_rule_ids.begin(), link_rule_ids.end());
+
+            bfs_queue.push_back(child_id);
+        }
+    }
+}
+
+void Collection::override_matcher_t::match(const std::string& query,
+                                           std::vector<const override_t*>& matched) const {
+    const auto exact_it = exact_rules.find(query);
+    if(exact_it != exact_rules.end()) {
+        matched.insert(matched.end(), exact_it->second.begin(), exact_it->second.end());
+    }
+
+    if(!contains_rules.empty()) {
+        std::vector<bool> seen(contains_rules.size(), false);
+        uint32_t state = 0;
+
+        // an empty rule query is matched by every query
+        for(uint32_t rule_id: nodes[0].rule_ids) {
+            seen[rule_id] = true;
+            matched.push_back(contains_rules[rule_id]);
+        }
+
+        for(unsigned char c: query) {
+            while(state != 0 && nodes[state].next.count(c) == 0) {
+                state = nodes[state].suffix_link;
+            }
+
+            const auto it = nodes[state].next.find(c);
+            if(it != nodes[state].next.end()) {
+                state = it->second;
+            }
+
+            for(uint32_t rule_id: nodes[state].rule_ids) {
+                if(!seen[rule_id]) {
+                    seen[rule_id] = true;
+                    matched.push_back(contains_rules[rule_id]);
+                }
+            }
+        }
+    }
+
+    // overrides have to be applied in id order, the way the linear scan did
+    std::sort(matched.begin(), matched.end(), [](const override_t* a, const override_t* b) {
+        return a->id < b->id;
+    });
+}
+
 Option<uint32_t> Collection::add_override(const override_t & override) {
     bool inserted = store->insert(Collection::get_override_key(name, override.id), override.to_json().dump());
     if(!inserted) {
@@ -1915,6 +2494,7 @@ Option<uint32_t> Collection::add_override(const override_t & override) {
 
     std::unique_lock lock(mutex);
     overrides[override.id] = override;
+    override_matcher.compile(overrides);
     return Option<uint32_t>(200);
 }
 
@@ -1927,6 +2507,7 @@ Option<uint32_t> Collection::remove_override(const std::string & id) {
 
         std::unique_lock lock(mutex);
         overrides.erase(id);
+        override_matcher.compile(overrides);
         return Option<uint32_t>(200);
     }
 
@@ -1967,6 +2548,24 @@ size_t Collection::get_num_documents() const {
     return num_documents.load();
 }
 
+size_t Collection::compact_posting_lists() {
+    std::shared_lock lock(mutex);
+    // the index serializes compaction against writes via its own lock
+    return index->compact_posting_lists();
+}
+
+void Collection::serialize_index_state(index_snapshot_writer_t& writer) {
+    std::shared_lock lock(mutex);
+    writer.write_u64(num_documents.load());
+    index->serialize_index_state(writer);
+}
+
+bool Collection::load_index_state(index_snapshot_reader_t& reader) {
+    std::unique_lock lock(mutex);
+    num_documents = reader.read_u64();
+    return reader.ok() && index->load_index_state(reader);
+}
+
 uint32_t Collection::get_collection_id() const {
     return collection_id.load();
 }
@@ -2044,7 +2643,17 @@ std::string Collection::get_default_sorting_field() {
     return default_sorting_field;
 }
 
-Option<bool> Collection::get_document_from_store(const uint32_t& seq_id, nlohmann::json& document) const {
+Option<bool> Collection::get_document_from_store(const uint32_t& seq_id, nlohmann::json& document,
+                                                 const spp::sparse_hash_set<std::string>* field_filter,
+                                                 std::string* raw_doc) const {
+    if(doc_cache_get(seq_id, document)) {
+        AppMetrics::get_instance().increment_count(AppMetrics::DOC_CACHE_HIT_LABEL, 1);
+        return Option<bool>(true);
+    }
+
+    // snapshot before the store read, so that a racing write is detected
+    const uint64_t watermark = doc_cache_watermark.load();
+
     std::string json_doc_str;
     StoreStatus json_doc_status = store->get(get_seq_id_key(seq_id), json_doc_str);
 
@@ -2053,32 +2662,47 @@ Option<bool> Collection::get_document_from_store(const uint32_t& seq_id, nlohman
     }
 
     try {
-        document = nlohmann::json::parse(json_doc_str);
+        if(field_filter != nullptr) {
+            // materialize only the requested top-level fields: the parser
+            // still scans the skipped values but never builds them into the
+            // tree, which is where most of the hydration cost goes
+            const auto filter_cb = [field_filter](int depth, nlohmann::json::parse_event_t event,
+                                                  nlohmann::json& parsed) {
+                if(depth == 1 && event == nlohmann::json::parse_event_t::key) {
+                    return field_filter->count(parsed.get<std::string>()) != 0;
+                }
+                return true;
+            };
+
+            document = nlohmann::json::parse(json_doc_str, filter_cb);
+        } else {
+            document = nlohmann::json::parse(json_doc_str);
+        }
     } catch(...) {
         return Option<bool>(500, "Error while parsing stored document with sequence ID: " + std::to_string(seq_id));
     }
 
-    return Option<bool>(true);
-}
-
-Option<bool> Collection::get_document_from_store(const std::string &seq_id_key, nlohmann::json & document) const {
-    std::string json_doc_str;
-    StoreStatus json_doc_status = store->get(seq_id_key, json_doc_str);
+    AppMetrics::get_instance().increment_count(AppMetrics::DOC_CACHE_MISS_LABEL, 1);
 
-    if(json_doc_status != StoreStatus::FOUND) {
-        const std::string& seq_id = std::to_string(get_seq_id_from_key(seq_id_key));
-        return Option<bool>(500, "Could not locate the JSON document for sequence ID: " + seq_id);
-    }
+    if(field_filter == nullptr) {
+        // partial documents must not be cached
+        doc_cache_put(seq_id, document, watermark);
 
-    try {
-        document = nlohmann::json::parse(json_doc_str);
-    } catch(...) {
-        return Option<bool>(500, "Error while parsing stored document with sequence ID: " + seq_id_key);
+        if(raw_doc != nullptr) {
+            // the stored bytes were parsed as-is, so they can stand in for the document
+            *raw_doc = std::move(json_doc_str);
+        }
     }
 
     return Option<bool>(true);
 }
 
+Option<bool> Collection::get_document_from_store(const std::string &seq_id_key, nlohmann::json & document,
+                                                 const spp::sparse_hash_set<std::string>* field_filter,
+                                                 std::string* raw_doc) const {
+    return get_document_from_store(get_seq_id_from_key(seq_id_key), document, field_filter, raw_doc);
+}
+
 const Index* Collection::_get_index() const {
     return index;
 }
@@ -2119,6 +2743,72 @@ Option<bool> Collection::parse_pinned_hits(const std::string& pinned_hits_str,
     return Option<bool>(true);
 }
 
+void Collection::synonym_matcher_t::add(const synonym_t& synonym) {
+    if(nodes.empty()) {
+        nodes.emplace_back();
+    }
+
+    auto add_sequence = [this](const std::vector<std::string>& seq_tokens, const std::string& id) {
+        uint32_t state = 0;
+
+        for(const auto& token: seq_tokens) {
+            uint64_t token_hash = StringUtils::hash_wy(token.c_str(), token.size());
+            const auto it = nodes[state].next.find(token_hash);
+
+            if(it == nodes[state].next.end()) {
+                uint32_t next_state = nodes.size();
+                nodes[state].next.emplace(token_hash, next_state);
+                nodes.emplace_back();
+                state = next_state;
+            } else {
+                state = it->second;
+            }
+        }
+
+        nodes[state].synonym_ids.push_back(id);
+    };
+
+    if(!synonym.root.empty()) {
+        add_sequence(synonym.root, synonym.id);
+    } else {
+        for(const auto& syn_tokens: synonym.synonyms) {
+            add_sequence(syn_tokens, synonym.id);
+        }
+    }
+}
+
+void Collection::synonym_matcher_t::compile(const spp::sparse_hash_map<std::string, synonym_t>& definitions) {
+    nodes.assign(1, node_t());
+
+    for(const auto& kv: definitions) {
+        add(kv.second);
+    }
+}
+
+void Collection::synonym_matcher_t::match_at(const std::vector<uint64_t>& token_hashes, size_t start,
+                                             std::vector<match_t>& matches) const {
+    if(nodes.empty()) {
+        return;
+    }
+
+    uint32_t state = 0;
+    uint64_t syn_hash = 1;
+
+    for(size_t i = start; i < token_hashes.size(); i++) {
+        const auto it = nodes[state].next.find(token_hashes[i]);
+        if(it == nodes[state].next.end()) {
+            return;
+        }
+
+        state = it->second;
+        syn_hash = (i == start) ? token_hashes[i] : Index::hash_combine(syn_hash, token_hashes[i]);
+
+        if(!nodes[state].synonym_ids.empty()) {
+            matches.push_back({i - start + 1, syn_hash, &nodes[state].synonym_ids});
+        }
+    }
+}
+
 void Collection::synonym_reduction(const std::vector<std::string>& tokens,
                                    std::vector<std::vector<std::string>>& results) const {
     if(synonym_definitions.empty()) {
@@ -2140,17 +2830,8 @@ Option<bool> Collection::add_synonym(const synonym_t& synonym) {
 
     std::unique_lock write_lock(mutex);
     synonym_definitions[synonym.id] = synonym;
-
-    if(!synonym.root.empty()) {
-        uint64_t root_hash = synonym_t::get_hash(synonym.root);
-        synonym_index[root_hash].emplace_back(synonym.id);
-    } else {
-        for(const auto & syn_tokens : synonym.synonyms) {
-            uint64_t syn_hash = synonym_t::get_hash(syn_tokens);
-            synonym_index[syn_hash].emplace_back(synonym.id);
-        }
-    }
-
+    synonym_matcher.add(synonym);
+    query_plan_version++;
     write_lock.unlock();
 
     bool inserted = store->insert(Collection::get_synonym_key(name, synonym.id), synonym.to_json().dump());
@@ -2179,28 +2860,34 @@ void Collection::synonym_reduction_internal(const std::vector<std::string>& toke
 
     bool recursed = false;
 
+    // one pass over the tokens: hash each token once and walk the synonym trie
+    // from every start position, instead of hashing each window separately
+    std::vector<uint64_t> token_hashes(tokens.size());
+    for(size_t i = 0; i < tokens.size(); i++) {
+        token_hashes[i] = StringUtils::hash_wy(tokens[i].c_str(), tokens[i].size());
+    }
+
+    std::vector<std::vector<synonym_matcher_t::match_t>> matches_by_start(tokens.size());
+    for(size_t start = 0; start < tokens.size(); start++) {
+        synonym_matcher.match_at(token_hashes, start, matches_by_start[start]);
+    }
+
     for(size_t window_len = start_window_size; window_len > 0; window_len--) {
         for(size_t start_index = start_index_pos; start_index+window_len-1 < tokens.size(); start_index++) {
-            std::vector<uint64_t> syn_hashes;
-            uint64_t syn_hash = 1;
+            const synonym_matcher_t::match_t* window_match = nullptr;
 
-            for(size_t i = start_index; i < start_index+window_len; i++) {
-                uint64_t token_hash = StringUtils::hash_wy(tokens[i].c_str(), tokens[i].size());
-
-                if(i == start_index) {
-                    syn_hash = token_hash;
-                } else {
-                    syn_hash = Index::hash_combine(syn_hash, token_hash);
+            for(const auto& candidate: matches_by_start[start_index]) {
+                if(candidate.window_len == window_len) {
+                    window_match = &candidate;
+                    break;
                 }
-
-                syn_hashes.push_back(token_hash);
             }
 
-            const auto& syn_itr = synonym_index.find(syn_hash);
+            const uint64_t syn_hash = (window_match != nullptr) ? window_match->syn_hash : 0;
 
-            if(syn_itr != synonym_index.end() && processed_syn_hashes.count(syn_hash) == 0) {
+            if(window_match != nullptr && processed_syn_hashes.count(syn_hash) == 0) {
                 // tokens in this window match a synonym: reconstruct tokens and rerun synonym mapping against matches
-                const auto& syn_ids = syn_itr->second;
+                const auto& syn_ids = *window_match->synonym_ids;
 
                 for(const auto& syn_id: syn_ids) {
                     const auto &syn_def = synonym_definitions.at(syn_id);
@@ -2246,8 +2933,8 @@ void Collection::synonym_reduction_internal(const std::vector<std::string>& toke
                             processed_syn_hashes.emplace(h);
                         }
 
-                        for (uint64_t h: syn_hashes) {
-                            processed_syn_hashes.emplace(h);
+                        for (size_t i = start_index; i < start_index + window_len; i++) {
+                            processed_syn_hashes.emplace(token_hashes[i]);
                         }
 
                         recursed = true;
@@ -2276,18 +2963,9 @@ Option<bool> Collection::remove_synonym(const std::string &id) {
             return Option<bool>(500, "Error while deleting the synonym from disk.");
         }
 
-        const auto& synonym = syn_iter->second;
-        if(!synonym.root.empty()) {
-            uint64_t root_hash = synonym_t::get_hash(synonym.root);
-            synonym_index.erase(root_hash);
-        } else {
-            for(const auto & syn_tokens : synonym.synonyms) {
-                uint64_t syn_hash = synonym_t::get_hash(syn_tokens);
-                synonym_index.erase(syn_hash);
-            }
-        }
-
         synonym_definitions.erase(id);
+        synonym_matcher.compile(synonym_definitions);
+        query_plan_version++;
         return Option<bool>(true);
     }
 
@@ -2430,6 +3108,7 @@ Option<bool> Collection::check_and_update_schema(nlohmann::json& document, const
             }
 
             index->refresh_schemas(new_fields);
+            query_plan_version++;
 
         } catch(...) {
             return Option<bool>(500, "Unable to parse collection meta.");
@@ -2466,6 +3145,7 @@ Index* Collection::init_index() {
                      collection_id,
                      store,
                      CollectionManager::get_instance().get_thread_pool(),
+                     CollectionManager::get_instance().get_indexing_thread_pool(),
                      search_schema, facet_schema, sort_schema,
                      symbols_to_index, token_separators);
 }
@@ -1,9 +1,15 @@
 #include <string>
 #include <vector>
+#include <cstdio>
+#include <random>
+#include <sys/stat.h>
 #include <json.hpp>
+#include <thread>
 #include <app_metrics.h>
+#include <system_metrics.h>
 #include "collection_manager.h"
 #include "batched_indexer.h"
+#include "index_snapshot.h"
 #include "logger.h"
 
 constexpr const size_t CollectionManager::DEFAULT_NUM_MEMORY_SHARDS;
@@ -37,8 +43,13 @@ Collection* CollectionManager::init_collection(const nlohmann::json & collection
             field_obj[fields::locale] = "";
         }
 
+        if(field_obj.count(fields::materialize) == 0) {
+            field_obj[fields::materialize] = false;
+        }
+
         fields.push_back({field_obj[fields::name], field_obj[fields::type], field_obj[fields::facet],
-                          field_obj[fields::optional], field_obj[fields::index], field_obj[fields::locale]});
+                          field_obj[fields::optional], field_obj[fields::index], field_obj[fields::locale],
+                          field_obj[fields::materialize]});
     }
 
     std::string default_sorting_field = collection_meta[Collection::COLLECTION_DEFAULT_SORTING_FIELD_KEY].get<std::string>();
@@ -46,10 +57,6 @@ Collection* CollectionManager::init_collection(const nlohmann::json & collection
     uint64_t created_at = collection_meta.find((const char*)Collection::COLLECTION_CREATED) != collection_meta.end() ?
                        collection_meta[Collection::COLLECTION_CREATED].get<uint64_t>() : 0;
 
-    size_t num_memory_shards = collection_meta.count(Collection::COLLECTION_NUM_MEMORY_SHARDS) != 0 ?
-                               collection_meta[Collection::COLLECTION_NUM_MEMORY_SHARDS].get<size_t>() :
-                               DEFAULT_NUM_MEMORY_SHARDS;
-
     std::string fallback_field_type = collection_meta.count(Collection::COLLECTION_FALLBACK_FIELD_TYPE) != 0 ?
                               collection_meta[Collection::COLLECTION_FALLBACK_FIELD_TYPE].get<std::string>() :
                               "";
@@ -65,7 +72,7 @@ Collection* CollectionManager::init_collection(const nlohmann::json & collection
         token_separators = collection_meta[Collection::COLLECTION_SEPARATORS].get<std::vector<std::string>>();
     }
 
-    LOG(INFO) << "Found collection " << this_collection_name << " with " << num_memory_shards << " memory shards.";
+    LOG(INFO) << "Found collection " << this_collection_name << ".";
 
     Collection* collection = new Collection(this_collection_name,
                                             collection_meta[Collection::COLLECTION_ID_KEY].get<uint32_t>(),
@@ -90,7 +97,7 @@ void CollectionManager::add_to_collections(Collection* collection) {
     collection_id_names.emplace(collection_id, collection_name);
 }
 
-void CollectionManager::init(Store *store, ThreadPool* thread_pool,
+void CollectionManager::init(Store *store, ThreadPool* thread_pool, ThreadPool* indexing_thread_pool,
                              const float max_memory_ratio,
                              const std::string & auth_key,
                              std::atomic<bool>& quit,
@@ -99,6 +106,7 @@ void CollectionManager::init(Store *store, ThreadPool* thread_pool,
 
     this->store = store;
     this->thread_pool = thread_pool;
+    this->indexing_thread_pool = indexing_thread_pool;
     this->bootstrap_auth_key = auth_key;
     this->max_memory_ratio = max_memory_ratio;
     this->quit = &quit;
@@ -109,7 +117,8 @@ void CollectionManager::init(Store *store, ThreadPool* thread_pool,
 void CollectionManager::init(Store *store, const float max_memory_ratio, const std::string & auth_key,
                              std::atomic<bool>& quit) {
     ThreadPool* thread_pool = new ThreadPool(8);
-    init(store, thread_pool, max_memory_ratio, auth_key, quit, nullptr);
+    ThreadPool* indexing_thread_pool = new ThreadPool(4);
+    init(store, thread_pool, indexing_thread_pool, max_memory_ratio, auth_key, quit, nullptr);
 }
 
 Option<bool> CollectionManager::load(const size_t collection_batch_size, const size_t document_batch_size) {
@@ -137,6 +146,14 @@ Option<bool> CollectionManager::load(const size_t collection_batch_size, const s
     LOG(INFO) << "Loading " << collection_batch_size << " collections in parallel, "
               << document_batch_size << " documents at a time.";
 
+    // remembered for lazy hydrations triggered later
+    lazy_document_batch_size = document_batch_size;
+    const bool lazy = lazy_mode;
+
+    if(lazy) {
+        LOG(INFO) << "Lazy collection mode: only collection metadata will be loaded at start-up.";
+    }
+
     std::vector<std::string> collection_meta_jsons;
     store->scan_fill(Collection::COLLECTION_META_PREFIX, collection_meta_jsons);
 
@@ -159,11 +176,11 @@ Option<bool> CollectionManager::load(const size_t collection_batch_size, const s
         }
 
         auto captured_store = store;
-        loading_pool.enqueue([captured_store, num_collections, collection_meta, document_batch_size,
+        loading_pool.enqueue([captured_store, num_collections, collection_meta, document_batch_size, lazy,
                               &m_process, &cv_process, &num_processed, &next_coll_id_status, quit = quit]() {
 
             //auto begin = std::chrono::high_resolution_clock::now();
-            Option<bool> res = load_collection(collection_meta, document_batch_size, next_coll_id_status, *quit);
+            Option<bool> res = load_collection(collection_meta, document_batch_size, next_coll_id_status, *quit, lazy);
             /*long long int timeMillis =
                     std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - begin).count();
             LOG(INFO) << "Time taken for indexing: " << timeMillis << "ms";*/
@@ -231,6 +248,10 @@ void CollectionManager::dispose() {
 
     collections.clear();
     store->close();
+
+    meta_store = nullptr;
+    query_samples.clear();
+    query_samples_dirty = false;
 }
 
 bool CollectionManager::auth_key_matches(const std::string& auth_key_sent,
@@ -385,6 +406,15 @@ Option<nlohmann::json> CollectionManager::drop_collection(const std::string& col
         }
         delete iter;
 
+        // document JSONs live in their own column family, which the scan above does not cover
+        const std::string& del_seq_id_prefix = del_key_prefix + Collection::SEQ_ID_PREFIX + "_";
+        iter = store->scan(del_seq_id_prefix);
+        while(iter->Valid() && iter->key().starts_with(del_seq_id_prefix)) {
+            store->remove(iter->key().ToString());
+            iter->Next();
+        }
+        delete iter;
+
         // delete overrides
         const std::string& del_override_prefix =
                 std::string(Collection::COLLECTION_OVERRIDE_PREFIX) + "_" + actual_coll_name + "_";
@@ -509,7 +539,8 @@ bool CollectionManager::parse_sort_by_str(std::string sort_by_str, std::vector<s
 }
 
 
-Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& req_params, std::string& results_json_str) {
+Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& req_params, nlohmann::json& result_json,
+                                          std::vector<std::string>* serialized_hits) {
     auto begin = std::chrono::high_resolution_clock::now();
 
     const char *NUM_TYPOS = "num_typos";
@@ -528,6 +559,9 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
     const char *FACET_BY = "facet_by";
     const char *FACET_QUERY = "facet_query";
     const char *MAX_FACET_VALUES = "max_facet_values";
+    const char *APPROX_FACETS = "approx_facets";
+    const char *FACET_SAMPLE_PERCENT = "facet_sample_percent";
+    const char *FACET_SAMPLE_THRESHOLD = "facet_sample_threshold";
 
     const char *GROUP_BY = "group_by";
     const char *GROUP_LIMIT = "group_limit";
@@ -543,6 +577,9 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
     const char *HIDDEN_HITS = "hidden_hits";
     const char *ENABLE_OVERRIDES = "enable_overrides";
 
+    // cursor pagination: a `search_cursor` value from a previous response
+    const char *SEARCH_AFTER = "search_after";
+
     // strings under this length will be fully highlighted, instead of showing a snippet of relevant portion
     const char *SNIPPET_THRESHOLD = "snippet_threshold";
 
@@ -667,6 +704,18 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
         req_params[PRIORITIZE_EXACT_MATCH] = "true";
     }
 
+    if(req_params.count(APPROX_FACETS) == 0) {
+        req_params[APPROX_FACETS] = "false";
+    }
+
+    if(req_params.count(FACET_SAMPLE_PERCENT) == 0) {
+        req_params[FACET_SAMPLE_PERCENT] = "100";
+    }
+
+    if(req_params.count(FACET_SAMPLE_THRESHOLD) == 0) {
+        req_params[FACET_SAMPLE_THRESHOLD] = "0";
+    }
+
     if(req_params.count(PRE_SEGMENTED_QUERY) == 0) {
         req_params[PRE_SEGMENTED_QUERY] = "false";
     }
@@ -752,9 +801,18 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
         return Option<bool>(400,"Parameter `" + std::string(SEARCH_CUTOFF_MS) + "` must be an unsigned integer.");
     }
 
+    if(!StringUtils::is_uint32_t(req_params[FACET_SAMPLE_PERCENT])) {
+        return Option<bool>(400,"Parameter `" + std::string(FACET_SAMPLE_PERCENT) + "` must be an unsigned integer.");
+    }
+
+    if(!StringUtils::is_uint32_t(req_params[FACET_SAMPLE_THRESHOLD])) {
+        return Option<bool>(400,"Parameter `" + std::string(FACET_SAMPLE_THRESHOLD) + "` must be an unsigned integer.");
+    }
+
     bool prioritize_exact_match = (req_params[PRIORITIZE_EXACT_MATCH] == "true");
     bool pre_segmented_query = (req_params[PRE_SEGMENTED_QUERY] == "true");
     bool exhaustive_search = (req_params[EXHAUSTIVE_SEARCH] == "true");
+    bool approx_facets = (req_params[APPROX_FACETS] == "true");
 
     std::string filter_str = req_params.count(FILTER) != 0 ? req_params[FILTER] : "";
 
@@ -791,6 +849,10 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
         req_params[PINNED_HITS] = "";
     }
 
+    if(req_params.count(SEARCH_AFTER) == 0) {
+        req_params[SEARCH_AFTER] = "";
+    }
+
     if(req_params.count(HIDDEN_HITS) == 0) {
         req_params[HIDDEN_HITS] = "";
     }
@@ -860,7 +922,14 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
                                                           enable_overrides,
                                                           req_params[HIGHLIGHT_FIELDS],
                                                           exhaustive_search,
-                                                          static_cast<size_t>(std::stol(req_params[SEARCH_CUTOFF_MS]))
+                                                          static_cast<size_t>(std::stol(req_params[SEARCH_CUTOFF_MS])),
+                                                          static_cast<size_t>(std::stol(req_params[MIN_LEN_1TYPO])),
+                                                          static_cast<size_t>(std::stol(req_params[MIN_LEN_2TYPO])),
+                                                          approx_facets,
+                                                          static_cast<size_t>(std::stol(req_params[FACET_SAMPLE_PERCENT])),
+                                                          static_cast<size_t>(std::stol(req_params[FACET_SAMPLE_THRESHOLD])),
+                                                          serialized_hits,
+                                                          req_params[SEARCH_AFTER]
                                                         );
 
     uint64_t timeMillis = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -873,10 +942,11 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
         return Option<bool>(result_op.code(), result_op.error());
     }
 
-    nlohmann::json result = result_op.get();
-    result["search_time_ms"] = timeMillis;
-    result["page"] = std::stoi(req_params[PAGE]);
-    results_json_str = result.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
+    result_json = result_op.get();
+    result_json["search_time_ms"] = timeMillis;
+    result_json["page"] = std::stoi(req_params[PAGE]);
+
+    CollectionManager::get_instance().sample_query(req_params);
 
     //LOG(INFO) << "Time taken: " << timeMillis << "ms";
 
@@ -887,6 +957,438 @@ ThreadPool* CollectionManager::get_thread_pool() const {
     return thread_pool;
 }
 
+ThreadPool* CollectionManager::get_indexing_thread_pool() const {
+    return indexing_thread_pool;
+}
+
+void CollectionManager::set_meta_store(Store* meta_store) {
+    this->meta_store = meta_store;
+}
+
+void CollectionManager::sample_query(const std::map<std::string, std::string>& req_params) {
+    if(meta_store == nullptr || !query_warmup_done.load()) {
+        // searches issued by the warmup replay itself are not re-sampled
+        return;
+    }
+
+    // only the parameters that shape the work done by a search are sampled
+    static const std::vector<std::string> sampled_params = {
+        "collection", "q", "query_by", "filter_by", "sort_by", "facet_by",
+        "group_by", "per_page", "include_fields", "exclude_fields", "prefix"
+    };
+
+    nlohmann::json sampled = nlohmann::json::object();
+
+    for(const auto& param: sampled_params) {
+        const auto it = req_params.find(param);
+        if(it != req_params.end() && !it->second.empty()) {
+            sampled[it->first] = it->second;
+        }
+    }
+
+    if(sampled.count("collection") == 0) {
+        return;
+    }
+
+    const std::string& sample_key = sampled.dump();
+
+    std::lock_guard<std::mutex> lock(query_samples_mutex);
+    const auto it = query_samples.find(sample_key);
+
+    if(it != query_samples.end()) {
+        it->second++;
+        query_samples_dirty = true;
+    } else if(query_samples.size() < QUERY_SAMPLES_MAX_DISTINCT) {
+        query_samples.emplace(sample_key, 1);
+        query_samples_dirty = true;
+    }
+}
+
+void CollectionManager::persist_query_samples() {
+    if(meta_store == nullptr) {
+        return;
+    }
+
+    std::vector<std::pair<std::string, uint64_t>> top_samples;
+
+    {
+        std::lock_guard<std::mutex> lock(query_samples_mutex);
+        if(!query_samples_dirty) {
+            return;
+        }
+
+        top_samples.assign(query_samples.begin(), query_samples.end());
+        query_samples_dirty = false;
+    }
+
+    const size_t top_k = std::min(QUERY_SAMPLES_TOP_K, top_samples.size());
+    std::partial_sort(top_samples.begin(), top_samples.begin() + top_k, top_samples.end(),
+                      [](const auto& a, const auto& b) {
+                          return a.second > b.second;
+                      });
+
+    nlohmann::json samples_json = nlohmann::json::array();
+
+    for(size_t i = 0; i < top_k; i++) {
+        nlohmann::json entry;
+        entry["count"] = top_samples[i].second;
+        entry["params"] = nlohmann::json::parse(top_samples[i].first);
+        samples_json.push_back(entry);
+    }
+
+    meta_store->insert(QUERY_SAMPLES_KEY, samples_json.dump());
+}
+
+void CollectionManager::trigger_query_warmup() {
+    if(meta_store == nullptr || thread_pool == nullptr) {
+        return;
+    }
+
+    std::string samples_str;
+    StoreStatus status = meta_store->get(QUERY_SAMPLES_KEY, samples_str);
+
+    if(status != StoreStatus::FOUND || samples_str.empty()) {
+        return;
+    }
+
+    bool expected = true;
+    if(!query_warmup_done.compare_exchange_strong(expected, false)) {
+        // a replay is already in flight
+        return;
+    }
+
+    thread_pool->enqueue([this, samples_str]() {
+        nlohmann::json samples_json = nlohmann::json::parse(samples_str, nullptr, false);
+        size_t num_replayed = 0;
+
+        if(samples_json.is_array()) {
+            for(const auto& entry: samples_json) {
+                if(quit != nullptr && quit->load()) {
+                    break;
+                }
+
+                if(!entry.is_object() || entry.count("params") == 0 || !entry["params"].is_object()) {
+                    continue;
+                }
+
+                std::map<std::string, std::string> req_params;
+                for(const auto& kv: entry["params"].items()) {
+                    if(kv.value().is_string()) {
+                        req_params[kv.key()] = kv.value().get<std::string>();
+                    }
+                }
+
+                nlohmann::json result_json;
+                do_search(req_params, result_json);
+                num_replayed++;
+
+                // replay runs at a deliberately gentle pace so it does not
+                // contend with requests that arrive while the node warms up
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+
+        LOG(INFO) << "Query warmup finished, replayed " << num_replayed << " sampled queries.";
+        query_warmup_done = true;
+    });
+}
+
+bool CollectionManager::is_warmed_up() const {
+    return query_warmup_done.load();
+}
+
+void CollectionManager::compact_posting_lists() {
+    // compaction takes each index's write lock, so it must not compete with live writes
+    uint64_t recent_writes = AppMetrics::get_instance().get_count(AppMetrics::DOC_WRITE_LABEL) +
+                             AppMetrics::get_instance().get_count(AppMetrics::IMPORT_LABEL);
+
+    if(recent_writes > COMPACTION_MAX_RECENT_WRITES) {
+        LOG(INFO) << "Deferring posting list compaction, write rate in last window was " << recent_writes;
+        return;
+    }
+
+    std::vector<std::string> collection_names;
+
+    for(Collection* collection: get_collections()) {
+        collection_names.push_back(collection->get_name());
+    }
+
+    for(const std::string& collection_name: collection_names) {
+        thread_pool->enqueue([collection_name]() {
+            // the collection could have been dropped while this task was queued
+            auto collection = CollectionManager::get_instance().get_collection(collection_name);
+            if(collection == nullptr) {
+                return;
+            }
+
+            size_t num_reclaimed = collection->compact_posting_lists();
+
+            if(num_reclaimed != 0) {
+                AppMetrics::get_instance().increment_count(AppMetrics::POSTING_COMPACTION_LABEL, num_reclaimed);
+                LOG(INFO) << "Reclaimed " << num_reclaimed << " posting list blocks of collection `"
+                          << collection_name << "`";
+            }
+        });
+    }
+}
+
+void CollectionManager::set_lazy_mode(const bool enable) {
+    std::unique_lock lock(mutex);
+    lazy_mode = enable;
+}
+
+void CollectionManager::hydrate_collection_async(const std::string& collection_name) {
+    Collection* collection;
+    {
+        std::shared_lock lock(mutex);
+        collection = get_collection_unsafe(collection_name);
+        if(collection == nullptr || !collection->try_start_hydration()) {
+            // already hydrated, or another thread has claimed the replay
+            return;
+        }
+    }
+
+    indexing_thread_pool->enqueue([this, collection_name, collection]() {
+        // the view pins the collection (eviction and drops wait on the shared
+        // lock) for the duration of the replay
+        auto view = get_collection(collection_name);
+        if(view == nullptr || view.get() != collection) {
+            // dropped (and possibly re-created) in between: a re-created
+            // collection starts PENDING and hydrates on its next access
+            return;
+        }
+
+        do_hydrate(view.get());
+    });
+}
+
+void CollectionManager::hydrate_collection_wait(Collection* collection) {
+    while(!collection->is_hydrated()) {
+        if(collection->try_start_hydration()) {
+            if(do_hydrate(collection)) {
+                return;
+            }
+
+            // a committed write cannot be dropped: back off and retry
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(hydration_mutex);
+        hydration_cv.wait_for(lock, std::chrono::milliseconds(500), [collection]() {
+            return collection->is_hydrated();
+        });
+    }
+}
+
+bool CollectionManager::do_hydrate(Collection* collection) {
+    LOG(INFO) << "Hydrating collection " << collection->get_name() << " on first access.";
+
+    const Option<bool> replay_op = replay_documents(collection, lazy_document_batch_size, *quit);
+
+    {
+        std::lock_guard<std::mutex> lock(hydration_mutex);
+        collection->set_hydration_state(replay_op.ok() ? hydration_state_t::HYDRATED
+                                                       : hydration_state_t::PENDING);
+    }
+    hydration_cv.notify_all();
+
+    if(!replay_op.ok()) {
+        LOG(ERROR) << "Error while hydrating collection `" << collection->get_name()
+                   << "`: " << replay_op.error();
+        return false;
+    }
+
+    collection->update_last_access_timestamp();
+    return true;
+}
+
+void CollectionManager::evict_idle_collections() {
+    {
+        std::shared_lock lock(mutex);
+        if(!lazy_mode) {
+            return;
+        }
+    }
+
+    const uint64_t now_ts = static_cast<uint64_t>(std::time(nullptr));
+
+    while(SystemMetrics::used_memory_ratio() > LAZY_EVICTION_WATERMARK * max_memory_ratio) {
+        // pick the longest-idle hydrated collection
+        std::string candidate;
+        uint64_t oldest_ts = 0;
+
+        {
+            std::shared_lock lock(mutex);
+            for(const auto& name_collection: collections) {
+                Collection* collection = name_collection.second;
+                if(!collection->is_hydrated()) {
+                    continue;
+                }
+
+                const uint64_t last_access_ts = collection->get_last_access_timestamp();
+                if(now_ts - last_access_ts < LAZY_MIN_IDLE_SECONDS) {
+                    continue;
+                }
+
+                if(candidate.empty() || last_access_ts < oldest_ts) {
+                    oldest_ts = last_access_ts;
+                    candidate = name_collection.first;
+                }
+            }
+        }
+
+        if(candidate.empty() || !evict_collection(candidate)) {
+            // no candidates left: memory pressure has to be resolved elsewhere
+            break;
+        }
+    }
+}
+
+bool CollectionManager::evict_collection(const std::string& collection_name) {
+    // gather the on-disk state needed for the metadata-only replacement first,
+    // outside the exclusive lock
+    std::string collection_meta_json;
+    if(store->get(Collection::get_meta_key(collection_name), collection_meta_json) != StoreStatus::FOUND) {
+        return false;
+    }
+
+    nlohmann::json collection_meta = nlohmann::json::parse(collection_meta_json, nullptr, false);
+    if(collection_meta.is_discarded()) {
+        return false;
+    }
+
+    std::string next_seq_id_str;
+    if(store->get(Collection::get_next_seq_id_key(collection_name), next_seq_id_str) != StoreStatus::FOUND) {
+        return false;
+    }
+
+    std::vector<std::string> override_jsons;
+    store->scan_fill(Collection::get_override_key(collection_name, ""), override_jsons);
+
+    std::vector<std::string> synonym_jsons;
+    store->scan_fill(Collection::get_synonym_key(collection_name, ""), synonym_jsons);
+
+    std::unique_lock lock(mutex);
+
+    auto it = collections.find(collection_name);
+    if(it == collections.end() || !it->second->is_hydrated()) {
+        return false;
+    }
+
+    Collection* existing = it->second;
+
+    Collection* fresh = init_collection(collection_meta,
+                                        StringUtils::deserialize_uint32_t(next_seq_id_str),
+                                        store, 1.0f);
+    fresh->set_hydration_state(hydration_state_t::PENDING);
+
+    for(const auto& override_json: override_jsons) {
+        nlohmann::json collection_override = nlohmann::json::parse(override_json, nullptr, false);
+        override_t override;
+        if(!collection_override.is_discarded() &&
+           override_t::parse(collection_override, "", override).ok()) {
+            fresh->add_override(override);
+        }
+    }
+
+    for(const auto& synonym_json: synonym_jsons) {
+        nlohmann::json collection_synonym = nlohmann::json::parse(synonym_json, nullptr, false);
+        if(!collection_synonym.is_discarded()) {
+            synonym_t synonym(collection_synonym);
+            fresh->add_synonym(synonym);
+        }
+    }
+
+    collections[collection_name] = fresh;
+    collection_id_names[fresh->get_collection_id()] = collection_name;
+    delete existing;
+
+    LOG(INFO) << "Evicted idle collection " << collection_name << " back to disk.";
+    return true;
+}
+
+void CollectionManager::set_index_snapshot_dir(const std::string& dir) {
+    std::unique_lock lock(mutex);
+    index_snapshot_dir = dir;
+}
+
+void CollectionManager::save_index_snapshots() {
+    std::shared_lock lock(mutex);
+
+    if(index_snapshot_dir.empty()) {
+        return;
+    }
+
+    // ignore failure: an unwritable directory only fails the per-collection
+    // writes below, which fall back to replay-on-boot
+    mkdir(index_snapshot_dir.c_str(), 0755);
+
+    // a fresh random stamp goes into every snapshot file and into the db, which
+    // is checkpointed in this same quiesced section: a db later restored from
+    // another node's snapshot carries that node's stamp, so the stale local
+    // files fail the stamp check and the collections replay instead
+    std::random_device rd;
+    const uint64_t stamp = (uint64_t(rd()) << 32) ^ uint64_t(rd());
+
+    for(const auto& name_collection: collections) {
+        Collection* collection = name_collection.second;
+
+        if(!collection->is_hydrated()) {
+            // a lazy collection without an in-memory index has nothing to dump;
+            // its documents replay on first access as usual
+            continue;
+        }
+
+        // the schema hash is computed from the parsed-then-dumped meta, exactly
+        // the way load_collection recomputes it
+        std::string collection_meta_json;
+        StoreStatus meta_status = store->get(Collection::get_meta_key(collection->get_name()),
+                                             collection_meta_json);
+
+        if(meta_status != StoreStatus::FOUND) {
+            LOG(WARNING) << "Skipping index snapshot of collection `" << collection->get_name()
+                         << "`: could not fetch collection meta.";
+            continue;
+        }
+
+        nlohmann::json collection_meta = nlohmann::json::parse(collection_meta_json, nullptr, false);
+        if(collection_meta.is_discarded()) {
+            LOG(WARNING) << "Skipping index snapshot of collection `" << collection->get_name()
+                         << "`: could not parse collection meta.";
+            continue;
+        }
+
+        const std::string canonical_meta = collection_meta.dump();
+        const uint64_t schema_hash = StringUtils::hash_wy(canonical_meta.c_str(), canonical_meta.size());
+
+        const std::string snapshot_path = index_snapshot_dir + "/" +
+                                          std::to_string(collection->get_collection_id()) + ".idxsnap";
+        const std::string snapshot_tmp_path = snapshot_path + ".tmp";
+
+        index_snapshot_writer_t writer(snapshot_tmp_path);
+        writer.write_u32(index_snapshot_writer_t::SNAPSHOT_MAGIC);
+        writer.write_u32(index_snapshot_writer_t::SNAPSHOT_VERSION);
+        writer.write_u64(stamp);
+        writer.write_u64(schema_hash);
+
+        collection->serialize_index_state(writer);
+
+        if(!writer.finish() || std::rename(snapshot_tmp_path.c_str(), snapshot_path.c_str()) != 0) {
+            // the leftover file carries an older stamp (or none), so it is
+            // ignored at load time and this collection simply replays
+            LOG(WARNING) << "Could not write index snapshot of collection `"
+                         << collection->get_name() << "`.";
+            std::remove(snapshot_tmp_path.c_str());
+            continue;
+        }
+    }
+
+    // files of dropped collections are left behind: no collection meta points
+    // at their ids anymore, so they are never read again and cost only disk
+    store->insert(INDEX_SNAPSHOT_STAMP_KEY, std::to_string(stamp));
+}
+
 nlohmann::json CollectionManager::get_collection_summaries() const {
     std::shared_lock lock(mutex);
 
@@ -1000,7 +1502,8 @@ Option<Collection*> CollectionManager::create_collection(nlohmann::json& req_jso
 Option<bool> CollectionManager::load_collection(const nlohmann::json &collection_meta,
                                                 const size_t batch_size,
                                                 const StoreStatus& next_coll_id_status,
-                                                const std::atomic<bool>& quit) {
+                                                const std::atomic<bool>& quit,
+                                                const bool lazy) {
 
     auto& cm = CollectionManager::get_instance();
 
@@ -1050,6 +1553,50 @@ Option<bool> CollectionManager::load_collection(const nlohmann::json &collection
 
     LOG(INFO) << "Loading collection " << collection->get_name();
 
+    // try restoring the in-memory index from a persisted snapshot before
+    // falling back to replaying every document from the store
+    bool index_restored = false;
+
+    std::string index_snapshot_path;
+    {
+        std::shared_lock lock(cm.mutex);
+        if(!cm.index_snapshot_dir.empty()) {
+            index_snapshot_path = cm.index_snapshot_dir + "/" +
+                                  std::to_string(collection->get_collection_id()) + ".idxsnap";
+        }
+    }
+
+    std::string db_stamp_str;
+    if(!lazy && !index_snapshot_path.empty() &&
+       cm.store->get(INDEX_SNAPSHOT_STAMP_KEY, db_stamp_str) == StoreStatus::FOUND &&
+       StringUtils::is_uint64_t(db_stamp_str) &&
+       index_snapshot_reader_t::verify_file(index_snapshot_path)) {
+
+        const std::string canonical_meta = collection_meta.dump();
+        const uint64_t schema_hash = StringUtils::hash_wy(canonical_meta.c_str(), canonical_meta.size());
+
+        index_snapshot_reader_t reader(index_snapshot_path);
+        const bool header_valid = (reader.read_u32() == index_snapshot_writer_t::SNAPSHOT_MAGIC) &&
+                                  (reader.read_u32() == index_snapshot_writer_t::SNAPSHOT_VERSION) &&
+                                  (reader.read_u64() == std::stoull(db_stamp_str)) &&
+                                  (reader.read_u64() == schema_hash) && reader.ok();
+
+        if(header_valid) {
+            if(collection->load_index_state(reader) && reader.finish()) {
+                index_restored = true;
+            } else {
+                // the collection object has been partially mutated, so it is
+                // rebuilt from scratch before taking the replay path
+                LOG(WARNING) << "Could not load index snapshot of collection `"
+                             << collection->get_name() << "`, replaying documents instead.";
+                delete collection;
+                collection = init_collection(collection_meta, collection_next_seq_id, cm.store, 1.0f);
+            }
+        }
+        // a stale stamp or schema change is expected after snapshot installs
+        // or schema migrations: fall through to the replay path silently
+    }
+
     // initialize overrides
     std::vector<std::string> collection_override_jsons;
     cm.store->scan_fill(Collection::get_override_key(this_collection_name, ""), collection_override_jsons);
@@ -1075,78 +1622,145 @@ Option<bool> CollectionManager::load_collection(const nlohmann::json &collection
         collection->add_synonym(synonym);
     }
 
+    if(index_restored) {
+        cm.add_to_collections(collection);
+        LOG(INFO) << "Restored collection " << collection->get_name() << " from an index snapshot.";
+        return Option<bool>(true);
+    }
+
+    if(lazy) {
+        // metadata-only boot: documents are replayed on first access
+        collection->set_hydration_state(hydration_state_t::PENDING);
+        cm.add_to_collections(collection);
+        return Option<bool>(true);
+    }
+
     // Fetch records from the store and re-create memory index
-    std::vector<std::string> documents;
+    const Option<bool> replay_op = replay_documents(collection, batch_size, quit);
+    if(!replay_op.ok()) {
+        return replay_op;
+    }
+
+    cm.add_to_collections(collection);
+    return Option<bool>(true);
+}
+
+Option<bool> CollectionManager::replay_documents(Collection* collection, const size_t batch_size,
+                                                 const std::atomic<bool>& quit) {
+    auto& cm = CollectionManager::get_instance();
+
     const std::string seq_id_prefix = collection->get_seq_id_collection_prefix();
 
     rocksdb::Iterator* iter = cm.store->scan(seq_id_prefix);
     std::unique_ptr<rocksdb::Iterator> iter_guard(iter);
 
-    std::vector<index_record> index_records;
-
     size_t num_found_docs = 0;
     size_t num_valid_docs = 0;
     size_t num_indexed_docs = 0;
 
     auto begin = std::chrono::high_resolution_clock::now();
 
-    while(iter->Valid() && iter->key().starts_with(seq_id_prefix)) {
-        num_found_docs++;
-        const uint32_t seq_id = Collection::get_seq_id_from_key(iter->key().ToString());
-
-        nlohmann::json document;
+    struct raw_doc_t {
+        uint32_t seq_id;
+        std::string value;
+    };
+
+    // scans up to `batch_size` raw documents off the store iterator
+    auto scan_window = [&iter, &seq_id_prefix, batch_size](std::vector<raw_doc_t>& out) {
+        out.clear();
+        while(iter->Valid() && iter->key().starts_with(seq_id_prefix) && out.size() < batch_size) {
+            out.push_back(raw_doc_t{Collection::get_seq_id_from_key(iter->key().ToString()),
+                                    iter->value().ToString()});
+            iter->Next();
+        }
+    };
+
+    auto parse_window = [](std::vector<raw_doc_t>& raw_docs, std::vector<index_record>& out,
+                           std::string& parse_error) {
+        out.clear();
+        parse_error.clear();
+
+        for(const raw_doc_t& raw_doc: raw_docs) {
+            nlohmann::json document;
+
+            try {
+                document = nlohmann::json::parse(raw_doc.value);
+            } catch(const std::exception& e) {
+                LOG(ERROR) << "JSON error: " << e.what();
+                parse_error = "Bad JSON.";
+                return;
+            }
 
-        try {
-            document = nlohmann::json::parse(iter->value().ToString());
-        } catch(const std::exception& e) {
-            LOG(ERROR) << "JSON error: " << e.what();
-            return Option<bool>(false, "Bad JSON.");
+            out.emplace_back(index_record(0, raw_doc.seq_id, document, CREATE, DIRTY_VALUES::DROP));
         }
+    };
 
-        auto dirty_values = DIRTY_VALUES::DROP;
+    ThreadPool* indexing_thread_pool = cm.get_indexing_thread_pool();
 
-        num_valid_docs++;
+    // JSON parsing is the serial, CPU-heavy part of reloading a document, so the next
+    // window of records is parsed on the indexing pool while the current window is
+    // being indexed, keeping one extra window of raw lines in memory per collection
+    std::vector<raw_doc_t> curr_raw, next_raw;
+    std::vector<index_record> curr_records, next_records;
+    std::string curr_parse_error, next_parse_error;
+    std::future<void> parse_ahead;
 
-        index_records.emplace_back(index_record(0, seq_id, document, CREATE, dirty_values));
+    scan_window(curr_raw);
+    parse_window(curr_raw, curr_records, curr_parse_error);
 
-        // Peek and check for last record right here so that we handle batched indexing correctly
-        // Without doing this, the "last batch" would have to be indexed outside the loop.
-        iter->Next();
-        bool last_record = !(iter->Valid() && iter->key().starts_with(seq_id_prefix));
+    while(!curr_raw.empty()) {
+        num_found_docs += curr_raw.size();
 
-        // batch must match atleast the number of shards
-        if((num_valid_docs % batch_size == 0) || last_record) {
-            size_t num_records = index_records.size();
-            size_t num_indexed = collection->batch_index_in_memory(index_records);
+        scan_window(next_raw);
+        if(!next_raw.empty()) {
+            parse_ahead = indexing_thread_pool->enqueue(parse_window, std::ref(next_raw), std::ref(next_records),
+                                                        std::ref(next_parse_error));
+        }
 
-            if(num_indexed != num_records) {
-                const Option<std::string> & index_error_op = get_first_index_error(index_records);
-                if(!index_error_op.ok()) {
-                    return Option<bool>(false, index_error_op.get());
-                }
+        if(!curr_parse_error.empty()) {
+            if(parse_ahead.valid()) {
+                parse_ahead.get();
             }
-
-            index_records.clear();
-            num_indexed_docs += num_indexed;
+            return Option<bool>(false, curr_parse_error);
         }
 
-        if(num_found_docs % ((1 << 14)) == 0) {
-            // having a cheaper higher layer check to prevent checking clock too often
-            auto time_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-                    std::chrono::high_resolution_clock::now() - begin).count();
+        num_valid_docs += curr_records.size();
 
-            if(time_elapsed > 30) {
-                begin = std::chrono::high_resolution_clock::now();
-                LOG(INFO) << "Loaded " << num_found_docs << " documents from " << collection->get_name() << " so far.";
+        size_t num_records = curr_records.size();
+        size_t num_indexed = collection->batch_index_in_memory(curr_records);
+
+        if(num_indexed != num_records) {
+            const Option<std::string> & index_error_op = get_first_index_error(curr_records);
+            if(!index_error_op.ok()) {
+                if(parse_ahead.valid()) {
+                    parse_ahead.get();
+                }
+                return Option<bool>(false, index_error_op.get());
             }
         }
 
+        num_indexed_docs += num_indexed;
+
+        auto time_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::high_resolution_clock::now() - begin).count();
+
+        if(time_elapsed > 30) {
+            begin = std::chrono::high_resolution_clock::now();
+            LOG(INFO) << "Loaded " << num_found_docs << " documents from " << collection->get_name() << " so far.";
+        }
+
+        if(parse_ahead.valid()) {
+            parse_ahead.get();
+        }
+
         if(quit) {
             break;
         }
-    }
 
-    cm.add_to_collections(collection);
+        curr_raw = std::move(next_raw);
+        curr_records = std::move(next_records);
+        curr_parse_error = std::move(next_parse_error);
+    }
 
     LOG(INFO) << "Indexed " << num_indexed_docs << "/" << num_found_docs
               << " documents into collection " << collection->get_name();
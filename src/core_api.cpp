@@ -1,5 +1,6 @@
 #include <chrono>
 #include <thread>
+#include <future>
 #include <app_metrics.h>
 #include "typesense_server_utils.h"
 #include "core_api.h"
@@ -9,6 +10,7 @@
 #include "system_metrics.h"
 #include "logger.h"
 #include "core_api_utils.h"
+#include "http_client.h"
 #include "lru/lru.hpp"
 
 using namespace std::chrono_literals;
@@ -44,13 +46,13 @@ void stream_response(const std::shared_ptr<http_req>& req, const std::shared_ptr
     }
 
     auto req_res = new async_req_res_t(req, res, true);
-    server->get_message_dispatcher()->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
+    server->get_message_dispatcher(req)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
 }
 
 void defer_processing(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res, size_t timeout_ms) {
     defer_processing_t* defer = new defer_processing_t(req, res, timeout_ms, server);
     //LOG(INFO) << "core_api req " << req.get() << ", use count: " << req.use_count();
-    server->get_message_dispatcher()->send_message(HttpServer::DEFER_PROCESSING_MESSAGE, defer);
+    server->get_message_dispatcher(req)->send_message(HttpServer::DEFER_PROCESSING_MESSAGE, defer);
 }
 
 void get_collections_for_auth(std::map<std::string, std::string> &req_params, const std::string &body,
@@ -158,6 +160,12 @@ bool get_debug(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_
     return true;
 }
 
+bool get_debug_rocksdb(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    CollectionManager & collectionManager = CollectionManager::get_instance();
+    res->set_200(collectionManager.get_store()->get_db_stats().dump());
+    return true;
+}
+
 bool get_health(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
     nlohmann::json result;
     bool alive = server->is_alive();
@@ -192,8 +200,7 @@ bool get_metrics_json(const std::shared_ptr<http_req>& req, const std::shared_pt
     CollectionManager & collectionManager = CollectionManager::get_instance();
     const std::string & data_dir_path = collectionManager.get_store()->get_state_dir_path();
 
-    SystemMetrics sys_metrics;
-    sys_metrics.get(data_dir_path, result);
+    SystemMetrics::get_instance().get(data_dir_path, result);
 
     res->set_body(200, result.dump(2));
     return true;
@@ -203,6 +210,12 @@ bool get_stats_json(const std::shared_ptr<http_req>& req, const std::shared_ptr<
     nlohmann::json result;
     AppMetrics::get_instance().get("requests_per_second", "latency_ms", result);
     result["pending_write_batches"] = server->get_num_queued_writes();
+    result["write_drain_rate_per_second"] = server->get_write_drain_rate();
+    result["write_backpressured"] = server->is_write_backpressured();
+    result["applied_lag_entries"] = server->get_applied_lag();
+    result["read_staleness_ms"] = server->get_read_staleness_ms();
+    result["last_snapshot_duration_ms"] = server->get_last_snapshot_duration_ms();
+    result["last_snapshot_bytes_written"] = server->get_last_snapshot_bytes_written();
 
     res->set_body(200, result.dump(2));
     return true;
@@ -230,68 +243,222 @@ uint64_t hash_request(const std::shared_ptr<http_req>& req) {
     return StringUtils::hash_wy(req_str.c_str(), req_str.size());
 }
 
+// bounded-staleness contract: a read carrying `max_staleness_ms` is turned away
+// when this node's applied state could be older than that, so the client can
+// retry against a fresher replica
+bool staleness_is_acceptable(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    const auto max_staleness_it = req->params.find("max_staleness_ms");
+    if(max_staleness_it == req->params.end() || !StringUtils::is_int64_t(max_staleness_it->second)) {
+        return true;
+    }
+
+    const int64_t max_staleness_ms = std::stoll(max_staleness_it->second);
+    if(max_staleness_ms <= 0) {
+        return true;
+    }
+
+    const int64_t staleness_ms = server->get_read_staleness_ms();
+    if(staleness_ms > max_staleness_ms) {
+        res->set_503("Node is lagging beyond the requested max_staleness_ms.");
+        return false;
+    }
+
+    return true;
+}
+
+// a cached response is only served while every collection it was computed from is
+// unchanged, so writes invalidate cached queries without waiting out their TTL
+static bool cached_epochs_are_current(const std::vector<std::pair<std::string, uint64_t>>& collection_write_epochs) {
+    CollectionManager& collectionManager = CollectionManager::get_instance();
+
+    for(const auto& name_epoch: collection_write_epochs) {
+        auto coll = collectionManager.get_collection(name_epoch.first);
+        if(coll == nullptr || coll->get_write_epoch() != name_epoch.second) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 bool get_search(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
-    const auto use_cache_it = req->params.find("use_cache");
-    bool use_cache = (use_cache_it != req->params.end()) && (use_cache_it->second == "1" || use_cache_it->second == "true");
-    uint64_t req_hash = 0;
+    // NOTE: this is a streaming response end-point, so this handler can be called multiple times
+    if(req->data == nullptr) {
+        if(!staleness_is_acceptable(req, res)) {
+            req->last_chunk_aggregate = true;
+            res->final = true;
+            stream_response(req, res);
+            return false;
+        }
 
-    if(use_cache) {
-        // cache enabled, let's check if request is already in the cache
-        req_hash = hash_request(req);
+        const auto use_cache_it = req->params.find("use_cache");
+        bool use_cache = (use_cache_it != req->params.end()) && (use_cache_it->second == "1" || use_cache_it->second == "true");
+        uint64_t req_hash = 0;
+
+        if(use_cache) {
+            // cache enabled, let's check if request is already in the cache
+            req_hash = hash_request(req);
+
+            //LOG(INFO) << "req_hash = " << req_hash;
+
+            std::shared_lock lock(mutex);
+            auto hit_it = res_cache.find(req_hash);
+            if(hit_it != res_cache.end()) {
+                //LOG(INFO) << "Result found in cache.";
+                const auto& cached_value = hit_it.value();
+
+                // we still need to check that TTL has not expired
+                uint32_t ttl = cached_value.ttl;
+                uint64_t seconds_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+                        std::chrono::high_resolution_clock::now() - cached_value.created_at).count();
+
+                if(seconds_elapsed < cached_value.ttl &&
+                   cached_epochs_are_current(cached_value.collection_write_epochs)) {
+                    AppMetrics::get_instance().increment_count(AppMetrics::QUERY_CACHE_HIT_LABEL, 1);
+                    res->set_content(cached_value.status_code, cached_value.content_type_header, cached_value.body, true);
+                    req->last_chunk_aggregate = true;
+                    stream_response(req, res);
+                    return true;
+                }
 
-        //LOG(INFO) << "req_hash = " << req_hash;
+                //LOG(INFO) << "Result found in cache but ttl lapsed or a collection has since changed.";
+            }
 
-        std::shared_lock lock(mutex);
-        auto hit_it = res_cache.find(req_hash);
-        if(hit_it != res_cache.end()) {
-            //LOG(INFO) << "Result found in cache.";
-            const auto& cached_value = hit_it.value();
+            lock.unlock();
+            AppMetrics::get_instance().increment_count(AppMetrics::QUERY_CACHE_MISS_LABEL, 1);
+        }
 
-            // we still need to check that TTL has not expired
-            uint32_t ttl = cached_value.ttl;
-            uint64_t seconds_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-                    std::chrono::high_resolution_clock::now() - cached_value.created_at).count();
+        std::vector<std::pair<std::string, uint64_t>> collection_epochs;
 
-            if(seconds_elapsed < cached_value.ttl) {
-                res->set_content(cached_value.status_code, cached_value.content_type_header, cached_value.body, true);
-                return true;
+        if(use_cache) {
+            // captured before the search, so a write that lands mid-search still
+            // invalidates the cached copy
+            auto cache_coll = CollectionManager::get_instance().get_collection(req->params["collection"]);
+            if(cache_coll != nullptr) {
+                collection_epochs.emplace_back(cache_coll->get_name(), cache_coll->get_write_epoch());
             }
+        }
+
+        nlohmann::json result_json;
+        std::vector<std::string> serialized_hits;
 
-            //LOG(INFO) << "Result found in cache but ttl lapsed.";
+        // a cached entry must hold the whole body in one piece, so direct hit
+        // serialization is only used when the response will be streamed
+        Option<bool> search_op = CollectionManager::do_search(req->params, result_json,
+                                                              use_cache ? nullptr : &serialized_hits);
+
+        if(!search_op.ok()) {
+            res->set(search_op.code(), search_op.error());
+            req->last_chunk_aggregate = true;
+            res->final = true;
+            stream_response(req, res);
+            return false;
         }
+
+        if(use_cache) {
+            // a cached entry must hold the whole body, so cacheable responses are not streamed
+            res->set_200(result_json.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore));
+
+            //LOG(INFO) << "Adding to cache, key = " << req_hash;
+            auto now = std::chrono::high_resolution_clock::now();
+            const auto cache_ttl_it = req->params.find("cache_ttl");
+            uint32_t cache_ttl = 60;
+            if(cache_ttl_it != req->params.end() && StringUtils::is_int32_t(cache_ttl_it->second)) {
+                cache_ttl = std::stoul(cache_ttl_it->second);
+            }
+
+            cached_res_t cached_res;
+            cached_res.load(res->status_code, res->content_type_header, res->body, now, cache_ttl, req_hash,
+                            collection_epochs);
+
+            std::unique_lock lock(mutex);
+            res_cache.insert(req_hash, cached_res);
+            lock.unlock();
+
+            req->last_chunk_aggregate = true;
+            stream_response(req, res);
+            return true;
+        }
+
+        auto search_state = new search_stream_state_t();
+        search_state->hits_key = result_json.contains("grouped_hits") ? "grouped_hits" : "hits";
+
+        if(search_state->hits_key == "hits") {
+            // ungrouped hits were emitted by the search as response-ready strings
+            search_state->hits_are_serialized = true;
+            search_state->serialized_hits = std::move(serialized_hits);
+            result_json.erase("hits");
+        } else if(result_json.contains(search_state->hits_key)) {
+            search_state->hits = std::move(result_json[search_state->hits_key]);
+            result_json.erase(search_state->hits_key);
+        } else {
+            search_state->hits = nlohmann::json::array();
+        }
+
+        search_state->header = result_json.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
+        req->data = search_state;
     }
 
-    std::string results_json_str;
-    Option<bool> search_op = CollectionManager::do_search(req->params, results_json_str);
+    auto search_state = static_cast<search_stream_state_t*>(req->data);
 
-    if(!search_op.ok()) {
-        res->set(search_op.code(), search_op.error());
-        return false;
+    res->body.clear();
+    res->body.reserve(search_stream_state_t::CHUNK_SIZE_BYTES);
+
+    if(search_state->next_hit_index == 0) {
+        // first chunk carries every top-level field except the hits, then opens the hits array
+        res->body = search_state->header;
+        res->body.pop_back();    // strip the closing `}`
+        if(search_state->header.size() > 2) {
+            res->body += ",";
+        }
+        res->body += "\"" + search_state->hits_key + "\":[";
     }
 
-    res->set_200(results_json_str);
+    while(search_state->next_hit_index < search_state->num_hits() &&
+          res->body.size() < search_stream_state_t::CHUNK_SIZE_BYTES) {
+        if(search_state->next_hit_index != 0) {
+            res->body += ",";
+        }
 
-    // we will cache only successful requests
-    if(use_cache) {
-        //LOG(INFO) << "Adding to cache, key = " << req_hash;
-        auto now = std::chrono::high_resolution_clock::now();
-        const auto cache_ttl_it = req->params.find("cache_ttl");
-        uint32_t cache_ttl = 60;
-        if(cache_ttl_it != req->params.end() && StringUtils::is_int32_t(cache_ttl_it->second)) {
-            cache_ttl = std::stoul(cache_ttl_it->second);
+        if(search_state->hits_are_serialized) {
+            std::string& hit = search_state->serialized_hits[search_state->next_hit_index];
+            res->body += hit;
+
+            // each hit is released as soon as it has been written out
+            hit = std::string();
+        } else {
+            nlohmann::json& hit = search_state->hits[search_state->next_hit_index];
+            res->body += hit.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
+
+            // each hit is released as soon as it has been serialized
+            hit = nlohmann::json();
         }
 
-        cached_res_t cached_res;
-        cached_res.load(res->status_code, res->content_type_header, res->body, now, cache_ttl, req_hash);
+        search_state->next_hit_index++;
+    }
 
-        std::unique_lock lock(mutex);
-        res_cache.insert(req_hash, cached_res);
+    if(search_state->next_hit_index < search_state->num_hits()) {
+        req->last_chunk_aggregate = false;
+        res->final = false;
+    } else {
+        res->body += "]}";
+        req->last_chunk_aggregate = true;
+        res->final = true;
+        delete search_state;
+        req->data = nullptr;
     }
 
+    res->status_code = 200;
+
+    stream_response(req, res);
     return true;
 }
 
 bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    if(!staleness_is_acceptable(req, res)) {
+        return false;
+    }
+
     const auto use_cache_it = req->params.find("use_cache");
     bool use_cache = (use_cache_it != req->params.end()) && (use_cache_it->second == "1" || use_cache_it->second == "true");
     uint64_t req_hash = 0;
@@ -313,11 +480,16 @@ bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_p
             uint64_t seconds_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
                     std::chrono::high_resolution_clock::now() - cached_value.created_at).count();
 
-            if(seconds_elapsed < cached_value.ttl) {
+            if(seconds_elapsed < cached_value.ttl &&
+               cached_epochs_are_current(cached_value.collection_write_epochs)) {
+                AppMetrics::get_instance().increment_count(AppMetrics::QUERY_CACHE_HIT_LABEL, 1);
                 res->set_content(cached_value.status_code, cached_value.content_type_header, cached_value.body, true);
                 return true;
             }
         }
+
+        lock.unlock();
+        AppMetrics::get_instance().increment_count(AppMetrics::QUERY_CACHE_MISS_LABEL, 1);
     }
 
     nlohmann::json req_json;
@@ -354,18 +526,120 @@ bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_p
 
     auto orig_req_params = req->params;
 
-    nlohmann::json response;
-    response["results"] = nlohmann::json::array();
-
     nlohmann::json& searches = req_json["searches"];
 
-    for(auto& search_params: searches) {
+    for(const auto& search_params: searches) {
         if(!search_params.is_object()) {
             res->set_400("The value of `searches` must be an array of objects.");
             return false;
         }
 
-        req->params = orig_req_params;
+        if(search_params.count("remote_cluster_url") != 0 && !search_params["remote_cluster_url"].is_string()) {
+            res->set_400("The `remote_cluster_url` of a search must be a string.");
+            return false;
+        }
+    }
+
+    std::vector<nlohmann::json> results_list(searches.size());
+
+    // scatter phase: searches that name a `remote_cluster_url` are forwarded to that
+    // cluster concurrently with the local searches below; each worker fills only its
+    // own slot of `results_list`, so the results retain their original positions
+    std::vector<std::thread> remote_workers;
+
+    for(size_t search_index = 0; search_index < searches.size(); search_index++) {
+        nlohmann::json& search_params = searches[search_index];
+
+        if(search_params.count("remote_cluster_url") == 0) {
+            continue;
+        }
+
+        const std::string remote_url = search_params["remote_cluster_url"].get<std::string>();
+
+        std::string remote_api_key;
+        if(search_params.count("remote_api_key") != 0 && search_params["remote_api_key"].is_string()) {
+            remote_api_key = search_params["remote_api_key"].get<std::string>();
+        }
+
+        long remote_timeout_ms = 4000;
+        if(search_params.count("remote_timeout_ms") != 0 && search_params["remote_timeout_ms"].is_number_integer()) {
+            remote_timeout_ms = search_params["remote_timeout_ms"].get<long>();
+        }
+
+        nlohmann::json remote_search = search_params;
+        remote_search.erase("remote_cluster_url");
+        remote_search.erase("remote_api_key");
+        remote_search.erase("remote_timeout_ms");
+
+        // common search params of the original request apply to the remote search too,
+        // but embedded params have higher priority, same as for local searches
+        for(const auto& kv: orig_req_params) {
+            if(kv.first == "use_cache" || kv.first == "limit_multi_searches" || kv.first == "max_staleness_ms") {
+                continue;
+            }
+
+            if(remote_search.count(kv.first) == 0) {
+                remote_search[kv.first] = kv.second;
+            }
+        }
+
+        nlohmann::json remote_req_body;
+        remote_req_body["searches"] = nlohmann::json::array();
+        remote_req_body["searches"].push_back(remote_search);
+
+        nlohmann::json* result_slot = &results_list[search_index];
+
+        remote_workers.emplace_back([remote_url, remote_api_key, remote_timeout_ms,
+                                     body_str = remote_req_body.dump(), result_slot]() {
+            std::string response_str;
+            std::map<std::string, std::string> res_headers;
+            long status_code = HttpClient::post_response_remote(remote_url + "/multi_search", body_str,
+                                                                remote_api_key, remote_timeout_ms,
+                                                                response_str, res_headers);
+
+            nlohmann::json remote_response = nlohmann::json::parse(response_str, nullptr, false);
+
+            if(status_code == 200 && remote_response.is_object() &&
+               remote_response.count("results") != 0 && remote_response["results"].is_array() &&
+               remote_response["results"].size() == 1) {
+                *result_slot = remote_response["results"][0];
+                return;
+            }
+
+            nlohmann::json err_res;
+            err_res["error"] = (remote_response.is_object() && remote_response.count("message") != 0) ?
+                               remote_response["message"] : nlohmann::json("Remote cluster search failed.");
+            err_res["code"] = status_code;
+            *result_slot = err_res;
+        });
+    }
+
+    bool bad_params = false;
+
+    // write epochs of the local collections searched, for cache invalidation on
+    // writes; remote results cannot be epoch-validated and only age out via TTL
+    std::vector<std::pair<std::string, uint64_t>> collection_epochs;
+
+    // local entries are independent, so they fan out onto the application thread
+    // pool and run concurrently: the response latency becomes the slowest entry
+    // instead of the sum of all entries. Params are merged and validated here on
+    // the handler thread, and each task writes only its own `results_list` slot.
+    std::vector<std::future<void>> local_searches;
+    ThreadPool* thread_pool = CollectionManager::get_instance().get_thread_pool();
+
+    size_t num_local_searches = 0;
+    for(const auto& search_params: searches) {
+        num_local_searches += (search_params.count("remote_cluster_url") == 0) ? 1 : 0;
+    }
+
+    for(size_t search_index = 0; search_index < searches.size(); search_index++) {
+        nlohmann::json& search_params = searches[search_index];
+
+        if(search_params.count("remote_cluster_url") != 0) {
+            continue;
+        }
+
+        std::map<std::string, std::string> entry_params = orig_req_params;
 
         for(auto& search_item: search_params.items()) {
             if(search_item.key() == "cache_ttl") {
@@ -374,26 +648,72 @@ bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_p
             }
 
             // overwrite = false since req params will contain embedded params and so has higher priority
-            bool populated = AuthManager::add_item_to_params(req->params, search_item, false);
+            bool populated = AuthManager::add_item_to_params(entry_params, search_item, false);
             if(!populated) {
-                res->set_400("One or more search parameters are malformed.");
-                return false;
+                bad_params = true;
+                break;
+            }
+        }
+
+        if(bad_params) {
+            break;
+        }
+
+        if(use_cache) {
+            // captured before the search, so a write that lands mid-search still
+            // invalidates the cached copy
+            auto cache_coll = CollectionManager::get_instance().get_collection(entry_params["collection"]);
+            if(cache_coll != nullptr) {
+                collection_epochs.emplace_back(cache_coll->get_name(), cache_coll->get_write_epoch());
             }
         }
 
-        std::string results_json_str;
-        Option<bool> search_op = CollectionManager::do_search(req->params, results_json_str);
+        nlohmann::json* result_slot = &results_list[search_index];
+
+        auto run_search = [entry_params = std::move(entry_params), result_slot]() mutable {
+            nlohmann::json result_json;
+            Option<bool> search_op = CollectionManager::do_search(entry_params, result_json);
 
-        if(search_op.ok()) {
-            response["results"].push_back(nlohmann::json::parse(results_json_str));
+            if(search_op.ok()) {
+                *result_slot = std::move(result_json);
+            } else {
+                nlohmann::json err_res;
+                err_res["error"] = search_op.error();
+                err_res["code"] = search_op.code();
+                *result_slot = err_res;
+            }
+        };
+
+        if(num_local_searches == 1 && remote_workers.empty()) {
+            // a lone search has nothing to overlap with: skip the pool round-trip
+            run_search();
         } else {
-            nlohmann::json err_res;
-            err_res["error"] = search_op.error();
-            err_res["code"] = search_op.code();
-            response["results"].push_back(err_res);
+            local_searches.push_back(thread_pool->enqueue(std::move(run_search)));
         }
     }
 
+    // gather phase: local futures and remote workers must be drained even when a
+    // later entry had malformed params, since they write into `results_list`
+    for(auto& local_search: local_searches) {
+        local_search.wait();
+    }
+
+    for(auto& remote_worker: remote_workers) {
+        remote_worker.join();
+    }
+
+    if(bad_params) {
+        res->set_400("One or more search parameters are malformed.");
+        return false;
+    }
+
+    nlohmann::json response;
+    response["results"] = nlohmann::json::array();
+
+    for(auto& result: results_list) {
+        response["results"].push_back(std::move(result));
+    }
+
     res->set_200(response.dump());
 
     // we will cache only successful requests
@@ -407,7 +727,8 @@ bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_p
         }
 
         cached_res_t cached_res;
-        cached_res.load(res->status_code, res->content_type_header, res->body, now, cache_ttl, req_hash);
+        cached_res.load(res->status_code, res->content_type_header, res->body, now, cache_ttl, req_hash,
+                        collection_epochs);
 
         std::unique_lock lock(mutex);
         res_cache.insert(req_hash, cached_res);
@@ -431,6 +752,21 @@ bool get_collection_summary(const std::shared_ptr<http_req>& req, const std::sha
     return true;
 }
 
+bool get_collection_stats(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    CollectionManager& collectionManager = CollectionManager::get_instance();
+    auto collection = collectionManager.get_collection(req->params["collection"]);
+
+    if(collection == nullptr) {
+        res->set_404();
+        return false;
+    }
+
+    nlohmann::json json_response = collection->get_stats_json();
+    res->set_200(json_response.dump());
+
+    return true;
+}
+
 bool get_export_documents(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
     // NOTE: this is a streaming response end-point so this handler will be called multiple times
     CollectionManager & collectionManager = CollectionManager::get_instance();
@@ -474,7 +810,8 @@ bool get_export_documents(const std::shared_ptr<http_req>& req, const std::share
         }
 
         if(simple_filter_query.empty()) {
-            export_state->it = collectionManager.get_store()->scan(seq_id_prefix);
+            export_state->it = collectionManager.get_store()->scan(seq_id_prefix,
+                                                                   export_state_t::SCAN_READAHEAD_BYTES);
         } else {
             auto filter_ids_op = collection->get_filter_ids(simple_filter_query, export_state->index_ids);
 
@@ -502,9 +839,21 @@ bool get_export_documents(const std::shared_ptr<http_req>& req, const std::share
     if(export_state->it != nullptr) {
         rocksdb::Iterator* it = export_state->it;
 
-        if(it->Valid() && it->key().ToString().compare(0, seq_id_prefix.size(), seq_id_prefix) == 0) {
+        // pack documents into the response buffer until the chunk is large enough:
+        // shipping one row per deferred invocation makes the export latency-bound
+        // instead of disk-bound
+        res->body.clear();
+        res->body.reserve(export_state_t::CHUNK_SIZE_BYTES);
+
+        bool more = it->Valid() && it->key().ToString().compare(0, seq_id_prefix.size(), seq_id_prefix) == 0;
+
+        while(more && res->body.size() < export_state_t::CHUNK_SIZE_BYTES) {
+            if(export_state->exported_any) {
+                res->body += "\n";
+            }
+
             if(export_state->include_fields.empty() && export_state->exclude_fields.empty()) {
-                res->body = it->value().ToString();
+                res->body.append(it->value().data(), it->value().size());
             } else {
                 nlohmann::json doc = nlohmann::json::parse(it->value().ToString());
                 nlohmann::json filtered_doc;
@@ -520,22 +869,22 @@ bool get_export_documents(const std::shared_ptr<http_req>& req, const std::share
                     }
                 }
 
-                res->body = filtered_doc.dump();
+                res->body += filtered_doc.dump();
             }
 
+            export_state->exported_any = true;
             it->Next();
+            more = it->Valid() && it->key().ToString().compare(0, seq_id_prefix.size(), seq_id_prefix) == 0;
+        }
 
-            // append a new line character if there is going to be one more record to send
-            if(it->Valid() && it->key().ToString().compare(0, seq_id_prefix.size(), seq_id_prefix) == 0) {
-                res->body += "\n";
-                req->last_chunk_aggregate = false;
-                res->final = false;
-            } else {
-                req->last_chunk_aggregate = true;
-                res->final = true;
-                delete export_state;
-                req->data = nullptr;
-            }
+        if(more) {
+            req->last_chunk_aggregate = false;
+            res->final = false;
+        } else {
+            req->last_chunk_aggregate = true;
+            res->final = true;
+            delete export_state;
+            req->data = nullptr;
         }
     } else {
         bool done;
@@ -566,11 +915,16 @@ bool post_import_documents(const std::shared_ptr<http_req>& req, const std::shar
     const char *BATCH_SIZE = "batch_size";
     const char *ACTION = "action";
     const char *DIRTY_VALUES = "dirty_values";
+    const char *FORMAT = "format";
 
     if(req->params.count(BATCH_SIZE) == 0) {
         req->params[BATCH_SIZE] = "40";
     }
 
+    if(req->params.count(FORMAT) == 0) {
+        req->params[FORMAT] = "jsonl";
+    }
+
     if(req->params.count(ACTION) == 0) {
         req->params[ACTION] = "create";
     }
@@ -593,6 +947,15 @@ bool post_import_documents(const std::shared_ptr<http_req>& req, const std::shar
         return false;
     }
 
+    if(req->params[FORMAT] != "jsonl" && req->params[FORMAT] != "msgpack") {
+        res->final = true;
+        res->set_400("Parameter `" + std::string(FORMAT) + "` must be a jsonl|msgpack.");
+        stream_response(req, res);
+        return false;
+    }
+
+    const bool msgpack_import = (req->params[FORMAT] == "msgpack");
+
     const size_t IMPORT_BATCH_SIZE = std::stoi(req->params[BATCH_SIZE]);
 
     if(IMPORT_BATCH_SIZE == 0) {
@@ -624,14 +987,42 @@ bool post_import_documents(const std::shared_ptr<http_req>& req, const std::shar
     //LOG(INFO) << "req body %: " << (float(req->body_index)/req->body.size())*100;
 
     std::vector<std::string> json_lines;
-    StringUtils::split(req->body, json_lines, "\n", false);
+
+    if(msgpack_import) {
+        // binary framing: 4-byte little-endian length followed by that many bytes
+        // of a MessagePack-encoded document; a partial frame waits for more chunks
+        size_t offset = 0;
+
+        while(req->body.size() - offset >= 4) {
+            const auto* raw = reinterpret_cast<const unsigned char*>(req->body.data() + offset);
+            const uint32_t frame_len = uint32_t(raw[0]) | (uint32_t(raw[1]) << 8) |
+                                       (uint32_t(raw[2]) << 16) | (uint32_t(raw[3]) << 24);
+
+            if(req->body.size() - offset - 4 < frame_len) {
+                break;
+            }
+
+            json_lines.emplace_back(req->body, offset + 4, frame_len);
+            offset += 4 + size_t(frame_len);
+        }
+
+        req->body.erase(0, offset);
+
+        if(req->last_chunk_aggregate && !req->body.empty()) {
+            // truncated trailing frame: surface it as a bad record instead of dropping it
+            json_lines.emplace_back(req->body);
+            req->body = "";
+        }
+    } else {
+        StringUtils::split(req->body, json_lines, "\n", false);
+    }
 
     //LOG(INFO) << "json_lines.size before: " << json_lines.size() << ", req->body_index: " << req->body_index;
 
     if(req->last_chunk_aggregate) {
         //LOG(INFO) << "req->last_chunk_aggregate is true";
         req->body = "";
-    } else {
+    } else if(!msgpack_import) {
         if(!json_lines.empty()) {
             // check if req->body had complete last record
             bool complete_document;
@@ -669,7 +1060,7 @@ bool post_import_documents(const std::shared_ptr<http_req>& req, const std::shar
 
         const auto& dirty_values = collection->parse_dirty_values_option(req->params[DIRTY_VALUES]);
         nlohmann::json json_res = collection->add_many(json_lines, document, operation, "",
-                                                       dirty_values);
+                                                       dirty_values, msgpack_import);
         //const std::string& import_summary_json = json_res->dump();
         //response_stream << import_summary_json << "\n";
 
@@ -833,8 +1224,11 @@ bool del_remove_documents(const std::shared_ptr<http_req>& req, const std::share
     const char *BATCH_SIZE = "batch_size";
     const char *FILTER_BY = "filter_by";
 
+    const bool async_job = (req->params.count("async") != 0 && req->params["async"] == "true");
+
     if(req->params.count(BATCH_SIZE) == 0) {
-        req->params[BATCH_SIZE] = "40";
+        // background jobs default to much larger batches since no response is held open
+        req->params[BATCH_SIZE] = async_job ? std::to_string(DeleteJobManager::DEFAULT_JOB_BATCH_SIZE) : "40";
     }
 
     if(req->params.count(FILTER_BY) == 0) {
@@ -869,6 +1263,24 @@ bool del_remove_documents(const std::shared_ptr<http_req>& req, const std::share
         simple_filter_query = req->params[FILTER_BY];
     }
 
+    if(async_job) {
+        // deletion runs as a background job: respond immediately with a job id
+        // that can be polled or cancelled via the `delete_jobs` end-points
+        auto job_op = DeleteJobManager::get_instance().submit(req->params["collection"], simple_filter_query,
+                                                              DELETE_BATCH_SIZE);
+        req->last_chunk_aggregate = true;
+        res->final = true;
+
+        if(!job_op.ok()) {
+            res->set(job_op.code(), job_op.error());
+        } else {
+            res->body = job_op.get()->to_json().dump();
+        }
+
+        stream_response(req, res);
+        return job_op.ok();
+    }
+
     deletion_state_t* deletion_state = nullptr;
 
     if(req->data == nullptr) {
@@ -926,6 +1338,40 @@ bool del_remove_documents(const std::shared_ptr<http_req>& req, const std::share
     return true;
 }
 
+bool get_delete_job(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    if(!StringUtils::is_uint64_t(req->params["id"])) {
+        res->set_400("Parameter `id` must be an unsigned integer.");
+        return false;
+    }
+
+    auto job_op = DeleteJobManager::get_instance().get(std::stoull(req->params["id"]));
+
+    if(!job_op.ok() || job_op.get()->collection != req->params["collection"]) {
+        res->set_404();
+        return false;
+    }
+
+    res->set_200(job_op.get()->to_json().dump());
+    return true;
+}
+
+bool del_delete_job(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    if(!StringUtils::is_uint64_t(req->params["id"])) {
+        res->set_400("Parameter `id` must be an unsigned integer.");
+        return false;
+    }
+
+    auto job_op = DeleteJobManager::get_instance().cancel(std::stoull(req->params["id"]));
+
+    if(!job_op.ok() || job_op.get()->collection != req->params["collection"]) {
+        res->set_404();
+        return false;
+    }
+
+    res->set_200(job_op.get()->to_json().dump());
+    return true;
+}
+
 bool get_aliases(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
     CollectionManager & collectionManager = CollectionManager::get_instance();
     const spp::sparse_hash_map<std::string, std::string> & symlinks = collectionManager.get_symlinks();
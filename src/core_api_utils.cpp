@@ -1,4 +1,9 @@
+#include <thread>
+#include <chrono>
+#include <ctime>
 #include "core_api_utils.h"
+#include "collection_manager.h"
+#include "app_metrics.h"
 
 Option<bool> stateful_remove_docs(deletion_state_t* deletion_state, size_t batch_size, bool& done) {
     bool removed = true;
@@ -103,4 +108,163 @@ Option<bool> stateful_export_docs(export_state_t* export_state, size_t batch_siz
     }
 
     return Option<bool>(true);
-}
\ No newline at end of file
+}
+
+const char* delete_job_t::state_to_str(state_t state) {
+    switch(state) {
+        case state_t::running: return "running";
+        case state_t::done: return "done";
+        case state_t::failed: return "failed";
+        case state_t::cancelled: return "cancelled";
+    }
+
+    return "unknown";
+}
+
+nlohmann::json delete_job_t::to_json() const {
+    const state_t current_state = state.load();
+
+    nlohmann::json obj;
+    obj["id"] = id;
+    obj["collection"] = collection;
+    obj["filter_by"] = filter_by;
+    obj["state"] = state_to_str(current_state);
+    obj["num_matched"] = num_matched.load();
+    obj["num_removed"] = num_removed.load();
+    obj["created_at"] = created_at;
+
+    if(current_state == state_t::failed) {
+        obj["error"] = error;
+    }
+
+    return obj;
+}
+
+Option<std::shared_ptr<delete_job_t>> DeleteJobManager::submit(const std::string& collection,
+                                                               const std::string& filter_by, size_t batch_size) {
+    auto job = std::make_shared<delete_job_t>();
+    job->collection = collection;
+    job->filter_by = filter_by;
+    job->batch_size = batch_size;
+    job->created_at = static_cast<uint64_t>(std::time(0));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job->id = next_job_id++;
+        jobs.emplace(job->id, job);
+
+        // prune the oldest finished jobs so that status polling stays bounded
+        size_t num_finished = 0;
+        for(const auto& kv: jobs) {
+            num_finished += (kv.second->state != delete_job_t::state_t::running) ? 1 : 0;
+        }
+
+        for(auto it = jobs.begin(); it != jobs.end() && num_finished > MAX_FINISHED_JOBS; ) {
+            if(it->second->state != delete_job_t::state_t::running) {
+                it = jobs.erase(it);
+                num_finished--;
+            } else {
+                it++;
+            }
+        }
+    }
+
+    CollectionManager::get_instance().get_thread_pool()->enqueue([this, job]() {
+        run_job(job);
+    });
+
+    return Option<std::shared_ptr<delete_job_t>>(job);
+}
+
+void DeleteJobManager::run_job(const std::shared_ptr<delete_job_t>& job) {
+    deletion_state_t deletion_state{};
+    deletion_state.num_removed = 0;
+
+    {
+        auto collection = CollectionManager::get_instance().get_collection(job->collection);
+        if(collection == nullptr) {
+            job->error = "Collection not found.";
+            job->state = delete_job_t::state_t::failed;
+            return;
+        }
+
+        auto filter_ids_op = collection->get_filter_ids(job->filter_by, deletion_state.index_ids);
+        if(!filter_ids_op.ok()) {
+            job->error = filter_ids_op.error();
+            job->state = delete_job_t::state_t::failed;
+            return;
+        }
+
+        size_t num_matched = 0;
+        for(size_t i = 0; i < deletion_state.index_ids.size(); i++) {
+            deletion_state.offsets.push_back(0);
+            num_matched += deletion_state.index_ids[i].first;
+        }
+
+        job->num_matched = num_matched;
+    }
+
+    bool done = false;
+
+    while(!done) {
+        if(job->cancel_requested) {
+            job->state = delete_job_t::state_t::cancelled;
+            return;
+        }
+
+        // the collection is re-resolved every batch so its lock is held only
+        // for the duration of one batch and a dropped collection ends the job
+        auto collection = CollectionManager::get_instance().get_collection(job->collection);
+        if(collection == nullptr) {
+            job->error = "Collection was dropped while the deletion was in progress.";
+            job->state = delete_job_t::state_t::failed;
+            return;
+        }
+
+        deletion_state.collection = collection.get();
+        Option<bool> remove_op = stateful_remove_docs(&deletion_state, job->batch_size, done);
+
+        if(!remove_op.ok()) {
+            job->error = remove_op.error();
+            job->state = delete_job_t::state_t::failed;
+            return;
+        }
+
+        job->num_removed = deletion_state.num_removed;
+        collection.unlock();
+
+        if(!done && AppMetrics::get_instance().get_count(AppMetrics::SEARCH_LABEL) > 0) {
+            // searches were served in the last metrics window: yield between
+            // batches so live traffic keeps priority over the purge
+            std::this_thread::sleep_for(std::chrono::milliseconds(THROTTLE_SLEEP_MS));
+        }
+    }
+
+    job->state = delete_job_t::state_t::done;
+}
+
+Option<std::shared_ptr<delete_job_t>> DeleteJobManager::get(uint64_t id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = jobs.find(id);
+
+    if(it == jobs.end()) {
+        return Option<std::shared_ptr<delete_job_t>>(404, "Could not find a delete job with the given `id`.");
+    }
+
+    return Option<std::shared_ptr<delete_job_t>>(it->second);
+}
+
+Option<std::shared_ptr<delete_job_t>> DeleteJobManager::cancel(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = jobs.find(id);
+
+    if(it == jobs.end()) {
+        return Option<std::shared_ptr<delete_job_t>>(404, "Could not find a delete job with the given `id`.");
+    }
+
+    if(it->second->state == delete_job_t::state_t::running) {
+        it->second->cancel_requested = true;
+    }
+
+    return Option<std::shared_ptr<delete_job_t>>(it->second);
+}
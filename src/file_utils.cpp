@@ -3,6 +3,10 @@
 #include <butil/files/file_enumerator.h>
 #include <butil/string_printf.h>
 #include <file_utils.h>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <vector>
 
 
 bool directory_exists(const std::string & dir_path) {
@@ -47,6 +51,74 @@ bool copy_dir(const std::string& from_path, const std::string& to_path) {
     return true;
 }
 
+bool copy_dir_throttled(const std::string& from_path, const std::string& to_path,
+                        size_t max_write_mb_per_sec, uint64_t& bytes_copied) {
+    struct stat from_stat;
+
+    if (stat(from_path.c_str(), &from_stat) < 0 || !S_ISDIR(from_stat.st_mode)) {
+        LOG(WARNING) << "stat " << from_path << " failed";
+        return false;
+    }
+
+    if (!butil::CreateDirectory(butil::FilePath(to_path))) {
+        LOG(WARNING) << "CreateDirectory " << to_path << " failed";
+        return false;
+    }
+
+    const auto copy_start = std::chrono::steady_clock::now();
+    uint64_t throttled_bytes = 0;
+    std::vector<char> buf(4 * 1024 * 1024);
+
+    butil::FileEnumerator dir_enum(butil::FilePath(from_path), true, butil::FileEnumerator::FILES);
+    for (butil::FilePath name = dir_enum.Next(); !name.empty(); name = dir_enum.Next()) {
+        const std::string& src_file = name.value();
+        const std::string dst_file = to_path + src_file.substr(from_path.size());
+
+        if (!butil::CreateDirectory(butil::FilePath(dst_file).DirName())) {
+            LOG(WARNING) << "CreateDirectory " << butil::FilePath(dst_file).DirName().value() << " failed";
+            return false;
+        }
+
+        std::ifstream src(src_file, std::ios::binary);
+        std::ofstream dst(dst_file, std::ios::binary | std::ios::trunc);
+
+        if (!src.is_open() || !dst.is_open()) {
+            LOG(WARNING) << "copy " << src_file << " to " << dst_file << " failed";
+            return false;
+        }
+
+        while (src) {
+            src.read(buf.data(), buf.size());
+            const std::streamsize chunk_len = src.gcount();
+            if (chunk_len <= 0) {
+                break;
+            }
+
+            dst.write(buf.data(), chunk_len);
+            bytes_copied += chunk_len;
+            throttled_bytes += chunk_len;
+
+            if (max_write_mb_per_sec != 0) {
+                // sleep off the gap between actual elapsed time and the time
+                // this many bytes should have taken at the configured rate
+                const auto elapsed = std::chrono::steady_clock::now() - copy_start;
+                const auto budgeted = std::chrono::milliseconds(
+                    (throttled_bytes * 1000) / (max_write_mb_per_sec * 1024 * 1024));
+                if (budgeted > elapsed) {
+                    std::this_thread::sleep_for(budgeted - elapsed);
+                }
+            }
+        }
+
+        if (!dst.good()) {
+            LOG(WARNING) << "copy " << src_file << " to " << dst_file << " failed";
+            return false;
+        }
+    }
+
+    return true;
+}
+
 bool mv_dir(const std::string& from_path, const std::string& to_path) {
     struct stat from_stat;
 
@@ -1,11 +1,28 @@
 #include "http_client.h"
 #include "file_utils.h"
 #include "logger.h"
+#include <algorithm>
 #include <vector>
 #include <json.hpp>
+#include <app_metrics.h>
 
 std::string HttpClient::api_key = "";
 std::string HttpClient::ca_cert_path = "";
+CURLSH* HttpClient::curl_share = nullptr;
+std::mutex HttpClient::curl_share_mutexes[CURL_LOCK_DATA_LAST];
+CURLM* HttpClient::curl_multi = nullptr;
+std::thread HttpClient::multi_loop_thread;
+std::mutex HttpClient::multi_mutex;
+std::vector<HttpClient::async_transfer_t*> HttpClient::pending_transfers;
+std::atomic<bool> HttpClient::multi_quit = false;
+
+void HttpClient::curl_share_lock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr) {
+    curl_share_mutexes[data].lock();
+}
+
+void HttpClient::curl_share_unlock(CURL* handle, curl_lock_data data, void* userptr) {
+    curl_share_mutexes[data].unlock();
+}
 
 long HttpClient::post_response(const std::string &url, const std::string &body, std::string &response,
                                std::map<std::string, std::string>& res_headers, long timeout_ms) {
@@ -18,6 +35,19 @@ long HttpClient::post_response(const std::string &url, const std::string &body,
     return perform_curl(curl, res_headers);
 }
 
+long HttpClient::post_response_remote(const std::string &url, const std::string &body,
+                                      const std::string &remote_api_key, long timeout_ms,
+                                      std::string &response, std::map<std::string, std::string>& res_headers) {
+    CURL *curl = init_curl(url, response);
+    if(curl == nullptr) {
+        return 500;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeout_ms);
+    return perform_curl(curl, res_headers, remote_api_key);
+}
+
 long HttpClient::post_response_async(const std::string &url, const std::shared_ptr<http_req> request,
                                      const std::shared_ptr<http_res> response, HttpServer* server) {
     deferred_req_res_t* req_res = new deferred_req_res_t(request, response, server, false);
@@ -86,6 +116,17 @@ long HttpClient::get_response(const std::string &url, std::string &response,
 void HttpClient::init(const std::string &api_key) {
     HttpClient::api_key = api_key;
 
+    // connections (and TLS sessions) are shared across the easy handles built
+    // per call, so repeat calls to the same peer reuse a kept-alive connection
+    // instead of paying connection setup + TLS handshake every time
+    curl_share = curl_share_init();
+    curl_share_setopt(curl_share, CURLSHOPT_LOCKFUNC, HttpClient::curl_share_lock);
+    curl_share_setopt(curl_share, CURLSHOPT_UNLOCKFUNC, HttpClient::curl_share_unlock);
+    curl_share_setopt(curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+    curl_share_setopt(curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+
     // try to locate ca cert file (from: https://serverfault.com/a/722646/117601)
     std::vector<std::string> locations = {
         "/etc/ssl/certs/ca-certificates.crt",                // Debian/Ubuntu/Gentoo etc.
@@ -105,11 +146,193 @@ void HttpClient::init(const std::string &api_key) {
             break;
         }
     }
+
+    if(curl_multi == nullptr) {
+        curl_multi = curl_multi_init();
+        multi_quit = false;
+        multi_loop_thread = std::thread(HttpClient::run_multi_loop);
+    }
 }
 
-long HttpClient::perform_curl(CURL *curl, std::map<std::string, std::string>& res_headers) {
-    struct curl_slist *chunk = nullptr;
+std::future<async_transfer_res_t> HttpClient::request_async(const std::string& http_method, const std::string& url,
+                                                            const std::string& body, long timeout_ms,
+                                                            std::function<void(async_transfer_res_t&)> done) {
+    async_transfer_t* transfer = new async_transfer_t();
+    std::future<async_transfer_res_t> res_future = transfer->promise.get_future();
+    transfer->request_body = body;
+    transfer->done = std::move(done);
+
+    CURL* curl = init_curl(url, transfer->result.body);
+    if(curl == nullptr) {
+        transfer->result.status_code = 500;
+        if(transfer->done) {
+            transfer->done(transfer->result);
+        }
+        transfer->promise.set_value(std::move(transfer->result));
+        delete transfer;
+        return res_future;
+    }
+
+    transfer->curl = curl;
+
+    if(timeout_ms > 0) {
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeout_ms);
+    }
+
+    if(http_method == "POST") {
+        curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    } else if(http_method != "GET") {
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, http_method.c_str());
+    }
+
+    if(http_method == "POST" || http_method == "PUT" || http_method == "PATCH") {
+        // the body lives in the transfer context, so it stays valid for the
+        // whole lifetime of the handle on the event loop
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long) transfer->request_body.size());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, transfer->request_body.c_str());
+    }
+
     std::string api_key_header = std::string("x-typesense-api-key: ") + HttpClient::api_key;
+    transfer->headers_list = curl_slist_append(nullptr, api_key_header.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->headers_list);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer);
+
+    {
+        std::unique_lock<std::mutex> lock(multi_mutex);
+
+        if(curl_multi == nullptr || multi_quit) {
+            // event loop not running (early start-up, tests or shutdown):
+            // fall back to performing the transfer inline
+            lock.unlock();
+            CURLcode code = curl_easy_perform(curl);
+            finish_transfer(transfer, code);
+            return res_future;
+        }
+
+        pending_transfers.push_back(transfer);
+    }
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+    curl_multi_wakeup(curl_multi);
+#endif
+
+    return res_future;
+}
+
+void HttpClient::run_multi_loop() {
+    // transfers owned by the multi handle; touched only by this thread
+    std::vector<async_transfer_t*> active_transfers;
+
+    while(!multi_quit) {
+        {
+            std::unique_lock<std::mutex> lock(multi_mutex);
+            for(async_transfer_t* transfer: pending_transfers) {
+                curl_multi_add_handle(curl_multi, transfer->curl);
+                active_transfers.push_back(transfer);
+            }
+            pending_transfers.clear();
+        }
+
+        int running_handles = 0;
+        curl_multi_perform(curl_multi, &running_handles);
+
+        CURLMsg* msg;
+        int msgs_left = 0;
+        while((msg = curl_multi_info_read(curl_multi, &msgs_left)) != nullptr) {
+            if(msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+
+            async_transfer_t* transfer = nullptr;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &transfer);
+            curl_multi_remove_handle(curl_multi, msg->easy_handle);
+            active_transfers.erase(std::remove(active_transfers.begin(), active_transfers.end(), transfer),
+                                   active_transfers.end());
+            finish_transfer(transfer, msg->data.result);
+        }
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+        // sleeps until network activity or a wakeup from request_async
+        curl_multi_poll(curl_multi, nullptr, 0, 1000, nullptr);
+#else
+        int numfds = 0;
+        curl_multi_wait(curl_multi, nullptr, 0, 100, &numfds);
+        if(numfds == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+#endif
+    }
+
+    // shutting down: fail whatever is in flight so that waiting futures unblock
+    for(async_transfer_t* transfer: active_transfers) {
+        curl_multi_remove_handle(curl_multi, transfer->curl);
+        finish_transfer(transfer, CURLE_ABORTED_BY_CALLBACK);
+    }
+
+    std::unique_lock<std::mutex> lock(multi_mutex);
+    for(async_transfer_t* transfer: pending_transfers) {
+        finish_transfer(transfer, CURLE_ABORTED_BY_CALLBACK);
+    }
+    pending_transfers.clear();
+}
+
+void HttpClient::finish_transfer(async_transfer_t* transfer, CURLcode code) {
+    if(code != CURLE_OK) {
+        char* url = nullptr;
+        curl_easy_getinfo(transfer->curl, CURLINFO_EFFECTIVE_URL, &url);
+        LOG(ERROR) << "CURL failed. URL: " << url << ", Code: " << code << ", strerror: " << curl_easy_strerror(code);
+        transfer->result.status_code = 500;
+    } else {
+        long http_code = 500;
+        curl_easy_getinfo(transfer->curl, CURLINFO_RESPONSE_CODE, &http_code);
+        transfer->result.status_code = (http_code == 0) ? 500 : http_code;
+
+        // pool metrics: zero new connects means the call rode a pooled connection
+        long num_connects = 0;
+        if(curl_easy_getinfo(transfer->curl, CURLINFO_NUM_CONNECTS, &num_connects) == CURLE_OK) {
+            const std::string& conn_label = (num_connects == 0) ? AppMetrics::PEER_CONN_REUSE_LABEL :
+                                                                  AppMetrics::PEER_CONN_NEW_LABEL;
+            AppMetrics::get_instance().increment_count(conn_label, 1);
+        }
+
+        extract_response_headers(transfer->curl, transfer->result.headers);
+    }
+
+    curl_easy_cleanup(transfer->curl);
+    curl_slist_free_all(transfer->headers_list);
+
+    if(transfer->done) {
+        transfer->done(transfer->result);
+    }
+
+    transfer->promise.set_value(std::move(transfer->result));
+    delete transfer;
+}
+
+void HttpClient::stop_async_loop() {
+    if(curl_multi == nullptr) {
+        return;
+    }
+
+    multi_quit = true;
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+    curl_multi_wakeup(curl_multi);
+#endif
+
+    if(multi_loop_thread.joinable()) {
+        multi_loop_thread.join();
+    }
+
+    curl_multi_cleanup(curl_multi);
+    curl_multi = nullptr;
+}
+
+long HttpClient::perform_curl(CURL *curl, std::map<std::string, std::string>& res_headers,
+                              const std::string& api_key_override) {
+    struct curl_slist *chunk = nullptr;
+    const std::string& auth_api_key = api_key_override.empty() ? HttpClient::api_key : api_key_override;
+    std::string api_key_header = std::string("x-typesense-api-key: ") + auth_api_key;
     chunk = curl_slist_append(chunk, api_key_header.c_str());
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, chunk);
     CURLcode res = curl_easy_perform(curl);
@@ -126,6 +349,14 @@ long HttpClient::perform_curl(CURL *curl, std::map<std::string, std::string>& re
     long http_code = 500;
     curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &http_code);
 
+    // pool metrics: zero new connects means the call rode a pooled connection
+    long num_connects = 0;
+    if(curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &num_connects) == CURLE_OK) {
+        const std::string& conn_label = (num_connects == 0) ? AppMetrics::PEER_CONN_REUSE_LABEL :
+                                                              AppMetrics::PEER_CONN_NEW_LABEL;
+        AppMetrics::get_instance().increment_count(conn_label, 1);
+    }
+
     extract_response_headers(curl, res_headers);
 
     curl_easy_cleanup(curl);
@@ -177,7 +408,7 @@ size_t HttpClient::curl_req_send_callback(char* buffer, size_t size, size_t nite
 
         HttpServer *server = req_res->server;
 
-        server->get_message_dispatcher()->send_message(HttpServer::REQUEST_PROCEED_MESSAGE, req_res);
+        server->get_message_dispatcher(req_res->req)->send_message(HttpServer::REQUEST_PROCEED_MESSAGE, req_res);
 
         if(!req_res->req->last_chunk_aggregate) {
             //LOG(INFO) << "Waiting for request body to be ready";
@@ -226,7 +457,7 @@ size_t HttpClient::curl_write_async(char *buffer, size_t size, size_t nmemb, voi
     //LOG(INFO) << "curl_write_async response, res body size: " << req_res->res->body.size();
 
     async_req_res_t* async_req_res = new async_req_res_t(req_res->req, req_res->res, true);
-    req_res->server->get_message_dispatcher()->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
+    req_res->server->get_message_dispatcher(req_res->req)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
 
     // wait until response is sent
     //LOG(INFO) << "Waiting on req_res " << req_res->res;
@@ -249,7 +480,7 @@ size_t HttpClient::curl_write_async_done(void *context, curl_socket_t item) {
     req_res->res->final = true;
 
     async_req_res_t* async_req_res = new async_req_res_t(req_res->req, req_res->res, true);
-    req_res->server->get_message_dispatcher()->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
+    req_res->server->get_message_dispatcher(req_res->req)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
 
     // wait until final response is flushed or response object will be destroyed by caller
     req_res->res->wait();
@@ -329,6 +560,12 @@ CURL *HttpClient::init_curl(const std::string& url, std::string& response) {
     curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, 4000);
     curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE);
 
+    // reuse pooled peer connections and keep them alive between write bursts
+    if(curl_share != nullptr) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, curl_share);
+    }
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+
     // to allow self-signed certs
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
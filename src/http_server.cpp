@@ -13,8 +13,10 @@
 
 HttpServer::HttpServer(const std::string & version, const std::string & listen_address,
                        uint32_t listen_port, const std::string & ssl_cert_path, const std::string & ssl_cert_key_path,
-                       const uint64_t ssl_refresh_interval_ms, bool cors_enabled, ThreadPool* thread_pool):
+                       const uint64_t ssl_refresh_interval_ms, bool cors_enabled, size_t num_http_loops,
+                       ThreadPool* thread_pool):
                        SSL_REFRESH_INTERVAL_MS(ssl_refresh_interval_ms),
+                       num_http_loops(std::max<size_t>(1, num_http_loops)),
                        exit_loop(false), version(version), listen_address(listen_address), listen_port(listen_port),
                        ssl_cert_path(ssl_cert_path), ssl_cert_key_path(ssl_cert_key_path),
                        cors_enabled(cors_enabled), thread_pool(thread_pool) {
@@ -40,7 +42,8 @@ HttpServer::HttpServer(const std::string & version, const std::string & listen_a
 }
 
 void HttpServer::on_accept(h2o_socket_t *listener, const char *err) {
-    HttpServer* http_server = reinterpret_cast<HttpServer*>(listener->data);
+    // each listener belongs to a single event loop, whose accept context it carries
+    h2o_accept_ctx_t* accept_ctx = reinterpret_cast<h2o_accept_ctx_t*>(listener->data);
     h2o_socket_t *sock;
 
     if (err != NULL) {
@@ -51,7 +54,7 @@ void HttpServer::on_accept(h2o_socket_t *listener, const char *err) {
         return;
     }
 
-    h2o_accept(http_server->accept_ctx, sock);
+    h2o_accept(accept_ctx, sock);
 }
 
 void HttpServer::on_metrics_refresh_timeout(h2o_timer_t *entry) {
@@ -80,6 +83,13 @@ void HttpServer::on_ssl_refresh_timeout(h2o_timer_t *entry) {
     bool refresh_success = initialize_ssl_ctx(hs->ssl_cert_path.c_str(), hs->ssl_cert_key_path.c_str(), hs->accept_ctx);
 
     if (refresh_success) {
+        // worker loops read their accept context on their own threads, so each
+        // swaps in the new SSL context via a message processed on its own loop
+        for(http_worker_t* worker: hs->http_workers) {
+            auto refresh = new ssl_ctx_refresh_t{&worker->accept_ctx, hs->accept_ctx->ssl_ctx};
+            worker->message_dispatcher->send_message(SSL_CTX_REFRESH_MESSAGE, refresh);
+        }
+
         // delete the old SSL context but after some time, to allow existing connections to drain
         h2o_custom_timer_t* ssl_ctx_delete_timer = new h2o_custom_timer_t(old_ssl_ctx);
         h2o_timer_init(&ssl_ctx_delete_timer->timer, on_ssl_ctx_delete_timeout);
@@ -93,6 +103,13 @@ void HttpServer::on_ssl_refresh_timeout(h2o_timer_t *entry) {
     h2o_timer_link(hs->ctx.loop, hs->SSL_REFRESH_INTERVAL_MS, &hs->ssl_refresh_timer.timer);
 }
 
+bool HttpServer::on_ssl_ctx_refresh_message(void *data) {
+    ssl_ctx_refresh_t* refresh = static_cast<ssl_ctx_refresh_t*>(data);
+    refresh->accept_ctx->ssl_ctx = refresh->ssl_ctx;
+    delete refresh;
+    return true;
+}
+
 void HttpServer::on_ssl_ctx_delete_timeout(h2o_timer_t *entry) {
     LOG(INFO) << "Deleting old SSL context.";
 
@@ -117,10 +134,27 @@ int HttpServer::setup_ssl(const char *cert_file, const char *key_file) {
     return 0;
 }
 
-int HttpServer::create_listener() {
+int HttpServer::bind_listener_fd(bool reuse_port) {
     struct sockaddr_in addr;
-    int fd, reuseaddr_flag = 1;
+    int fd, sockopt_flag = 1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(listen_port);
+    inet_pton(AF_INET, listen_address.c_str(), &(addr.sin_addr));
 
+    if ((fd = socket(AF_INET, SOCK_STREAM, 0)) == -1 ||
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &sockopt_flag, sizeof(sockopt_flag)) != 0 ||
+        (reuse_port && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &sockopt_flag, sizeof(sockopt_flag)) != 0) ||
+        bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(fd, SOMAXCONN) != 0) {
+        return -1;
+    }
+
+    return fd;
+}
+
+int HttpServer::create_listener() {
     if(!ssl_cert_path.empty() && !ssl_cert_key_path.empty()) {
         int ssl_setup_code = setup_ssl(ssl_cert_path.c_str(), ssl_cert_key_path.c_str());
         if(ssl_setup_code != 0) {
@@ -139,25 +173,58 @@ int HttpServer::create_listener() {
     accept_ctx->ctx = &ctx;
     accept_ctx->hosts = config.hosts;
 
-    memset(&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(listen_port);
-    inet_pton(AF_INET, listen_address.c_str(), &(addr.sin_addr));
-
-    if ((fd = socket(AF_INET, SOCK_STREAM, 0)) == -1 ||
-        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuseaddr_flag, sizeof(reuseaddr_flag)) != 0 ||
-        bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
-        listen(fd, SOMAXCONN) != 0) {
+    // with additional loops, every listener (including this one) binds its own
+    // SO_REUSEPORT socket so that the kernel spreads accepted connections across them
+    int fd = bind_listener_fd(num_http_loops > 1);
+    if(fd == -1) {
         return -1;
     }
 
     listener_socket = h2o_evloop_socket_create(ctx.loop, fd, H2O_SOCKET_FLAG_DONT_READ);
-    listener_socket->data = this;
+    listener_socket->data = accept_ctx;
     h2o_socket_read_start(listener_socket, on_accept);
 
     return 0;
 }
 
+int HttpServer::start_http_workers() {
+    for(size_t i = 1; i < num_http_loops; i++) {
+        http_worker_t* worker = new http_worker_t();
+        h2o_context_init(&worker->ctx, h2o_evloop_create(), &config);
+
+        worker->accept_ctx.ctx = &worker->ctx;
+        worker->accept_ctx.hosts = config.hosts;
+        worker->accept_ctx.ssl_ctx = accept_ctx->ssl_ctx;
+
+        worker->message_dispatcher = new http_message_dispatcher;
+        worker->message_dispatcher->init(worker->ctx.loop);
+
+        // message handlers registered before run() must work on every loop
+        worker->message_dispatcher->message_handlers = message_dispatcher->message_handlers;
+
+        int fd = bind_listener_fd(true);
+        if(fd == -1) {
+            return -1;
+        }
+
+        worker->listener_socket = h2o_evloop_socket_create(worker->ctx.loop, fd, H2O_SOCKET_FLAG_DONT_READ);
+        worker->listener_socket->data = &worker->accept_ctx;
+        h2o_socket_read_start(worker->listener_socket, on_accept);
+
+        http_workers.push_back(worker);
+    }
+
+    for(http_worker_t* worker: http_workers) {
+        worker->thread = std::thread([this, worker]() {
+            while(!exit_loop) {
+                h2o_evloop_run(worker->ctx.loop, INT32_MAX);
+            }
+        });
+    }
+
+    return 0;
+}
+
 int HttpServer::run(ReplicationState* replication_state) {
     this->replication_state = replication_state;
 
@@ -173,11 +240,27 @@ int HttpServer::run(ReplicationState* replication_state) {
     }
 
     message_dispatcher->on(STOP_SERVER_MESSAGE, HttpServer::on_stop_server);
+    message_dispatcher->on(SSL_CTX_REFRESH_MESSAGE, HttpServer::on_ssl_ctx_refresh_message);
+
+    if(num_http_loops > 1) {
+        if(start_http_workers() != 0) {
+            LOG(ERROR) << "Failed to start additional HTTP event loops - " << strerror(errno);
+            return 1;
+        }
+
+        LOG(INFO) << "Accepting HTTP connections with " << num_http_loops << " event loops.";
+    }
 
     while(!exit_loop) {
         h2o_evloop_run(ctx.loop, INT32_MAX);
     }
 
+    for(http_worker_t* worker: http_workers) {
+        if(worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+
     return 0;
 }
 
@@ -202,11 +285,22 @@ void HttpServer::stop() {
         h2o_socket_close(listener_socket);
     }
 
-    // this will break the event loop
+    for(http_worker_t* worker: http_workers) {
+        if(worker->listener_socket != nullptr) {
+            h2o_socket_read_stop(worker->listener_socket);
+            h2o_socket_close(worker->listener_socket);
+        }
+    }
+
+    // this will break the event loops
     exit_loop = true;
 
-    // send a message to activate the idle event loop to exit, just in case
+    // send a message to activate the idle event loops to exit, just in case
     message_dispatcher->send_message(STOP_SERVER_MESSAGE, nullptr);
+
+    for(http_worker_t* worker: http_workers) {
+        worker->message_dispatcher->send_message(STOP_SERVER_MESSAGE, nullptr);
+    }
 }
 
 h2o_pathconf_t* HttpServer::register_handler(h2o_hostconf_t *hostconf, const char *path,
@@ -220,8 +314,10 @@ h2o_pathconf_t* HttpServer::register_handler(h2o_hostconf_t *hostconf, const cha
     // Enable streaming request body
     handler->super.supports_request_streaming = 1;
 
-    compress_args.min_size = 256;       // don't gzip less than this size
-    compress_args.brotli.quality = -1;  // disable, not widely supported
+    // large JSON responses (search hits, exports) compress 5-10x, so they are
+    // compressed natively instead of requiring a proxy hop in front
+    compress_args.min_size = 1024;      // below this, headers + CPU outweigh the savings
+    compress_args.brotli.quality = 4;   // negotiated when the client prefers `br`
     compress_args.gzip.quality = 1;     // fastest
     h2o_compress_register(pathconf, &compress_args);
 
@@ -347,9 +443,8 @@ int HttpServer::catch_all_handler(h2o_handler_t *_h2o_handler, h2o_req_t *req) {
         return send_response(req, 400, resp.dump());
     }
 
-    std::string query_str(query.base, query.len);
     std::map<std::string, std::string> query_map;
-    StringUtils::parse_query_string(query_str, query_map);
+    StringUtils::parse_query_string(std::string_view(query.base, query.len), query_map);
 
     // cache ttl can be applied only from an embedded key: cannot be a get param
     query_map.erase("cache_ttl");
@@ -396,6 +491,18 @@ int HttpServer::catch_all_handler(h2o_handler_t *_h2o_handler, h2o_req_t *req) {
         else if(write_op && !h2o_handler->http_server->get_replication_state()->is_write_caught_up()) {
             return send_response(req, 503, message);
         }
+
+        else if(write_op && h2o_handler->http_server->get_replication_state()->is_write_backpressured()) {
+            // write queue crossed its high watermark: turn writes away with a retry hint
+            // until it drains below the low watermark
+            size_t retry_after_secs = h2o_handler->http_server->get_replication_state()->get_write_retry_after_secs();
+            h2o_iovec_t retry_after_val = h2o_strdup(&req->pool, std::to_string(retry_after_secs).c_str(), SIZE_MAX);
+            h2o_add_header_by_str(&req->pool, &req->res.headers, H2O_STRLIT("retry-after"),
+                                  0, NULL, retry_after_val.base, retry_after_val.len);
+
+            std::string backpressure_message = "{ \"message\": \"Too many pending writes, try again later.\"}";
+            return send_response(req, 429, backpressure_message);
+        }
     }
 
     // iterate and extract path params
@@ -422,6 +529,9 @@ int HttpServer::catch_all_handler(h2o_handler_t *_h2o_handler, h2o_req_t *req) {
     std::shared_ptr<http_req> request = std::make_shared<http_req>(req, rpath->http_method, path_without_query,
                                                                    route_hash, query_map, body);
 
+    // response messages must come back to the event loop that owns this connection
+    request->message_dispatcher = h2o_handler->http_server->dispatcher_for_context(req->conn->ctx);
+
     // add custom generator with a dispose function for cleaning up resources
     h2o_custom_generator_t* custom_gen = new h2o_custom_generator_t;
     std::shared_ptr<http_res> response = std::make_shared<http_res>(custom_gen);
@@ -610,7 +720,7 @@ int HttpServer::process_request(const std::shared_ptr<http_req>& request, const
     }
 
     auto http_server = handler->http_server;
-    auto message_dispatcher = handler->http_server->get_message_dispatcher();
+    auto message_dispatcher = handler->http_server->get_message_dispatcher(request);
 
     // LOG(INFO) << "Before enqueue res: " << response
     handler->http_server->get_thread_pool()->enqueue([rpath, message_dispatcher, request, response]() {
@@ -673,7 +783,9 @@ void HttpServer::defer_processing(const std::shared_ptr<http_req>& req, const st
         h2o_timer_unlink(&req->defer_timer.timer);
     }
 
-    h2o_timer_link(ctx.loop, timeout_ms, &req->defer_timer.timer);
+    // the timer must fire on the loop that owns the request's socket
+    h2o_loop_t* loop = (req->message_dispatcher != nullptr) ? req->message_dispatcher->loop : ctx.loop;
+    h2o_timer_link(loop, timeout_ms, &req->defer_timer.timer);
 
     if(exit_loop) {
         // otherwise, replication thread could be stuck waiting on a future
@@ -826,6 +938,13 @@ void HttpServer::on(const std::string & message, bool (*handler)(void*)) {
 }
 
 HttpServer::~HttpServer() {
+    for(http_worker_t* worker: http_workers) {
+        delete worker->message_dispatcher;
+        h2o_timerwheel_run(worker->ctx.loop->_timeouts, 9999999999999);
+        h2o_context_dispose(&worker->ctx);
+        delete worker;
+    }
+
     delete message_dispatcher;
 
     if(ssl_refresh_timer.timer.expire_at != 0) {
@@ -860,6 +979,20 @@ http_message_dispatcher* HttpServer::get_message_dispatcher() const {
     return message_dispatcher;
 }
 
+http_message_dispatcher* HttpServer::get_message_dispatcher(const std::shared_ptr<http_req>& req) const {
+    return (req != nullptr && req->message_dispatcher != nullptr) ? req->message_dispatcher : message_dispatcher;
+}
+
+http_message_dispatcher* HttpServer::dispatcher_for_context(h2o_context_t* context) const {
+    for(http_worker_t* worker: http_workers) {
+        if(&worker->ctx == context) {
+            return worker->message_dispatcher;
+        }
+    }
+
+    return message_dispatcher;
+}
+
 ReplicationState* HttpServer::get_replication_state() const {
     return replication_state;
 }
@@ -1014,6 +1147,30 @@ int64_t HttpServer::get_num_queued_writes() {
     return replication_state->get_num_queued_writes();
 }
 
+int64_t HttpServer::get_applied_lag() {
+    return replication_state->get_applied_lag();
+}
+
+int64_t HttpServer::get_read_staleness_ms() {
+    return replication_state->get_read_staleness_ms();
+}
+
+int64_t HttpServer::get_last_snapshot_duration_ms() {
+    return replication_state->get_last_snapshot_duration_ms();
+}
+
+int64_t HttpServer::get_last_snapshot_bytes_written() {
+    return replication_state->get_last_snapshot_bytes_written();
+}
+
+bool HttpServer::is_write_backpressured() {
+    return replication_state->is_write_backpressured();
+}
+
+int64_t HttpServer::get_write_drain_rate() {
+    return replication_state->get_write_drain_rate();
+}
+
 bool HttpServer::is_leader() const {
     return replication_state->is_leader();
 }
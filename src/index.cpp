@@ -2,6 +2,7 @@
 
 #include <numeric>
 #include <chrono>
+#include <queue>
 #include <set>
 #include <unordered_map>
 #include <array_utils.h>
@@ -17,9 +18,12 @@
 #include <s2/s2loop.h>
 #include <s2/s2builder.h>
 #include <posting.h>
+#include <parasort.h>
 #include <thread_local_vars.h>
 #include <unordered_set>
+#include "index_snapshot.h"
 #include "logger.h"
+#include "app_metrics.h"
 
 #define RETURN_CIRCUIT_BREAKER if(std::chrono::duration_cast<std::chrono::milliseconds>(\
                                 std::chrono::high_resolution_clock::now() - search_begin).count() > search_stop_ms) { \
@@ -33,15 +37,17 @@
                                     break;\
                                 }
 
-spp::sparse_hash_map<uint32_t, int64_t> Index::text_match_sentinel_value;
-spp::sparse_hash_map<uint32_t, int64_t> Index::seq_id_sentinel_value;
-spp::sparse_hash_map<uint32_t, int64_t> Index::geo_sentinel_value;
+doc_values_t Index::text_match_sentinel_value;
+doc_values_t Index::seq_id_sentinel_value;
+doc_values_t Index::geo_sentinel_value;
 
 Index::Index(const std::string& name, const uint32_t collection_id, const Store* store, ThreadPool* thread_pool,
+             ThreadPool* indexing_thread_pool,
              const std::unordered_map<std::string, field> & search_schema,
              const std::map<std::string, field>& facet_schema, const std::unordered_map<std::string, field>& sort_schema,
              const std::vector<char>& symbols_to_index, const std::vector<char>& token_separators):
         name(name), collection_id(collection_id), store(store), thread_pool(thread_pool),
+        indexing_thread_pool(indexing_thread_pool),
         search_schema(search_schema), facet_schema(facet_schema), sort_schema(sort_schema),
         symbols_to_index(symbols_to_index), token_separators(token_separators) {
 
@@ -49,11 +55,11 @@ Index::Index(const std::string& name, const uint32_t collection_id, const Store*
         if(fname_field.second.is_string()) {
             if(fname_field.second.index) {
                 art_tree *t = new art_tree;
-                art_tree_init(t);
+                art_tree_init_interned(t, &token_interner);
                 search_index.emplace(fname_field.first, t);
             }
         } else if(fname_field.second.is_geopoint()) {
-            auto field_geo_index = new spp::sparse_hash_map<std::string, std::vector<uint32_t>>();
+            auto field_geo_index = new geo_index_t();
             geopoint_index.emplace(fname_field.first, field_geo_index);
 
             if(!fname_field.second.is_single_geopoint()) {
@@ -61,32 +67,42 @@ Index::Index(const std::string& name, const uint32_t collection_id, const Store*
                 geo_array_index.emplace(fname_field.first, doc_to_geos);
             }
         } else {
-            num_tree_t* num_tree = new num_tree_t;
-            numerical_index.emplace(fname_field.first, num_tree);
+            if(fname_field.second.is_bool()) {
+                bool_index_t* bitmaps = new bool_index_t;
+                bool_index.emplace(fname_field.first, bitmaps);
+            } else {
+                num_tree_t* num_tree = new num_tree_t;
+                numerical_index.emplace(fname_field.first, num_tree);
+            }
+
+            if(fname_field.second.materialize) {
+                auto value_to_ids = new spp::sparse_hash_map<int64_t, std::vector<uint32_t>>();
+                materialized_filter_index.emplace(fname_field.first, value_to_ids);
+            }
         }
 
         // initialize for non-string facet fields
         if(fname_field.second.facet && !fname_field.second.is_string()) {
             art_tree *ft = new art_tree;
-            art_tree_init(ft);
+            art_tree_init_interned(ft, &token_interner);
             search_index.emplace(fname_field.second.faceted_name(), ft);
         }
     }
 
     for(const auto & pair: sort_schema) {
         if(pair.second.type != field_types::GEOPOINT_ARRAY) {
-            spp::sparse_hash_map<uint32_t, int64_t> * doc_to_score = new spp::sparse_hash_map<uint32_t, int64_t>();
+            doc_values_t* doc_to_score = new doc_values_t();
             sort_index.emplace(pair.first, doc_to_score);
         }
     }
 
     for(const auto& pair: facet_schema) {
-        array_mapped_facet_t facet_array;
-        for(size_t i = 0; i < ARRAY_FACET_DIM; i++) {
-            facet_array[i] = new facet_map_t();
-        }
+        facet_index_v3.emplace(pair.first, new facet_column_t());
+        facet_value_store.emplace(pair.first, new facet_value_store_t());
 
-        facet_index_v3.emplace(pair.first, facet_array);
+        if(!pair.second.is_geopoint()) {
+            facet_value_index.emplace(pair.first, new facet_value_index_t(&token_interner));
+        }
     }
 
     num_documents = 0;
@@ -128,6 +144,20 @@ Index::~Index() {
 
     numerical_index.clear();
 
+    for(auto & name_index: bool_index) {
+        delete name_index.second;
+        name_index.second = nullptr;
+    }
+
+    bool_index.clear();
+
+    for(auto & name_map: materialized_filter_index) {
+        delete name_map.second;
+        name_map.second = nullptr;
+    }
+
+    materialized_filter_index.clear();
+
     for(auto & name_map: sort_index) {
         delete name_map.second;
         name_map.second = nullptr;
@@ -135,14 +165,33 @@ Index::~Index() {
 
     sort_index.clear();
 
-    for(auto& field_name_facet_map_array: facet_index_v3) {
-        for(auto& facet_map: field_name_facet_map_array.second) {
-            delete facet_map;
-            facet_map = nullptr;
-        }
+    for(auto& field_name_facet_column: facet_index_v3) {
+        delete field_name_facet_column.second;
+        field_name_facet_column.second = nullptr;
     }
 
     facet_index_v3.clear();
+
+    for(auto& field_name_fvindex: facet_value_index) {
+        delete field_name_fvindex.second;
+        field_name_fvindex.second = nullptr;
+    }
+
+    facet_value_index.clear();
+
+    for(auto& field_name_fvstore: facet_value_store) {
+        delete field_name_fvstore.second;
+        field_name_fvstore.second = nullptr;
+    }
+
+    facet_value_store.clear();
+
+    for(auto& kv: filter_cache) {
+        delete kv.second;
+    }
+
+    filter_cache.clear();
+    filter_cache_lru.clear();
 }
 
 int64_t Index::get_points_from_doc(const nlohmann::json &document, const std::string & default_sorting_field) {
@@ -214,7 +263,9 @@ void Index::compute_token_offsets_facets(index_record& record,
 
                 tokenize_string_array_with_facets(strings, is_facet, field_pair.second,
                                                   local_symbols_to_index, local_token_separators,
-                                                  offset_facet_hashes.offsets, offset_facet_hashes.facet_hashes);
+                                                  offset_facet_hashes.offsets, offset_facet_hashes.facet_hashes,
+                                                  offset_facet_hashes.facet_values,
+                                                  offset_facet_hashes.facet_value_tokens);
             } else {
                 std::string text;
 
@@ -230,7 +281,9 @@ void Index::compute_token_offsets_facets(index_record& record,
 
                 tokenize_string_with_facets(text, is_facet, field_pair.second,
                                             local_symbols_to_index, local_token_separators,
-                                            offset_facet_hashes.offsets, offset_facet_hashes.facet_hashes);
+                                            offset_facet_hashes.offsets, offset_facet_hashes.facet_hashes,
+                                            offset_facet_hashes.facet_values,
+                                            offset_facet_hashes.facet_value_tokens);
             }
         }
 
@@ -239,11 +292,140 @@ void Index::compute_token_offsets_facets(index_record& record,
             if(field_pair.second.type == field_types::STRING) {
                 tokenize_string_with_facets(document[field_name], is_facet, field_pair.second,
                                             local_symbols_to_index, local_token_separators,
-                                            offset_facet_hashes.offsets, offset_facet_hashes.facet_hashes);
+                                            offset_facet_hashes.offsets, offset_facet_hashes.facet_hashes,
+                                            offset_facet_hashes.facet_values,
+                                            offset_facet_hashes.facet_value_tokens);
             } else {
                 tokenize_string_array_with_facets(document[field_name], is_facet, field_pair.second,
                                                   local_symbols_to_index, local_token_separators,
-                                                  offset_facet_hashes.offsets, offset_facet_hashes.facet_hashes);
+                                                  offset_facet_hashes.offsets, offset_facet_hashes.facet_hashes,
+                                                  offset_facet_hashes.facet_values,
+                                                  offset_facet_hashes.facet_value_tokens);
+            }
+        }
+
+        if(!offset_facet_hashes.offsets.empty() || !offset_facet_hashes.facet_hashes.empty()) {
+            record.field_index.emplace(field_name, std::move(offset_facet_hashes));
+        }
+    }
+}
+
+Option<bool> Index::load_precomputed_field_index(index_record& record,
+                                                 const std::unordered_map<std::string, field>& search_schema,
+                                                 const std::map<std::string, field>& facet_schema) {
+
+    const nlohmann::json& artifacts = record.precomputed_index;
+
+    if(!artifacts.is_object()) {
+        return Option<bool>(400, "Key `" + std::string(PRECOMPUTED_FIELD_INDEX_KEY) + "` must be an object mapping "
+                                 "field names to precomputed index artifacts.");
+    }
+
+    for(auto artifact_it = artifacts.begin(); artifact_it != artifacts.end(); ++artifact_it) {
+        const std::string& field_name = artifact_it.key();
+        const auto& search_field_it = search_schema.find(field_name);
+
+        if(search_field_it == search_schema.end() || !search_field_it->second.index) {
+            return Option<bool>(400, "Field `" + field_name + "` under `" + PRECOMPUTED_FIELD_INDEX_KEY + "` "
+                                     "is not an indexed field.");
+        }
+
+        if(record.doc.count(field_name) == 0) {
+            return Option<bool>(400, "Field `" + field_name + "` under `" + PRECOMPUTED_FIELD_INDEX_KEY + "` "
+                                     "is not present in the document.");
+        }
+
+        const nlohmann::json& artifact = artifact_it.value();
+
+        if(!artifact.is_object()) {
+            return Option<bool>(400, "Artifacts for field `" + field_name + "` must be an object.");
+        }
+
+        offsets_facet_hashes_t offset_facet_hashes;
+
+        const auto& offsets_it = artifact.find("offsets");
+        if(offsets_it != artifact.end()) {
+            if(!offsets_it->is_object()) {
+                return Option<bool>(400, "`offsets` of field `" + field_name + "` must be an object mapping "
+                                         "tokens to offset arrays.");
+            }
+
+            for(auto token_it = offsets_it->begin(); token_it != offsets_it->end(); ++token_it) {
+                if(!token_it.value().is_array() || token_it.value().empty()) {
+                    return Option<bool>(400, "Offsets of token `" + token_it.key() + "` in field `" + field_name + "` "
+                                             "must be a non-empty array of unsigned integers.");
+                }
+
+                std::vector<uint32_t> token_offsets;
+                token_offsets.reserve(token_it.value().size());
+
+                for(const auto& offset: token_it.value()) {
+                    if(!offset.is_number_unsigned()) {
+                        return Option<bool>(400, "Offsets of token `" + token_it.key() + "` in field "
+                                                 "`" + field_name + "` must be a non-empty array of unsigned integers.");
+                    }
+
+                    token_offsets.push_back(offset.get<uint32_t>());
+                }
+
+                offset_facet_hashes.offsets.emplace(token_it.key(), std::move(token_offsets));
+            }
+        }
+
+        const auto& facet_hashes_it = artifact.find("facet_hashes");
+        if(facet_hashes_it != artifact.end()) {
+            if(facet_schema.count(field_name) == 0) {
+                return Option<bool>(400, "Field `" + field_name + "` carries `facet_hashes` but is not a "
+                                         "faceted field.");
+            }
+
+            const auto& facet_values_it = artifact.find("facet_values");
+            const auto& facet_value_tokens_it = artifact.find("facet_value_tokens");
+
+            if(!facet_hashes_it->is_array() || facet_values_it == artifact.end() || !facet_values_it->is_array() ||
+               facet_value_tokens_it == artifact.end() || !facet_value_tokens_it->is_array() ||
+               facet_values_it->size() != facet_hashes_it->size() ||
+               facet_value_tokens_it->size() != facet_hashes_it->size()) {
+                return Option<bool>(400, "Field `" + field_name + "` must carry `facet_hashes`, `facet_values` and "
+                                         "`facet_value_tokens` as parallel arrays.");
+            }
+
+            for(const auto& facet_hash: *facet_hashes_it) {
+                if(!facet_hash.is_number_unsigned()) {
+                    return Option<bool>(400, "`facet_hashes` of field `" + field_name + "` must contain only "
+                                             "unsigned integers.");
+                }
+
+                offset_facet_hashes.facet_hashes.push_back(facet_hash.get<uint64_t>());
+            }
+
+            for(const auto& facet_value: *facet_values_it) {
+                if(!facet_value.is_string()) {
+                    return Option<bool>(400, "`facet_values` of field `" + field_name + "` must contain only strings.");
+                }
+
+                offset_facet_hashes.facet_values.push_back(facet_value.get<std::string>());
+            }
+
+            for(const auto& value_tokens: *facet_value_tokens_it) {
+                if(!value_tokens.is_array()) {
+                    return Option<bool>(400, "`facet_value_tokens` of field `" + field_name + "` must contain only "
+                                             "arrays of strings.");
+                }
+
+                std::vector<std::string> tokens;
+                tokens.reserve(value_tokens.size());
+
+                for(const auto& token: value_tokens) {
+                    if(!token.is_string()) {
+                        return Option<bool>(400, "`facet_value_tokens` of field `" + field_name + "` must contain only "
+                                                 "arrays of strings.");
+                    }
+
+                    tokens.push_back(token.get<std::string>());
+                }
+
+                offset_facet_hashes.facet_value_tokens.emplace_back(std::move(tokens));
             }
         }
 
@@ -251,6 +433,8 @@ void Index::compute_token_offsets_facets(index_record& record,
             record.field_index.emplace(field_name, std::move(offset_facet_hashes));
         }
     }
+
+    return Option<bool>(true);
 }
 
 Option<uint32_t> Index::validate_index_in_memory(nlohmann::json& document, uint32_t seq_id,
@@ -259,7 +443,14 @@ Option<uint32_t> Index::validate_index_in_memory(nlohmann::json& document, uint3
                                                  const std::map<std::string, field> & facet_schema,
                                                  const index_operation_t op,
                                                  const std::string& fallback_field_type,
-                                                 const DIRTY_VALUES& dirty_values) {
+                                                 const DIRTY_VALUES& dirty_values,
+                                                 bool* doc_modified) {
+
+    const auto mark_modified = [doc_modified]() {
+        if(doc_modified != nullptr) {
+            *doc_modified = true;
+        }
+    };
 
     bool missing_default_sort_field = (!default_sorting_field.empty() && document.count(default_sorting_field) == 0);
 
@@ -289,6 +480,7 @@ Option<uint32_t> Index::validate_index_in_memory(nlohmann::json& document, uint3
             // we will ignore `null` on an option field
             if(op != UPDATE) {
                 // for updates, the erasure is done later since we need to keep the key for overwrite
+                mark_modified();
                 document.erase(field_name);
             }
             continue;
@@ -298,29 +490,34 @@ Option<uint32_t> Index::validate_index_in_memory(nlohmann::json& document, uint3
         bool array_ele_erased = false;
 
         if(a_field.type == field_types::STRING && !document[field_name].is_string()) {
+            mark_modified();
             Option<uint32_t> coerce_op = coerce_string(dirty_values, fallback_field_type, a_field, document, field_name, dummy_iter, false, array_ele_erased);
             if(!coerce_op.ok()) {
                 return coerce_op;
             }
         } else if(a_field.type == field_types::INT32) {
             if(!document[field_name].is_number_integer()) {
+                mark_modified();
                 Option<uint32_t> coerce_op = coerce_int32_t(dirty_values, a_field, document, field_name, dummy_iter, false, array_ele_erased);
                 if(!coerce_op.ok()) {
                     return coerce_op;
                 }
             }
         } else if(a_field.type == field_types::INT64 && !document[field_name].is_number_integer()) {
+            mark_modified();
             Option<uint32_t> coerce_op = coerce_int64_t(dirty_values, a_field, document, field_name, dummy_iter, false, array_ele_erased);
             if(!coerce_op.ok()) {
                 return coerce_op;
             }
         } else if(a_field.type == field_types::FLOAT && !document[field_name].is_number()) {
             // using `is_number` allows integer to be passed to a float field
+            mark_modified();
             Option<uint32_t> coerce_op = coerce_float(dirty_values, a_field, document, field_name, dummy_iter, false, array_ele_erased);
             if(!coerce_op.ok()) {
                 return coerce_op;
             }
         } else if(a_field.type == field_types::BOOL && !document[field_name].is_boolean()) {
+            mark_modified();
             Option<uint32_t> coerce_op = coerce_bool(dirty_values, a_field, document, field_name, dummy_iter, false, array_ele_erased);
             if(!coerce_op.ok()) {
                 return coerce_op;
@@ -332,6 +529,7 @@ Option<uint32_t> Index::validate_index_in_memory(nlohmann::json& document, uint3
 
             if(!(document[field_name][0].is_number() && document[field_name][1].is_number())) {
                 // one or more elements is not an number, try to coerce
+                mark_modified();
                 Option<uint32_t> coerce_op = coerce_geopoint(dirty_values, a_field, document, field_name, dummy_iter, false, array_ele_erased);
                 if(!coerce_op.ok()) {
                     return coerce_op;
@@ -341,6 +539,7 @@ Option<uint32_t> Index::validate_index_in_memory(nlohmann::json& document, uint3
             if(!document[field_name].is_array()) {
                 if(a_field.optional && (dirty_values == DIRTY_VALUES::DROP ||
                                           dirty_values == DIRTY_VALUES::COERCE_OR_DROP)) {
+                    mark_modified();
                     document.erase(field_name);
                     continue;
                 } else {
@@ -354,27 +553,32 @@ Option<uint32_t> Index::validate_index_in_memory(nlohmann::json& document, uint3
                 array_ele_erased = false;
 
                 if (a_field.type == field_types::STRING_ARRAY && !item.is_string()) {
+                    mark_modified();
                     Option<uint32_t> coerce_op = coerce_string(dirty_values, fallback_field_type, a_field, document, field_name, it, true, array_ele_erased);
                     if (!coerce_op.ok()) {
                         return coerce_op;
                     }
                 } else if (a_field.type == field_types::INT32_ARRAY && !item.is_number_integer()) {
+                    mark_modified();
                     Option<uint32_t> coerce_op = coerce_int32_t(dirty_values, a_field, document, field_name, it, true, array_ele_erased);
                     if (!coerce_op.ok()) {
                         return coerce_op;
                     }
                 } else if (a_field.type == field_types::INT64_ARRAY && !item.is_number_integer()) {
+                    mark_modified();
                     Option<uint32_t> coerce_op = coerce_int64_t(dirty_values, a_field, document, field_name, it, true, array_ele_erased);
                     if (!coerce_op.ok()) {
                         return coerce_op;
                     }
                 } else if (a_field.type == field_types::FLOAT_ARRAY && !item.is_number()) {
                     // we check for `is_number` to allow whole numbers to be passed into float fields
+                    mark_modified();
                     Option<uint32_t> coerce_op = coerce_float(dirty_values, a_field, document, field_name, it, true, array_ele_erased);
                     if (!coerce_op.ok()) {
                         return coerce_op;
                     }
                 } else if (a_field.type == field_types::BOOL_ARRAY && !item.is_boolean()) {
+                    mark_modified();
                     Option<uint32_t> coerce_op = coerce_bool(dirty_values, a_field, document, field_name, it, true, array_ele_erased);
                     if (!coerce_op.ok()) {
                         return coerce_op;
@@ -386,6 +590,7 @@ Option<uint32_t> Index::validate_index_in_memory(nlohmann::json& document, uint3
 
                     if(!(item[0].is_number() && item[1].is_number())) {
                         // one or more elements is not an number, try to coerce
+                        mark_modified();
                         Option<uint32_t> coerce_op = coerce_geopoint(dirty_values, a_field, document, field_name, it, true, array_ele_erased);
                         if(!coerce_op.ok()) {
                             return coerce_op;
@@ -428,38 +633,56 @@ void Index::validate_and_preprocess(Index *index, std::vector<index_record>& ite
                 continue;
             }
 
+            bool doc_modified = false;
+
             Option<uint32_t> validation_op = validate_index_in_memory(index_rec.doc, index_rec.seq_id,
                                                                       default_sorting_field,
                                                                       search_schema, facet_schema,
                                                                       index_rec.operation,
                                                                       fallback_field_type,
-                                                                      index_rec.dirty_values);
+                                                                      index_rec.dirty_values,
+                                                                      &doc_modified);
 
             if(!validation_op.ok()) {
                 index_rec.index_failure(validation_op.code(), validation_op.error());
                 continue;
             }
 
+            if(doc_modified) {
+                // the document no longer matches the raw request body, so the
+                // disk write must serialize the DOM
+                index_rec.raw_doc.clear();
+            }
+
             if(index_rec.is_update) {
                 // scrub string fields to reduce delete ops
                 get_doc_changes(index_rec.operation, index_rec.doc, index_rec.old_doc, index_rec.new_doc,
                                 index_rec.del_doc);
                 scrub_reindex_doc(search_schema, index_rec.doc, index_rec.del_doc, index_rec.old_doc);
+                index_rec.numeric_only_update = is_numeric_only_update(search_schema, index_rec);
             }
 
-            compute_token_offsets_facets(index_rec, search_schema, facet_schema, token_separators, symbols_to_index);
+            if(!index_rec.precomputed_index.is_null() && !index_rec.is_update && !doc_modified) {
+                // bulk loads can ship the tokenization artifacts along with the document,
+                // reducing server-side import to validation + memory writes
+                Option<bool> load_op = load_precomputed_field_index(index_rec, search_schema, facet_schema);
+
+                if(!load_op.ok()) {
+                    index_rec.index_failure(load_op.code(), load_op.error());
+                    continue;
+                }
+            } else {
+                // updates and coerced documents fall back to server-side tokenization,
+                // since client artifacts may no longer match the effective document
+                compute_token_offsets_facets(index_rec, search_schema, facet_schema, token_separators, symbols_to_index);
+            }
 
             int64_t points = 0;
 
             if(index_rec.doc.count(default_sorting_field) == 0) {
                 auto default_sorting_field_it = index->sort_index.find(default_sorting_field);
                 if(default_sorting_field_it != index->sort_index.end()) {
-                    auto seq_id_it = default_sorting_field_it->second->find(index_rec.seq_id);
-                    if(seq_id_it != default_sorting_field_it->second->end()) {
-                        points = seq_id_it->second;
-                    } else {
-                        points = INT64_MIN;
-                    }
+                    points = default_sorting_field_it->second->get(index_rec.seq_id, INT64_MIN);
                 } else {
                     points = INT64_MIN;
                 }
@@ -497,31 +720,37 @@ size_t Index::batch_memory_index(Index *index, std::vector<index_record>& iter_b
     size_t num_queued = 0;
     size_t batch_index = 0;
 
-    for(size_t thread_id = 0; thread_id < num_threads && batch_index < iter_batch.size(); thread_id++) {
-        size_t batch_len = window_size;
+    {
+        // validation only reads the index (default scores come from sort_index),
+        // so concurrent searches can proceed during this phase
+        std::shared_lock rlock(index->mutex);
 
-        if(batch_index + window_size > iter_batch.size()) {
-            batch_len = iter_batch.size() - batch_index;
-        }
+        for(size_t thread_id = 0; thread_id < num_threads && batch_index < iter_batch.size(); thread_id++) {
+            size_t batch_len = window_size;
 
-        num_queued++;
+            if(batch_index + window_size > iter_batch.size()) {
+                batch_len = iter_batch.size() - batch_index;
+            }
 
-        index->thread_pool->enqueue([&, batch_index, batch_len]() {
-            validate_and_preprocess(index, iter_batch, batch_index, batch_len, default_sorting_field, search_schema,
-                                    facet_schema, fallback_field_type,
-                                    token_separators, symbols_to_index);
+            num_queued++;
 
-            std::unique_lock<std::mutex> lock(m_process);
-            num_processed++;
-            cv_process.notify_one();
-        });
+            index->indexing_thread_pool->enqueue([&, batch_index, batch_len]() {
+                validate_and_preprocess(index, iter_batch, batch_index, batch_len, default_sorting_field, search_schema,
+                                        facet_schema, fallback_field_type,
+                                        token_separators, symbols_to_index);
 
-        batch_index += batch_len;
-    }
+                std::unique_lock<std::mutex> lock(m_process);
+                num_processed++;
+                cv_process.notify_one();
+            });
 
-    {
-        std::unique_lock<std::mutex> lock_process(m_process);
-        cv_process.wait(lock_process, [&](){ return num_processed == num_queued; });
+            batch_index += batch_len;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock_process(m_process);
+            cv_process.wait(lock_process, [&](){ return num_processed == num_queued; });
+        }
     }
 
     std::unordered_set<std::string> found_fields;
@@ -534,42 +763,82 @@ size_t Index::batch_memory_index(Index *index, std::vector<index_record>& iter_b
             continue;
         }
 
-        if(index_rec.is_update) {
-            index->remove(index_rec.seq_id, index_rec.del_doc, index_rec.is_update);
-        } else if(index_rec.indexed.ok()) {
+        if(!index_rec.is_update && index_rec.indexed.ok()) {
             num_indexed++;
         }
 
+        if(index_rec.numeric_only_update) {
+            // applied via the in-place patch path, needs no per-field task
+            continue;
+        }
+
         for(const auto& kv: index_rec.doc.items()) {
             found_fields.insert(kv.key());
         }
     }
 
+    // the in-memory apply is the only phase that mutates index structures, so
+    // the writer lock is scoped to it and searches are blocked only here
+    std::unique_lock wlock(index->mutex);
+
+    for(size_t i = 0; i < iter_batch.size(); i++) {
+        auto& index_rec = iter_batch[i];
+
+        if(index_rec.indexed.ok() && index_rec.is_update) {
+            if(index_rec.numeric_only_update) {
+                // numeric-only deltas swap the changed values directly instead of remove + reindex
+                index->patch_numerical_fields_in_place(index_rec);
+            } else {
+                index->remove_unlocked(index_rec.seq_id, index_rec.del_doc, index_rec.is_update,
+                                       &index_rec.field_index);
+            }
+        }
+    }
+
     num_queued = num_processed = 0;
 
+    std::vector<const std::string*> index_field_names;
+
     for(const auto& field_name: found_fields) {
         //LOG(INFO) << "field name: " << field_name;
         if(field_name != "id" && search_schema.count(field_name) == 0) {
             continue;
         }
 
+        index_field_names.push_back(&field_name);
+    }
+
+    auto index_single_field = [&](const std::string& field_name) {
+        const field& f = (field_name == "id") ?
+                         field("id", field_types::STRING, false) : search_schema.at(field_name);
+        index->index_field_in_memory(f, iter_batch);
+    };
+
+    // fields write to disjoint structures, so they are indexed concurrently;
+    // the last field runs inline since this thread would otherwise idle on the barrier
+    for(size_t i = 0; i + 1 < index_field_names.size(); i++) {
         num_queued++;
 
-        index->thread_pool->enqueue([&]() {
-            const field& f = (field_name == "id") ?
-                             field("id", field_types::STRING, false) : search_schema.at(field_name);
-            index->index_field_in_memory(f, iter_batch);
+        index->indexing_thread_pool->enqueue([&, i]() {
+            index_single_field(*index_field_names[i]);
             std::unique_lock<std::mutex> lock(m_process);
             num_processed++;
             cv_process.notify_one();
         });
     }
 
+    if(!index_field_names.empty()) {
+        index_single_field(*index_field_names.back());
+    }
+
     {
         std::unique_lock<std::mutex> lock_process(m_process);
         cv_process.wait(lock_process, [&](){ return num_processed == num_queued; });
     }
 
+    // cached filter results are now stale
+    index->write_watermark++;
+
     return num_indexed;
 }
 
@@ -588,6 +857,7 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
             }
         }
 
+        seq_ids_version++;
         return;
     }
 
@@ -629,7 +899,26 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
                     fhashvalues.hashes[i] = field_index_it->second.facet_hashes[i];
                 }
 
-                facet_index_v3[afield.name][seq_id % ARRAY_FACET_DIM]->emplace(seq_id, std::move(fhashvalues));
+                facet_index_v3[afield.name]->upsert(seq_id, std::move(fhashvalues));
+
+                facet_value_store_t* fvstore = facet_value_store.at(afield.name);
+                const auto& fvalues = field_index_it->second.facet_values;
+
+                for(size_t i = 0; i < fvalues.size(); i++) {
+                    fvstore->intern(field_index_it->second.facet_hashes[i], fvalues[i]);
+                }
+
+                const auto fvindex_it = facet_value_index.find(afield.name);
+                if(fvindex_it != facet_value_index.end()) {
+                    const auto& fvalue_tokens = field_index_it->second.facet_value_tokens;
+
+                    for(size_t i = 0; i < fvalue_tokens.size(); i++) {
+                        for(const std::string& value_token: fvalue_tokens[i]) {
+                            fvindex_it->second->insert(value_token, field_index_it->second.facet_hashes[i],
+                                                       seq_id, record.points);
+                        }
+                    }
+                }
             }
 
             if(record.points > max_score) {
@@ -648,51 +937,73 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
 
         art_tree *t = tree_it->second;
 
+        std::vector<art_key_documents> batch;
+        batch.reserve(token_to_doc_offsets.size());
+
         for(auto& token_to_doc: token_to_doc_offsets) {
             const std::string& token = token_to_doc.first;
             std::vector<art_document>& documents = token_to_doc.second;
 
             const auto *key = (const unsigned char *) token.c_str();
-            int key_len = (int) token.length() + 1;  // for the terminating \0 char
+            uint32_t key_len = (uint32_t) token.length() + 1;  // for the terminating \0 char
 
             //LOG(INFO) << "key: " << key << ", art_doc.id: " << art_doc.id;
-            art_inserts(t, key, key_len, max_score, documents);
+            batch.push_back({key, key_len, &documents});
         }
+
+        // sorted bulk insert descends shared token prefixes only once
+        art_bulk_inserts(t, max_score, batch);
     }
 
     if(!afield.is_string()) {
         if (afield.type == field_types::INT32) {
             auto num_tree = numerical_index.at(afield.name);
-            iterate_and_index_numerical_field(iter_batch, afield, [&afield, num_tree]
+            iterate_and_index_numerical_field(iter_batch, afield, [this, &afield, num_tree]
                     (const index_record& record, uint32_t seq_id) {
                 int32_t value = record.doc[afield.name].get<int32_t>();
                 num_tree->insert(value, seq_id);
+
+                if(afield.materialize) {
+                    materialized_filter_insert(afield.name, value, seq_id);
+                }
             });
         }
 
         else if(afield.type == field_types::INT64) {
             auto num_tree = numerical_index.at(afield.name);
-            iterate_and_index_numerical_field(iter_batch, afield, [&afield, num_tree]
+            iterate_and_index_numerical_field(iter_batch, afield, [this, &afield, num_tree]
             (const index_record& record, uint32_t seq_id) {
                 int64_t value = record.doc[afield.name].get<int64_t>();
                 num_tree->insert(value, seq_id);
+
+                if(afield.materialize) {
+                    materialized_filter_insert(afield.name, value, seq_id);
+                }
           });
         }
 
         else if(afield.type == field_types::FLOAT) {
             auto num_tree = numerical_index.at(afield.name);
-            iterate_and_index_numerical_field(iter_batch, afield, [&afield, num_tree]
+            iterate_and_index_numerical_field(iter_batch, afield, [this, &afield, num_tree]
                     (const index_record& record, uint32_t seq_id) {
                 float fvalue = record.doc[afield.name].get<float>();
                 int64_t value = float_to_in64_t(fvalue);
                 num_tree->insert(value, seq_id);
+
+                if(afield.materialize) {
+                    materialized_filter_insert(afield.name, value, seq_id);
+                }
             });
         } else if(afield.type == field_types::BOOL) {
-            auto num_tree = numerical_index.at(afield.name);
-            iterate_and_index_numerical_field(iter_batch, afield, [&afield, num_tree]
+            auto bitmaps = bool_index.at(afield.name);
+            iterate_and_index_numerical_field(iter_batch, afield, [this, &afield, bitmaps]
                     (const index_record& record, uint32_t seq_id) {
                 bool value = record.doc[afield.name].get<bool>();
-                num_tree->insert(value, seq_id);
+                bitmaps->insert(value, seq_id);
+
+                if(afield.materialize) {
+                    materialized_filter_insert(afield.name, value, seq_id);
+                }
             });
         } else if(afield.type == field_types::GEOPOINT) {
             auto geo_index = geopoint_index.at(afield.name);
@@ -707,7 +1018,7 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
                 S2Point point = S2LatLng::FromDegrees(latlong[0], latlong[1]).ToPoint();
 
                 for(const auto& term: indexer.GetIndexTerms(point, "")) {
-                    (*geo_index)[term].push_back(seq_id);
+                    geo_index->insert(term, seq_id);
                 }
             });
         } else if(afield.type == field_types::GEOPOINT_ARRAY) {
@@ -727,13 +1038,10 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
                 for(size_t li = 0; li < latlongs.size(); li++) {
                     auto& latlong = latlongs[li];
                     S2Point point = S2LatLng::FromDegrees(latlong[0], latlong[1]).ToPoint();
-                    std::set<std::string> terms;
-                    for(const auto& term: indexer.GetIndexTerms(point, "")) {
-                        terms.insert(term);
-                    }
 
-                    for(const auto& term: terms) {
-                        (*geo_index)[term].push_back(seq_id);
+                    // `insert` de-duplicates, so points sharing a cell term index it once
+                    for(const auto& term: indexer.GetIndexTerms(point, "")) {
+                        geo_index->insert(term, seq_id);
                     }
 
                     int64_t packed_latlong = GeoPoint::pack_lat_lng(latlong[0], latlong[1]);
@@ -742,33 +1050,49 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
 
                 geo_array_index.at(afield.name)->emplace(seq_id, packed_latlongs);
             });
+        } else if(afield.type == field_types::BOOL_ARRAY) {
+            auto bitmaps = bool_index.at(afield.name);
+            iterate_and_index_numerical_field(iter_batch, afield, [this, &afield, bitmaps]
+                    (const index_record& record, uint32_t seq_id) {
+                for(size_t arr_i = 0; arr_i < record.doc[afield.name].size(); arr_i++) {
+                    const bool value = record.doc[afield.name][arr_i];
+                    bitmaps->insert(value, seq_id);
+
+                    if(afield.materialize) {
+                        materialized_filter_insert(afield.name, int64_t(value), seq_id);
+                    }
+                }
+            });
         } else if(afield.is_array()) {
             // all other numerical arrays
             auto num_tree = numerical_index.at(afield.name);
-            iterate_and_index_numerical_field(iter_batch, afield, [&afield, num_tree]
+            iterate_and_index_numerical_field(iter_batch, afield, [this, &afield, num_tree]
                     (const index_record& record, uint32_t seq_id) {
                 for(size_t arr_i = 0; arr_i < record.doc[afield.name].size(); arr_i++) {
                     const auto& arr_value = record.doc[afield.name][arr_i];
+                    int64_t value;
 
                     if(afield.type == field_types::INT32_ARRAY) {
-                        const int32_t value = arr_value;
-                        num_tree->insert(value, seq_id);
+                        value = arr_value.get<int32_t>();
                     }
 
                     else if(afield.type == field_types::INT64_ARRAY) {
-                        const int64_t value = arr_value;
-                        num_tree->insert(value, seq_id);
+                        value = arr_value.get<int64_t>();
                     }
 
                     else if(afield.type == field_types::FLOAT_ARRAY) {
                         const float fvalue = arr_value;
-                        int64_t value = float_to_in64_t(fvalue);
-                        num_tree->insert(value, seq_id);
+                        value = float_to_in64_t(fvalue);
                     }
 
-                    else if(afield.type == field_types::BOOL_ARRAY) {
-                        const bool value = record.doc[afield.name][arr_i];
-                        num_tree->insert(int64_t(value), seq_id);
+                    else {
+                        continue;
+                    }
+
+                    num_tree->insert(value, seq_id);
+
+                    if(afield.materialize) {
+                        materialized_filter_insert(afield.name, value, seq_id);
                     }
                 }
             });
@@ -778,7 +1102,7 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
         if(afield.type == field_types::INT32 || afield.type == field_types::INT64 ||
            afield.type == field_types::FLOAT || afield.type == field_types::BOOL ||
            afield.type == field_types::GEOPOINT) {
-            spp::sparse_hash_map<uint32_t, int64_t> *doc_to_score = sort_index.at(afield.name);
+            doc_values_t* doc_to_score = sort_index.at(afield.name);
 
             bool is_integer = afield.is_integer();
             bool is_float = afield.is_float();
@@ -786,7 +1110,7 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
             bool is_geopoint = afield.is_geopoint();
 
             for(const auto& record: iter_batch) {
-                if(!record.indexed.ok()) {
+                if(!record.indexed.ok() || record.numeric_only_update) {
                     continue;
                 }
 
@@ -798,16 +1122,16 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
                 }
 
                 if(is_integer) {
-                    doc_to_score->emplace(seq_id, document[afield.name].get<int64_t>());
+                    doc_to_score->upsert(seq_id, document[afield.name].get<int64_t>());
                 } else if(is_float) {
                     int64_t ifloat = float_to_in64_t(document[afield.name].get<float>());
-                    doc_to_score->emplace(seq_id, ifloat);
+                    doc_to_score->upsert(seq_id, ifloat);
                 } else if(is_bool) {
-                    doc_to_score->emplace(seq_id, (int64_t) document[afield.name].get<bool>());
+                    doc_to_score->upsert(seq_id, (int64_t) document[afield.name].get<bool>());
                 } else if(is_geopoint) {
                     const std::vector<double>& latlong = document[afield.name];
                     int64_t lat_lng = GeoPoint::pack_lat_lng(latlong[0], latlong[1]);
-                    doc_to_score->emplace(seq_id, lat_lng);
+                    doc_to_score->upsert(seq_id, lat_lng);
                 }
             }
         }
@@ -849,11 +1173,14 @@ void Index::tokenize_string_with_facets(const std::string& text, bool is_facet,
                                         const std::vector<char>& symbols_to_index,
                                         const std::vector<char>& token_separators,
                                         std::unordered_map<std::string, std::vector<uint32_t>>& token_to_offsets,
-                                        std::vector<uint64_t>& facet_hashes) {
+                                        std::vector<uint64_t>& facet_hashes,
+                                        std::vector<std::string>& facet_values,
+                                        std::vector<std::vector<std::string>>& facet_value_tokens) {
 
     Tokenizer tokenizer(text, true, !a_field.is_string(), a_field.locale, symbols_to_index, token_separators);
     std::string token;
     std::string last_token;
+    std::vector<std::string> value_tokens;
     size_t token_index = 0;
 
     while(tokenizer.next(token, token_index)) {
@@ -863,6 +1190,10 @@ void Index::tokenize_string_with_facets(const std::string& text, bool is_facet,
 
         token_to_offsets[token].push_back(token_index + 1);
         last_token = token;
+
+        if(is_facet) {
+            value_tokens.push_back(token);
+        }
     }
 
     if(!token_to_offsets.empty()) {
@@ -873,6 +1204,8 @@ void Index::tokenize_string_with_facets(const std::string& text, bool is_facet,
     if(is_facet) {
         uint64_t hash = Index::facet_token_hash(a_field, text);
         facet_hashes.push_back(hash);
+        facet_values.push_back(text);
+        facet_value_tokens.push_back(std::move(value_tokens));
     }
 }
 
@@ -898,7 +1231,7 @@ void Index::index_strings_field(const int64_t score, art_tree *t,
             fhashvalues.hashes[i] = facet_hashes[i];
         }
 
-        facet_index_v3[a_field.name][seq_id % ARRAY_FACET_DIM]->emplace(seq_id, std::move(fhashvalues));
+        facet_index_v3[a_field.name]->upsert(seq_id, std::move(fhashvalues));
     }
 }
 
@@ -907,7 +1240,9 @@ void Index::tokenize_string_array_with_facets(const std::vector<std::string>& st
                                               const std::vector<char>& symbols_to_index,
                                               const std::vector<char>& token_separators,
                                               std::unordered_map<std::string, std::vector<uint32_t>>& token_to_offsets,
-                                              std::vector<uint64_t>& facet_hashes) {
+                                              std::vector<uint64_t>& facet_hashes,
+                                              std::vector<std::string>& facet_values,
+                                              std::vector<std::vector<std::string>>& facet_value_tokens) {
 
     for(size_t array_index = 0; array_index < strings.size(); array_index++) {
         const std::string& str = strings[array_index];
@@ -915,6 +1250,7 @@ void Index::tokenize_string_array_with_facets(const std::vector<std::string>& st
 
         Tokenizer tokenizer(str, true, !a_field.is_string(), a_field.locale, symbols_to_index, token_separators);
         std::string token, last_token;
+        std::vector<std::string> value_tokens;
         size_t token_index = 0;
 
         // iterate and append offset positions
@@ -926,6 +1262,10 @@ void Index::tokenize_string_array_with_facets(const std::vector<std::string>& st
             token_to_offsets[token].push_back(token_index + 1);
             token_set.insert(token);
             last_token = token;
+
+            if(is_facet) {
+                value_tokens.push_back(token);
+            }
         }
 
         //LOG(INFO) << "Str: " << str << ", last_token: " << last_token;
@@ -938,6 +1278,8 @@ void Index::tokenize_string_array_with_facets(const std::vector<std::string>& st
             uint64_t hash = facet_token_hash(a_field, str);
             //LOG(INFO) << "indexing " << token  << ", hash:" << hash;
             facet_hashes.push_back(hash);
+            facet_values.push_back(str);
+            facet_value_tokens.push_back(std::move(value_tokens));
         }
 
         for(auto& the_token: token_set) {
@@ -990,9 +1332,21 @@ void Index::compute_facet_stats(facet &a_facet, uint64_t raw_value, const std::s
 void Index::do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
                       const std::vector<facet_info_t>& facet_infos,
                       const size_t group_limit, const std::vector<std::string>& group_by_fields,
-                      const uint32_t* result_ids, size_t results_size) const {
+                      const uint32_t* result_ids, size_t results_size,
+                      const size_t sample_stride) const {
     
     // assumed that facet fields have already been validated upstream
+
+    // when grouping, resolve every document's group key once for the whole
+    // batch instead of once per facet field
+    std::vector<uint64_t> distinct_ids;
+    if(group_limit) {
+        distinct_ids.resize(results_size);
+        for(size_t i = 0; i < results_size; i++) {
+            distinct_ids[i] = get_distinct_id(group_by_fields, result_ids[i]);
+        }
+    }
+
     for(size_t findex=0; findex < facets.size(); findex++) {
         auto& a_facet = facets[findex];
         const auto& facet_field = facet_infos[findex].facet_field;
@@ -1005,18 +1359,26 @@ void Index::do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
             continue;
         }
 
-        const auto& field_facet_mapping = field_facet_mapping_it->second;
+        const facet_column_t* facet_column = field_facet_mapping_it->second;
 
-        for(size_t i = 0; i < results_size; i++) {
+        // opt-in bounded counting (Misra-Gries): once the summary is full, an
+        // unseen value decays every counter instead of being admitted, so only
+        // heavy hitters survive; counts beyond the displayed top values are
+        // approximate (grouped and facet-query counting stay exact)
+        const bool bounded_counting = a_facet.approx && group_limit == 0 && !use_facet_query;
+
+        // a stride > 1 counts a uniform sample of the result ids; the caller
+        // scales the counts back up and marks them as sampled
+        for(size_t i = 0; i < results_size; i += sample_stride) {
             uint32_t doc_seq_id = result_ids[i];
-            const auto& facet_hashes_it = field_facet_mapping[doc_seq_id % ARRAY_FACET_DIM]->find(doc_seq_id);
+            const facet_hash_values_t* doc_facet_hashes = facet_column->get(doc_seq_id);
 
-            if(facet_hashes_it == field_facet_mapping[doc_seq_id % ARRAY_FACET_DIM]->end()) {
+            if(doc_facet_hashes == nullptr) {
                 continue;
             }
 
-            const auto& facet_hashes = facet_hashes_it->second;
-            const uint64_t distinct_id = group_limit ? get_distinct_id(group_by_fields, doc_seq_id) : 0;
+            const auto& facet_hashes = *doc_facet_hashes;
+            const uint64_t distinct_id = group_limit ? distinct_ids[i] : 0;
 
             for(size_t j = 0; j < facet_hashes.size(); j++) {
                 auto fhash = facet_hashes.hashes[j];
@@ -1026,6 +1388,23 @@ void Index::do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
                 }
 
                 if(!use_facet_query || fquery_hashes.find(fhash) != fquery_hashes.end()) {
+                    if(bounded_counting && a_facet.result_map.size() >= APPROX_FACET_CAPACITY &&
+                       a_facet.result_map.count(fhash) == 0) {
+                        std::vector<uint64_t> decayed_hashes;
+
+                        for(auto& kv: a_facet.result_map) {
+                            if(--kv.second.count == 0) {
+                                decayed_hashes.push_back(kv.first);
+                            }
+                        }
+
+                        for(const uint64_t decayed_hash: decayed_hashes) {
+                            a_facet.result_map.erase(decayed_hash);
+                        }
+
+                        continue;
+                    }
+
                     facet_count_t& facet_count = a_facet.result_map[fhash];
 
                     //LOG(INFO) << "field: " << a_facet.field_name << ", doc id: " << doc_seq_id << ", hash: " <<  fhash;
@@ -1050,10 +1429,9 @@ void Index::do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
 
 void Index::aggregate_topster(Topster* agg_topster, Topster* index_topster) {
     if(index_topster->distinct) {
-        for(auto &group_topster_entry: index_topster->group_kv_map) {
-            Topster* group_topster = group_topster_entry.second;
-            for(const auto& map_kv: group_topster->kv_map) {
-                agg_topster->add(map_kv.second);
+        for(auto& slot: index_topster->group_map->slots) {
+            for(uint32_t i = 0; i < slot.size; i++) {
+                agg_topster->add(&slot.kvs[i]);
             }
         }
     } else {
@@ -1063,11 +1441,103 @@ void Index::aggregate_topster(Topster* agg_topster, Topster* index_topster) {
     }
 }
 
+void Index::aggregate_topsters(Topster* agg_topster, const std::vector<Topster*>& batch_topsters) {
+    // grouped results aggregate via per-group maps, and a partially filled
+    // aggregate cannot take a bulk move, so both fall back to per-entry adds
+    if(agg_topster->distinct || agg_topster->size != 0) {
+        for(Topster* batch_topster: batch_topsters) {
+            if(batch_topster != nullptr) {
+                aggregate_topster(agg_topster, batch_topster);
+            }
+        }
+
+        return;
+    }
+
+    std::vector<Topster*> candidates;
+    size_t total_entries = 0;
+
+    for(Topster* batch_topster: batch_topsters) {
+        if(batch_topster != nullptr && batch_topster->size != 0) {
+            batch_topster->sort();
+            candidates.push_back(batch_topster);
+            total_entries += batch_topster->size;
+        }
+    }
+
+    // per-worker topsters hold disjoint documents, so a k-way merge of their
+    // sorted entries can move the overall top-K straight into the aggregate:
+    // no per-entry heap maintenance and no final sort over the aggregate.
+    // filling backwards leaves the array ascending, which is a valid min-heap
+    // layout for any later adds
+    std::vector<uint32_t> cursors(candidates.size(), 0);
+    const size_t num_taken = std::min<size_t>(agg_topster->MAX_SIZE, total_entries);
+
+    for(size_t fill_index = num_taken; fill_index-- > 0; ) {
+        size_t best = candidates.size();
+
+        for(size_t ci = 0; ci < candidates.size(); ci++) {
+            if(cursors[ci] < candidates[ci]->size &&
+               (best == candidates.size() ||
+                Topster::is_greater(candidates[ci]->kvs[cursors[ci]], candidates[best]->kvs[cursors[best]]))) {
+                best = ci;
+            }
+        }
+
+        KV* source_kv = candidates[best]->kvs[cursors[best]];
+        cursors[best]++;
+
+        // move ferries `query_indices` ownership without a copy
+        agg_topster->data[fill_index] = std::move(*source_kv);
+        agg_topster->data[fill_index].array_index = fill_index;
+        agg_topster->kvs[fill_index] = &agg_topster->data[fill_index];
+        agg_topster->kv_map.emplace(agg_topster->data[fill_index].key, agg_topster->kvs[fill_index]);
+    }
+
+    agg_topster->size = num_taken;
+    agg_topster->sorted_ascending = (num_taken != 0);
+}
+
+void Index::aggregate_facets(std::vector<facet>& agg_facets, std::vector<facet>& batch_facets,
+                             const size_t group_limit) {
+    for(size_t fi = 0; fi < batch_facets.size(); fi++) {
+        auto& this_facet = batch_facets[fi];
+        auto& acc_facet = agg_facets[fi];
+
+        for(auto & facet_kv: this_facet.result_map) {
+            // single probe into the accumulated map per hash
+            facet_count_t& acc_count = acc_facet.result_map[facet_kv.first];
+
+            if(group_limit) {
+                // we have to add all group sets
+                acc_facet.hash_groups[facet_kv.first].insert(
+                    this_facet.hash_groups[facet_kv.first].begin(),
+                    this_facet.hash_groups[facet_kv.first].end()
+                );
+            } else {
+                acc_count.count += facet_kv.second.count;
+            }
+
+            acc_count.doc_id = facet_kv.second.doc_id;
+            acc_count.array_pos = facet_kv.second.array_pos;
+            acc_facet.hash_tokens[facet_kv.first] = this_facet.hash_tokens[facet_kv.first];
+        }
+
+        if(this_facet.stats.fvcount != 0) {
+            acc_facet.stats.fvcount += this_facet.stats.fvcount;
+            acc_facet.stats.fvsum += this_facet.stats.fvsum;
+            acc_facet.stats.fvmax = std::max(acc_facet.stats.fvmax, this_facet.stats.fvmax);
+            acc_facet.stats.fvmin = std::min(acc_facet.stats.fvmin, this_facet.stats.fvmin);
+        }
+    }
+}
+
 void Index::search_candidates(const uint8_t & field_id, bool field_is_array,
                               const uint32_t* filter_ids, size_t filter_ids_length,
                               const uint32_t* exclude_token_ids, size_t exclude_token_ids_size,
                               const std::vector<uint32_t>& curated_ids,
                               const std::vector<sort_by> & sort_fields,
+                              const std::string& default_sorting_field,
                               std::vector<token_candidates> & token_candidates_vec,
                               std::vector<std::vector<art_leaf*>> & searched_queries,
                               Topster* topster,
@@ -1088,16 +1558,37 @@ void Index::search_candidates(const uint8_t & field_id, bool field_is_array,
     long long int N = std::accumulate(token_candidates_vec.begin(), token_candidates_vec.end(), 1LL, product);
 
     int sort_order[3]; // 1 or -1 based on DESC or ASC respectively
-    std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3> field_values;
+    std::array<doc_values_t*, 3> field_values;
     std::vector<size_t> geopoint_indices;
 
     populate_sort_mapping(sort_order, geopoint_indices, sort_fields, field_values);
 
+    // Block-Max WAND: when ranking primarily on the default sorting field in descending order,
+    // the per-block score maxima let the intersection skip blocks that cannot displace the
+    // current top-k. Skipped ids are absent from the result set, so counts become lower bounds;
+    // exhaustive and grouped searches therefore stay on the full walk.
+    const bool use_wand = topster != nullptr && !exhaustive_search && group_limit == 0 &&
+                          !sort_fields.empty() && !default_sorting_field.empty() &&
+                          sort_fields[0].name == default_sorting_field && sort_order[0] == 1;
+
     size_t combination_limit = exhaustive_search ? Index::COMBINATION_MAX_LIMIT : Index::COMBINATION_MIN_LIMIT;
 
-    for(long long n=0; n<N && n<combination_limit; ++n) {
+    // when the cap will cut off combinations, enumerate them best-first (lowest
+    // typo cost, then highest token frequency) so that the cap drops the least
+    // promising combinations instead of an arbitrary tail of the product
+    std::vector<long long> combination_order;
+    if(N > (long long) combination_limit) {
+        beam_candidate_order(token_candidates_vec, combination_limit, combination_order);
+    }
+
+    const long long num_combinations = combination_order.empty() ? std::min<long long>(N, combination_limit)
+                                                                 : (long long) combination_order.size();
+
+    for(long long ci = 0; ci < num_combinations; ++ci) {
         RETURN_CIRCUIT_BREAKER
 
+        const long long n = combination_order.empty() ? ci : combination_order[ci];
+
         // every element in `query_suggestion` contains a token and its associated hits
         std::vector<art_leaf*> query_suggestion(token_candidates_vec.size());
 
@@ -1116,6 +1607,13 @@ void Index::search_candidates(const uint8_t & field_id, bool field_is_array,
 
         query_hashes.insert(qhash);
 
+        // `query_suggestion` is ordered by token selectivity: an intersection can only be
+        // as large as its rarest token, so one wiped out by deletes empties the whole
+        // conjunction and the combination can be skipped without building iterators
+        if(!query_suggestion.empty() && posting_t::num_ids(query_suggestion[0]->values) == 0) {
+            continue;
+        }
+
         //LOG(INFO) << "field_num_results: " << field_num_results << ", typo_tokens_threshold: " << typo_tokens_threshold;
         //LOG(INFO) << "n: " << n;
 
@@ -1137,10 +1635,23 @@ void Index::search_candidates(const uint8_t & field_id, bool field_is_array,
             posting_lists.push_back(query_leaf->values);
         }
 
+        /*std::stringstream plan;
+        for(const auto& query_leaf : query_suggestion) {
+            std::string qtok(reinterpret_cast<char*>(query_leaf->key), query_leaf->key_len - 1);
+            plan << qtok << "(" << posting_t::num_ids(query_leaf->values) << ") ";
+        }
+        LOG(INFO) << "intersection order: " << plan.str();*/
+
         posting_list_t::result_iter_state_t iter_state(
             excluded_result_ids, excluded_result_ids_size, filter_ids, filter_ids_length
         );
 
+        std::atomic<int64_t> wand_threshold{INT64_MIN};
+
+        if(use_wand) {
+            iter_state.max_score_threshold = &wand_threshold;
+        }
+
         // We fetch offset positions only for multi token query
         bool fetch_offsets = (query_suggestion.size() > 1);
         bool single_exact_query_token = false;
@@ -1164,6 +1675,7 @@ void Index::search_candidates(const uint8_t & field_id, bool field_is_array,
         } else {
             for(size_t i = 0; i < concurrency; i++) {
                 topsters[i] = new Topster(topster->MAX_SIZE, topster->distinct);
+                topsters[i]->after_bound = topster->after_bound;
             }
 
             posting_t::block_intersector_t(
@@ -1176,6 +1688,15 @@ void Index::search_candidates(const uint8_t & field_id, bool field_is_array,
                               group_limit, group_by_fields, token_bits,
                               prioritize_exact_match, single_exact_query_token, its);
 
+                if(use_wand && topsters[index]->size == topsters[index]->MAX_SIZE) {
+                    // min-heap root holds the k-th best primary score seen by this thread
+                    const int64_t kth_score = topsters[index]->kvs[0]->scores[0];
+                    int64_t prev_threshold = wand_threshold.load(std::memory_order_relaxed);
+                    while(prev_threshold < kth_score &&
+                          !wand_threshold.compare_exchange_weak(prev_threshold, kth_score,
+                                                                std::memory_order_relaxed)) { }
+                }
+
                 result_id_vecs[index].push_back(seq_id);
             }, concurrency);
         }
@@ -1201,19 +1722,23 @@ void Index::search_candidates(const uint8_t & field_id, bool field_is_array,
 
                 if (topster != nullptr) {
                     // topster is null when used by overrides which requires only IDs but not actual processing
-                    aggregate_topster(topster, topsters[i]);
                     groups_processed.insert(groups_processed_vec[i].begin(), groups_processed_vec[i].end());
                 }
             }
+        }
 
-            if(topster != nullptr) {
+        if(topster != nullptr) {
+            aggregate_topsters(topster, std::vector<Topster*>(topsters, topsters + concurrency));
+
+            for(size_t i = 0; i < concurrency; i++) {
                 delete topsters[i];
             }
         }
 
         if(id_buff.size() > 100000) {
             // prevents too many ORs during exhaustive searching
-            std::sort(id_buff.begin(), id_buff.end());
+            // (always past the parallel sort threshold given the check above)
+            parasort(id_buff.size(), &id_buff[0], 4);
             id_buff.erase(std::unique( id_buff.begin(), id_buff.end() ), id_buff.end());
 
             uint32_t* new_all_result_ids = nullptr;
@@ -1234,355 +1759,615 @@ void Index::search_candidates(const uint8_t & field_id, bool field_is_array,
     }
 }
 
-void Index::do_filtering(uint32_t*& filter_ids, uint32_t& filter_ids_length,
-                         const std::vector<filter>& filters,
-                         const bool enable_short_circuit) const {
-    //auto begin = std::chrono::high_resolution_clock::now();
-    for(size_t i = 0; i < filters.size(); i++) {
-        const filter & a_filter = filters[i];
+bool Index::do_filtering_clause(const filter& a_filter, uint32_t* prior_ids, const uint32_t prior_ids_length,
+                                uint32_t*& result_ids, size_t& result_ids_len) const {
+    if(a_filter.field_name == "id") {
+        // we handle `ids` separately
+        std::vector<uint32> id_values;
+        for(const auto& id_str: a_filter.values) {
+            id_values.push_back(std::stoul(id_str));
+        }
 
-        if(a_filter.field_name == "id") {
-            // we handle `ids` separately
-            std::vector<uint32> result_ids;
-            for(const auto& id_str: a_filter.values) {
-                result_ids.push_back(std::stoul(id_str));
-            }
+        std::sort(id_values.begin(), id_values.end());
 
-            std::sort(result_ids.begin(), result_ids.end());
+        result_ids = new uint32[id_values.size()];
+        std::copy(id_values.begin(), id_values.end(), result_ids);
+        result_ids_len = id_values.size();
 
-            if(i == 0) {
-                filter_ids = new uint32[result_ids.size()];
-                std::copy(result_ids.begin(), result_ids.end(), filter_ids);
-                filter_ids_length = result_ids.size();
-            } else {
-                uint32_t* filtered_results = nullptr;
-                filter_ids_length = ArrayUtils::and_scalar(filter_ids, filter_ids_length, &result_ids[0],
-                                                           result_ids.size(), &filtered_results);
-                delete [] filter_ids;
-                filter_ids = filtered_results;
-            }
+        return true;
+    }
 
-            continue;
-        }
+    bool has_search_index = search_index.count(a_filter.field_name) != 0 ||
+                            numerical_index.count(a_filter.field_name) != 0 ||
+                            bool_index.count(a_filter.field_name) != 0 ||
+                            geopoint_index.count(a_filter.field_name) != 0;
 
-        bool has_search_index = search_index.count(a_filter.field_name) != 0 ||
-                                numerical_index.count(a_filter.field_name) != 0 ||
-                                geopoint_index.count(a_filter.field_name) != 0;
+    if(!has_search_index) {
+        return false;
+    }
 
-        if(!has_search_index) {
-            continue;
-        }
+    field f = search_schema.at(a_filter.field_name);
 
-        field f = search_schema.at(a_filter.field_name);
+    if(f.is_integer()) {
+        auto num_tree = numerical_index.at(a_filter.field_name);
 
-        uint32_t* result_ids = nullptr;
-        size_t result_ids_len = 0;
+        for(size_t fi=0; fi < a_filter.values.size(); fi++) {
+            const std::string & filter_value = a_filter.values[fi];
+            int64_t value = (int64_t) std::stol(filter_value);
 
-        if(f.is_integer()) {
-            auto num_tree = numerical_index.at(a_filter.field_name);
+            if(a_filter.comparators[fi] == RANGE_INCLUSIVE && fi+1 < a_filter.values.size()) {
+                const std::string& next_filter_value = a_filter.values[fi+1];
+                int64_t range_end_value = (int64_t) std::stol(next_filter_value);
+                num_tree->range_inclusive_search(value, range_end_value, &result_ids, result_ids_len);
+                fi++;
+            } else if(f.materialize && a_filter.comparators[fi] == EQUALS) {
+                materialized_filter_fetch(a_filter.field_name, value, &result_ids, result_ids_len);
+            } else {
+                num_tree->search(a_filter.comparators[fi], value, &result_ids, result_ids_len);
+            }
+        }
 
-            for(size_t fi=0; fi < a_filter.values.size(); fi++) {
-                const std::string & filter_value = a_filter.values[fi];
-                int64_t value = (int64_t) std::stol(filter_value);
+    } else if(f.is_float()) {
+        auto num_tree = numerical_index.at(a_filter.field_name);
 
-                if(a_filter.comparators[fi] == RANGE_INCLUSIVE && fi+1 < a_filter.values.size()) {
-                    const std::string& next_filter_value = a_filter.values[fi+1];
-                    int64_t range_end_value = (int64_t) std::stol(next_filter_value);
-                    num_tree->range_inclusive_search(value, range_end_value, &result_ids, result_ids_len);
-                    fi++;
-                } else {
-                    num_tree->search(a_filter.comparators[fi], value, &result_ids, result_ids_len);
-                }
-            }
-
-        } else if(f.is_float()) {
-            auto num_tree = numerical_index.at(a_filter.field_name);
+        for(size_t fi=0; fi < a_filter.values.size(); fi++) {
+            const std::string & filter_value = a_filter.values[fi];
+            float value = (float) std::atof(filter_value.c_str());
+            int64_t float_int64 = float_to_in64_t(value);
 
-            for(size_t fi=0; fi < a_filter.values.size(); fi++) {
-                const std::string & filter_value = a_filter.values[fi];
-                float value = (float) std::atof(filter_value.c_str());
-                int64_t float_int64 = float_to_in64_t(value);
-
-                if(a_filter.comparators[fi] == RANGE_INCLUSIVE && fi+1 < a_filter.values.size()) {
-                    const std::string& next_filter_value = a_filter.values[fi+1];
-                    int64_t range_end_value = float_to_in64_t((float) std::atof(next_filter_value.c_str()));
-                    num_tree->range_inclusive_search(float_int64, range_end_value, &result_ids, result_ids_len);
-                    fi++;
-                } else {
-                    num_tree->search(a_filter.comparators[fi], float_int64, &result_ids, result_ids_len);
-                }
+            if(a_filter.comparators[fi] == RANGE_INCLUSIVE && fi+1 < a_filter.values.size()) {
+                const std::string& next_filter_value = a_filter.values[fi+1];
+                int64_t range_end_value = float_to_in64_t((float) std::atof(next_filter_value.c_str()));
+                num_tree->range_inclusive_search(float_int64, range_end_value, &result_ids, result_ids_len);
+                fi++;
+            } else if(f.materialize && a_filter.comparators[fi] == EQUALS) {
+                materialized_filter_fetch(a_filter.field_name, float_int64, &result_ids, result_ids_len);
+            } else {
+                num_tree->search(a_filter.comparators[fi], float_int64, &result_ids, result_ids_len);
             }
+        }
 
-        } else if(f.is_bool()) {
-            auto num_tree = numerical_index.at(a_filter.field_name);
+    } else if(f.is_bool()) {
+        auto bitmaps = bool_index.at(a_filter.field_name);
 
-            size_t value_index = 0;
-            for(const std::string & filter_value: a_filter.values) {
-                int64_t bool_int64 = (filter_value == "1") ? 1 : 0;
-                if(a_filter.comparators[value_index] == NOT_EQUALS) {
-                    uint32_t* to_exclude_ids = nullptr;
-                    size_t to_exclude_ids_len = 0;
-                    num_tree->search(EQUALS, bool_int64, &to_exclude_ids, to_exclude_ids_len);
+        size_t value_index = 0;
+        for(const std::string & filter_value: a_filter.values) {
+            bool bool_value = (filter_value == "1");
+            if(a_filter.comparators[value_index] == NOT_EQUALS) {
+                uint32_t* to_exclude_ids = nullptr;
+                size_t to_exclude_ids_len = 0;
 
-                    auto all_ids = seq_ids.uncompress();
-                    auto all_ids_size = seq_ids.getLength();
+                // exclusion from `seq_ids` (instead of reading the opposite bitmap) keeps
+                // documents that lack the field, and multi-valued docs holding both values
+                bitmaps->search(bool_value, &to_exclude_ids, to_exclude_ids_len);
 
-                    uint32_t* excluded_ids = nullptr;
-                    size_t excluded_ids_len = 0;
+                size_t all_ids_size = 0;
+                const uint32_t* all_ids = get_live_ids(all_ids_size);
 
-                    excluded_ids_len = ArrayUtils::exclude_scalar(all_ids, all_ids_size, to_exclude_ids,
-                                                                  to_exclude_ids_len, &excluded_ids);
+                uint32_t* excluded_ids = nullptr;
+                size_t excluded_ids_len = 0;
 
-                    delete [] all_ids;
-                    delete [] to_exclude_ids;
+                excluded_ids_len = ArrayUtils::exclude_scalar(all_ids, all_ids_size, to_exclude_ids,
+                                                              to_exclude_ids_len, &excluded_ids);
 
-                    uint32_t *out = nullptr;
-                    result_ids_len = ArrayUtils::or_scalar(result_ids, result_ids_len,
-                                                           excluded_ids, excluded_ids_len, &out);
-                    delete [] result_ids;
-                    result_ids = out;
-                    delete [] excluded_ids;
-                } else {
-                    num_tree->search(a_filter.comparators[value_index], bool_int64, &result_ids, result_ids_len);
-                }
+                delete [] to_exclude_ids;
 
-                value_index++;
+                uint32_t *out = nullptr;
+                result_ids_len = ArrayUtils::or_scalar(result_ids, result_ids_len,
+                                                       excluded_ids, excluded_ids_len, &out);
+                delete [] result_ids;
+                result_ids = out;
+                delete [] excluded_ids;
+            } else {
+                bitmaps->search(bool_value, &result_ids, result_ids_len);
             }
 
-        } else if(f.is_geopoint()) {
-            std::set<uint32_t> geo_result_ids;
+            value_index++;
+        }
+
+    } else if(f.is_geopoint()) {
+        for(const std::string& filter_value: a_filter.values) {
+            std::vector<std::string> filter_value_parts;
+            StringUtils::split(filter_value, filter_value_parts, ",");  // x, y, 2 km (or) list of points
 
-            for(const std::string& filter_value: a_filter.values) {
-                std::vector<std::string> filter_value_parts;
-                StringUtils::split(filter_value, filter_value_parts, ",");  // x, y, 2 km (or) list of points
+            bool is_polygon = StringUtils::is_float(filter_value_parts.back());
+            S2Region* query_region;
 
-                bool is_polygon = StringUtils::is_float(filter_value_parts.back());
-                S2Region* query_region;
+            if(is_polygon) {
+                const int num_verts = int(filter_value_parts.size()) / 2;
+                std::vector<S2Point> vertices;
+                double sum = 0.0;
 
-                if(is_polygon) {
-                    const int num_verts = int(filter_value_parts.size()) / 2;
-                    std::vector<S2Point> vertices;
-                    double sum = 0.0;
+                for(size_t point_index = 0; point_index < size_t(num_verts); point_index++) {
+                    double lat = std::stod(filter_value_parts[point_index * 2]);
+                    double lon = std::stod(filter_value_parts[point_index * 2 + 1]);
+                    S2Point vertex = S2LatLng::FromDegrees(lat, lon).ToPoint();
+                    vertices.emplace_back(vertex);
+                }
 
-                    for(size_t point_index = 0; point_index < size_t(num_verts); point_index++) {
-                        double lat = std::stod(filter_value_parts[point_index * 2]);
-                        double lon = std::stod(filter_value_parts[point_index * 2 + 1]);
-                        S2Point vertex = S2LatLng::FromDegrees(lat, lon).ToPoint();
-                        vertices.emplace_back(vertex);
-                    }
+                for(size_t vi = 0; vi < vertices.size(); vi++) {
+                    auto& v1 = vertices[vi];
+                    auto& v2 = vertices[(vi + 1) % vertices.size()];
+                    sum += (v2.x() - v1.x()) * (v2.y() + v1.y());
+                }
 
-                    for(size_t vi = 0; vi < vertices.size(); vi++) {
-                        auto& v1 = vertices[vi];
-                        auto& v2 = vertices[(vi + 1) % vertices.size()];
-                        sum += (v2.x() - v1.x()) * (v2.y() + v1.y());
-                    }
+                bool is_clockwise = (sum > 0.0);
 
-                    bool is_clockwise = (sum > 0.0);
+                if(is_clockwise) {
+                    std::reverse(vertices.begin(), vertices.end());
+                }
 
-                    if(is_clockwise) {
-                        std::reverse(vertices.begin(), vertices.end());
-                    }
+                query_region = new S2Loop(vertices);
+            } else {
+                double radius = std::stof(filter_value_parts[2]);
+                const auto& unit = filter_value_parts[3];
 
-                    query_region = new S2Loop(vertices);
+                if(unit == "km") {
+                    radius *= 1000;
                 } else {
-                    double radius = std::stof(filter_value_parts[2]);
-                    const auto& unit = filter_value_parts[3];
+                    // assume "mi" (validated upstream)
+                    radius *= 1609.34;
+                }
 
-                    if(unit == "km") {
-                        radius *= 1000;
-                    } else {
-                        // assume "mi" (validated upstream)
-                        radius *= 1609.34;
-                    }
+                S1Angle query_radius = S1Angle::Radians(S2Earth::MetersToRadians(radius));
+                double query_lat = std::stod(filter_value_parts[0]);
+                double query_lng = std::stod(filter_value_parts[1]);
+                S2Point center = S2LatLng::FromDegrees(query_lat, query_lng).ToPoint();
+                query_region = new S2Cap(center, query_radius);
+            }
 
-                    S1Angle query_radius = S1Angle::Radians(S2Earth::MetersToRadians(radius));
-                    double query_lat = std::stod(filter_value_parts[0]);
-                    double query_lng = std::stod(filter_value_parts[1]);
-                    S2Point center = S2LatLng::FromDegrees(query_lat, query_lng).ToPoint();
-                    query_region = new S2Cap(center, query_radius);
-                }
+            S2RegionTermIndexer::Options options;
+            options.set_index_contains_points_only(true);
+            S2RegionTermIndexer indexer(options);
 
-                S2RegionTermIndexer::Options options;
-                options.set_index_contains_points_only(true);
-                S2RegionTermIndexer indexer(options);
+            std::vector<uint32_t> geo_result_ids;
+            geopoint_index.at(a_filter.field_name)->collect(indexer.GetQueryTerms(*query_region, ""),
+                                                            geo_result_ids);
+
+            // `geo_result_ids` will contain all IDs that are within approximately within query radius
+            // we still need to do another round of exact filtering on them
 
-                for (const auto& term : indexer.GetQueryTerms(*query_region, "")) {
-                    auto geo_index = geopoint_index.at(a_filter.field_name);
-                    const auto& ids_it = geo_index->find(term);
-                    if(ids_it != geo_index->end()) {
-                        geo_result_ids.insert(ids_it->second.begin(), ids_it->second.end());
+            std::vector<uint32_t> exact_geo_result_ids;
+
+            if(f.is_single_geopoint()) {
+                // candidates are sorted, so the packed lat/lng column is read in seq_id order
+                for(auto result_id: geo_result_ids) {
+                    // no need to check for existence of `result_id` because of indexer based pre-filtering above
+                    int64_t lat_lng = sort_index.at(f.name)->at(result_id);
+                    S2LatLng s2_lat_lng;
+                    GeoPoint::unpack_lat_lng(lat_lng, s2_lat_lng);
+                    if (query_region->Contains(s2_lat_lng.ToPoint())) {
+                        exact_geo_result_ids.push_back(result_id);
                     }
                 }
+            } else {
+                for(auto result_id: geo_result_ids) {
+                    int64_t* lat_lngs = geo_array_index.at(f.name)->at(result_id);
 
-                // `geo_result_ids` will contain all IDs that are within approximately within query radius
-                // we still need to do another round of exact filtering on them
-
-                std::vector<uint32_t> exact_geo_result_ids;
+                    bool point_found = false;
 
-                if(f.is_single_geopoint()) {
-                    for(auto result_id: geo_result_ids) {
-                        // no need to check for existence of `result_id` because of indexer based pre-filtering above
-                        int64_t lat_lng = sort_index.at(f.name)->at(result_id);
+                    // any one point should exist
+                    for(size_t li = 0; li < lat_lngs[0]; li++) {
+                        int64_t lat_lng = lat_lngs[li + 1];
                         S2LatLng s2_lat_lng;
                         GeoPoint::unpack_lat_lng(lat_lng, s2_lat_lng);
                         if (query_region->Contains(s2_lat_lng.ToPoint())) {
-                            exact_geo_result_ids.push_back(result_id);
+                            point_found = true;
+                            break;
                         }
                     }
-                } else {
-                    for(auto result_id: geo_result_ids) {
-                        int64_t* lat_lngs = geo_array_index.at(f.name)->at(result_id);
-
-                        bool point_found = false;
-
-                        // any one point should exist
-                        for(size_t li = 0; li < lat_lngs[0]; li++) {
-                            int64_t lat_lng = lat_lngs[li + 1];
-                            S2LatLng s2_lat_lng;
-                            GeoPoint::unpack_lat_lng(lat_lng, s2_lat_lng);
-                            if (query_region->Contains(s2_lat_lng.ToPoint())) {
-                                point_found = true;
-                                break;
-                            }
-                        }
 
-                        if(point_found) {
-                            exact_geo_result_ids.push_back(result_id);
-                        }
+                    if(point_found) {
+                        exact_geo_result_ids.push_back(result_id);
                     }
                 }
-
-                std::sort(exact_geo_result_ids.begin(), exact_geo_result_ids.end());
-
-                uint32_t *out = nullptr;
-                result_ids_len = ArrayUtils::or_scalar(&exact_geo_result_ids[0], exact_geo_result_ids.size(),
-                                                       result_ids, result_ids_len, &out);
-
-                delete [] result_ids;
-                result_ids = out;
-
-                delete query_region;
             }
 
-        } else if(f.is_string()) {
-            art_tree* t = search_index.at(a_filter.field_name);
+            // `exact_geo_result_ids` stays sorted since candidates were iterated in order
+            uint32_t *out = nullptr;
+            result_ids_len = ArrayUtils::or_scalar(&exact_geo_result_ids[0], exact_geo_result_ids.size(),
+                                                   result_ids, result_ids_len, &out);
 
-            uint32_t* ids = nullptr;
-            size_t ids_size = 0;
+            delete [] result_ids;
+            result_ids = out;
 
-            for(const std::string & filter_value: a_filter.values) {
-                uint32_t* strt_ids = nullptr;
-                size_t strt_ids_size = 0;
+            delete query_region;
+        }
 
-                std::vector<void*> posting_lists;
+    } else if(f.is_string()) {
+        art_tree* t = search_index.at(a_filter.field_name);
 
-                // there could be multiple tokens in a filter value, which we have to treat as ANDs
-                // e.g. country: South Africa
+        uint32_t* ids = nullptr;
+        size_t ids_size = 0;
 
-                Tokenizer tokenizer(filter_value, true, false, f.locale, symbols_to_index, token_separators);
+        for(const std::string & filter_value: a_filter.values) {
+            uint32_t* strt_ids = nullptr;
+            size_t strt_ids_size = 0;
 
-                std::string str_token;
-                size_t token_index = 0;
-                std::vector<std::string> str_tokens;
+            std::vector<void*> posting_lists;
 
-                while(tokenizer.next(str_token, token_index)) {
-                    str_tokens.push_back(str_token);
+            // there could be multiple tokens in a filter value, which we have to treat as ANDs
+            // e.g. country: South Africa
 
-                    art_leaf* leaf = (art_leaf *) art_search(t, (const unsigned char*) str_token.c_str(),
-                                                             str_token.length()+1);
-                    if(leaf == nullptr) {
-                        continue;
-                    }
+            Tokenizer tokenizer(filter_value, true, false, f.locale, symbols_to_index, token_separators);
 
-                    posting_lists.push_back(leaf->values);
-                }
+            std::string str_token;
+            size_t token_index = 0;
+            std::vector<std::string> str_tokens;
+
+            while(tokenizer.next(str_token, token_index)) {
+                str_tokens.push_back(str_token);
 
-                // For NOT_EQUALS alone, it is okay for none of the results to match prior to negation
-                // e.g. field:!= [RANDOM_NON_EXISTING_STRING]
-                if(a_filter.comparators[0] != NOT_EQUALS && posting_lists.size() != str_tokens.size()) {
+                art_leaf* leaf = (art_leaf *) art_search(t, (const unsigned char*) str_token.c_str(),
+                                                         str_token.length()+1);
+                if(leaf == nullptr) {
                     continue;
                 }
 
-                std::vector<uint32_t> result_id_vec;
-                posting_t::intersect(posting_lists, result_id_vec);
-                if(!result_id_vec.empty()) {
-                    strt_ids = new uint32_t [result_id_vec.size()];
-                    std::copy(result_id_vec.begin(), result_id_vec.end(), strt_ids);
-                    strt_ids_size = result_id_vec.size();
-                }
+                posting_lists.push_back(leaf->values);
+            }
+
+            // For NOT_EQUALS alone, it is okay for none of the results to match prior to negation
+            // e.g. field:!= [RANDOM_NON_EXISTING_STRING]
+            if(a_filter.comparators[0] != NOT_EQUALS && posting_lists.size() != str_tokens.size()) {
+                continue;
+            }
 
-                if(a_filter.comparators[0] == EQUALS || a_filter.comparators[0] == NOT_EQUALS) {
-                    // need to do exact match (unlike CONTAINS)
-                    uint32_t* exact_strt_ids = new uint32_t[strt_ids_size];
-                    size_t exact_strt_size = 0;
+            std::vector<uint32_t> result_id_vec;
+            posting_t::intersect(posting_lists, result_id_vec);
+            if(!result_id_vec.empty()) {
+                strt_ids = new uint32_t [result_id_vec.size()];
+                std::copy(result_id_vec.begin(), result_id_vec.end(), strt_ids);
+                strt_ids_size = result_id_vec.size();
+            }
 
-                    posting_t::get_exact_matches(posting_lists, f.is_array(), strt_ids, strt_ids_size,
-                                                 exact_strt_ids, exact_strt_size);
+            if(a_filter.comparators[0] == EQUALS || a_filter.comparators[0] == NOT_EQUALS) {
+                // need to do exact match (unlike CONTAINS)
+                uint32_t* exact_strt_ids = new uint32_t[strt_ids_size];
+                size_t exact_strt_size = 0;
 
-                    delete[] strt_ids;
-                    strt_ids = exact_strt_ids;
-                    strt_ids_size = exact_strt_size;
-                }
+                posting_t::get_exact_matches(posting_lists, f.is_array(), strt_ids, strt_ids_size,
+                                             exact_strt_ids, exact_strt_size);
 
-                if(a_filter.comparators[0] == NOT_EQUALS) {
-                    // exclude records from existing IDs (from previous filters or ALL records)
-                    // upstream will guarantee that NOT_EQUALS is placed right at the end of filters list
-                    if(ids == nullptr) {
-                        if(filter_ids == nullptr) {
-                            ids = seq_ids.uncompress();
-                            ids_size = seq_ids.getLength();
-                        } else {
-                            ids = filter_ids;
-                            ids_size = filter_ids_length;
-                        }
-                    }
+                delete[] strt_ids;
+                strt_ids = exact_strt_ids;
+                strt_ids_size = exact_strt_size;
+            }
 
-                    uint32_t* excluded_strt_ids = nullptr;
-                    size_t excluded_strt_size = 0;
-                    excluded_strt_size = ArrayUtils::exclude_scalar(ids, ids_size, strt_ids,
-                                                                    strt_ids_size, &excluded_strt_ids);
+            if(a_filter.comparators[0] == NOT_EQUALS) {
+                // exclude records from existing IDs (from previous filters or ALL records)
+                // upstream will guarantee that NOT_EQUALS is placed right at the end of filters list
+                const uint32_t* base_ids = ids;
+                size_t base_ids_size = ids_size;
 
-                    if(filter_ids == nullptr) {
-                        // means we had to uncompress `seq_ids` so need to free that
-                        delete [] ids;
+                if(base_ids == nullptr) {
+                    if(prior_ids == nullptr) {
+                        // borrow the shared live-id view instead of uncompressing `seq_ids`
+                        base_ids = get_live_ids(base_ids_size);
+                    } else {
+                        base_ids = prior_ids;
+                        base_ids_size = prior_ids_length;
                     }
+                }
 
-                    ids = excluded_strt_ids;
-                    ids_size = excluded_strt_size;
-                    delete[] strt_ids;
-                } else {
-                    // Otherwise, we just ensure that given record contains tokens in the filter query
-                    uint32_t* out = nullptr;
-                    ids_size = ArrayUtils::or_scalar(ids, ids_size, strt_ids, strt_ids_size, &out);
-                    delete[] strt_ids;
-                    delete[] ids;
-                    ids = out;
+                uint32_t* excluded_strt_ids = nullptr;
+                size_t excluded_strt_size = 0;
+                excluded_strt_size = ArrayUtils::exclude_scalar(base_ids, base_ids_size, strt_ids,
+                                                                strt_ids_size, &excluded_strt_ids);
+
+                if(ids != nullptr && prior_ids == nullptr) {
+                    // results accumulated from earlier filter values are owned by us
+                    delete [] ids;
                 }
+
+                ids = excluded_strt_ids;
+                ids_size = excluded_strt_size;
+                delete[] strt_ids;
+            } else {
+                // Otherwise, we just ensure that given record contains tokens in the filter query
+                uint32_t* out = nullptr;
+                ids_size = ArrayUtils::or_scalar(ids, ids_size, strt_ids, strt_ids_size, &out);
+                delete[] strt_ids;
+                delete[] ids;
+                ids = out;
             }
+        }
+
+        result_ids = ids;
+        result_ids_len = ids_size;
+    }
+
+    return true;
+}
+
+void Index::do_filtering_parallel(uint32_t*& filter_ids, uint32_t& filter_ids_length,
+                                  const std::vector<filter>& filters) const {
+    const size_t num_clauses = filters.size();
+
+    std::vector<uint32_t*> clause_ids(num_clauses, nullptr);
+    std::vector<size_t> clause_ids_lens(num_clauses, 0);
+    std::vector<char> clause_evaluated(num_clauses, 0);
+
+    size_t num_processed = 0;
+    std::mutex m_process;
+    std::condition_variable cv_process;
+
+    for(size_t ci = 0; ci < num_clauses; ci++) {
+        thread_pool->enqueue([this, ci, &filters, &clause_ids, &clause_ids_lens, &clause_evaluated,
+                              &num_processed, &m_process, &cv_process]() {
+            clause_evaluated[ci] = do_filtering_clause(filters[ci], nullptr, 0,
+                                                       clause_ids[ci], clause_ids_lens[ci]);
+
+            std::unique_lock<std::mutex> lock(m_process);
+            num_processed++;
+            cv_process.notify_one();
+        });
+    }
+
+    std::unique_lock<std::mutex> lock_process(m_process);
+    cv_process.wait(lock_process, [&](){ return num_processed == num_clauses; });
+    lock_process.unlock();
 
-            result_ids = ids;
-            result_ids_len = ids_size;
+    std::vector<uint32_t*> ids_list;
+    std::vector<size_t> ids_lens;
+
+    for(size_t ci = 0; ci < num_clauses; ci++) {
+        if(clause_evaluated[ci]) {
+            ids_list.push_back(clause_ids[ci]);
+            ids_lens.push_back(clause_ids_lens[ci]);
         }
+    }
 
-        if(i == 0) {
-            filter_ids = result_ids;
-            filter_ids_length = result_ids_len;
-        } else {
-            uint32_t* filtered_results = nullptr;
-            filter_ids_length = ArrayUtils::and_scalar(filter_ids, filter_ids_length, result_ids,
-                                                       result_ids_len, &filtered_results);
-            delete [] result_ids;
-            delete [] filter_ids;
-            filter_ids = filtered_results;
+    if(ids_list.empty()) {
+        return;
+    }
+
+    // log-depth pairwise intersection: every round halves the number of lists
+    // and the pairs of a round are intersected concurrently
+    while(ids_list.size() > 1) {
+        const size_t num_pairs = ids_list.size() / 2;
+
+        std::vector<uint32_t*> merged_ids(num_pairs, nullptr);
+        std::vector<size_t> merged_lens(num_pairs, 0);
+
+        num_processed = 0;
+
+        for(size_t pi = 0; pi < num_pairs; pi++) {
+            thread_pool->enqueue([pi, &ids_list, &ids_lens, &merged_ids, &merged_lens,
+                                  &num_processed, &m_process, &cv_process]() {
+                merged_lens[pi] = ArrayUtils::and_scalar(ids_list[2*pi], ids_lens[2*pi],
+                                                         ids_list[2*pi + 1], ids_lens[2*pi + 1],
+                                                         &merged_ids[pi]);
+                delete [] ids_list[2*pi];
+                delete [] ids_list[2*pi + 1];
+
+                std::unique_lock<std::mutex> lock(m_process);
+                num_processed++;
+                cv_process.notify_one();
+            });
+        }
+
+        std::unique_lock<std::mutex> lock_merge(m_process);
+        cv_process.wait(lock_merge, [&](){ return num_processed == num_pairs; });
+        lock_merge.unlock();
+
+        if(ids_list.size() % 2 != 0) {
+            merged_ids.push_back(ids_list.back());
+            merged_lens.push_back(ids_lens.back());
+        }
+
+        ids_list = std::move(merged_ids);
+        ids_lens = std::move(merged_lens);
+    }
+
+    filter_ids = ids_list[0];
+    filter_ids_length = ids_lens[0];
+}
+
+void Index::do_filtering(uint32_t*& filter_ids, uint32_t& filter_ids_length,
+                         const std::vector<filter>& filters,
+                         const bool enable_short_circuit) const {
+    //auto begin = std::chrono::high_resolution_clock::now();
+
+    const std::string cache_key = get_filter_cache_key(filters, enable_short_circuit);
+
+    if(!cache_key.empty() && filter_cache_get(cache_key, filter_ids, filter_ids_length)) {
+        AppMetrics::get_instance().increment_count(AppMetrics::FILTER_CACHE_HIT_LABEL, 1);
+        return;
+    }
+
+    bool parallelize = filters.size() > 1 && seq_ids.getLength() >= PARALLEL_FILTER_MIN_DOCS;
+
+    for(const auto& a_filter: filters) {
+        const auto& field_it = search_schema.find(a_filter.field_name);
+        if(field_it != search_schema.end() && field_it->second.is_string() &&
+           !a_filter.comparators.empty() && a_filter.comparators[0] == NOT_EQUALS) {
+            // a string `!=` clause subtracts from the result accumulated so far,
+            // so such a conjunction must be evaluated in order
+            parallelize = false;
+            break;
+        }
+    }
+
+    if(parallelize) {
+        do_filtering_parallel(filter_ids, filter_ids_length, filters);
+    } else {
+        for(size_t i = 0; i < filters.size(); i++) {
+            uint32_t* result_ids = nullptr;
+            size_t result_ids_len = 0;
+
+            if(!do_filtering_clause(filters[i], filter_ids, filter_ids_length, result_ids, result_ids_len)) {
+                continue;
+            }
+
+            if(i == 0) {
+                filter_ids = result_ids;
+                filter_ids_length = result_ids_len;
+            } else {
+                uint32_t* filtered_results = nullptr;
+                filter_ids_length = ArrayUtils::and_scalar(filter_ids, filter_ids_length, result_ids,
+                                                           result_ids_len, &filtered_results);
+                delete [] result_ids;
+                delete [] filter_ids;
+                filter_ids = filtered_results;
+            }
         }
     }
 
+    if(!cache_key.empty()) {
+        filter_cache_put(cache_key, filter_ids, filter_ids_length);
+        AppMetrics::get_instance().increment_count(AppMetrics::FILTER_CACHE_MISS_LABEL, 1);
+    }
+
     /*long long int timeMillis =
             std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - begin).count();
 
     LOG(INFO) << "Time taken for filtering: " << timeMillis << "ms";*/
 }
 
+std::string Index::get_filter_cache_key(const std::vector<filter>& filters, const bool enable_short_circuit) {
+    if(filters.empty()) {
+        return "";
+    }
+
+    std::vector<std::string> parts;
+    parts.reserve(filters.size());
+
+    for(const auto& a_filter: filters) {
+        std::string part = a_filter.field_name;
+
+        for(size_t i = 0; i < a_filter.values.size(); i++) {
+            part += "/";
+
+            if(i < a_filter.comparators.size()) {
+                part += std::to_string(a_filter.comparators[i]);
+                part += ":";
+            }
+
+            part += a_filter.values[i];
+        }
+
+        parts.push_back(part);
+    }
+
+    // filters are ANDed together, so the conjunction is order independent
+    std::sort(parts.begin(), parts.end());
+
+    std::string cache_key = enable_short_circuit ? "sc&&" : "";
+    for(const auto& part: parts) {
+        cache_key += part;
+        cache_key += "&&";
+    }
+
+    return cache_key;
+}
+
+bool Index::filter_cache_get(const std::string& cache_key, uint32_t*& filter_ids, uint32_t& filter_ids_length) const {
+    std::lock_guard<std::mutex> lock(filter_cache_mutex);
+
+    const auto& it = filter_cache.find(cache_key);
+    if(it == filter_cache.end()) {
+        return false;
+    }
+
+    filter_cache_entry_t* entry = it->second;
+
+    if(entry->watermark != write_watermark.load()) {
+        // a write happened after this entry was computed
+        filter_cache_lru.erase(entry->lru_it);
+        delete entry;
+        filter_cache.erase(it);
+        return false;
+    }
+
+    filter_cache_lru.splice(filter_cache_lru.begin(), filter_cache_lru, entry->lru_it);
+
+    filter_ids_length = entry->ids.getLength();
+    filter_ids = (filter_ids_length == 0) ? nullptr : entry->ids.uncompress();
+
+    return true;
+}
+
+void Index::filter_cache_put(const std::string& cache_key, const uint32_t* filter_ids,
+                             const uint32_t filter_ids_length) const {
+    std::lock_guard<std::mutex> lock(filter_cache_mutex);
+
+    if(filter_cache.find(cache_key) != filter_cache.end()) {
+        // a concurrent search has stored this expression already
+        return;
+    }
+
+    filter_cache_entry_t* entry = new filter_cache_entry_t();
+    entry->ids.load(filter_ids, filter_ids_length);
+    entry->watermark = write_watermark.load();
+
+    filter_cache_lru.push_front(cache_key);
+    entry->lru_it = filter_cache_lru.begin();
+    filter_cache.emplace(cache_key, entry);
+
+    if(filter_cache.size() > FILTER_CACHE_MAX_ENTRIES) {
+        const std::string& evicted_key = filter_cache_lru.back();
+        const auto& evicted_it = filter_cache.find(evicted_key);
+        delete evicted_it->second;
+        filter_cache.erase(evicted_it);
+        filter_cache_lru.pop_back();
+    }
+}
+
+void Index::materialized_filter_insert(const std::string& field_name, const int64_t value, const uint32_t seq_id) {
+    auto& value_to_ids = *materialized_filter_index.at(field_name);
+    std::vector<uint32_t>& ids = value_to_ids[value];
+
+    if(ids.empty() || seq_id > ids.back()) {
+        // seq_ids of fresh documents are monotonically increasing
+        ids.push_back(seq_id);
+        return;
+    }
+
+    // out-of-order ids show up only when older documents are re-indexed
+    const auto& it = std::lower_bound(ids.begin(), ids.end(), seq_id);
+    if(it == ids.end() || *it != seq_id) {
+        ids.insert(it, seq_id);
+    }
+}
+
+void Index::materialized_filter_remove(const std::string& field_name, const int64_t value, const uint32_t seq_id) {
+    auto& value_to_ids = *materialized_filter_index.at(field_name);
+    const auto& value_it = value_to_ids.find(value);
+
+    if(value_it == value_to_ids.end()) {
+        return;
+    }
+
+    std::vector<uint32_t>& ids = value_it->second;
+    const auto& id_it = std::lower_bound(ids.begin(), ids.end(), seq_id);
+
+    if(id_it != ids.end() && *id_it == seq_id) {
+        ids.erase(id_it);
+    }
+
+    if(ids.empty()) {
+        value_to_ids.erase(value_it);
+    }
+}
+
+void Index::materialized_filter_fetch(const std::string& field_name, const int64_t value,
+                                      uint32_t** ids, size_t& ids_len) const {
+    const auto& value_to_ids = *materialized_filter_index.at(field_name);
+    const auto& value_it = value_to_ids.find(value);
+
+    if(value_it == value_to_ids.end()) {
+        return;
+    }
+
+    const std::vector<uint32_t>& value_ids = value_it->second;
+
+    uint32_t* out = nullptr;
+    ids_len = ArrayUtils::or_scalar(&value_ids[0], value_ids.size(), *ids, ids_len, &out);
+
+    delete [] *ids;
+    *ids = out;
+}
 
 void Index::do_filtering_with_lock(uint32_t*& filter_ids, uint32_t& filter_ids_length,
                                    const std::vector<filter>& filters) const {
@@ -1611,7 +2396,11 @@ void Index::run_search(search_args* search_params) {
            search_params->concurrency,
            search_params->search_cutoff_ms,
            search_params->min_len_1typo,
-           search_params->min_len_2typo);
+           search_params->min_len_2typo,
+           search_params->facet_sample_percent,
+           search_params->facet_sample_threshold,
+           search_params->kv_arena,
+           search_params->timings);
 }
 
 void Index::collate_included_ids(const std::vector<std::string>& q_included_tokens,
@@ -1670,19 +2459,31 @@ void Index::collate_included_ids(const std::vector<std::string>& q_included_toke
     searched_queries.push_back(override_query);
 }
 
-void Index::concat_topster_ids(Topster* topster, spp::sparse_hash_map<uint64_t, std::vector<KV*>>& topster_ids) {
+void Index::concat_topster_ids(Topster* topster, spp::sparse_hash_map<uint64_t, arena_kv_list_t>& topster_ids,
+                               arena_t& kv_arena) {
+    // the lists live for the rest of the search, so they are bump-allocated
+    // from the per-search arena instead of paying a malloc per document
+    const auto append_kv = [&topster_ids, &kv_arena](const uint64_t key, KV* kv) {
+        auto it = topster_ids.find(key);
+
+        if(it == topster_ids.end()) {
+            it = topster_ids.emplace(key, arena_kv_list_t(arena_allocator<KV*>(&kv_arena))).first;
+        }
+
+        it->second.push_back(kv);
+    };
+
     if(topster->distinct) {
-        for(auto &group_topster_entry: topster->group_kv_map) {
-            Topster* group_topster = group_topster_entry.second;
-            for(const auto& map_kv: group_topster->kv_map) {
-                topster_ids[map_kv.first].push_back(map_kv.second);
+        for(auto& slot: topster->group_map->slots) {
+            for(uint32_t i = 0; i < slot.size; i++) {
+                append_kv(slot.kvs[i].key, &slot.kvs[i]);
             }
         }
     } else {
         for(const auto& map_kv: topster->kv_map) {
             //LOG(INFO) << "map_kv.second.key: " << map_kv.second->key;
             //LOG(INFO) << "map_kv.first: " << map_kv.first;
-            topster_ids[map_kv.first].push_back(map_kv.second);
+            append_kv(map_kv.first, map_kv.second);
         }
     }
 }
@@ -1954,7 +2755,7 @@ bool Index::check_for_overrides(const token_ordering& token_order, const string&
             }
 
             search_field(0, window_tokens, search_tokens, nullptr, 0, num_toks_dropped, field_it->second, field_name,
-                         nullptr, 0, {}, {}, 2, searched_queries, topster, groups_processed,
+                         nullptr, 0, {}, {}, "", 2, searched_queries, topster, groups_processed,
                          &result_ids, result_ids_len, field_num_results, 0, group_by_fields,
                          false, 4, query_hashes, token_order, false, 0, 1, false, 3, 7);
 
@@ -1986,6 +2787,12 @@ bool Index::check_for_overrides(const token_ordering& token_order, const string&
     return false;
 }
 
+// elapsed wall-clock micros of a search stage, accumulated into search_stage_timings_t
+static inline uint64_t stage_micros(const std::chrono::high_resolution_clock::time_point& begin) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - begin).count();
+}
+
 void Index::search(std::vector<query_tokens_t>& field_query_tokens,
                    const std::vector<search_field_t>& search_fields,
                    std::vector<filter>& filters,
@@ -2012,9 +2819,14 @@ void Index::search(std::vector<query_tokens_t>& field_query_tokens,
                    const size_t concurrency,
                    const size_t search_cutoff_ms,
                    size_t min_len_1typo,
-                   size_t min_len_2typo) const {
+                   size_t min_len_2typo,
+                   const size_t facet_sample_percent,
+                   const size_t facet_sample_threshold,
+                   arena_t& kv_arena,
+                   search_stage_timings_t& timings) const {
 
     search_begin = std::chrono::high_resolution_clock::now();
+    auto stage_begin = search_begin;
     search_stop_ms = search_cutoff_ms;
     search_cutoff = false;
 
@@ -2023,7 +2835,12 @@ void Index::search(std::vector<query_tokens_t>& field_query_tokens,
     uint32_t* filter_ids = nullptr;
     uint32_t filter_ids_length = 0;
 
-    std::shared_lock lock(mutex);
+    // whether `filter_ids` points at an allocation we must free, or borrows the
+    // shared live-id view (see curate_filtered_ids)
+    bool filter_ids_owned = true;
+
+    // NOTE: the caller already holds the read lock (via `get_search_lock()`),
+    // since searched query leaves are dereferenced even after search returns
 
     // we will be removing all curated IDs from organic result ids before running topster
     std::set<uint32_t> curated_ids;
@@ -2045,6 +2862,9 @@ void Index::search(std::vector<query_tokens_t>& field_query_tokens,
 
     do_filtering(filter_ids, filter_ids_length, filters, true);
 
+    timings.filter_us += stage_micros(stage_begin);
+    stage_begin = std::chrono::high_resolution_clock::now();
+
     // Order of `fields` are used to sort results
     //auto begin = std::chrono::high_resolution_clock::now();
     uint32_t* all_result_ids = nullptr;
@@ -2090,62 +2910,251 @@ void Index::search(std::vector<query_tokens_t>& field_query_tokens,
         const std::string& field = search_fields[0].name;
 
         curate_filtered_ids(filters, curated_ids, exclude_token_ids,
-                            exclude_token_ids_size, filter_ids, filter_ids_length, curated_ids_sorted);
+                            exclude_token_ids_size, filter_ids, filter_ids_length, filter_ids_owned,
+                            curated_ids_sorted);
 
         search_wildcard(field_query_tokens[0].q_include_tokens, filters, included_ids_map, sort_fields_std, topster,
                         curated_topster, groups_processed, searched_queries, group_limit, group_by_fields,
                         curated_ids, curated_ids_sorted,
                         exclude_token_ids, exclude_token_ids_size, field_id, field,
                         all_result_ids, all_result_ids_len, filter_ids, filter_ids_length, concurrency);
+
+        timings.candidates_us += stage_micros(stage_begin);
+        stage_begin = std::chrono::high_resolution_clock::now();
     } else {
         // In multi-field searches, a record can be matched across different fields, so we use this for aggregation
-        spp::sparse_hash_map<uint64_t, std::vector<KV*>> topster_ids;
+        spp::sparse_hash_map<uint64_t, arena_kv_list_t> topster_ids;
 
         //begin = std::chrono::high_resolution_clock::now();
 
-        // non-wildcard
+        // a synonym can be rewritten into a wildcard by an override filter; that path
+        // curates shared filter state mid-flight, so such queries stay on the serial walk
+        bool has_wildcard_synonym = false;
         for(size_t i = 0; i < num_search_fields; i++) {
-            std::vector<token_t> q_include_pos_tokens;
-            for(size_t j=0; j < field_query_tokens[i].q_include_tokens.size(); j++) {
-                bool is_prefix = (j == field_query_tokens[i].q_include_tokens.size()-1);
-                q_include_pos_tokens.emplace_back(j, field_query_tokens[i].q_include_tokens[j], is_prefix);
-            }
-
-            std::vector<std::vector<token_t>> q_pos_synonyms;
             for(const auto& q_syn_vec: field_query_tokens[i].q_synonyms) {
-                std::vector<token_t> q_pos_syn;
-                for(size_t j=0; j < q_syn_vec.size(); j++) {
-                    bool is_prefix = (j == q_syn_vec.size()-1);
-                    q_pos_syn.emplace_back(j, q_syn_vec[j], is_prefix);
+                if(q_syn_vec.size() == 1 && q_syn_vec[0] == "*") {
+                    has_wildcard_synonym = true;
                 }
-                q_pos_synonyms.emplace_back(q_pos_syn);
             }
+        }
 
-            // num_typos is already validated upstream, but still playing safe
-            int field_num_typos = (i < num_typos.size()) ? num_typos[i] : num_typos[0];
+        bool fields_searched_in_parallel = false;
 
-            bool field_prefix = (i < prefixes.size()) ? prefixes[i] : prefixes[0];
+        if(num_search_fields > 1 && !has_wildcard_synonym && (filters.empty() || filter_ids_length > 0)) {
+            // dispatch independent per-field searches onto the thread pool: per-field
+            // topsters, searched queries, groups and result ids are kept isolated and
+            // merged in field order afterwards. The workers intersect their posting
+            // lists inline (concurrency 1), so they never block on nested pool tasks.
+            fields_searched_in_parallel = true;
 
-            // proceed to query search only when no filters are provided or when filtering produces results
-            if(filters.empty() || filter_ids_length > 0) {
+            std::vector<std::vector<std::vector<art_leaf*>>> field_searched_queries(num_search_fields);
+            std::vector<spp::sparse_hash_set<uint64_t>> field_groups_processed(num_search_fields);
+            std::vector<uint32_t*> field_result_ids(num_search_fields, nullptr);
+            std::vector<size_t> field_result_ids_lens(num_search_fields, 0);
+            std::vector<Topster*> field_topsters(num_search_fields, nullptr);
+
+            const auto parent_search_begin = search_begin;
+            const auto parent_search_stop_ms = search_stop_ms;
+            auto parent_search_cutoff = search_cutoff;
+
+            size_t num_queued = 0;
+            size_t num_processed = 0;
+            std::mutex m_process;
+            std::condition_variable cv_process;
+
+            auto search_single_field = [&](size_t i, const field& the_field) {
                 const uint8_t field_id = (uint8_t)(FIELD_LIMIT_NUM - i);
                 const std::string& field_name = search_fields[i].name;
 
-                auto field_it = search_schema.find(field_name);
-                if(field_it == search_schema.end()) {
-                    continue;
+                std::vector<token_t> q_include_pos_tokens;
+                for(size_t j=0; j < field_query_tokens[i].q_include_tokens.size(); j++) {
+                    bool is_prefix = (j == field_query_tokens[i].q_include_tokens.size()-1);
+                    q_include_pos_tokens.emplace_back(j, field_query_tokens[i].q_include_tokens[j], is_prefix);
                 }
 
+                int field_num_typos = (i < num_typos.size()) ? num_typos[i] : num_typos[0];
+                bool field_prefix = (i < prefixes.size()) ? prefixes[i] : prefixes[0];
+
                 std::vector<token_t> query_tokens = q_include_pos_tokens;
                 std::vector<token_t> search_tokens = q_include_pos_tokens;
                 size_t num_tokens_dropped = 0;
+                size_t field_num_results = 0;
+                std::set<uint64> query_hashes;
 
-                //LOG(INFO) << "searching field_name! " << field_name;
-                Topster* ftopster = new Topster(topster->MAX_SIZE, topster->distinct);
-                ftopsters.push_back(ftopster);
-
-                // Don't waste additional cycles for single field_name searches
-                Topster* actual_topster = (num_search_fields == 1) ? topster : ftopster;
+                search_field(field_id, query_tokens, search_tokens, exclude_token_ids, exclude_token_ids_size,
+                             num_tokens_dropped, the_field, field_name,
+                             filter_ids, filter_ids_length, curated_ids_sorted, sort_fields_std, default_sorting_field,
+                             field_num_typos, field_searched_queries[i], field_topsters[i], field_groups_processed[i],
+                             &field_result_ids[i], field_result_ids_lens[i],
+                             field_num_results, group_limit, group_by_fields, prioritize_exact_match, 1,
+                             query_hashes, token_order, field_prefix,
+                             drop_tokens_threshold, typo_tokens_threshold, exhaustive_search,
+                             min_len_1typo, min_len_2typo);
+
+                // do synonym based searches (wildcard synonyms never reach this path)
+                for(const auto& q_syn_vec: field_query_tokens[i].q_synonyms) {
+                    std::vector<token_t> syn_tokens;
+                    for(size_t j=0; j < q_syn_vec.size(); j++) {
+                        bool is_prefix = (j == q_syn_vec.size()-1);
+                        syn_tokens.emplace_back(j, q_syn_vec[j], is_prefix);
+                    }
+
+                    num_tokens_dropped = 0;
+                    field_num_results = 0;
+                    query_tokens = search_tokens = syn_tokens;
+                    query_hashes.clear();
+
+                    search_field(field_id, query_tokens, search_tokens, exclude_token_ids, exclude_token_ids_size,
+                                 num_tokens_dropped, the_field, field_name,
+                                 filter_ids, filter_ids_length, curated_ids_sorted, sort_fields_std, default_sorting_field,
+                                 field_num_typos, field_searched_queries[i], field_topsters[i], field_groups_processed[i],
+                                 &field_result_ids[i], field_result_ids_lens[i],
+                                 field_num_results, group_limit, group_by_fields, prioritize_exact_match, 1,
+                                 query_hashes, token_order, field_prefix,
+                                 drop_tokens_threshold, typo_tokens_threshold, exhaustive_search,
+                                 min_len_1typo, min_len_2typo);
+                }
+            };
+
+            std::vector<std::pair<size_t, const field*>> pending_fields;
+            for(size_t i = 0; i < num_search_fields; i++) {
+                const auto field_it = search_schema.find(search_fields[i].name);
+                if(field_it == search_schema.end()) {
+                    continue;
+                }
+
+                field_topsters[i] = new Topster(topster->MAX_SIZE, topster->distinct);
+                field_topsters[i]->after_bound = topster->after_bound;
+                ftopsters.push_back(field_topsters[i]);
+                pending_fields.emplace_back(i, &field_it->second);
+            }
+
+            // all fields but the last go to the pool; the last one runs inline on the
+            // calling thread, which would otherwise just sleep on the condition variable
+            for(size_t t = 0; t + 1 < pending_fields.size(); t++) {
+                const size_t i = pending_fields[t].first;
+                const field* the_field = pending_fields[t].second;
+                num_queued++;
+
+                thread_pool->enqueue([&, i, the_field]() {
+                    search_begin = parent_search_begin;
+                    search_stop_ms = parent_search_stop_ms;
+                    search_cutoff = false;
+
+                    search_single_field(i, *the_field);
+
+                    std::unique_lock<std::mutex> lock(m_process);
+                    num_processed++;
+                    parent_search_cutoff = parent_search_cutoff || search_cutoff;
+                    cv_process.notify_one();
+                });
+            }
+
+            if(!pending_fields.empty()) {
+                search_cutoff = false;
+                search_single_field(pending_fields.back().first, *pending_fields.back().second);
+                std::unique_lock<std::mutex> lock(m_process);
+                parent_search_cutoff = parent_search_cutoff || search_cutoff;
+            }
+
+            std::unique_lock<std::mutex> lock_process(m_process);
+            cv_process.wait(lock_process, [&](){ return num_processed == num_queued; });
+            lock_process.unlock();
+
+            search_cutoff = parent_search_cutoff;
+
+            for(size_t i = 0; i < num_search_fields; i++) {
+                if(field_topsters[i] == nullptr) {
+                    continue;
+                }
+
+                // per-field KVs hold indices into their field's searched queries: rebase
+                // them onto the shared list before the KVs are aggregated
+                const size_t query_index_offset = searched_queries.size();
+                searched_queries.insert(searched_queries.end(), field_searched_queries[i].begin(),
+                                        field_searched_queries[i].end());
+
+                Topster* ftopster = field_topsters[i];
+
+                if(ftopster->distinct != 0) {
+                    for(auto& slot: ftopster->group_map->slots) {
+                        if(slot.kvs == nullptr) {
+                            continue;
+                        }
+
+                        for(uint32_t j = 0; j < slot.size; j++) {
+                            slot.kvs[j].query_index += query_index_offset;
+                        }
+                    }
+                } else {
+                    for(uint32_t j = 0; j < ftopster->size; j++) {
+                        ftopster->kvs[j]->query_index += query_index_offset;
+                    }
+                }
+
+                groups_processed.insert(field_groups_processed[i].begin(), field_groups_processed[i].end());
+
+                if(field_result_ids[i] != nullptr) {
+                    uint32_t* merged_result_ids = nullptr;
+                    all_result_ids_len = ArrayUtils::or_scalar(all_result_ids, all_result_ids_len,
+                                                               field_result_ids[i], field_result_ids_lens[i],
+                                                               &merged_result_ids);
+                    delete[] all_result_ids;
+                    all_result_ids = merged_result_ids;
+                    delete[] field_result_ids[i];
+                }
+
+                concat_topster_ids(ftopster, topster_ids, kv_arena);
+                collate_included_ids(field_query_tokens[i].q_include_tokens, search_fields[i].name,
+                                     (uint8_t)(FIELD_LIMIT_NUM - i), included_ids_map, curated_topster,
+                                     searched_queries);
+            }
+        }
+
+        // non-wildcard
+        for(size_t i = 0; i < num_search_fields && !fields_searched_in_parallel; i++) {
+            std::vector<token_t> q_include_pos_tokens;
+            for(size_t j=0; j < field_query_tokens[i].q_include_tokens.size(); j++) {
+                bool is_prefix = (j == field_query_tokens[i].q_include_tokens.size()-1);
+                q_include_pos_tokens.emplace_back(j, field_query_tokens[i].q_include_tokens[j], is_prefix);
+            }
+
+            std::vector<std::vector<token_t>> q_pos_synonyms;
+            for(const auto& q_syn_vec: field_query_tokens[i].q_synonyms) {
+                std::vector<token_t> q_pos_syn;
+                for(size_t j=0; j < q_syn_vec.size(); j++) {
+                    bool is_prefix = (j == q_syn_vec.size()-1);
+                    q_pos_syn.emplace_back(j, q_syn_vec[j], is_prefix);
+                }
+                q_pos_synonyms.emplace_back(q_pos_syn);
+            }
+
+            // num_typos is already validated upstream, but still playing safe
+            int field_num_typos = (i < num_typos.size()) ? num_typos[i] : num_typos[0];
+
+            bool field_prefix = (i < prefixes.size()) ? prefixes[i] : prefixes[0];
+
+            // proceed to query search only when no filters are provided or when filtering produces results
+            if(filters.empty() || filter_ids_length > 0) {
+                const uint8_t field_id = (uint8_t)(FIELD_LIMIT_NUM - i);
+                const std::string& field_name = search_fields[i].name;
+
+                auto field_it = search_schema.find(field_name);
+                if(field_it == search_schema.end()) {
+                    continue;
+                }
+
+                std::vector<token_t> query_tokens = q_include_pos_tokens;
+                std::vector<token_t> search_tokens = q_include_pos_tokens;
+                size_t num_tokens_dropped = 0;
+
+                //LOG(INFO) << "searching field_name! " << field_name;
+                Topster* ftopster = new Topster(topster->MAX_SIZE, topster->distinct);
+                ftopster->after_bound = topster->after_bound;
+                ftopsters.push_back(ftopster);
+
+                // Don't waste additional cycles for single field_name searches
+                Topster* actual_topster = (num_search_fields == 1) ? topster : ftopster;
 
                 // tracks the number of results found for the current field_name
                 size_t field_num_results = 0;
@@ -2153,7 +3162,7 @@ void Index::search(std::vector<query_tokens_t>& field_query_tokens,
 
                 search_field(field_id, query_tokens, search_tokens, exclude_token_ids, exclude_token_ids_size,
                              num_tokens_dropped, field_it->second, field_name,
-                             filter_ids, filter_ids_length, curated_ids_sorted, sort_fields_std,
+                             filter_ids, filter_ids_length, curated_ids_sorted, sort_fields_std, default_sorting_field,
                              field_num_typos, searched_queries, actual_topster, groups_processed, &all_result_ids, all_result_ids_len,
                              field_num_results, group_limit, group_by_fields, prioritize_exact_match, concurrency,
                              query_hashes, token_order, field_prefix,
@@ -2175,7 +3184,8 @@ void Index::search(std::vector<query_tokens_t>& field_query_tokens,
 
                         if(!syn_wildcard_filter_init_done) {
                             curate_filtered_ids(filters, curated_ids, exclude_token_ids, exclude_token_ids_size,
-                                                filter_ids, filter_ids_length, curated_ids_sorted);
+                                                filter_ids, filter_ids_length, filter_ids_owned,
+                                                curated_ids_sorted);
                             syn_wildcard_filter_init_done = true;
                         }
 
@@ -2187,7 +3197,8 @@ void Index::search(std::vector<query_tokens_t>& field_query_tokens,
                                         all_result_ids, all_result_ids_len, filter_ids, filter_ids_length, concurrency);
                     } else {
                         search_field(field_id, query_tokens, search_tokens, exclude_token_ids, exclude_token_ids_size, num_tokens_dropped,
-                                     field_it->second, field_name, filter_ids, filter_ids_length, curated_ids_sorted, sort_fields_std,
+                                     field_it->second, field_name, filter_ids, filter_ids_length, curated_ids_sorted,
+                                     sort_fields_std, default_sorting_field,
                                      field_num_typos, searched_queries, actual_topster, groups_processed, &all_result_ids, all_result_ids_len,
                                      field_num_results, group_limit, group_by_fields, prioritize_exact_match, concurrency,
                                      query_hashes, token_order, field_prefix,
@@ -2197,12 +3208,15 @@ void Index::search(std::vector<query_tokens_t>& field_query_tokens,
                 }
 
                 // concat is done only for multi-field searches as `ftopster` will be empty for single-field search
-                concat_topster_ids(ftopster, topster_ids);
+                concat_topster_ids(ftopster, topster_ids, kv_arena);
                 collate_included_ids(field_query_tokens[i].q_include_tokens, field_name, field_id, included_ids_map, curated_topster, searched_queries);
                 //LOG(INFO) << "topster_ids.size: " << topster_ids.size();
             }
         }
 
+        timings.candidates_us += stage_micros(stage_begin);
+        stage_begin = std::chrono::high_resolution_clock::now();
+
         //auto begin0 = std::chrono::high_resolution_clock::now();
 
         for(auto& seq_id_kvs: topster_ids) {
@@ -2210,7 +3224,7 @@ void Index::search(std::vector<query_tokens_t>& field_query_tokens,
             auto& kvs = seq_id_kvs.second; // each `kv` can be from a different field
 
             std::sort(kvs.begin(), kvs.end(), Topster::is_greater);
-            kvs[0]->query_indices = new uint64_t[kvs.size() + 1];
+            kvs[0]->query_indices = static_cast<uint64_t*>(kv_arena.alloc((kvs.size() + 1) * sizeof(uint64_t)));
             kvs[0]->query_indices[0] = kvs.size();
 
             //LOG(INFO) << "DOC ID: " << seq_id << ", score: " << kvs[0]->scores[kvs[0]->match_score_index];
@@ -2389,6 +3403,9 @@ void Index::search(std::vector<query_tokens_t>& field_query_tokens,
                 std::chrono::high_resolution_clock::now() - begin0).count();
 
         LOG(INFO) << "Time taken for multi-field aggregation: " << timeMillis0 << "ms";*/
+
+        timings.score_us += stage_micros(stage_begin);
+        stage_begin = std::chrono::high_resolution_clock::now();
     }
 
     //LOG(INFO) << "topster size: " << topster->size;
@@ -2396,105 +3413,172 @@ void Index::search(std::vector<query_tokens_t>& field_query_tokens,
     delete [] exclude_token_ids;
 
     if(!facets.empty()) {
-        const size_t num_threads = std::min(concurrency, all_result_ids_len);
-        const size_t window_size = (num_threads == 0) ? 0 :
-                                   (all_result_ids_len + num_threads - 1) / num_threads;  // rounds up
-        size_t num_processed = 0;
-        std::mutex m_process;
-        std::condition_variable cv_process;
-
         std::vector<facet_info_t> facet_infos(facets.size());
         compute_facet_infos(facets, facet_query, all_result_ids, all_result_ids_len,
                                      group_by_fields, facet_infos);
 
-        std::vector<std::vector<facet>> facet_batches(num_threads);
-        for(size_t i = 0; i < num_threads; i++) {
-            for(const auto& this_facet: facets) {
-                facet_batches[i].emplace_back(facet(this_facet.field_name));
+        // a result set covering the whole index (unfiltered wildcard queries)
+        // has facet counts that only change on writes, so they are kept per
+        // field and reused until the next write invalidates them
+        const uint64_t facets_watermark = write_watermark.load();
+
+        // when the result set is large enough, count only every `sample_stride`th
+        // result id and scale the counts back up: on uniform data a 1% sample is
+        // within a fraction of a percent of the exact counts at a fraction of the
+        // cost, and the response marks such counts as sampled
+        const bool sample_facets = facet_sample_percent < 100 && group_limit == 0 &&
+                                   all_result_ids_len > facet_sample_threshold;
+        const size_t sample_stride = sample_facets ? (100 / facet_sample_percent) : 1;
+
+        // sampled counts are estimates, so they never enter the facet cache
+        bool facets_cacheable = (group_limit == 0) && !sample_facets &&
+                                (all_result_ids_len == seq_ids.getLength());
+
+        for(size_t fi = 0; fi < facets.size() && facets_cacheable; fi++) {
+            if(facets[fi].approx || facet_infos[fi].use_facet_query) {
+                facets_cacheable = false;
             }
         }
 
-        size_t num_queued = 0;
-        size_t result_index = 0;
+        bool facets_served_from_cache = false;
+
+        if(facets_cacheable) {
+            std::unique_lock<std::mutex> cache_lock(facet_cache_mutex);
+            facets_served_from_cache = true;
+
+            for(const auto& a_facet: facets) {
+                const auto cache_it = facet_cache.find(a_facet.field_name);
+                if(cache_it == facet_cache.end() || cache_it->second.watermark != facets_watermark) {
+                    facets_served_from_cache = false;
+                    break;
+                }
+            }
 
-        //auto beginF = std::chrono::high_resolution_clock::now();
+            if(facets_served_from_cache) {
+                for(auto& a_facet: facets) {
+                    const auto& cache_entry = facet_cache.at(a_facet.field_name);
+                    a_facet.result_map = cache_entry.result_map;
+                    a_facet.stats = cache_entry.stats;
+                }
+            }
+        }
 
-        for(size_t thread_id = 0; thread_id < num_threads && result_index < all_result_ids_len; thread_id++) {
-            size_t batch_res_len = window_size;
+        if(!facets_served_from_cache) {
+            const size_t num_threads = std::min(concurrency, all_result_ids_len);
+            const size_t window_size = (num_threads == 0) ? 0 :
+                                       (all_result_ids_len + num_threads - 1) / num_threads;  // rounds up
+            size_t num_processed = 0;
+            std::mutex m_process;
+            std::condition_variable cv_process;
 
-            if(result_index + window_size > all_result_ids_len) {
-                batch_res_len = all_result_ids_len - result_index;
+            std::vector<std::vector<facet>> facet_batches(num_threads);
+            for(size_t i = 0; i < num_threads; i++) {
+                for(const auto& this_facet: facets) {
+                    facet_batches[i].emplace_back(facet(this_facet.field_name, this_facet.approx));
+                }
             }
 
-            uint32_t* batch_result_ids = all_result_ids + result_index;
-            num_queued++;
+            size_t num_queued = 0;
+            size_t result_index = 0;
 
-            thread_pool->enqueue([this, thread_id, &facet_batches, &facet_query, group_limit, group_by_fields,
-                                         batch_result_ids, batch_res_len, &facet_infos,
-                                         &num_processed, &m_process, &cv_process]() {
-                auto fq = facet_query;
-                do_facets(facet_batches[thread_id], fq, facet_infos, group_limit, group_by_fields,
-                          batch_result_ids, batch_res_len);
-                std::unique_lock<std::mutex> lock(m_process);
-                num_processed++;
-                cv_process.notify_one();
-            });
+            //auto beginF = std::chrono::high_resolution_clock::now();
 
-            result_index += batch_res_len;
-        }
+            for(size_t thread_id = 0; thread_id < num_threads && result_index < all_result_ids_len; thread_id++) {
+                size_t batch_res_len = window_size;
 
-        std::unique_lock<std::mutex> lock_process(m_process);
-        cv_process.wait(lock_process, [&](){ return num_processed == num_queued; });
+                if(result_index + window_size > all_result_ids_len) {
+                    batch_res_len = all_result_ids_len - result_index;
+                }
+
+                uint32_t* batch_result_ids = all_result_ids + result_index;
+                num_queued++;
+
+                thread_pool->enqueue([this, thread_id, &facet_batches, &facet_query, group_limit, group_by_fields,
+                                             batch_result_ids, batch_res_len, &facet_infos, sample_stride,
+                                             &num_processed, &m_process, &cv_process]() {
+                    auto fq = facet_query;
+                    do_facets(facet_batches[thread_id], fq, facet_infos, group_limit, group_by_fields,
+                              batch_result_ids, batch_res_len, sample_stride);
+                    std::unique_lock<std::mutex> lock(m_process);
+                    num_processed++;
+                    cv_process.notify_one();
+                });
+
+                result_index += batch_res_len;
+            }
 
-        for(auto& facet_batch: facet_batches) {
-            for(size_t fi = 0; fi < facet_batch.size(); fi++) {
-                auto& this_facet = facet_batch[fi];
-                auto& acc_facet = facets[fi];
+            std::unique_lock<std::mutex> lock_process(m_process);
+            cv_process.wait(lock_process, [&](){ return num_processed == num_queued; });
+
+            // merge the per-thread facet maps pairwise on the thread pool (tree
+            // reduction, like aggregate_topster does for hits): a sequential fold
+            // over the batches can outlast the counting itself on high-cardinality
+            // fields, while pairwise merging finishes in log2(batches) rounds
+            for(size_t merge_step = 1; merge_step < facet_batches.size(); merge_step *= 2) {
+                size_t num_merges_queued = 0;
+                size_t num_merges_done = 0;
+
+                for(size_t i = 0; i + merge_step < facet_batches.size(); i += 2 * merge_step) {
+                    num_merges_queued++;
+
+                    thread_pool->enqueue([&facet_batches, i, merge_step, group_limit,
+                                                 &num_merges_done, &m_process, &cv_process]() {
+                        aggregate_facets(facet_batches[i], facet_batches[i + merge_step], group_limit);
+                        std::unique_lock<std::mutex> lock(m_process);
+                        num_merges_done++;
+                        cv_process.notify_one();
+                    });
+                }
 
-                for(auto & facet_kv: this_facet.result_map) {
-                    if(group_limit) {
-                        // we have to add all group sets
-                        acc_facet.hash_groups[facet_kv.first].insert(
-                            this_facet.hash_groups[facet_kv.first].begin(),
-                            this_facet.hash_groups[facet_kv.first].end()
-                        );
-                    } else {
-                        size_t count = 0;
-                        if(acc_facet.result_map.count(facet_kv.first) == 0) {
-                            // not found, so set it
-                            count = facet_kv.second.count;
-                        } else {
-                            count = acc_facet.result_map[facet_kv.first].count + facet_kv.second.count;
-                        }
-                        acc_facet.result_map[facet_kv.first].count = count;
+                std::unique_lock<std::mutex> lock_merge(m_process);
+                cv_process.wait(lock_merge, [&](){ return num_merges_done == num_merges_queued; });
+            }
+
+            if(!facet_batches.empty()) {
+                aggregate_facets(facets, facet_batches[0], group_limit);
+            }
+
+            if(sample_facets) {
+                for(auto& acc_facet: facets) {
+                    for(auto& facet_kv: acc_facet.result_map) {
+                        facet_kv.second.count *= sample_stride;
                     }
 
-                    acc_facet.result_map[facet_kv.first].doc_id = facet_kv.second.doc_id;
-                    acc_facet.result_map[facet_kv.first].array_pos = facet_kv.second.array_pos;
-                    acc_facet.hash_tokens[facet_kv.first] = this_facet.hash_tokens[facet_kv.first];
+                    // min/max remain those of the sample, only the additive stats scale
+                    acc_facet.stats.fvcount *= sample_stride;
+                    acc_facet.stats.fvsum *= sample_stride;
+                    acc_facet.sampled = true;
                 }
+            }
 
-                if(this_facet.stats.fvcount != 0) {
-                    acc_facet.stats.fvcount += this_facet.stats.fvcount;
-                    acc_facet.stats.fvsum += this_facet.stats.fvsum;
-                    acc_facet.stats.fvmax = std::max(acc_facet.stats.fvmax, this_facet.stats.fvmax);
-                    acc_facet.stats.fvmin = std::min(acc_facet.stats.fvmin, this_facet.stats.fvmin);
+            if(facets_cacheable) {
+                std::unique_lock<std::mutex> cache_lock(facet_cache_mutex);
+
+                for(const auto& a_facet: facets) {
+                    facet_cache_entry_t& cache_entry = facet_cache[a_facet.field_name];
+                    cache_entry.result_map = a_facet.result_map;
+                    cache_entry.stats = a_facet.stats;
+                    cache_entry.watermark = facets_watermark;
                 }
             }
-        }
 
-        /*long long int timeMillisF = std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::high_resolution_clock::now() - beginF).count();
-        LOG(INFO) << "Time for faceting: " << timeMillisF;*/
+            /*long long int timeMillisF = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::high_resolution_clock::now() - beginF).count();
+            LOG(INFO) << "Time for faceting: " << timeMillisF;*/
+        }
     }
 
     std::vector<facet_info_t> facet_infos(facets.size());
     compute_facet_infos(facets, facet_query, &included_ids[0], included_ids.size(), group_by_fields, facet_infos);
     do_facets(facets, facet_query, facet_infos, group_limit, group_by_fields, &included_ids[0], included_ids.size());
 
+    timings.facet_us += stage_micros(stage_begin);
+
     all_result_ids_len += curated_topster->size;
 
-    delete [] filter_ids;
+    if(filter_ids_owned) {
+        delete [] filter_ids;
+    }
     delete [] all_result_ids;
 
     for(Topster* ftopster: ftopsters) {
@@ -2546,119 +3630,98 @@ void Index::compute_facet_infos(const std::vector<facet>& facets, facet_query_t&
 
             //LOG(INFO) << "facet_query.query: " << facet_query.query;
 
+            const auto fvindex_it = facet_value_index.find(a_facet.field_name);
+            if(fvindex_it == facet_value_index.end()) {
+                continue;
+            }
+
             std::vector<std::string> query_tokens;
             Tokenizer(facet_query.query, true, !facet_field.is_string()).tokenize(query_tokens);
 
-            std::vector<token_t> search_tokens, qtokens;
-
-            for (size_t qtoken_index = 0; qtoken_index < query_tokens.size(); qtoken_index++) {
-                bool is_prefix = (qtoken_index == query_tokens.size()-1);
-                search_tokens.emplace_back(qtoken_index, query_tokens[qtoken_index], is_prefix);
-                qtokens.emplace_back(qtoken_index, query_tokens[qtoken_index], is_prefix);
+            if(query_tokens.empty()) {
+                continue;
             }
 
-            std::vector<std::vector<art_leaf*>> searched_queries;
-            Topster* topster = nullptr;
-            spp::sparse_hash_set<uint64_t> groups_processed;
-            uint32_t* field_result_ids = nullptr;
-            size_t field_result_ids_len = 0;
-            size_t field_num_results = 0;
-            std::set<uint64> query_hashes;
-            size_t num_toks_dropped = 0;
-
-            search_field(0, qtokens, search_tokens, nullptr, 0, num_toks_dropped,
-                         facet_field, facet_field.faceted_name(),
-                         all_result_ids, all_result_ids_len, {}, {}, 2, searched_queries, topster, groups_processed,
-                         &field_result_ids, field_result_ids_len, field_num_results, 0, group_by_fields,
-                         false, 4, query_hashes, MAX_SCORE, true, 0, 1, false, 3, 1000);
-
-            //LOG(INFO) << "searched_queries.size: " << searched_queries.size();
-
-            // NOTE: `field_result_ids` will consists of IDs across ALL queries in searched_queries
-
-            for(size_t si = 0; si < searched_queries.size(); si++) {
-                const auto& searched_query = searched_queries[si];
-                std::vector<std::string> searched_tokens;
-
-                std::vector<void*> posting_lists;
-                for(auto leaf: searched_query) {
-                    posting_lists.push_back(leaf->values);
-                    std::string tok(reinterpret_cast<char*>(leaf->key), leaf->key_len - 1);
-                    searched_tokens.push_back(tok);
-                    //LOG(INFO) << "tok: " << tok;
+            // every query token is prefix-looked-up in the value index and a
+            // value qualifies when each of them matches one of its tokens;
+            // this replaces the per-document candidate scan of the old approach
+            spp::sparse_hash_map<uint64_t, std::vector<std::string>> hash_to_tokens;
+
+            for(size_t qtoken_index = 0; qtoken_index < query_tokens.size(); qtoken_index++) {
+                const std::string& qtoken = query_tokens[qtoken_index];
+
+                // typo tolerance mirrors the term search defaults: no typos
+                // on short tokens, up to two on longer ones
+                const int max_cost = (qtoken.size() < 4) ? 0 : ((qtoken.size() < 7) ? 1 : 2);
+
+                std::vector<std::pair<std::string, std::vector<uint64_t>>> token_matches;
+                fvindex_it->second->search(qtoken, max_cost, FACET_VALUE_SEARCH_MAX_KEYS,
+                                           all_result_ids, all_result_ids_len, token_matches);
+
+                // the value token matched for each hash, used downstream to
+                // highlight the matched portions of the value
+                spp::sparse_hash_map<uint64_t, const std::string*> matched_token_of_hash;
+                for(const auto& token_match: token_matches) {
+                    for(const uint64_t hash: token_match.second) {
+                        if(matched_token_of_hash.count(hash) == 0) {
+                            matched_token_of_hash.emplace(hash, &token_match.first);
+                        }
+                    }
                 }
 
-                //LOG(INFO) << "si: " << si << ", field_result_ids_len: " << field_result_ids_len;
-
-                for(size_t i = 0; i < std::min<size_t>(1000, field_result_ids_len); i++) {
-                    uint32_t seq_id = field_result_ids[i];
-
-                    const auto doc_fvalues_it = field_facet_mapping_it->second[seq_id % ARRAY_FACET_DIM]->find(seq_id);
-                    if(doc_fvalues_it == field_facet_mapping_it->second[seq_id % ARRAY_FACET_DIM]->end()) {
-                        continue;
+                if(qtoken_index == 0) {
+                    for(const auto& hash_token: matched_token_of_hash) {
+                        hash_to_tokens[hash_token.first].push_back(*hash_token.second);
                     }
-
-                    bool id_matched = true;
-
-                    for(auto pl: posting_lists) {
-                        if(!posting_t::contains(pl, seq_id)) {
-                            // need to ensure that document ID actually contains both searched_query tokens
-                            id_matched = false;
-                            break;
+                } else {
+                    // intersect: drop the hashes this query token did not match
+                    spp::sparse_hash_map<uint64_t, std::vector<std::string>> surviving_hashes;
+
+                    for(auto& hash_tokens: hash_to_tokens) {
+                        const auto matched_it = matched_token_of_hash.find(hash_tokens.first);
+                        if(matched_it != matched_token_of_hash.end()) {
+                            hash_tokens.second.push_back(*matched_it->second);
+                            surviving_hashes.emplace(hash_tokens.first, std::move(hash_tokens.second));
                         }
                     }
 
-                    if(!id_matched) {
-                        continue;
-                    }
-
-                    if(facet_field.is_array()) {
-                        std::vector<size_t> array_indices;
-                        posting_t::get_matching_array_indices(posting_lists, seq_id, array_indices);
-
-                        for(size_t array_index: array_indices) {
-                            if(array_index < doc_fvalues_it->second.length) {
-                                uint64_t hash = doc_fvalues_it->second.hashes[array_index];
-
-                                /*LOG(INFO) << "seq_id: " << seq_id << ", hash: " << hash << ", array index: "
-                                          << array_index;*/
+                    hash_to_tokens = std::move(surviving_hashes);
+                }
 
-                                if(facet_infos[findex].hashes.count(hash) == 0) {
-                                    facet_infos[findex].hashes.emplace(hash, searched_tokens);
-                                }
-                            }
-                        }
-                    } else {
-                        uint64_t hash = doc_fvalues_it->second.hashes[0];
-                        if(facet_infos[findex].hashes.count(hash) == 0) {
-                            facet_infos[findex].hashes.emplace(hash, searched_tokens);
-                        }
-                    }
+                if(hash_to_tokens.empty()) {
+                    break;
                 }
             }
 
-            delete [] field_result_ids;
+            for(auto& hash_tokens: hash_to_tokens) {
+                facet_infos[findex].hashes.emplace(hash_tokens.first, std::move(hash_tokens.second));
+            }
         }
     }
 }
 
 void Index::curate_filtered_ids(const std::vector<filter>& filters, const std::set<uint32_t>& curated_ids,
                                 const uint32_t* exclude_token_ids, size_t exclude_token_ids_size,
-                                uint32_t*& filter_ids, uint32_t& filter_ids_length,
+                                uint32_t*& filter_ids, uint32_t& filter_ids_length, bool& filter_ids_owned,
                                 const std::vector<uint32_t>& curated_ids_sorted) const {
-    // if filtered results are not available, use the seq_ids index to generate the list of all document ids
+    // if filtered results are not available, the shared live-id view serves as the list of all document ids
 
     if(filters.empty() && filter_ids_length == 0) {
-        filter_ids_length = seq_ids.getLength();
-        filter_ids = seq_ids.uncompress();
+        size_t num_live_ids = 0;
+        filter_ids = get_live_ids(num_live_ids);
+        filter_ids_length = num_live_ids;
+        filter_ids_owned = false;
     }
 
     if(!curated_ids.empty()) {
         uint32_t *excluded_result_ids = nullptr;
         filter_ids_length = ArrayUtils::exclude_scalar(filter_ids, filter_ids_length, &curated_ids_sorted[0],
                                                        curated_ids_sorted.size(), &excluded_result_ids);
-        delete [] filter_ids;
+        if(filter_ids_owned) {
+            delete [] filter_ids;
+        }
         filter_ids = excluded_result_ids;
+        filter_ids_owned = true;
     }
 
     // Exclude document IDs associated with excluded tokens from the result set
@@ -2666,8 +3729,11 @@ void Index::curate_filtered_ids(const std::vector<filter>& filters, const std::s
         uint32_t *excluded_result_ids = nullptr;
         filter_ids_length = ArrayUtils::exclude_scalar(filter_ids, filter_ids_length, exclude_token_ids,
                                                        exclude_token_ids_size, &excluded_result_ids);
-        delete[] filter_ids;
+        if(filter_ids_owned) {
+            delete[] filter_ids;
+        }
         filter_ids = excluded_result_ids;
+        filter_ids_owned = true;
     }
 }
 
@@ -2683,11 +3749,76 @@ void Index::search_wildcard(const std::vector<std::string>& qtokens, const std::
                             uint32_t filter_ids_length, const size_t concurrency) const {
 
     int sort_order[3]; // 1 or -1 based on DESC or ASC respectively
-    std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3> field_values;
+    std::array<doc_values_t*, 3> field_values;
     std::vector<size_t> geopoint_indices;
     populate_sort_mapping(sort_order, geopoint_indices, sort_fields_std, field_values);
 
     uint32_t token_bits = 255;
+    bool scored_by_sort_walk = false;
+
+    // fast path for browse queries sorted solely by a static numeric field:
+    // walk the field's values in sort order, probe the filter bitset per id
+    // and stop once the topster is filled, instead of scoring every match
+    if(sort_fields_std.size() == 1 && group_limit == 0 && geopoint_indices.empty() &&
+       field_values[0] != &text_match_sentinel_value && field_values[0] != &seq_id_sentinel_value &&
+       numerical_index.count(sort_fields_std[0].name) != 0 &&
+       filter_ids_length > topster->MAX_SIZE) {
+
+        num_tree_t* num_tree = numerical_index.at(sort_fields_std[0].name);
+        const bool descending = (sort_order[0] == 1);
+
+        const uint32_t max_seq_id = filter_ids[filter_ids_length - 1];
+        std::vector<bool> filter_bitset(size_t(max_seq_id) + 1, false);
+        for(size_t i = 0; i < filter_ids_length; i++) {
+            filter_bitset[filter_ids[i]] = true;
+        }
+
+        std::vector<posting_list_t::iterator_t> no_plists;
+        std::vector<uint32_t> value_ids;
+        size_t num_hits = 0;
+
+        num_tree->iterate_values(descending, [&](int64_t, sorted_array* arr) {
+            const uint32_t arr_len = arr->getLength();
+            value_ids.resize(arr_len);
+            arr->uncompress(value_ids.data());
+
+            for(uint32_t i = 0; i < arr_len; i++) {
+                const uint32_t seq_id = value_ids[i];
+                if(seq_id > max_seq_id || !filter_bitset[seq_id]) {
+                    continue;
+                }
+
+                num_hits++;
+                score_results(sort_fields_std, (uint16_t) searched_queries.size(), field_id, false, 0,
+                              topster, {}, groups_processed, seq_id, sort_order, field_values,
+                              geopoint_indices, group_limit, group_by_fields, token_bits,
+                              false, false, no_plists);
+            }
+
+            // stop only at a value boundary so that tie-breaking by seq_id
+            // within an equal value stays identical to the full scan
+            return topster->size < topster->MAX_SIZE;
+        });
+
+        // documents without the field sort last, so the walk is conclusive when
+        // the topster is full or every filtered id carried the field
+        scored_by_sort_walk = (topster->size >= topster->MAX_SIZE) || (num_hits == filter_ids_length);
+
+        if(scored_by_sort_walk) {
+            collate_included_ids(qtokens, field, field_id, included_ids_map, curated_topster, searched_queries);
+
+            uint32_t* new_all_result_ids = nullptr;
+            all_result_ids_len = ArrayUtils::or_scalar(all_result_ids, all_result_ids_len, filter_ids,
+                                                       filter_ids_length, &new_all_result_ids);
+            delete [] all_result_ids;
+            all_result_ids = new_all_result_ids;
+            return;
+        }
+
+        // otherwise some filtered ids lack the field: fall through to the full
+        // scan, which re-feeds already added entries harmlessly (kv_map dedup)
+    }
+
     const bool check_for_circuit_break = (filter_ids_length > 1000000);
 
     //auto beginF = std::chrono::high_resolution_clock::now();
@@ -2722,6 +3853,7 @@ void Index::search_wildcard(const std::vector<std::string>& qtokens, const std::
         num_queued++;
 
         topsters[thread_id] = new Topster(topster->MAX_SIZE, topster->distinct);
+        topsters[thread_id]->after_bound = topster->after_bound;
 
         thread_pool->enqueue([this, &parent_search_begin, &parent_search_stop_ms, &parent_search_cutoff,
                              thread_id, &sort_fields_std, &searched_queries, &field_id,
@@ -2764,7 +3896,11 @@ void Index::search_wildcard(const std::vector<std::string>& qtokens, const std::
 
     for(size_t thread_id = 0; thread_id < num_processed; thread_id++) {
         groups_processed.insert(tgroups_processed[thread_id].begin(), tgroups_processed[thread_id].end());
-        aggregate_topster(topster, topsters[thread_id]);
+    }
+
+    aggregate_topsters(topster, std::vector<Topster*>(topsters, topsters + num_processed));
+
+    for(size_t thread_id = 0; thread_id < num_processed; thread_id++) {
         delete topsters[thread_id];
     }
 
@@ -2783,7 +3919,7 @@ void Index::search_wildcard(const std::vector<std::string>& qtokens, const std::
 
 void Index::populate_sort_mapping(int* sort_order, std::vector<size_t>& geopoint_indices,
                                   const std::vector<sort_by>& sort_fields_std,
-                                  std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3>& field_values) const {
+                                  std::array<doc_values_t*, 3>& field_values) const {
     for (size_t i = 0; i < sort_fields_std.size(); i++) {
         sort_order[i] = 1;
         if (sort_fields_std[i].order == sort_field_const::asc) {
@@ -2827,7 +3963,9 @@ void Index::search_field(const uint8_t & field_id,
                          const field& the_field, const std::string& field_name, // to handle faceted index
                          const uint32_t *filter_ids, size_t filter_ids_length,
                          const std::vector<uint32_t>& curated_ids,
-                         const std::vector<sort_by> & sort_fields, const int num_typos,
+                         const std::vector<sort_by> & sort_fields,
+                         const std::string& default_sorting_field,
+                         const int num_typos,
                          std::vector<std::vector<art_leaf*>> & searched_queries,
                          Topster* topster, spp::sparse_hash_set<uint64_t>& groups_processed,
                          uint32_t** all_result_ids, size_t & all_result_ids_len, size_t& field_num_results,
@@ -2881,22 +4019,50 @@ void Index::search_field(const uint8_t & field_id,
     const size_t combination_limit = exhaustive_search ? Index::COMBINATION_MAX_LIMIT : Index::COMBINATION_MIN_LIMIT;
     const size_t num_fuzzy_candidates = exhaustive_search ? 10000 : 4;
 
+    // when results are ranked primarily by descending text match score, a full
+    // topster's worst entry puts a floor under what a typo-penalized candidate
+    // must beat, letting us stop exploring costlier corrections
+    const bool text_match_first = !sort_fields.empty() &&
+                                  sort_fields[0].name == sort_field_const::text_match &&
+                                  sort_fields[0].order == sort_field_const::desc;
+
     while(n < N && n < combination_limit) {
         RETURN_CIRCUIT_BREAKER
 
         // Outerloop generates combinations of [cost to max_cost] for each token
         // For e.g. for a 3-token query: [0, 0, 0], [0, 0, 1], [0, 1, 1] etc.
         std::vector<uint32_t> costs(token_to_costs.size());
+        size_t total_cost = 0;
         ldiv_t q { n, 0 };
         for(long long i = (token_to_costs.size() - 1); 0 <= i ; --i ) {
             q = ldiv(q.quot, token_to_costs[i].size());
             costs[i] = token_to_costs[i][q.rem];
+            total_cost += costs[i];
         }
 
         unique_tokens.clear();
         token_candidates_vec.clear();
         size_t token_index = 0;
 
+        if(total_cost != 0 && !exhaustive_search && text_match_first && group_limit == 0 &&
+           topster != nullptr && topster->size >= topster->MAX_SIZE) {
+            // best possible score at this typo cost: every token present inside
+            // a single gapless window
+            const uint64_t best_score = Match::get_match_score(
+                    std::min(search_tokens.size(), WINDOW_SIZE), total_cost, 0) | uint64_t(1);
+
+            if(int64_t(best_score) < topster->kvs[0]->scores[0]) {
+                if(total_cost == 1) {
+                    // every remaining combination carries at least one typo and
+                    // scores strictly lower, so nothing more can rank
+                    return;
+                }
+
+                // a cheaper combination can still follow, so skip just this one
+                goto resume_typo_loop;
+            }
+        }
+
         while(token_index < search_tokens.size()) {
             // For each token, look up the generated cost for this iteration and search using that cost
             const std::string& token = search_tokens[token_index].value;
@@ -2974,12 +4140,16 @@ void Index::search_field(const uint8_t & field_id,
             // If atleast one token is found, go ahead and search for candidates
             search_candidates(field_id, the_field.is_array(), filter_ids, filter_ids_length,
                               exclude_token_ids, exclude_token_ids_size,
-                              curated_ids, sort_fields, token_candidates_vec, searched_queries, topster,
+                              curated_ids, sort_fields, default_sorting_field,
+                              token_candidates_vec, searched_queries, topster,
                               groups_processed, all_result_ids, all_result_ids_len, field_num_results,
                               typo_tokens_threshold, group_limit, group_by_fields, query_tokens,
                               prioritize_exact_match, combination_limit, concurrency, query_hashes, id_buff);
 
-            if(id_buff.size() > 1) {
+            if(id_buff.size() > 50000) {
+                parasort(id_buff.size(), &id_buff[0], 4);
+                id_buff.erase(std::unique( id_buff.begin(), id_buff.end() ), id_buff.end());
+            } else if(id_buff.size() > 1) {
                 std::sort(id_buff.begin(), id_buff.end());
                 id_buff.erase(std::unique( id_buff.begin(), id_buff.end() ), id_buff.end());
             }
@@ -3030,7 +4200,7 @@ void Index::search_field(const uint8_t & field_id,
 
         return search_field(field_id, query_tokens, truncated_tokens, exclude_token_ids, exclude_token_ids_size,
                             num_tokens_dropped, the_field, field_name, filter_ids, filter_ids_length, curated_ids,
-                            sort_fields, num_typos,searched_queries, topster, groups_processed, all_result_ids,
+                            sort_fields, default_sorting_field, num_typos,searched_queries, topster, groups_processed, all_result_ids,
                             all_result_ids_len, field_num_results, group_limit, group_by_fields,
                             prioritize_exact_match, concurrency, query_hashes,
                             token_order, prefix, drop_tokens_threshold, typo_tokens_threshold,
@@ -3072,7 +4242,7 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
                           const std::vector<art_leaf *> &query_suggestion,
                           spp::sparse_hash_set<uint64_t>& groups_processed /**/,
                           const uint32_t seq_id, const int sort_order[3],
-                          std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3> field_values /**/,
+                          std::array<doc_values_t*, 3> field_values /**/,
                           const std::vector<size_t>& geopoint_indices,
                           const size_t group_limit, const std::vector<std::string>& group_by_fields,
                           const uint32_t token_bits,
@@ -3083,17 +4253,15 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
     int64_t geopoint_distances[3];
 
     for(auto& i: geopoint_indices) {
-        spp::sparse_hash_map<uint32_t, int64_t>* geopoints = field_values[i];
+        doc_values_t* geopoints = field_values[i];
         int64_t dist = INT32_MAX;
 
         S2LatLng reference_lat_lng;
         GeoPoint::unpack_lat_lng(sort_fields[i].geopoint, reference_lat_lng);
 
         if(geopoints != nullptr) {
-            auto it = geopoints->find(seq_id);
-
-            if(it != geopoints->end()) {
-                int64_t packed_latlng = it->second;
+            if(geopoints->contains(seq_id)) {
+                int64_t packed_latlng = geopoints->at(seq_id);
                 S2LatLng s2_lat_lng;
                 GeoPoint::unpack_lat_lng(packed_latlng, s2_lat_lng);
                 dist = GeoPoint::distance(s2_lat_lng, reference_lat_lng);
@@ -3136,20 +4304,12 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
     //const std::string first_token((const char*)query_suggestion[0]->key, query_suggestion[0]->key_len-1);
 
     uint64_t match_score = 0;
+    bool match_score_deferred = false;
+    std::unordered_map<size_t, std::vector<token_positions_t>> array_token_positions;
 
-    if (posting_lists.size() <= 1) {
-        const uint8_t is_verbatim_match = uint8_t(
-            prioritize_exact_match && single_exact_query_token &&
-            posting_list_t::is_single_token_verbatim_match(posting_lists[0], field_is_array)
-        );
-        Match single_token_match = Match(1, 0, is_verbatim_match);
-        match_score = single_token_match.get_match_score(total_cost);
-    } else {
+    const auto compute_text_match_score = [&]() {
         uint64_t total_tokens_found = 0, total_num_typos = 0, total_distance = 0, total_verbatim = 0;
 
-        std::unordered_map<size_t, std::vector<token_positions_t>> array_token_positions;
-        posting_list_t::get_offsets(posting_lists, array_token_positions);
-
         for (const auto& kv: array_token_positions) {
             const std::vector<token_positions_t>& token_positions = kv.second;
             if (token_positions.empty()) {
@@ -3172,7 +4332,7 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
             LOG(INFO) << os.str();*/
         }
 
-        match_score = (
+        return (
             (uint64_t(total_tokens_found) << 24) |
             (uint64_t(255 - total_num_typos) << 16) |
             (uint64_t(100 - total_distance) << 8) |
@@ -3185,6 +4345,28 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
                   << " - total_distance: " << total_distance
                   << " - total_verbatim: " << total_verbatim
                   << " - total_cost: " << total_cost;*/
+    };
+
+    if (posting_lists.size() <= 1) {
+        const uint8_t is_verbatim_match = uint8_t(
+            prioritize_exact_match && single_exact_query_token &&
+            posting_list_t::is_single_token_verbatim_match(posting_lists[0], field_is_array)
+        );
+        Match single_token_match = Match(1, 0, is_verbatim_match);
+        match_score = single_token_match.get_match_score(total_cost);
+    } else {
+        posting_list_t::get_offsets(posting_lists, array_token_positions);
+
+        if(!field_is_array && topster != nullptr && group_limit == 0 && topster->size >= topster->MAX_SIZE) {
+            // optimistic upper bound on the match score (every token inside one
+            // window with no gaps); the expensive window scan runs only if this
+            // bound can still displace the topster's current minimum
+            match_score = Match::get_match_score(std::min(posting_lists.size(), WINDOW_SIZE), total_cost, 0) |
+                          uint64_t(1);
+            match_score_deferred = true;
+        } else {
+            match_score = compute_text_match_score();
+        }
     }
 
     const int64_t default_score = INT64_MIN;  // to handle field that doesn't exist in document (e.g. optional)
@@ -3201,8 +4383,7 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
         } else if(field_values[0] == &geo_sentinel_value) {
             scores[0] = geopoint_distances[0];
         } else {
-            auto it = field_values[0]->find(seq_id);
-            scores[0] = (it == field_values[0]->end()) ? default_score : it->second;
+            scores[0] = field_values[0]->get(seq_id, default_score);
         }
 
         if (sort_order[0] == -1) {
@@ -3219,8 +4400,7 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
         } else if(field_values[1] == &geo_sentinel_value) {
             scores[1] = geopoint_distances[1];
         } else {
-            auto it = field_values[1]->find(seq_id);
-            scores[1] = (it == field_values[1]->end()) ? default_score : it->second;
+            scores[1] = field_values[1]->get(seq_id, default_score);
         }
 
         if (sort_order[1] == -1) {
@@ -3237,8 +4417,7 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
         } else if(field_values[2] == &geo_sentinel_value) {
             scores[2] = geopoint_distances[2];
         } else {
-            auto it = field_values[2]->find(seq_id);
-            scores[2] = (it == field_values[2]->end()) ? default_score : it->second;
+            scores[2] = field_values[2]->get(seq_id, default_score);
         }
 
         if (sort_order[2] == -1) {
@@ -3246,6 +4425,38 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
         }
     }
 
+    if(match_score_deferred) {
+        bool can_prune = true;
+
+        for(size_t i = 0; i < sort_fields.size() && i < 3; i++) {
+            if(field_values[i] == &text_match_sentinel_value && sort_order[i] == -1) {
+                // with an ascending text match sort the negated bound is no
+                // longer an upper bound on the final score, so don't prune
+                can_prune = false;
+            }
+        }
+
+        if(can_prune) {
+            const KV* worst_kv = topster->kvs[0];
+            if(std::tie(scores[0], scores[1], scores[2]) <
+               std::tie(worst_kv->scores[0], worst_kv->scores[1], worst_kv->scores[2])) {
+                // even a perfect proximity match cannot enter the topster
+                return;
+            }
+        }
+
+        match_score = compute_text_match_score();
+
+        for(size_t i = 0; i < sort_fields.size() && i < 3; i++) {
+            if(field_values[i] == &text_match_sentinel_value) {
+                scores[i] = int64_t(match_score);
+                if(sort_order[i] == -1) {
+                    scores[i] = -scores[i];
+                }
+            }
+        }
+    }
+
     uint64_t distinct_id = seq_id;
 
     if(group_limit != 0) {
@@ -3273,14 +4484,13 @@ uint64_t Index::get_distinct_id(const std::vector<std::string>& group_by_fields,
             continue;
         }
 
-        const auto& field_facet_mapping = field_facet_mapping_it->second;
-        const auto& facet_hashes_it = field_facet_mapping[seq_id % ARRAY_FACET_DIM]->find(seq_id);
+        const facet_hash_values_t* facet_hashes_ptr = field_facet_mapping_it->second->get(seq_id);
 
-        if(facet_hashes_it == field_facet_mapping[seq_id % ARRAY_FACET_DIM]->end()) {
+        if(facet_hashes_ptr == nullptr) {
             continue;
         }
 
-        const auto& facet_hashes = facet_hashes_it->second;
+        const auto& facet_hashes = *facet_hashes_ptr;
 
         for(size_t i = 0; i < facet_hashes.size(); i++) {
             distinct_id = hash_combine(distinct_id, facet_hashes.hashes[i]);
@@ -3290,20 +4500,110 @@ uint64_t Index::get_distinct_id(const std::vector<std::string>& group_by_fields,
     return distinct_id;
 }
 
-inline uint32_t Index::next_suggestion(const std::vector<token_candidates> &token_candidates_vec,
-                                   long long int n,
-                                   std::vector<art_leaf *>& actual_query_suggestion,
-                                   std::vector<art_leaf *>& query_suggestion,
-                                   uint32_t& token_bits,
-                                   uint64& qhash) {
-    uint32_t total_cost = 0;
-    qhash = 1;
+void Index::beam_candidate_order(const std::vector<token_candidates>& token_candidates_vec,
+                                 const long long combination_limit,
+                                 std::vector<long long>& combination_order) {
+    const size_t num_tokens = token_candidates_vec.size();
 
-    // generate the next combination from `token_leaves` and store it in `query_suggestion`
-    ldiv_t q { n, 0 };
-    for(long long i = 0 ; i < (long long) token_candidates_vec.size(); i++) {
-        size_t token_size = token_candidates_vec[i].token.value.size();
-        q = ldiv(q.quot, token_candidates_vec[i].candidates.size());
+    // rank each token's candidates cheapest-first: typo/prefix cost dominates and
+    // document frequency breaks ties, since a candidate matching more documents
+    // is more likely to produce a viable intersection
+    std::vector<std::vector<uint32_t>> ranked_indices(num_tokens);
+    std::vector<std::vector<uint64_t>> penalties(num_tokens);
+    std::vector<long long> strides(num_tokens);
+
+    long long stride = 1;
+
+    for(size_t i = 0; i < num_tokens; i++) {
+        const auto& tc = token_candidates_vec[i];
+        const size_t token_size = tc.token.value.size();
+
+        strides[i] = stride;
+        stride *= tc.candidates.size();
+
+        penalties[i].resize(tc.candidates.size());
+        ranked_indices[i].resize(tc.candidates.size());
+
+        for(size_t j = 0; j < tc.candidates.size(); j++) {
+            // mirrors the cost computed by next_suggestion()
+            bool exact_match = tc.cost == 0 && token_size == tc.candidates[j]->key_len - 1;
+            bool incr_for_prefix_search = tc.prefix_search && !exact_match;
+            uint64_t actual_cost = (2 * tc.cost) + uint64_t(incr_for_prefix_search);
+
+            size_t num_ids = posting_t::num_ids(tc.candidates[j]->values);
+            uint64_t freq_penalty = UINT32_MAX - uint64_t(std::min<size_t>(num_ids, UINT32_MAX));
+
+            // cost sits above the frequency bits so that summing per-token
+            // penalties cannot let frequencies outvote a cheaper typo
+            penalties[i][j] = (actual_cost << 40) | freq_penalty;
+            ranked_indices[i][j] = j;
+        }
+
+        std::sort(ranked_indices[i].begin(), ranked_indices[i].end(), [&](uint32_t a, uint32_t b) {
+            return penalties[i][a] < penalties[i][b];
+        });
+    }
+
+    // best-first walk of the cartesian product: each state holds per-token ranks
+    // into the sorted candidate lists and is expanded by bumping one rank at a
+    // position >= `pos`, which reaches every combination exactly once
+    struct beam_state_t {
+        uint64_t penalty;
+        uint32_t pos;
+        std::vector<uint32_t> ranks;
+    };
+
+    auto state_gt = [](const beam_state_t& a, const beam_state_t& b) {
+        return a.penalty > b.penalty;
+    };
+
+    std::priority_queue<beam_state_t, std::vector<beam_state_t>, decltype(state_gt)> states(state_gt);
+
+    beam_state_t root{0, 0, std::vector<uint32_t>(num_tokens, 0)};
+    for(size_t i = 0; i < num_tokens; i++) {
+        root.penalty += penalties[i][ranked_indices[i][0]];
+    }
+
+    states.push(root);
+
+    while(!states.empty() && (long long) combination_order.size() < combination_limit) {
+        beam_state_t state = states.top();
+        states.pop();
+
+        long long n = 0;
+        for(size_t i = 0; i < num_tokens; i++) {
+            n += strides[i] * ranked_indices[i][state.ranks[i]];
+        }
+
+        combination_order.push_back(n);
+
+        for(size_t j = state.pos; j < num_tokens; j++) {
+            if(size_t(state.ranks[j]) + 1 < ranked_indices[j].size()) {
+                beam_state_t next = state;
+                next.pos = j;
+                next.ranks[j]++;
+                next.penalty = state.penalty - penalties[j][ranked_indices[j][state.ranks[j]]]
+                                             + penalties[j][ranked_indices[j][next.ranks[j]]];
+                states.push(next);
+            }
+        }
+    }
+}
+
+inline uint32_t Index::next_suggestion(const std::vector<token_candidates> &token_candidates_vec,
+                                   long long int n,
+                                   std::vector<art_leaf *>& actual_query_suggestion,
+                                   std::vector<art_leaf *>& query_suggestion,
+                                   uint32_t& token_bits,
+                                   uint64& qhash) {
+    uint32_t total_cost = 0;
+    qhash = 1;
+
+    // generate the next combination from `token_leaves` and store it in `query_suggestion`
+    ldiv_t q { n, 0 };
+    for(long long i = 0 ; i < (long long) token_candidates_vec.size(); i++) {
+        size_t token_size = token_candidates_vec[i].token.value.size();
+        q = ldiv(q.quot, token_candidates_vec[i].candidates.size());
         actual_query_suggestion[i] = token_candidates_vec[i].candidates[q.rem];
         query_suggestion[i] = token_candidates_vec[i].candidates[q.rem];
 
@@ -3336,6 +4636,15 @@ inline uint32_t Index::next_suggestion(const std::vector<token_candidates> &toke
 Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & document, const bool is_update) {
     std::unique_lock lock(mutex);
 
+    // cached filter results are now stale
+    write_watermark++;
+
+    return remove_unlocked(seq_id, document, is_update);
+}
+
+// requires unique lock to be held by the caller
+Option<uint32_t> Index::remove_unlocked(const uint32_t seq_id, const nlohmann::json & document, const bool is_update,
+                                        const std::unordered_map<std::string, offsets_facet_hashes_t>* new_field_index) {
     for(auto it = document.begin(); it != document.end(); ++it) {
         const std::string& field_name = it.key();
         const auto& search_field_it = search_schema.find(field_name);
@@ -3354,8 +4663,23 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
             std::vector<std::string> tokens;
             tokenize_string_field(document, search_field, tokens, search_field.locale);
 
+            // tokens that survive the update need not be erased: the posting upsert
+            // replaces their offsets in place
+            const offsets_facet_hashes_t* new_field_tokens = nullptr;
+            if(new_field_index != nullptr) {
+                const auto& new_field_it = new_field_index->find(field_name);
+                if(new_field_it != new_field_index->end()) {
+                    new_field_tokens = &new_field_it->second;
+                }
+            }
+
             for(size_t i = 0; i < tokens.size(); i++) {
                 const auto& token = tokens[i];
+
+                if(new_field_tokens != nullptr && new_field_tokens->offsets.count(token) != 0) {
+                    continue;
+                }
+
                 const unsigned char *key = (const unsigned char *) token.c_str();
                 int key_len = (int) (token.length() + 1);
 
@@ -3375,6 +4699,10 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
             for(int32_t value: values) {
                 num_tree_t* num_tree = numerical_index.at(field_name);
                 num_tree->remove(value, seq_id);
+
+                if(search_field.materialize) {
+                    materialized_filter_remove(field_name, value, seq_id);
+                }
             }
         } else if(search_field.is_int64()) {
             const std::vector<int64_t>& values = search_field.is_single_integer() ?
@@ -3383,6 +4711,10 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
             for(int64_t value: values) {
                 num_tree_t* num_tree = numerical_index.at(field_name);
                 num_tree->remove(value, seq_id);
+
+                if(search_field.materialize) {
+                    materialized_filter_remove(field_name, value, seq_id);
+                }
             }
         } else if(search_field.is_float()) {
             const std::vector<float>& values = search_field.is_single_float() ?
@@ -3392,6 +4724,10 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
                 num_tree_t* num_tree = numerical_index.at(field_name);
                 int64_t fintval = float_to_in64_t(value);
                 num_tree->remove(fintval, seq_id);
+
+                if(search_field.materialize) {
+                    materialized_filter_remove(field_name, fintval, seq_id);
+                }
             }
         } else if(search_field.is_bool()) {
 
@@ -3399,9 +4735,12 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
                                                std::vector<bool>{document[field_name].get<bool>()} :
                                                document[field_name].get<std::vector<bool>>();
             for(bool value: values) {
-                num_tree_t* num_tree = numerical_index.at(field_name);
-                int64_t bool_int64 = value ? 1 : 0;
-                num_tree->remove(bool_int64, seq_id);
+                bool_index_t* bitmaps = bool_index.at(field_name);
+                bitmaps->remove(value, seq_id);
+
+                if(search_field.materialize) {
+                    materialized_filter_remove(field_name, value ? 1 : 0, seq_id);
+                }
             }
         } else if(search_field.is_geopoint()) {
             auto geo_index = geopoint_index[field_name];
@@ -3416,15 +4755,7 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
             for(const std::vector<double>& latlong: latlongs) {
                 S2Point point = S2LatLng::FromDegrees(latlong[0], latlong[1]).ToPoint();
                 for(const auto& term: indexer.GetIndexTerms(point, "")) {
-                    auto term_it = geo_index->find(term);
-                    if(term_it == geo_index->end()) {
-                        continue;
-                    }
-                    std::vector<uint32_t>& ids = term_it->second;
-                    ids.erase(std::remove(ids.begin(), ids.end(), seq_id), ids.end());
-                    if(ids.empty()) {
-                        geo_index->erase(term);
-                    }
+                    geo_index->remove(term, seq_id);
                 }
             }
 
@@ -3438,14 +4769,49 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
             }
         }
 
+        // remove facet values from the type-ahead value index and release
+        // their interned copies
+        const auto fvindex_it = facet_value_index.find(field_name);
+        const auto fvstore_it = facet_value_store.find(field_name);
+
+        if(fvstore_it != facet_value_store.end() && document.count(field_name) != 0) {
+            std::vector<std::string> facet_texts;
+            const auto& fvalue = document[field_name];
+            const auto& elements = fvalue.is_array() ? fvalue : nlohmann::json::array({fvalue});
+
+            // mirrors the stringification done when the values were indexed
+            for(const auto& element: elements) {
+                if(element.is_string()) {
+                    facet_texts.push_back(element.get<std::string>());
+                } else if(element.is_boolean()) {
+                    facet_texts.push_back(std::to_string(element.get<bool>()));
+                } else if(search_field.is_float()) {
+                    facet_texts.push_back(StringUtils::float_to_str(element.get<float>()));
+                } else if(element.is_number_integer()) {
+                    facet_texts.push_back(std::to_string(element.get<int64_t>()));
+                }
+            }
+
+            for(const std::string& facet_text: facet_texts) {
+                fvstore_it->second->release(facet_token_hash(search_field, facet_text));
+
+                if(fvindex_it != facet_value_index.end()) {
+                    std::vector<std::string> value_tokens;
+                    Tokenizer(facet_text, true, !search_field.is_string(), search_field.locale,
+                              symbols_to_index, token_separators).tokenize(value_tokens);
+
+                    for(const std::string& value_token: value_tokens) {
+                        fvindex_it->second->remove(value_token, seq_id);
+                    }
+                }
+            }
+        }
+
         // remove facets
         const auto& field_facets_it = facet_index_v3.find(field_name);
 
         if(field_facets_it != facet_index_v3.end()) {
-            const auto& fvalues_it = field_facets_it->second[seq_id % ARRAY_FACET_DIM]->find(seq_id);
-            if(fvalues_it != field_facets_it->second[seq_id % ARRAY_FACET_DIM]->end()) {
-                field_facets_it->second[seq_id % ARRAY_FACET_DIM]->erase(fvalues_it);
-            }
+            field_facets_it->second->erase(seq_id);
         }
 
         // remove sort field
@@ -3456,6 +4822,7 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
 
     if(!is_update) {
         seq_ids.remove_value(seq_id);
+        seq_ids_version++;
     }
 
     return Option<uint32_t>(seq_id);
@@ -3490,6 +4857,16 @@ const spp::sparse_hash_map<std::string, num_tree_t*>& Index::_get_numerical_inde
     return numerical_index;
 }
 
+const std::string* Index::get_facet_value(const std::string& field_name, const uint64_t fhash) const {
+    const auto fvstore_it = facet_value_store.find(field_name);
+
+    if(fvstore_it == facet_value_store.end()) {
+        return nullptr;
+    }
+
+    return fvstore_it->second->get(fhash);
+}
+
 void Index::refresh_schemas(const std::vector<field>& new_fields) {
     std::unique_lock lock(mutex);
 
@@ -3500,41 +4877,51 @@ void Index::refresh_schemas(const std::vector<field>& new_fields) {
         if(search_index.count(new_field.name) == 0) {
             if(new_field.is_string() || field_types::is_string_or_array(new_field.type)) {
                 art_tree *t = new art_tree;
-                art_tree_init(t);
+                art_tree_init_interned(t, &token_interner);
                 search_index.emplace(new_field.name, t);
             } else if(new_field.is_geopoint()) {
-                auto field_geo_index = new spp::sparse_hash_map<std::string, std::vector<uint32_t>>();
+                auto field_geo_index = new geo_index_t();
                 geopoint_index.emplace(new_field.name, field_geo_index);
                 if(!new_field.is_single_geopoint()) {
                     auto geo_array_map = new spp::sparse_hash_map<uint32_t, int64_t*>();
                     geo_array_index.emplace(new_field.name, geo_array_map);
                 }
             } else {
-                num_tree_t* num_tree = new num_tree_t;
-                numerical_index.emplace(new_field.name, num_tree);
+                if(new_field.is_bool()) {
+                    bool_index_t* bitmaps = new bool_index_t;
+                    bool_index.emplace(new_field.name, bitmaps);
+                } else {
+                    num_tree_t* num_tree = new num_tree_t;
+                    numerical_index.emplace(new_field.name, num_tree);
+                }
+
+                if(new_field.materialize) {
+                    auto value_to_ids = new spp::sparse_hash_map<int64_t, std::vector<uint32_t>>();
+                    materialized_filter_index.emplace(new_field.name, value_to_ids);
+                }
             }
         }
 
         if(new_field.is_facet()) {
             facet_schema.emplace(new_field.name, new_field);
 
-            array_mapped_facet_t facet_array;
-            for(size_t i = 0; i < ARRAY_FACET_DIM; i++) {
-                facet_array[i] = new facet_map_t();
-            }
+            facet_index_v3.emplace(new_field.name, new facet_column_t());
+            facet_value_store.emplace(new_field.name, new facet_value_store_t());
 
-            facet_index_v3.emplace(new_field.name, facet_array);
+            if(!new_field.is_geopoint()) {
+                facet_value_index.emplace(new_field.name, new facet_value_index_t(&token_interner));
+            }
 
             // initialize for non-string facet fields
             if(!new_field.is_string()) {
                 art_tree *ft = new art_tree;
-                art_tree_init(ft);
+                art_tree_init_interned(ft, &token_interner);
                 search_index.emplace(new_field.faceted_name(), ft);
             }
         }
 
         if(sort_index.count(new_field.name) == 0) {
-            spp::sparse_hash_map<uint32_t, int64_t> * doc_to_score = new spp::sparse_hash_map<uint32_t, int64_t>();
+            doc_values_t* doc_to_score = new doc_values_t();
             sort_index.emplace(new_field.name, doc_to_score);
         }
     }
@@ -3980,11 +5367,806 @@ void Index::scrub_reindex_doc(const std::unordered_map<std::string, field>& sear
     }
 }
 
+bool Index::is_numeric_only_update(const std::unordered_map<std::string, field>& search_schema,
+                                   const index_record& record) {
+    // every updated key must replace an existing scalar numeric/bool value: added or
+    // dropped fields and string/facet/array changes need the generic remove + reindex path
+
+    for(auto it = record.doc.begin(); it != record.doc.end(); ++it) {
+        if(it.key() != "id" && record.del_doc.count(it.key()) == 0) {
+            // a freshly added field must be inserted via the regular path
+            return false;
+        }
+    }
+
+    for(auto it = record.del_doc.begin(); it != record.del_doc.end(); ++it) {
+        if(record.doc.count(it.key()) == 0) {
+            // field is being dropped (e.g. by an upsert), needs actual removal
+            return false;
+        }
+
+        const auto& search_field_it = search_schema.find(it.key());
+        if(search_field_it == search_schema.end()) {
+            continue;
+        }
+
+        const field& search_field = search_field_it->second;
+
+        if(!search_field.index) {
+            continue;
+        }
+
+        if(search_field.facet || search_field.materialize) {
+            return false;
+        }
+
+        if(search_field.type != field_types::INT32 && search_field.type != field_types::INT64 &&
+           search_field.type != field_types::FLOAT && search_field.type != field_types::BOOL) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Index::patch_numerical_fields_in_place(index_record& record) {
+    // requires unique lock to be held by the caller
+    const uint32_t seq_id = record.seq_id;
+
+    for(auto it = record.del_doc.begin(); it != record.del_doc.end(); ++it) {
+        const std::string& field_name = it.key();
+        const auto& search_field_it = search_schema.find(field_name);
+        if(search_field_it == search_schema.end()) {
+            continue;
+        }
+
+        const field& afield = search_field_it->second;
+        if(!afield.index) {
+            continue;
+        }
+
+        int64_t old_value, new_value;
+
+        if(afield.type == field_types::BOOL) {
+            bool_index_t* bitmaps = bool_index.at(field_name);
+            bitmaps->remove(it.value().get<bool>(), seq_id);
+            bitmaps->insert(record.doc[field_name].get<bool>(), seq_id);
+            sort_index.at(field_name)->upsert(seq_id, (int64_t) record.doc[field_name].get<bool>());
+            continue;
+        } else if(afield.type == field_types::INT32) {
+            old_value = it.value().get<int32_t>();
+            new_value = record.doc[field_name].get<int32_t>();
+        } else if(afield.type == field_types::INT64) {
+            old_value = it.value().get<int64_t>();
+            new_value = record.doc[field_name].get<int64_t>();
+        } else if(afield.type == field_types::FLOAT) {
+            old_value = float_to_in64_t(it.value().get<float>());
+            new_value = float_to_in64_t(record.doc[field_name].get<float>());
+        } else {
+            continue;
+        }
+
+        num_tree_t* num_tree = numerical_index.at(field_name);
+        num_tree->remove(old_value, seq_id);
+        num_tree->insert(new_value, seq_id);
+
+        // sort doc-values are overwritten in place instead of erase + re-add
+        sort_index.at(field_name)->upsert(seq_id, new_value);
+    }
+}
+
 size_t Index::num_seq_ids() const {
     std::shared_lock lock(mutex);
     return seq_ids.getLength();
 }
 
+uint32_t* Index::get_live_ids(size_t& num_ids) const {
+    std::lock_guard<std::mutex> lock(live_ids_mutex);
+
+    const uint64_t version = seq_ids_version.load();
+    if(live_ids_view_version != version) {
+        live_ids_view.resize(seq_ids.getLength());
+        if(!live_ids_view.empty()) {
+            seq_ids.uncompress(live_ids_view.data());
+        }
+        live_ids_view_version = version;
+    }
+
+    num_ids = live_ids_view.size();
+    return live_ids_view.data();
+}
+
+void Index::get_memory_stats(nlohmann::json& stats) const {
+    std::shared_lock lock(mutex);
+
+    uint64_t art_bytes = 0, posting_bytes = 0;
+
+    for(const auto& field_tree: search_index) {
+        art_bytes += art_tree_arena_bytes(field_tree.second);
+        art_iter_leaves(field_tree.second, [](void* data, const art_leaf* leaf) {
+            *static_cast<uint64_t*>(data) += posting_t::memory_bytes(leaf->values);
+            return 0;
+        }, &posting_bytes);
+    }
+
+    uint64_t numerical_bytes = 0;
+    for(const auto& field_num_tree: numerical_index) {
+        numerical_bytes += field_num_tree.second->memory_bytes();
+    }
+
+    uint64_t bool_bytes = 0;
+    for(const auto& field_bool_index: bool_index) {
+        bool_bytes += field_bool_index.second->memory_bytes();
+    }
+
+    uint64_t materialized_bytes = 0;
+    for(const auto& field_value_map: materialized_filter_index) {
+        for(const auto& value_ids: *field_value_map.second) {
+            materialized_bytes += sizeof(int64_t) + sizeof(std::vector<uint32_t>) +
+                                  (value_ids.second.capacity() * sizeof(uint32_t));
+        }
+    }
+
+    uint64_t geo_bytes = 0;
+    for(const auto& field_geo_index: geopoint_index) {
+        geo_bytes += field_geo_index.second->memory_bytes();
+    }
+
+    for(const auto& field_geo_array: geo_array_index) {
+        for(const auto& id_latlngs: *field_geo_array.second) {
+            // packed lat/lng array stores its length at slot 0
+            geo_bytes += sizeof(uint32_t) + sizeof(int64_t*) +
+                         ((id_latlngs.second[0] + 1) * sizeof(int64_t));
+        }
+    }
+
+    uint64_t facet_bytes = 0;
+    for(const auto& field_facet_column: facet_index_v3) {
+        facet_bytes += field_facet_column.second->memory_bytes();
+    }
+
+    for(const auto& field_facet_value_index: facet_value_index) {
+        facet_bytes += field_facet_value_index.second->memory_bytes();
+    }
+
+    for(const auto& field_facet_value_store: facet_value_store) {
+        facet_bytes += field_facet_value_store.second->memory_bytes();
+    }
+
+    uint64_t sort_bytes = 0;
+    for(const auto& field_doc_values: sort_index) {
+        sort_bytes += field_doc_values.second->memory_bytes();
+    }
+
+    const uint64_t interner_bytes = token_interner.memory_bytes();
+    const uint64_t seq_ids_bytes = seq_ids.getSizeInBytes();
+
+    stats["art_tree_bytes"] = art_bytes;
+    stats["token_interner_bytes"] = interner_bytes;
+    stats["posting_list_bytes"] = posting_bytes;
+    stats["numerical_index_bytes"] = numerical_bytes;
+    stats["bool_index_bytes"] = bool_bytes;
+    stats["materialized_filter_index_bytes"] = materialized_bytes;
+    stats["geopoint_index_bytes"] = geo_bytes;
+    stats["facet_index_bytes"] = facet_bytes;
+    stats["sort_index_bytes"] = sort_bytes;
+    stats["seq_ids_bytes"] = seq_ids_bytes;
+    stats["total_bytes"] = art_bytes + interner_bytes + posting_bytes + numerical_bytes +
+                           bool_bytes + materialized_bytes + geo_bytes + facet_bytes +
+                           sort_bytes + seq_ids_bytes;
+}
+
+size_t Index::compact_posting_lists() {
+    std::unique_lock lock(mutex);
+    size_t num_reclaimed = 0;
+
+    art_callback cb = [](void* data, const unsigned char* key, uint32_t key_len, void* value) -> int {
+        if(value != nullptr && !IS_COMPACT_POSTING(value)) {
+            *((size_t*) data) += ((posting_list_t*) value)->compact_blocks();
+        }
+
+        return 0;
+    };
+
+    for(const auto& field_tree: search_index) {
+        art_iter(field_tree.second, cb, &num_reclaimed);
+    }
+
+    return num_reclaimed;
+}
+
+// dumps an ART leaf: key, max score and flattened postings
+static int dump_search_leaf(void* data, const art_leaf* leaf) {
+    auto& writer = *((index_snapshot_writer_t*) data);
+
+    writer.write_u32(leaf->key_len);
+    writer.write_bytes(leaf->key, leaf->key_len);
+    writer.write_i64(leaf->max_score);
+
+    std::vector<uint32_t> ids, offset_index, offsets;
+    posting_t::dump_flat(leaf->values, ids, offset_index, offsets);
+
+    writer.write_u32(uint32_t(ids.size()));
+    writer.write_u32s(ids.data(), ids.size());
+    writer.write_u32s(offset_index.data(), offset_index.size());
+    writer.write_u32(uint32_t(offsets.size()));
+    writer.write_u32s(offsets.data(), offsets.size());
+
+    return 0;
+}
+
+// dumps a facet value index leaf: every posting entry of these trees carries
+// the fixed offset list {0} (see facet_value_index_t::insert), so only the
+// ids are stored and the offsets are regenerated on load
+static int dump_facet_value_leaf(void* data, const art_leaf* leaf) {
+    auto& writer = *((index_snapshot_writer_t*) data);
+
+    writer.write_u32(leaf->key_len);
+    writer.write_bytes(leaf->key, leaf->key_len);
+    writer.write_i64(leaf->max_score);
+
+    std::vector<uint32_t> ids, offset_index, offsets;
+    posting_t::dump_flat(leaf->values, ids, offset_index, offsets);
+
+    writer.write_u32(uint32_t(ids.size()));
+    writer.write_u32s(ids.data(), ids.size());
+
+    return 0;
+}
+
+void Index::serialize_index_state(index_snapshot_writer_t& writer) {
+    std::shared_lock lock(mutex);
+
+    writer.write_u64(num_documents);
+
+    // seq ids
+    const uint32_t num_ids = seq_ids.getLength();
+    writer.write_u32(num_ids);
+
+    if(num_ids != 0) {
+        uint32_t* ids = seq_ids.uncompress();
+        writer.write_u32s(ids, num_ids);
+        delete [] ids;
+    }
+
+    // search index
+    writer.write_u64(search_index.size());
+
+    for(const auto& field_tree: search_index) {
+        writer.write_str(field_tree.first);
+        writer.write_u64(art_size(field_tree.second));
+        art_iter_leaves(field_tree.second, dump_search_leaf, &writer);
+    }
+
+    // numerical index
+    writer.write_u64(numerical_index.size());
+
+    for(const auto& field_tree: numerical_index) {
+        writer.write_str(field_tree.first);
+        writer.write_u64(field_tree.second->size());
+
+        field_tree.second->iterate_values(false, [&writer](int64_t value, sorted_array* arr) {
+            writer.write_i64(value);
+
+            const uint32_t arr_len = arr->getLength();
+            writer.write_u32(arr_len);
+
+            uint32_t* arr_ids = arr->uncompress();
+            writer.write_u32s(arr_ids, arr_len);
+            delete [] arr_ids;
+
+            return true;
+        });
+    }
+
+    // bool index
+    writer.write_u64(bool_index.size());
+
+    for(const auto& field_index: bool_index) {
+        writer.write_str(field_index.first);
+
+        for(bool value: {false, true}) {
+            const std::vector<uint64_t>& words = field_index.second->get_words(value);
+            writer.write_u64(words.size());
+            writer.write_bytes(words.data(), words.size() * sizeof(uint64_t));
+            writer.write_u64(field_index.second->num_ids(value));
+        }
+    }
+
+    // materialized filter index
+    writer.write_u64(materialized_filter_index.size());
+
+    for(const auto& field_index: materialized_filter_index) {
+        writer.write_str(field_index.first);
+        writer.write_u64(field_index.second->size());
+
+        for(const auto& value_ids: *field_index.second) {
+            writer.write_i64(value_ids.first);
+            writer.write_u32(uint32_t(value_ids.second.size()));
+            writer.write_u32s(value_ids.second.data(), value_ids.second.size());
+        }
+    }
+
+    // geopoint index
+    writer.write_u64(geopoint_index.size());
+
+    for(const auto& field_index: geopoint_index) {
+        writer.write_str(field_index.first);
+        writer.write_u64(field_index.second->num_cells());
+
+        field_index.second->iterate_cells([&writer](const std::string& term, const std::vector<uint32_t>& ids) {
+            writer.write_str(term);
+            writer.write_u32(uint32_t(ids.size()));
+            writer.write_u32s(ids.data(), ids.size());
+        });
+    }
+
+    // geo array index (packed lat/lng values per document)
+    writer.write_u64(geo_array_index.size());
+
+    for(const auto& field_index: geo_array_index) {
+        writer.write_str(field_index.first);
+        writer.write_u64(field_index.second->size());
+
+        for(const auto& seq_id_geos: *field_index.second) {
+            const int64_t* packed_latlongs = seq_id_geos.second;
+            const uint32_t num_latlongs = uint32_t(packed_latlongs[0]);
+
+            writer.write_u32(seq_id_geos.first);
+            writer.write_u32(num_latlongs);
+            writer.write_bytes(packed_latlongs + 1, num_latlongs * sizeof(int64_t));
+        }
+    }
+
+    // facet columns (only filled rows are stored)
+    writer.write_u64(facet_index_v3.size());
+
+    for(const auto& field_column: facet_index_v3) {
+        const facet_column_t* column = field_column.second;
+
+        uint32_t num_filled = 0;
+        for(uint32_t seq_id = 0; seq_id < column->num_rows(); seq_id++) {
+            if(column->get(seq_id) != nullptr) {
+                num_filled++;
+            }
+        }
+
+        writer.write_str(field_column.first);
+        writer.write_u32(num_filled);
+
+        for(uint32_t seq_id = 0; seq_id < column->num_rows(); seq_id++) {
+            const facet_hash_values_t* row = column->get(seq_id);
+            if(row == nullptr) {
+                continue;
+            }
+
+            writer.write_u32(seq_id);
+            writer.write_u32(row->length);
+            writer.write_bytes(row->hashes, row->length * sizeof(uint64_t));
+        }
+    }
+
+    // facet value store
+    writer.write_u64(facet_value_store.size());
+
+    for(const auto& field_store: facet_value_store) {
+        writer.write_str(field_store.first);
+        writer.write_u64(field_store.second->num_values());
+
+        field_store.second->iterate_values([&writer](uint64_t fhash, const std::string& value, uint32_t ref_count) {
+            writer.write_u64(fhash);
+            writer.write_str(value);
+            writer.write_u32(ref_count);
+        });
+    }
+
+    // facet value index: the (key => value hashes) map, then the prefix tree
+    writer.write_u64(facet_value_index.size());
+
+    for(const auto& field_index: facet_value_index) {
+        writer.write_str(field_index.first);
+        writer.write_u64(field_index.second->num_keys());
+
+        field_index.second->iterate_key_hashes([&writer](const std::string& key, const std::vector<uint64_t>& hashes) {
+            writer.write_str(key);
+            writer.write_u32(uint32_t(hashes.size()));
+            writer.write_bytes(hashes.data(), hashes.size() * sizeof(uint64_t));
+        });
+
+        art_tree* tree = field_index.second->get_tree();
+        writer.write_u64(art_size(tree));
+        art_iter_leaves(tree, dump_facet_value_leaf, &writer);
+    }
+
+    // sort doc-values (only valid slots are stored)
+    writer.write_u64(sort_index.size());
+
+    for(const auto& field_values: sort_index) {
+        const doc_values_t* doc_vals = field_values.second;
+
+        uint64_t num_valid = 0;
+        for(uint32_t seq_id = 0; seq_id < doc_vals->num_slots(); seq_id++) {
+            if(doc_vals->contains(seq_id)) {
+                num_valid++;
+            }
+        }
+
+        writer.write_str(field_values.first);
+        writer.write_u64(num_valid);
+
+        for(uint32_t seq_id = 0; seq_id < doc_vals->num_slots(); seq_id++) {
+            if(doc_vals->contains(seq_id)) {
+                writer.write_u32(seq_id);
+                writer.write_i64(doc_vals->at(seq_id));
+            }
+        }
+    }
+}
+
+bool Index::load_index_state(index_snapshot_reader_t& reader) {
+    std::unique_lock lock(mutex);
+
+    num_documents = reader.read_u64();
+
+    // seq ids
+    const uint32_t num_ids = reader.read_u32();
+
+    if(num_ids != 0) {
+        std::vector<uint32_t> ids(num_ids);
+        reader.read_u32s(ids.data(), num_ids);
+
+        if(!reader.ok()) {
+            return false;
+        }
+
+        seq_ids.load(ids.data(), num_ids);
+        seq_ids_version++;
+    }
+
+    // search index
+    const uint64_t num_trees = reader.read_u64();
+
+    for(uint64_t i = 0; i < num_trees; i++) {
+        const std::string field_name = reader.read_str();
+        const auto& tree_it = search_index.find(field_name);
+
+        if(!reader.ok() || tree_it == search_index.end()) {
+            return false;
+        }
+
+        const uint64_t num_leaves = reader.read_u64();
+
+        for(uint64_t j = 0; j < num_leaves; j++) {
+            const uint32_t key_len = reader.read_u32();
+            if(!reader.ok() || key_len == 0) {
+                return false;
+            }
+
+            std::vector<unsigned char> key(key_len);
+            reader.read_bytes(key.data(), key_len);
+
+            const int64_t max_score = reader.read_i64();
+            const uint32_t num_leaf_ids = reader.read_u32();
+
+            if(!reader.ok() || num_leaf_ids == 0) {
+                return false;
+            }
+
+            std::vector<uint32_t> leaf_ids(num_leaf_ids), offset_index(num_leaf_ids);
+            reader.read_u32s(leaf_ids.data(), num_leaf_ids);
+            reader.read_u32s(offset_index.data(), num_leaf_ids);
+
+            const uint32_t num_offsets = reader.read_u32();
+            std::vector<uint32_t> offsets(num_offsets);
+            reader.read_u32s(offsets.data(), num_offsets);
+
+            if(!reader.ok()) {
+                return false;
+            }
+
+            void* values = posting_t::load_flat(num_leaf_ids, leaf_ids.data(), offset_index.data(),
+                                                num_offsets, offsets.data());
+            art_load_leaf(tree_it->second, key.data(), key_len, max_score, values);
+        }
+    }
+
+    // numerical index
+    const uint64_t num_numerical_fields = reader.read_u64();
+
+    for(uint64_t i = 0; i < num_numerical_fields; i++) {
+        const std::string field_name = reader.read_str();
+        const auto& tree_it = numerical_index.find(field_name);
+
+        if(!reader.ok() || tree_it == numerical_index.end()) {
+            return false;
+        }
+
+        const uint64_t num_values = reader.read_u64();
+
+        for(uint64_t j = 0; j < num_values; j++) {
+            const int64_t value = reader.read_i64();
+            const uint32_t arr_len = reader.read_u32();
+
+            std::vector<uint32_t> arr_ids(arr_len);
+            reader.read_u32s(arr_ids.data(), arr_len);
+
+            if(!reader.ok()) {
+                return false;
+            }
+
+            tree_it->second->load(value, arr_ids.data(), arr_len);
+        }
+    }
+
+    // bool index
+    const uint64_t num_bool_fields = reader.read_u64();
+
+    for(uint64_t i = 0; i < num_bool_fields; i++) {
+        const std::string field_name = reader.read_str();
+        const auto& bool_it = bool_index.find(field_name);
+
+        if(!reader.ok() || bool_it == bool_index.end()) {
+            return false;
+        }
+
+        for(bool value: {false, true}) {
+            const uint64_t num_words = reader.read_u64();
+
+            std::vector<uint64_t> words(num_words);
+            reader.read_bytes(words.data(), num_words * sizeof(uint64_t));
+
+            const uint64_t num_set_ids = reader.read_u64();
+
+            if(!reader.ok()) {
+                return false;
+            }
+
+            bool_it->second->load_words(value, std::move(words), num_set_ids);
+        }
+    }
+
+    // materialized filter index
+    const uint64_t num_materialized_fields = reader.read_u64();
+
+    for(uint64_t i = 0; i < num_materialized_fields; i++) {
+        const std::string field_name = reader.read_str();
+        const auto& field_it = materialized_filter_index.find(field_name);
+
+        if(!reader.ok() || field_it == materialized_filter_index.end()) {
+            return false;
+        }
+
+        const uint64_t num_values = reader.read_u64();
+
+        for(uint64_t j = 0; j < num_values; j++) {
+            const int64_t value = reader.read_i64();
+            const uint32_t value_num_ids = reader.read_u32();
+
+            std::vector<uint32_t> value_ids(value_num_ids);
+            reader.read_u32s(value_ids.data(), value_num_ids);
+
+            if(!reader.ok()) {
+                return false;
+            }
+
+            (*field_it->second)[value] = std::move(value_ids);
+        }
+    }
+
+    // geopoint index
+    const uint64_t num_geo_fields = reader.read_u64();
+
+    for(uint64_t i = 0; i < num_geo_fields; i++) {
+        const std::string field_name = reader.read_str();
+        const auto& field_it = geopoint_index.find(field_name);
+
+        if(!reader.ok() || field_it == geopoint_index.end()) {
+            return false;
+        }
+
+        const uint64_t num_cells = reader.read_u64();
+
+        for(uint64_t j = 0; j < num_cells; j++) {
+            std::string term = reader.read_str();
+            const uint32_t cell_num_ids = reader.read_u32();
+
+            std::vector<uint32_t> cell_ids(cell_num_ids);
+            reader.read_u32s(cell_ids.data(), cell_num_ids);
+
+            if(!reader.ok()) {
+                return false;
+            }
+
+            field_it->second->load_cell(std::move(term), std::move(cell_ids));
+        }
+    }
+
+    // geo array index
+    const uint64_t num_geo_array_fields = reader.read_u64();
+
+    for(uint64_t i = 0; i < num_geo_array_fields; i++) {
+        const std::string field_name = reader.read_str();
+        const auto& field_it = geo_array_index.find(field_name);
+
+        if(!reader.ok() || field_it == geo_array_index.end()) {
+            return false;
+        }
+
+        const uint64_t num_docs = reader.read_u64();
+
+        for(uint64_t j = 0; j < num_docs; j++) {
+            const uint32_t seq_id = reader.read_u32();
+            const uint32_t num_latlongs = reader.read_u32();
+
+            if(!reader.ok()) {
+                return false;
+            }
+
+            int64_t* packed_latlongs = new int64_t[num_latlongs + 1];
+            packed_latlongs[0] = num_latlongs;
+            reader.read_bytes(packed_latlongs + 1, num_latlongs * sizeof(int64_t));
+
+            if(!reader.ok()) {
+                delete [] packed_latlongs;
+                return false;
+            }
+
+            field_it->second->emplace(seq_id, packed_latlongs);
+        }
+    }
+
+    // facet columns
+    const uint64_t num_facet_columns = reader.read_u64();
+
+    for(uint64_t i = 0; i < num_facet_columns; i++) {
+        const std::string field_name = reader.read_str();
+        const auto& field_it = facet_index_v3.find(field_name);
+
+        if(!reader.ok() || field_it == facet_index_v3.end()) {
+            return false;
+        }
+
+        const uint32_t num_filled = reader.read_u32();
+
+        for(uint32_t j = 0; j < num_filled; j++) {
+            const uint32_t seq_id = reader.read_u32();
+            const uint32_t row_len = reader.read_u32();
+
+            if(!reader.ok() || row_len == 0) {
+                return false;
+            }
+
+            facet_hash_values_t fhashvalues;
+            fhashvalues.length = row_len;
+            fhashvalues.hashes = new uint64_t[row_len];
+            reader.read_bytes(fhashvalues.hashes, row_len * sizeof(uint64_t));
+
+            if(!reader.ok()) {
+                return false;
+            }
+
+            field_it->second->upsert(seq_id, std::move(fhashvalues));
+        }
+    }
+
+    // facet value store
+    const uint64_t num_facet_stores = reader.read_u64();
+
+    for(uint64_t i = 0; i < num_facet_stores; i++) {
+        const std::string field_name = reader.read_str();
+        const auto& field_it = facet_value_store.find(field_name);
+
+        if(!reader.ok() || field_it == facet_value_store.end()) {
+            return false;
+        }
+
+        const uint64_t num_values = reader.read_u64();
+
+        for(uint64_t j = 0; j < num_values; j++) {
+            const uint64_t fhash = reader.read_u64();
+            std::string value = reader.read_str();
+            const uint32_t ref_count = reader.read_u32();
+
+            if(!reader.ok()) {
+                return false;
+            }
+
+            field_it->second->load_value(fhash, std::move(value), ref_count);
+        }
+    }
+
+    // facet value index
+    const uint64_t num_facet_value_indices = reader.read_u64();
+
+    for(uint64_t i = 0; i < num_facet_value_indices; i++) {
+        const std::string field_name = reader.read_str();
+        const auto& field_it = facet_value_index.find(field_name);
+
+        if(!reader.ok() || field_it == facet_value_index.end()) {
+            return false;
+        }
+
+        const uint64_t num_keys = reader.read_u64();
+
+        for(uint64_t j = 0; j < num_keys; j++) {
+            std::string key = reader.read_str();
+            const uint32_t num_hashes = reader.read_u32();
+
+            std::vector<uint64_t> hashes(num_hashes);
+            reader.read_bytes(hashes.data(), num_hashes * sizeof(uint64_t));
+
+            if(!reader.ok()) {
+                return false;
+            }
+
+            field_it->second->load_key_hashes(std::move(key), std::move(hashes));
+        }
+
+        const uint64_t num_leaves = reader.read_u64();
+
+        for(uint64_t j = 0; j < num_leaves; j++) {
+            const uint32_t key_len = reader.read_u32();
+            if(!reader.ok() || key_len == 0) {
+                return false;
+            }
+
+            std::vector<unsigned char> key(key_len);
+            reader.read_bytes(key.data(), key_len);
+
+            const int64_t max_score = reader.read_i64();
+            const uint32_t num_leaf_ids = reader.read_u32();
+
+            if(!reader.ok() || num_leaf_ids == 0) {
+                return false;
+            }
+
+            std::vector<uint32_t> leaf_ids(num_leaf_ids);
+            reader.read_u32s(leaf_ids.data(), num_leaf_ids);
+
+            if(!reader.ok()) {
+                return false;
+            }
+
+            // regenerate the fixed {0} offset list each posting entry carries
+            std::vector<uint32_t> offset_index(num_leaf_ids), offsets(num_leaf_ids, 0);
+            for(uint32_t k = 0; k < num_leaf_ids; k++) {
+                offset_index[k] = k;
+            }
+
+            void* values = posting_t::load_flat(num_leaf_ids, leaf_ids.data(), offset_index.data(),
+                                                num_leaf_ids, offsets.data());
+            art_load_leaf(field_it->second->get_tree(), key.data(), key_len, max_score, values);
+        }
+    }
+
+    // sort doc-values
+    const uint64_t num_sort_fields = reader.read_u64();
+
+    for(uint64_t i = 0; i < num_sort_fields; i++) {
+        const std::string field_name = reader.read_str();
+        const auto& field_it = sort_index.find(field_name);
+
+        if(!reader.ok() || field_it == sort_index.end()) {
+            return false;
+        }
+
+        const uint64_t num_valid = reader.read_u64();
+
+        for(uint64_t j = 0; j < num_valid; j++) {
+            const uint32_t seq_id = reader.read_u32();
+            const int64_t value = reader.read_i64();
+
+            if(!reader.ok()) {
+                return false;
+            }
+
+            field_it->second->upsert(seq_id, value);
+        }
+    }
+
+    return reader.ok();
+}
+
 /*
 // https://stackoverflow.com/questions/924171/geo-fencing-point-inside-outside-polygon
 // NOTE: polygon and point should have been transformed with `transform_for_180th_meridian`
@@ -17,7 +17,8 @@ extern "C" {
 void master_server_routes() {
     // collection operations
     // NOTE: placing this first to score an immediate hit on O(N) route search
-    server->get("/collections/:collection/documents/search", get_search);
+    // search serializes its hits in batches through the streaming machinery
+    server->get("/collections/:collection/documents/search", get_search, false, true);
     server->post("/multi_search", post_multi_search);
 
     // document management
@@ -28,6 +29,10 @@ void master_server_routes() {
     server->post("/collections/:collection/documents/import", post_import_documents, true, true);
     server->get("/collections/:collection/documents/export", get_export_documents, false, true);
 
+    // background delete-by-filter jobs (submitted via `DELETE /documents?async=true`)
+    server->get("/collections/:collection/documents/delete_jobs/:id", get_delete_job);
+    server->del("/collections/:collection/documents/delete_jobs/:id", del_delete_job);
+
     server->get("/collections/:collection/documents/:id", get_fetch_document);
     server->patch("/collections/:collection/documents/:id", patch_update_document);
     server->del("/collections/:collection/documents/:id", del_remove_document);
@@ -46,6 +51,7 @@ void master_server_routes() {
     server->post("/collections", post_create_collection);
     server->get("/collections", get_collections);
     server->del("/collections/:collection", del_drop_collection);
+    server->get("/collections/:collection/stats", get_collection_stats);
     server->get("/collections/:collection", get_collection_summary);
 
     server->get("/aliases", get_aliases);
@@ -61,6 +67,7 @@ void master_server_routes() {
     // meta
     server->get("/metrics.json", get_metrics_json);
     server->get("/stats.json", get_stats_json);
+    server->get("/debug/rocksdb", get_debug_rocksdb);
     server->get("/debug", get_debug);
     server->get("/health", get_health);
     server->post("/health", post_health);
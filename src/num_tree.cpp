@@ -1,34 +1,157 @@
 #include "num_tree.h"
 #include "parasort.h"
 
-void num_tree_t::insert(int64_t value, uint32_t id) {
-    if (int64map.count(value) == 0) {
-        int64map.emplace(value, new sorted_array);
+size_t num_tree_t::page_index_of(int64_t value) const {
+    // last page whose first key is <= value (page 0 when value precedes all keys)
+    auto it = std::upper_bound(page_first_keys.begin(), page_first_keys.end(), value);
+    return (it == page_first_keys.begin()) ? 0 : (it - page_first_keys.begin()) - 1;
+}
+
+sorted_array* num_tree_t::find_value(int64_t value) const {
+    if(pages.empty()) {
+        return nullptr;
     }
 
-    if (!int64map[value]->contains(id)) {
-        int64map[value]->append(id);
+    leaf_page_t* page = pages[page_index_of(value)];
+    size_t pos = std::lower_bound(page->keys.begin(), page->keys.end(), value) - page->keys.begin();
+
+    if(pos == page->keys.size() || page->keys[pos] != value) {
+        return nullptr;
     }
+
+    return page->values[pos];
 }
 
-void num_tree_t::range_inclusive_search(int64_t start, int64_t end, uint32_t** ids, size_t& ids_len) {
-    if(int64map.empty()) {
+sorted_array* num_tree_t::get_or_create(int64_t value) {
+    if(pages.empty()) {
+        leaf_page_t* page = new leaf_page_t;
+        page->keys.push_back(value);
+        page->values.push_back(new sorted_array);
+
+        pages.push_back(page);
+        page_first_keys.push_back(value);
+        num_keys = 1;
+
+        return page->values[0];
+    }
+
+    size_t page_index = page_index_of(value);
+    leaf_page_t* page = pages[page_index];
+    size_t pos = std::lower_bound(page->keys.begin(), page->keys.end(), value) - page->keys.begin();
+
+    // the caller is going to mutate one of this page's arrays
+    delete page->id_union;
+    page->id_union = nullptr;
+
+    if(pos != page->keys.size() && page->keys[pos] == value) {
+        return page->values[pos];
+    }
+
+    sorted_array* arr = new sorted_array;
+    page->keys.insert(page->keys.begin() + pos, value);
+    page->values.insert(page->values.begin() + pos, arr);
+    num_keys++;
+
+    if(pos == 0) {
+        page_first_keys[page_index] = value;
+    }
+
+    if(page->keys.size() > LEAF_FANOUT) {
+        // split: move the upper half into a fresh page chained after this one
+        size_t half = page->keys.size() / 2;
+
+        leaf_page_t* new_page = new leaf_page_t;
+        new_page->keys.assign(page->keys.begin() + half, page->keys.end());
+        new_page->values.assign(page->values.begin() + half, page->values.end());
+        new_page->next = page->next;
+
+        page->keys.resize(half);
+        page->values.resize(half);
+        page->next = new_page;
+
+        pages.insert(pages.begin() + page_index + 1, new_page);
+        page_first_keys.insert(page_first_keys.begin() + page_index + 1, new_page->keys[0]);
+    }
+
+    return arr;
+}
+
+void num_tree_t::insert(int64_t value, uint32_t id) {
+    sorted_array* arr = get_or_create(value);
+
+    if(!arr->contains(id)) {
+        arr->append(id);
+    }
+}
+
+void num_tree_t::load(int64_t value, const uint32_t* ids, const uint32_t ids_len) {
+    get_or_create(value)->load(ids, ids_len);
+}
+
+void num_tree_t::collect_range_ids(int64_t start, int64_t end, std::vector<uint32_t>& consolidated_ids) {
+    if(pages.empty()) {
         return ;
     }
 
-    auto it_start = int64map.lower_bound(start);  // iter values will be >= start
+    leaf_page_t* page = pages[page_index_of(start)];
+    size_t i = std::lower_bound(page->keys.begin(), page->keys.end(), start) - page->keys.begin();
 
-    std::vector<uint32_t> consolidated_ids;
-    while(it_start != int64map.end() && it_start->first <= end) {
-        uint32_t* values = it_start->second->uncompress();
+    if(i == page->keys.size()) {
+        page = page->next;
+        i = 0;
+    }
+
+    while(page != nullptr && page->keys[i] <= end) {
+        if(i == 0 && page->keys.back() <= end) {
+            // page fully covered by the range: merge its cached id union
+            if(page->id_union == nullptr) {
+                std::vector<uint32_t> page_ids;
 
-        for(size_t i = 0; i < it_start->second->getLength(); i++) {
-            consolidated_ids.push_back(values[i]);
+                for(size_t j = 0; j < page->values.size(); j++) {
+                    uint32_t* values = page->values[j]->uncompress();
+                    page_ids.insert(page_ids.end(), values, values + page->values[j]->getLength());
+                    delete [] values;
+                }
+
+                std::sort(page_ids.begin(), page_ids.end());
+                page_ids.erase(std::unique(page_ids.begin(), page_ids.end()), page_ids.end());
+
+                page->id_union = new sorted_array;
+                page->id_union->load(page_ids.empty() ? nullptr : &page_ids[0], page_ids.size());
+            }
+
+            uint32_t* values = page->id_union->uncompress();
+            consolidated_ids.insert(consolidated_ids.end(), values, values + page->id_union->getLength());
+            delete [] values;
+
+            page = page->next;
+            i = 0;
+            continue;
+        }
+
+        // partially covered page: walk its values one key at a time
+        uint32_t* values = page->values[i]->uncompress();
+
+        for(size_t j = 0; j < page->values[i]->getLength(); j++) {
+            consolidated_ids.push_back(values[j]);
         }
 
         delete [] values;
-        it_start++;
+
+        if(++i == page->keys.size()) {
+            page = page->next;
+            i = 0;
+        }
     }
+}
+
+void num_tree_t::range_inclusive_search(int64_t start, int64_t end, uint32_t** ids, size_t& ids_len) {
+    if(pages.empty()) {
+        return ;
+    }
+
+    std::vector<uint32_t> consolidated_ids;
+    collect_range_ids(start, end, consolidated_ids);
 
     if(consolidated_ids.size() > 50000) {
         parasort(consolidated_ids.size(), &consolidated_ids[0], 4);
@@ -36,6 +159,8 @@ void num_tree_t::range_inclusive_search(int64_t start, int64_t end, uint32_t** i
         std::sort(consolidated_ids.begin(), consolidated_ids.end());
     }
 
+    consolidated_ids.erase(unique(consolidated_ids.begin(), consolidated_ids.end()), consolidated_ids.end());
+
     uint32_t *out = nullptr;
     ids_len = ArrayUtils::or_scalar(&consolidated_ids[0], consolidated_ids.size(),
                                     *ids, ids_len, &out);
@@ -45,59 +170,66 @@ void num_tree_t::range_inclusive_search(int64_t start, int64_t end, uint32_t** i
 }
 
 size_t num_tree_t::get(int64_t value, std::vector<uint32_t>& geo_result_ids) {
-    const auto& it = int64map.find(value);
-    if(it == int64map.end()) {
+    sorted_array* arr = find_value(value);
+
+    if(arr == nullptr) {
         return 0;
     }
 
-    uint32_t* ids = it->second->uncompress();
-    for(size_t i = 0; i < it->second->getLength(); i++) {
+    uint32_t* ids = arr->uncompress();
+    for(size_t i = 0; i < arr->getLength(); i++) {
         geo_result_ids.push_back(ids[i]);
     }
 
     delete [] ids;
 
-    return it->second->getLength();
+    return arr->getLength();
 }
 
 void num_tree_t::search(NUM_COMPARATOR comparator, int64_t value, uint32_t** ids, size_t& ids_len) {
-    if(int64map.empty()) {
+    if(pages.empty()) {
         return ;
     }
 
     if(comparator == EQUALS) {
-        const auto& it = int64map.find(value);
-        if(it != int64map.end()) {
+        sorted_array* arr = find_value(value);
+
+        if(arr != nullptr) {
             uint32_t *out = nullptr;
-            uint32_t* val_ids = it->second->uncompress();
-            ids_len = ArrayUtils::or_scalar(val_ids, it->second->getLength(),
+            uint32_t* val_ids = arr->uncompress();
+            ids_len = ArrayUtils::or_scalar(val_ids, arr->getLength(),
                                             *ids, ids_len, &out);
             delete[] *ids;
             *ids = out;
             delete[] val_ids;
         }
-    } else if(comparator == GREATER_THAN || comparator == GREATER_THAN_EQUALS) {
-        // iter entries will be >= value, or end() if all entries are before value
-        auto iter_ge_value = int64map.lower_bound(value);
+    } else {
+        // the ordered comparators are open-ended ranges over the leaf chain
+        int64_t range_start, range_end;
 
-        if(iter_ge_value == int64map.end()) {
-            return ;
-        }
+        if(comparator == GREATER_THAN || comparator == GREATER_THAN_EQUALS) {
+            if(comparator == GREATER_THAN && value == std::numeric_limits<int64_t>::max()) {
+                return ;
+            }
+
+            range_start = (comparator == GREATER_THAN) ? value + 1 : value;
+            range_end = std::numeric_limits<int64_t>::max();
+        } else if(comparator == LESS_THAN || comparator == LESS_THAN_EQUALS) {
+            if(comparator == LESS_THAN && value == std::numeric_limits<int64_t>::min()) {
+                return ;
+            }
 
-        if(comparator == GREATER_THAN && iter_ge_value->first == value) {
-            iter_ge_value++;
+            range_start = std::numeric_limits<int64_t>::min();
+            range_end = (comparator == LESS_THAN) ? value - 1 : value;
+        } else {
+            return ;
         }
 
         std::vector<uint32_t> consolidated_ids;
-        while(iter_ge_value != int64map.end()) {
-            uint32_t* values = iter_ge_value->second->uncompress();
-
-            for(size_t i = 0; i < iter_ge_value->second->getLength(); i++) {
-                consolidated_ids.push_back(values[i]);
-            }
+        collect_range_ids(range_start, range_end, consolidated_ids);
 
-            delete [] values;
-            iter_ge_value++;
+        if(consolidated_ids.empty()) {
+            return ;
         }
 
         if(consolidated_ids.size() > 50000) {
@@ -114,62 +246,94 @@ void num_tree_t::search(NUM_COMPARATOR comparator, int64_t value, uint32_t** ids
 
         delete [] *ids;
         *ids = out;
+    }
+}
 
-    } else if(comparator == LESS_THAN || comparator == LESS_THAN_EQUALS) {
-        // iter entries will be >= value, or end() if all entries are before value
-        auto iter_ge_value = int64map.lower_bound(value);
+void num_tree_t::remove(uint64_t value, uint32_t id) {
+    if(pages.empty()) {
+        return ;
+    }
 
-        std::vector<uint32_t> consolidated_ids;
-        auto it = int64map.begin();
+    const int64_t key = value;
+    size_t page_index = page_index_of(key);
+    leaf_page_t* page = pages[page_index];
+    size_t pos = std::lower_bound(page->keys.begin(), page->keys.end(), key) - page->keys.begin();
 
-        while(it != iter_ge_value) {
-            uint32_t* values = it->second->uncompress();
+    if(pos == page->keys.size() || page->keys[pos] != key) {
+        return ;
+    }
 
-            for(size_t i = 0; i < it->second->getLength(); i++) {
-                consolidated_ids.push_back(values[i]);
+    delete page->id_union;
+    page->id_union = nullptr;
+
+    sorted_array* arr = page->values[pos];
+    arr->remove_value(id);
+
+    if(arr->getLength() == 0) {
+        delete arr;
+        page->keys.erase(page->keys.begin() + pos);
+        page->values.erase(page->values.begin() + pos);
+        num_keys--;
+
+        if(page->keys.empty()) {
+            // unlink and drop the empty page
+            if(page_index != 0) {
+                pages[page_index - 1]->next = page->next;
             }
 
-            delete [] values;
-            it++;
+            delete page;
+            pages.erase(pages.begin() + page_index);
+            page_first_keys.erase(page_first_keys.begin() + page_index);
+        } else if(pos == 0) {
+            page_first_keys[page_index] = page->keys[0];
         }
+    }
+}
 
-        // for LESS_THAN_EQUALS, check if last iter entry is equal to value
-        if(it != int64map.end() && comparator == LESS_THAN_EQUALS && it->first == value) {
-            uint32_t* values = it->second->uncompress();
-            for(size_t i = 0; i < it->second->getLength(); i++) {
-                consolidated_ids.push_back(values[i]);
+void num_tree_t::iterate_values(const bool descending,
+                                const std::function<bool(int64_t, sorted_array*)>& func) {
+    if(descending) {
+        for(size_t page_index = pages.size(); page_index-- > 0; ) {
+            leaf_page_t* page = pages[page_index];
+            for(size_t pos = page->keys.size(); pos-- > 0; ) {
+                if(!func(page->keys[pos], page->values[pos])) {
+                    return;
+                }
             }
-            delete [] values;
         }
-
-        if(consolidated_ids.size() > 50000) {
-            parasort(consolidated_ids.size(), &consolidated_ids[0], 4);
-        } else {
-            std::sort(consolidated_ids.begin(), consolidated_ids.end());
+    } else {
+        for(leaf_page_t* page: pages) {
+            for(size_t pos = 0; pos < page->keys.size(); pos++) {
+                if(!func(page->keys[pos], page->values[pos])) {
+                    return;
+                }
+            }
         }
+    }
+}
 
-        consolidated_ids.erase(unique(consolidated_ids.begin(), consolidated_ids.end()), consolidated_ids.end());
+size_t num_tree_t::size() {
+    return num_keys;
+}
 
-        uint32_t *out = nullptr;
-        ids_len = ArrayUtils::or_scalar(&consolidated_ids[0], consolidated_ids.size(),
-                                        *ids, ids_len, &out);
+size_t num_tree_t::memory_bytes() const {
+    size_t bytes = sizeof(num_tree_t);
+    bytes += page_first_keys.capacity() * sizeof(int64_t);
+    bytes += pages.capacity() * sizeof(leaf_page_t*);
 
-        delete [] *ids;
-        *ids = out;
-    }
-}
+    for(const leaf_page_t* page: pages) {
+        bytes += sizeof(leaf_page_t);
+        bytes += page->keys.capacity() * sizeof(int64_t);
+        bytes += page->values.capacity() * sizeof(sorted_array*);
 
-void num_tree_t::remove(uint64_t value, uint32_t id) {
-    if(int64map.count(value) != 0) {
-        sorted_array* arr = int64map[value];
-        arr->remove_value(id);
-        if(arr->getLength() == 0) {
-            delete arr;
-            int64map.erase(value);
+        for(const sorted_array* arr: page->values) {
+            bytes += sizeof(sorted_array) + arr->getSizeInBytes();
+        }
+
+        if(page->id_union != nullptr) {
+            bytes += sizeof(sorted_array) + page->id_union->getSizeInBytes();
         }
     }
-}
 
-size_t num_tree_t::size() {
-    return int64map.size();
-}
\ No newline at end of file
+    return bytes;
+}
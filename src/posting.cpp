@@ -139,11 +139,15 @@ compact_posting_list_t* compact_posting_list_t::create(uint32_t num_ids, const u
     // format: num_offsets, offset1,..,offsetn, id1 | num_offsets, offset1,..,offsetn, id2
 
     size_t length_required = num_offsets + (2 * num_ids);
+
+    // leave some slack so the first few appends don't each trigger a realloc
+    size_t alloc_length = length_required + std::max<size_t>(4, length_required / 2);
+
     compact_posting_list_t* pl = (compact_posting_list_t*) malloc(sizeof(compact_posting_list_t) +
-                                                                  (length_required * sizeof(uint32_t)));
+                                                                  (alloc_length * sizeof(uint32_t)));
 
     pl->length = 0;
-    pl->capacity = length_required;
+    pl->capacity = alloc_length;
     pl->ids_length = 0;
 
     for(size_t i = 0; i < num_ids; i++) {
@@ -158,19 +162,28 @@ compact_posting_list_t* compact_posting_list_t::create(uint32_t num_ids, const u
 posting_list_t* compact_posting_list_t::to_full_posting_list() const {
     posting_list_t* pl = new posting_list_t(posting_t::MAX_BLOCK_ELEMENTS);
 
+    // decode the flat stream once and bulk-load whole blocks, instead of
+    // paying a block re-encode per upserted id
+    std::vector<uint32_t> ids, offset_index, offsets;
+    ids.reserve(ids_length);
+    offset_index.reserve(ids_length);
+    offsets.reserve(length);
+
     size_t i = 0;
     while(i < length) {
         size_t num_existing_offsets = id_offsets[i];
-        i++;
-        std::vector<uint32_t> offsets(num_existing_offsets);
+        offset_index.push_back(offsets.size());
+
         for(size_t j = 0; j < num_existing_offsets; j++) {
-            auto offset = id_offsets[i + j];
-            offsets[j] = offset;
+            offsets.push_back(id_offsets[i + 1 + j]);
         }
 
-        size_t existing_id = id_offsets[i + num_existing_offsets];
-        pl->upsert(existing_id, offsets);
-        i += num_existing_offsets + 1;
+        ids.push_back(id_offsets[i + num_existing_offsets + 1]);
+        i += num_existing_offsets + 2;
+    }
+
+    if(!ids.empty()) {
+        pl->load_sorted(&ids[0], ids.size(), &offset_index[0], &offsets[0], offsets.size());
     }
 
     return pl;
@@ -245,7 +258,7 @@ bool compact_posting_list_t::contains_atleast_one(const uint32_t* target_ids, si
 
 /* posting operations */
 
-void posting_t::upsert(void*& obj, uint32_t id, const std::vector<uint32_t>& offsets) {
+void posting_t::upsert(void*& obj, uint32_t id, const std::vector<uint32_t>& offsets, const int64_t score) {
     if(IS_COMPACT_POSTING(obj)) {
         compact_posting_list_t* list = (compact_posting_list_t*) RAW_POSTING_PTR(obj);
         int64_t extra_capacity_required = list->upsert(id, offsets);
@@ -263,9 +276,10 @@ void posting_t::upsert(void*& obj, uint32_t id, const std::vector<uint32_t>& off
         }
 
         else {
-            // grow the container by 30%
-            size_t new_capacity = std::min<size_t>((list->capacity + extra_capacity_required) * 1.3,
-                                                   COMPACT_LIST_THRESHOLD_LENGTH);
+            // grow geometrically: at least 30% over what's needed, or double the current capacity
+            size_t new_capacity = std::max<size_t>((list->capacity + extra_capacity_required) * 1.3,
+                                                   list->capacity * 2);
+            new_capacity = std::min<size_t>(new_capacity, COMPACT_LIST_THRESHOLD_LENGTH);
 
             size_t new_capacity_bytes = sizeof(compact_posting_list_t) + (new_capacity * sizeof(uint32_t));
             auto new_list = (compact_posting_list_t *) realloc(list, new_capacity_bytes);
@@ -285,7 +299,7 @@ void posting_t::upsert(void*& obj, uint32_t id, const std::vector<uint32_t>& off
 
     // either `obj` is already a full list or was converted to a full list above
     posting_list_t* list = (posting_list_t*)(obj);
-    list->upsert(id, offsets);
+    list->upsert(id, offsets, score);
 }
 
 void posting_t::erase(void*& obj, uint32_t id) {
@@ -343,6 +357,16 @@ uint32_t posting_t::num_ids(const void* obj) {
     }
 }
 
+size_t posting_t::memory_bytes(const void* obj) {
+    if(IS_COMPACT_POSTING(obj)) {
+        compact_posting_list_t* list = COMPACT_POSTING_PTR(obj);
+        return sizeof(compact_posting_list_t) + (list->capacity * sizeof(uint32_t));
+    } else {
+        const posting_list_t* list = (const posting_list_t*)(obj);
+        return list->memory_bytes();
+    }
+}
+
 uint32_t posting_t::first_id(const void* obj) {
     if(IS_COMPACT_POSTING(obj)) {
         compact_posting_list_t* list = COMPACT_POSTING_PTR(obj);
@@ -545,3 +569,79 @@ void posting_t::block_intersector_t::split_lists(size_t concurrency,
         curr_block = curr_block->next;
     }
 }
+
+void posting_t::dump_flat(const void* obj, std::vector<uint32_t>& ids,
+                          std::vector<uint32_t>& offset_index, std::vector<uint32_t>& offsets) {
+    if(IS_COMPACT_POSTING(obj)) {
+        compact_posting_list_t* list = COMPACT_POSTING_PTR(obj);
+
+        ids.reserve(list->ids_length);
+        offset_index.reserve(list->ids_length);
+        offsets.reserve(list->length);
+
+        size_t i = 0;
+        while(i < list->length) {
+            size_t num_existing_offsets = list->id_offsets[i];
+            offset_index.push_back(offsets.size());
+
+            for(size_t j = 0; j < num_existing_offsets; j++) {
+                offsets.push_back(list->id_offsets[i + 1 + j]);
+            }
+
+            ids.push_back(list->id_offsets[i + num_existing_offsets + 1]);
+            i += num_existing_offsets + 2;
+        }
+
+        return;
+    }
+
+    posting_list_t* list = (posting_list_t*)(obj);
+
+    ids.reserve(list->num_ids());
+    offset_index.reserve(list->num_ids());
+
+    posting_list_t::block_t* block = list->get_root();
+
+    while(block != nullptr) {
+        const uint32_t block_len = block->size();
+
+        uint32_t* block_ids = block->ids.uncompress();
+        uint32_t* block_offset_index = block->offset_index.uncompress();
+        uint32_t* block_offsets = block->offsets.uncompress();
+
+        // block offset index entries are block-relative, so they are rebased
+        // onto the flat offsets array being accumulated
+        const uint32_t offsets_base = offsets.size();
+
+        for(uint32_t i = 0; i < block_len; i++) {
+            ids.push_back(block_ids[i]);
+            offset_index.push_back(offsets_base + block_offset_index[i]);
+        }
+
+        const uint32_t num_block_offsets = block->offsets.getLength();
+        for(uint32_t i = 0; i < num_block_offsets; i++) {
+            offsets.push_back(block_offsets[i]);
+        }
+
+        delete [] block_ids;
+        delete [] block_offset_index;
+        delete [] block_offsets;
+
+        block = block->next;
+    }
+}
+
+void* posting_t::load_flat(const uint32_t num_ids, const uint32_t* ids, const uint32_t* offset_index,
+                           const uint32_t num_offsets, const uint32_t* offsets) {
+    const size_t length_required = num_offsets + (2 * num_ids);
+
+    if(length_required <= COMPACT_LIST_THRESHOLD_LENGTH) {
+        compact_posting_list_t* list = compact_posting_list_t::create(num_ids, ids, offset_index,
+                                                                      num_offsets, offsets);
+        return SET_COMPACT_POSTING(list);
+    }
+
+    posting_list_t* list = new posting_list_t(MAX_BLOCK_ELEMENTS);
+    list->load_sorted(ids, num_ids, offset_index, offsets, num_offsets);
+    return list;
+}
@@ -1,8 +1,64 @@
 #include "posting_list.h"
+#include <algorithm>
 #include <bitset>
 #include "for.h"
 #include "array_utils.h"
 
+namespace {
+    // Iterators decode every visited block's ids, offset_index and offsets
+    // arrays, so a multi-token search used to do a heap allocation (and free)
+    // per block per posting list. Each thread instead keeps a small free list
+    // of fixed-size decode buffers: fixed-size makes release O(1) even when a
+    // buffer is freed on a different thread than the one that acquired it
+    // (iterators are constructed on the search thread but consumed on pool
+    // threads). Oversized decodes — long offset streams mostly — fall back to
+    // a plain heap allocation.
+    constexpr size_t SCRATCH_BUFFER_LENGTH = 4096;
+    constexpr size_t SCRATCH_MAX_POOLED_BUFFERS = 64;
+
+    struct scratch_pool_t {
+        std::vector<uint32_t*> free_buffers;
+
+        ~scratch_pool_t() {
+            for(uint32_t* buffer: free_buffers) {
+                delete [] buffer;
+            }
+        }
+    };
+
+    thread_local scratch_pool_t scratch_pool;
+
+    uint32_t* scratch_acquire(uint32_t length, bool& pooled) {
+        if(length > SCRATCH_BUFFER_LENGTH) {
+            pooled = false;
+            return new uint32_t[length];
+        }
+
+        pooled = true;
+
+        if(scratch_pool.free_buffers.empty()) {
+            return new uint32_t[SCRATCH_BUFFER_LENGTH];
+        }
+
+        uint32_t* buffer = scratch_pool.free_buffers.back();
+        scratch_pool.free_buffers.pop_back();
+        return buffer;
+    }
+
+    void scratch_release(uint32_t* buffer, bool pooled) {
+        if(buffer == nullptr) {
+            return;
+        }
+
+        if(!pooled || scratch_pool.free_buffers.size() == SCRATCH_MAX_POOLED_BUFFERS) {
+            delete [] buffer;
+            return;
+        }
+
+        scratch_pool.free_buffers.push_back(buffer);
+    }
+}
+
 /* block_t operations */
 
 uint32_t posting_list_t::block_t::upsert(const uint32_t id, const std::vector<uint32_t>& positions) {
@@ -183,6 +239,32 @@ bool posting_list_t::block_t::contains(uint32_t id) {
     return ids.contains(id);
 }
 
+/* id_bitmap_t operations */
+
+void id_bitmap_t::set(uint32_t id) {
+    uint32_t chunk_index = id >> CHUNK_SHIFT;
+    if(chunk_index >= chunks.size()) {
+        chunks.resize(chunk_index + 1, nullptr);
+    }
+
+    if(chunks[chunk_index] == nullptr) {
+        chunks[chunk_index] = new uint64_t[WORDS_PER_CHUNK]();
+    }
+
+    uint32_t bit = id & ((1 << CHUNK_SHIFT) - 1);
+    chunks[chunk_index][bit / 64] |= (uint64_t(1) << (bit % 64));
+}
+
+void id_bitmap_t::unset(uint32_t id) {
+    uint32_t chunk_index = id >> CHUNK_SHIFT;
+    if(chunk_index >= chunks.size() || chunks[chunk_index] == nullptr) {
+        return;
+    }
+
+    uint32_t bit = id & ((1 << CHUNK_SHIFT) - 1);
+    chunks[chunk_index][bit / 64] &= ~(uint64_t(1) << (bit % 64));
+}
+
 /* posting_list_t operations */
 
 posting_list_t::posting_list_t(uint16_t max_block_elements): BLOCK_MAX_ELEMENTS(max_block_elements) {
@@ -198,10 +280,28 @@ posting_list_t::~posting_list_t() {
         delete block;
         block = next_block;
     }
+
+    delete id_bitmap;
+}
+
+void posting_list_t::build_id_bitmap() {
+    id_bitmap = new id_bitmap_t;
+    block_t* block = &root_block;
+    while(block != nullptr) {
+        uint32_t* ids = block->ids.uncompress();
+        for(uint32_t i = 0; i < block->ids.getLength(); i++) {
+            id_bitmap->set(ids[i]);
+        }
+        delete [] ids;
+        block = block->next;
+    }
 }
 
 void posting_list_t::merge_adjacent_blocks(posting_list_t::block_t* block1, posting_list_t::block_t* block2,
                                            size_t num_block2_ids_to_move) {
+    // moved ids carry over their score upper bound
+    block1->max_score = std::max(block1->max_score, block2->max_score);
+
     // merge ids
     uint32_t* ids1 = block1->ids.uncompress();
     uint32_t* ids2 = block2->ids.uncompress();
@@ -348,6 +448,9 @@ void posting_list_t::split_block(posting_list_t::block_t* src_block, posting_lis
         return;
     }
 
+    // both halves inherit the source's score upper bound
+    dst_block->max_score = src_block->max_score;
+
     uint32_t* raw_ids = src_block->ids.uncompress();
     size_t ids_first_half_length = (src_block->size() / 2);
     size_t ids_second_half_length = (src_block->size() - ids_first_half_length);
@@ -415,7 +518,7 @@ void posting_list_t::split_block(posting_list_t::block_t* src_block, posting_lis
     delete [] raw_offsets;
 }
 
-void posting_list_t::upsert(const uint32_t id, const std::vector<uint32_t>& offsets) {
+void posting_list_t::upsert(const uint32_t id, const std::vector<uint32_t>& offsets, const int64_t score) {
     // first we will locate the block where `id` should reside
     block_t* upsert_block;
     last_id_t before_upsert_last_id;
@@ -429,6 +532,8 @@ void posting_list_t::upsert(const uint32_t id, const std::vector<uint32_t>& offs
         before_upsert_last_id = upsert_block->ids.last();
     }
 
+    upsert_block->max_score = std::max(upsert_block->max_score, score);
+
     // happy path: upsert_block is not full
     if(upsert_block->size() < BLOCK_MAX_ELEMENTS) {
         uint32_t num_inserted = upsert_block->upsert(id, offsets);
@@ -445,6 +550,7 @@ void posting_list_t::upsert(const uint32_t id, const std::vector<uint32_t>& offs
         if(upsert_block->next == nullptr && upsert_block->ids.last() < id) {
             // appending to the end of the last block where the id will reside on a newly block
             uint32_t num_inserted = new_block->upsert(id, offsets);
+            new_block->max_score = score;
             ids_length += num_inserted;
         } else {
             // upsert and then split block
@@ -465,6 +571,95 @@ void posting_list_t::upsert(const uint32_t id, const std::vector<uint32_t>& offs
         new_block->next = upsert_block->next;
         upsert_block->next = new_block;
     }
+
+    if(id_bitmap != nullptr) {
+        id_bitmap->set(id);
+    } else if(ids_length >= BITMAP_MIN_IDS) {
+        build_id_bitmap();
+    }
+}
+
+size_t posting_list_t::compact_blocks() {
+    size_t num_reclaimed = 0;
+    block_t* block = &root_block;
+
+    while(block->next != nullptr) {
+        block_t* next_block = block->next;
+
+        if(block->size() + next_block->size() <= BLOCK_MAX_ELEMENTS) {
+            last_id_t block_last_id = block->ids.last();
+            last_id_t next_block_last_id = next_block->ids.last();
+
+            merge_adjacent_blocks(block, next_block, next_block->size());
+
+            id_block_map.erase(block_last_id);
+            id_block_map.erase(next_block_last_id);
+            id_block_map.emplace(block->ids.last(), block);
+
+            block->next = next_block->next;
+            delete next_block;
+            num_reclaimed++;
+
+            // stay on this block: it may be able to absorb the next one too
+        } else {
+            block = block->next;
+        }
+    }
+
+    return num_reclaimed;
+}
+
+void posting_list_t::load_sorted(const uint32_t* ids, const uint32_t num_ids,
+                                 const uint32_t* offset_index, const uint32_t* offsets, const uint32_t num_offsets) {
+    block_t* block = &root_block;
+    uint32_t i = 0;
+
+    while(i < num_ids) {
+        uint32_t block_len = std::min<uint32_t>(BLOCK_MAX_ELEMENTS, num_ids - i);
+
+        if(i != 0) {
+            block_t* new_block = new block_t;
+            block->next = new_block;
+            block = new_block;
+        }
+
+        block->ids.load(ids + i, block_len);
+
+        uint32_t start_offset = offset_index[i];
+        uint32_t end_offset = (i + block_len == num_ids) ? num_offsets : offset_index[i + block_len];
+
+        // offset index entries are rebased to the block's own offsets
+        uint32_t* block_offset_index = new uint32_t[block_len];
+        for(uint32_t j = 0; j < block_len; j++) {
+            block_offset_index[j] = offset_index[i + j] - start_offset;
+        }
+
+        block->offset_index.load(block_offset_index, block_len);
+        delete [] block_offset_index;
+
+        uint32_t min_offset = 0, max_offset = 0;
+        if(end_offset != start_offset) {
+            min_offset = UINT32_MAX;
+            for(uint32_t j = start_offset; j < end_offset; j++) {
+                min_offset = std::min(min_offset, offsets[j]);
+                max_offset = std::max(max_offset, offsets[j]);
+            }
+        }
+
+        block->offsets.load(offsets + start_offset, end_offset - start_offset, min_offset, max_offset);
+
+        // no per-id scores are known here, so the block bound must stay unprunable
+        block->max_score = INT64_MAX;
+
+        id_block_map.emplace(ids[i + block_len - 1], block);
+        i += block_len;
+    }
+
+    ids_length = num_ids;
+
+    if(ids_length >= BITMAP_MIN_IDS) {
+        build_id_bitmap();
+    }
 }
 
 void posting_list_t::erase(const uint32_t id) {
@@ -479,6 +674,10 @@ void posting_list_t::erase(const uint32_t id) {
     uint32_t num_erased = erase_block->erase(id);
     ids_length -= num_erased;
 
+    if(id_bitmap != nullptr && num_erased != 0) {
+        id_bitmap->unset(id);
+    }
+
     size_t new_ids_length = erase_block->size();
 
     if(new_ids_length == 0) {
@@ -552,6 +751,27 @@ size_t posting_list_t::num_blocks() const {
     return id_block_map.size();
 }
 
+size_t posting_list_t::memory_bytes() const {
+    size_t bytes = sizeof(posting_list_t);
+    const block_t* block = &root_block;
+
+    while(block != nullptr) {
+        if(block != &root_block) {
+            bytes += sizeof(block_t);
+        }
+
+        bytes += block->ids.getSizeInBytes() + block->offset_index.getSizeInBytes() +
+                 block->offsets.getSizeInBytes();
+        block = block->next;
+    }
+
+    // a red-black tree node per map entry: parent/left/right pointers, color
+    // and the key/value payload
+    bytes += id_block_map.size() * ((3 * sizeof(void*)) + sizeof(int) +
+                                    sizeof(last_id_t) + sizeof(block_t*));
+    return bytes;
+}
+
 uint32_t posting_list_t::first_id() {
     if(ids_length == 0) {
         return 0;
@@ -645,6 +865,65 @@ void posting_list_t::intersect(const std::vector<posting_list_t*>& posting_lists
         return ;
     }
 
+    bool any_bitmap = false;
+    for(const auto& posting_list: posting_lists) {
+        if(posting_list->id_bitmap != nullptr) {
+            any_bitmap = true;
+            break;
+        }
+    }
+
+    if(any_bitmap) {
+        // dense lists are probed through their bitmaps; only the sparse
+        // lists (or the smallest list, if every one is dense) are walked
+        std::vector<posting_list_t*> iterated_lists;
+        std::vector<const id_bitmap_t*> probed_bitmaps;
+
+        for(const auto& posting_list: posting_lists) {
+            if(posting_list->id_bitmap != nullptr) {
+                probed_bitmaps.push_back(posting_list->id_bitmap);
+            } else {
+                iterated_lists.push_back(posting_list);
+            }
+        }
+
+        if(iterated_lists.empty()) {
+            posting_list_t* smallest = posting_lists[0];
+            for(const auto& posting_list: posting_lists) {
+                if(posting_list->ids_length < smallest->ids_length) {
+                    smallest = posting_list;
+                }
+            }
+
+            iterated_lists.push_back(smallest);
+            probed_bitmaps.clear();
+            for(const auto& posting_list: posting_lists) {
+                if(posting_list != smallest) {
+                    probed_bitmaps.push_back(posting_list->id_bitmap);
+                }
+            }
+        }
+
+        std::vector<uint32_t> candidate_ids;
+        intersect(iterated_lists, candidate_ids);
+
+        for(const uint32_t candidate_id: candidate_ids) {
+            bool in_all = true;
+            for(const id_bitmap_t* bitmap: probed_bitmaps) {
+                if(!bitmap->contains(candidate_id)) {
+                    in_all = false;
+                    break;
+                }
+            }
+
+            if(in_all) {
+                result_ids.push_back(candidate_id);
+            }
+        }
+
+        return;
+    }
+
     auto its = std::vector<posting_list_t::iterator_t>();
     its.reserve(posting_lists.size());
 
@@ -725,6 +1004,7 @@ bool posting_list_t::get_offsets(const std::vector<iterator_t>& its,
                               curr_block->offsets.getLength() :
                               curr_block->offset_index.at(curr_index + 1);*/
 
+        its[j].decode_offsets();
         uint32_t* offsets = its[j].offsets;
 
         uint32_t start_offset = its[j].offset_index[curr_index];
@@ -798,6 +1078,7 @@ bool posting_list_t::is_single_token_verbatim_match(const posting_list_t::iterat
         return false;
     }
 
+    it.decode_offsets();
     uint32_t* offsets = it.offsets;
     uint32_t start_offset = it.offset_index[curr_index];
 
@@ -865,7 +1146,7 @@ bool posting_list_t::equals2(std::vector<posting_list_t::iterator_t>& its) {
 
 posting_list_t::iterator_t posting_list_t::new_iterator(block_t* start_block, block_t* end_block) {
     start_block = (start_block == nullptr) ? &root_block : start_block;
-    return posting_list_t::iterator_t(start_block, end_block);
+    return posting_list_t::iterator_t(start_block, end_block, &id_block_map);
 }
 
 void posting_list_t::advance_all(std::vector<posting_list_t::iterator_t>& its) {
@@ -937,11 +1218,56 @@ uint32_t posting_list_t::advance_smallest2(std::vector<posting_list_t::iterator_
     return smallest_value;
 }
 
+bool posting_list_t::advance_past_low_scoring_blocks(std::vector<posting_list_t::iterator_t>& its,
+                                                     const int64_t threshold) {
+    // the score of any id in the current alignment cannot exceed the smallest
+    // of the per-block maxima, so when that bound does not beat the threshold
+    // the whole block holding the bound can be jumped over
+    int64_t bound = INT64_MAX;
+    size_t bound_index = 0;
+
+    for(size_t i = 0; i < its.size(); i++) {
+        if(!its[i].valid()) {
+            return false;
+        }
+
+        if(its[i].block_max_score() < bound) {
+            bound = its[i].block_max_score();
+            bound_index = i;
+        }
+    }
+
+    // ids scoring exactly `threshold` can still win on tie-breaking fields,
+    // so only a strictly lower bound is skippable
+    if(bound >= threshold) {
+        return false;
+    }
+
+    auto& bound_it = its[bound_index];
+    uint32_t block_last_id = bound_it.block()->ids.last();
+
+    if(block_last_id == UINT32_MAX) {
+        // cannot express "past the largest id" via skip_to: step out manually
+        block_t* skipped_block = bound_it.block();
+        while(bound_it.valid() && bound_it.block() == skipped_block) {
+            bound_it.next();
+        }
+    } else {
+        bound_it.skip_to(block_last_id + 1);
+    }
+
+    return true;
+}
+
 size_t posting_list_t::num_ids() const {
     return ids_length;
 }
 
 bool posting_list_t::contains(uint32_t id) {
+    if(id_bitmap != nullptr) {
+        return id_bitmap->contains(id);
+    }
+
     const auto it = id_block_map.lower_bound(id);
 
     if(it == id_block_map.end()) {
@@ -953,6 +1279,15 @@ bool posting_list_t::contains(uint32_t id) {
 }
 
 bool posting_list_t::contains_atleast_one(const uint32_t* target_ids, size_t target_ids_size) {
+    if(id_bitmap != nullptr) {
+        for(size_t i = 0; i < target_ids_size; i++) {
+            if(id_bitmap->contains(target_ids[i])) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     posting_list_t::iterator_t it = new_iterator();
     size_t target_ids_index = 0;
 
@@ -1009,6 +1344,7 @@ void posting_list_t::get_exact_matches(std::vector<iterator_t>& its, const bool
                         break;
                     }
 
+                    it.decode_offsets();
                     uint32_t* offsets = it.offsets;
 
                     uint32_t start_offset_index = it.offset_index[curr_index];
@@ -1076,6 +1412,7 @@ void posting_list_t::get_exact_matches(std::vector<iterator_t>& its, const bool
                         break;
                     }
 
+                    it.decode_offsets();
                     uint32_t* offsets = it.offsets;
                     uint32_t start_offset_index = it.offset_index[curr_index];
                     uint32_t end_offset_index = (curr_index == curr_block->size() - 1) ?
@@ -1164,6 +1501,7 @@ void posting_list_t::get_matching_array_indices(uint32_t id, std::vector<iterato
             return;
         }
 
+        it.decode_offsets();
         uint32_t* offsets = it.offsets;
         uint32_t start_offset_index = it.offset_index[curr_index];
         uint32_t end_offset_index = (curr_index == curr_block->size() - 1) ?
@@ -1206,14 +1544,46 @@ void posting_list_t::get_matching_array_indices(uint32_t id, std::vector<iterato
 
 /* iterator_t operations */
 
-posting_list_t::iterator_t::iterator_t(posting_list_t::block_t* start, posting_list_t::block_t* end):
-        curr_block(start), curr_index(0), end_block(end) {
+posting_list_t::iterator_t::iterator_t(posting_list_t::block_t* start, posting_list_t::block_t* end,
+                                       const std::map<last_id_t, block_t*>* id_block_map):
+        curr_block(start), curr_index(0), end_block(end), id_block_map(id_block_map) {
 
     if(curr_block != end_block) {
-        ids = curr_block->ids.uncompress();
-        offset_index = curr_block->offset_index.uncompress();
-        offsets = curr_block->offsets.uncompress();
+        decode_curr_block();
+    }
+}
+
+void posting_list_t::iterator_t::decode_curr_block() {
+    ids = scratch_acquire(curr_block->ids.getLength(), ids_pooled);
+    curr_block->ids.uncompress(ids);
+
+    // software pipelining of the block decode: while the ids just decoded are
+    // being consumed (filtered/scored), the next block's compressed ids stream
+    // towards the cache, so the FOR decode at the block boundary doesn't stall
+    // on a cold fetch
+    if(curr_block->next != nullptr && curr_block->next != end_block) {
+        curr_block->next->ids.prefetch();
+    }
+}
+
+void posting_list_t::iterator_t::decode_offsets() const {
+    if(offset_index != nullptr || curr_block == end_block) {
+        return;
     }
+
+    offset_index = scratch_acquire(curr_block->offset_index.getLength(), offset_index_pooled);
+    curr_block->offset_index.uncompress(offset_index);
+
+    offsets = scratch_acquire(curr_block->offsets.getLength(), offsets_pooled);
+    curr_block->offsets.uncompress(offsets);
+}
+
+void posting_list_t::iterator_t::release_buffers() {
+    scratch_release(ids, ids_pooled);
+    scratch_release(offset_index, offset_index_pooled);
+    scratch_release(offsets, offsets_pooled);
+
+    ids = offset_index = offsets = nullptr;
 }
 
 bool posting_list_t::iterator_t::valid() const {
@@ -1226,16 +1596,10 @@ void posting_list_t::iterator_t::next() {
         curr_index = 0;
         curr_block = curr_block->next;
 
-        delete [] ids;
-        delete [] offset_index;
-        delete [] offsets;
-
-        ids = offset_index = offsets = nullptr;
+        release_buffers();
 
         if(curr_block != end_block) {
-            ids = curr_block->ids.uncompress();
-            offset_index = curr_block->offset_index.uncompress();
-            offsets = curr_block->offsets.uncompress();
+            decode_curr_block();
         }
     }
 }
@@ -1252,22 +1616,43 @@ posting_list_t::block_t* posting_list_t::iterator_t::block() const {
     return curr_block;
 }
 
+int64_t posting_list_t::iterator_t::block_max_score() const {
+    return (curr_block == end_block) ? INT64_MAX : curr_block->max_score;
+}
+
 void posting_list_t::iterator_t::skip_to(uint32_t id) {
     bool skipped_block = false;
-    while(curr_block != end_block && curr_block->ids.last() < id) {
-        curr_block = curr_block->next;
 
-        // FIXME: remove duplication
-        delete [] ids;
-        delete [] offset_index;
-        delete [] offsets;
+    if(curr_block != end_block && curr_block->ids.last() < id) {
+        block_t* dest_block = nullptr;
 
-        ids = offset_index = offsets = nullptr;
+        if(id_block_map != nullptr) {
+            // jump straight to the first block whose last id can cover `id`,
+            // without touching (or uncompressing) the blocks in between
+            const auto dest_it = id_block_map->lower_bound(id);
+            if(dest_it != id_block_map->end()) {
+                dest_block = dest_it->second;
+            }
+        } else {
+            dest_block = curr_block->next;
+            while(dest_block != end_block && dest_block->ids.last() < id) {
+                dest_block = dest_block->next;
+            }
+        }
+
+        // a bounded iteration must not jump past its end block: `end_block`
+        // is either nullptr (full iteration, chain walk also ends on null)
+        // or the first block outside the range, whose ids are not decoded
+        if(dest_block == nullptr || (end_block != nullptr && end_block->ids.last() < id)) {
+            dest_block = end_block;
+        }
+
+        curr_block = dest_block;
+
+        release_buffers();
 
         if(curr_block != end_block) {
-            ids = curr_block->ids.uncompress();
-            offset_index = curr_block->offset_index.uncompress();
-            offsets = curr_block->offsets.uncompress();
+            decode_curr_block();
         }
 
         skipped_block = true;
@@ -1277,29 +1662,28 @@ void posting_list_t::iterator_t::skip_to(uint32_t id) {
         curr_index = 0;
     }
 
-    while(curr_block != end_block && curr_index < curr_block->size() && this->id() < id) {
-        curr_index++;
+    if(curr_block != end_block && curr_index < curr_block->size() && this->id() < id) {
+        // binary jump over the decoded ids instead of a linear scan
+        const uint32_t* found = std::lower_bound(ids + curr_index, ids + curr_block->size(), id);
+        curr_index = found - ids;
     }
 }
 
 posting_list_t::iterator_t::~iterator_t() {
-    delete [] ids;
-    ids = nullptr;
-
-    delete [] offsets;
-    offsets = nullptr;
-
-    delete [] offset_index;
-    offset_index = nullptr;
+    release_buffers();
 }
 
 posting_list_t::iterator_t::iterator_t(iterator_t&& rhs) noexcept {
     curr_block = rhs.curr_block;
     curr_index = rhs.curr_index;
     end_block = rhs.end_block;
+    id_block_map = rhs.id_block_map;
     ids = rhs.ids;
     offset_index = rhs.offset_index;
     offsets = rhs.offsets;
+    ids_pooled = rhs.ids_pooled;
+    offset_index_pooled = rhs.offset_index_pooled;
+    offsets_pooled = rhs.offsets_pooled;
 
     rhs.curr_block = nullptr;
     rhs.end_block = nullptr;
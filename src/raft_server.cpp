@@ -1,8 +1,14 @@
 #include "store.h"
 #include "raft_server.h"
+#include <braft/local_file_meta.pb.h>    // braft::LocalFileMeta
+#include <butil/crc32c.h>
 #include <butil/files/file_enumerator.h>
+#include <fstream>
 #include <thread>
 #include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <limits>
 #include <string_utils.h>
 #include <file_utils.h>
 #include <collection_manager.h>
@@ -27,6 +33,44 @@ void ReplicationClosure::Run() {
 
 // State machine implementation
 
+// CRC32C of a file's contents, streamed in 1 MB chunks
+static std::string crc32c_of_file(const std::string& file_path) {
+    std::ifstream src(file_path, std::ios::binary);
+    std::vector<char> buf(1024 * 1024);
+    uint32_t crc = 0;
+
+    while(src) {
+        src.read(buf.data(), buf.size());
+        const std::streamsize chunk_len = src.gcount();
+        if(chunk_len <= 0) {
+            break;
+        }
+
+        crc = butil::crc32c::Extend(crc, buf.data(), chunk_len);
+    }
+
+    return std::to_string(crc);
+}
+
+// parses a UTC `HH:MM-HH:MM` snapshot window into minutes-of-day
+static bool parse_snapshot_window(const std::string& window, int& start_mins, int& end_mins) {
+    int start_hh, start_mm, end_hh, end_mm;
+
+    if(std::sscanf(window.c_str(), "%2d:%2d-%2d:%2d", &start_hh, &start_mm, &end_hh, &end_mm) != 4) {
+        return false;
+    }
+
+    if(start_hh < 0 || start_hh > 23 || end_hh < 0 || end_hh > 23 ||
+       start_mm < 0 || start_mm > 59 || end_mm < 0 || end_mm > 59) {
+        return false;
+    }
+
+    start_mins = start_hh * 60 + start_mm;
+    end_mins = end_hh * 60 + end_mm;
+
+    return start_mins != end_mins;
+}
+
 int ReplicationState::start(const butil::EndPoint & peering_endpoint, const int api_port,
                             int election_timeout_ms, int snapshot_interval_s,
                             const std::string & raft_dir, const std::string & nodes,
@@ -68,6 +112,21 @@ int ReplicationState::start(const butil::EndPoint & peering_endpoint, const int
 
     this->read_caught_up = false;
     this->write_caught_up = false;
+    this->applied_lag_entries = 0;
+    this->last_caught_up_ts_ms = 0;
+    this->last_snapshot_duration_ms = 0;
+    this->last_snapshot_bytes_written = 0;
+
+    this->snapshot_interval_s = snapshot_interval_s;
+    this->last_periodic_snapshot_ts = std::time(nullptr);
+    this->snapshot_window = config->get_snapshot_window();
+
+    int window_start_mins, window_end_mins;
+    if(!snapshot_window.empty() && !parse_snapshot_window(snapshot_window, window_start_mins, window_end_mins)) {
+        LOG(WARNING) << "Ignoring malformed snapshot window `" << snapshot_window
+                     << "` (expected `HH:MM-HH:MM` in UTC).";
+        this->snapshot_window = "";
+    }
 
     // do snapshot only when the gap between applied index and last snapshot index is >= this number
     braft::FLAGS_raft_do_snapshot_min_index_gap = 1;
@@ -82,9 +141,27 @@ int ReplicationState::start(const butil::EndPoint & peering_endpoint, const int
 
     node_options.catchup_margin = config->get_healthy_read_lag();
     node_options.election_timeout_ms = election_timeout_ms;
+
+    if(config->get_read_replica()) {
+        // A read replica receives the replicated log and snapshots like any other
+        // follower, but must never campaign for leadership: an effectively infinite
+        // election timeout ensures it does not start an election even when the
+        // leader's heartbeats stop. NOTE: the raft library has no true learner role,
+        // so a read replica still grants votes and counts towards the quorum —
+        // clusters must retain enough regular nodes to form a majority without it.
+        node_options.election_timeout_ms = std::numeric_limits<int32_t>::max();
+        LOG(INFO) << "Starting this node as a read replica: it will never campaign for leadership.";
+    }
     node_options.fsm = this;
     node_options.node_owns_fsm = false;
-    node_options.snapshot_interval_s = snapshot_interval_s;
+    if(snapshot_window.empty()) {
+        node_options.snapshot_interval_s = snapshot_interval_s;
+    } else {
+        // snapshots are scheduled from trigger_periodic_snapshot() instead, so that
+        // the checkpoint and copy IO always lands inside the configured window
+        node_options.snapshot_interval_s = -1;
+        LOG(INFO) << "Periodic snapshots will run only within the window " << snapshot_window << " (UTC).";
+    }
     node_options.filter_before_copy_remote = true;
     std::string prefix = "local://" + raft_dir;
     node_options.log_uri = prefix + "/" + log_dir_name;
@@ -236,7 +313,7 @@ void ReplicationState::write_to_leader(const std::shared_ptr<http_req>& request,
 
         response->set_500("Could not find a leader.");
         auto req_res = new async_req_res_t(request, response, true);
-        return message_dispatcher->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
+        return get_message_dispatcher(request)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
     }
 
     if (request->_req->proceed_req && response->proxied_stream) {
@@ -257,56 +334,56 @@ void ReplicationState::write_to_leader(const std::shared_ptr<http_req>& request,
     const std::string& scheme = std::string(raw_req->scheme->name.base, raw_req->scheme->name.len);
     const std::string url = get_leader_url_path(leader_addr, path, scheme);
 
-    thread_pool->enqueue([request, response, server, path, url, this]() {
-        pending_writes++;
+    const std::string& http_method = request->http_method;
 
-        std::map<std::string, std::string> res_headers;
+    std::vector<std::string> path_parts;
+    StringUtils::split(path, path_parts, "/");
+    const bool is_async_import = (http_method == "POST" && path_parts.back().rfind("import", 0) == 0);
 
-        if(request->http_method == "POST") {
-            std::vector<std::string> path_parts;
-            StringUtils::split(path, path_parts, "/");
+    if(is_async_import) {
+        // imports stream the request body chunk by chunk and block on body
+        // refills, so they keep a dedicated pool thread for the transfer
+        thread_pool->enqueue([request, response, server, url, this]() {
+            pending_writes++;
 
-            if(path_parts.back().rfind("import", 0) == 0) {
-                // imports are handled asynchronously
-                response->proxied_stream = true;
-                long status = HttpClient::post_response_async(url, request, response, server);
+            response->proxied_stream = true;
+            long status = HttpClient::post_response_async(url, request, response, server);
 
-                if(status == 500) {
-                    response->content_type_header = res_headers["content-type"];
-                    response->set_500("");
-                } else {
-                    pending_writes--;
-                    return ;
-                }
-            } else {
-                std::string api_res;
-                long status = HttpClient::post_response(url, request->body, api_res, res_headers);
-                response->content_type_header = res_headers["content-type"];
-                response->set_body(status, api_res);
+            if(status == 500) {
+                response->content_type_header = "";
+                response->set_500("");
+                auto req_res = new async_req_res_t(request, response, true);
+                get_message_dispatcher(request)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
             }
-        } else if(request->http_method == "PUT") {
-            std::string api_res;
-            long status = HttpClient::put_response(url, request->body, api_res, res_headers);
-            response->content_type_header = res_headers["content-type"];
-            response->set_body(status, api_res);
-        } else if(request->http_method == "DELETE") {
-            std::string api_res;
-            long status = HttpClient::delete_response(url, api_res, res_headers);
-            response->content_type_header = res_headers["content-type"];
-            response->set_body(status, api_res);
-        } else if(request->http_method == "PATCH") {
-            std::string api_res;
-            long status = HttpClient::patch_response(url, request->body, api_res, res_headers);
-            response->content_type_header = res_headers["content-type"];
-            response->set_body(status, api_res);
-        } else {
-            const std::string& err = "Forwarding for http method not implemented: " + request->http_method;
-            LOG(ERROR) << err;
-            response->set_500(err);
-        }
+
+            pending_writes--;
+        });
+
+        return ;
+    }
+
+    if(http_method != "POST" && http_method != "PUT" &&
+       http_method != "DELETE" && http_method != "PATCH") {
+        const std::string& err = "Forwarding for http method not implemented: " + http_method;
+        LOG(ERROR) << err;
+        response->set_500(err);
+        auto req_res = new async_req_res_t(request, response, true);
+        return get_message_dispatcher(request)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
+    }
+
+    // writes whose body is already in memory ride the http client's shared
+    // curl-multi event loop instead of tying up a pool thread per round trip
+    pending_writes++;
+
+    HttpClient::request_async(http_method, url, request->body, 0,
+                              [this, request, response](async_transfer_res_t& result) {
+        // runs on the http client's event loop thread: format the response and
+        // hand it over to the server's event loop without blocking
+        response->content_type_header = result.headers["content-type"];
+        response->set_body(result.status_code, result.body);
 
         auto req_res = new async_req_res_t(request, response, true);
-        message_dispatcher->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
+        get_message_dispatcher(request)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
         pending_writes--;
     });
 }
@@ -370,17 +447,55 @@ void* ReplicationState::save_snapshot(void* arg) {
     SnapshotArg* sa = static_cast<SnapshotArg*>(arg);
     std::unique_ptr<SnapshotArg> arg_guard(sa);
 
+    uint64_t bytes_written = 0;
+
+    auto& checksum_cache = sa->replication_state->snapshot_file_checksums;
+    std::unordered_map<std::string, std::pair<uint64_t, std::string>> fresh_checksums;
+
     // add the db snapshot files to writer state
     butil::FileEnumerator dir_enum(butil::FilePath(sa->db_snapshot_path), false, butil::FileEnumerator::FILES);
 
     for (butil::FilePath file = dir_enum.Next(); !file.empty(); file = dir_enum.Next()) {
-        std::string file_name = std::string(db_snapshot_name) + "/" + file.BaseName().value();
-        if (sa->writer->add_file(file_name) != 0) {
+        const std::string& base_name = file.BaseName().value();
+        std::string file_name = std::string(db_snapshot_name) + "/" + base_name;
+        const uint64_t file_size = dir_enum.GetInfo().GetSize();
+
+        // SST files are immutable once written, so a checksum computed for an
+        // earlier snapshot can be reused without re-reading the file
+        const bool is_sst = base_name.size() > 4 && base_name.compare(base_name.size() - 4, 4, ".sst") == 0;
+        std::string checksum;
+
+        const auto cached_it = checksum_cache.find(base_name);
+        if(is_sst && cached_it != checksum_cache.end() && cached_it->second.first == file_size) {
+            checksum = cached_it->second.second;
+        } else {
+            checksum = crc32c_of_file(file.value());
+        }
+
+        if(is_sst) {
+            fresh_checksums[base_name] = std::make_pair(file_size, checksum);
+        }
+
+        // the checksum in the file meta is what lets braft's filter-before-copy
+        // phase (filter_before_copy_remote is enabled in node options) detect
+        // files a follower already holds in its previous snapshot and hard-link
+        // them locally instead of downloading them again — with immutable,
+        // uniquely named SST files this turns a full snapshot transfer into a
+        // delta of just the files changed since the last snapshot
+        braft::LocalFileMeta file_meta;
+        file_meta.set_checksum(checksum);
+
+        if (sa->writer->add_file(file_name, &file_meta) != 0) {
             sa->done->status().set_error(EIO, "Fail to add file to writer.");
             return nullptr;
         }
+
+        bytes_written += file_size;
     }
 
+    // entries for SST files that compaction has since deleted are dropped here
+    checksum_cache.swap(fresh_checksums);
+
     const std::string& temp_snapshot_dir = sa->writer->get_path();
 
     sa->done->Run();
@@ -400,11 +515,17 @@ void* ReplicationState::save_snapshot(void* arg) {
             butil::CreateDirectory(dest_state_dir, true);
         }
 
-        const butil::FilePath& src_snapshot_dir = butil::FilePath(sa->state_dir_path + "/snapshot");
-        const butil::FilePath& src_meta_dir = butil::FilePath(sa->state_dir_path + "/meta");
+        const std::string& src_snapshot_dir = sa->state_dir_path + "/snapshot";
+        const std::string& src_meta_dir = sa->state_dir_path + "/meta";
 
-        butil::CopyDirectory(src_snapshot_dir, dest_state_dir, true);
-        butil::CopyDirectory(src_meta_dir, dest_state_dir, true);
+        // copied with an optional write rate limit so that snapshots taken during
+        // serving hours don't saturate the disk that live writes depend on
+        if(!copy_dir_throttled(src_snapshot_dir, dest_state_dir.value() + "/snapshot",
+                               sa->max_write_mb_per_sec, bytes_written) ||
+           !copy_dir_throttled(src_meta_dir, dest_state_dir.value() + "/meta",
+                               sa->max_write_mb_per_sec, bytes_written)) {
+            LOG(WARNING) << "Copy to external snapshot directory " << sa->ext_snapshot_path << " failed.";
+        }
 
         // notify on demand closure that external snapshotting is done
         sa->replication_state->notify();
@@ -414,7 +535,14 @@ void* ReplicationState::save_snapshot(void* arg) {
     // last snapshot. By doing a dummy write right after a snapshot, we ensure that this can never be the case.
     sa->replication_state->do_dummy_write();
 
-    LOG(INFO) << "save_snapshot done";
+    const uint64_t snapshot_end_ts_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    sa->replication_state->last_snapshot_duration_ms = int64_t(snapshot_end_ts_ms - sa->start_ts_ms);
+    sa->replication_state->last_snapshot_bytes_written = int64_t(bytes_written);
+
+    LOG(INFO) << "save_snapshot done in " << (snapshot_end_ts_ms - sa->start_ts_ms) << " ms, "
+              << bytes_written << " bytes written";
 
     return nullptr;
 }
@@ -423,6 +551,9 @@ void* ReplicationState::save_snapshot(void* arg) {
 void ReplicationState::on_snapshot_save(braft::SnapshotWriter* writer, braft::Closure* done) {
     LOG(INFO) << "on_snapshot_save";
 
+    const uint64_t snapshot_start_ts_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
     std::string db_snapshot_path = writer->get_path() + "/" + db_snapshot_name;
 
     {
@@ -438,6 +569,11 @@ void ReplicationState::on_snapshot_save(braft::SnapshotWriter* writer, braft::Cl
         // this will block writes, but should be pretty fast
         batched_indexer->clear_skip_indices();
 
+        // persist per-collection index snapshots (when enabled) against the
+        // same quiesced state the checkpoint below captures, so a reboot can
+        // restore the in-memory index instead of replaying every document
+        CollectionManager::get_instance().save_index_snapshots();
+
         rocksdb::Checkpoint* checkpoint = nullptr;
         rocksdb::Status status = store->create_check_point(&checkpoint, db_snapshot_path);
         std::unique_ptr<rocksdb::Checkpoint> checkpoint_guard(checkpoint);
@@ -454,6 +590,8 @@ void ReplicationState::on_snapshot_save(braft::SnapshotWriter* writer, braft::Cl
     arg->state_dir_path = raft_dir_path;
     arg->db_snapshot_path = db_snapshot_path;
     arg->done = done;
+    arg->max_write_mb_per_sec = config->get_snapshot_max_write_mb_per_sec();
+    arg->start_ts_ms = snapshot_start_ts_ms;
 
     if(!ext_snapshot_path.empty()) {
         arg->ext_snapshot_path = ext_snapshot_path;
@@ -474,6 +612,9 @@ int ReplicationState::init_db() {
 
     if(init_op.ok()) {
         LOG(INFO) << "Finished loading collections from disk.";
+        // replay sampled queries against the freshly loaded collections so
+        // that the node does not face first traffic with fully cold caches
+        CollectionManager::get_instance().trigger_query_warmup();
     } else {
         LOG(ERROR)<< "Typesense failed to start. " << "Could not load collections from disk: " << init_op.error();
         return 1;
@@ -489,7 +630,9 @@ int ReplicationState::on_snapshot_load(braft::SnapshotReader* reader) {
 
     LOG(INFO) << "on_snapshot_load";
 
-    // ensures that reads and writes are rejected, as `store->reload()` unique locks the DB handle
+    // writes are rejected while the snapshot is installed; searches keep being
+    // served from the old state during the copy and only pause for the brief
+    // directory swap inside `install_snapshot()`
     read_caught_up = false;
     write_caught_up = false;
 
@@ -497,9 +640,9 @@ int ReplicationState::on_snapshot_load(braft::SnapshotReader* reader) {
     std::string snapshot_path = reader->get_path();
     snapshot_path.append(std::string("/") + db_snapshot_name);
 
-    int reload_store = store->reload(true, snapshot_path);
-    if(reload_store != 0) {
-        return reload_store;
+    int install_store = store->install_snapshot(snapshot_path);
+    if(install_store != 0) {
+        return install_store;
     }
 
     bool init_db_status = init_db();
@@ -590,6 +733,13 @@ void ReplicationState::refresh_catchup_status(bool log_msg) {
     //LOG(INFO) << "last_index: " << n_status.applying_index << ", known_applied_index: " << n_status.known_applied_index;
     //LOG(INFO) << "apply_lag: " << apply_lag;
 
+    applied_lag_entries = apply_lag + num_queued_writes;
+
+    if(apply_lag == 0 && num_queued_writes == 0) {
+        last_caught_up_ts_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
     int healthy_read_lag = config->get_healthy_read_lag();
     int healthy_write_lag = config->get_healthy_write_lag();
 
@@ -634,8 +784,26 @@ ReplicationState::ReplicationState(HttpServer* server, BatchedIndexer* batched_i
 }
 
 bool ReplicationState::is_alive() const {
-    // for general health check we will only care about the `read_caught_up` threshold
-    return read_caught_up;
+    // for general health check we will only care about the `read_caught_up` threshold,
+    // and whether the post-boot query warmup replay has finished
+    return read_caught_up && CollectionManager::get_instance().is_warmed_up();
+}
+
+int64_t ReplicationState::get_read_staleness_ms() const {
+    if(applied_lag_entries.load() == 0) {
+        return 0;
+    }
+
+    const int64_t last_caught_up_ms = last_caught_up_ts_ms.load();
+    if(last_caught_up_ms == 0) {
+        // never caught up since boot: infinitely stale
+        return INT64_MAX;
+    }
+
+    const int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    return now_ms - last_caught_up_ms;
 }
 
 uint64_t ReplicationState::node_state() const {
@@ -663,6 +831,44 @@ void ReplicationState::do_snapshot(const std::string& snapshot_path, const std::
     });
 }
 
+void ReplicationState::trigger_periodic_snapshot() {
+    if(snapshot_window.empty()) {
+        // braft's own snapshot timer is active
+        return;
+    }
+
+    const uint64_t current_ts = std::time(nullptr);
+
+    if(current_ts - last_periodic_snapshot_ts < uint64_t(snapshot_interval_s)) {
+        return;
+    }
+
+    int window_start_mins, window_end_mins;
+    parse_snapshot_window(snapshot_window, window_start_mins, window_end_mins);
+
+    std::time_t raw_time = current_ts;
+    std::tm utc_time{};
+    gmtime_r(&raw_time, &utc_time);
+    const int now_mins = utc_time.tm_hour * 60 + utc_time.tm_min;
+
+    // a window like 22:00-04:00 wraps past midnight
+    const bool window_open = (window_start_mins < window_end_mins) ?
+                             (now_mins >= window_start_mins && now_mins < window_end_mins) :
+                             (now_mins >= window_start_mins || now_mins < window_end_mins);
+
+    if(!window_open) {
+        return;
+    }
+
+    std::shared_lock lock(node_mutex);
+
+    if(node) {
+        LOG(INFO) << "Triggering a scheduled snapshot within window " << snapshot_window;
+        node->snapshot(nullptr);
+        last_periodic_snapshot_ts = current_ts;
+    }
+}
+
 void ReplicationState::set_ext_snapshot_path(const std::string& snapshot_path) {
     this->ext_snapshot_path = snapshot_path;
 }
@@ -693,6 +899,11 @@ void ReplicationState::do_dummy_write() {
 }
 
 bool ReplicationState::trigger_vote() {
+    if(config->get_read_replica()) {
+        LOG(WARNING) << "Refusing to trigger a vote: this node is a read replica.";
+        return false;
+    }
+
     std::shared_lock lock(node_mutex);
 
     if(node) {
@@ -708,6 +919,10 @@ http_message_dispatcher* ReplicationState::get_message_dispatcher() const {
     return message_dispatcher;
 }
 
+http_message_dispatcher* ReplicationState::get_message_dispatcher(const std::shared_ptr<http_req>& req) const {
+    return (req != nullptr && req->message_dispatcher != nullptr) ? req->message_dispatcher : message_dispatcher;
+}
+
 Store* ReplicationState::get_store() {
     return store;
 }
@@ -754,6 +969,18 @@ int64_t ReplicationState::get_num_queued_writes() {
     return batched_indexer->get_queued_writes();
 }
 
+bool ReplicationState::is_write_backpressured() {
+    return batched_indexer->is_write_backpressured();
+}
+
+int64_t ReplicationState::get_write_drain_rate() {
+    return batched_indexer->get_drain_rate();
+}
+
+size_t ReplicationState::get_write_retry_after_secs() {
+    return batched_indexer->get_retry_after_secs();
+}
+
 bool ReplicationState::is_leader() {
     std::shared_lock lock(node_mutex);
 
@@ -792,7 +1019,7 @@ void OnDemandSnapshotClosure::Run() {
     res->body = response.dump();
 
     auto req_res = new async_req_res_t(req, res, true);
-    replication_state->get_message_dispatcher()->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
+    replication_state->get_message_dispatcher(req)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
 
     // wait for response to be sent
     res->wait();
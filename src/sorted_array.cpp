@@ -1,7 +1,13 @@
 #include "sorted_array.h"
 #include "array_utils.h"
+#include "cpu_dispatch.h"
 #include "logger.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SORTED_ARRAY_HAS_SIMD_PROBE 1
+#endif
+
 void sorted_array::load(const uint32_t *sorted_array, const uint32_t array_length) {
     min = array_length != 0 ? sorted_array[0] : 0;
     max = array_length > 1 ? sorted_array[array_length-1] : min;
@@ -216,11 +222,67 @@ void sorted_array::binary_search_indices(const uint32_t *values, int low_vindex,
     }
 }
 
+#ifdef SORTED_ARRAY_HAS_SIMD_PROBE
+// probes `value` against the 8 ids starting at `block`, returning the offset
+// of the match or 8 when it is absent
+CLONE_FOR_AVX2
+static uint32_t probe_block(const uint32_t* block, const uint32_t value) {
+    const __m128i probe = _mm_set1_epi32(value);
+    const __m128i eq0 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) block), probe);
+    const __m128i eq1 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) (block + 4)), probe);
+    const int mask = _mm_movemask_ps(_mm_castsi128_ps(eq0)) |
+                     (_mm_movemask_ps(_mm_castsi128_ps(eq1)) << 4);
+
+    return (mask != 0) ? __builtin_ctz(mask) : 8;
+}
+#endif
+
+// resolves a batch of sorted probe values in a single pass over the decoded
+// sequence: the cost of random access into the compressed buffer is paid once,
+// in a sequential bulk decode, instead of on every binary search step
+void sorted_array::merge_search_indices(const uint32_t *values, const size_t values_len, uint32_t *indices) {
+    uint32_t* decoded = uncompress();
+    size_t i = 0;
+
+    for(size_t vindex = 0; vindex < values_len; vindex++) {
+        const uint32_t value = values[vindex];
+
+        // elements below `value` are skipped 8 at a time via the block's last element
+        while(i + 8 <= length && decoded[i + 7] < value) {
+            i += 8;
+        }
+
+#ifdef SORTED_ARRAY_HAS_SIMD_PROBE
+        if(i + 8 <= length) {
+            // `value` can now only be among decoded[i..i+7]
+            const uint32_t offset = probe_block(decoded + i, value);
+            indices[vindex] = (offset != 8) ? (i + offset) : length;
+            continue;
+        }
+#endif
+
+        while(i < length && decoded[i] < value) {
+            i++;
+        }
+
+        indices[vindex] = (i < length && decoded[i] == value) ? i : length;
+    }
+
+    delete [] decoded;
+}
+
 void sorted_array::indexOf(const uint32_t *values, const size_t values_len, uint32_t *indices) {
     if(values_len == 0) {
         return ;
     }
 
+    // large batches relative to the sequence are better served by one decoded
+    // pass than by a compressed binary search per value
+    if(values_len >= 32 && length <= values_len * 64) {
+        merge_search_indices(values, values_len, indices);
+        return;
+    }
+
     uint32_t base = *(uint32_t *)(in + 0);
     uint32_t bits = *(in + 4);
 
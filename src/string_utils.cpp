@@ -80,16 +80,16 @@ std::string StringUtils::hash_sha256(const std::string& str) {
     return StringUtils::str2hex(std::string(reinterpret_cast<char*>(hash_buf), SHA256_SIZE));
 }
 
-void StringUtils::parse_query_string(const std::string& query, std::map<std::string, std::string>& query_map) {
-    std::string key_value;
-
-    int query_len = int(query.size());
-    int i = 0;
+void StringUtils::parse_query_string(std::string_view query, std::map<std::string, std::string>& query_map) {
+    size_t query_len = query.size();
+    size_t i = 0;
 
-    if(query[0] == '?') {
+    if(!query.empty() && query[0] == '?') {
         i++;
     }
 
+    size_t kv_start = i;
+
     while(i < query_len) {
         // we have to support un-encoded "&&" in the query string value, which makes things a bit more complex
         bool start_of_new_param = query[i] == '&' &&
@@ -98,43 +98,29 @@ void StringUtils::parse_query_string(const std::string& query, std::map<std::str
         bool end_of_params = (i == query_len - 1);
 
         if(start_of_new_param || end_of_params) {
-            // Save accumulated key_value
-            if(end_of_params && query[i] != '&') {
-                key_value += query[i];
-            }
+            // slice out the accumulated `key=value` (a trailing '&' is excluded)
+            size_t kv_end = (end_of_params && query[i] != '&') ? (i + 1) : i;
+            std::string_view key_value = query.substr(kv_start, kv_end - kv_start);
 
-            size_t j = 0;
-            bool iterating_on_key = true;
-            std::string key;
-            std::string value;
-
-            while(j < key_value.size()) {
-                if(key_value[j] == '=' && iterating_on_key) {
-                    iterating_on_key = false;
-                } else if(iterating_on_key) {
-                    key += key_value[j];
-                } else {
-                    value += key_value[j];
-                }
-
-                j++;
-            }
+            size_t eq_pos = key_value.find('=');
+            std::string_view key = key_value.substr(0, std::min(eq_pos, key_value.size()));
+            std::string_view value = (eq_pos == std::string_view::npos) ? std::string_view() :
+                                     key_value.substr(eq_pos + 1);
 
             if(!key.empty() && key != "&") {
-                value = StringUtils::url_decode(value);
+                std::string key_str(key);
+                std::string value_str = StringUtils::url_decode(value);
 
-                if (query_map.count(key) == 0) {
-                    query_map[key] = value;
-                } else if (key == "filter_by") {
-                    query_map[key] = query_map[key] + "&&" + value;
+                if (query_map.count(key_str) == 0) {
+                    query_map[key_str] = value_str;
+                } else if (key_str == "filter_by") {
+                    query_map[key_str] = query_map[key_str] + "&&" + value_str;
                 } else {
-                    query_map[key] = value;
+                    query_map[key_str] = value_str;
                 }
             }
 
-            key_value = "";
-        } else {
-            key_value += query[i];
+            kv_start = i + 1;
         }
 
         i++;
@@ -15,6 +15,7 @@
 #endif
 
 #include "string_utils.h"
+#include "logger.h"
 #include "jemalloc.h"
 
 #if __APPLE__
@@ -26,7 +27,42 @@
 uint64_t SystemMetrics::non_proc_mem_last_access = 0;
 uint64_t SystemMetrics::non_proc_mem_bytes = 0;
 
+std::shared_ptr<nlohmann::json> SystemMetrics::cached_metrics = nullptr;
+std::atomic<uint64_t> SystemMetrics::last_sampled_seconds{0};
+
 void SystemMetrics::get(const std::string &data_dir_path, nlohmann::json &result) {
+    uint64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    auto snapshot = std::atomic_load(&cached_metrics);
+
+    // a snapshot older than two sampling intervals means the background
+    // sampler is not running, so we fall back to sampling inline
+    if(snapshot == nullptr || (now - last_sampled_seconds) > (2 * SAMPLE_INTERVAL_MS / 1000)) {
+        sample(data_dir_path);
+        snapshot = std::atomic_load(&cached_metrics);
+    }
+
+    result = *snapshot;
+}
+
+void SystemMetrics::run_sampler(const std::string& data_dir_path, const std::atomic<bool>& quit) {
+    LOG(INFO) << "System metrics sampler thread started.";
+
+    while(!quit) {
+        sample(data_dir_path);
+
+        // sleep in small slices so that shutdown does not wait out the cadence
+        for(size_t i = 0; i < (SAMPLE_INTERVAL_MS / 100) && !quit; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+
+    LOG(INFO) << "System metrics sampler thread exiting.";
+}
+
+void SystemMetrics::sample(const std::string &data_dir_path) {
+    nlohmann::json result;
     // DISK METRICS
     struct statvfs st{};
     statvfs(data_dir_path.c_str(), &st);
@@ -53,18 +89,36 @@ void SystemMetrics::get(const std::string &data_dir_path, nlohmann::json &result
     impl_mallctl("stats.mapped", &mapped, &sz, nullptr, 0);
     impl_mallctl("stats.retained", &retained, &sz, nullptr, 0);
 
+    unsigned num_arenas = 0;
+    size_t unsigned_sz = sizeof(unsigned);
+    impl_mallctl("arenas.narenas", &num_arenas, &unsigned_sz, nullptr, 0);
+
     result["typesense_memory_active_bytes"] = std::to_string(active);
     result["typesense_memory_allocated_bytes"] = std::to_string(allocated);
-    result["typesense_memory_resident_bytes"] = std::to_string(active);
+    result["typesense_memory_resident_bytes"] = std::to_string(resident);
     result["typesense_memory_metadata_bytes"] = std::to_string(metadata);
     result["typesense_memory_mapped_bytes"] = std::to_string(mapped);
     result["typesense_memory_retained_bytes"] = std::to_string(retained);
+    result["typesense_memory_num_arenas"] = std::to_string(num_arenas);
 
     // Fragmentation ratio is calculated very similar to how Redis does it:
     // https://github.com/redis/redis/blob/d6180c8c8674ffdae3d6efa5f946d85fe9163464/src/defrag.c#L900
     std::string frag_ratio = format_dp(1.0f - ((float)allocated / active));
     result["typesense_memory_fragmentation_ratio"] = frag_ratio;
 
+    // RSS vs active separates heap waste (allocator pages held but not in use
+    // by live allocations) from data actually resident for the process
+    uint64_t rss_bytes = 0;
+#if __linux__
+    rss_bytes = linux_get_proc_rss_bytes();
+#endif
+    if(rss_bytes == 0) {
+        rss_bytes = resident;
+    }
+
+    result["typesense_memory_rss_bytes"] = std::to_string(rss_bytes);
+    result["typesense_memory_rss_to_active_ratio"] = format_dp((float)rss_bytes / active);
+
     result["system_memory_total_bytes"] = std::to_string(get_memory_total_bytes());
     result["system_memory_used_bytes"] = std::to_string(get_memory_used_bytes());
 
@@ -82,6 +136,10 @@ void SystemMetrics::get(const std::string &data_dir_path, nlohmann::json &result
     result["system_network_received_bytes"] = std::to_string(received_bytes);
     result["system_network_sent_bytes"] = std::to_string(sent_bytes);
 #endif
+
+    std::atomic_store(&cached_metrics, std::make_shared<nlohmann::json>(std::move(result)));
+    last_sampled_seconds = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
 }
 
 float SystemMetrics::used_memory_ratio() {
@@ -109,6 +167,17 @@ uint64_t SystemMetrics::linux_get_mem_available_bytes() {
     return 0; // nothing found
 }
 
+uint64_t SystemMetrics::linux_get_proc_rss_bytes() {
+    std::ifstream file("/proc/self/statm");
+    uint64_t total_pages = 0, rss_pages = 0;
+
+    if(file >> total_pages >> rss_pages) {
+        return rss_pages * sysconf(_SC_PAGESIZE);
+    }
+
+    return 0;
+}
+
 uint64_t SystemMetrics::get_memory_active_bytes() {
     size_t sz, memory_active_bytes = 1;
     sz = sizeof(size_t);
@@ -0,0 +1,94 @@
+#include "token_interner.h"
+
+token_interner_t::~token_interner_t() {
+    for(char* block: blocks) {
+        free(block);
+    }
+}
+
+const char* token_interner_t::store_bytes(const unsigned char* bytes, uint32_t len) {
+    if(block_capacity - block_used < len) {
+        size_t capacity = (len > BLOCK_SIZE) ? len : BLOCK_SIZE;
+        blocks.push_back((char *) malloc(capacity));
+        block_used = 0;
+        block_capacity = capacity;
+    }
+
+    char* dest = blocks.back() + block_used;
+    memcpy(dest, bytes, len);
+    block_used += len;
+    return dest;
+}
+
+const unsigned char* token_interner_t::intern(const unsigned char* bytes, uint32_t len, uint32_t* id) {
+    std::string_view token((const char *) bytes, len);
+
+    {
+        std::shared_lock lock(mutex);
+        const auto it = token_to_id.find(token);
+        if(it != token_to_id.end()) {
+            if(id != nullptr) {
+                *id = it->second;
+            }
+            return (const unsigned char *) it->first.data();
+        }
+    }
+
+    std::unique_lock lock(mutex);
+
+    // another writer could have interned the token between the two locks
+    const auto it = token_to_id.find(token);
+    if(it != token_to_id.end()) {
+        if(id != nullptr) {
+            *id = it->second;
+        }
+        return (const unsigned char *) it->first.data();
+    }
+
+    const char* stored = store_bytes(bytes, len);
+    std::string_view stored_token(stored, len);
+    uint32_t new_id = id_to_token.size();
+
+    token_to_id.emplace(stored_token, new_id);
+    id_to_token.push_back(stored_token);
+
+    if(id != nullptr) {
+        *id = new_id;
+    }
+
+    return (const unsigned char *) stored;
+}
+
+uint32_t token_interner_t::get_id(const unsigned char* bytes, uint32_t len) const {
+    std::shared_lock lock(mutex);
+    const auto it = token_to_id.find(std::string_view((const char *) bytes, len));
+    return (it != token_to_id.end()) ? it->second : NOT_FOUND;
+}
+
+const unsigned char* token_interner_t::get_bytes(uint32_t id, uint32_t& len) const {
+    std::shared_lock lock(mutex);
+    if(id >= id_to_token.size()) {
+        len = 0;
+        return nullptr;
+    }
+
+    len = id_to_token[id].size();
+    return (const unsigned char *) id_to_token[id].data();
+}
+
+size_t token_interner_t::num_tokens() const {
+    std::shared_lock lock(mutex);
+    return id_to_token.size();
+}
+
+size_t token_interner_t::memory_bytes() const {
+    std::shared_lock lock(mutex);
+
+    // blocks larger than BLOCK_SIZE exist only for tokens longer than 256 KB,
+    // so counting BLOCK_SIZE per block is accurate in practice
+    size_t bytes = blocks.size() * BLOCK_SIZE;
+    bytes += blocks.capacity() * sizeof(char*);
+    bytes += token_to_id.size() * (sizeof(std::string_view) + sizeof(uint32_t));
+    bytes += id_to_token.capacity() * sizeof(std::string_view);
+    return bytes;
+}
@@ -1,6 +1,112 @@
 #include <sstream>
 #include <algorithm>
+#include <unordered_map>
 #include "tokenizer.h"
+#include "cpu_dispatch.h"
+
+namespace {
+    /*
+     * Thread-local pools of the expensive-to-construct per-instance handles:
+     * ICU break iterators (per locale), the zh transliterator and iconv
+     * descriptors. Instead of being constructed per field per document during
+     * imports, they are borrowed here and reset on reuse (setText for break
+     * iterators, a shift-state reset for iconv). A Tokenizer must be
+     * destroyed on the thread that created it, which holds for the indexing
+     * and search paths where each tokenizer lives within one worker's call.
+     */
+    struct analyzer_pool_t {
+        std::unordered_map<std::string, std::vector<icu::BreakIterator*>> break_iterators;
+        std::vector<icu::Transliterator*> zh_transliterators;
+        std::vector<iconv_t> iconv_handles;
+
+        ~analyzer_pool_t() {
+            for(auto& locale_iterators: break_iterators) {
+                for(icu::BreakIterator* bi: locale_iterators.second) {
+                    delete bi;
+                }
+            }
+
+            for(icu::Transliterator* translit: zh_transliterators) {
+                delete translit;
+            }
+
+            for(iconv_t handle: iconv_handles) {
+                iconv_close(handle);
+            }
+        }
+    };
+
+    thread_local analyzer_pool_t analyzer_pool;
+
+    icu::BreakIterator* acquire_break_iterator(const std::string& locale) {
+        auto& pool = analyzer_pool.break_iterators[locale];
+
+        if(!pool.empty()) {
+            icu::BreakIterator* bi = pool.back();
+            pool.pop_back();
+            return bi;
+        }
+
+        UErrorCode status = U_ZERO_ERROR;
+        return icu::BreakIterator::createWordInstance(icu::Locale(locale.c_str()), status);
+    }
+
+    icu::Transliterator* acquire_zh_transliterator() {
+        if(!analyzer_pool.zh_transliterators.empty()) {
+            icu::Transliterator* translit = analyzer_pool.zh_transliterators.back();
+            analyzer_pool.zh_transliterators.pop_back();
+            return translit;
+        }
+
+        UErrorCode translit_status = U_ZERO_ERROR;
+        icu::Transliterator* translit = icu::Transliterator::createInstance("Traditional-Simplified",
+                                                                            UTRANS_FORWARD, translit_status);
+        return U_FAILURE(translit_status) ? nullptr : translit;
+    }
+
+    iconv_t acquire_iconv_handle() {
+        if(!analyzer_pool.iconv_handles.empty()) {
+            iconv_t handle = analyzer_pool.iconv_handles.back();
+            analyzer_pool.iconv_handles.pop_back();
+            return handle;
+        }
+
+        return iconv_open("ASCII//TRANSLIT", "UTF-8");
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TOKENIZER_HAS_SIMD_KERNEL 1
+#endif
+
+#ifdef TOKENIZER_HAS_SIMD_KERNEL
+/*
+ * Returns how many leading bytes of the 16-byte chunk at `p` are plain ASCII
+ * alphanumerics, storing the chunk into `lowered` with uppercase letters
+ * already lowered. Classification stops at the first byte that isn't one:
+ * symbols, separators and UTF-8 lead bytes (negative in the signed byte
+ * comparisons below, so never classified as alphanumeric) take the scalar
+ * path, which also consults the per-instance symbol tables.
+ */
+CLONE_FOR_AVX2
+static size_t classify_alnum_chunk(const char* p, char* lowered) {
+    const __m128i chunk = _mm_loadu_si128((const __m128i *) p);
+
+    const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('A' - 1)),
+                                        _mm_cmplt_epi8(chunk, _mm_set1_epi8('Z' + 1)));
+    const __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('a' - 1)),
+                                        _mm_cmplt_epi8(chunk, _mm_set1_epi8('z' + 1)));
+    const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)),
+                                        _mm_cmplt_epi8(chunk, _mm_set1_epi8('9' + 1)));
+
+    _mm_storeu_si128((__m128i *) lowered,
+                     _mm_add_epi8(chunk, _mm_and_si128(upper, _mm_set1_epi8(0x20))));
+
+    const int alnum_mask = _mm_movemask_epi8(_mm_or_si128(digit, _mm_or_si128(upper, lower)));
+    return (alnum_mask == 0xFFFF) ? 16 : __builtin_ctz(~alnum_mask & 0xFFFF);
+}
+#endif
 
 Tokenizer::Tokenizer(const std::string& input, bool normalize, bool no_op, const std::string& locale,
                      const std::vector<char>& symbols_to_index,
@@ -8,12 +114,9 @@ Tokenizer::Tokenizer(const std::string& input, bool normalize, bool no_op, const
                      i(0), normalize(normalize), no_op(no_op), locale(locale) {
 
     if(locale == "zh") {
-        UErrorCode translit_status = U_ZERO_ERROR;
-        transliterator = icu::Transliterator::createInstance("Traditional-Simplified",
-                                                             UTRANS_FORWARD, translit_status);
-        if(U_FAILURE(translit_status)) {
+        transliterator = acquire_zh_transliterator();
+        if(transliterator == nullptr) {
             //LOG(ERROR) << "Unable to create transliteration instance for `zh` locale.";
-            transliterator = nullptr;
             text = input;
         } else {
             icu::UnicodeString unicode_input = icu::UnicodeString::fromUTF8(input);
@@ -33,12 +136,10 @@ Tokenizer::Tokenizer(const std::string& input, bool normalize, bool no_op, const
         text = input;
     }
 
-    cd = iconv_open("ASCII//TRANSLIT", "UTF-8");
+    cd = acquire_iconv_handle();
 
     if(!locale.empty() && locale != "en") {
-        UErrorCode status = U_ZERO_ERROR;
-        const icu::Locale& icu_locale = icu::Locale(locale.c_str());
-        bi = icu::BreakIterator::createWordInstance(icu_locale, status);
+        bi = acquire_break_iterator(locale);
 
         unicode_text = icu::UnicodeString::fromUTF8(text);
         bi->setText(unicode_text);
@@ -59,6 +160,22 @@ Tokenizer::Tokenizer(const std::string& input, bool normalize, bool no_op, const
     nfkd = icu::Normalizer2::getNFKDInstance(errcode);
 }
 
+Tokenizer::~Tokenizer() {
+    // reset the conversion shift state before handing the descriptor back
+    iconv(cd, nullptr, nullptr, nullptr, nullptr);
+    analyzer_pool.iconv_handles.push_back(cd);
+
+    free(normalized_text);
+
+    if(bi != nullptr) {
+        analyzer_pool.break_iterators[locale].push_back(bi);
+    }
+
+    if(transliterator != nullptr) {
+        analyzer_pool.zh_transliterators.push_back(transliterator);
+    }
+}
+
 bool Tokenizer::next(std::string &token, size_t& token_index, size_t& start_index, size_t& end_index) {
     if(no_op) {
         if(i == text.size()) {
@@ -137,6 +254,34 @@ bool Tokenizer::next(std::string &token, size_t& token_index, size_t& start_inde
     }
 
     while(i < text.size()) {
+#ifdef TOKENIZER_HAS_SIMD_KERNEL
+        // fast path: consume runs of ASCII alphanumerics 16 bytes at a time;
+        // the first byte that isn't one falls through to the scalar path,
+        // which handles symbol tables, separators and multi-byte UTF-8
+        while(i + 16 <= text.size()) {
+            char lowered[16];
+            const size_t run_len = classify_alnum_chunk(text.data() + i, lowered);
+
+            if(run_len == 0) {
+                break;
+            }
+
+            if(out.empty()) {
+                start_index = i;
+            }
+
+            out.append(normalize ? lowered : text.data() + i, run_len);
+            i += run_len;
+
+            if(run_len != 16) {
+                break;
+            }
+        }
+
+        if(i == text.size()) {
+            break;
+        }
+#endif
         if(is_ascii_char(text[i])) {
             size_t this_stream_mode = get_stream_mode(text[i]);
 
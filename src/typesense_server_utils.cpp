@@ -14,6 +14,7 @@
 #include <ifaddrs.h>
 
 #include "core_api.h"
+#include "system_metrics.h"
 #include "typesense_server_utils.h"
 #include "file_utils.h"
 #include "threadpool.h"
@@ -76,17 +77,32 @@ void init_cmdline_options(cmdline::parser & options, int argc, char **argv) {
     options.add<uint32_t>("ssl-refresh-interval-seconds", '\0', "Frequency of automatic reloading of SSL certs from disk.", false, 8 * 60 * 60);
 
     options.add("enable-cors", '\0', "Enable CORS requests.");
+    options.add("enable-index-snapshots", '\0', "Persist in-memory index snapshots to skip reindexing on restart.");
+    options.add("enable-lazy-collections", '\0', "Load collection indices into memory on first access instead of at start-up.");
+    options.add("read-replica", '\0', "Serve reads only: replicate the log but never campaign for leadership.");
 
     options.add<float>("max-memory-ratio", '\0', "Maximum fraction of system memory to be used.", false, 1.0f);
     options.add<int>("snapshot-interval-seconds", '\0', "Frequency of replication log snapshots.", false, 3600);
+    options.add<std::string>("snapshot-window", '\0', "UTC window (HH:MM-HH:MM) within which periodic snapshots are taken. Empty means anytime.", false, "");
+    options.add<int>("snapshot-max-write-mb-per-sec", '\0', "Disk write rate limit for the snapshot copy phase. 0 means unthrottled.", false, 0);
     options.add<size_t>("healthy-read-lag", '\0', "Reads are rejected if the updates lag behind this threshold.", false, 1000);
     options.add<size_t>("healthy-write-lag", '\0', "Writes are rejected if the updates lag behind this threshold.", false, 500);
+    options.add<size_t>("write-queue-high-watermark", '\0', "Imports are rejected with 429 when this many write batches are queued (0 = disabled).", false, 0);
+    options.add<size_t>("write-queue-low-watermark", '\0', "Imports are accepted again once the write queue drains below this threshold.", false, 0);
     options.add<int>("log-slow-requests-time-ms", '\0', "When > 0, requests that take longer than this duration are logged.", false, -1);
 
     options.add<uint32_t>("num-collections-parallel-load", '\0', "Number of collections that are loaded in parallel during start up.", false, 4);
     options.add<uint32_t>("num-documents-parallel-load", '\0', "Number of documents per collection that are indexed in parallel during start up.", false, 1000);
 
     options.add<uint32_t>("thread-pool-size", '\0', "Number of threads used for handling concurrent requests.", false, 4);
+    options.add<uint32_t>("indexing-thread-pool-size", '\0', "Number of threads used for indexing documents.", false, 0);
+    options.add<uint32_t>("num-http-loops", '\0', "Number of event loops that accept HTTP connections, sharded via SO_REUSEPORT.", false, 1);
+
+    options.add<size_t>("db-block-cache-mb", '\0', "Size of the on-disk DB's block cache. 0 means RocksDB's default.", false, 0);
+    options.add<size_t>("db-write-buffer-mb", '\0', "Size of each memtable of the on-disk DB. 0 means the built-in default.", false, 0);
+    options.add<size_t>("db-max-write-buffer-number", '\0', "Number of memtables kept per column family of the on-disk DB. 0 means the built-in default.", false, 0);
+    options.add<int>("db-max-background-jobs", '\0', "Number of background compaction/flush threads of the on-disk DB. 0 means RocksDB's default.", false, 0);
+    options.add<int>("db-compaction-rate-mb-per-sec", '\0', "Disk write rate limit for compactions and flushes of the on-disk DB. 0 means unthrottled.", false, 0);
 
     options.add<std::string>("log-dir", '\0', "Path to the log directory.", false, "");
 
@@ -282,6 +298,22 @@ int start_raft_server(ReplicationState& replication_state, const std::string& st
             replication_state.refresh_catchup_status(log_msg);
         }
 
+        if(raft_counter != 0 && raft_counter % 3600 == 0) {
+            // hourly, low-priority: merge under-filled posting list blocks left behind by deletes
+            CollectionManager::get_instance().compact_posting_lists();
+        }
+
+        if(raft_counter != 0 && raft_counter % 60 == 0) {
+            // no-op unless lazy collections are enabled and memory is tight
+            CollectionManager::get_instance().evict_idle_collections();
+
+            // no-op unless a snapshot window has been configured
+            replication_state.trigger_periodic_snapshot();
+
+            // flush the popular-query sample for the next boot's cache warmup
+            CollectionManager::get_instance().persist_query_samples();
+        }
+
         raft_counter++;
         sleep(1);
     }
@@ -347,20 +379,34 @@ int run_server(const Config & config, const std::string & version, void (*master
     std::string meta_dir = config.get_data_dir() + "/meta";
 
     size_t thread_pool_size = config.get_thread_pool_size();
+    size_t indexing_thread_pool_size = config.get_indexing_thread_pool_size();
 
     const size_t proc_count = std::max<size_t>(1, std::thread::hardware_concurrency());
     const size_t num_threads = thread_pool_size == 0 ? (proc_count * 8) : thread_pool_size;
+    const size_t num_indexing_threads = indexing_thread_pool_size == 0 ? (proc_count * 4) : indexing_thread_pool_size;
 
     size_t num_collections_parallel_load = config.get_num_collections_parallel_load();
     num_collections_parallel_load = (num_collections_parallel_load == 0) ?
                                     (proc_count * 4) : num_collections_parallel_load;
 
-    LOG(INFO) << "Thread pool size: " << num_threads;
-    ThreadPool app_thread_pool(num_threads);
+    LOG(INFO) << "Thread pool size: " << num_threads << ", indexing thread pool size: " << num_indexing_threads;
+    // search/indexing workers are spread across NUMA nodes so that index memory
+    // they first-touch stays local to the node they keep running on.
+    // indexing work runs on its own pool so that searches never queue
+    // behind import batches during heavy writes
+    ThreadPool app_thread_pool(num_threads, true);
+    ThreadPool indexing_thread_pool(num_indexing_threads, true);
     ThreadPool server_thread_pool(num_threads);
 
+    store_tuning_t store_tuning;
+    store_tuning.block_cache_mb = config.get_db_block_cache_mb();
+    store_tuning.write_buffer_mb = config.get_db_write_buffer_mb();
+    store_tuning.max_write_buffer_number = config.get_db_max_write_buffer_number();
+    store_tuning.max_background_jobs = config.get_db_max_background_jobs();
+    store_tuning.compaction_rate_mb_per_sec = config.get_db_compaction_rate_mb_per_sec();
+
     // primary DB used for storing the documents: we will not use WAL since Raft provides that
-    Store store(db_dir);
+    Store store(db_dir, 24*60*60, 1024, true, store_tuning);
 
     // meta DB for storing house keeping things
     Store meta_store(meta_dir, 24*60*60, 1024, false);
@@ -377,6 +423,7 @@ int run_server(const Config & config, const std::string & version, void (*master
         config.get_ssl_cert_key(),
         config.get_ssl_refresh_interval_seconds() * 1000,
         config.get_enable_cors(),
+        config.get_num_http_loops(),
         &server_thread_pool
     );
 
@@ -388,12 +435,24 @@ int run_server(const Config & config, const std::string & version, void (*master
 
     bool ssl_enabled = (!config.get_ssl_cert().empty() && !config.get_ssl_cert_key().empty());
 
-    BatchedIndexer* batch_indexer = new BatchedIndexer(server, &store, &meta_store, num_threads);
+    BatchedIndexer* batch_indexer = new BatchedIndexer(server, &store, &meta_store, num_threads,
+                                                       config.get_write_queue_high_watermark(),
+                                                       config.get_write_queue_low_watermark());
 
     CollectionManager & collectionManager = CollectionManager::get_instance();
-    collectionManager.init(&store, &app_thread_pool, config.get_max_memory_ratio(),
+    collectionManager.init(&store, &app_thread_pool, &indexing_thread_pool, config.get_max_memory_ratio(),
                            config.get_api_key(), quit_raft_service, batch_indexer);
 
+    if(config.get_enable_index_snapshots()) {
+        collectionManager.set_index_snapshot_dir(config.get_data_dir() + "/index_snapshots");
+    }
+
+    collectionManager.set_lazy_mode(config.get_enable_lazy_collections());
+
+    // popular queries are sampled into the meta DB and replayed on the next
+    // boot to warm the caches before the node reports healthy
+    collectionManager.set_meta_store(&meta_store);
+
     // first we start the peering service
 
     ReplicationState replication_state(server, batch_indexer, &store,
@@ -404,7 +463,7 @@ int run_server(const Config & config, const std::string & version, void (*master
                                        config.get_num_documents_parallel_load());
 
     std::thread raft_thread([&replication_state, &config, &state_dir,
-                             &app_thread_pool, &server_thread_pool, batch_indexer]() {
+                             &app_thread_pool, &indexing_thread_pool, &server_thread_pool, batch_indexer]() {
 
         std::thread batch_indexing_thread([batch_indexer]() {
             batch_indexer->run();
@@ -431,9 +490,19 @@ int run_server(const Config & config, const std::string & version, void (*master
 
         app_thread_pool.shutdown();
 
+        LOG(INFO) << "Shutting down indexing_thread_pool.";
+
+        indexing_thread_pool.shutdown();
+
         server->stop();
     });
 
+    // metrics endpoints serve a cached snapshot, refreshed on a fixed cadence
+    // off the event loop so concurrent scrapers don't re-read /proc each time
+    std::thread metrics_sampler_thread([&db_dir]() {
+        SystemMetrics::get_instance().run_sampler(db_dir, quit_raft_service);
+    });
+
     LOG(INFO) << "Starting API service...";
 
     master_server_routes();
@@ -444,6 +513,7 @@ int run_server(const Config & config, const std::string & version, void (*master
     LOG(INFO) << "Typesense API service has quit.";
     quit_raft_service = true;  // we set this once again in case API thread crashes instead of a signal
     raft_thread.join();
+    metrics_sampler_thread.join();
 
     LOG(INFO) << "Deleting batch indexer";
 
@@ -451,6 +521,7 @@ int run_server(const Config & config, const std::string & version, void (*master
 
     LOG(INFO) << "CURL clean up";
 
+    HttpClient::stop_async_loop();
     curl_global_cleanup();
 
     LOG(INFO) << "Deleting server";
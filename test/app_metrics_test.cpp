@@ -43,3 +43,39 @@ TEST_F(AppMetricsTest, StatefulRemoveDocs) {
     ASSERT_EQ(result["rps"]["GET /collections"].get<double>(), 0.2);
     ASSERT_EQ(result["rps"]["GET /operations/vote"].get<double>(), 0.1);
 }
+
+TEST_F(AppMetricsTest, LatencyPercentiles) {
+    for(uint64_t duration = 1; duration <= 100; duration++) {
+        metrics.increment_duration(AppMetrics::SEARCH_LABEL, duration);
+        metrics.increment_count(AppMetrics::SEARCH_LABEL, 1);
+    }
+
+    metrics.increment_duration("GET /collections", 2);
+    metrics.increment_duration("GET /collections", 1000);
+
+    metrics.window_reset();
+
+    // percentile estimates land on the mid-point of the log-linear bucket
+    // holding the target rank, so they are only approximate above 16 ms
+    ASSERT_EQ(51, metrics.get_duration_percentile(AppMetrics::SEARCH_LABEL, 50));
+    ASSERT_EQ(90, metrics.get_duration_percentile(AppMetrics::SEARCH_LABEL, 90));
+    ASSERT_EQ(98, metrics.get_duration_percentile(AppMetrics::SEARCH_LABEL, 99));
+    ASSERT_EQ(102, metrics.get_duration_percentile(AppMetrics::SEARCH_LABEL, 99.9));
+
+    // unknown identifier
+    ASSERT_EQ(0, metrics.get_duration_percentile("GET /nope", 99));
+
+    nlohmann::json result;
+    metrics.get("rps", "latency", result);
+
+    ASSERT_EQ(51, result["search_latency_percentiles"]["p50"].get<uint64_t>());
+    ASSERT_EQ(98, result["search_latency_percentiles"]["p99"].get<uint64_t>());
+    ASSERT_EQ(102, result["search_latency_percentiles"]["p999"].get<uint64_t>());
+
+    ASSERT_EQ(2, result["latency_percentiles"]["GET /collections"]["p50"].get<uint64_t>());
+    ASSERT_EQ(1008, result["latency_percentiles"]["GET /collections"]["p99"].get<uint64_t>());
+
+    // labels with no samples in the window still get a stable, zeroed schema
+    ASSERT_EQ(0, result["import_latency_percentiles"]["p99"].get<uint64_t>());
+    ASSERT_EQ(0, result["write_latency_percentiles"]["p999"].get<uint64_t>());
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "arena.h"
+
+TEST(ArenaTest, BumpAllocationWithinBlock) {
+    arena_t arena;
+    ASSERT_EQ(0, arena.num_blocks());
+
+    void* first = arena.alloc(3);
+    void* second = arena.alloc(10);
+
+    // both allocations come from the same block and are 8-byte aligned
+    ASSERT_EQ(1, arena.num_blocks());
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(first) % 8);
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(second) % 8);
+    ASSERT_EQ(8, static_cast<uint8_t*>(second) - static_cast<uint8_t*>(first));
+}
+
+TEST(ArenaTest, OversizedAllocationGetsDedicatedBlock) {
+    arena_t arena;
+
+    void* small_1 = arena.alloc(8);
+    void* big = arena.alloc(200 * 1024);
+    ASSERT_EQ(2, arena.num_blocks());
+    ASSERT_NE(nullptr, big);
+
+    // current block keeps serving small allocations after the oversized one
+    void* small_2 = arena.alloc(8);
+    ASSERT_EQ(2, arena.num_blocks());
+    ASSERT_EQ(8, static_cast<uint8_t*>(small_2) - static_cast<uint8_t*>(small_1));
+}
+
+TEST(ArenaTest, AllocatorAdapterBacksVector) {
+    arena_t arena;
+    std::vector<int, arena_allocator<int>> values{arena_allocator<int>(&arena)};
+
+    for(int i = 0; i < 5000; i++) {
+        values.push_back(i);
+    }
+
+    for(int i = 0; i < 5000; i++) {
+        ASSERT_EQ(i, values[i]);
+    }
+
+    ASSERT_GE(arena.num_blocks(), 1);
+
+    arena_t other_arena;
+    ASSERT_TRUE(arena_allocator<int>(&arena) == arena_allocator<long>(&arena));
+    ASSERT_TRUE(arena_allocator<int>(&arena) != arena_allocator<int>(&other_arena));
+}
@@ -172,4 +172,46 @@ TEST(SortedArrayTest, FilterArray) {
     delete[] arr2;
     delete[] arr1;
     delete[] results;
-}
\ No newline at end of file
+}
+TEST(SortedArrayTest, FilterArrayLargeAndSparse) {
+    // a filter spread thinly over the id range goes through the vectorized
+    // difference kernel
+    std::vector<uint32_t> src;
+    for(uint32_t i = 0; i < 50000; i++) {
+        src.push_back(i * 3);             // 0, 3, 6, ...
+    }
+
+    std::vector<uint32_t> sparse_filter;
+    for(uint32_t i = 0; i < 500; i++) {
+        sparse_filter.push_back(i * 300); // every 100th element of src
+    }
+
+    uint32_t* results = nullptr;
+    size_t results_size = ArrayUtils::exclude_scalar(&src[0], src.size(), &sparse_filter[0],
+                                                     sparse_filter.size(), &results);
+    ASSERT_EQ(49500, results_size);
+
+    for(size_t i = 0; i < results_size; i++) {
+        ASSERT_EQ(0, results[i] % 3);
+        ASSERT_NE(0, results[i] % 300);
+    }
+
+    delete[] results;
+    results = nullptr;
+
+    // a dense filter goes through the bitmap path
+    std::vector<uint32_t> dense_filter;
+    for(uint32_t i = 1000; i < 4000; i++) {
+        dense_filter.push_back(i);
+    }
+
+    results_size = ArrayUtils::exclude_scalar(&src[0], src.size(), &dense_filter[0],
+                                              dense_filter.size(), &results);
+    ASSERT_EQ(49000, results_size);
+
+    for(size_t i = 0; i < results_size; i++) {
+        ASSERT_TRUE(results[i] < 1000 || results[i] >= 4000);
+    }
+
+    delete[] results;
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include "bool_index.h"
+
+TEST(BoolIndexTest, InsertSearchRemove) {
+    bool_index_t bitmaps;
+
+    for(uint32_t seq_id = 0; seq_id < 1000; seq_id++) {
+        bitmaps.insert(seq_id % 3 == 0, seq_id);
+    }
+
+    ASSERT_EQ(334, bitmaps.num_ids(true));
+    ASSERT_EQ(666, bitmaps.num_ids(false));
+
+    // duplicate insert is a no-op
+    bitmaps.insert(true, 0);
+    ASSERT_EQ(334, bitmaps.num_ids(true));
+
+    uint32_t* ids = nullptr;
+    size_t ids_len = 0;
+
+    bitmaps.search(true, &ids, ids_len);
+    ASSERT_EQ(334, ids_len);
+
+    for(size_t i = 0; i < ids_len; i++) {
+        ASSERT_EQ(0, ids[i] % 3);
+    }
+
+    // search or-merges into the existing id list, like num_tree_t::search
+    bitmaps.search(false, &ids, ids_len);
+    ASSERT_EQ(1000, ids_len);
+
+    for(size_t i = 0; i < ids_len; i++) {
+        ASSERT_EQ(i, ids[i]);
+    }
+
+    delete [] ids;
+
+    bitmaps.remove(true, 0);
+    bitmaps.remove(true, 0);      // double remove is a no-op
+    bitmaps.remove(false, 5000);  // unknown id is a no-op
+    ASSERT_EQ(333, bitmaps.num_ids(true));
+
+    // empty value set leaves the id list untouched
+    ids = nullptr;
+    ids_len = 0;
+    bool_index_t empty_bitmaps;
+    empty_bitmaps.search(true, &ids, ids_len);
+    ASSERT_EQ(nullptr, ids);
+    ASSERT_EQ(0, ids_len);
+}
+
+TEST(BoolIndexTest, ArrayDocCanHoldBothValues) {
+    bool_index_t bitmaps;
+
+    bitmaps.insert(true, 7);
+    bitmaps.insert(false, 7);
+
+    ASSERT_EQ(1, bitmaps.num_ids(true));
+    ASSERT_EQ(1, bitmaps.num_ids(false));
+
+    bitmaps.remove(true, 7);
+    ASSERT_EQ(0, bitmaps.num_ids(true));
+    ASSERT_EQ(1, bitmaps.num_ids(false));
+}
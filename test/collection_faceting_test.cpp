@@ -813,3 +813,261 @@ TEST_F(CollectionFacetingTest, FacetQueryOnStringArray) {
 
     collectionManager.drop_collection("coll1");
 }
+
+TEST_F(CollectionFacetingTest, FacetQueryReflectsWrites) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("brand", field_types::STRING, true)};
+
+    Collection* coll1 = collectionManager.get_collection("coll1").get();
+    if(coll1 == nullptr) {
+        coll1 = collectionManager.create_collection("coll1", 1, fields, "").get();
+    }
+
+    for(size_t i = 0; i < 3; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Sneaker " + std::to_string(i);
+        doc["brand"] = (i < 2) ? "New Balance" : "Nike";
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    // type-ahead from the middle of the value
+    auto results = coll1->search("*", {}, "", {"brand"}, sort_fields, {0}, 10, 1, FREQUENCY,
+                                 {false}, Index::DROP_TOKENS_THRESHOLD,
+                                 spp::sparse_hash_set<std::string>(),
+                                 spp::sparse_hash_set<std::string>(), 10, "brand: bal").get();
+
+    ASSERT_EQ(1, results["facet_counts"][0]["counts"].size());
+    ASSERT_EQ("New Balance", results["facet_counts"][0]["counts"][0]["value"].get<std::string>());
+    ASSERT_EQ(2, results["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+
+    // removal must be reflected in both count and value matching
+    ASSERT_TRUE(coll1->remove("0").ok());
+
+    results = coll1->search("*", {}, "", {"brand"}, sort_fields, {0}, 10, 1, FREQUENCY,
+                            {false}, Index::DROP_TOKENS_THRESHOLD,
+                            spp::sparse_hash_set<std::string>(),
+                            spp::sparse_hash_set<std::string>(), 10, "brand: bal").get();
+
+    ASSERT_EQ(1, results["facet_counts"][0]["counts"].size());
+    ASSERT_EQ(1, results["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+
+    ASSERT_TRUE(coll1->remove("1").ok());
+
+    results = coll1->search("*", {}, "", {"brand"}, sort_fields, {0}, 10, 1, FREQUENCY,
+                            {false}, Index::DROP_TOKENS_THRESHOLD,
+                            spp::sparse_hash_set<std::string>(),
+                            spp::sparse_hash_set<std::string>(), 10, "brand: bal").get();
+
+    ASSERT_EQ(0, results["facet_counts"][0]["counts"].size());
+
+    results = coll1->search("*", {}, "", {"brand"}, sort_fields, {0}, 10, 1, FREQUENCY,
+                            {false}, Index::DROP_TOKENS_THRESHOLD,
+                            spp::sparse_hash_set<std::string>(),
+                            spp::sparse_hash_set<std::string>(), 10, "brand: nik").get();
+
+    ASSERT_EQ(1, results["facet_counts"][0]["counts"].size());
+    ASSERT_EQ("Nike", results["facet_counts"][0]["counts"][0]["value"].get<std::string>());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionFacetingTest, ApproxFacetCountsOnHighCardinalityField) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("seller", field_types::STRING, true),
+                                 field("points", field_types::INT32, false)};
+
+    Collection* coll1 = collectionManager.get_collection("coll1").get();
+    if(coll1 == nullptr) {
+        coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+    }
+
+    // 1200 sellers with a single listing each + 2 heavy hitters
+    for(size_t i = 0; i < 1200; i++) {
+        nlohmann::json doc;
+        doc["title"] = "Listing " + std::to_string(i);
+        doc["seller"] = "seller_" + std::to_string(i);
+        doc["points"] = 100;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    for(size_t i = 0; i < 200; i++) {
+        nlohmann::json doc;
+        doc["title"] = "Top listing " + std::to_string(i);
+        doc["seller"] = (i < 120) ? "top_seller_1" : "top_seller_2";
+        doc["points"] = 100;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    // exact counting
+    auto results = coll1->search("*", {}, "", {"seller"}, sort_fields, {0}, 10, 1, FREQUENCY,
+                                 {false}, Index::DROP_TOKENS_THRESHOLD,
+                                 spp::sparse_hash_set<std::string>(),
+                                 spp::sparse_hash_set<std::string>(), 10, "", 30, 4, "", 1, "", "",
+                                 {}, 0, "<mark>", "</mark>", {}, UINT32_MAX, true, false, true, "",
+                                 false, 6000*1000, 4, 7, false).get();
+
+    ASSERT_EQ(1, results["facet_counts"].size());
+    ASSERT_EQ("top_seller_1", results["facet_counts"][0]["counts"][0]["value"].get<std::string>());
+    ASSERT_EQ(120, results["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+    ASSERT_EQ("top_seller_2", results["facet_counts"][0]["counts"][1]["value"].get<std::string>());
+    ASSERT_EQ(80, results["facet_counts"][0]["counts"][1]["count"].get<size_t>());
+
+    // approximate counting: heavy hitters must surface on top with near-exact
+    // counts (undercounted by at most results / summary capacity)
+    results = coll1->search("*", {}, "", {"seller"}, sort_fields, {0}, 10, 1, FREQUENCY,
+                            {false}, Index::DROP_TOKENS_THRESHOLD,
+                            spp::sparse_hash_set<std::string>(),
+                            spp::sparse_hash_set<std::string>(), 10, "", 30, 4, "", 1, "", "",
+                            {}, 0, "<mark>", "</mark>", {}, UINT32_MAX, true, false, true, "",
+                            false, 6000*1000, 4, 7, true).get();
+
+    ASSERT_EQ(1, results["facet_counts"].size());
+    ASSERT_EQ("top_seller_1", results["facet_counts"][0]["counts"][0]["value"].get<std::string>());
+    size_t top1_count = results["facet_counts"][0]["counts"][0]["count"].get<size_t>();
+    ASSERT_GE(top1_count, 110);
+    ASSERT_LE(top1_count, 120);
+
+    ASSERT_EQ("top_seller_2", results["facet_counts"][0]["counts"][1]["value"].get<std::string>());
+    size_t top2_count = results["facet_counts"][0]["counts"][1]["count"].get<size_t>();
+    ASSERT_GE(top2_count, 70);
+    ASSERT_LE(top2_count, 80);
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionFacetingTest, SampledFacetCountsOnLargeResultSets) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("color", field_types::STRING, true),
+                                 field("points", field_types::INT32, false)};
+
+    Collection* coll1 = collectionManager.get_collection("coll1").get();
+    if(coll1 == nullptr) {
+        coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+    }
+
+    // colors alternate with document parity, so a 50% sample (every other
+    // result id) sees only the even-positioned color
+    for(size_t i = 0; i < 1000; i++) {
+        nlohmann::json doc;
+        doc["title"] = "Shirt " + std::to_string(i);
+        doc["color"] = (i % 2 == 0) ? "red" : "blue";
+        doc["points"] = 100;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    // exact counting
+    auto results = coll1->search("*", {}, "", {"color"}, sort_fields, {0}, 10, 1, FREQUENCY,
+                                 {false}, Index::DROP_TOKENS_THRESHOLD,
+                                 spp::sparse_hash_set<std::string>(),
+                                 spp::sparse_hash_set<std::string>(), 10, "", 30, 4, "", 1, "", "",
+                                 {}, 0, "<mark>", "</mark>", {}, UINT32_MAX, true, false, true, "",
+                                 false, 6000*1000, 4, 7, false).get();
+
+    ASSERT_EQ(1, results["facet_counts"].size());
+    ASSERT_EQ(2, results["facet_counts"][0]["counts"].size());
+    ASSERT_EQ(500, results["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+    ASSERT_EQ(500, results["facet_counts"][0]["counts"][1]["count"].get<size_t>());
+    ASSERT_FALSE(results["facet_counts"][0]["sampled"].get<bool>());
+
+    // 50% sampling: every other result id is counted and the counts doubled,
+    // so only the even-positioned color surfaces, at the full result size
+    results = coll1->search("*", {}, "", {"color"}, sort_fields, {0}, 10, 1, FREQUENCY,
+                            {false}, Index::DROP_TOKENS_THRESHOLD,
+                            spp::sparse_hash_set<std::string>(),
+                            spp::sparse_hash_set<std::string>(), 10, "", 30, 4, "", 1, "", "",
+                            {}, 0, "<mark>", "</mark>", {}, UINT32_MAX, true, false, true, "",
+                            false, 6000*1000, 4, 7, false, 50, 0).get();
+
+    ASSERT_EQ(1, results["facet_counts"].size());
+    ASSERT_EQ(1, results["facet_counts"][0]["counts"].size());
+    ASSERT_EQ("red", results["facet_counts"][0]["counts"][0]["value"].get<std::string>());
+    ASSERT_EQ(1000, results["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+    ASSERT_TRUE(results["facet_counts"][0]["sampled"].get<bool>());
+
+    // result set below the sampling threshold: counts stay exact
+    results = coll1->search("*", {}, "", {"color"}, sort_fields, {0}, 10, 1, FREQUENCY,
+                            {false}, Index::DROP_TOKENS_THRESHOLD,
+                            spp::sparse_hash_set<std::string>(),
+                            spp::sparse_hash_set<std::string>(), 10, "", 30, 4, "", 1, "", "",
+                            {}, 0, "<mark>", "</mark>", {}, UINT32_MAX, true, false, true, "",
+                            false, 6000*1000, 4, 7, false, 50, 10000).get();
+
+    ASSERT_EQ(1, results["facet_counts"].size());
+    ASSERT_EQ(2, results["facet_counts"][0]["counts"].size());
+    ASSERT_EQ(500, results["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+    ASSERT_FALSE(results["facet_counts"][0]["sampled"].get<bool>());
+
+    auto res_op = coll1->search("*", {}, "", {"color"}, sort_fields, {0}, 10, 1, FREQUENCY,
+                                {false}, Index::DROP_TOKENS_THRESHOLD,
+                                spp::sparse_hash_set<std::string>(),
+                                spp::sparse_hash_set<std::string>(), 10, "", 30, 4, "", 1, "", "",
+                                {}, 0, "<mark>", "</mark>", {}, UINT32_MAX, true, false, true, "",
+                                false, 6000*1000, 4, 7, false, 200, 0);
+
+    ASSERT_FALSE(res_op.ok());
+    ASSERT_EQ("Value of `facet_sample_percent` must be between 1 and 100.", res_op.error());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionFacetingTest, WholeIndexFacetCountsStayFreshAcrossWrites) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("category", field_types::STRING, true),
+                                 field("points", field_types::INT32, false)};
+
+    Collection* coll1 = collectionManager.get_collection("coll1").get();
+    if(coll1 == nullptr) {
+        coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+    }
+
+    for(size_t i = 0; i < 20; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Title " + std::to_string(i);
+        doc["category"] = (i % 2 == 0) ? "shoes" : "bags";
+        doc["points"] = 100;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    // unfiltered wildcard: counts are computed once and then served from the
+    // whole-index cache on the repeat query
+    for(size_t repeat = 0; repeat < 2; repeat++) {
+        auto results = coll1->search("*", {}, "", {"category"}, sort_fields, {0}, 10, 1,
+                                     FREQUENCY, {false}).get();
+        ASSERT_EQ(1, results["facet_counts"].size());
+        ASSERT_EQ(2, results["facet_counts"][0]["counts"].size());
+        ASSERT_EQ(10, results["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+        ASSERT_EQ(10, results["facet_counts"][0]["counts"][1]["count"].get<size_t>());
+    }
+
+    // a write invalidates the cached counts
+    nlohmann::json doc;
+    doc["id"] = "20";
+    doc["title"] = "Title 20";
+    doc["category"] = "shoes";
+    doc["points"] = 100;
+    ASSERT_TRUE(coll1->add(doc.dump()).ok());
+
+    auto results = coll1->search("*", {}, "", {"category"}, sort_fields, {0}, 10, 1,
+                                 FREQUENCY, {false}).get();
+    ASSERT_EQ("shoes", results["facet_counts"][0]["counts"][0]["value"].get<std::string>());
+    ASSERT_EQ(11, results["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+
+    // ... and so does a removal
+    ASSERT_TRUE(coll1->remove("20").ok());
+
+    results = coll1->search("*", {}, "", {"category"}, sort_fields, {0}, 10, 1,
+                            FREQUENCY, {false}).get();
+    ASSERT_EQ(10, results["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+    ASSERT_EQ(10, results["facet_counts"][0]["counts"][1]["count"].get<size_t>());
+
+    // filtered searches fall back to counting over the restricted result set
+    results = coll1->search("*", {}, "points: 100 && category: shoes", {"category"}, sort_fields,
+                            {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(1, results["facet_counts"][0]["counts"].size());
+    ASSERT_EQ("shoes", results["facet_counts"][0]["counts"][0]["value"].get<std::string>());
+    ASSERT_EQ(10, results["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+
+    collectionManager.drop_collection("coll1");
+}
@@ -2150,3 +2150,65 @@ TEST_F(CollectionFilteringTest, ExactFilteringRepeatingTokensArrayField) {
 
     collectionManager.drop_collection("coll1");
 }
+
+TEST_F(CollectionFilteringTest, FilteringOnMaterializedFields) {
+    Collection *coll1;
+
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("in_stock", field_types::BOOL, false, false, true, "", true),
+                                 field("store_id", field_types::INT32, false, false, true, "", true),
+                                 field("points", field_types::INT32, false)};
+
+    coll1 = collectionManager.get_collection("coll1").get();
+    if(coll1 == nullptr) {
+        coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+    }
+
+    for(size_t i = 0; i < 6; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Title " + std::to_string(i);
+        doc["in_stock"] = (i % 2 == 0);
+        doc["store_id"] = int32_t(i % 3 + 1);
+        doc["points"] = int32_t(i);
+
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    auto results = coll1->search("*", {}, "in_stock:true", {}, {}, {0}, 10, 1, FREQUENCY, {true}, 10).get();
+
+    ASSERT_EQ(3, results["found"].get<size_t>());
+    ASSERT_EQ("4", results["hits"][0]["document"]["id"].get<std::string>());
+    ASSERT_EQ("2", results["hits"][1]["document"]["id"].get<std::string>());
+    ASSERT_EQ("0", results["hits"][2]["document"]["id"].get<std::string>());
+
+    results = coll1->search("*", {}, "store_id: [1, 3]", {}, {}, {0}, 10, 1, FREQUENCY, {true}, 10).get();
+
+    ASSERT_EQ(4, results["found"].get<size_t>());
+
+    results = coll1->search("*", {}, "store_id: 2 && in_stock: true", {}, {}, {0}, 10, 1,
+                            FREQUENCY, {true}, 10).get();
+
+    ASSERT_EQ(1, results["found"].get<size_t>());
+    ASSERT_EQ("4", results["hits"][0]["document"]["id"].get<std::string>());
+
+    results = coll1->search("*", {}, "in_stock:!= true", {}, {}, {0}, 10, 1, FREQUENCY, {true}, 10).get();
+
+    ASSERT_EQ(3, results["found"].get<size_t>());
+
+    // materialized lists must reflect deletions
+    coll1->remove("0");
+
+    results = coll1->search("*", {}, "in_stock:true", {}, {}, {0}, 10, 1, FREQUENCY, {true}, 10).get();
+
+    ASSERT_EQ(2, results["found"].get<size_t>());
+    ASSERT_EQ("4", results["hits"][0]["document"]["id"].get<std::string>());
+    ASSERT_EQ("2", results["hits"][1]["document"]["id"].get<std::string>());
+
+    // non-equality comparators still go through the numerical tree
+    results = coll1->search("*", {}, "store_id:>1", {}, {}, {0}, 10, 1, FREQUENCY, {true}, 10).get();
+
+    ASSERT_EQ(4, results["found"].get<size_t>());
+
+    collectionManager.drop_collection("coll1");
+}
@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <thread>
 #include <collection_manager.h>
 #include "string_utils.h"
 #include "collection.h"
@@ -639,4 +640,73 @@ TEST_F(CollectionManagerTest, ParseSortByClause) {
     sort_by_parsed = CollectionManager::parse_sort_by_str(",,", sort_fields);
     ASSERT_FALSE(sort_by_parsed);
 
-}
\ No newline at end of file
+}
+TEST_F(CollectionManagerTest, QuerySamplingAndWarmup) {
+    nlohmann::json doc;
+    doc["id"] = "0";
+    doc["title"] = "The quick brown fox";
+    doc["starring"] = "Wayne Rogers";
+    doc["cast"] = {"Wayne Rogers"};
+    doc["points"] = 10;
+
+    ASSERT_TRUE(collection1->add(doc.dump()).ok());
+
+    collectionManager.set_meta_store(store);
+
+    std::map<std::string, std::string> req_params;
+    req_params["collection"] = "collection1";
+    req_params["q"] = "quick";
+    req_params["query_by"] = "title";
+
+    collectionManager.sample_query(req_params);
+    collectionManager.sample_query(req_params);
+
+    std::map<std::string, std::string> req_params2;
+    req_params2["collection"] = "collection1";
+    req_params2["q"] = "fox";
+    req_params2["query_by"] = "title";
+
+    collectionManager.sample_query(req_params2);
+
+    // a sample without a collection is ignored
+    std::map<std::string, std::string> bad_params;
+    bad_params["q"] = "quick";
+    collectionManager.sample_query(bad_params);
+
+    collectionManager.persist_query_samples();
+
+    std::string samples_str;
+    StoreStatus status = store->get(CollectionManager::QUERY_SAMPLES_KEY, samples_str);
+    ASSERT_EQ(StoreStatus::FOUND, status);
+
+    nlohmann::json samples_json = nlohmann::json::parse(samples_str);
+    ASSERT_TRUE(samples_json.is_array());
+    ASSERT_EQ(2, samples_json.size());
+
+    // most popular query comes first
+    ASSERT_EQ(2, samples_json[0]["count"].get<uint64_t>());
+    ASSERT_EQ("quick", samples_json[0]["params"]["q"].get<std::string>());
+    ASSERT_EQ(1, samples_json[1]["count"].get<uint64_t>());
+    ASSERT_EQ("fox", samples_json[1]["params"]["q"].get<std::string>());
+
+    // unchanged samples are not re-persisted
+    ASSERT_TRUE(store->remove(CollectionManager::QUERY_SAMPLES_KEY));
+    collectionManager.persist_query_samples();
+    status = store->get(CollectionManager::QUERY_SAMPLES_KEY, samples_str);
+    ASSERT_EQ(StoreStatus::NOT_FOUND, status);
+
+    // persist again after a new sample and replay the stored queries
+    collectionManager.sample_query(req_params);
+    collectionManager.persist_query_samples();
+
+    ASSERT_TRUE(collectionManager.is_warmed_up());
+    collectionManager.trigger_query_warmup();
+
+    size_t num_tries = 0;
+    while(!collectionManager.is_warmed_up() && num_tries < 500) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        num_tries++;
+    }
+
+    ASSERT_TRUE(collectionManager.is_warmed_up());
+}
@@ -1014,3 +1014,78 @@ TEST_F(CollectionSortingTest, GeoPointArraySorting) {
 
     collectionManager.drop_collection("coll1");
 }
+
+TEST_F(CollectionSortingTest, StaticSortWalkOnWildcardQuery) {
+    // enough documents to exceed the default topster size (250) so that the
+    // sort-ordered walk kicks in for wildcard queries
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),
+                                 field("rank", field_types::INT32, false, true)};
+
+    Collection* coll1 = collectionManager.get_collection("coll1").get();
+    if(coll1 == nullptr) {
+        coll1 = collectionManager.create_collection("coll1", 4, fields, "points").get();
+    }
+
+    for(size_t i = 0; i < 300; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Record " + std::to_string(i);
+        doc["points"] = int32_t(i);
+
+        // only a prefix of the documents carries the optional field
+        if(i < 50) {
+            doc["rank"] = int32_t(i);
+        }
+
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    std::vector<sort_by> sort_fields = { sort_by("points", "DESC") };
+    auto results = coll1->search("*", {}, "", {}, sort_fields, {0}, 10, 1, FREQUENCY, {false}).get();
+
+    ASSERT_EQ(300, results["found"].get<size_t>());
+    ASSERT_EQ(10, results["hits"].size());
+
+    for(size_t i = 0; i < 10; i++) {
+        ASSERT_EQ(std::to_string(299 - i), results["hits"][i]["document"]["id"].get<std::string>());
+    }
+
+    // second page
+    results = coll1->search("*", {}, "", {}, sort_fields, {0}, 10, 2, FREQUENCY, {false}).get();
+    ASSERT_EQ(10, results["hits"].size());
+
+    for(size_t i = 0; i < 10; i++) {
+        ASSERT_EQ(std::to_string(289 - i), results["hits"][i]["document"]["id"].get<std::string>());
+    }
+
+    // ascending order
+    sort_fields = { sort_by("points", "ASC") };
+    results = coll1->search("*", {}, "", {}, sort_fields, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(10, results["hits"].size());
+
+    for(size_t i = 0; i < 10; i++) {
+        ASSERT_EQ(std::to_string(i), results["hits"][i]["document"]["id"].get<std::string>());
+    }
+
+    // with a filter applied on top
+    sort_fields = { sort_by("points", "DESC") };
+    results = coll1->search("*", {}, "points:<100", {}, sort_fields, {0}, 10, 1, FREQUENCY, {false}).get();
+
+    ASSERT_EQ(100, results["found"].get<size_t>());
+    for(size_t i = 0; i < 10; i++) {
+        ASSERT_EQ(std::to_string(99 - i), results["hits"][i]["document"]["id"].get<std::string>());
+    }
+
+    // sorting by an optional field most documents lack falls back to the full
+    // scan; documents without the field sort last either way
+    sort_fields = { sort_by("rank", "DESC") };
+    results = coll1->search("*", {}, "", {}, sort_fields, {0}, 10, 1, FREQUENCY, {false}).get();
+
+    ASSERT_EQ(300, results["found"].get<size_t>());
+    for(size_t i = 0; i < 10; i++) {
+        ASSERT_EQ(std::to_string(49 - i), results["hits"][i]["document"]["id"].get<std::string>());
+    }
+
+    collectionManager.drop_collection("coll1");
+}
@@ -1984,3 +1984,167 @@ TEST_F(CollectionSpecificTest, SingleHyphenInQueryNotToBeTreatedAsExclusion) {
     ASSERT_EQ(1, results["hits"].size());
     collectionManager.drop_collection("coll1");
 }
+
+TEST_F(CollectionSpecificTest, TypoCorrectionRanksAgainstFullTopster) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false)};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    // enough exact matches to fill the topster, plus documents reachable only
+    // via a single-typo correction
+    for(size_t i = 0; i < 300; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = (i < 280) ? "silver spoon" : "silver spoons";
+        doc["points"] = int32_t(i);
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    // exact query: all exact matches are found and rank first
+    auto results = coll1->search("silver spoon", {"title"}, "", {}, {}, {2}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(10, results["hits"].size());
+    ASSERT_GE(results["found"].get<size_t>(), 280);
+
+    // typo'd query: corrections must still surface when nothing matches exactly
+    results = coll1->search("silvar spoon", {"title"}, "", {}, {}, {2}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(10, results["hits"].size());
+    ASSERT_GE(results["found"].get<size_t>(), 280);
+    ASSERT_EQ("silver spoon", results["hits"][0]["document"]["title"].get<std::string>());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionSpecificTest, SerializedHitsEmission) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    for(size_t i = 0; i < 3; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "The quick brown fox " + std::to_string(i);
+        doc["points"] = int(i);
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    // when a serialized hits sink is passed, hits must arrive as response-ready
+    // JSON strings and the result tree's own hits array must stay empty
+    std::vector<std::string> serialized_hits;
+    auto results = coll1->search("quick", {"title"}, "", {}, sort_fields, {0}, 10, 1, FREQUENCY,
+                                 {false}, Index::DROP_TOKENS_THRESHOLD,
+                                 spp::sparse_hash_set<std::string>(),
+                                 spp::sparse_hash_set<std::string>(), 10, "", 30, 4, "", 1, "", "",
+                                 {}, 0, "<mark>", "</mark>", {}, UINT32_MAX, true, false, true, "",
+                                 false, 6000*1000, 4, 7, false, 100, 0, &serialized_hits).get();
+
+    ASSERT_EQ(3, results["found"].get<size_t>());
+    ASSERT_EQ(0, results["hits"].size());
+    ASSERT_EQ(3, serialized_hits.size());
+
+    for(size_t i = 0; i < serialized_hits.size(); i++) {
+        nlohmann::json hit = nlohmann::json::parse(serialized_hits[i]);
+        ASSERT_TRUE(hit.contains("document"));
+        ASSERT_TRUE(hit.contains("highlights"));
+        ASSERT_TRUE(hit.contains("text_match"));
+        ASSERT_EQ(1, hit["highlights"].size());
+        ASSERT_EQ("title", hit["highlights"][0]["field"].get<std::string>());
+    }
+
+    // descending by points: doc 2 first, with the full stored document spliced in
+    nlohmann::json first_hit = nlohmann::json::parse(serialized_hits[0]);
+    ASSERT_EQ("2", first_hit["document"]["id"].get<std::string>());
+    ASSERT_EQ("The quick brown fox 2", first_hit["document"]["title"].get<std::string>());
+    ASSERT_EQ(2, first_hit["document"]["points"].get<int>());
+
+    // with include_fields, hits are still serialized but the document is pruned
+    spp::sparse_hash_set<std::string> include_fields = {"title"};
+    serialized_hits.clear();
+    results = coll1->search("quick", {"title"}, "", {}, sort_fields, {0}, 10, 1, FREQUENCY,
+                            {false}, Index::DROP_TOKENS_THRESHOLD,
+                            include_fields,
+                            spp::sparse_hash_set<std::string>(), 10, "", 30, 4, "", 1, "", "",
+                            {}, 0, "<mark>", "</mark>", {}, UINT32_MAX, true, false, true, "",
+                            false, 6000*1000, 4, 7, false, 100, 0, &serialized_hits).get();
+
+    ASSERT_EQ(3, serialized_hits.size());
+    first_hit = nlohmann::json::parse(serialized_hits[0]);
+    ASSERT_EQ(1, first_hit["document"].size());
+    ASSERT_EQ("The quick brown fox 2", first_hit["document"]["title"].get<std::string>());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionSpecificTest, SearchAfterCursorPagination) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    for(size_t i = 0; i < 25; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "record number " + std::to_string(i);
+        doc["points"] = int(i);
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    // page one is an ordinary search: the response carries the cursor of its last hit
+    auto res1 = coll1->search("record", {"title"}, "", {}, sort_fields, {0}, 10, 1, FREQUENCY, {false}).get();
+
+    ASSERT_EQ(25, res1["found"].get<size_t>());
+    ASSERT_EQ(10, res1["hits"].size());
+    ASSERT_EQ("24", res1["hits"][0]["document"]["id"].get<std::string>());
+    ASSERT_EQ("15", res1["hits"][9]["document"]["id"].get<std::string>());
+    ASSERT_TRUE(res1.contains("search_cursor"));
+
+    // the cursor prunes already-served candidates, so the next page follows seamlessly
+    std::string cursor = res1["search_cursor"].get<std::string>();
+    auto res2 = coll1->search("record", {"title"}, "", {}, sort_fields, {0}, 10, 1, FREQUENCY,
+                              {false}, Index::DROP_TOKENS_THRESHOLD,
+                              spp::sparse_hash_set<std::string>(),
+                              spp::sparse_hash_set<std::string>(), 10, "", 30, 4, "", 1, "", "",
+                              {}, 0, "<mark>", "</mark>", {}, UINT32_MAX, true, false, true, "",
+                              false, 6000*1000, 4, 7, false, 100, 0, nullptr, cursor).get();
+
+    ASSERT_EQ(25, res2["found"].get<size_t>());
+    ASSERT_EQ(10, res2["hits"].size());
+    ASSERT_EQ("14", res2["hits"][0]["document"]["id"].get<std::string>());
+    ASSERT_EQ("5", res2["hits"][9]["document"]["id"].get<std::string>());
+
+    // final page is shorter and still yields a cursor that fetches nothing further
+    cursor = res2["search_cursor"].get<std::string>();
+    auto res3 = coll1->search("record", {"title"}, "", {}, sort_fields, {0}, 10, 1, FREQUENCY,
+                              {false}, Index::DROP_TOKENS_THRESHOLD,
+                              spp::sparse_hash_set<std::string>(),
+                              spp::sparse_hash_set<std::string>(), 10, "", 30, 4, "", 1, "", "",
+                              {}, 0, "<mark>", "</mark>", {}, UINT32_MAX, true, false, true, "",
+                              false, 6000*1000, 4, 7, false, 100, 0, nullptr, cursor).get();
+
+    ASSERT_EQ(5, res3["hits"].size());
+    ASSERT_EQ("4", res3["hits"][0]["document"]["id"].get<std::string>());
+    ASSERT_EQ("0", res3["hits"][4]["document"]["id"].get<std::string>());
+
+    // a malformed cursor is rejected
+    auto bad_op = coll1->search("record", {"title"}, "", {}, sort_fields, {0}, 10, 1, FREQUENCY,
+                                {false}, Index::DROP_TOKENS_THRESHOLD,
+                                spp::sparse_hash_set<std::string>(),
+                                spp::sparse_hash_set<std::string>(), 10, "", 30, 4, "", 1, "", "",
+                                {}, 0, "<mark>", "</mark>", {}, UINT32_MAX, true, false, true, "",
+                                false, 6000*1000, 4, 7, false, 100, 0, nullptr, "not-a-cursor");
+    ASSERT_FALSE(bad_op.ok());
+    ASSERT_EQ(422, bad_op.code());
+
+    // `page` and `search_after` cannot be combined
+    bad_op = coll1->search("record", {"title"}, "", {}, sort_fields, {0}, 10, 2, FREQUENCY,
+                           {false}, Index::DROP_TOKENS_THRESHOLD,
+                           spp::sparse_hash_set<std::string>(),
+                           spp::sparse_hash_set<std::string>(), 10, "", 30, 4, "", 1, "", "",
+                           {}, 0, "<mark>", "</mark>", {}, UINT32_MAX, true, false, true, "",
+                           false, 6000*1000, 4, 7, false, 100, 0, nullptr, cursor);
+    ASSERT_FALSE(bad_op.ok());
+    ASSERT_EQ(422, bad_op.code());
+
+    collectionManager.drop_collection("coll1");
+}
@@ -570,4 +570,34 @@ TEST_F(CollectionSynonymsTest, SynonymSingleTokenExactMatch) {
     ASSERT_STREQ("1", res["hits"][1]["document"]["id"].get<std::string>().c_str());
 
     collectionManager.drop_collection("coll1");
-}
\ No newline at end of file
+}
+TEST_F(CollectionSynonymsTest, RepeatedQueryReflectsSynonymChanges) {
+    // repeated identical queries hit the compiled plan cache, so synonym
+    // changes in between must invalidate cached plans
+    nlohmann::json syn_json = {
+        {"id", "syn-1"},
+        {"root", "Ocean"},
+        {"synonyms", {"Sea"} }
+    };
+
+    synonym_t synonym;
+    auto syn_op = synonym_t::parse(syn_json, synonym);
+    ASSERT_TRUE(syn_op.ok());
+
+    auto res = coll_mul_fields->search("ocean", {"title"}, "", {}, {}, {0}, 10).get();
+    ASSERT_EQ(0, res["found"].get<uint32_t>());
+
+    // same query again: served from the cached plan
+    res = coll_mul_fields->search("ocean", {"title"}, "", {}, {}, {0}, 10).get();
+    ASSERT_EQ(0, res["found"].get<uint32_t>());
+
+    coll_mul_fields->add_synonym(synonym);
+
+    res = coll_mul_fields->search("ocean", {"title"}, "", {}, {}, {0}, 10).get();
+    ASSERT_EQ(1, res["found"].get<uint32_t>());
+
+    coll_mul_fields->remove_synonym("syn-1");
+
+    res = coll_mul_fields->search("ocean", {"title"}, "", {}, {}, {0}, 10).get();
+    ASSERT_EQ(0, res["found"].get<uint32_t>());
+}
@@ -92,6 +92,39 @@ TEST_F(CollectionTest, VerifyCountOfDocuments) {
     ASSERT_EQ(DIRTY_VALUES::REJECT, collection->parse_dirty_values_option(empty_dirty_values));
 }
 
+TEST_F(CollectionTest, MemoryStatsJson) {
+    nlohmann::json stats = collection->get_stats_json();
+
+    ASSERT_EQ("collection", stats["name"].get<std::string>());
+    ASSERT_EQ(collection->get_num_documents(), stats["num_documents"].get<size_t>());
+
+    const nlohmann::json& memory = stats["memory"];
+
+    // title tokens live in the ART trees / interner, their ids in posting lists
+    ASSERT_GT(memory["art_tree_bytes"].get<uint64_t>(), 0);
+    ASSERT_GT(memory["token_interner_bytes"].get<uint64_t>(), 0);
+    ASSERT_GT(memory["posting_list_bytes"].get<uint64_t>(), 0);
+
+    // `points` is indexed both for filtering and sorting
+    ASSERT_GT(memory["numerical_index_bytes"].get<uint64_t>(), 0);
+    ASSERT_GT(memory["sort_index_bytes"].get<uint64_t>(), 0);
+
+    ASSERT_GT(memory["seq_ids_bytes"].get<uint64_t>(), 0);
+
+    // no facet / bool / geo fields in this schema
+    ASSERT_EQ(0, memory["facet_index_bytes"].get<uint64_t>());
+    ASSERT_EQ(0, memory["bool_index_bytes"].get<uint64_t>());
+    ASSERT_EQ(0, memory["geopoint_index_bytes"].get<uint64_t>());
+
+    const uint64_t total_bytes = memory["total_bytes"].get<uint64_t>();
+    ASSERT_EQ(total_bytes,
+              memory["art_tree_bytes"].get<uint64_t>() + memory["token_interner_bytes"].get<uint64_t>() +
+              memory["posting_list_bytes"].get<uint64_t>() + memory["numerical_index_bytes"].get<uint64_t>() +
+              memory["bool_index_bytes"].get<uint64_t>() + memory["materialized_filter_index_bytes"].get<uint64_t>() +
+              memory["geopoint_index_bytes"].get<uint64_t>() + memory["facet_index_bytes"].get<uint64_t>() +
+              memory["sort_index_bytes"].get<uint64_t>() + memory["seq_ids_bytes"].get<uint64_t>());
+}
+
 TEST_F(CollectionTest, RetrieveADocumentById) {
     Option<nlohmann::json> doc_option = collection->get("1");
     ASSERT_TRUE(doc_option.ok());
@@ -1535,6 +1568,52 @@ TEST_F(CollectionTest, ImportDocuments) {
     collectionManager.drop_collection("coll_mul_fields");
 }
 
+TEST_F(CollectionTest, ImportDocumentsMsgpack) {
+    std::vector<field> fields = {
+        field("title", field_types::STRING, false),
+        field("points", field_types::INT32, false)
+    };
+
+    Collection* coll_msgpack = collectionManager.get_collection("coll_msgpack").get();
+    if(coll_msgpack == nullptr) {
+        coll_msgpack = collectionManager.create_collection("coll_msgpack", 4, fields, "points").get();
+    }
+
+    std::vector<std::string> import_records;
+    for(size_t i = 0; i < 3; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Binary title " + std::to_string(i);
+        doc["points"] = int(i);
+
+        const std::vector<std::uint8_t>& packed = nlohmann::json::to_msgpack(doc);
+        import_records.emplace_back(packed.begin(), packed.end());
+    }
+
+    nlohmann::json document;
+    nlohmann::json import_response = coll_msgpack->add_many(import_records, document, CREATE, "",
+                                                            DIRTY_VALUES::COERCE_OR_REJECT, true);
+    ASSERT_TRUE(import_response["success"].get<bool>());
+    ASSERT_EQ(3, import_response["num_imported"].get<int>());
+
+    auto results = coll_msgpack->search("binary", {"title"}, "", {}, sort_fields, {0}, 10, 1,
+                                        FREQUENCY, {false}).get();
+    ASSERT_EQ(3, results["hits"].size());
+
+    // a record that is not valid msgpack must be rejected with a parse error
+    std::vector<std::string> bad_records = {"plain text, not msgpack"};
+    import_response = coll_msgpack->add_many(bad_records, document, CREATE, "",
+                                             DIRTY_VALUES::COERCE_OR_REJECT, true);
+    ASSERT_FALSE(import_response["success"].get<bool>());
+    ASSERT_EQ(0, import_response["num_imported"].get<int>());
+
+    nlohmann::json bad_res = nlohmann::json::parse(bad_records[0]);
+    ASSERT_FALSE(bad_res["success"].get<bool>());
+    ASSERT_EQ(0, bad_res["error"].get<std::string>().rfind("Bad MessagePack:", 0));
+
+    collectionManager.drop_collection("coll_msgpack");
+}
+
 TEST_F(CollectionTest, SearchingWithMissingFields) {
     // return error without crashing when searching for fields that do not conform to the schema
     Collection *coll_array_fields;
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "collection.h"
 #include <vector>
+#include <thread>
+#include <chrono>
 #include <collection_manager.h>
 #include <core_api.h>
 #include "core_api_utils.h"
@@ -343,3 +345,77 @@ TEST_F(CoreAPIUtilsTest, ExtractCollectionsFromRequestBodyExtended) {
     ASSERT_EQ(1, collections.size());
     ASSERT_STREQ("", collections[0].c_str());
 }
+
+TEST_F(CoreAPIUtilsTest, DeleteJobManager) {
+    Collection *coll1;
+
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    coll1 = collectionManager.get_collection("coll1").get();
+    if(coll1 == nullptr) {
+        coll1 = collectionManager.create_collection("coll1", 2, fields, "points").get();
+    }
+
+    for(size_t i=0; i<100; i++) {
+        nlohmann::json doc;
+
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Title " + std::to_string(i);
+        doc["points"] = i;
+
+        coll1->add(doc.dump());
+    }
+
+    auto submit_op = DeleteJobManager::get_instance().submit("coll1", "points: < 50", 10);
+    ASSERT_TRUE(submit_op.ok());
+
+    auto job = submit_op.get();
+
+    // wait for the background job to run to completion
+    for(size_t i = 0; i < 250 && job->state == delete_job_t::state_t::running; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    ASSERT_EQ(delete_job_t::state_t::done, job->state.load());
+    ASSERT_EQ(50, job->num_matched.load());
+    ASSERT_EQ(50, job->num_removed.load());
+
+    std::vector<std::pair<size_t, uint32_t*>> index_ids;
+    coll1->get_filter_ids("points: < 50", index_ids);
+    size_t num_left = 0;
+    for(auto& kv: index_ids) {
+        num_left += kv.first;
+        delete [] kv.second;
+    }
+    ASSERT_EQ(0, num_left);
+
+    // polling the job by id
+    auto get_op = DeleteJobManager::get_instance().get(job->id);
+    ASSERT_TRUE(get_op.ok());
+    ASSERT_EQ("done", get_op.get()->to_json()["state"].get<std::string>());
+
+    // unknown job id
+    auto missing_op = DeleteJobManager::get_instance().get(9999999);
+    ASSERT_FALSE(missing_op.ok());
+    ASSERT_EQ(404, missing_op.code());
+
+    // cancelling a finished job is a no-op
+    auto cancel_op = DeleteJobManager::get_instance().cancel(job->id);
+    ASSERT_TRUE(cancel_op.ok());
+    ASSERT_EQ(delete_job_t::state_t::done, cancel_op.get()->state.load());
+
+    // a bad filter surfaces as a failed job
+    auto bad_op = DeleteJobManager::get_instance().submit("coll1", "bad filter", 10);
+    ASSERT_TRUE(bad_op.ok());
+    auto bad_job = bad_op.get();
+
+    for(size_t i = 0; i < 250 && bad_job->state == delete_job_t::state_t::running; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    ASSERT_EQ(delete_job_t::state_t::failed, bad_job->state.load());
+    ASSERT_EQ("Could not parse the filter query.", bad_job->to_json()["error"].get<std::string>());
+
+    collectionManager.drop_collection("coll1");
+}
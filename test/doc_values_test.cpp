@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+#include "doc_values.h"
+
+TEST(DocValuesTest, UpsertGetErase) {
+    doc_values_t dvs;
+
+    dvs.upsert(0, 100);
+    dvs.upsert(5, -250);
+    dvs.upsert(2, 75);
+
+    ASSERT_TRUE(dvs.contains(0));
+    ASSERT_TRUE(dvs.contains(2));
+    ASSERT_TRUE(dvs.contains(5));
+    ASSERT_EQ(100, dvs.at(0));
+    ASSERT_EQ(75, dvs.at(2));
+    ASSERT_EQ(-250, dvs.at(5));
+
+    // slots in the gap and past the end are missing
+    ASSERT_FALSE(dvs.contains(1));
+    ASSERT_FALSE(dvs.contains(3));
+    ASSERT_FALSE(dvs.contains(100));
+    ASSERT_EQ(INT64_MIN, dvs.get(3, INT64_MIN));
+    ASSERT_EQ(INT64_MIN, dvs.get(100, INT64_MIN));
+
+    // update path: same seq_id is re-written in place
+    dvs.upsert(2, 80);
+    ASSERT_EQ(80, dvs.at(2));
+
+    dvs.erase(5);
+    ASSERT_FALSE(dvs.contains(5));
+    ASSERT_EQ(INT64_MIN, dvs.get(5, INT64_MIN));
+
+    // erase of an unknown seq_id is a no-op
+    dvs.erase(1000);
+
+    // deleted slot is reused when the document comes back
+    dvs.upsert(5, 300);
+    ASSERT_TRUE(dvs.contains(5));
+    ASSERT_EQ(300, dvs.at(5));
+}
+
+TEST(DocValuesTest, MonotonicGrowth) {
+    doc_values_t dvs;
+
+    for(uint32_t seq_id = 0; seq_id < 100000; seq_id++) {
+        dvs.upsert(seq_id, int64_t(seq_id) * 2);
+    }
+
+    ASSERT_EQ(100000, dvs.num_slots());
+
+    for(uint32_t seq_id = 0; seq_id < 100000; seq_id++) {
+        ASSERT_EQ(int64_t(seq_id) * 2, dvs.get(seq_id, INT64_MIN));
+    }
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "facet_column.h"
+
+namespace {
+    facet_hash_values_t make_hashes(const std::vector<uint64_t>& values) {
+        facet_hash_values_t fhashvalues;
+        fhashvalues.length = values.size();
+        fhashvalues.hashes = new uint64_t[values.size()];
+
+        for(size_t i = 0; i < values.size(); i++) {
+            fhashvalues.hashes[i] = values[i];
+        }
+
+        return fhashvalues;
+    }
+}
+
+TEST(FacetColumnTest, UpsertGetErase) {
+    facet_column_t fcolumn;
+
+    ASSERT_EQ(nullptr, fcolumn.get(0));
+    ASSERT_EQ(0, fcolumn.num_rows());
+
+    fcolumn.upsert(5, make_hashes({100, 101, 102}));
+    ASSERT_EQ(6, fcolumn.num_rows());
+
+    const facet_hash_values_t* row = fcolumn.get(5);
+    ASSERT_NE(nullptr, row);
+    ASSERT_EQ(3, row->size());
+    ASSERT_EQ(100, row->hashes[0]);
+    ASSERT_EQ(102, row->back());
+
+    // rows in the gap and past the end are missing
+    ASSERT_EQ(nullptr, fcolumn.get(3));
+    ASSERT_EQ(nullptr, fcolumn.get(100));
+
+    // update path: old hashes are released and replaced
+    fcolumn.upsert(5, make_hashes({200}));
+    row = fcolumn.get(5);
+    ASSERT_NE(nullptr, row);
+    ASSERT_EQ(1, row->size());
+    ASSERT_EQ(200, row->hashes[0]);
+
+    fcolumn.erase(5);
+    ASSERT_EQ(nullptr, fcolumn.get(5));
+
+    // erase of an unknown seq_id is a no-op
+    fcolumn.erase(1000);
+
+    // deleted row is reused when the document comes back
+    fcolumn.upsert(5, make_hashes({300}));
+    row = fcolumn.get(5);
+    ASSERT_NE(nullptr, row);
+    ASSERT_EQ(300, row->hashes[0]);
+}
+
+TEST(FacetColumnTest, MonotonicGrowth) {
+    facet_column_t fcolumn;
+
+    for(uint32_t seq_id = 0; seq_id < 100000; seq_id++) {
+        fcolumn.upsert(seq_id, make_hashes({uint64_t(seq_id)}));
+    }
+
+    ASSERT_EQ(100000, fcolumn.num_rows());
+
+    for(uint32_t seq_id = 0; seq_id < 100000; seq_id++) {
+        const facet_hash_values_t* row = fcolumn.get(seq_id);
+        ASSERT_NE(nullptr, row);
+        ASSERT_EQ(uint64_t(seq_id), row->hashes[0]);
+    }
+}
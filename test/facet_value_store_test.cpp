@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+#include "facet_value_store.h"
+
+TEST(FacetValueStoreTest, InternReleaseGet) {
+    facet_value_store_t fvstore;
+
+    ASSERT_EQ(nullptr, fvstore.get(100));
+    ASSERT_EQ(0, fvstore.num_values());
+
+    // repeated values share a single stored copy
+    fvstore.intern(100, "Electronics");
+    fvstore.intern(100, "Electronics");
+    fvstore.intern(200, "Furniture");
+
+    ASSERT_EQ(2, fvstore.num_values());
+
+    const std::string* value = fvstore.get(100);
+    ASSERT_NE(nullptr, value);
+    ASSERT_EQ("Electronics", *value);
+
+    value = fvstore.get(200);
+    ASSERT_NE(nullptr, value);
+    ASSERT_EQ("Furniture", *value);
+
+    // value survives until the last reference is released
+    fvstore.release(100);
+    ASSERT_NE(nullptr, fvstore.get(100));
+
+    fvstore.release(100);
+    ASSERT_EQ(nullptr, fvstore.get(100));
+    ASSERT_EQ(1, fvstore.num_values());
+
+    // releasing an unknown hash is a no-op
+    fvstore.release(999);
+
+    // re-interning after full release stores the value again
+    fvstore.intern(100, "Electronics");
+    value = fvstore.get(100);
+    ASSERT_NE(nullptr, value);
+    ASSERT_EQ("Electronics", *value);
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include "geo_index.h"
+
+TEST(GeoIndexTest, InsertCollectRemove) {
+    geo_index_t geo_index;
+
+    geo_index.insert("cell_a", 5);
+    geo_index.insert("cell_a", 1);
+    geo_index.insert("cell_a", 9);
+    geo_index.insert("cell_b", 9);
+    geo_index.insert("cell_b", 3);
+
+    // duplicate insert is a no-op
+    geo_index.insert("cell_a", 5);
+
+    ASSERT_EQ(2, geo_index.num_cells());
+
+    std::vector<uint32_t> result_ids;
+    geo_index.collect({"cell_a", "cell_b", "cell_missing"}, result_ids);
+
+    // sorted union across cells
+    std::vector<uint32_t> expected = {1, 3, 5, 9};
+    ASSERT_EQ(expected, result_ids);
+
+    geo_index.remove("cell_a", 5);
+    geo_index.remove("cell_a", 100);       // unknown id is a no-op
+    geo_index.remove("cell_missing", 1);   // unknown cell is a no-op
+
+    result_ids.clear();
+    geo_index.collect({"cell_a"}, result_ids);
+    expected = {1, 9};
+    ASSERT_EQ(expected, result_ids);
+
+    // cell is dropped once its last id is removed
+    geo_index.remove("cell_b", 3);
+    geo_index.remove("cell_b", 9);
+    ASSERT_EQ(1, geo_index.num_cells());
+
+    result_ids.clear();
+    geo_index.collect({"cell_b"}, result_ids);
+    ASSERT_TRUE(result_ids.empty());
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <lev_automaton.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Reference optimal string alignment distance (same recurrence that
+// art.cpp's DP fallback uses).
+static int osa_distance(const std::string& key, const std::string& term) {
+    const size_t rows = key.size() + 1, cols = term.size() + 1;
+    std::vector<std::vector<int>> d(rows, std::vector<int>(cols, 0));
+
+    for(size_t i = 0; i < rows; i++) {
+        d[i][0] = i;
+    }
+
+    for(size_t j = 0; j < cols; j++) {
+        d[0][j] = j;
+    }
+
+    for(size_t i = 1; i < rows; i++) {
+        for(size_t j = 1; j < cols; j++) {
+            int cost = (key[i-1] == term[j-1]) ? 0 : 1;
+            d[i][j] = std::min({d[i-1][j] + 1, d[i][j-1] + 1, d[i-1][j-1] + cost});
+            if(i > 2 && j > 1 && key[i-1] == term[j-2] && key[i-2] == term[j-1]) {
+                d[i][j] = std::min(d[i][j], d[i-2][j-2] + 1);
+            }
+        }
+    }
+
+    return d[rows-1][cols-1];
+}
+
+static int automaton_cost(const std::string& term, const std::string& key, int max_edits) {
+    lev_automaton la(reinterpret_cast<const unsigned char*>(term.c_str()), term.size(), max_edits);
+    lev_automaton::state st = la.initial();
+
+    for(size_t i = 0; i < key.size(); i++) {
+        la.step(st, key[i], i);
+    }
+
+    return la.cost_at(st, term.size());
+}
+
+TEST(LevAutomatonTest, ExactMatchHasZeroCost) {
+    ASSERT_EQ(0, automaton_cost("platinum", "platinum", 2));
+    ASSERT_EQ(0, automaton_cost("a", "a", 1));
+}
+
+TEST(LevAutomatonTest, SingleEdits) {
+    ASSERT_EQ(1, automaton_cost("platinum", "pltinum", 2));    // deletion
+    ASSERT_EQ(1, automaton_cost("platinum", "plaatinum", 2));  // insertion
+    ASSERT_EQ(1, automaton_cost("platinum", "plotinum", 2));   // substitution
+}
+
+TEST(LevAutomatonTest, TranspositionCountsAsOneEdit) {
+    ASSERT_EQ(1, automaton_cost("platinum", "paltinum", 2));
+    ASSERT_EQ(1, automaton_cost("abcdef", "abdcef", 2));
+}
+
+TEST(LevAutomatonTest, CostBeyondBudgetIsInfinity) {
+    ASSERT_GT(automaton_cost("platinum", "gold", 2), 2);
+    ASSERT_GT(automaton_cost("abc", "xyz", 1), 1);
+}
+
+TEST(LevAutomatonTest, DeadStateAfterDivergence) {
+    std::string term = "abc";
+    lev_automaton la(reinterpret_cast<const unsigned char*>(term.c_str()), term.size(), 1);
+    lev_automaton::state st = la.initial();
+
+    std::string key = "xyzw";
+    for(size_t i = 0; i < key.size(); i++) {
+        la.step(st, key[i], i);
+    }
+
+    ASSERT_TRUE(la.is_dead(st));
+}
+
+TEST(LevAutomatonTest, MatchesBruteForceOSADistance) {
+    srand(42);
+    const char* alphabet = "abcd";
+
+    for(int trial = 0; trial < 5000; trial++) {
+        std::string term, key;
+        int term_len = 1 + rand() % 10;
+        int key_len = 1 + rand() % 14;
+
+        for(int i = 0; i < term_len; i++) {
+            term += alphabet[rand() % 4];
+        }
+
+        for(int i = 0; i < key_len; i++) {
+            key += alphabet[rand() % 4];
+        }
+
+        int max_edits = 1 + rand() % 4;
+        int expected = osa_distance(key, term);
+        int actual = automaton_cost(term, key, max_edits);
+
+        if(expected <= max_edits) {
+            ASSERT_EQ(expected, actual) << "term=" << term << ", key=" << key;
+        } else {
+            ASSERT_GT(actual, max_edits) << "term=" << term << ", key=" << key;
+        }
+    }
+}
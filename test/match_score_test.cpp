@@ -23,6 +23,49 @@ TEST(MatchTest, TokenOffsetsExceedWindowSize) {
     ASSERT_EQ(WINDOW_SIZE, (size_t)this_match.words_present);
 }
 
+TEST(MatchTest, ScoringFastPathMatchesWindowedPath) {
+    std::vector<std::vector<token_positions_t>> cases = {
+        {
+            token_positions_t{false, {25}},
+            token_positions_t{false, {26}},
+            token_positions_t{false, {11, 18, 24, 60}},
+            token_positions_t{false, {14, 27, 63}},
+        },
+        {
+            token_positions_t{false, {38, 50, 170, 187, 195, 222}},
+            token_positions_t{true, {39, 140, 171, 189, 223}},
+            token_positions_t{false, {169, 180}},
+        },
+        {
+            // no two tokens fall within a single window
+            token_positions_t{false, {38, 50, 187, 195, 201}},
+            token_positions_t{false, {120, 167, 171, 223}},
+            token_positions_t{true, {240, 250}},
+        },
+        {
+            // tokens sharing the same offset
+            token_positions_t{false, {7}},
+            token_positions_t{false, {7}},
+            token_positions_t{true, {7, 9}},
+        },
+        {
+            token_positions_t{false, {0}},
+            token_positions_t{true, {2}},
+            token_positions_t{false, {1}},
+        },
+    };
+
+    for(const auto& token_offsets: cases) {
+        const Match& windowed = Match(100, token_offsets, true, true);
+        const Match& scored = Match(100, token_offsets, false, true);
+
+        ASSERT_EQ(windowed.words_present, scored.words_present);
+        ASSERT_EQ(windowed.distance, scored.distance);
+        ASSERT_EQ(windowed.exact_match, scored.exact_match);
+        ASSERT_EQ(0, scored.offsets.size());
+    }
+}
+
 TEST(MatchTest, MatchScoreV2) {
     std::vector<token_positions_t> token_offsets;
     token_offsets.push_back(token_positions_t{false, {25}});
@@ -42,3 +42,56 @@ TEST(NumTreeTest, Searches) {
     delete [] ids;
     ids = nullptr;
 }
+
+TEST(NumTreeTest, RangeSearchAcrossLeafPages) {
+    num_tree_t tree;
+
+    // enough distinct values to force multiple leaf page splits
+    for(int64_t v = 0; v < 500; v++) {
+        tree.insert(v * 10, (uint32_t) v);
+    }
+
+    ASSERT_EQ(500, tree.size());
+
+    uint32_t* ids = nullptr;
+    size_t ids_len = 0;
+
+    tree.range_inclusive_search(1000, 2000, &ids, ids_len);
+    ASSERT_EQ(101, ids_len);
+    ASSERT_EQ(100, ids[0]);
+    ASSERT_EQ(200, ids[100]);
+    delete [] ids;
+    ids = nullptr;
+    ids_len = 0;
+
+    // removing the sole id of a value should drop the key entirely
+    tree.remove(1000, 100);
+    ASSERT_EQ(499, tree.size());
+
+    tree.range_inclusive_search(1000, 2000, &ids, ids_len);
+    ASSERT_EQ(100, ids_len);
+    ASSERT_EQ(101, ids[0]);
+    delete [] ids;
+    ids = nullptr;
+    ids_len = 0;
+
+    // a write into an already-scanned page must invalidate its cached id union
+    tree.insert(1500, 777);
+    tree.range_inclusive_search(1000, 2000, &ids, ids_len);
+    ASSERT_EQ(101, ids_len);
+    ASSERT_EQ(777, ids[100]);
+    delete [] ids;
+    ids = nullptr;
+    ids_len = 0;
+
+    tree.search(NUM_COMPARATOR::GREATER_THAN_EQUALS, 4000, &ids, ids_len);
+    ASSERT_EQ(100, ids_len);
+    ASSERT_EQ(400, ids[0]);
+    delete [] ids;
+    ids = nullptr;
+    ids_len = 0;
+
+    tree.search(NUM_COMPARATOR::LESS_THAN, 500, &ids, ids_len);
+    ASSERT_EQ(50, ids_len);
+    delete [] ids;
+}
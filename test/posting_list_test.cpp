@@ -1047,7 +1047,7 @@ TEST_F(PostingListTest, CompactPostingListUpsertAppends) {
 
     compact_posting_list_t* list = compact_posting_list_t::create(3, ids, offset_index, 9, offsets);
     ASSERT_EQ(15, list->length);
-    ASSERT_EQ(15, list->capacity);
+    ASSERT_EQ(22, list->capacity);
     ASSERT_EQ(1002, list->last_id());
     ASSERT_EQ(3, list->num_ids());
 
@@ -1057,10 +1057,10 @@ TEST_F(PostingListTest, CompactPostingListUpsertAppends) {
     ASSERT_FALSE(list->contains(500));
     ASSERT_FALSE(list->contains(2));
 
-    // no-op since the container expects resizing to be done outside
-    list->upsert(1003, {1, 2});
+    // no-op since this exceeds the container's slack and resizing is done outside
+    list->upsert(1003, {1, 2, 3, 4, 5, 6});
     ASSERT_EQ(15, list->length);
-    ASSERT_EQ(15, list->capacity);
+    ASSERT_EQ(22, list->capacity);
     ASSERT_EQ(1002, list->last_id());
     ASSERT_EQ(3, list->num_ids());
 
@@ -1070,7 +1070,7 @@ TEST_F(PostingListTest, CompactPostingListUpsertAppends) {
     ASSERT_EQ(1003, COMPACT_POSTING_PTR(obj)->last_id());
 
     ASSERT_EQ(19, (COMPACT_POSTING_PTR(obj))->length);
-    ASSERT_EQ(24, (COMPACT_POSTING_PTR(obj))->capacity);
+    ASSERT_EQ(22, (COMPACT_POSTING_PTR(obj))->capacity);
     ASSERT_EQ(4, (COMPACT_POSTING_PTR(obj))->ids_length);
 
     // insert enough docs to NOT exceed compact posting list threshold
@@ -1106,7 +1106,7 @@ TEST_F(PostingListTest, CompactPostingListUpserts) {
 
     compact_posting_list_t* list = compact_posting_list_t::create(3, ids, offset_index, 9, offsets);
     ASSERT_EQ(15, list->length);
-    ASSERT_EQ(15, list->capacity);
+    ASSERT_EQ(22, list->capacity);
     ASSERT_EQ(1002, list->last_id());
     ASSERT_EQ(3, list->num_ids());
 
@@ -1116,14 +1116,14 @@ TEST_F(PostingListTest, CompactPostingListUpserts) {
     posting_t::upsert(obj, 2, {1, 2});
     ASSERT_EQ(1002, COMPACT_POSTING_PTR(obj)->last_id());
     ASSERT_EQ(19, COMPACT_POSTING_PTR(obj)->length);
-    ASSERT_EQ(24, COMPACT_POSTING_PTR(obj)->capacity);
+    ASSERT_EQ(22, COMPACT_POSTING_PTR(obj)->capacity);
     ASSERT_EQ(4, COMPACT_POSTING_PTR(obj)->num_ids());
 
     // insert in the middle
     posting_t::upsert(obj, 999, {1, 2});
     ASSERT_EQ(1002, COMPACT_POSTING_PTR(obj)->last_id());
     ASSERT_EQ(23, COMPACT_POSTING_PTR(obj)->length);
-    ASSERT_EQ(24, COMPACT_POSTING_PTR(obj)->capacity);
+    ASSERT_EQ(44, COMPACT_POSTING_PTR(obj)->capacity);
     ASSERT_EQ(5, COMPACT_POSTING_PTR(obj)->num_ids());
 
     uint32_t expected_id_offsets[] = {
@@ -1150,7 +1150,7 @@ TEST_F(PostingListTest, CompactPostingListUpdateWithLessOffsets) {
 
     compact_posting_list_t* list = compact_posting_list_t::create(3, ids, offset_index, 9, offsets);
     ASSERT_EQ(15, list->length);
-    ASSERT_EQ(15, list->capacity);
+    ASSERT_EQ(22, list->capacity);
     ASSERT_EQ(1002, list->last_id());
     ASSERT_EQ(3, list->num_ids());
 
@@ -1158,7 +1158,7 @@ TEST_F(PostingListTest, CompactPostingListUpdateWithLessOffsets) {
 
     list->upsert(1000, {1, 2});
     ASSERT_EQ(14, list->length);
-    ASSERT_EQ(15, list->capacity);
+    ASSERT_EQ(22, list->capacity);
     ASSERT_EQ(1002, list->last_id());
     ASSERT_EQ(3, list->num_ids());
     uint32_t expected_id_offsets[] = {3, 0, 3, 4, 0, 2, 1, 2, 1000, 3, 0, 3, 4, 1002};
@@ -1169,7 +1169,7 @@ TEST_F(PostingListTest, CompactPostingListUpdateWithLessOffsets) {
     // update start
     list->upsert(0, {2, 4});
     ASSERT_EQ(13, list->length);
-    ASSERT_EQ(15, list->capacity);
+    ASSERT_EQ(22, list->capacity);
     ASSERT_EQ(1002, list->last_id());
     ASSERT_EQ(3, list->num_ids());
     uint32_t expected_id_offsets2[] = {2, 2, 4, 0, 2, 1, 2, 1000, 3, 0, 3, 4, 1002};
@@ -1180,7 +1180,7 @@ TEST_F(PostingListTest, CompactPostingListUpdateWithLessOffsets) {
     // update end
     list->upsert(1002, {2, 4});
     ASSERT_EQ(12, list->length);
-    ASSERT_EQ(15, list->capacity);
+    ASSERT_EQ(22, list->capacity);
     ASSERT_EQ(1002, list->last_id());
     ASSERT_EQ(3, list->num_ids());
     uint32_t expected_id_offsets3[] = {2, 2, 4, 0, 2, 1, 2, 1000, 2, 2, 4, 1002};
@@ -1198,7 +1198,7 @@ TEST_F(PostingListTest, CompactPostingListUpdateWithMoreOffsets) {
 
     compact_posting_list_t* list = compact_posting_list_t::create(3, ids, offset_index, 9, offsets);
     ASSERT_EQ(15, list->length);
-    ASSERT_EQ(15, list->capacity);
+    ASSERT_EQ(22, list->capacity);
     ASSERT_EQ(1002, list->last_id());
     ASSERT_EQ(3, list->num_ids());
 
@@ -1207,7 +1207,7 @@ TEST_F(PostingListTest, CompactPostingListUpdateWithMoreOffsets) {
     posting_t::upsert(obj, 1000, {1, 2, 3, 4});
     list = COMPACT_POSTING_PTR(obj);
     ASSERT_EQ(16, list->length);
-    ASSERT_EQ(20, list->capacity);
+    ASSERT_EQ(22, list->capacity);
     ASSERT_EQ(1002, list->last_id());
     ASSERT_EQ(3, list->num_ids());
     uint32_t expected_id_offsets[] = {3, 0, 3, 4, 0, 4, 1, 2, 3, 4, 1000, 3, 0, 3, 4, 1002};
@@ -1218,7 +1218,7 @@ TEST_F(PostingListTest, CompactPostingListUpdateWithMoreOffsets) {
     // update start
     list->upsert(0, {1, 2, 3, 4});
     ASSERT_EQ(17, list->length);
-    ASSERT_EQ(20, list->capacity);
+    ASSERT_EQ(22, list->capacity);
     ASSERT_EQ(1002, list->last_id());
     ASSERT_EQ(3, list->num_ids());
     uint32_t expected_id_offsets2[] = {4, 1, 2, 3, 4, 0, 4, 1, 2, 3, 4, 1000, 3, 0, 3, 4, 1002};
@@ -1229,7 +1229,7 @@ TEST_F(PostingListTest, CompactPostingListUpdateWithMoreOffsets) {
     // update end
     list->upsert(1002, {1, 2, 3, 4});
     ASSERT_EQ(18, list->length);
-    ASSERT_EQ(20, list->capacity);
+    ASSERT_EQ(22, list->capacity);
     ASSERT_EQ(1002, list->last_id());
     ASSERT_EQ(3, list->num_ids());
     uint32_t expected_id_offsets3[] = {4, 1, 2, 3, 4, 0, 4, 1, 2, 3, 4, 1000, 4, 1, 2, 3, 4, 1002};
@@ -1250,13 +1250,13 @@ TEST_F(PostingListTest, CompactPostingListErase) {
     list->erase(3); // erase non-existing ID
 
     ASSERT_EQ(15, list->length);
-    ASSERT_EQ(15, list->capacity);
+    ASSERT_EQ(22, list->capacity);
     ASSERT_EQ(1002, list->last_id());
     ASSERT_EQ(3, list->num_ids());
 
     list->erase(1000);
     ASSERT_EQ(10, list->length);
-    ASSERT_EQ(15, list->capacity);
+    ASSERT_EQ(22, list->capacity);
     ASSERT_EQ(1002, list->last_id());
     ASSERT_EQ(2, list->num_ids());
 
@@ -1265,7 +1265,7 @@ TEST_F(PostingListTest, CompactPostingListErase) {
     posting_t::erase(obj, 1002);
     ASSERT_TRUE(IS_COMPACT_POSTING(obj));
     ASSERT_EQ(5, (COMPACT_POSTING_PTR(obj))->length);
-    ASSERT_EQ(7, (COMPACT_POSTING_PTR(obj))->capacity);
+    ASSERT_EQ(11, (COMPACT_POSTING_PTR(obj))->capacity);
     ASSERT_EQ(0, (COMPACT_POSTING_PTR(obj))->last_id());
     ASSERT_EQ(1, (COMPACT_POSTING_PTR(obj))->num_ids());
 
@@ -1273,7 +1273,7 @@ TEST_F(PostingListTest, CompactPostingListErase) {
     posting_t::upsert(obj, 1002, {0, 3, 4});
     list = COMPACT_POSTING_PTR(obj);
     ASSERT_EQ(10, list->length);
-    ASSERT_EQ(13, list->capacity);
+    ASSERT_EQ(11, list->capacity);
     ASSERT_EQ(1002, list->last_id());
     ASSERT_EQ(2, list->num_ids());
 
@@ -1397,6 +1397,38 @@ TEST_F(PostingListTest, InsertAndEraseSequence) {
     ASSERT_EQ(0, pl.num_ids());
 }
 
+TEST_F(PostingListTest, CompactBlocksMergesUnderfilledBlocks) {
+    std::vector<uint32_t> offsets = {0, 1, 3};
+    posting_list_t pl(6);
+
+    for(uint32_t i = 0; i < 18; i++) {
+        pl.upsert(i, offsets);
+    }
+
+    ASSERT_EQ(3, pl.num_blocks());
+
+    // leave every block exactly half-filled so that erase() does not merge on its own
+    for(uint32_t i = 0; i < 18; i++) {
+        if(i % 6 >= 3) {
+            pl.erase(i);
+        }
+    }
+
+    ASSERT_EQ(3, pl.num_blocks());
+    ASSERT_EQ(9, pl.num_ids());
+
+    ASSERT_EQ(1, pl.compact_blocks());
+    ASSERT_EQ(2, pl.num_blocks());
+    ASSERT_EQ(9, pl.num_ids());
+
+    for(uint32_t i = 0; i < 18; i++) {
+        ASSERT_EQ(i % 6 < 3, pl.contains(i));
+    }
+
+    // already compacted, so there is nothing more to reclaim
+    ASSERT_EQ(0, pl.compact_blocks());
+}
+
 TEST_F(PostingListTest, InsertAndEraseSequenceWithBlockSizeTwo) {
     std::vector<uint32_t> offsets = {0, 1, 3};
     posting_list_t pl(2);
@@ -464,4 +464,40 @@ TEST(SortedArrayTest, NumFoundOfSortedArrayLessThanValues) {
 
     num_found = arr2.numFoundOf(&filter_ids[0], filter_ids.size());
     ASSERT_EQ(4, num_found);
-}
\ No newline at end of file
+}
+TEST(SortedArrayTest, BulkIndexOfLargeBatch) {
+    sorted_array arr;
+    for(uint32_t i = 0; i < 10000; i++) {
+        arr.append(i * 2);  // even values only
+    }
+
+    // a batch this large relative to the array goes through the decoded
+    // single-pass resolution
+    std::vector<uint32_t> search_ids;
+    for(uint32_t i = 0; i < 4000; i++) {
+        search_ids.push_back(i * 5);  // mix of hits and misses
+    }
+
+    uint32_t* results = new uint32_t[search_ids.size()];
+    arr.indexOf(&search_ids[0], search_ids.size(), results);
+
+    for(size_t i = 0; i < search_ids.size(); i++) {
+        ASSERT_EQ(arr.indexOf(search_ids[i]), results[i]);
+    }
+
+    // probes past the end of the array must report "not found"
+    search_ids.clear();
+    for(uint32_t i = 0; i < 200; i++) {
+        search_ids.push_back(19999 + i);
+    }
+
+    delete [] results;
+    results = new uint32_t[search_ids.size()];
+    arr.indexOf(&search_ids[0], search_ids.size(), results);
+
+    for(size_t i = 0; i < search_ids.size(); i++) {
+        ASSERT_EQ(arr.getLength(), results[i]);
+    }
+
+    delete [] results;
+}
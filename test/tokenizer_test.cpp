@@ -148,6 +148,33 @@ TEST(TokenizerTest, ShouldTokenizeIteratively) {
     ASSERT_STREQ("Michael Jordan:\n\nWelcome, everybody. Welcome!", tokens[0].c_str());
 }
 
+TEST(TokenizerTest, ShouldTokenizeLongAsciiRuns) {
+    // alphanumeric runs longer than a 16-byte SIMD chunk, with case changes
+    // and a separator landing mid-chunk
+    std::vector<std::string> tokens;
+    Tokenizer("SUPERCALIFRAGILISTICexpialidocious plus A1B2C3D4E5F6G7H8I9 trailing",
+              true, false).tokenize(tokens);
+    ASSERT_EQ(4, tokens.size());
+    ASSERT_EQ("supercalifragilisticexpialidocious", tokens[0]);
+    ASSERT_EQ("plus", tokens[1]);
+    ASSERT_EQ("a1b2c3d4e5f6g7h8i9", tokens[2]);
+    ASSERT_EQ("trailing", tokens[3]);
+
+    // non-ASCII bytes inside an otherwise ASCII run must still normalize
+    tokens.clear();
+    Tokenizer("abcdefghijklmnopqrsté abcdefghijklmnopqrst", true, false).tokenize(tokens);
+    ASSERT_EQ(2, tokens.size());
+    ASSERT_EQ("abcdefghijklmnopqrste", tokens[0]);
+    ASSERT_EQ("abcdefghijklmnopqrst", tokens[1]);
+
+    // without normalization the original casing must survive the fast path
+    tokens.clear();
+    Tokenizer("MixedCASERunsOverSixteenBytes intact", false, false).tokenize(tokens);
+    ASSERT_EQ(2, tokens.size());
+    ASSERT_EQ("MixedCASERunsOverSixteenBytes", tokens[0]);
+    ASSERT_EQ("intact", tokens[1]);
+}
+
 TEST(TokenizerTest, ShouldTokenizeTextWithCustomSpecialChars) {
     std::vector<std::string> tokens;
     Tokenizer("and -some -more", true, false, "en", {'-'}).tokenize(tokens);
@@ -143,23 +143,88 @@ TEST(TopsterTest, DistinctIntValues) {
 
     dist_topster.sort();
 
-    std::vector<uint64_t> distinct_ids = {4, 1, 8, 5, 9};
-
-    for(uint32_t i = 0; i < dist_topster.size; i++) {
-        EXPECT_EQ(distinct_ids[i], dist_topster.getDistinctKeyAt(i));
+    ASSERT_EQ(10, dist_topster.group_map->num_groups);
+
+    group_slot_t* slot = dist_topster.group_map->find(1);
+    ASSERT_NE(nullptr, slot);
+    EXPECT_EQ(2, slot->size);
+    EXPECT_EQ(12, slot->kvs[0].scores[0]);
+    EXPECT_EQ(11, slot->kvs[1].scores[0]);
+
+    slot = dist_topster.group_map->find(5);
+    ASSERT_NE(nullptr, slot);
+    EXPECT_EQ(2, slot->size);
+    EXPECT_EQ(10, slot->kvs[0].scores[0]);
+    EXPECT_EQ(9, slot->kvs[1].scores[0]);
+
+    // group with a single entry
+    slot = dist_topster.group_map->find(2);
+    ASSERT_NE(nullptr, slot);
+    EXPECT_EQ(1, slot->size);
+    EXPECT_EQ(4, slot->kvs[0].scores[0]);
+
+    // unseen group
+    ASSERT_EQ(nullptr, dist_topster.group_map->find(999));
+}
+TEST(TopsterTest, KWayMergeOfBatchTopsters) {
+    Topster agg(5);
+    std::vector<Topster*> batches = {new Topster(5), new Topster(5), new Topster(5)};
+
+    // disjoint keys per batch, the way per-worker topsters are filled
+    std::vector<std::vector<std::pair<uint64_t, int64_t>>> batch_data = {
+        {{1, 100}, {2, 40}},
+        {{3, 90}, {4, 60}, {5, 20}},
+        {{6, 80}, {7, 50}},
+    };
 
-        if(distinct_ids[i] == 1) {
-            EXPECT_EQ(12, (int) dist_topster.getKV(i)->scores[dist_topster.getKV(i)->match_score_index]);
-            EXPECT_EQ(2, dist_topster.group_kv_map[dist_topster.getDistinctKeyAt(i)]->size);
-            EXPECT_EQ(12, dist_topster.group_kv_map[dist_topster.getDistinctKeyAt(i)]->getKV(0)->scores[0]);
-            EXPECT_EQ(11, dist_topster.group_kv_map[dist_topster.getDistinctKeyAt(i)]->getKV(1)->scores[0]);
+    for(size_t bi = 0; bi < batches.size(); bi++) {
+        for(const auto& key_score: batch_data[bi]) {
+            int64_t scores[3] = {key_score.second, 0, 0};
+            KV kv(1, 0, 255, key_score.first, key_score.first, 0, scores);
+            batches[bi]->add(&kv);
         }
+    }
+
+    Index::aggregate_topsters(&agg, batches);
+    ASSERT_EQ(5, agg.size);
+
+    agg.sort();
+
+    std::vector<uint64_t> ids = {1, 3, 6, 4, 7};
+    for(uint32_t i = 0; i < agg.size; i++) {
+        EXPECT_EQ(ids[i], agg.getKeyAt(i));
+    }
+
+    for(auto batch: batches) {
+        delete batch;
+    }
 
-        if(distinct_ids[i] == 5) {
-            EXPECT_EQ(9, (int) dist_topster.getKV(i)->scores[dist_topster.getKV(i)->match_score_index]);
-            EXPECT_EQ(2, dist_topster.group_kv_map[dist_topster.getDistinctKeyAt(i)]->size);
-            EXPECT_EQ(10, dist_topster.group_kv_map[dist_topster.getDistinctKeyAt(i)]->getKV(0)->scores[0]);
-            EXPECT_EQ(9, dist_topster.group_kv_map[dist_topster.getDistinctKeyAt(i)]->getKV(1)->scores[0]);
+    // adds after a bulk merge must still respect the heap invariants
+    Topster agg2(5);
+    batches = {new Topster(5), new Topster(5), new Topster(5)};
+
+    for(size_t bi = 0; bi < batches.size(); bi++) {
+        for(const auto& key_score: batch_data[bi]) {
+            int64_t scores[3] = {key_score.second, 0, 0};
+            KV kv(1, 0, 255, key_score.first, key_score.first, 0, scores);
+            batches[bi]->add(&kv);
         }
     }
-}
\ No newline at end of file
+
+    Index::aggregate_topsters(&agg2, batches);
+
+    int64_t scores[3] = {95, 0, 0};
+    KV kv(1, 0, 255, 8, 8, 0, scores);
+    agg2.add(&kv);
+
+    agg2.sort();
+
+    ids = {1, 8, 3, 6, 4};
+    for(uint32_t i = 0; i < agg2.size; i++) {
+        EXPECT_EQ(ids[i], agg2.getKeyAt(i));
+    }
+
+    for(auto batch: batches) {
+        delete batch;
+    }
+}